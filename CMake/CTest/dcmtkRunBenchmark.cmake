@@ -0,0 +1,14 @@
+#
+# This file is used to run the benchmark of a module (see DCMTK_ADD_BENCHMARK)
+# with the DCMDICTPATH environment variable set appropriately.
+#
+
+set(ENV{DCMDICTPATH} "${DCMDICTPATH}")
+
+execute_process(COMMAND "${DCMTK_BENCHMARK_COMMAND}"
+    RESULT_VARIABLE RESULT
+)
+
+if(RESULT)
+    message(FATAL_ERROR "Benchmark command returned: ${RESULT}")
+endif()
@@ -285,7 +285,9 @@ endif()
   CHECK_INCLUDE_FILE_CXX("syslog.h" HAVE_SYSLOG_H)
   CHECK_INCLUDE_FILE_CXX("sys/errno.h" HAVE_SYS_ERRNO_H)
   CHECK_INCLUDE_FILE_CXX("sys/dir.h" HAVE_SYS_DIR_H)
+  CHECK_INCLUDE_FILE_CXX("sys/epoll.h" HAVE_SYS_EPOLL_H)
   CHECK_INCLUDE_FILE_CXX("sys/file.h" HAVE_SYS_FILE_H)
+  CHECK_INCLUDE_FILE_CXX("sys/mman.h" HAVE_SYS_MMAN_H)
   CHECK_INCLUDE_FILE_CXX("sys/ndir.h" HAVE_SYS_NDIR_H)
   CHECK_INCLUDE_FILE_CXX("sys/param.h" HAVE_SYS_PARAM_H)
   CHECK_INCLUDE_FILE_CXX("sys/resource.h" HAVE_SYS_RESOURCE_H)
@@ -295,6 +297,7 @@ endif()
   CHECK_INCLUDE_FILE_CXX("sys/time.h" HAVE_SYS_TIME_H)
   CHECK_INCLUDE_FILE_CXX("sys/timeb.h" HAVE_SYS_TIMEB_H)
   CHECK_INCLUDE_FILE_CXX("sys/types.h" HAVE_SYS_TYPES_H)
+  CHECK_INCLUDE_FILE_CXX("sys/uio.h" HAVE_SYS_UIO_H)
   CHECK_INCLUDE_FILE_CXX("sys/utime.h" HAVE_SYS_UTIME_H)
   CHECK_INCLUDE_FILE_CXX("sys/utsname.h" HAVE_SYS_UTSNAME_H)
   CHECK_INCLUDE_FILE_CXX("sys/wait.h" HAVE_SYS_WAIT_H)
@@ -693,6 +696,9 @@ endif()
   # popen and pclose are nonstandard and may not be available in the C++ headers
   CHECK_FUNCTIONWITHHEADER_EXISTS("popen" "${HEADERS}" HAVE_POPEN)
   CHECK_FUNCTIONWITHHEADER_EXISTS("pclose" "${HEADERS}" HAVE_PCLOSE)
+  # Hints for writing large files sequentially (mostly Linux specific)
+  CHECK_FUNCTIONWITHHEADER_EXISTS("fallocate(0, FALLOC_FL_KEEP_SIZE, 0, 0)" "fcntl.h" HAVE_FALLOCATE)
+  CHECK_FUNCTIONWITHHEADER_EXISTS("posix_fadvise(0, 0, 0, POSIX_FADV_DONTNEED)" "fcntl.h" HAVE_POSIX_FADVISE)
 
   # Signal handling functions
   CHECK_FUNCTIONWITHHEADER_EXISTS("sigjmp_buf definition" "setjmp.h" HAVE_SIGJMP_BUF)
@@ -44,6 +44,29 @@ function(DCMTK_ADD_TESTS MODULE)
     endif()
 endfunction()
 
+#
+# Add a target for running the benchmark of the current module
+#
+# DCMTK_ADD_BENCHMARK - function which adds the target "<module>-benchmark"
+# MODULE - name of the module that we are called for
+#
+# The benchmark executable "<module>_bench" is not registered as a test, since
+# its results depend on the machine. The target runs it with its default
+# options and the DCMDICTPATH environment variable set appropriately. The
+# target "benchmark" runs the benchmarks of all modules.
+#
+function(DCMTK_ADD_BENCHMARK MODULE)
+    if(BUILD_APPS AND NOT CMAKE_CROSSCOMPILING)
+        string(REPLACE ";" "${ENVIRONMENT_PATH_SEPARATOR}" DCMDICTPATH "${DCMTK_DICOM_DICTIONARIES}")
+        add_custom_target("${MODULE}-benchmark"
+            COMMAND "${CMAKE_COMMAND}" "-DDCMTK_BENCHMARK_COMMAND=$<TARGET_FILE:${MODULE}_bench>" "-DDCMDICTPATH=${DCMDICTPATH}" "-P" "${DCMTK_SOURCE_DIR}/CMake/CTest/dcmtkRunBenchmark.cmake"
+            DEPENDS "${MODULE}_bench"
+            WORKING_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}"
+        )
+        add_dependencies(benchmark "${MODULE}-benchmark")
+    endif()
+endfunction()
+
 #
 # Setup an executable
 #
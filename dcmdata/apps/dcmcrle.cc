@@ -64,6 +64,7 @@ int main(int argc, char *argv[])
   OFBool           opt_createOffsetTable = OFTrue;
   OFBool           opt_uidcreation = OFFalse;
   OFBool           opt_secondarycapture = OFFalse;
+  OFCmdUnsignedInt opt_threads = 1;
 
   OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION, "Encode DICOM file to RLE transfer syntax", rcsid);
   OFCommandLine cmd;
@@ -107,6 +108,10 @@ int main(int argc, char *argv[])
       cmd.addOption("--uid-never",           "+un",    "never assign new UID (default)");
       cmd.addOption("--uid-always",          "+ua",    "always assign new UID");
 
+    cmd.addSubGroup("multi-frame compression:");
+      cmd.addOption("--threads",             "+th", 1, "[n]umber: integer (0 = number of CPUs)",
+                                                       "compress up to n frames in parallel (default: 1)");
+
   cmd.addGroup("output options:");
     cmd.addSubGroup("post-1993 value representations:");
       cmd.addOption("--enable-new-vr",       "+u",     "enable support for new VRs (UN/UT) (default)");
@@ -199,6 +204,11 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--class-sc")) opt_secondarycapture = OFTrue;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValue(opt_threads));
+      }
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--uid-always")) opt_uidcreation = OFTrue;
       if (cmd.findOption("--uid-never")) opt_uidcreation = OFFalse;
@@ -237,7 +247,8 @@ int main(int argc, char *argv[])
 
     // register RLE compression codec
     DcmRLEEncoderRegistration::registerCodecs(opt_uidcreation,
-      OFstatic_cast(Uint32, opt_fragmentSize), opt_createOffsetTable, opt_secondarycapture);
+      OFstatic_cast(Uint32, opt_fragmentSize), opt_createOffsetTable, opt_secondarycapture,
+      OFstatic_cast(size_t, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
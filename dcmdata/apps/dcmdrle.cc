@@ -63,6 +63,7 @@ int main(int argc, char *argv[])
   // RLE parameters
   OFBool opt_uidcreation = OFFalse;
   OFBool opt_reversebyteorder = OFFalse;
+  OFCmdUnsignedInt opt_threads = 1;
 
   OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION, "Decode RLE-compressed DICOM file", rcsid);
   OFCommandLine cmd;
@@ -90,6 +91,9 @@ int main(int argc, char *argv[])
     cmd.addSubGroup("RLE byte segment order:");
       cmd.addOption("--byte-order-default",  "+bd",    "most significant byte first (default)");
       cmd.addOption("--byte-order-reverse",  "+br",    "least significant byte first");
+    cmd.addSubGroup("multi-frame decompression:");
+      cmd.addOption("--threads",             "+th", 1, "[n]umber: integer (0 = number of CPUs)",
+                                                       "decompress up to n frames in parallel (default: 1)");
 
   cmd.addGroup("output options:");
     cmd.addSubGroup("output file format:");
@@ -152,6 +156,11 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--byte-order-reverse")) opt_reversebyteorder = OFTrue;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValue(opt_threads));
+      }
+
       cmd.beginOptionBlock();
       if (cmd.findOption("--read-file"))
       {
@@ -218,7 +227,8 @@ int main(int argc, char *argv[])
     OFLOG_DEBUG(dcmdrleLogger, rcsid << OFendl);
 
     // register global decompression codecs
-    DcmRLEDecoderRegistration::registerCodecs(opt_uidcreation, opt_reversebyteorder);
+    DcmRLEDecoderRegistration::registerCodecs(opt_uidcreation, opt_reversebyteorder,
+      OFstatic_cast(size_t, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
@@ -30,6 +30,7 @@
 
 // forward declarations
 class DcmInputStreamFactory;
+class DcmMappedFile;
 class DcmJsonFormat;
 class DcmFileCache;
 class DcmItem;
@@ -476,7 +477,11 @@ class DCMTK_DCMDATA_EXPORT DcmElement
      *  over the element value, especially the value must be deleted from the
      *  heap after use. The DICOM element remains a copy of the value if the
      *  copy parameter is OFTrue; otherwise the value is erased in the DICOM
-     *  element.
+     *  element. A value that refers to a memory-mapped file (see
+     *  dcmUseMemoryMappedFiles) is not owned by the element and, therefore,
+     *  cannot be handed over to the caller. If the copy parameter is OFTrue,
+     *  such a value is copied into newly allocated memory and the element no
+     *  longer refers to the mapped file. Otherwise, EC_IllegalCall is returned.
      *  @param copy if true, copy value field before detaching; if false, do not
      *    retain a copy.
      *  @return EC_Normal upon success, an error code otherwise
@@ -988,6 +993,22 @@ class DCMTK_DCMDATA_EXPORT DcmElement
 
   private:
 
+    /** check whether the value of this element can refer directly to the
+     *  content of the given input stream, which is possible for large binary
+     *  values if the stream is backed by a memory-mapped file.
+     *  @param inStream stream from which the value is to be read
+     *  @param mapping returns the memory-mapped file the value refers to
+     *  @return pointer to the value in the memory-mapped file, NULL if the
+     *    value cannot or should not refer to the stream content
+     */
+    Uint8 *getMappedValue(DcmInputStream &inStream,
+                          DcmMappedFile *&mapping);
+
+    /** delete the value field (if any) or, if the value refers to a
+     *  memory-mapped file, release the reference to that file
+     */
+    void deleteValueField();
+
     /// current byte order of attribute value in memory
     E_ByteOrder fByteOrder;
 
@@ -996,6 +1017,9 @@ class DCMTK_DCMDATA_EXPORT DcmElement
 
     /// value of the element
     Uint8 *fValue;
+
+    /// memory-mapped file that fValue refers to, NULL if fValue was allocated on the heap
+    DcmMappedFile *fMappedFile;
 };
 
 /** Checks whether left hand side element is smaller than right hand side
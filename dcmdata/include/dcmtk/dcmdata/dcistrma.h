@@ -29,6 +29,7 @@
 #include "dcmtk/dcmdata/dcxfer.h"   /* for E_StreamCompression */
 
 class DcmInputStream;
+class DcmMappedFile;
 
 /** pure virtual abstract base class for producers, i.e. the initial node
  *  of a filter chain in an input stream.
@@ -224,6 +225,17 @@ public:
    */
   virtual DcmInputStreamFactory *newFactory() const = 0;
 
+  /** returns a pointer to the content of the stream at the current position
+   *  if the stream is backed by a memory-mapped file (and no compression
+   *  filter is installed) and at least the given number of bytes is
+   *  available.  The stream position is not changed by this method.
+   *  The default implementation always returns NULL.
+   *  @param length number of bytes that need to be available
+   *  @param mapping returns the memory-mapped file the pointer refers to
+   *  @return pointer to mapped file content, NULL if not available
+   */
+  virtual Uint8 *mappedData(const offile_off_t length, DcmMappedFile *&mapping);
+
   /** marks the current stream position for a later putback operation,
    *  overwriting a possibly existing prior putback mark.
    *  The DcmObject read methods rely on the possibility to putback
@@ -213,6 +213,9 @@ private:
 
   /// filename
   OFFilename filename_;
+
+  /// byte offset in file at which this stream starts (tell() is relative to this position)
+  offile_off_t offset_;
 };
 
 /** class that manages the life cycle of a temporary file.
@@ -327,4 +330,245 @@ private:
   DcmTempFileHandler *fileHandler_;
 };
 
+/** class that manages the life cycle of a memory-mapped file.
+ *  The complete file is mapped into memory in copy-on-write mode, i.e.\ the
+ *  mapped content may be modified in memory without affecting the file.
+ *  The class maintains a thread-safe reference counter, and when this
+ *  counter is decreased to zero, unmaps the file and deletes the handler
+ *  object itself.
+ *  @note If the file is truncated by another process while it is mapped,
+ *    any access to the mapped content beyond the new end of the file causes
+ *    a SIGBUS signal (POSIX) or an EXCEPTION_IN_PAGE_ERROR (Windows).
+ */
+class DCMTK_DCMDATA_EXPORT DcmMappedFile
+{
+public:
+
+  /** static method that permits creation of instances of
+   *  this class (only) on the heap, never on the stack.
+   *  A newly created instance always has a reference counter of 1.
+   *  @param filename name of file to be mapped (may contain wide chars
+   *    if support enabled)
+   *  @return pointer to new instance, NULL if the file could not be mapped
+   *    (e.g. because it does not exist, is empty or too large, or memory
+   *    mapping is not supported on this platform)
+   */
+  static DcmMappedFile *newInstance(const OFFilename &filename);
+
+  /** get pointer to the mapped file content
+   *  @return pointer to mapped file content, never NULL
+   */
+  Uint8 *data() const
+  {
+    return data_;
+  }
+
+  /** get size of the mapped file content
+   *  @return number of bytes mapped
+   */
+  offile_off_t size() const
+  {
+    return size_;
+  }
+
+  /// increase reference counter for this object
+  void increaseRefCount();
+
+  /** decreases reference counter for this object and unmaps
+   *  the file and deletes this object if the reference counter becomes zero.
+   */
+  void decreaseRefCount();
+
+private:
+
+  /** private constructor.
+   *  Instances of this class are always created through newInstance().
+   *  @param data pointer to mapped file content
+   *  @param size number of bytes mapped
+   */
+  DcmMappedFile(Uint8 *data, offile_off_t size);
+
+  /** private destructor. Instances of this class
+   *  are always deleted through the reference counting methods
+   */
+  virtual ~DcmMappedFile();
+
+  /// private undefined copy constructor
+  DcmMappedFile(const DcmMappedFile& arg);
+
+  /// private undefined copy assignment operator
+  DcmMappedFile& operator=(const DcmMappedFile& arg);
+
+  /** number of references to the mapped file.
+   *  Default initialized to 1 upon construction of this object
+   */
+  size_t refCount_;
+
+#ifdef WITH_THREADS
+  /// mutex for MT-safe reference counting
+  /// @remark this member is only available if DCMTK is compiled with thread
+  /// support enabled.
+  OFMutex mutex_;
+#endif
+
+  /// pointer to mapped file content
+  Uint8 *data_;
+
+  /// number of bytes mapped
+  offile_off_t size_;
+};
+
+/** producer class that reads data from a memory-mapped file.
+ */
+class DCMTK_DCMDATA_EXPORT DcmMappedFileProducer: public DcmProducer
+{
+public:
+  /** constructor
+   *  @param mapping memory-mapped file.
+   *    Reference counter of the mapped file is increased by this operation.
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmMappedFileProducer(DcmMappedFile *mapping, offile_off_t offset = 0);
+
+  /// destructor, decreases reference counter of the mapped file
+  virtual ~DcmMappedFileProducer();
+
+  /** returns the status of the producer. Unless the status is good,
+   *  the producer will not permit any operation.
+   *  @return status, true if good
+   */
+  virtual OFBool good() const;
+
+  /** returns the status of the producer as an OFCondition object.
+   *  Unless the status is good, the producer will not permit any operation.
+   *  @return status, EC_Normal if good
+   */
+  virtual OFCondition status() const;
+
+  /** returns true if the producer is at the end of stream.
+   *  @return true if end of stream, false otherwise
+   */
+  virtual OFBool eos();
+
+  /** returns the minimum number of bytes that can be read with the
+   *  next call to read(). The DcmObject read methods rely on avail
+   *  to return a value > 0 if there is no I/O suspension since certain
+   *  data such as tag and length are only read "en bloc", i.e. all
+   *  or nothing.
+   *  @return minimum of data available in producer
+   */
+  virtual offile_off_t avail();
+
+  /** reads as many bytes as possible into the given block.
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually read.
+   */
+  virtual offile_off_t read(void *buf, offile_off_t buflen);
+
+  /** skips over the given number of bytes (or less)
+   *  @param skiplen number of bytes to skip
+   *  @return number of bytes actually skipped.
+   */
+  virtual offile_off_t skip(offile_off_t skiplen);
+
+  /** resets the stream to the position by the given number of bytes.
+   *  @param num number of bytes to putback. If the putback operation
+   *    fails, the producer status becomes bad.
+   */
+  virtual void putback(offile_off_t num);
+
+  /** returns a pointer to the mapped file content at the current position
+   *  @return pointer to mapped file content at the current position
+   */
+  Uint8 *currentData() const
+  {
+    return mapping_->data() + pos_;
+  }
+
+  /** returns the memory-mapped file this producer reads from
+   *  @return memory-mapped file, never NULL
+   */
+  DcmMappedFile *mapping() const
+  {
+    return mapping_;
+  }
+
+private:
+
+  /// private unimplemented copy constructor
+  DcmMappedFileProducer(const DcmMappedFileProducer&);
+
+  /// private unimplemented copy assignment operator
+  DcmMappedFileProducer& operator=(const DcmMappedFileProducer&);
+
+  /// the memory-mapped file we're actually reading from
+  DcmMappedFile *mapping_;
+
+  /// status
+  OFCondition status_;
+
+  /// current position in the mapped file
+  offile_off_t pos_;
+};
+
+
+/** input stream that reads from a memory-mapped file.  In contrast to
+ *  DcmInputFileStream, large binary element values can directly refer to
+ *  the mapped file content instead of being copied into newly allocated
+ *  memory (see dcmUseMemoryMappedFiles).
+ */
+class DCMTK_DCMDATA_EXPORT DcmInputMappedFileStream: public DcmInputStream
+{
+public:
+  /** constructor
+   *  @param mapping memory-mapped file.
+   *    Reference counter of the mapped file is increased by this operation.
+   *  @param filename name of the mapped file (may contain wide chars
+   *    if support enabled), used for creating stream factories
+   *  @param offset byte offset to skip from the start of file
+   */
+  DcmInputMappedFileStream(DcmMappedFile *mapping, const OFFilename &filename, offile_off_t offset = 0);
+
+  /// destructor
+  virtual ~DcmInputMappedFileStream();
+
+  /** creates a new factory object for the current stream
+   *  and stream position.  When activated, the factory will be
+   *  able to create new DcmInputStream delivering the same
+   *  data as the current stream.  Used to defer loading of
+   *  value fields until accessed.
+   *  If no factory object can be created (e.g. because the
+   *  stream is not seekable), returns NULL.
+   *  @return pointer to new factory object if successful, NULL otherwise.
+   */
+  virtual DcmInputStreamFactory *newFactory() const;
+
+  /** returns a pointer to the mapped file content at the current stream
+   *  position, provided that no compression filter is installed and at
+   *  least the given number of bytes is available.
+   *  @param length number of bytes that need to be available
+   *  @param mapping returns the memory-mapped file the pointer refers to
+   *  @return pointer to mapped file content, NULL if not available
+   */
+  virtual Uint8 *mappedData(const offile_off_t length, DcmMappedFile *&mapping);
+
+private:
+
+  /// private unimplemented copy constructor
+  DcmInputMappedFileStream(const DcmInputMappedFileStream&);
+
+  /// private unimplemented copy assignment operator
+  DcmInputMappedFileStream& operator=(const DcmInputMappedFileStream&);
+
+  /// the final producer of the filter chain
+  DcmMappedFileProducer producer_;
+
+  /// filename
+  OFFilename filename_;
+
+  /// byte offset in file at which this stream starts (tell() is relative to this position)
+  offile_off_t offset_;
+};
+
 #endif
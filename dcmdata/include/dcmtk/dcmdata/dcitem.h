@@ -259,6 +259,15 @@ class DCMTK_DCMDATA_EXPORT DcmItem
                                      const Uint32 maxReadLength = DCM_MaxReadLength,
                                      const DcmTagKey &stopParsingAtElement = DCM_UndefinedTagKey);
 
+    /** specify how readUntilTag() reports that it has reached the element
+     *  at which parsing is stopped. By default, a warning is reported since
+     *  the rest of the dataset is skipped. A caller that parses the first
+     *  part of a dataset on purpose, e.g.\ while receiving it to file, may
+     *  reduce this to a debug message.
+     *  @param quiet report a debug message instead of a warning if OFTrue
+     */
+    void setQuietStopParsing(const OFBool quiet);
+
     /** write object to a stream
      *  @param outStream DICOM output stream
      *  @param oxfer output transfer syntax
@@ -1486,6 +1495,9 @@ class DCMTK_DCMDATA_EXPORT DcmItem
 
     /// cache for private creator tags and names
     DcmPrivateTagCache privateCreatorCache;
+
+    /// report reaching the stop element in readUntilTag() as a debug message only
+    OFBool quietStopParsing;
 };
 
 /** Checks whether left hand side item is smaller than right hand side
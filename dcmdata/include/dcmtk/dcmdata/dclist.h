@@ -26,6 +26,7 @@
 
 #include "dcmtk/ofstd/ofcast.h"
 #include "dcmtk/ofstd/oftypes.h"
+#include "dcmtk/ofstd/ofvector.h"
 
 #include "dcmtk/dcmdata/dcobject.h"
 
@@ -88,9 +89,36 @@ typedef enum
     ELP_next
 } E_ListPos;
 
+/** helper structure for the optional tag index of class DcmList.
+ *  Each entry maps the tag of a list node's object to the node itself.
+ */
+struct DCMTK_DCMDATA_EXPORT DcmListIndexEntry
+{
+    /// default constructor
+    DcmListIndexEntry()
+      : tagKey(), node(NULL) {}
+
+    /** constructor
+     *  @param key tag of the object maintained by the given node
+     *  @param n list node
+     */
+    DcmListIndexEntry(const DcmTagKey &key, DcmListNode *n)
+      : tagKey(key), node(n) {}
+
+    /// tag of the object at the time it was added to the index
+    DcmTagKey tagKey;
+
+    /// pointer to list node
+    DcmListNode *node;
+};
+
 /** double-linked list class that maintains pointers to DcmObject instances.
  *  The remove operation does not delete the object pointed to, however,
- *  the destructor will delete all elements pointed to
+ *  the destructor will delete all elements pointed to.
+ *  Optionally, the list maintains an index sorted by the objects' tags,
+ *  which allows for searching an object with a given tag in logarithmic
+ *  instead of linear time (see enableIndex()).  The index requires that the
+ *  tag of an object is not changed while it is part of the list.
  */
 class DCMTK_DCMDATA_EXPORT DcmList 
 {
@@ -146,6 +174,32 @@ public:
      */
     DcmObject *seek_to(unsigned long absolute_position);
 
+    /** seek within list to the object with the given tag (i.e.\ set current
+     *  element to that object).  If the tag index is enabled, this is done
+     *  by a binary search, otherwise the list is searched sequentially.
+     *  @param tag tag of the object to be searched for
+     *  @param exactMatch if OFTrue, only an object with exactly the given tag
+     *    is found.  If OFFalse, the object with the greatest tag that is less
+     *    than or equal to the given tag is found, which requires the list to
+     *    be sorted in ascending tag order (as done by class DcmItem).
+     *  @return pointer to new current object, NULL if not found (the current
+     *    element is invalid in this case)
+     */
+    DcmObject *seek_tag(const DcmTagKey &tag,
+                        const OFBool exactMatch = OFTrue);
+
+    /** enable or disable the tag index for this list.  When enabled, an
+     *  index of all objects is created and maintained by all subsequent
+     *  insert and remove operations, which costs some additional memory
+     *  per list entry.  Lists whose entries share the same tag (e.g. the
+     *  items of a sequence) do not benefit from the index.
+     *  @param enable enable index if OFTrue, disable (and free) it otherwise
+     */
+    void enableIndex(const OFBool enable = OFTrue);
+
+    /// return OFTrue if the tag index is enabled, OFFalse otherwise
+    inline OFBool indexEnabled() const { return indexActive; }
+
     /** Remove and delete all elements from list. Thus, the 
      *  elements' memory is also freed by this operation. The list
      *  is empty after calling this function.
@@ -173,7 +227,34 @@ private:
 
     /// number of elements in list
     unsigned long cardinality;
- 
+
+    /// flag indicating whether the tag index is maintained
+    OFBool indexActive;
+
+    /// tag index, sorted by tag (only used if indexActive is OFTrue)
+    OFVector<DcmListIndexEntry> tagIndex;
+
+    /** add list node to the tag index (if enabled)
+     *  @param node list node to be added
+     */
+    void addToIndex(DcmListNode *node);
+
+    /** remove list node from the tag index (if enabled)
+     *  @param node list node to be removed
+     */
+    void removeFromIndex(DcmListNode *node);
+
+    /** rebuild the tag index from the current list content
+     */
+    void rebuildIndex();
+
+    /** find position of the first index entry with a tag that is not less
+     *  than the given tag (binary search)
+     *  @param tag tag to be searched for
+     *  @return position within tagIndex (may be equal to its size)
+     */
+    size_t lowerBound(const DcmTagKey &tag) const;
+
     /// private undefined copy constructor 
     DcmList &operator=(const DcmList &);
 
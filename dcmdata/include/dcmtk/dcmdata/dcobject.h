@@ -227,6 +227,51 @@ extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmConvertVOILUTSequenceOWtoSQ; /*
  */
 extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmUseExplLengthPixDataForEncTS; /* default OFFalse */
 
+/** This flag enables a tag index for the elements of every item and dataset
+ *  that is created afterwards.  The index is maintained in addition to the
+ *  list of elements and allows for searching an element on the main level
+ *  of an item (e.g. by DcmItem::findAndGetElement() with searchIntoSub being
+ *  OFFalse), as well as for inserting and removing an element, in logarithmic
+ *  instead of linear time.  This is particularly useful for items with many
+ *  elements (e.g. the main dataset of an enhanced multi-frame image) that are
+ *  accessed frequently.  However, the index requires some additional memory
+ *  (about 16 bytes per element), so it is disabled by default.
+ */
+extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmEnableElementIndex; /* default OFFalse */
+
+/** This flag enables the use of memory-mapped files in DcmFileFormat::loadFile()
+ *  and DcmDataset::loadFile().  Large binary element values (e.g. OB or OW with
+ *  at least 4 KB) are then not copied from the file into newly allocated
+ *  memory but refer directly to the mapped file content, which is mapped in
+ *  copy-on-write mode, i.e.\ modifying such a value never changes the file.
+ *  The file remains mapped as long as any element refers to it.  If a file
+ *  cannot be mapped, it is read in the usual way.  The file must not be
+ *  truncated (or replaced in place) while it is mapped: accessing a value
+ *  beyond the new end of the file raises the signal SIGBUS on POSIX systems
+ *  (an EXCEPTION_IN_PAGE_ERROR on Windows), which terminates the process
+ *  unless the application handles it.  This cannot be detected in advance,
+ *  so only files that are not modified by other processes should be loaded
+ *  this way.  Since a mapped file also keeps address space occupied, this
+ *  feature is disabled by default.
+ */
+extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmUseMemoryMappedFiles; /* default OFFalse */
+
+/** This flag enables lazy parsing of sequences.  If enabled, the items of a
+ *  sequence with explicit length are not parsed when reading a dataset from a
+ *  file, but only when the sequence is accessed for the first time, e.g.\ by
+ *  DcmSequenceOfItems::getItem() or DcmSequenceOfItems::nextObject().  Only the
+ *  position of the sequence in the file is remembered, so the file must not be
+ *  modified or deleted as long as the dataset is in use.  This avoids the cost
+ *  of parsing large sequences (e.g.\ the Per-Frame Functional Groups Sequence
+ *  of an enhanced multi-frame image) if only a few top-level attributes are
+ *  needed.  The flag is evaluated when a sequence is read, so nested sequences
+ *  of deferred items are also parsed lazily if the flag is still enabled when
+ *  the items are parsed.  Sequences with undefined length and sequences that
+ *  are not read from a file (e.g.\ received over the network or compressed
+ *  with "deflate") are always parsed immediately.
+ */
+extern DCMTK_DCMDATA_EXPORT OFGlobal<OFBool> dcmEnableLazySequenceParsing; /* default OFFalse */
+
 /** Abstract base class for most classes in module dcmdata. As a rule of thumb,
  *  everything that is either a dataset or that can be identified with a DICOM
  *  attribute tag is derived from class DcmObject.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2011, OFFIS e.V.
+ *  Copyright (C) 1994-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -75,6 +75,20 @@ public:
    */
   virtual offile_off_t write(const void *buf, offile_off_t buflen) = 0;
 
+  /** processes as many bytes as possible from the given input block.
+   *  In contrast to write(), the caller guarantees that the memory block
+   *  remains valid and unmodified until the consumer has been flushed,
+   *  so the consumer may keep a reference to the data instead of copying it.
+   *  The default implementation simply calls write().
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually processed.
+   */
+  virtual offile_off_t writeStable(const void *buf, offile_off_t buflen)
+  {
+    return write(buf, buflen);
+  }
+
   /** instructs the consumer to flush its internal content until
    *  either the consumer becomes "flushed" or I/O suspension occurs.
    *  After a call to flush(), a call to write() will produce undefined
@@ -151,6 +165,16 @@ public:
    */
   virtual offile_off_t write(const void *buf, offile_off_t buflen);
 
+  /** processes as many bytes as possible from the given input block,
+   *  which remains valid and unmodified until the stream has been flushed
+   *  by its owner (see DcmConsumer::writeStable()). Used for element values
+   *  that do not change while being written, so they need not be copied.
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually processed.
+   */
+  virtual offile_off_t writeStable(const void *buf, offile_off_t buflen);
+
   /** instructs the stream to flush its internal content until
    *  either the stream becomes "flushed" or I/O suspension occurs.
    *  After a call to flush(), a call to write() will produce undefined
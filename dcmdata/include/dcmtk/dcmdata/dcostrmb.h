@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2017, OFFIS e.V.
+ *  Copyright (C) 1994-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -78,6 +78,18 @@ public:
    */
   virtual offile_off_t write(const void *buf, offile_off_t buflen);
 
+  /** processes as many bytes as possible from the given input block,
+   *  which remains valid and unmodified until the buffer has been flushed.
+   *  If zero copy is enabled (see setZeroCopyThreshold()) and at least the
+   *  given threshold of bytes can be processed, the block is not copied to
+   *  the buffer but only referenced. In this case, no more data is accepted
+   *  until the buffer has been flushed, i.e. avail() returns 0.
+   *  @param buf pointer to memory block, must not be NULL
+   *  @param buflen length of memory block
+   *  @return number of bytes actually processed.
+   */
+  virtual offile_off_t writeStable(const void *buf, offile_off_t buflen);
+
   /** instructs the consumer to flush its internal content until
    *  either the consumer becomes "flushed" or I/O suspension occurs.
    *  After a call to flush(), a call to write() will produce undefined
@@ -88,17 +100,40 @@ public:
   /** retrieves and flushes the underlying buffer.
    *  After return of this method, the buffer is considered to have
    *  been flushed (copied, stored) by the caller and is reused
-   *  by the next write operation.
+   *  by the next write operation. A memory block that has been
+   *  referenced by writeStable() is copied to the buffer first.
    *  @param buffer pointer to user provided buffer returned in this parameter
    *  @param length number of bytes in buffer returned in this parameter
    */
   virtual void flushBuffer(void *& buffer, offile_off_t& length);
 
+  /** retrieves and flushes the underlying buffer and the memory block
+   *  referenced by writeStable(), if any. The data of the block follows
+   *  the data in the buffer. After return of this method, both are
+   *  considered to have been flushed (copied, stored) by the caller.
+   *  @param buffer pointer to user provided buffer returned in this parameter
+   *  @param length number of bytes in buffer returned in this parameter
+   *  @param block pointer to referenced memory block returned in this
+   *    parameter, NULL if none
+   *  @param blockLength number of bytes in referenced memory block
+   *    returned in this parameter, 0 if none
+   */
+  virtual void flushBuffer(void *& buffer, offile_off_t& length,
+                           const void *& block, offile_off_t& blockLength);
+
   /** query the number of bytes in buffer without flushing it.
+   *  The bytes referenced by writeStable() are included.
    *  @return number of bytes in buffer.
    */
   virtual offile_off_t filled();
 
+  /** enables or disables zero copy for data written with writeStable().
+   *  Zero copy is disabled by default.
+   *  @param threshold minimum number of bytes that are referenced
+   *    instead of being copied to the buffer, 0 to disable zero copy
+   */
+  virtual void setZeroCopyThreshold(offile_off_t threshold);
+
 private:
 
   /// private unimplemented copy constructor
@@ -116,6 +151,15 @@ private:
   /// number of bytes filled in buffer
   offile_off_t filled_;
 
+  /// memory block referenced by writeStable(), NULL if none
+  const void *block_;
+
+  /// number of bytes referenced in memory block
+  offile_off_t blockLength_;
+
+  /// minimum number of bytes referenced by writeStable(), 0 if disabled
+  offile_off_t zeroCopyThreshold_;
+
   /// status
   OFCondition status_;
 };
@@ -146,11 +190,35 @@ public:
    */
   virtual void flushBuffer(void *& buffer, offile_off_t& length);
 
+  /** retrieves and flushes the underlying buffer and the memory block
+   *  that has been referenced instead of being copied to the buffer, if any.
+   *  The data of the block follows the data in the buffer. After return of
+   *  this method, both are considered to have been flushed by the caller.
+   *  @param buffer pointer to user provided buffer returned in this parameter
+   *  @param length number of bytes in buffer returned in this parameter
+   *  @param block pointer to referenced memory block returned in this
+   *    parameter, NULL if none
+   *  @param blockLength number of bytes in referenced memory block
+   *    returned in this parameter, 0 if none
+   */
+  virtual void flushBuffer(void *& buffer, offile_off_t& length,
+                           const void *& block, offile_off_t& blockLength);
+
   /** query the number of bytes in buffer without flushing it.
    *  @return number of bytes in buffer.
    */
   virtual offile_off_t filled();
 
+  /** enables or disables zero copy, i.e.\ element values that do not change
+   *  while being written are only referenced instead of being copied to the
+   *  buffer (see DcmBufferConsumer::writeStable()). The referenced data is
+   *  returned separately by flushBuffer(). Zero copy is disabled by default
+   *  and is not used for data that passes a compression filter.
+   *  @param threshold minimum number of bytes that are referenced
+   *    instead of being copied to the buffer, 0 to disable zero copy
+   */
+  virtual void setZeroCopyThreshold(offile_off_t threshold);
+
 private:
 
   /// private unimplemented copy constructor
@@ -87,6 +87,18 @@ public:
    */
   virtual void flush();
 
+  /** enables hints to the operating system that are useful when writing large
+   *  files sequentially (e.g.\ when receiving a dataset directly to file).
+   *  While writing, disk space is reserved in advance in chunks of the given size
+   *  (using fallocate()), which reduces fragmentation. Data that has been written
+   *  more than one chunk ago is removed from the page cache (using posix_fadvise()),
+   *  since it is not expected to be read again soon. Disk space that has been
+   *  reserved but not used is released when the file is closed.
+   *  On systems that do not support these functions, this method has no effect.
+   *  @param chunkSize size of the chunks in bytes, 0 disables the hints (default)
+   */
+  virtual void setPreallocationChunkSize(const offile_off_t chunkSize);
+
 private:
 
   /// private unimplemented copy constructor
@@ -95,11 +107,28 @@ private:
   /// private unimplemented copy assignment operator
   DcmFileConsumer& operator=(const DcmFileConsumer&);
 
+  /** reserve the next chunk of disk space and drop the data written before
+   *  from the page cache (if needed). Called after each write operation.
+   */
+  void updateFileHints();
+
   /// the file we're actually writing to
   OFFile file_;
 
   /// status
   OFCondition status_;
+
+  /// size of the chunks reserved in advance, 0 if disabled
+  offile_off_t chunkSize_;
+
+  /// current position in the file (only maintained if chunkSize_ > 0)
+  offile_off_t position_;
+
+  /// end of the disk space reserved so far
+  offile_off_t reserved_;
+
+  /// end of the data that has been dropped from the page cache so far
+  offile_off_t released_;
 };
 
 
@@ -122,6 +151,12 @@ public:
   /// destructor
   virtual ~DcmOutputFileStream();
 
+  /** enables hints to the operating system that are useful when writing large
+   *  files sequentially. See DcmFileConsumer::setPreallocationChunkSize().
+   *  @param chunkSize size of the chunks in bytes, 0 disables the hints (default)
+   */
+  void setPreallocationChunkSize(const offile_off_t chunkSize);
+
 private:
 
   /// private unimplemented copy constructor
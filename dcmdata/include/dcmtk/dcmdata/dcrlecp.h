@@ -44,13 +44,16 @@ public:
    *  @param pReverseDecompressionByteOrder flag indicating whether the byte order should
    *    be reversed upon decompression. Needed to correctly decode some incorrectly encoded
    *    images with more than one byte per sample.
+   *  @param pNumberOfThreads maximum number of threads used for compressing or
+   *    decompressing the frames of a multi-frame image, 0 for the number of processors.
    */
   DcmRLECodecParameter(
     OFBool pCreateSOPInstanceUID = OFFalse,
     Uint32 pFragmentSize = 0,
     OFBool pCreateOffsetTable = OFTrue,
     OFBool pConvertToSC = OFFalse,
-    OFBool pReverseDecompressionByteOrder = OFFalse);
+    OFBool pReverseDecompressionByteOrder = OFFalse,
+    size_t pNumberOfThreads = 1);
 
   /// copy constructor
   DcmRLECodecParameter(const DcmRLECodecParameter& arg);
@@ -109,6 +112,14 @@ public:
     return reverseDecompressionByteOrder;
   }
 
+  /** returns maximum number of threads used for compression or decompression
+   *  @return maximum number of threads, 0 for the number of processors
+   */
+  size_t getNumberOfThreads() const
+  {
+    return numberOfThreads;
+  }
+
 
 private:
 
@@ -131,6 +142,9 @@ private:
    *  decompress certain incorrectly encoded RLE images
    */
   OFBool reverseDecompressionByteOrder;
+
+  /// maximum number of threads used for compression/decompression, 0 for the number of processors
+  size_t numberOfThreads;
 };
 
 
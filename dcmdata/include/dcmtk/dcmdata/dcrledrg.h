@@ -42,10 +42,13 @@ public:
    *  @param pReverseDecompressionByteOrder flag indicating whether the byte order should
    *    be reversed upon decompression. Needed to correctly decode some incorrectly encoded
    *    images with more than one byte per sample.
+   *  @param pNumberOfThreads maximum number of threads used for decompressing
+   *    the frames of a multi-frame image, 0 for the number of processors
    */
   static void registerCodecs(
     OFBool pCreateSOPInstanceUID = OFFalse,
-    OFBool pReverseDecompressionByteOrder = OFFalse);
+    OFBool pReverseDecompressionByteOrder = OFFalse,
+    size_t pNumberOfThreads = 1);
 
   /** deregisters decoder.
    *  Attention: Must not be called while other threads might still use
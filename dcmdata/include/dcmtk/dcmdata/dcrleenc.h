@@ -173,7 +173,23 @@ public:
   {
     if (buf)
     {
-      while (bufcount--) add(*buf++);
+      while (bufcount > 0)
+      {
+        if ((! fail_) && (OFstatic_cast(int, *buf) == RLE_prev_))
+        {
+          // the byte continues the current replicate run. Determine the
+          // length of the run in one go and just increase the repeat counter
+          const size_t count = runLength(buf, (bufcount < 65536) ? bufcount : 65536);
+          RLE_pcount_ += OFstatic_cast(int, count);
+          buf += count;
+          bufcount -= count;
+        }
+        else
+        {
+          add(*buf++);
+          --bufcount;
+        }
+      }
     }
   }
 
@@ -329,6 +345,32 @@ private:
   /// private undefined copy assignment operator
   DcmRLEEncoder& operator=(const DcmRLEEncoder&);
 
+  /** determines the number of consecutive bytes that are equal to the
+   *  first byte of the given buffer. The buffer is compared one machine
+   *  word at a time, which is considerably faster than a byte-wise
+   *  comparison for the long runs typical for medical images.
+   *  @param buf pointer to buffer, must not be NULL
+   *  @param bufcount number of bytes in buffer, must be greater than 0
+   *  @return length of the run, 1..bufcount
+   */
+  static inline size_t runLength(const unsigned char *buf, size_t bufcount)
+  {
+    const unsigned char ch = *buf;
+    size_t pattern;
+    size_t word;
+    size_t i = 1;
+    memset(&pattern, ch, sizeof(pattern));
+    while (i + sizeof(word) <= bufcount)
+    {
+      // memcpy() avoids unaligned memory access
+      memcpy(&word, buf + i, sizeof(word));
+      if (word != pattern) break;
+      i += sizeof(word);
+    }
+    while ((i < bufcount) && (buf[i] == ch)) ++i;
+    return i;
+  }
+
   /** this method moves the given number of bytes from buff_
    *  to currentBlock_ and "flushes" currentBlock_ to
    *  blockList_ if necessary.
@@ -44,12 +44,15 @@ public:
    *  @param pCreateOffsetTable create offset table during image compression?
    *  @param pConvertToSC flag indicating whether image should be converted to
    *    Secondary Capture upon compression
+   *  @param pNumberOfThreads maximum number of threads used for compressing
+   *    the frames of a multi-frame image, 0 for the number of processors
    */
   static void registerCodecs(
     OFBool pCreateSOPInstanceUID = OFFalse,
     Uint32 pFragmentSize = 0,
     OFBool pCreateOffsetTable = OFTrue,
-    OFBool pConvertToSC = OFFalse);
+    OFBool pConvertToSC = OFFalse,
+    size_t pNumberOfThreads = 1);
 
   /** deregisters encoder.
    *  Attention: Must not be called while other threads might still use
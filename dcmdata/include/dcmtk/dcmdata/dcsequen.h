@@ -586,6 +586,15 @@ protected:
                                           DcmStack &resultStack,              // inout
                                           const OFBool searchIntoSub);        // in
 
+    /** parse the items of this sequence if this has been deferred while reading
+     *  (see dcmEnableLazySequenceParsing). Calling this method is safe in any case,
+     *  it does nothing if there are no deferred items. Since the list of items
+     *  might be incomplete otherwise, all methods accessing the item list call
+     *  this method first.
+     *  @return EC_Normal if successful or nothing to do, an error code otherwise
+     */
+    OFCondition loadItems();
+
     /// the list of items maintained by this sequence object
     DcmList *itemList;
 
@@ -622,6 +631,20 @@ private:
      */
     OFBool readAsUN_;
 
+    /** required information to parse the items of this sequence later, i.e.\ on
+     *  first access (see dcmEnableLazySequenceParsing). NULL if the items have
+     *  already been parsed or if the sequence was not read from a file.
+     */
+    DcmInputStreamFactory *fLoadItems;
+
+    /// transfer syntax used for parsing the items later
+    E_TransferSyntax fLoadXfer;
+
+    /// group length encoding used for parsing the items later
+    E_GrpLenEncoding fLoadGroupLength;
+
+    /// maximum read length used for parsing the items later
+    Uint32 fLoadMaxReadLength;
 };
 
 
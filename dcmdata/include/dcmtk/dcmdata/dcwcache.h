@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2007-2011, OFFIS e.V.
+ *  Copyright (C) 2007-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -93,9 +93,13 @@ public:
 
   /** write buffer content to output stream
    *  @param outStream output stream to write to
+   *  @param stable if true, the buffer content is written with
+   *    DcmOutputStream::writeStable(), i.e.\ the stream may keep a reference to
+   *    the buffer. In this case, the caller must make sure that the buffer is
+   *    neither re-filled nor deleted before the stream has been flushed.
    *  @return number of bytes written
    */
-  Uint32 writeBuffer(DcmOutputStream &outStream);
+  Uint32 writeBuffer(DcmOutputStream &outStream, OFBool stable = OFFalse);
 
 private:
 
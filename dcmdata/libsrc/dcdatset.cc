@@ -669,11 +669,19 @@ OFCondition DcmDataset::loadFileUntilTag(const OFFilename &fileName,
             }
 
         } else {
-            /* open file for input */
-            DcmInputFileStream fileStream(fileName);
+            /* open file for input, use a memory-mapped file if enabled and possible */
+            DcmInputStream *fileStream = NULL;
+            DcmMappedFile *mapping = dcmUseMemoryMappedFiles.get() ? DcmMappedFile::newInstance(fileName) : NULL;
+            if (mapping)
+            {
+                fileStream = new DcmInputMappedFileStream(mapping, fileName);
+                /* the stream keeps its own reference to the mapped file */
+                mapping->decreaseRefCount();
+            } else
+                fileStream = new DcmInputFileStream(fileName);
 
             /* check stream status */
-            l_error = fileStream.status();
+            l_error = fileStream->status();
 
             if (l_error.good())
             {
@@ -683,11 +691,11 @@ OFCondition DcmDataset::loadFileUntilTag(const OFFilename &fileName,
                 {
                     /* read data from file */
                     transferInit();
-                    l_error = readUntilTag(fileStream, readXfer, groupLength, maxReadLength, stopParsingAtElement);
+                    l_error = readUntilTag(*fileStream, readXfer, groupLength, maxReadLength, stopParsingAtElement);
                     transferEnd();
                 }
             }
-
+            delete fileStream;
         }
     }
     return l_error;
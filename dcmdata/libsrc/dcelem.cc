@@ -31,6 +31,7 @@
 #include "dcmtk/dcmdata/dcobject.h"
 #include "dcmtk/dcmdata/dcswap.h"
 #include "dcmtk/dcmdata/dcistrma.h"    /* for class DcmInputStream */
+#include "dcmtk/dcmdata/dcistrmf.h"    /* for class DcmMappedFile */
 #include "dcmtk/dcmdata/dcostrma.h"    /* for class DcmOutputStream */
 #include "dcmtk/dcmdata/dcfcache.h"    /* for class DcmFileCache */
 #include "dcmtk/dcmdata/dcwcache.h"    /* for class DcmWriteCache */
@@ -41,6 +42,9 @@
 
 #include <cstring>                      /* for memset() */
 
+/* minimum length of an element value that may refer to a memory-mapped file */
+#define DCM_MinMappedValueLength 4096
+
 #define SWAPBUFFER_SIZE 16  /* sufficient for all DICOM VRs as per the 2007 edition */
 
 //
@@ -52,7 +56,8 @@ DcmElement::DcmElement(const DcmTag &tag,
   : DcmObject(tag, len),
     fByteOrder(gLocalByteOrder),
     fLoadValue(NULL),
-    fValue(NULL)
+    fValue(NULL),
+    fMappedFile(NULL)
 {
 }
 
@@ -61,7 +66,8 @@ DcmElement::DcmElement(const DcmElement &elem)
   : DcmObject(elem),
     fByteOrder(elem.fByteOrder),
     fLoadValue(NULL),
-    fValue(NULL)
+    fValue(NULL),
+    fMappedFile(NULL)
 {
     if (elem.fValue)
     {
@@ -133,13 +139,7 @@ DcmElement &DcmElement::operator=(const DcmElement &obj)
 {
   if (this != &obj)
   {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-    // if created with the nothrow version it must also be deleted with
-    // the nothrow version else memory error.
-    operator delete[] (fValue, std::nothrow);
-#else
-    delete[] fValue;
-#endif
+    deleteValueField();
     delete fLoadValue;
     fLoadValue = NULL;
     fValue = NULL;
@@ -256,13 +256,7 @@ OFCondition DcmElement::copyFrom(const DcmObject& rhs)
 
 DcmElement::~DcmElement()
 {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-    // if created with the nothrow version it must also be deleted with
-    // the nothrow version else memory error.
-    operator delete[] (fValue, std::nothrow);
-#else
-    delete[] fValue;
-#endif
+    deleteValueField();
     delete fLoadValue;
 }
 
@@ -273,14 +267,7 @@ DcmElement::~DcmElement()
 OFCondition DcmElement::clear()
 {
     errorFlag = EC_Normal;
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-    // if created with the nothrow version it must also be deleted with
-    // the nothrow version else memory error.
-    operator delete[] (fValue, std::nothrow);
-#else
-    delete[] fValue;
-#endif
-    fValue = NULL;
+    deleteValueField();
     delete fLoadValue;
     fLoadValue = NULL;
     setLengthField(0);
@@ -349,7 +336,25 @@ OFBool DcmElement::canWriteXfer(const E_TransferSyntax newXfer,
 OFCondition DcmElement::detachValueField(OFBool copy)
 {
     OFCondition l_error = EC_Normal;
-    if (getLengthField() != 0)
+    /* a value that refers to a memory-mapped file cannot be handed over */
+    if (fMappedFile)
+    {
+        if (copy)
+        {
+            /* copy the value out of the mapped file */
+            Uint8 *newValue = newValueField();
+            if (newValue)
+            {
+                memcpy(newValue, fValue, size_t(getLengthField()));
+                fMappedFile->decreaseRefCount();
+                fMappedFile = NULL;
+                fValue = newValue;
+            } else
+                l_error = EC_MemoryExhausted;
+        } else
+            l_error = EC_IllegalCall;
+    }
+    else if (getLengthField() != 0)
     {
         if (copy)
         {
@@ -866,13 +871,7 @@ OFCondition DcmElement::changeValue(const void *value,
                     memcpy(newValue, fValue, size_t(getLengthField()));
                     // copy value passed as a parameter to the end
                     memcpy(&newValue[getLengthField()], OFstatic_cast(const Uint8 *, value), size_t(num));
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-                    // if created with the nothrow version it must also be deleted with
-                    // the nothrow version else memory error.
-                    operator delete[] (fValue, std::nothrow);
-#else
-                    delete[] fValue;
-#endif
+                    deleteValueField();
                     fValue = newValue;
                     setLengthField(getLengthField() + num);
                 } else
@@ -1039,17 +1038,7 @@ OFCondition DcmElement::putValue(const void * newValue,
 {
     errorFlag = EC_Normal;
 
-    if (fValue)
-    {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-        // if created with the nothrow version it must also be deleted with
-        // the nothrow version else memory error.
-        operator delete[] (fValue, std::nothrow);
-#else
-        delete[] fValue;
-#endif
-    }
-    fValue = NULL;
+    deleteValueField();
 
     if (fLoadValue)
         delete fLoadValue;
@@ -1102,17 +1091,7 @@ OFCondition DcmElement::createUint16Array(const Uint32 /*numWords*/,
 OFCondition DcmElement::createEmptyValue(const Uint32 length)
 {
     errorFlag = EC_Normal;
-    if (fValue)
-    {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-        // if created with the nothrow version it must also be deleted with
-        // the nothrow version else memory error.
-        operator delete[] (fValue, std::nothrow);
-#else
-        delete[] fValue;
-#endif
-    }
-    fValue = NULL;
+    deleteValueField();
     if (fLoadValue)
         delete fLoadValue;
     fLoadValue = NULL;
@@ -1193,12 +1172,32 @@ OFCondition DcmElement::read(DcmInputStream &inStream,
             /* the reading of this element's value from the stream */
             if (getTransferState() == ERW_init)
             {
+                /* if the stream is backed by a memory-mapped file, large binary values */
+                /* do not need to be copied but can refer to the mapped file directly */
+                DcmMappedFile *mapping = NULL;
+                Uint8 *mappedValue = getMappedValue(inStream, mapping);
+                if (mappedValue)
+                {
+                    /* if there is already a value for this element, delete this value */
+                    deleteValueField();
+                    delete fLoadValue;
+                    fLoadValue = NULL;
+                    /* modifications of the value do not affect the file (copy-on-write) */
+                    fValue = mappedValue;
+                    fMappedFile = mapping;
+                    fMappedFile->increaseRefCount();
+                    setTransferredBytes(OFstatic_cast(Uint32, inStream.skip(getLengthField())));
+                    DCMDATA_TRACE("DcmElement::read() Value of element " << getTag()
+                        << " with " << getLengthField() << " bytes refers to memory-mapped file");
+                    postLoadValue();
+                    setTransferState(ERW_ready);
+                }
                 /* if the Length of this element's value is greater than the amount of bytes we */
                 /* can read from the stream and if the stream has random access, we want to create */
                 /* a DcmInputStreamFactory object that enables us to read this element's value later. */
                 /* This new object will be stored (together with the position where we have to start */
                 /* reading the value) in the member variable fLoadValue. */
-                if (getLengthField() > maxReadLength)
+                else if (getLengthField() > maxReadLength)
                 {
                     /* try to create a stream factory to read the value later */
                     delete fLoadValue;
@@ -1221,16 +1220,13 @@ OFCondition DcmElement::read(DcmInputStream &inStream,
                         }
                     }
                 }
-                /* if there is already a value for this element, delete this value */
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-                // if created with the nothrow version it must also be deleted with
-                // the nothrow version else memory error.
-                operator delete[] (fValue, std::nothrow);
-#else
-                delete[] fValue;
-#endif
-                /* set the transfer state to ERW_inWork */
-                setTransferState(ERW_inWork);
+                /* set the transfer state to ERW_inWork (unless the value has been mapped) */
+                if (getTransferState() == ERW_init)
+                {
+                    /* if there is already a value for this element, delete this value */
+                    deleteValueField();
+                    setTransferState(ERW_inWork);
+                }
             }
             /* if the transfer state is ERW_inWork and we are not supposed */
             /* to read this element's value later, read the value now */
@@ -1252,6 +1248,64 @@ OFCondition DcmElement::read(DcmInputStream &inStream,
 // ********************************
 
 
+Uint8 *DcmElement::getMappedValue(DcmInputStream &inStream,
+                                  DcmMappedFile *&mapping)
+{
+    Uint8 *result = NULL;
+    const Uint32 length = getLengthField();
+    /* only large binary values with even length are considered */
+    if ((length >= DCM_MinMappedValueLength) && (length != DCM_UndefinedLength) && ((length & 1) == 0))
+    {
+        switch (getTag().getEVR())
+        {
+            case EVR_OB:
+            case EVR_OW:
+            case EVR_OF:
+            case EVR_OD:
+            case EVR_OL:
+            case EVR_OV:
+            case EVR_ox:
+            case EVR_px:
+            case EVR_pixelItem:
+            {
+                result = inStream.mappedData(length, mapping);
+                /* make sure that the value is properly aligned in memory */
+                const size_t valueWidth = getTag().getVR().getValueWidth();
+                if (result && (valueWidth > 1) && ((OFreinterpret_cast(size_t, result) % valueWidth) != 0))
+                    result = NULL;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return result;
+}
+
+
+void DcmElement::deleteValueField()
+{
+    if (fMappedFile)
+    {
+        /* value refers to a memory-mapped file, so only release the reference */
+        fMappedFile->decreaseRefCount();
+        fMappedFile = NULL;
+    } else {
+#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
+        // if created with the nothrow version it must also be deleted with
+        // the nothrow version else memory error.
+        operator delete[] (fValue, std::nothrow);
+#else
+        delete[] fValue;
+#endif
+    }
+    fValue = NULL;
+}
+
+
+// ********************************
+
+
 void DcmElement::swapValueField(size_t valueWidth)
 {
     if (getLengthField() != 0)
@@ -1355,6 +1409,14 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
                 value = OFstatic_cast(Uint8 *, getValue(outByteOrder));
                 if (value) accessPossible = OFTrue;
               }
+              else if ((outStream.avail() == 0) && (getTransferState() != ERW_ready))
+              {
+                /* do not access the file if nothing can be written anyway. This also makes
+                 * sure that the cache buffer is not re-filled while still being referenced
+                 * by the output stream (see DcmWriteCache::writeBuffer()).
+                 */
+                errorFlag = EC_StreamNotifyClient;
+              }
               else
               {
                 /* Use local cache object if needed. This may cause those bytes
@@ -1417,7 +1479,7 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
                     /* write as many bytes as possible to the stream starting at value[getTransferredBytes()] */
                     /* (note that the bytes value[0] to value[getTransferredBytes()-1] have already been */
                     /* written to the stream) */
-                    len = OFstatic_cast(Uint32, outStream.write(&value[getTransferredBytes()], getLengthField() - getTransferredBytes()));
+                    len = OFstatic_cast(Uint32, outStream.writeStable(&value[getTransferredBytes()], getLengthField() - getTransferredBytes()));
 
                     /* increase the amount of bytes which have been transfered correspondingly */
                     incTransferredBytes(len);
@@ -1438,7 +1500,7 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
                       if (errorFlag.good())
                       {
                         // write as many bytes from cache buffer to stream as possible
-                        len = wcache->writeBuffer(outStream);
+                        len = wcache->writeBuffer(outStream, wcache != &wcache2);
 
                         /* increase the amount of bytes which have been transfered correspondingly */
                         incTransferredBytes(len);
@@ -1449,7 +1511,7 @@ OFCondition DcmElement::write(DcmOutputStream &outStream,
 
                       // stop writing if something went wrong, we were unable to send all of the buffer content
                       // (which indicates that the output stream needs to be flushed, or everything was sent out.
-                      done = errorFlag.bad() || (len < buflen) || (getTransferredBytes() == getLengthField());
+                      done = errorFlag.bad() || (len < buflen) || (outStream.avail() == 0) || (getTransferredBytes() == getLengthField());
                     }
                 }
 
@@ -1951,8 +2013,7 @@ void DcmElement::compact()
   {
     DCMDATA_DEBUG("DcmElement::compact() removed element value of " << getTag()
         << " with " << getTransferredBytes() << " bytes");
-    delete[] fValue;
-    fValue = NULL;
+    deleteValueField();
     setTransferredBytes(0);
   }
 }
@@ -1964,14 +2025,7 @@ OFCondition DcmElement::createValueFromTempFile(DcmInputStreamFactory *factory,
 {
     if (factory && !(length & 1))
     {
-#if defined(HAVE_STD__NOTHROW) && defined(HAVE_NOTHROW_DELETE)
-        // if created with the nothrow version it must also be deleted with
-        // the nothrow version else memory error.
-        operator delete[] (fValue, std::nothrow);
-#else
-        delete[] fValue;
-#endif
-        fValue = 0;
+        deleteValueField();
         delete fLoadValue;
         fLoadValue = factory;
         fByteOrder = byteOrder;
@@ -936,11 +936,19 @@ OFCondition DcmFileFormat::loadFileUntilTag(
             }
 
         } else {
-            /* open file for output */
-            DcmInputFileStream fileStream(fileName);
+            /* open file for input, use a memory-mapped file if enabled and possible */
+            DcmInputStream *fileStream = NULL;
+            DcmMappedFile *mapping = dcmUseMemoryMappedFiles.get() ? DcmMappedFile::newInstance(fileName) : NULL;
+            if (mapping)
+            {
+                fileStream = new DcmInputMappedFileStream(mapping, fileName);
+                /* the stream keeps its own reference to the mapped file */
+                mapping->decreaseRefCount();
+            } else
+                fileStream = new DcmInputFileStream(fileName);
 
             /* check stream status */
-            l_error = fileStream.status();
+            l_error = fileStream->status();
             if (l_error.good())
             {
                 /* clear this object */
@@ -952,12 +960,13 @@ OFCondition DcmFileFormat::loadFileUntilTag(
                     FileReadMode = readMode;
                     /* read data from file */
                     transferInit();
-                    l_error = readUntilTag(fileStream, readXfer, groupLength, maxReadLength, stopParsingAtElement);
+                    l_error = readUntilTag(*fileStream, readXfer, groupLength, maxReadLength, stopParsingAtElement);
                     transferEnd();
                     /* restore old value */
                     FileReadMode = oldMode;
                 }
             }
+            delete fileStream;
         }
     }
     return l_error;
@@ -89,6 +89,12 @@ void DcmInputStream::putback()
   tell_ = mark_;
 }
 
+Uint8 *DcmInputStream::mappedData(const offile_off_t /* length */, DcmMappedFile *& /* mapping */)
+{
+  // not a memory-mapped stream
+  return NULL;
+}
+
 const DcmProducer *DcmInputStream::currentProducer() const
 {
   return current_;
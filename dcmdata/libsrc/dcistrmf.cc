@@ -25,6 +25,8 @@
 #include "dcmtk/dcmdata/dcistrmb.h"
 #include "dcmtk/dcmdata/dcerror.h"
 
+#include <cstring>                    /* for memcpy() */
+
 BEGIN_EXTERN_C
 #ifdef HAVE_FCNTL_H
 #include <fcntl.h>
@@ -32,8 +34,22 @@ BEGIN_EXTERN_C
 #ifdef HAVE_IO_H
 #include <io.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 END_EXTERN_C
 
+#ifdef HAVE_WINDOWS_H
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
 DcmFileProducer::DcmFileProducer(const OFFilename &filename, offile_off_t offset)
 : DcmProducer()
 , file_()
@@ -165,6 +181,7 @@ DcmInputFileStream::DcmInputFileStream(const OFFilename &filename, offile_off_t
 : DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
 , producer_(filename, offset)
 , filename_(filename)
+, offset_(offset)
 {
 }
 
@@ -178,7 +195,7 @@ DcmInputStreamFactory *DcmInputFileStream::newFactory() const
   if (currentProducer() == &producer_)
   {
     // no filter installed, can create factory object
-    result = new DcmInputFileStreamFactory(filename_, tell());
+    result = new DcmInputFileStreamFactory(filename_, offset_ + tell());
   }
   return result;
 }
@@ -262,3 +279,214 @@ DcmInputStreamFactory *DcmInputTempFileStreamFactory::clone() const
 {
     return new DcmInputTempFileStreamFactory(*this);
 }
+
+
+/* ======================================================================= */
+
+DcmMappedFile::DcmMappedFile(Uint8 *data, offile_off_t size)
+#ifdef WITH_THREADS
+: refCount_(1), mutex_(), data_(data), size_(size)
+#else
+: refCount_(1), data_(data), size_(size)
+#endif
+{
+}
+
+DcmMappedFile::~DcmMappedFile()
+{
+#ifdef HAVE_WINDOWS_H
+    UnmapViewOfFile(data_);
+#elif defined(HAVE_SYS_MMAN_H)
+    munmap(data_, OFstatic_cast(size_t, size_));
+#endif
+}
+
+DcmMappedFile *DcmMappedFile::newInstance(const OFFilename &filename)
+{
+    DcmMappedFile *result = NULL;
+#ifdef HAVE_WINDOWS_H
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+#if (defined(WIDE_CHAR_FILE_IO_FUNCTIONS) || defined(WIDE_CHAR_MAIN_FUNCTION)) && defined(_WIN32)
+    if (filename.usesWideChars())
+        fileHandle = CreateFileW(filename.getWideCharPointer(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    else
+#endif
+        fileHandle = CreateFileA(filename.getCharPointer(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(fileHandle, &fileSize) && (fileSize.QuadPart > 0) &&
+            (OFstatic_cast(Uint64, fileSize.QuadPart) <= OFstatic_cast(Uint64, OFstatic_cast(size_t, -1))))
+        {
+            // map the file in copy-on-write mode
+            HANDLE mapHandle = CreateFileMapping(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+            if (mapHandle != NULL)
+            {
+                void *data = MapViewOfFile(mapHandle, FILE_MAP_COPY, 0, 0, 0);
+                if (data != NULL)
+                    result = new DcmMappedFile(OFstatic_cast(Uint8 *, data), OFstatic_cast(offile_off_t, fileSize.QuadPart));
+                // the view keeps a reference to the mapping object
+                CloseHandle(mapHandle);
+            }
+        }
+        CloseHandle(fileHandle);
+    }
+#elif defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H)
+    if (!filename.isEmpty() && !filename.isStandardStream())
+    {
+        const int fd = open(filename.getCharPointer(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat fileStat;
+            if ((fstat(fd, &fileStat) == 0) && S_ISREG(fileStat.st_mode) && (fileStat.st_size > 0) &&
+                (OFstatic_cast(Uint64, fileStat.st_size) <= OFstatic_cast(Uint64, OFstatic_cast(size_t, -1))))
+            {
+                // map the file in copy-on-write mode, i.e. modifications are private
+                const size_t size = OFstatic_cast(size_t, fileStat.st_size);
+                void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED)
+                    result = new DcmMappedFile(OFstatic_cast(Uint8 *, data), OFstatic_cast(offile_off_t, size));
+            }
+            // the mapping remains valid after the file is closed
+            close(fd);
+        }
+    }
+#else
+    (void) filename;
+#endif
+    return result;
+}
+
+void DcmMappedFile::increaseRefCount()
+{
+#ifdef WITH_THREADS
+    mutex_.lock();
+#endif
+    ++refCount_;
+#ifdef WITH_THREADS
+    mutex_.unlock();
+#endif
+}
+
+void DcmMappedFile::decreaseRefCount()
+{
+#ifdef WITH_THREADS
+    mutex_.lock();
+#endif
+    size_t result = --refCount_;
+#ifdef WITH_THREADS
+    mutex_.unlock();
+#endif
+    if (result == 0) delete this;
+}
+
+/* ======================================================================= */
+
+DcmMappedFileProducer::DcmMappedFileProducer(DcmMappedFile *mapping, offile_off_t offset)
+: DcmProducer()
+, mapping_(mapping)
+, status_(EC_Normal)
+, pos_(0)
+{
+  mapping_->increaseRefCount();
+  if (offset <= mapping_->size())
+    pos_ = offset;
+  else
+    status_ = EC_InvalidStream;
+}
+
+DcmMappedFileProducer::~DcmMappedFileProducer()
+{
+  mapping_->decreaseRefCount();
+}
+
+OFBool DcmMappedFileProducer::good() const
+{
+  return status_.good();
+}
+
+OFCondition DcmMappedFileProducer::status() const
+{
+  return status_;
+}
+
+OFBool DcmMappedFileProducer::eos()
+{
+  return (pos_ >= mapping_->size());
+}
+
+offile_off_t DcmMappedFileProducer::avail()
+{
+  return mapping_->size() - pos_;
+}
+
+offile_off_t DcmMappedFileProducer::read(void *buf, offile_off_t buflen)
+{
+  offile_off_t result = 0;
+  if (status_.good() && buf && buflen)
+  {
+    result = (mapping_->size() - pos_ < buflen) ? (mapping_->size() - pos_) : buflen;
+    memcpy(buf, mapping_->data() + pos_, OFstatic_cast(size_t, result));
+    pos_ += result;
+  }
+  return result;
+}
+
+offile_off_t DcmMappedFileProducer::skip(offile_off_t skiplen)
+{
+  offile_off_t result = 0;
+  if (status_.good() && skiplen)
+  {
+    result = (mapping_->size() - pos_ < skiplen) ? (mapping_->size() - pos_) : skiplen;
+    pos_ += result;
+  }
+  return result;
+}
+
+void DcmMappedFileProducer::putback(offile_off_t num)
+{
+  if (status_.good() && num)
+  {
+    if (num <= pos_)
+      pos_ -= num;
+    else status_ = EC_PutbackFailed; // tried to putback before start of file
+  }
+}
+
+/* ======================================================================= */
+
+DcmInputMappedFileStream::DcmInputMappedFileStream(DcmMappedFile *mapping, const OFFilename &filename, offile_off_t offset)
+: DcmInputStream(&producer_) // safe because DcmInputStream only stores pointer
+, producer_(mapping, offset)
+, filename_(filename)
+, offset_(offset)
+{
+}
+
+DcmInputMappedFileStream::~DcmInputMappedFileStream()
+{
+}
+
+DcmInputStreamFactory *DcmInputMappedFileStream::newFactory() const
+{
+  DcmInputStreamFactory *result = NULL;
+  if (currentProducer() == &producer_)
+  {
+    // no filter installed, can create factory object.
+    // Values that are loaded later are read from the file in the usual way.
+    result = new DcmInputFileStreamFactory(filename_, offset_ + tell());
+  }
+  return result;
+}
+
+Uint8 *DcmInputMappedFileStream::mappedData(const offile_off_t length, DcmMappedFile *&mapping)
+{
+  Uint8 *result = NULL;
+  // only possible if no filter is installed
+  if ((currentProducer() == &producer_) && producer_.good() && (producer_.avail() >= length))
+  {
+    mapping = producer_.mapping();
+    result = producer_.currentData();
+  }
+  return result;
+}
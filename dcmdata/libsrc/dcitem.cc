@@ -83,9 +83,11 @@ DcmItem::DcmItem()
     elementList(NULL),
     lastElementComplete(OFTrue),
     fStartPosition(0),
-    privateCreatorCache()
+    privateCreatorCache(),
+    quietStopParsing(OFFalse)
 {
     elementList = new DcmList;
+    elementList->enableIndex(dcmEnableElementIndex.get());
 }
 
 
@@ -95,9 +97,11 @@ DcmItem::DcmItem(const DcmTag &tag,
     elementList(NULL),
     lastElementComplete(OFTrue),
     fStartPosition(0),
-    privateCreatorCache()
+    privateCreatorCache(),
+    quietStopParsing(OFFalse)
 {
     elementList = new DcmList;
+    elementList->enableIndex(dcmEnableElementIndex.get());
 }
 
 
@@ -106,8 +110,11 @@ DcmItem::DcmItem(const DcmItem &old)
     elementList(new DcmList),
     lastElementComplete(old.lastElementComplete),
     fStartPosition(old.fStartPosition),
-    privateCreatorCache()
+    privateCreatorCache(),
+    quietStopParsing(old.quietStopParsing)
 {
+    // the copy uses the element index if (and only if) the original does
+    elementList->enableIndex(old.elementList->indexEnabled());
     if (!old.elementList->empty())
     {
         elementList->seek(ELP_first);
@@ -132,10 +139,12 @@ DcmItem& DcmItem::operator=(const DcmItem& obj)
 
         // delete any existing elements
         elementList->deleteAllElements();
+        elementList->enableIndex(obj.elementList->indexEnabled());
 
         // copy DcmItem's member variables
         lastElementComplete = obj.lastElementComplete;
         fStartPosition = obj.fStartPosition;
+        quietStopParsing = obj.quietStopParsing;
         if (!obj.elementList->empty())
         {
             elementList->seek(ELP_first);
@@ -1346,6 +1355,12 @@ OFCondition DcmItem::read(DcmInputStream & inStream,
     return DcmItem::readUntilTag(inStream, xfer, glenc, maxReadLength, DCM_UndefinedTagKey);
 }
 
+void DcmItem::setQuietStopParsing(const OFBool quiet)
+{
+    quietStopParsing = quiet;
+}
+
+
 OFCondition DcmItem::readUntilTag(DcmInputStream & inStream,
                                   const E_TransferSyntax xfer,
                                   const E_GrpLenEncoding glenc,
@@ -1434,8 +1449,12 @@ OFCondition DcmItem::readUntilTag(DcmInputStream & inStream,
                     {
                       lastElementComplete = OFTrue;
                       readStopElem = OFTrue;
-                      DCMDATA_WARN("DcmItem: Element " << newTag.getTagName() << " " << newTag
-                        << " encountered, skipping rest of dataset");
+                      if (quietStopParsing)
+                        DCMDATA_DEBUG("DcmItem: Element " << newTag.getTagName() << " " << newTag
+                          << " encountered, skipping rest of dataset");
+                      else
+                        DCMDATA_WARN("DcmItem: Element " << newTag.getTagName() << " " << newTag
+                          << " encountered, skipping rest of dataset");
                     }
                     else
                     {
@@ -1765,6 +1784,13 @@ OFCondition DcmItem::insert(DcmElement *elem,
     {
         DcmElement *dE;
         E_ListPos seekmode = ELP_last;
+        /* if available, use the tag index in order to determine the element */
+        /* with the greatest tag that is less or equal to the new element's tag */
+        if (elementList->indexEnabled())
+        {
+            elementList->seek_tag(elem->getTag(), OFFalse /*exactMatch*/);
+            seekmode = ELP_atpos;
+        }
         /* iterate through elementList (from the last element to the first) */
         do {
             /* get current element from elementList */
@@ -1998,6 +2024,17 @@ DcmElement *DcmItem::remove(const unsigned long num)
 DcmElement *DcmItem::remove(DcmObject *elem)
 {
     errorFlag = EC_IllegalCall;
+    /* if available, use the tag index in order to find the element */
+    if (elementList->indexEnabled() && elem != NULL)
+    {
+        if (elementList->seek_tag(elem->getTag()) == elem)
+        {
+            elementList->remove();     // removes element from list but does not delete it
+            elem->setParent(NULL);     // forget about the parent
+            errorFlag = EC_Normal;
+            return OFstatic_cast(DcmElement *, elem);
+        }
+    }
     if (!elementList->empty() && elem != NULL)
     {
         DcmObject *dO;
@@ -2029,17 +2066,13 @@ DcmElement *DcmItem::remove(const DcmTagKey &tag)
     DcmObject *dO = NULL;
     if (!elementList->empty())
     {
-        elementList->seek(ELP_first);
-        do {
-            dO = elementList->get();
-            if (dO->getTag() == tag)
-            {
-                elementList->remove();     // removes element from list but does not delete it
-                dO->setParent(NULL);       // forget about the parent
-                errorFlag = EC_Normal;
-                break;
-            }
-        } while (elementList->seek(ELP_next));
+        dO = elementList->seek_tag(tag);
+        if (dO != NULL)
+        {
+            elementList->remove();     // removes element from list but does not delete it
+            dO->setParent(NULL);       // forget about the parent
+            errorFlag = EC_Normal;
+        }
     }
 
     if (errorFlag == EC_TagNotFound)
@@ -2107,7 +2140,18 @@ OFCondition DcmItem::searchSubFromHere(const DcmTagKey &tag,
 {
     DcmObject *dO;
     OFCondition l_error = EC_TagNotFound;
-    if (!elementList->empty())
+    if (!searchIntoSub && elementList->indexEnabled())
+    {
+        /* no need to iterate over all elements */
+        dO = elementList->seek_tag(tag);
+        if (dO != NULL)
+        {
+            resultStack.push(dO);
+            l_error = EC_Normal;
+            DCMDATA_TRACE("DcmItem::searchSubFromHere() Element " << tag << " found");
+        }
+    }
+    else if (!elementList->empty())
     {
         elementList->seek(ELP_first);
         do {
@@ -3180,6 +3224,17 @@ OFCondition DcmItem::findAndDeleteElement(const DcmTagKey &tagKey,
                                           const OFBool searchIntoSub)
 {
     OFCondition status = EC_TagNotFound;
+    /* remove single element from the main level directly */
+    if (!allOccurrences && !searchIntoSub)
+    {
+        DcmElement *elem = remove(tagKey);
+        if (elem != NULL)
+        {
+            delete elem;
+            status = EC_Normal;
+        }
+        return status;
+    }
     DcmStack stack;
     DcmObject *object = NULL;
     OFBool intoSub = OFTrue;
@@ -55,7 +55,9 @@ DcmList::DcmList()
   : firstNode(NULL),
     lastNode(NULL),
     currentNode(NULL),
-    cardinality(0)
+    cardinality(0),
+    indexActive(OFFalse),
+    tagIndex()
 {
 }
 
@@ -95,6 +97,7 @@ DcmObject *DcmList::append( DcmObject *obj )
             node->prevNode = lastNode;
             currentNode = lastNode = node;
         }
+        addToIndex(currentNode);
         cardinality++;
     } // obj == NULL
     return obj;
@@ -117,6 +120,7 @@ DcmObject *DcmList::prepend( DcmObject *obj )
             firstNode->prevNode = node;
             currentNode = firstNode = node;
         }
+        addToIndex(currentNode);
         cardinality++;
     } // obj == NULL
     return obj;
@@ -133,6 +137,7 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
         if ( DcmList::empty() )                 // list is empty !
         {
             currentNode = firstNode = lastNode = new DcmListNode(obj);
+            addToIndex(currentNode);
             cardinality++;
         }
         else {
@@ -155,6 +160,7 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
                 node->nextNode = currentNode;
                 currentNode->prevNode = node;
                 currentNode = node;
+                addToIndex(node);
                 cardinality++;
             }
             else //( pos==ELP_next || pos==ELP_atpos )
@@ -169,6 +175,7 @@ DcmObject *DcmList::insert( DcmObject *obj, E_ListPos pos )
                 node->prevNode = currentNode;
                 currentNode->nextNode = node;
                 currentNode = node;
+                addToIndex(node);
                 cardinality++;
             }
         }
@@ -204,6 +211,7 @@ DcmObject *DcmList::remove()
             currentNode->nextNode->prevNode = currentNode->prevNode;
 
         currentNode = currentNode->nextNode;
+        removeFromIndex(tempnode);
         tempobj = tempnode->value();
         delete tempnode;
         cardinality--;
@@ -305,4 +313,175 @@ void DcmList::deleteAllElements()
     lastNode = NULL;
     currentNode = NULL;
     cardinality = 0;
+    tagIndex.clear();
+}
+
+
+// ********************************
+
+
+DcmObject *DcmList::seek_tag(const DcmTagKey &tag,
+                             const OFBool exactMatch)
+{
+    currentNode = NULL;
+    if (indexActive)
+    {
+        const size_t count = tagIndex.size();
+        size_t pos = lowerBound(tag);
+        if (pos < count && tagIndex[pos].tagKey == tag)
+        {
+            // make sure that the object's tag has not been changed in the meantime
+            if (tagIndex[pos].node->value()->getTag() != tag)
+            {
+                rebuildIndex();
+                return seek_tag(tag, exactMatch);
+            }
+            // in case of multiple objects with the same tag, the one that comes
+            // first in the list is not necessarily the first one in the index
+            if ((pos + 1 < count) && (tagIndex[pos + 1].tagKey == tag))
+            {
+                for (DcmListNode *node = firstNode; node != NULL; node = node->nextNode)
+                {
+                    if (node->value()->getTag() == tag)
+                    {
+                        currentNode = node;
+                        break;
+                    }
+                }
+            } else
+                currentNode = tagIndex[pos].node;
+        }
+        else if (!exactMatch)
+        {
+            // find the last object in the index with a smaller tag
+            while (pos < count && tagIndex[pos].tagKey <= tag)
+                ++pos;
+            if (pos > 0)
+                currentNode = tagIndex[pos - 1].node;
+        }
+    } else {
+        DcmListNode *node;
+        if (exactMatch)
+        {
+            // search from start of list
+            for (node = firstNode; node != NULL; node = node->nextNode)
+            {
+                if (node->value()->getTag() == tag)
+                    break;
+            }
+        } else {
+            // search from end of list (assuming ascending tag order)
+            for (node = lastNode; node != NULL; node = node->prevNode)
+            {
+                if (node->value()->getTag() <= tag)
+                    break;
+            }
+        }
+        currentNode = node;
+    }
+    return get( ELP_atpos );
+}
+
+
+// ********************************
+
+
+void DcmList::enableIndex(const OFBool enable)
+{
+    if (enable != indexActive)
+    {
+        indexActive = enable;
+        if (indexActive)
+            rebuildIndex();
+        else
+        {
+            // also free the memory allocated for the index
+            OFVector<DcmListIndexEntry>().swap(tagIndex);
+        }
+    }
+}
+
+
+// ********************************
+
+
+size_t DcmList::lowerBound(const DcmTagKey &tag) const
+{
+    size_t first = 0;
+    size_t count = tagIndex.size();
+    while (count > 0)
+    {
+        const size_t step = count / 2;
+        if (tagIndex[first + step].tagKey < tag)
+        {
+            first += step + 1;
+            count -= step + 1;
+        } else
+            count = step;
+    }
+    return first;
+}
+
+
+// ********************************
+
+
+void DcmList::addToIndex(DcmListNode *node)
+{
+    if (indexActive)
+    {
+        const DcmTagKey tag = node->value()->getTag();
+        // in most cases, objects are added in ascending tag order
+        if (tagIndex.empty() || !(tag < tagIndex.back().tagKey))
+            tagIndex.push_back(DcmListIndexEntry(tag, node));
+        else
+        {
+            // insert after all entries with the same tag
+            size_t pos = lowerBound(tag);
+            while (pos < tagIndex.size() && tagIndex[pos].tagKey == tag)
+                ++pos;
+            tagIndex.insert(tagIndex.begin() + pos, DcmListIndexEntry(tag, node));
+        }
+    }
+}
+
+
+// ********************************
+
+
+void DcmList::removeFromIndex(DcmListNode *node)
+{
+    if (indexActive)
+    {
+        const size_t count = tagIndex.size();
+        size_t pos = lowerBound(node->value()->getTag());
+        while (pos < count && tagIndex[pos].node != node && tagIndex[pos].tagKey == node->value()->getTag())
+            ++pos;
+        if (pos >= count || tagIndex[pos].node != node)
+        {
+            // tag has been changed in the meantime, so search sequentially
+            for (pos = 0; pos < count; ++pos)
+            {
+                if (tagIndex[pos].node == node)
+                    break;
+            }
+        }
+        if (pos < count)
+            tagIndex.erase(tagIndex.begin() + pos);
+    }
+}
+
+
+// ********************************
+
+
+void DcmList::rebuildIndex()
+{
+    tagIndex.clear();
+    if (indexActive)
+    {
+        tagIndex.reserve(cardinality);
+        for (DcmListNode *node = firstNode; node != NULL; node = node->nextNode)
+            addToIndex(node);
+    }
 }
@@ -54,6 +54,9 @@ OFGlobal<OFBool>    dcmReplaceWrongDelimitationItem(OFFalse);
 OFGlobal<OFBool>    dcmConvertUndefinedLengthOBOWtoSQ(OFFalse);
 OFGlobal<OFBool>    dcmConvertVOILUTSequenceOWtoSQ(OFFalse);
 OFGlobal<OFBool>    dcmUseExplLengthPixDataForEncTS(OFFalse);
+OFGlobal<OFBool>    dcmEnableElementIndex(OFFalse);
+OFGlobal<OFBool>    dcmUseMemoryMappedFiles(OFFalse);
+OFGlobal<OFBool>    dcmEnableLazySequenceParsing(OFFalse);
 
 // ****** public methods **********************************
 
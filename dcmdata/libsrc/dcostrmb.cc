@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2002-2017, OFFIS e.V.
+ *  Copyright (C) 2002-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -30,6 +30,9 @@ DcmBufferConsumer::DcmBufferConsumer(void *buf, offile_off_t bufLen)
 , buffer_(OFstatic_cast(unsigned char *, buf))
 , bufSize_(bufLen)
 , filled_(0)
+, block_(NULL)
+, blockLength_(0)
+, zeroCopyThreshold_(0)
 , status_(EC_Normal)
 {
   if (buffer_ == NULL) status_ = EC_IllegalCall;
@@ -51,18 +54,20 @@ OFCondition DcmBufferConsumer::status() const
 
 OFBool DcmBufferConsumer::isFlushed() const
 {
-  return (filled_ == 0);
+  return (filled_ == 0) && (blockLength_ == 0);
 }
 
 offile_off_t DcmBufferConsumer::avail() const
 {
+  // nothing can be appended to a referenced block
+  if (block_) return 0;
   return bufSize_ - filled_;
 }
 
 offile_off_t DcmBufferConsumer::write(const void *buf, offile_off_t buflen)
 {
   offile_off_t result = 0;
-  if (status_.good() && buf && buflen)
+  if (status_.good() && buf && buflen && !block_)
   {
     result = bufSize_ - filled_;
     if (result > buflen) result = buflen;
@@ -72,21 +77,64 @@ offile_off_t DcmBufferConsumer::write(const void *buf, offile_off_t buflen)
   return result;
 }
 
+offile_off_t DcmBufferConsumer::writeStable(const void *buf, offile_off_t buflen)
+{
+  offile_off_t result = 0;
+  if (status_.good() && buf && buflen && !block_)
+  {
+    result = bufSize_ - filled_;
+    if (result > buflen) result = buflen;
+    // small blocks are copied, since a reference completes the current content of the buffer
+    if ((zeroCopyThreshold_ > 0) && (result >= zeroCopyThreshold_))
+    {
+      block_ = buf;
+      blockLength_ = result;
+    }
+    else result = write(buf, buflen);
+  }
+  return result;
+}
+
 void DcmBufferConsumer::flush()
 {
   // nothing to flush
 }
 
 void DcmBufferConsumer::flushBuffer(void *& buffer, offile_off_t& length)
+{
+  // the buffer always has enough space left for the referenced block
+  if (block_)
+  {
+    memcpy(buffer_ + filled_, block_, OFstatic_cast(size_t, blockLength_));
+    filled_ += blockLength_;
+  }
+  buffer = buffer_;
+  length = filled_;
+  filled_ = 0;
+  block_ = NULL;
+  blockLength_ = 0;
+}
+
+void DcmBufferConsumer::flushBuffer(void *& buffer, offile_off_t& length,
+                                    const void *& block, offile_off_t& blockLength)
 {
   buffer = buffer_;
   length = filled_;
+  block = block_;
+  blockLength = blockLength_;
   filled_ = 0;
+  block_ = NULL;
+  blockLength_ = 0;
 }
 
 offile_off_t DcmBufferConsumer::filled()
 {
-  return filled_;
+  return filled_ + blockLength_;
+}
+
+void DcmBufferConsumer::setZeroCopyThreshold(offile_off_t threshold)
+{
+  zeroCopyThreshold_ = threshold;
 }
 
 /* ======================================================================= */
@@ -112,7 +160,18 @@ void DcmOutputBufferStream::flushBuffer(void *& buffer, offile_off_t& length)
   consumer_.flushBuffer(buffer, length);
 }
 
+void DcmOutputBufferStream::flushBuffer(void *& buffer, offile_off_t& length,
+                                        const void *& block, offile_off_t& blockLength)
+{
+  consumer_.flushBuffer(buffer, length, block, blockLength);
+}
+
 offile_off_t DcmOutputBufferStream::filled()
 {
   return consumer_.filled();
 }
+
+void DcmOutputBufferStream::setZeroCopyThreshold(offile_off_t threshold)
+{
+  consumer_.setZeroCopyThreshold(threshold);
+}
@@ -32,6 +32,9 @@ BEGIN_EXTERN_C
 #ifdef HAVE_IO_H
 #include <io.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 END_EXTERN_C
 
 
@@ -39,6 +42,10 @@ DcmFileConsumer::DcmFileConsumer(const OFFilename &filename)
 : DcmConsumer()
 , file_()
 , status_(EC_Normal)
+, chunkSize_(0)
+, position_(0)
+, reserved_(0)
+, released_(0)
 {
   if (!file_.fopen(filename, "wb"))
   {
@@ -51,11 +58,23 @@ DcmFileConsumer::DcmFileConsumer(FILE *file)
 : DcmConsumer()
 , file_(file)
 , status_(EC_Normal)
+, chunkSize_(0)
+, position_(0)
+, reserved_(0)
+, released_(0)
 {
 }
 
 DcmFileConsumer::~DcmFileConsumer()
 {
+#ifdef HAVE_FALLOCATE
+  // release the disk space that has been reserved but not used
+  if ((reserved_ > position_) && file_.open() && (file_.fflush() == 0))
+  {
+    if (ftruncate(file_.fileNo(), position_) != 0)
+      DCMDATA_DEBUG("DcmFileConsumer: cannot release reserved disk space");
+  }
+#endif
   file_.fclose();
 }
 
@@ -115,6 +134,11 @@ offile_off_t DcmFileConsumer::write(const void *buf, offile_off_t buflen)
       result += written;
     }
 #endif
+    if (chunkSize_ > 0)
+    {
+      position_ += result;
+      updateFileHints();
+    }
   }
   return result;
 }
@@ -124,6 +148,46 @@ void DcmFileConsumer::flush()
   // nothing to flush
 }
 
+void DcmFileConsumer::setPreallocationChunkSize(const offile_off_t chunkSize)
+{
+  chunkSize_ = (chunkSize > 0) ? chunkSize : 0;
+  if ((chunkSize_ > 0) && file_.open())
+  {
+    // start at the current position (the file might not be empty)
+    position_ = file_.ftell();
+    if (reserved_ < position_) reserved_ = position_;
+    if (released_ > position_) released_ = position_;
+    updateFileHints();
+  }
+}
+
+void DcmFileConsumer::updateFileHints()
+{
+#if defined(HAVE_FALLOCATE) || defined(HAVE_POSIX_FADVISE)
+  if ((position_ + chunkSize_ / 2 < reserved_) || !status_.good() || !file_.open())
+    return;
+  const int fd = file_.fileNo();
+#ifdef HAVE_FALLOCATE
+  // reserve the next chunk without changing the file size. This might fail if
+  // the file system does not support it, which is not an error.
+  const offile_off_t start = reserved_;
+  reserved_ = position_ + chunkSize_;
+  if (fallocate(fd, FALLOC_FL_KEEP_SIZE, start, reserved_ - start) != 0)
+    DCMDATA_TRACE("DcmFileConsumer: cannot reserve disk space at offset " << start);
+#else
+  reserved_ = position_ + chunkSize_;
+#endif
+#ifdef HAVE_POSIX_FADVISE
+  // this also starts writing the data back to disk (at least on Linux)
+  if (position_ - chunkSize_ > released_)
+  {
+    (void) posix_fadvise(fd, released_, position_ - chunkSize_ - released_, POSIX_FADV_DONTNEED);
+    released_ = position_ - chunkSize_;
+  }
+#endif
+#endif
+}
+
 /* ======================================================================= */
 
 DcmOutputFileStream::DcmOutputFileStream(const OFFilename &filename)
@@ -138,6 +202,11 @@ DcmOutputFileStream::DcmOutputFileStream(FILE *file)
 {
 }
 
+void DcmOutputFileStream::setPreallocationChunkSize(const offile_off_t chunkSize)
+{
+  consumer_.setPreallocationChunkSize(chunkSize);
+}
+
 DcmOutputFileStream::~DcmOutputFileStream()
 {
   // last attempt to flush stream before file is closed
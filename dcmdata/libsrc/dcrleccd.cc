@@ -32,6 +32,201 @@
 #include "dcmtk/dcmdata/dcvrpobw.h"  /* for class DcmPolymorphOBOW */
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary() */
 #include "dcmtk/dcmdata/dcuid.h"     /* for dcmGenerateUniqueIdentifer()*/
+#include "dcmtk/ofstd/ofthpool.h"    /* for class OFThreadPool */
+#include "dcmtk/ofstd/ofvector.h"    /* for class OFVector */
+
+
+/** helper class decompressing the frames of a multi-frame image in parallel.
+ *  This is only used if each frame is stored in exactly one pixel item,
+ *  which is required by the DICOM standard for RLE. The pixel items are
+ *  accessed before, so the frames can be decompressed without accessing
+ *  the pixel sequence. Only frames that are encoded correctly are accepted;
+ *  in all other cases, the caller falls back to the sequential decoder,
+ *  which also handles (and reports) a number of common encoding errors.
+ */
+class DcmRLEFrameDecoderTask: public OFThreadPool::Task
+{
+public:
+
+  /** constructor
+   *  @param imageData buffer for the uncompressed pixel data of all frames
+   *  @param frameSize size of an uncompressed frame in bytes
+   *  @param bytesAllocated number of bytes allocated per sample
+   *  @param samplesPerPixel number of samples per pixel
+   *  @param planarConfiguration planar configuration of the pixel data
+   *  @param columns number of columns
+   *  @param rows number of rows
+   *  @param reverseByteOrder assume LSB to MSB order of RLE segments
+   *  @param numberOfFrames number of frames
+   *  @param numberOfThreads number of threads that may call execute()
+   */
+  DcmRLEFrameDecoderTask(
+    Uint8 *imageData,
+    size_t frameSize,
+    Uint16 bytesAllocated,
+    Uint16 samplesPerPixel,
+    Uint16 planarConfiguration,
+    Uint16 columns,
+    Uint16 rows,
+    OFBool reverseByteOrder,
+    size_t numberOfFrames,
+    size_t numberOfThreads)
+  : imageData_(imageData)
+  , frameSize_(frameSize)
+  , bytesAllocated_(bytesAllocated)
+  , samplesPerPixel_(samplesPerPixel)
+  , planarConfiguration_(planarConfiguration)
+  , columns_(columns)
+  , rows_(rows)
+  , reverseByteOrder_(reverseByteOrder)
+  , decoders_(numberOfThreads, OFstatic_cast(DcmRLEDecoder *, NULL))
+  , fragments(numberOfFrames, OFstatic_cast(Uint8 *, NULL))
+  , fragmentLengths(numberOfFrames, 0)
+  {
+  }
+
+  /// destructor
+  virtual ~DcmRLEFrameDecoderTask()
+  {
+    for (size_t i = 0; i < decoders_.size(); ++i) delete decoders_[i];
+  }
+
+  /** decompress a single frame
+   *  @param index index of the frame
+   *  @param thread index of the calling thread
+   *  @return OFTrue if successful, OFFalse otherwise
+   */
+  virtual OFBool execute(const size_t index, const size_t thread)
+  {
+    const size_t bytesPerStripe = OFstatic_cast(size_t, columns_) * OFstatic_cast(size_t, rows_);
+    if (decoders_[thread] == NULL) decoders_[thread] = new DcmRLEDecoder(bytesPerStripe);
+    DcmRLEDecoder& rledecoder = *decoders_[thread];
+    if (rledecoder.fail()) return OFFalse;
+
+    Uint8 *rleData = fragments[index];
+    const Uint32 fragmentLength = fragmentLengths[index];
+    Uint8 *imageData8 = imageData_ + index * frameSize_;
+    Uint32 rleHeader[16];
+
+    // the RLE header must be completely contained in the fragment
+    if ((rleData == NULL) || (fragmentLength < 64)) return OFFalse;
+
+    // copy RLE header to buffer and adjust byte order
+    memcpy(rleHeader, rleData, 64);
+    swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, rleHeader, 16*OFstatic_cast(Uint32, sizeof(Uint32)), sizeof(Uint32));
+
+    // check that number of stripes in RLE header matches our expectation
+    const Uint32 numberOfStripes = rleHeader[0];
+    if ((numberOfStripes < 1) || (numberOfStripes > 15) ||
+        (numberOfStripes != OFstatic_cast(Uint32, bytesAllocated_) * samplesPerPixel_)) return OFFalse;
+
+    // for each stripe in stripe set
+    for (Uint32 stripeIndex = 0; stripeIndex < numberOfStripes; ++stripeIndex)
+    {
+      // reset RLE codec
+      rledecoder.clear();
+
+      // the stripe must start within the fragment
+      const Uint32 byteOffset = rleHeader[stripeIndex + 1];
+      if (byteOffset > fragmentLength) return OFFalse;
+
+      // the size of the last stripe is determined by the end of the fragment
+      Uint32 inputBytes = fragmentLength - byteOffset;
+      if (stripeIndex + 1 < numberOfStripes)
+      {
+        if ((rleHeader[stripeIndex + 2] < byteOffset) || (rleHeader[stripeIndex + 2] - byteOffset > inputBytes)) return OFFalse;
+        inputBytes = rleHeader[stripeIndex + 2] - byteOffset;
+      }
+
+      // the return code is ignored here (just like in the sequential decoder)
+      // since a zero pad byte or trailing garbage at the end of the RLE stream
+      // leads to an error, which is harmless if the stripe is complete
+      (void) rledecoder.decompress(rleData + byteOffset, OFstatic_cast(size_t, inputBytes));
+      if (rledecoder.size() != bytesPerStripe) return OFFalse;
+
+      // which sample and byte are we currently decompressing?
+      const Uint32 sample = stripeIndex / bytesAllocated_;
+      const Uint32 byte = stripeIndex % bytesAllocated_;
+
+      // compute byte offsets
+      Uint32 sampleOffset = 0;
+      Uint32 offsetBetweenSamples = 0;
+      if (planarConfiguration_ == 0)
+      {
+        sampleOffset = sample * bytesAllocated_;
+        offsetBetweenSamples = samplesPerPixel_ * bytesAllocated_;
+      }
+      else
+      {
+        sampleOffset = sample * bytesAllocated_ * columns_ * rows_;
+        offsetBetweenSamples = bytesAllocated_;
+      }
+
+      // initialize pointer to output data
+      Uint8 *pixelPointer = imageData8 + sampleOffset;
+      if (reverseByteOrder_)
+        pixelPointer += byte;
+        else pixelPointer += bytesAllocated_ - byte - 1;
+
+      // distribute decompressed bytes into output image array
+      const Uint8 *outputBuffer = OFstatic_cast(const Uint8 *, rledecoder.getOutputBuffer());
+      if (offsetBetweenSamples == 1)
+        memcpy(pixelPointer, outputBuffer, bytesPerStripe);
+      else
+      {
+        for (size_t pixel = 0; pixel < bytesPerStripe; ++pixel)
+        {
+          *pixelPointer = *outputBuffer++;
+          pixelPointer += offsetBetweenSamples;
+        }
+      }
+    }
+    return OFTrue;
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DcmRLEFrameDecoderTask(const DcmRLEFrameDecoderTask&);
+
+  /// private undefined copy assignment operator
+  DcmRLEFrameDecoderTask& operator=(const DcmRLEFrameDecoderTask&);
+
+  /// buffer for the uncompressed pixel data of all frames
+  Uint8 *imageData_;
+
+  /// size of an uncompressed frame in bytes
+  size_t frameSize_;
+
+  /// number of bytes allocated per sample
+  Uint16 bytesAllocated_;
+
+  /// number of samples per pixel
+  Uint16 samplesPerPixel_;
+
+  /// planar configuration of the pixel data
+  Uint16 planarConfiguration_;
+
+  /// number of columns
+  Uint16 columns_;
+
+  /// number of rows
+  Uint16 rows_;
+
+  /// assume LSB to MSB order of RLE segments
+  OFBool reverseByteOrder_;
+
+  /// RLE decoder for each thread, created on demand
+  OFVector<DcmRLEDecoder *> decoders_;
+
+public:
+
+  /// compressed data of each frame (content of the pixel item)
+  OFVector<Uint8 *> fragments;
+
+  /// length of the compressed data of each frame
+  OFVector<Uint32> fragmentLengths;
+};
 
 
 DcmRLECodecDecoder::DcmRLECodecDecoder()
@@ -144,6 +339,36 @@ OFCondition DcmRLECodecDecoder::decode(
         {
           Uint8 *imageData8 = OFreinterpret_cast(Uint8 *, imageData16);
 
+          // if each frame is stored in a single pixel item (as required by
+          // the standard), the frames can be decompressed in parallel
+          OFThreadPool pool(djcp->getNumberOfThreads());
+          if ((pool.getNumberOfThreads() > 1) && (imageFrames > 1) && (pixSeq->card() == OFstatic_cast(unsigned long, imageFrames) + 1))
+          {
+            DCMDATA_DEBUG("RLE decoder uses up to " << pool.getNumberOfThreads() << " threads");
+            DcmRLEFrameDecoderTask task(imageData8, frameSize, imageBytesAllocated, imageSamplesPerPixel,
+              imagePlanarConfiguration, imageColumns, imageRows, enableReverseByteOrder,
+              OFstatic_cast(size_t, imageFrames), pool.getNumberOfThreads());
+
+            // access the pixel items one after the other
+            OFBool itemsAvailable = OFTrue;
+            for (Sint32 frame = 0; (frame < imageFrames) && itemsAvailable; ++frame)
+            {
+              itemsAvailable = pixSeq->getItem(pixItem, OFstatic_cast(Uint32, frame) + 1).good() &&
+                pixItem->getUint8Array(task.fragments[frame]).good();
+              if (itemsAvailable) task.fragmentLengths[frame] = pixItem->getLength();
+            }
+
+            if (itemsAvailable && pool.run(task, OFstatic_cast(size_t, imageFrames)))
+            {
+              // all frames have been decompressed
+              currentFrame = imageFrames;
+            }
+            else
+            {
+              DCMDATA_DEBUG("RLE decoder cannot decompress frames in parallel, processing them one after the other");
+            }
+          }
+
           while ((currentFrame < imageFrames) && result.good())
           {
             DCMDATA_DEBUG("RLE decoder processes frame " << currentFrame);
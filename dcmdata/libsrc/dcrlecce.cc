@@ -30,9 +30,190 @@
 #include "dcmtk/dcmdata/dcswap.h"    /* for swapIfNecessary */
 #include "dcmtk/dcmdata/dcitem.h"
 #include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofthpool.h"   /* for class OFThreadPool */
+#include "dcmtk/ofstd/ofvector.h"   /* for class OFVector */
 
-typedef OFList<DcmRLEEncoder *> DcmRLEEncoderList;
-typedef OFListIterator(DcmRLEEncoder *) DcmRLEEncoderListIterator;
+
+/** helper class compressing the RLE stripes (segments) of a number of
+ *  consecutive frames, possibly in parallel. Each work item is a single
+ *  stripe, i.e. one byte of one sample of one frame.
+ */
+class DcmRLEStripeEncoderTask: public OFThreadPool::Task
+{
+public:
+
+  /** constructor
+   *  @param pixelData uncompressed pixel data of all frames, little endian
+   *  @param frameSize size of an uncompressed frame in bytes
+   *  @param bytesAllocated number of bytes allocated per sample
+   *  @param samplesPerPixel number of samples per pixel
+   *  @param planarConfiguration planar configuration of the pixel data
+   *  @param columns number of columns
+   *  @param rows number of rows
+   *  @param numberOfThreads number of threads that may call execute()
+   */
+  DcmRLEStripeEncoderTask(
+    const Uint8 *pixelData,
+    Uint32 frameSize,
+    Uint16 bytesAllocated,
+    Uint16 samplesPerPixel,
+    Uint16 planarConfiguration,
+    Uint16 columns,
+    Uint16 rows,
+    size_t numberOfThreads)
+  : pixelData_(pixelData)
+  , frameSize_(frameSize)
+  , bytesAllocated_(bytesAllocated)
+  , samplesPerPixel_(samplesPerPixel)
+  , planarConfiguration_(planarConfiguration)
+  , columns_(columns)
+  , rows_(rows)
+  , firstFrame_(0)
+  , rowBuffers_(numberOfThreads, OFstatic_cast(Uint8 *, NULL))
+  , encoders()
+  {
+  }
+
+  /// destructor
+  virtual ~DcmRLEStripeEncoderTask()
+  {
+    clear();
+    for (size_t i = 0; i < rowBuffers_.size(); ++i) delete[] rowBuffers_[i];
+  }
+
+  /// returns the number of stripes per frame
+  Uint32 getNumberOfStripes() const
+  {
+    return OFstatic_cast(Uint32, bytesAllocated_) * samplesPerPixel_;
+  }
+
+  /** prepare the next run
+   *  @param firstFrame index of the first frame compressed by the next run
+   *  @param numberOfFrames number of frames compressed by the next run
+   */
+  void prepare(Uint32 firstFrame, Uint32 numberOfFrames)
+  {
+    firstFrame_ = firstFrame;
+    encoders.clear();
+    encoders.resize(numberOfFrames * getNumberOfStripes(), OFstatic_cast(DcmRLEEncoder *, NULL));
+  }
+
+  /// delete the RLE encoders of the last run
+  void clear()
+  {
+    for (size_t i = 0; i < encoders.size(); ++i)
+    {
+      delete encoders[i];
+      encoders[i] = NULL;
+    }
+  }
+
+  /** compress a single stripe
+   *  @param index index of the stripe relative to the first stripe of the first frame
+   *  @param thread index of the calling thread
+   *  @return OFTrue if successful, OFFalse if out of memory
+   */
+  virtual OFBool execute(const size_t index, const size_t thread)
+  {
+    const Uint32 numberOfStripes = getNumberOfStripes();
+    const Uint32 frame = firstFrame_ + OFstatic_cast(Uint32, index / numberOfStripes);
+    const Uint32 stripe = OFstatic_cast(Uint32, index % numberOfStripes);
+
+    // which sample and byte are we currently compressing?
+    const Uint32 sample = stripe / bytesAllocated_;
+    const Uint32 byte = stripe % bytesAllocated_;
+
+    // compute byte offset for first sample in frame and between samples
+    Uint32 sampleOffset = 0;
+    Uint32 offsetBetweenSamples = 0;
+    if (planarConfiguration_ == 0)
+    {
+      sampleOffset = sample * bytesAllocated_;
+      offsetBetweenSamples = samplesPerPixel_ * bytesAllocated_;
+    }
+    else
+    {
+      sampleOffset = sample * bytesAllocated_ * columns_ * rows_;
+      offsetBetweenSamples = bytesAllocated_;
+    }
+    const Uint8 *pixelPointer = pixelData_ + frameSize_ * frame + sampleOffset + bytesAllocated_ - byte - 1;
+
+    // the bytes of a stripe are collected row by row in a contiguous buffer
+    // unless they are already stored contiguously
+    Uint8 *rowBuffer = NULL;
+    if (offsetBetweenSamples > 1)
+    {
+      if (rowBuffers_[thread] == NULL) rowBuffers_[thread] = new Uint8[columns_];
+      rowBuffer = rowBuffers_[thread];
+    }
+
+    DcmRLEEncoder *rleEncoder = new DcmRLEEncoder(1 /* DICOM padding required */);
+    encoders[index] = rleEncoder;
+    for (Uint32 row = 0; row < rows_; ++row)
+    {
+      if (rowBuffer)
+      {
+        for (Uint32 column = 0; column < columns_; ++column)
+        {
+          rowBuffer[column] = *pixelPointer;
+          pixelPointer += offsetBetweenSamples;
+        }
+        rleEncoder->add(rowBuffer, columns_);
+      }
+      else
+      {
+        rleEncoder->add(pixelPointer, columns_);
+        pixelPointer += columns_;
+      }
+
+      // enforce DICOM rule that "Each row of the image shall be encoded
+      // separately and not cross a row boundary."
+      // (see DICOM part 5 section G.3.1)
+      rleEncoder->flush();
+    }
+    return !rleEncoder->fail();
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DcmRLEStripeEncoderTask(const DcmRLEStripeEncoderTask&);
+
+  /// private undefined copy assignment operator
+  DcmRLEStripeEncoderTask& operator=(const DcmRLEStripeEncoderTask&);
+
+  /// uncompressed pixel data of all frames
+  const Uint8 *pixelData_;
+
+  /// size of an uncompressed frame in bytes
+  Uint32 frameSize_;
+
+  /// number of bytes allocated per sample
+  Uint16 bytesAllocated_;
+
+  /// number of samples per pixel
+  Uint16 samplesPerPixel_;
+
+  /// planar configuration of the pixel data
+  Uint16 planarConfiguration_;
+
+  /// number of columns
+  Uint16 columns_;
+
+  /// number of rows
+  Uint16 rows_;
+
+  /// index of the first frame compressed by the current run
+  Uint32 firstFrame_;
+
+  /// buffer for the bytes of one row of a stripe, for each thread
+  OFVector<Uint8 *> rowBuffers_;
+
+public:
+
+  /// RLE encoders of the current run, indexed by work item
+  OFVector<DcmRLEEncoder *> encoders;
+};
 
 
 // =======================================================================
@@ -123,11 +304,7 @@ OFCondition DcmRLECodecEncoder::encode(
   (void)localStack.pop();             // pop pixel data element from stack
   DcmObject *dataset = localStack.pop(); // this is the item in which the pixel data is located
   Uint8 *pixelData8 = OFreinterpret_cast(Uint8 *, OFconst_cast(Uint16 *, pixelData));
-  Uint8 *pixelPointer = NULL;
   DcmOffsetList offsetList;
-  DcmRLEEncoderList rleEncoderList;
-  DcmRLEEncoderListIterator first = rleEncoderList.begin();
-  DcmRLEEncoderListIterator last = rleEncoderList.end();
   Uint32 rleHeader[16];
   Uint32 i;
   OFBool byteSwapped = OFFalse;  // true if we have byte-swapped the original pixel data
@@ -204,17 +381,7 @@ OFCondition DcmRLECodecEncoder::encode(
     // create RLE stripe sets
     if (result.good())
     {
-      const Uint32 bytesPerStripe = columns * rows;
       const Uint32 frameSize = columns * rows * samplesPerPixel * bytesAllocated;
-      Uint32 frameOffset = 0;
-      Uint32 sampleOffset = 0;
-      Uint32 offsetBetweenSamples = 0;
-      Uint32 sample = 0;
-      Uint32 byte = 0;
-      Uint32 pixel = 0;
-      Uint32 columnCounter = 0;
-
-      DcmRLEEncoder *rleEncoder = NULL;
       Uint32 rleSize = 0;
       Uint8 *rleData = NULL;
       Uint8 *rleData2 = NULL;
@@ -223,74 +390,38 @@ OFCondition DcmRLECodecEncoder::encode(
       if (djcp->getFragmentSize() > 0)
          DCMDATA_WARN("DcmRLECodecEncoder: limiting the fragment size may result in non-standard conformant encoding");
 
-      // compute byte offset between samples
-      if (planarConfiguration == 0)
-         offsetBetweenSamples = samplesPerPixel * bytesAllocated;
-         else offsetBetweenSamples = bytesAllocated;
+      // the stripes of a limited number of frames are compressed in parallel,
+      // then the compressed frames are stored in their original order
+      OFThreadPool pool(djcp->getNumberOfThreads());
+      if ((pool.getNumberOfThreads() > 1) && (numberOfFrames > 1))
+        DCMDATA_DEBUG("DcmRLECodecEncoder: using up to " << pool.getNumberOfThreads() << " threads");
+      const Uint32 framesPerRun = OFstatic_cast(Uint32, pool.getNumberOfThreads() * 4);
+      DcmRLEStripeEncoderTask task(pixelData8, frameSize, bytesAllocated, samplesPerPixel,
+        planarConfiguration, columns, rows, pool.getNumberOfThreads());
 
       // loop through all frames of the image
-      for (Uint32 currentFrame = 0; ((currentFrame < OFstatic_cast(Uint32, numberOfFrames)) && result.good()); currentFrame++)
+      Uint32 currentFrame = 0;
+      while ((currentFrame < OFstatic_cast(Uint32, numberOfFrames)) && result.good())
       {
-        // offset to start of frame, in bytes
-        frameOffset = frameSize * currentFrame;
+        Uint32 framesInRun = OFstatic_cast(Uint32, numberOfFrames) - currentFrame;
+        if (framesInRun > framesPerRun) framesInRun = framesPerRun;
+        task.prepare(currentFrame, framesInRun);
+        if (!pool.run(task, framesInRun * numberOfStripes)) result = EC_MemoryExhausted;
 
-        // loop through all samples of one frame
-        for (sample = 0; sample < samplesPerPixel; sample++)
+        // store frames
+        for (Uint32 frame = 0; (frame < framesInRun) && result.good(); ++frame)
         {
-          // compute byte offset for first sample in frame
-          if (planarConfiguration == 0)
-             sampleOffset = sample * bytesAllocated;
-             else sampleOffset = sample * bytesAllocated * columns * rows;
+          DcmRLEEncoder **encoders = &task.encoders[frame * numberOfStripes];
 
-          // loop through the bytes of one sample
-          for (byte = 0; byte < bytesAllocated; byte++)
-          {
-            pixelPointer = pixelData8 + frameOffset + sampleOffset + bytesAllocated - byte - 1;
-
-            // initialize new RLE codec for this stripe
-            rleEncoder = new DcmRLEEncoder(1 /* DICOM padding required */);
-            if (rleEncoder)
-            {
-              rleEncoderList.push_back(rleEncoder);
-              columnCounter = columns;
-
-              // loop through all pixels of the frame
-              for (pixel = 0; pixel < bytesPerStripe; ++pixel)
-              {
-                rleEncoder->add(*pixelPointer);
-
-                // enforce DICOM rule that "Each row of the image shall be encoded
-                // separately and not cross a row boundary."
-                // (see DICOM part 5 section G.3.1)
-                if (--columnCounter == 0)
-                {
-                  rleEncoder->flush();
-                  columnCounter = columns;
-                }
-                pixelPointer += offsetBetweenSamples;
-              }
-
-              rleEncoder->flush();
-              if (rleEncoder->fail()) result = EC_MemoryExhausted;
-            } else result = EC_MemoryExhausted;
-          }
-        }
-
-        // store frame and erase RLE codec list
-        if (result.good() && (rleEncoderList.size() > 0) && (rleEncoderList.size() < 16))
-        {
           // compute size of compressed frame including RLE header
           // and populate RLE header
           for (i=0; i<16; i++) rleHeader[i] = 0;
-          rleHeader[0] = OFstatic_cast(Uint32, rleEncoderList.size());
+          rleHeader[0] = numberOfStripes;
           rleSize = 64;
-          i = 1;
-          first = rleEncoderList.begin();
-          while (first != last)
+          for (i=0; i<numberOfStripes; i++)
           {
-            rleHeader[i++] = rleSize;
-            rleSize += OFstatic_cast(Uint32, (*first)->size());
-            ++first;
+            rleHeader[i+1] = rleSize;
+            rleSize += OFstatic_cast(Uint32, encoders[i]->size());
           }
 
           // allocate buffer for compressed frame
@@ -304,13 +435,10 @@ OFCondition DcmRLECodecEncoder::encode(
 
             // store RLE stripe sets in compressed frame buffer
             rleData2 = rleData + 64;
-            first = rleEncoderList.begin();
-            while (first != last)
+            for (i=0; i<numberOfStripes; i++)
             {
-              (*first)->write(rleData2);
-              rleData2 += (*first)->size();
-              delete *first;
-              first = rleEncoderList.erase(first);
+              encoders[i]->write(rleData2);
+              rleData2 += encoders[i]->size();
             }
 
             // store compressed frame, breaking into segments if necessary
@@ -321,20 +449,11 @@ OFCondition DcmRLECodecEncoder::encode(
             delete[] rleData;
           } else result = EC_MemoryExhausted;
         }
-        else
-        {
-          // erase RLE codec list
-          first = rleEncoderList.begin();
-          while (first != last)
-          {
-            delete *first;
-            first = rleEncoderList.erase(first);
-          }
-          if (result.good()) result = EC_CannotChangeRepresentation;
-        }
 
+        // erase RLE codecs
+        task.clear();
+        currentFrame += framesInRun;
       }
-
     }
 
     // store pixel sequence if everything went well.
@@ -27,13 +27,15 @@ DcmRLECodecParameter::DcmRLECodecParameter(
     Uint32 pFragmentSize,
     OFBool pCreateOffsetTable,
     OFBool pConvertToSC,
-    OFBool pReverseDecompressionByteOrder)
+    OFBool pReverseDecompressionByteOrder,
+    size_t pNumberOfThreads)
 : DcmCodecParameter()
 , fragmentSize(pFragmentSize)
 , createOffsetTable(pCreateOffsetTable)
 , convertToSC(pConvertToSC)
 , createInstanceUID(pCreateSOPInstanceUID)
 , reverseDecompressionByteOrder(pReverseDecompressionByteOrder)
+, numberOfThreads(pNumberOfThreads)
 {
 }
 
@@ -45,6 +47,7 @@ DcmRLECodecParameter::DcmRLECodecParameter(const DcmRLECodecParameter& arg)
 , convertToSC(arg.convertToSC)
 , createInstanceUID(arg.createInstanceUID)
 , reverseDecompressionByteOrder(arg.reverseDecompressionByteOrder)
+, numberOfThreads(arg.numberOfThreads)
 {
 }
 
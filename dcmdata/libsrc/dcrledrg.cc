@@ -33,14 +33,16 @@ DcmRLECodecDecoder *DcmRLEDecoderRegistration::codec          = NULL;
 
 void DcmRLEDecoderRegistration::registerCodecs(
     OFBool pCreateSOPInstanceUID,
-    OFBool pReverseDecompressionByteOrder)
+    OFBool pReverseDecompressionByteOrder,
+    size_t pNumberOfThreads)
 {
   if (! registered)
   {
     cp = new DcmRLECodecParameter(
       pCreateSOPInstanceUID,
       0, OFTrue, OFFalse,
-      pReverseDecompressionByteOrder);
+      pReverseDecompressionByteOrder,
+      pNumberOfThreads);
       
     if (cp)
     {
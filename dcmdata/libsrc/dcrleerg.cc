@@ -35,7 +35,8 @@ void DcmRLEEncoderRegistration::registerCodecs(
     OFBool pCreateSOPInstanceUID,
     Uint32 pFragmentSize,
     OFBool pCreateOffsetTable,
-    OFBool pConvertToSC)
+    OFBool pConvertToSC,
+    size_t pNumberOfThreads)
 {
   if (! registered)
   {
@@ -43,7 +44,9 @@ void DcmRLEEncoderRegistration::registerCodecs(
       pCreateSOPInstanceUID,
       pFragmentSize,
       pCreateOffsetTable,
-      pConvertToSC);
+      pConvertToSC,
+      OFFalse,
+      pNumberOfThreads);
 
     if (cp)
     {
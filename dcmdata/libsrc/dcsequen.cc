@@ -44,7 +44,11 @@ DcmSequenceOfItems::DcmSequenceOfItems(const DcmTag &tag)
   itemList(new DcmList),
   lastItemComplete(OFTrue),
   fStartPosition(0),
-  readAsUN_(OFFalse)
+  readAsUN_(OFFalse),
+  fLoadItems(NULL),
+  fLoadXfer(EXS_Unknown),
+  fLoadGroupLength(EGL_noChange),
+  fLoadMaxReadLength(0)
 {
 }
 
@@ -60,7 +64,11 @@ DcmSequenceOfItems::DcmSequenceOfItems(
   itemList(new DcmList),
   lastItemComplete(OFTrue),
   fStartPosition(0),
-  readAsUN_(readAsUN)
+  readAsUN_(readAsUN),
+  fLoadItems(NULL),
+  fLoadXfer(EXS_Unknown),
+  fLoadGroupLength(EGL_noChange),
+  fLoadMaxReadLength(0)
 {
 }
 
@@ -73,8 +81,15 @@ DcmSequenceOfItems::DcmSequenceOfItems(const DcmSequenceOfItems &old)
     itemList(new DcmList),
     lastItemComplete(old.lastItemComplete),
     fStartPosition(old.fStartPosition),
-    readAsUN_(old.readAsUN_)
+    readAsUN_(old.readAsUN_),
+    fLoadItems(NULL),
+    fLoadXfer(old.fLoadXfer),
+    fLoadGroupLength(old.fLoadGroupLength),
+    fLoadMaxReadLength(old.fLoadMaxReadLength)
 {
+    /* items that have not been parsed yet are parsed later from the same file */
+    if (old.fLoadItems)
+        fLoadItems = old.fLoadItems->clone();
     if (!old.itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -97,6 +112,7 @@ DcmSequenceOfItems::~DcmSequenceOfItems()
 {
     itemList->deleteAllElements();
     delete itemList;
+    delete fLoadItems;
 }
 
 
@@ -111,6 +127,12 @@ DcmSequenceOfItems &DcmSequenceOfItems::operator=(const DcmSequenceOfItems &obj)
     lastItemComplete = obj.lastItemComplete;
     fStartPosition = obj.fStartPosition;
     readAsUN_ = obj.readAsUN_;
+    /* items that have not been parsed yet are parsed later from the same file */
+    delete fLoadItems;
+    fLoadItems = (obj.fLoadItems) ? obj.fLoadItems->clone() : NULL;
+    fLoadXfer = obj.fLoadXfer;
+    fLoadGroupLength = obj.fLoadGroupLength;
+    fLoadMaxReadLength = obj.fLoadMaxReadLength;
 
     // DcmList has no copy constructor. Need to copy ourselves.
     DcmList *newList = new DcmList;
@@ -254,12 +276,15 @@ unsigned long  DcmSequenceOfItems::getVM()
 
 unsigned long DcmSequenceOfItems::getNumberOfValues()
 {
+    loadItems();
     return itemList->card();
 }
 
 
 unsigned long DcmSequenceOfItems::card() const
 {
+    /* cast away constness (dcmdata is not const correct...) */
+    OFconst_cast(DcmSequenceOfItems *, this)->loadItems();
     return itemList->card();
 }
 
@@ -273,6 +298,7 @@ void DcmSequenceOfItems::print(STD_NAMESPACE ostream &out,
                                const char *pixelFileName,
                                size_t *pixelCounter)
 {
+    loadItems();
     /* print sequence start line */
     if (flags & DCMTypes::PF_showTreeStructure)
     {
@@ -326,7 +352,9 @@ void DcmSequenceOfItems::print(STD_NAMESPACE ostream &out,
 OFCondition DcmSequenceOfItems::writeXML(STD_NAMESPACE ostream &out,
                                          const size_t flags)
 {
-    OFCondition l_error = EC_Normal;
+    OFCondition l_error = loadItems();
+    if (l_error.bad())
+        return l_error;
     if (flags & DCMTypes::XF_useNativeModel)
     {
         /* use common method from DcmElement to write start tag */
@@ -403,9 +431,11 @@ OFCondition DcmSequenceOfItems::writeXML(STD_NAMESPACE ostream &out,
 OFCondition DcmSequenceOfItems::writeJson(STD_NAMESPACE ostream& out,
                                           DcmJsonFormat &format)
 {
+    OFCondition status = loadItems();
+    if (status.bad())
+        return status;
     // use common method from DcmElement to write opener
     DcmElement::writeJsonOpener(out, format);
-    OFCondition status = EC_Normal;
     // write sequence content
     if (!itemList->empty())
     {
@@ -434,6 +464,8 @@ OFBool DcmSequenceOfItems::canWriteXfer(const E_TransferSyntax newXfer,
 
     if (newXfer == EXS_Unknown)
         canWrite = OFFalse;
+    else if (loadItems().bad())
+        canWrite = OFFalse;
     else if (!itemList->empty())
     {
         DcmObject *dO;
@@ -478,6 +510,7 @@ Uint32 DcmSequenceOfItems::getLength(const E_TransferSyntax xfer,
 {
     Uint32 seqlen = 0;
     Uint32 sublen = 0;
+    loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -521,9 +554,9 @@ OFCondition DcmSequenceOfItems::computeGroupLengthAndPadding(const E_GrpLenEncod
                                                              const Uint32 subPadlen,
                                                              Uint32 instanceLength)
 {
-    OFCondition l_error = EC_Normal;
+    OFCondition l_error = loadItems();
 
-    if (!itemList->empty())
+    if (l_error.good() && !itemList->empty())
     {
         itemList->seek(ELP_first);
         do {
@@ -710,14 +743,32 @@ OFCondition DcmSequenceOfItems::read(DcmInputStream &inStream,
             errorFlag = EC_EndOfStream;
         else if (errorFlag.good() && (getTransferState() != ERW_ready))
         {
+            E_TransferSyntax readxfer = readAsUN_ ? EXS_LittleEndianImplicit : xfer;
+
             if (getTransferState() == ERW_init)
             {
                 fStartPosition = inStream.tell();   // Position Sequence-Value
                 setTransferState(ERW_inWork);
+                /* in lazy mode, the items of a sequence with explicit length are not parsed now */
+                /* but only on first access, provided that the stream permits random access */
+                if (dcmEnableLazySequenceParsing.get() && (ident() == EVR_SQ) && itemList->empty() &&
+                    (getLengthField() > 0) && (getLengthField() != DCM_UndefinedLength) &&
+                    (inStream.avail() >= OFstatic_cast(offile_off_t, getLengthField())))
+                {
+                    delete fLoadItems;
+                    fLoadItems = inStream.newFactory();
+                    if (fLoadItems)
+                    {
+                        fLoadXfer = readxfer;
+                        fLoadGroupLength = glenc;
+                        fLoadMaxReadLength = maxReadLength;
+                        setTransferredBytes(OFstatic_cast(Uint32, inStream.skip(getLengthField())));
+                        DCMDATA_TRACE("DcmSequenceOfItems::read() Parsing of items in sequence " << getTag()
+                            << " with " << getLengthField() << " bytes deferred until first access");
+                    }
+                }
             }
 
-            E_TransferSyntax readxfer = readAsUN_ ? EXS_LittleEndianImplicit : xfer;
-
             itemList->seek(ELP_last); // append data at end
             while (inStream.good() && ((getTransferredBytes() < getLengthField()) || !lastItemComplete))
             {
@@ -789,6 +840,8 @@ OFCondition DcmSequenceOfItems::write(DcmOutputStream &outStream,
 {
   if (getTransferState() == ERW_notInitialized)
         errorFlag = EC_IllegalCall;
+    else if (loadItems().bad())
+        errorFlag = EC_InvalidStream;
     else
     {
         errorFlag = outStream.status();
@@ -913,6 +966,8 @@ OFCondition DcmSequenceOfItems::writeSignatureFormat(DcmOutputStream &outStream,
 {
     if (getTransferState() == ERW_notInitialized)
         errorFlag = EC_IllegalCall;
+    else if (loadItems().bad())
+        errorFlag = EC_InvalidStream;
     else
     {
         errorFlag = outStream.status();
@@ -1017,6 +1072,7 @@ void DcmSequenceOfItems::transferEnd()
 
 OFCondition DcmSequenceOfItems::prepend(DcmItem *item)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -1037,6 +1093,7 @@ OFCondition DcmSequenceOfItems::insert(DcmItem *item,
                                        unsigned long where,
                                        OFBool before)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -1082,6 +1139,7 @@ OFCondition DcmSequenceOfItems::insert(DcmItem *item,
 OFCondition DcmSequenceOfItems::insertAtCurrentPos(DcmItem *item,
                                                    OFBool before)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -1107,6 +1165,7 @@ OFCondition DcmSequenceOfItems::insertAtCurrentPos(DcmItem *item,
 
 OFCondition DcmSequenceOfItems::append(DcmItem *item)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (item != NULL)
     {
@@ -1130,6 +1189,7 @@ OFCondition DcmSequenceOfItems::append(DcmItem *item)
 
 DcmItem* DcmSequenceOfItems::getItem(const unsigned long num)
 {
+    loadItems();
     errorFlag = EC_Normal;
     DcmItem *item;
     item = OFstatic_cast(DcmItem *, itemList->seek_to(num));  // read item from list
@@ -1144,6 +1204,7 @@ DcmItem* DcmSequenceOfItems::getItem(const unsigned long num)
 
 DcmObject *DcmSequenceOfItems::nextInContainer(const DcmObject *obj)
 {
+    loadItems();
     if (!obj)
         return itemList->get(ELP_first);
     else
@@ -1207,6 +1268,7 @@ OFCondition DcmSequenceOfItems::nextObject(DcmStack &stack,
 
 DcmItem *DcmSequenceOfItems::remove(const unsigned long num)
 {
+    loadItems();
     errorFlag = EC_Normal;
     DcmItem *item;
     item = OFstatic_cast(DcmItem *, itemList->seek_to(num));  // read item from list
@@ -1225,6 +1287,7 @@ DcmItem *DcmSequenceOfItems::remove(const unsigned long num)
 
 DcmItem *DcmSequenceOfItems::remove(DcmItem *item)
 {
+    loadItems();
     DcmItem *retItem = NULL;
     errorFlag = EC_IllegalCall;
     if (!itemList->empty() && (item != NULL))
@@ -1256,6 +1319,9 @@ DcmItem *DcmSequenceOfItems::remove(DcmItem *item)
 OFCondition DcmSequenceOfItems::clear()
 {
     errorFlag = EC_Normal;
+    // items that have not been parsed yet are not needed any longer
+    delete fLoadItems;
+    fLoadItems = NULL;
     // remove all items from sequence and delete them from memory
     itemList->deleteAllElements();
     setLengthField(0);
@@ -1265,6 +1331,7 @@ OFCondition DcmSequenceOfItems::clear()
 
 OFBool DcmSequenceOfItems::isEmpty(const OFBool /*normalize*/)
 {
+    loadItems();
     return itemList->empty();
 }
 
@@ -1274,6 +1341,7 @@ OFBool DcmSequenceOfItems::isEmpty(const OFBool /*normalize*/)
 
 OFCondition DcmSequenceOfItems::verify(const OFBool autocorrect)
 {
+    loadItems();
     errorFlag = EC_Normal;
     if (!itemList->empty())
     {
@@ -1304,6 +1372,7 @@ OFCondition DcmSequenceOfItems::searchSubFromHere(const DcmTagKey &tag,
                                                   DcmStack &resultStack,
                                                   const OFBool searchIntoSub)
 {
+    loadItems();
     DcmObject *dO;
     OFCondition l_error = EC_TagNotFound;
     if (!itemList->empty())
@@ -1341,6 +1410,7 @@ OFCondition DcmSequenceOfItems::search(const DcmTagKey &tag,
                                        E_SearchMode mode,
                                        OFBool searchIntoSub)
 {
+    loadItems();
     DcmObject *dO = NULL;
     OFCondition l_error = EC_TagNotFound;
     if ((mode == ESM_afterStackTop) && (resultStack.top() == this))
@@ -1433,8 +1503,8 @@ OFCondition DcmSequenceOfItems::search(const DcmTagKey &tag,
 
 OFCondition DcmSequenceOfItems::loadAllDataIntoMemory()
 {
-    OFCondition l_error = EC_Normal;
-    if (!itemList->empty())
+    OFCondition l_error = loadItems();
+    if (l_error.good() && !itemList->empty())
     {
         itemList->seek(ELP_first);
         do {
@@ -1461,6 +1531,8 @@ OFBool DcmSequenceOfItems::isSignable() const
 
 OFBool DcmSequenceOfItems::containsUnknownVR() const
 {
+    /* cast away constness (dcmdata is not const correct...) */
+    OFconst_cast(DcmSequenceOfItems *, this)->loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1475,6 +1547,7 @@ OFBool DcmSequenceOfItems::containsUnknownVR() const
 
 OFBool DcmSequenceOfItems::containsExtendedCharacters(const OFBool checkAllStrings)
 {
+    loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1489,6 +1562,8 @@ OFBool DcmSequenceOfItems::containsExtendedCharacters(const OFBool checkAllStrin
 
 OFBool DcmSequenceOfItems::isAffectedBySpecificCharacterSet() const
 {
+    /* cast away constness (dcmdata is not const correct...) */
+    OFconst_cast(DcmSequenceOfItems *, this)->loadItems();
     if (!itemList->empty())
     {
         itemList->seek(ELP_first);
@@ -1503,6 +1578,7 @@ OFBool DcmSequenceOfItems::isAffectedBySpecificCharacterSet() const
 
 OFCondition DcmSequenceOfItems::convertCharacterSet(DcmSpecificCharacterSet &converter)
 {
+    loadItems();
     OFCondition status = EC_Normal;
     if (!itemList->empty())
     {
@@ -1516,6 +1592,58 @@ OFCondition DcmSequenceOfItems::convertCharacterSet(DcmSpecificCharacterSet &con
 }
 
 
+OFCondition DcmSequenceOfItems::loadItems()
+{
+    OFCondition l_error = EC_Normal;
+    if (fLoadItems != NULL)
+    {
+        /* reset the member variable first, so this method is never called recursively */
+        DcmInputStreamFactory *factory = fLoadItems;
+        fLoadItems = NULL;
+        DcmInputStream *readStream = factory->create();
+        if (readStream != NULL)
+        {
+            l_error = readStream->status();
+            if (l_error.good())
+            {
+                DCMDATA_TRACE("DcmSequenceOfItems::loadItems() Parsing deferred items of sequence "
+                    << getTag() << " with " << getLengthField() << " bytes");
+                /* read the items (this also works if the sequence is currently being written) */
+                const E_TransferState oldState = getTransferState();
+                setTransferState(ERW_inWork);
+                setTransferredBytes(0);
+                fStartPosition = readStream->tell();
+                lastItemComplete = OFTrue;
+                l_error = read(*readStream, fLoadXfer, fLoadGroupLength, fLoadMaxReadLength);
+                /* the complete sequence should be available, so this is an error */
+                if (l_error == EC_StreamNotifyClient)
+                    l_error = EC_InvalidStream;
+                /* bring the sequence and the new items into the previous transfer state */
+                transferEnd();
+                if (oldState != ERW_notInitialized)
+                {
+                    transferInit();
+                    setTransferState(oldState);
+                }
+            }
+            delete readStream;
+        } else
+            l_error = EC_InvalidStream;
+        delete factory;
+        if (l_error.bad())
+        {
+            DCMDATA_ERROR("DcmSequenceOfItems: Cannot parse deferred items of sequence "
+                << getTagName() << " " << getTag() << ": " << l_error.text());
+            errorFlag = l_error;
+        }
+    }
+    return l_error;
+}
+
+
+// ********************************
+
+
 OFCondition DcmSequenceOfItems::getPartialValue(void * /* targetBuffer */,
                                                 const Uint32 /* offset */,
                                                 Uint32 /* numBytes */,
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2007-2010, OFFIS e.V.
+ *  Copyright (C) 2007-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -77,12 +77,15 @@ OFCondition DcmWriteCache::fillBuffer(DcmElement& elem)
   return result;
 }
 
-Uint32 DcmWriteCache::writeBuffer(DcmOutputStream &outStream)
+Uint32 DcmWriteCache::writeBuffer(DcmOutputStream &outStream, OFBool stable)
 {
   Uint32 result = 0;
   if (buf_ && numBytes_)
   {
-    result = OFstatic_cast(Uint32, outStream.write(buf_ + offset_, numBytes_));
+    if (stable)
+      result = OFstatic_cast(Uint32, outStream.writeStable(buf_ + offset_, numBytes_));
+    else
+      result = OFstatic_cast(Uint32, outStream.write(buf_ + offset_, numBytes_));
 
     numBytes_ -= result;
     offset_ += result;
@@ -0,0 +1,284 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Benchmark for the optional data structures of the dcmdata
+ *           object tree, i.e. the element index of DcmItem
+ *
+ *  The benchmark is not part of the unit tests since its results depend on
+ *  the machine it is run on. Each scenario is run with the optional feature
+ *  disabled (the default) and enabled, e.g.
+ *
+ *    dcmdata_bench --elements 100,1000,5000
+ *
+ *  If DICOM files are given, they are loaded and the elements on the main
+ *  level of each dataset are looked up instead, e.g.
+ *
+ *    dcmdata_bench ct.dcm rtstruct.dcm sr.dcm
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/ofconapp.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/oftimer.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/dcmdata/dcitem.h"
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcvrus.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmdata/cmdlnarg.h"
+
+
+#define OFFIS_CONSOLE_APPLICATION "dcmdata_bench"
+
+static OFLogger benchLogger = OFLog::getLogger("dcmtk.tests." OFFIS_CONSOLE_APPLICATION);
+
+static char rcsid[] = "$dcmtk: " OFFIS_CONSOLE_APPLICATION " v"
+  OFFIS_DCMTK_VERSION " " OFFIS_DCMTK_RELEASEDATE " $";
+
+#define SHORTCOL 4
+#define LONGCOL 20
+
+
+// parse a comma separated list of positive numbers
+static OFBool parseNumberList(const char *list, OFVector<size_t>& numbers)
+{
+    numbers.clear();
+    const char *p = list;
+    while (*p != '\0')
+    {
+        char *end = NULL;
+        const unsigned long value = strtoul(p, &end, 10);
+        if ((end == p) || (value == 0))
+            return OFFalse;
+        numbers.push_back(OFstatic_cast(size_t, value));
+        p = end;
+        if (*p == ',')
+            ++p;
+        else if (*p != '\0')
+            return OFFalse;
+    }
+    return !numbers.empty();
+}
+
+
+/* Insert the given number of private US elements into an item, read each of
+ * them five times and delete every second element again. The elements are
+ * inserted in descending order, i.e. always at the beginning of the list.
+ * Returns the elapsed time in seconds.
+ */
+static double benchmarkElementIndex(const size_t count, const OFBool useIndex)
+{
+    OFTimer timer;
+    dcmEnableElementIndex.set(useIndex);
+    DcmItem item;
+    dcmEnableElementIndex.set(OFFalse);
+    Uint16 value = 0;
+    for (size_t i = count; i > 0; --i)
+    {
+        DcmUnsignedShort *elem = new DcmUnsignedShort(DcmTag(OFstatic_cast(Uint16, 0x0009 + 2 * (i >> 16)), OFstatic_cast(Uint16, i & 0xffff), EVR_US));
+        elem->putUint16(OFstatic_cast(Uint16, i));
+        item.insert(elem);
+    }
+    for (int pass = 0; pass < 5; ++pass)
+    {
+        for (size_t i = 1; i <= count; ++i)
+            item.findAndGetUint16(DcmTagKey(OFstatic_cast(Uint16, 0x0009 + 2 * (i >> 16)), OFstatic_cast(Uint16, i & 0xffff)), value);
+    }
+    for (size_t i = 1; i <= count; i += 2)
+        item.findAndDeleteElement(DcmTagKey(OFstatic_cast(Uint16, 0x0009 + 2 * (i >> 16)), OFstatic_cast(Uint16, i & 0xffff)));
+    return timer.getDiff();
+}
+
+
+/* Load the given file into a newly created file format (to be deleted by the
+ * caller) and return the elapsed time in seconds, or a negative value if the
+ * file cannot be loaded.
+ */
+static double benchmarkLoadFile(const char *filename, const OFBool useIndex, DcmFileFormat *&fileformat)
+{
+    OFTimer timer;
+    /* the setting applies to all items created, including the dataset itself */
+    dcmEnableElementIndex.set(useIndex);
+    fileformat = new DcmFileFormat();
+    const OFCondition status = fileformat->loadFile(filename);
+    dcmEnableElementIndex.set(OFFalse);
+    const double seconds = timer.getDiff();
+    if (status.bad())
+    {
+        OFLOG_ERROR(benchLogger, "cannot load file: " << filename << ": " << status.text());
+        delete fileformat;
+        fileformat = NULL;
+        return -1.0;
+    }
+    return seconds;
+}
+
+
+/* Look up each of the given elements five times on the main level of the
+ * dataset. Returns the elapsed time in seconds.
+ */
+static double benchmarkLookup(DcmDataset &dataset, const OFVector<DcmTagKey> &tags)
+{
+    OFTimer timer;
+    DcmElement *elem = NULL;
+    for (int pass = 0; pass < 5; ++pass)
+    {
+        for (size_t i = 0; i < tags.size(); ++i)
+            dataset.findAndGetElement(tags[i], elem, OFFalse /*searchIntoSub*/);
+    }
+    return timer.getDiff();
+}
+
+
+int main(int argc, char *argv[])
+{
+    OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION, "Measure dcmdata object tree operations", rcsid);
+    const char *opt_elements = "100,1000,5000,20000";
+    OFBool opt_synthetic = OFTrue;
+    OFCmdUnsignedInt opt_repeat = 3;
+    OFList<const char *> fileNames;
+
+    OFCommandLine cmd;
+    cmd.setOptionColumns(LONGCOL, SHORTCOL);
+    cmd.addParam("dcmfile-in", "DICOM input file(s) to be loaded instead of\nthe synthetic datasets", OFCmdParam::PM_MultiOptional);
+    cmd.addGroup("general options:", LONGCOL, SHORTCOL + 2);
+      cmd.addOption("--help",      "-h",     "print this help text and exit", OFCommandLine::AF_Exclusive);
+      cmd.addOption("--version",             "print version information and exit", OFCommandLine::AF_Exclusive);
+      OFLog::addOptions(cmd);
+    cmd.addGroup("benchmark options:");
+      cmd.addOption("--elements",  "-ne", 1, "[l]ist: string (default: 100,1000,5000,20000)", "comma separated numbers of elements per item\nfor the element index scenario (also run if\ninput files are given)");
+      cmd.addOption("--repeat",    "-nr", 1, "[n]umber: integer (default: 3)", "run each measurement n times, report the best");
+      cmd.addOption("--quick",     "-qr",    "run a short benchmark (e.g. as smoke test)");
+
+    prepareCmdLineArgs(argc, argv, OFFIS_CONSOLE_APPLICATION);
+    if (app.parseCommandLine(cmd, argc, argv))
+    {
+        if (cmd.hasExclusiveOption())
+        {
+            if (cmd.findOption("--version"))
+            {
+                app.printHeader(OFTrue /*print host identifier*/);
+                return EXITCODE_NO_ERROR;
+            }
+        }
+
+        OFLog::configureFromCommandLine(cmd, app);
+
+        if (cmd.findOption("--quick"))
+        {
+            opt_elements = "100,1000";
+            opt_repeat = 1;
+        }
+        const int paramCount = cmd.getParamCount();
+        for (int i = 1; i <= paramCount; ++i)
+        {
+            const char *fileName = NULL;
+            cmd.getParam(i, fileName);
+            fileNames.push_back(fileName);
+        }
+        opt_synthetic = fileNames.empty();
+        if (cmd.findOption("--elements"))
+        {
+            app.checkValue(cmd.getValue(opt_elements));
+            opt_synthetic = OFTrue;
+        }
+        if (cmd.findOption("--repeat")) app.checkValue(cmd.getValueAndCheckMin(opt_repeat, 1));
+    }
+
+    OFLOG_DEBUG(benchLogger, rcsid << OFendl);
+
+    OFVector<size_t> elements;
+    if (!parseNumberList(opt_elements, elements))
+    {
+        OFLOG_FATAL(benchLogger, "invalid list of element numbers: " << opt_elements);
+        return EXITCODE_COMMANDLINE_SYNTAX_ERROR;
+    }
+
+    /* element index: list search compared to index search */
+    if (opt_synthetic)
+    {
+        COUT << "element index (seconds, best of " << opt_repeat << ")" << OFendl
+             << "  elements        list       index" << OFendl;
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            double best[2] = { 0.0, 0.0 };
+            for (int mode = 0; mode < 2; ++mode)
+            {
+                for (OFCmdUnsignedInt r = 0; r < opt_repeat; ++r)
+                {
+                    const double seconds = benchmarkElementIndex(elements[i], mode == 1);
+                    if ((r == 0) || (seconds < best[mode]))
+                        best[mode] = seconds;
+                }
+            }
+            char line[80];
+            OFStandard::snprintf(line, sizeof(line), "  %8lu  %10.4f  %10.4f", OFstatic_cast(unsigned long, elements[i]), best[0], best[1]);
+            COUT << line << OFendl;
+        }
+    }
+
+    /* element index: loading and searching the given files */
+    int result = EXITCODE_NO_ERROR;
+    if (!fileNames.empty())
+    {
+        COUT << "element index for files (seconds, best of " << opt_repeat << ")" << OFendl
+             << "  elements   load list  load index  find list  find index  file" << OFendl;
+    }
+    for (OFListIterator(const char *) it = fileNames.begin(); it != fileNames.end(); ++it)
+    {
+        OFVector<DcmTagKey> tags;
+        double load[2] = { 0.0, 0.0 };
+        double find[2] = { 0.0, 0.0 };
+        for (int mode = 0; (mode < 2) && (result == EXITCODE_NO_ERROR); ++mode)
+        {
+            for (OFCmdUnsignedInt r = 0; r < opt_repeat; ++r)
+            {
+                DcmFileFormat *fileformat = NULL;
+                const double seconds = benchmarkLoadFile(*it, mode == 1, fileformat);
+                if (seconds < 0.0)
+                {
+                    result = EXITCODE_CANNOT_READ_INPUT_FILE;
+                    break;
+                }
+                if ((r == 0) || (seconds < load[mode]))
+                    load[mode] = seconds;
+                DcmDataset *dataset = fileformat->getDataset();
+                /* look up all elements on the main level of the dataset */
+                if (tags.empty())
+                {
+                    for (unsigned long i = 0; i < dataset->card(); ++i)
+                        tags.push_back(dataset->getElement(i)->getTag());
+                }
+                const double lookup = benchmarkLookup(*dataset, tags);
+                if ((r == 0) || (lookup < find[mode]))
+                    find[mode] = lookup;
+                delete fileformat;
+            }
+        }
+        if (result != EXITCODE_NO_ERROR)
+            break;
+        char line[80];
+        OFStandard::snprintf(line, sizeof(line), "  %8lu  %10.4f  %10.4f  %9.4f  %10.4f  ", OFstatic_cast(unsigned long, tags.size()), load[0], load[1], find[0], find[1]);
+        COUT << line << *it << OFendl;
+    }
+
+    return result;
+}
@@ -24,6 +24,8 @@
 #include "dcmtk/ofstd/oftest.h"
 
 OFTEST_REGISTER(dcmdata_partialElementAccess);
+OFTEST_REGISTER(dcmdata_memoryMappedFile);
+OFTEST_REGISTER(dcmdata_rereadPopulatedElement);
 OFTEST_REGISTER(dcmdata_i2d_bmp);
 OFTEST_REGISTER(dcmdata_checkStringValue);
 OFTEST_REGISTER(dcmdata_determineVM);
@@ -94,7 +96,9 @@ OFTEST_REGISTER(dcmdata_elementParent);
 OFTEST_REGISTER(dcmdata_sequenceInsert);
 OFTEST_REGISTER(dcmdata_pixelSequenceInsert);
 OFTEST_REGISTER(dcmdata_findAndGetSequenceItem);
+OFTEST_REGISTER(dcmdata_lazySequenceParsing);
 OFTEST_REGISTER(dcmdata_findAndGetUint16Array);
+OFTEST_REGISTER(dcmdata_elementIndex);
 OFTEST_REGISTER(dcmdata_parser_missingDelimitationItems);
 OFTEST_REGISTER(dcmdata_parser_missingSequenceDelimitationItem_1);
 OFTEST_REGISTER(dcmdata_parser_missingSequenceDelimitationItem_2);
@@ -118,4 +122,8 @@ OFTEST_REGISTER(dcmdata_attribute_filter);
 OFTEST_REGISTER(dcmdata_attribute_matching);
 OFTEST_REGISTER(dcmdata_newDicomElementPrivate);
 OFTEST_REGISTER(dcmdata_generateUniqueIdentifier);
+OFTEST_REGISTER(dcmdata_RLEEncoderBlock);
+OFTEST_REGISTER(dcmdata_RLECodecThreads);
+OFTEST_REGISTER(dcmdata_bufferStream_zeroCopy);
+OFTEST_REGISTER(dcmdata_bufferStream_zeroCopyFromFile);
 OFTEST_MAIN("dcmdata")
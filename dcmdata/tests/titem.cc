@@ -27,6 +27,18 @@
 #include "dcmtk/dcmdata/dcvrat.h"
 #include "dcmtk/dcmdata/dcvrus.h"
 #include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dclist.h"
+
+
+// helper class providing access to the element list of an item
+class IndexedItem : public DcmItem
+{
+  public:
+    IndexedItem() : DcmItem() {}
+    IndexedItem(const DcmItem &old) : DcmItem(old) {}
+    IndexedItem &operator=(const DcmItem &obj) { DcmItem::operator=(obj); return *this; }
+    OFBool indexEnabled() const { return elementList->indexEnabled(); }
+};
 
 
 OFTEST(dcmdata_findAndGetUint16Array)
@@ -48,3 +60,61 @@ OFTEST(dcmdata_findAndGetUint16Array)
     OFCHECK(item.findAndGetUint16Array(DCM_FrameIncrementPointer, uintVals, &numUints).good());
     OFCHECK_EQUAL(numUints, 2);
 }
+
+
+OFTEST(dcmdata_elementIndex)
+{
+    dcmEnableElementIndex.set(OFTrue);
+    DcmItem item;
+    dcmEnableElementIndex.set(OFFalse);
+    /* insert elements in descending order, so the list has to be re-sorted */
+    for (Uint16 elem = 0x0100; elem > 0x0000; --elem)
+        OFCHECK(item.insert(new DcmUnsignedShort(DcmTag(0x0009, elem, EVR_US))).good());
+    OFCHECK_EQUAL(item.card(), 256);
+    /* check the order of the elements */
+    for (unsigned long i = 0; i < item.card(); ++i)
+        OFCHECK_EQUAL(item.getElement(i)->getTag(), DcmTagKey(0x0009, OFstatic_cast(Uint16, i + 1)));
+    /* check that all elements can be found on the main level */
+    DcmElement *element = NULL;
+    OFCHECK(item.findAndGetElement(DcmTagKey(0x0009, 0x0001), element).good());
+    OFCHECK(item.findAndGetElement(DcmTagKey(0x0009, 0x0080), element).good());
+    OFCHECK(item.findAndGetElement(DcmTagKey(0x0009, 0x0100), element).good());
+    OFCHECK(item.findAndGetElement(DcmTagKey(0x0009, 0x0101), element).bad());
+    OFCHECK(item.findAndGetElement(DcmTagKey(0x0008, 0x0080), element).bad());
+    /* replace an existing element */
+    DcmUnsignedShort *usValue = new DcmUnsignedShort(DcmTag(0x0009, 0x0080, EVR_US));
+    OFCHECK(item.insert(usValue, OFFalse /*replaceOld*/).bad());
+    OFCHECK(item.insert(usValue, OFTrue /*replaceOld*/).good());
+    OFCHECK_EQUAL(item.card(), 256);
+    OFCHECK(item.findAndGetElement(DcmTagKey(0x0009, 0x0080), element).good());
+    OFCHECK(element == usValue);
+    OFCHECK(item.getElement(0x7f) == usValue);
+    /* remove elements and check that they cannot be found anymore */
+    delete item.remove(DcmTagKey(0x0009, 0x0080));
+    OFCHECK(!item.tagExists(DcmTagKey(0x0009, 0x0080)));
+    OFCHECK(item.findAndDeleteElement(DcmTagKey(0x0009, 0x0001)).good());
+    OFCHECK(!item.tagExists(DcmTagKey(0x0009, 0x0001)));
+    OFCHECK(item.tagExists(DcmTagKey(0x0009, 0x0002)));
+    OFCHECK_EQUAL(item.card(), 254);
+    /* copy of the item should also have the same content */
+    DcmItem copy(item);
+    OFCHECK_EQUAL(copy.card(), 254);
+    OFCHECK(copy.tagExists(DcmTagKey(0x0009, 0x0081)));
+    OFCHECK(copy.compare(item) == 0);
+    /* the copy uses the index (like the original), independent of the global flag */
+    IndexedItem indexedCopy(item);
+    OFCHECK(indexedCopy.indexEnabled());
+    OFCHECK(indexedCopy.tagExists(DcmTagKey(0x0009, 0x0081)));
+    IndexedItem plainItem;
+    OFCHECK(!plainItem.indexEnabled());
+    IndexedItem plainCopy(plainItem);
+    OFCHECK(!plainCopy.indexEnabled());
+    plainCopy = item;
+    OFCHECK(plainCopy.indexEnabled());
+    OFCHECK_EQUAL(plainCopy.card(), 254);
+    indexedCopy = plainItem;
+    OFCHECK(!indexedCopy.indexEnabled());
+    /* finally, remove all elements */
+    OFCHECK(item.clear().good());
+    OFCHECK(!item.tagExists(DcmTagKey(0x0009, 0x0002)));
+}
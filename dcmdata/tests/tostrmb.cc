@@ -0,0 +1,145 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for zero copy in class DcmOutputBufferStream
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmdata/dcostrmb.h"
+#include "dcmtk/dcmdata/dcwcache.h"
+
+
+/// size of the buffer of the output stream
+#define BUFFER_SIZE 1024
+
+/// number of bytes in the large element values
+#define VALUE_SIZE 10000
+
+
+static void createTestDataset(DcmDataset& dset, Uint8 *buffer)
+{
+    for (size_t i = 0; i < VALUE_SIZE; ++i)
+        buffer[i] = OFstatic_cast(Uint8, i * 13);
+    OFCHECK(dset.putAndInsertString(DCM_PatientName, "Zero^Copy").good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4").good());
+    // small value that is always copied
+    OFCHECK(dset.putAndInsertUint16Array(DCM_RedPaletteColorLookupTableData, OFreinterpret_cast(Uint16 *, buffer), 32).good());
+    // large values with VR=OB and VR=OW
+    OFCHECK(dset.putAndInsertUint8Array(DCM_EncapsulatedDocument, buffer, VALUE_SIZE).good());
+    OFCHECK(dset.putAndInsertUint16Array(DCM_PixelData, OFreinterpret_cast(Uint16 *, buffer), VALUE_SIZE / 2).good());
+    OFCHECK(dset.putAndInsertString(DCM_StudyDescription, "after the large values").good());
+}
+
+
+// compare the content of two byte vectors
+static OFBool sameContent(const OFVector<Uint8>& a, const OFVector<Uint8>& b)
+{
+    return (a.size() == b.size()) && (a.empty() || (memcmp(&a[0], &b[0], a.size()) == 0));
+}
+
+
+// write the dataset to a buffer stream, collect the output and count the referenced blocks
+static void writeDataset(DcmDataset& dset, const offile_off_t threshold,
+                         OFVector<Uint8>& output, size_t& references)
+{
+    Uint8 buf[BUFFER_SIZE];
+    DcmOutputBufferStream stream(buf, BUFFER_SIZE);
+    stream.setZeroCopyThreshold(threshold);
+    DcmWriteCache wcache;
+    void *buffer = NULL;
+    offile_off_t length = 0;
+    const void *block = NULL;
+    offile_off_t blockLength = 0;
+    OFCondition cond = EC_StreamNotifyClient;
+
+    output.clear();
+    references = 0;
+    dset.transferInit();
+    while (cond == EC_StreamNotifyClient)
+    {
+        cond = dset.write(stream, EXS_LittleEndianExplicit, EET_ExplicitLength, &wcache);
+        stream.flushBuffer(buffer, length, block, blockLength);
+        // the stream never returns more data than fits into its buffer
+        OFCHECK(length + blockLength <= BUFFER_SIZE);
+        output.insert(output.end(), OFstatic_cast(Uint8 *, buffer), OFstatic_cast(Uint8 *, buffer) + length);
+        if (block != NULL)
+        {
+            OFCHECK(blockLength >= threshold);
+            output.insert(output.end(), OFstatic_cast(const Uint8 *, block), OFstatic_cast(const Uint8 *, block) + blockLength);
+            ++references;
+        }
+    }
+    dset.transferEnd();
+    OFCHECK(cond.good());
+    OFCHECK(stream.isFlushed());
+}
+
+
+OFTEST(dcmdata_bufferStream_zeroCopy)
+{
+    Uint8 *values = new Uint8[VALUE_SIZE];
+    DcmDataset dset;
+    createTestDataset(dset, values);
+
+    OFVector<Uint8> expected;
+    OFVector<Uint8> output;
+    size_t references = 0;
+    writeDataset(dset, 0, expected, references);
+    OFCHECK_EQUAL(references, 0);
+
+    // the large values are referenced, but the output is the same
+    writeDataset(dset, 256, output, references);
+    OFCHECK(references >= 2 * (VALUE_SIZE / BUFFER_SIZE));
+    OFCHECK(sameContent(output, expected));
+
+    // a threshold larger than the buffer disables zero copy
+    writeDataset(dset, BUFFER_SIZE + 2, output, references);
+    OFCHECK_EQUAL(references, 0);
+    OFCHECK(sameContent(output, expected));
+    delete[] values;
+}
+
+
+OFTEST(dcmdata_bufferStream_zeroCopyFromFile)
+{
+    Uint8 *values = new Uint8[VALUE_SIZE];
+    DcmFileFormat dfile;
+    createTestDataset(*dfile.getDataset(), values);
+    OFVector<Uint8> expected;
+    size_t references = 0;
+    writeDataset(*dfile.getDataset(), 0, expected, references);
+    OFCHECK(dfile.saveFile("test_zc.dcm", EXS_LittleEndianExplicit).good());
+    delete[] values;
+
+    {
+        // large values remain in file and are read through the write cache,
+        // the buffer of which must not be re-filled while it is referenced
+        DcmFileFormat dfile2;
+        OFCHECK(dfile2.loadFile("test_zc.dcm", EXS_Unknown, EGL_noChange, 256).good());
+        OFVector<Uint8> output;
+        writeDataset(*dfile2.getDataset(), 256, output, references);
+        OFCHECK(references >= 2 * (VALUE_SIZE / BUFFER_SIZE));
+        OFCHECK(sameContent(output, expected));
+    }
+    OFStandard::deleteFile("test_zc.dcm");
+}
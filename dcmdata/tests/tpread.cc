@@ -15,7 +15,8 @@
  *
  *  Author:  Marco Eichelberg
  *
- *  Purpose: Test application for partial element access API
+ *  Purpose: Test application for partial element access API and
+ *           memory-mapped file access
  *
  */
 
@@ -28,6 +29,7 @@
 #include "dcmtk/dcmdata/dcostrmz.h"    /* for dcmZlibCompressionLevel */
 #include "dcmtk/dcmdata/dcistrmz.h"    /* for dcmZlibExpectRFC1950Encoding */
 #include "dcmtk/dcmdata/dcfcache.h"
+#include "dcmtk/dcmdata/dcistrmf.h"    /* for DcmInputFileStream */
 
 #ifdef WITH_ZLIB
 #include <zlib.h>        /* for zlibVersion() */
@@ -406,3 +408,136 @@ OFTEST(dcmdata_partialElementAccess)
 #endif
     delete[] buffer;
 }
+
+OFTEST(dcmdata_memoryMappedFile)
+{
+    /* make sure data dictionary is loaded */
+    if (!dcmDataDict.isDictionaryLoaded())
+    {
+      OFCHECK_FAIL("no data dictionary loaded, check environment variable: " DCM_DICT_ENVIRONMENT_VARIABLE);
+      return;
+    }
+
+    OFRandom rnd;
+    DcmFileFormat dfile;
+
+    unsigned char *buffer = new unsigned char[BUFSIZE];
+    unsigned char *bufptr = buffer;
+    for (int i = BUFSIZE; i; --i)
+    {
+      *bufptr++ = OFstatic_cast(unsigned char, rnd.getRND32());
+    }
+
+    // add a large word array (VR=OW) in addition to the other test data
+    createTestDataset(dfile.getDataset(), buffer);
+    OFCHECK(dfile.getDataset()->putAndInsertUint16Array(DCM_SegmentedRedPaletteColorLookupTableData, OFreinterpret_cast(Uint16 *, buffer), BUFSIZE/OFstatic_cast(Uint32, sizeof(Uint16))).good());
+
+    OFCHECK(dfile.saveFile("test_mm_le.dcm", EXS_LittleEndianExplicit).good());
+    OFCHECK(dfile.saveFile("test_mm_be.dcm", EXS_BigEndianExplicit).good());
+
+    const char *fileNames[] = { "test_mm_le.dcm", "test_mm_be.dcm" };
+    for (int f = 0; f < 2; ++f)
+    {
+      dcmUseMemoryMappedFiles.set(OFTrue);
+      DcmFileFormat mfile;
+      OFCHECK(mfile.loadFile(fileNames[f]).good());
+      dcmUseMemoryMappedFiles.set(OFFalse);
+      DcmDataset *dset = mfile.getDataset();
+
+      // compare the element values with the original data
+      const Uint8 *uint8Vals = NULL;
+      const Uint16 *uint16Vals = NULL;
+      unsigned long count = 0;
+      OFCHECK(dset->findAndGetUint8Array(DCM_EncapsulatedDocument, uint8Vals, &count).good());
+      OFCHECK_EQUAL(count, BUFSIZE);
+      OFCHECK(uint8Vals != NULL && memcmp(uint8Vals, buffer, BUFSIZE) == 0);
+      OFCHECK(dset->findAndGetUint16Array(DCM_SegmentedRedPaletteColorLookupTableData, uint16Vals, &count).good());
+      OFCHECK_EQUAL(count, BUFSIZE / sizeof(Uint16));
+      OFCHECK(uint16Vals != NULL && memcmp(uint16Vals, buffer, BUFSIZE) == 0);
+      OFCHECK(dset->findAndGetUint16Array(DCM_RWavePointer, uint16Vals, &count).good());
+      OFCHECK(uint16Vals != NULL && memcmp(uint16Vals, buffer, BUFSIZE) == 0);
+
+      // values referring to the mapped file cannot be handed over, but copied
+      DcmElement *delem = NULL;
+      OFCHECK(dset->findAndGetElement(DCM_SegmentedRedPaletteColorLookupTableData, delem).good());
+      OFCHECK(delem != NULL && delem->detachValueField(OFFalse).bad());
+      OFCHECK(delem != NULL && delem->detachValueField(OFTrue).good());
+      OFCHECK(dset->findAndGetUint16Array(DCM_SegmentedRedPaletteColorLookupTableData, uint16Vals, &count).good());
+      OFCHECK(uint16Vals != NULL && memcmp(uint16Vals, buffer, BUFSIZE) == 0);
+      OFCHECK(delem != NULL && delem->detachValueField(OFFalse).good());
+      delete[] OFconst_cast(Uint16 *, uint16Vals);
+      OFCHECK(dset->findAndGetElement(DCM_EncapsulatedDocument, delem).good());
+
+      // modifying the value in memory must not change the file
+      OFCHECK(delem != NULL && delem->getUint8Array(bufptr).good());
+      if (bufptr != NULL)
+        bufptr[0] = OFstatic_cast(Uint8, ~buffer[0]);
+
+      // the mapped file remains valid as long as an element refers to it
+      delem = dset->remove(DCM_EncapsulatedDocument);
+      mfile.clear();
+      OFCHECK(delem != NULL && delem->getUint8Array(bufptr).good());
+      OFCHECK(bufptr != NULL && bufptr[0] == OFstatic_cast(Uint8, ~buffer[0]));
+      OFCHECK(bufptr != NULL && memcmp(bufptr + 1, buffer + 1, BUFSIZE - 1) == 0);
+      delete delem;
+
+      DcmFileFormat cfile;
+      OFCHECK(cfile.loadFile(fileNames[f]).good());
+      OFCHECK(cfile.getDataset()->findAndGetUint8Array(DCM_EncapsulatedDocument, uint8Vals).good());
+      OFCHECK(uint8Vals != NULL && memcmp(uint8Vals, buffer, BUFSIZE) == 0);
+    }
+
+    unlink("test_mm_le.dcm");
+    unlink("test_mm_be.dcm");
+    delete[] buffer;
+}
+
+OFTEST(dcmdata_rereadPopulatedElement)
+{
+    OFRandom rnd;
+    unsigned char *buffer = new unsigned char[BUFSIZE];
+    unsigned char *fileBuffer = new unsigned char[BUFSIZE];
+    for (int i = 0; i < BUFSIZE; ++i)
+    {
+      buffer[i] = OFstatic_cast(unsigned char, rnd.getRND32());
+      fileBuffer[i] = OFstatic_cast(unsigned char, ~buffer[i]);
+    }
+
+    // write a raw value that differs from the one already in the element
+    OFFile rawFile;
+    OFCHECK(rawFile.fopen("test_reread.raw", "wb"));
+    OFCHECK_EQUAL(rawFile.fwrite(fileBuffer, 1, BUFSIZE), OFstatic_cast(size_t, BUFSIZE));
+    rawFile.fclose();
+
+    // re-reading a populated element with a value larger than maxReadLength
+    // must drop the old value and load the new one from the file on demand
+    DcmOtherByteOtherWord elem(DcmTag(DCM_EncapsulatedDocument, EVR_OB));
+    OFCHECK(elem.putUint8Array(buffer, BUFSIZE).good());
+    {
+      DcmInputFileStream inStream("test_reread.raw");
+      OFCHECK(inStream.good());
+      elem.transferInit();
+      OFCHECK(elem.read(inStream, EXS_LittleEndianExplicit, EGL_noChange, 256).good());
+      elem.transferEnd();
+    }
+    OFCHECK(!elem.valueLoaded());
+    Uint8 *uint8Vals = NULL;
+    OFCHECK(elem.getUint8Array(uint8Vals).good());
+    OFCHECK(uint8Vals != NULL && memcmp(uint8Vals, fileBuffer, BUFSIZE) == 0);
+
+    // the same applies if the new value is read immediately
+    OFCHECK(elem.putUint8Array(buffer, BUFSIZE).good());
+    {
+      DcmInputFileStream inStream("test_reread.raw");
+      elem.transferInit();
+      OFCHECK(elem.read(inStream, EXS_LittleEndianExplicit, EGL_noChange, DCM_MaxReadLength * 16).good());
+      elem.transferEnd();
+    }
+    OFCHECK(elem.valueLoaded());
+    OFCHECK(elem.getUint8Array(uint8Vals).good());
+    OFCHECK(uint8Vals != NULL && memcmp(uint8Vals, fileBuffer, BUFSIZE) == 0);
+
+    unlink("test_reread.raw");
+    delete[] fileBuffer;
+    delete[] buffer;
+}
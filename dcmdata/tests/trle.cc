@@ -0,0 +1,203 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmdata
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the RLE encoder and the RLE codecs
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofvector.h"
+
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcpixel.h"
+#include "dcmtk/dcmdata/dcpixseq.h"
+#include "dcmtk/dcmdata/dcpxitem.h"
+#include "dcmtk/dcmdata/dcrleenc.h"
+#include "dcmtk/dcmdata/dcrleerg.h"
+#include "dcmtk/dcmdata/dcrledrg.h"
+
+
+// create test data consisting of runs of different length and random bytes
+static void createTestData(OFVector<Uint8>& data, size_t size)
+{
+  Uint32 seed = 4711;
+  data.clear();
+  while (data.size() < size)
+  {
+    seed = seed * 1103515245 + 12345;
+    const size_t length = (seed >> 16) % 300;
+    const Uint8 value = OFstatic_cast(Uint8, seed >> 8);
+    if (seed & 0x10)
+    {
+      // replicate run
+      for (size_t i = 0; (i < length) && (data.size() < size); ++i) data.push_back(value);
+    }
+    else
+    {
+      // literal run
+      for (size_t i = 0; (i < length / 8) && (data.size() < size); ++i) data.push_back(OFstatic_cast(Uint8, value + i * 7));
+    }
+  }
+}
+
+
+// create a multi-frame image with the given pixel data
+static void createImage(DcmDataset& dset, const OFVector<Uint8>& data, Uint16 bitsAllocated,
+                        Uint16 samplesPerPixel, Uint16 planarConfiguration,
+                        Uint16 columns, Uint16 rows, const char *numberOfFrames)
+{
+  OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_MultiframeTrueColorSecondaryCaptureImageStorage).good());
+  OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, "1.2.276.0.7230010.3.1.4.0.1").good());
+  OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, samplesPerPixel).good());
+  OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, (samplesPerPixel == 3) ? "RGB" : "MONOCHROME2").good());
+  if (samplesPerPixel > 1)
+    OFCHECK(dset.putAndInsertUint16(DCM_PlanarConfiguration, planarConfiguration).good());
+  OFCHECK(dset.putAndInsertString(DCM_NumberOfFrames, numberOfFrames).good());
+  OFCHECK(dset.putAndInsertUint16(DCM_Rows, rows).good());
+  OFCHECK(dset.putAndInsertUint16(DCM_Columns, columns).good());
+  OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, bitsAllocated).good());
+  OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, bitsAllocated).good());
+  OFCHECK(dset.putAndInsertUint16(DCM_HighBit, OFstatic_cast(Uint16, bitsAllocated - 1)).good());
+  OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+  if (bitsAllocated == 8)
+    OFCHECK(dset.putAndInsertUint8Array(DCM_PixelData, &data[0], OFstatic_cast(unsigned long, data.size())).good());
+  else
+    OFCHECK(dset.putAndInsertUint16Array(DCM_PixelData, OFreinterpret_cast(const Uint16 *, &data[0]), OFstatic_cast(unsigned long, data.size() / 2)).good());
+}
+
+
+// compress the given image with the given number of threads and return the pixel sequence
+static DcmPixelSequence *compressImage(DcmDataset& dset, size_t numberOfThreads)
+{
+  DcmRLEEncoderRegistration::registerCodecs(OFFalse, 0, OFTrue, OFFalse, numberOfThreads);
+  OFCHECK(dset.chooseRepresentation(EXS_RLELossless, NULL).good());
+  DcmRLEEncoderRegistration::cleanup();
+
+  DcmElement *elem = NULL;
+  DcmPixelSequence *pixSeq = NULL;
+  OFCHECK(dset.findAndGetElement(DCM_PixelData, elem).good());
+  if (elem)
+    OFCHECK(OFstatic_cast(DcmPixelData *, elem)->getEncapsulatedRepresentation(EXS_RLELossless, NULL, pixSeq).good());
+  return pixSeq;
+}
+
+
+// check whether both pixel sequences contain the same pixel items
+static OFBool samePixelItems(DcmPixelSequence *seq1, DcmPixelSequence *seq2)
+{
+  if ((seq1 == NULL) || (seq2 == NULL) || (seq1->card() != seq2->card())) return OFFalse;
+  for (unsigned long i = 0; i < seq1->card(); ++i)
+  {
+    DcmPixelItem *item1 = NULL;
+    DcmPixelItem *item2 = NULL;
+    Uint8 *data1 = NULL;
+    Uint8 *data2 = NULL;
+    if (seq1->getItem(item1, i).bad() || seq2->getItem(item2, i).bad()) return OFFalse;
+    if (item1->getLength() != item2->getLength()) return OFFalse;
+    if (item1->getLength() > 0)
+    {
+      if (item1->getUint8Array(data1).bad() || item2->getUint8Array(data2).bad()) return OFFalse;
+      if (memcmp(data1, data2, item1->getLength()) != 0) return OFFalse;
+    }
+  }
+  return OFTrue;
+}
+
+
+// compress and decompress an image with and without multiple threads
+static void checkCodec(Uint16 bitsAllocated, Uint16 samplesPerPixel, Uint16 planarConfiguration)
+{
+  const Uint16 columns = 37;
+  const Uint16 rows = 19;
+  const Uint16 frames = 11;
+  OFVector<Uint8> data;
+  createTestData(data, OFstatic_cast(size_t, columns) * rows * frames * samplesPerPixel * (bitsAllocated / 8));
+
+  DcmDataset dset1;
+  DcmDataset dset2;
+  createImage(dset1, data, bitsAllocated, samplesPerPixel, planarConfiguration, columns, rows, "11");
+  createImage(dset2, data, bitsAllocated, samplesPerPixel, planarConfiguration, columns, rows, "11");
+
+  // the compressed frames must not depend on the number of threads
+  OFCHECK(samePixelItems(compressImage(dset1, 1), compressImage(dset2, 3)));
+
+  // decompress the image that has been compressed in parallel
+  dset2.removeAllButCurrentRepresentations();
+  DcmRLEDecoderRegistration::registerCodecs(OFFalse, OFFalse, 3);
+  OFCHECK(dset2.chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+  DcmRLEDecoderRegistration::cleanup();
+
+  // the decompressed pixel data is padded to an even number of bytes
+  DcmElement *elem = NULL;
+  Uint8 *pixelData = NULL;
+  OFCHECK(dset2.findAndGetElement(DCM_PixelData, elem).good());
+  if (elem)
+  {
+    OFCHECK(elem->getUint8Array(pixelData).good());
+    OFCHECK_EQUAL(elem->getLength(), (data.size() + 1) & ~OFstatic_cast(size_t, 1));
+    if (pixelData && (elem->getLength() >= data.size()))
+      OFCHECK(memcmp(pixelData, &data[0], data.size()) == 0);
+  }
+}
+
+
+OFTEST(dcmdata_RLEEncoderBlock)
+{
+  OFVector<Uint8> data;
+  createTestData(data, 200000);
+
+  // add some really long replicate runs
+  data.resize(data.size() + 70000, 0);
+  data.resize(data.size() + 3, 1);
+  data.push_back(2);
+  data.resize(data.size() + 129, 1);
+
+  // adding a block of bytes must give the same result as adding single bytes
+  DcmRLEEncoder encoder1(1);
+  DcmRLEEncoder encoder2(1);
+  for (size_t i = 0; i < data.size(); ++i) encoder1.add(data[i]);
+  encoder1.flush();
+  encoder2.add(&data[0], 1000);
+  encoder2.add(&data[1000], data.size() - 1000);
+  encoder2.flush();
+  OFCHECK(!encoder1.fail());
+  OFCHECK(!encoder2.fail());
+  OFCHECK_EQUAL(encoder1.size(), encoder2.size());
+  if (encoder1.size() == encoder2.size())
+  {
+    OFVector<Uint8> buf1(encoder1.size());
+    OFVector<Uint8> buf2(encoder2.size());
+    encoder1.write(&buf1[0]);
+    encoder2.write(&buf2[0]);
+    OFCHECK(memcmp(&buf1[0], &buf2[0], buf1.size()) == 0);
+  }
+}
+
+
+OFTEST(dcmdata_RLECodecThreads)
+{
+  // monochrome, 8 bit
+  checkCodec(8, 1, 0);
+  // color-by-pixel, 16 bit
+  checkCodec(16, 3, 0);
+  // color-by-plane, 8 bit
+  checkCodec(8, 3, 1);
+}
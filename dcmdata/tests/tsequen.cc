@@ -23,9 +23,11 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 
 #include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
 
 #include "dcmtk/dcmdata/dcitem.h"
 #include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmdata/dcsequen.h"
 #include "dcmtk/dcmdata/dcpxitem.h"
 #include "dcmtk/dcmdata/dcpixseq.h"
@@ -98,3 +100,80 @@ OFTEST(dcmdata_findAndGetSequenceItem)
     OFCHECK(dataset.findAndGetSequenceItem(DCM_OtherPatientIDsSequence, item, 1).good());
     OFCHECK(dataset.findAndGetSequenceItem(DCM_PixelData, item, 1).good());
 }
+
+
+OFTEST(dcmdata_lazySequenceParsing)
+{
+    DcmFileFormat fileformat;
+    DcmDataset *dataset = fileformat.getDataset();
+    DcmItem *item = NULL;
+    DcmItem *subItem = NULL;
+    /* create a dataset with nested sequences */
+    OFCHECK(dataset->putAndInsertString(DCM_PatientName, "Doe^John").good());
+    for (unsigned long i = 0; i < 100; ++i)
+    {
+        OFCHECK(dataset->findOrCreateSequenceItem(DCM_PerFrameFunctionalGroupsSequence, item, -2 /* append */).good());
+        if (item != NULL)
+        {
+            OFCHECK(item->findOrCreateSequenceItem(DCM_FrameContentSequence, subItem).good());
+            if (subItem != NULL)
+                OFCHECK(subItem->putAndInsertUint32(DCM_InStackPositionNumber, i).good());
+        }
+    }
+    OFCHECK(dataset->putAndInsertString(DCM_SeriesDescription, "lazy").good());
+    /* the items are only parsed lazily if the sequence has an explicit length */
+    OFCHECK(fileformat.saveFile("test_lazy.dcm", EXS_LittleEndianExplicit, EET_ExplicitLength).good());
+
+    dcmEnableLazySequenceParsing.set(OFTrue);
+    DcmFileFormat lazyFormat;
+    OFCHECK(lazyFormat.loadFile("test_lazy.dcm").good());
+    DcmFileFormat brokenFormat;
+    OFCHECK(brokenFormat.loadFile("test_lazy.dcm").good());
+    dcmEnableLazySequenceParsing.set(OFFalse);
+
+    /* top-level attributes after the sequence are available without parsing its items */
+    OFString value;
+    DcmDataset *lazyDataset = lazyFormat.getDataset();
+    OFCHECK(lazyDataset->findAndGetOFString(DCM_SeriesDescription, value).good());
+    OFCHECK_EQUAL(value, "lazy");
+
+    /* if the file cannot be accessed any longer, the items cannot be parsed */
+    OFCHECK(OFStandard::renameFile("test_lazy.dcm", "test_lazy_renamed.dcm"));
+    OFCHECK(brokenFormat.getDataset()->findAndGetSequenceItem(DCM_PerFrameFunctionalGroupsSequence, item).bad());
+    OFCHECK(OFStandard::renameFile("test_lazy_renamed.dcm", "test_lazy.dcm"));
+
+    /* items are parsed on first access, including the nested (lazy) sequences */
+    Uint32 position = 0;
+    OFCHECK(lazyDataset->findAndGetSequenceItem(DCM_PerFrameFunctionalGroupsSequence, item, 42).good());
+    if (item != NULL)
+    {
+        OFCHECK(item->findAndGetSequenceItem(DCM_FrameContentSequence, subItem).good());
+        OFCHECK(subItem != NULL && subItem->findAndGetUint32(DCM_InStackPositionNumber, position).good());
+        OFCHECK_EQUAL(position, 42);
+    }
+
+    /* a lazily parsed dataset is equal to a completely parsed one */
+    DcmFileFormat completeFormat;
+    OFCHECK(completeFormat.loadFile("test_lazy.dcm").good());
+    DcmFileFormat lazyFormat2;
+    dcmEnableLazySequenceParsing.set(OFTrue);
+    OFCHECK(lazyFormat2.loadFile("test_lazy.dcm").good());
+    dcmEnableLazySequenceParsing.set(OFFalse);
+    /* copies of sequences with deferred items parse the items from the same file */
+    DcmDataset lazyCopy(*lazyFormat2.getDataset());
+    OFCHECK_EQUAL(lazyCopy.compare(*completeFormat.getDataset()), 0);
+    OFCHECK_EQUAL(lazyFormat2.getDataset()->compare(*completeFormat.getDataset()), 0);
+
+    /* writing a lazily parsed dataset results in the same file */
+    dcmEnableLazySequenceParsing.set(OFTrue);
+    DcmFileFormat lazyFormat3;
+    OFCHECK(lazyFormat3.loadFile("test_lazy.dcm").good());
+    dcmEnableLazySequenceParsing.set(OFFalse);
+    OFCHECK(lazyFormat3.saveFile("test_lazy_copy.dcm", EXS_LittleEndianExplicit, EET_ExplicitLength).good());
+    DcmFileFormat copyFormat;
+    OFCHECK(copyFormat.loadFile("test_lazy_copy.dcm").good());
+    OFCHECK_EQUAL(copyFormat.getDataset()->compare(*completeFormat.getDataset()), 0);
+
+    OFStandard::deleteFile("test_lazy.dcm");
+    OFStandard::deleteFile("test_lazy_copy.dcm");
+}
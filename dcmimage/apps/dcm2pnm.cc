@@ -193,6 +193,7 @@ int main(int argc, char *argv[])
     E_FileType          opt_fileType = EFT_RawPNM;        /* default: 8-bit PGM/PPM */
                                                           /* (binary for file output and ASCII for stdout) */
     OFCmdUnsignedInt    opt_fileBits = 0;                 /* default: 0 */
+    OFCmdUnsignedInt    opt_threads = 1;                  /* default: no parallel processing */
     const char *        opt_ifname = NULL;
     const char *        opt_ofname = NULL;
 
@@ -372,6 +373,10 @@ int main(int argc, char *argv[])
       cmd.addOption("--clip-region",        "+C",   4, "[l]eft [t]op [w]idth [h]eight: integer",
                                                        "clip image region (l, t, w, h)");
 
+     cmd.addSubGroup("multi-threading:");
+      cmd.addOption("--threads",            "+th",  1, "[n]umber: integer (0 = number of CPUs)",
+                                                       "render pixel data using up to n threads\n(default: 1)");
+
     cmd.addGroup("output options:");
      cmd.addSubGroup("general:");
       cmd.addOption("--image-info",         "-im",     "print image details (requires verbose mode)");
@@ -524,6 +529,11 @@ int main(int argc, char *argv[])
             opt_useClip = 1;
         }
 
+        /* image processing options: multi-threading */
+
+        if (cmd.findOption("--threads"))
+            app.checkValue(cmd.getValue(opt_threads));
+
         /* image processing options: rotation */
 
         cmd.beginOptionBlock();
@@ -929,6 +939,8 @@ int main(int argc, char *argv[])
         opt_compatibilityMode |= CIF_UsePartialAccessToPixelData;
     }
 
+    DicomImageClass::setNumberOfThreads(opt_threads);
+
     DicomImage *di = new DicomImage(dfile, xfer, opt_compatibilityMode, opt_frame - 1, opt_frameCount);
     if (di == NULL)
     {
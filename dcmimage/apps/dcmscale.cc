@@ -99,6 +99,8 @@ int main(int argc, char *argv[])
     OFCmdSignedInt   opt_left = 0, opt_top = 0;        /* clip region (origin) */
     OFCmdUnsignedInt opt_width = 0, opt_height = 0;    /* clip region (extension) */
 
+    OFCmdUnsignedInt opt_threads = 1;                  /* default: no parallel processing */
+
     const char *opt_ifname = NULL;
     const char *opt_ofname = NULL;
 
@@ -153,6 +155,9 @@ int main(int argc, char *argv[])
      cmd.addSubGroup("other transformations:");
       cmd.addOption("--clip-region",         "+C",   4, "[l]eft [t]op [w]idth [h]eight: integer",
                                                         "clip rectangular image region (l, t, w, h)");
+     cmd.addSubGroup("multi-threading:");
+      cmd.addOption("--threads",             "+th",  1, "[n]umber: integer (0 = number of CPUs)",
+                                                        "scale pixel data using up to n threads\n(default: 1)");
      cmd.addSubGroup("SOP Instance UID:");
       cmd.addOption("--uid-always",          "+ua",     "always assign new SOP Instance UID (default)");
       cmd.addOption("--uid-never",           "+un",     "never assign new SOP Instance UID");
@@ -316,6 +321,11 @@ int main(int argc, char *argv[])
           opt_useClip = OFTrue;
       }
 
+      /* image processing options: multi-threading */
+
+      if (cmd.findOption("--threads"))
+          app.checkValue(cmd.getValue(opt_threads));
+
       /* image processing options: SOP Instance UID options */
 
       cmd.beginOptionBlock();
@@ -447,6 +457,8 @@ int main(int argc, char *argv[])
 
     OFLOG_INFO(dcmscaleLogger, "preparing pixel data");
 
+    DicomImageClass::setNumberOfThreads(opt_threads);
+
     const unsigned long flags = (opt_scaleType > 0) ? CIF_MayDetachPixelData : 0;
     // create DicomImage object
     DicomImage *di = new DicomImage(dataset, opt_oxfer, flags);
@@ -31,6 +31,8 @@
 
 #include "dcmtk/dcmimgle/dimopxt.h"
 #include "dcmtk/dcmimgle/diinpx.h"
+#include "dcmtk/dcmimgle/disimdt.h"
+#include "dcmtk/dcmimgle/dithread.h"
 
 
 /*---------------------*
@@ -163,9 +165,8 @@ class DiMonoInputPixelTemplate
                                 *(q++) = OFstatic_cast(T3, mlut->getValue(value));
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);                 // points to 'zero' entry
-                        q = this->Data;
-                        for (i = this->InputCount; i != 0; --i)                           // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, this->Data, lut0, this->InputCount);       // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                      // use "normal" transformation
                     {
@@ -217,8 +218,8 @@ class DiMonoInputPixelTemplate
                     {
                         DCMIMGLE_DEBUG("copying pixel data from input buffer");
                         const T1 *p = pixel + input->getPixelStart();
-                        for (i = this->InputCount; i != 0; --i)   // copy pixel data: can't use copyMem because T1 isn't always equal to T3
-                            *(q++) = OFstatic_cast(T3, *(p++));
+                        DiCopyPixelTask<T1, T3> task(p, q, this->InputCount);   // copy pixel data: can't use copyMem because T1 isn't always equal to T3
+                        task.run();
                     }
                 } else {
                     DCMIMGLE_DEBUG("applying modality transformation with rescale slope = " << slope << ", intercept = " << intercept);
@@ -229,7 +230,9 @@ class DiMonoInputPixelTemplate
                     {                                                                     // use LUT for optimization
                         const double absmin = input->getAbsMinimum();
                         q = lut;
-                        if (slope == 1.0)
+                        if (DiSIMDTemplate<T1, T3>::isSupported())                        // use vectorized kernel
+                            DiSIMDTemplate<T1, T3>::rescaleRange(absmin, q, ocnt, slope, intercept);
+                        else if (slope == 1.0)
                         {
                             for (i = 0; i < ocnt; ++i)                                    // calculating LUT entries
                                 *(q++) = OFstatic_cast(T3, OFstatic_cast(double, i) + absmin + intercept);
@@ -244,13 +247,14 @@ class DiMonoInputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);                 // points to 'zero' entry
-                        q = this->Data;
-                        for (i = this->InputCount; i != 0; --i)                           // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, this->Data, lut0, this->InputCount);       // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                      // use "normal" transformation
                     {
-                        if (slope == 1.0)
+                        if (DiSIMDTemplate<T1, T3>::isSupported())                        // use vectorized kernel
+                            DiSIMDTemplate<T1, T3>::rescale(p, q, this->InputCount, slope, intercept);
+                        else if (slope == 1.0)
                         {
                             for (i = this->InputCount; i != 0; --i)
                                 *(q++) = OFstatic_cast(T3, OFstatic_cast(double, *(p++)) + intercept);
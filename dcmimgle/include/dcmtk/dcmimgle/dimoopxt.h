@@ -36,6 +36,8 @@
 #include "dcmtk/dcmimgle/dipxrept.h"
 #include "dcmtk/dcmimgle/didispfn.h"
 #include "dcmtk/dcmimgle/didislut.h"
+#include "dcmtk/dcmimgle/disimdt.h"
+#include "dcmtk/dcmimgle/dithread.h"
 
 #ifdef PASTEL_COLOR_OUTPUT
 #include "dimcopxt.h"
@@ -459,9 +461,8 @@ class DiMonoOutputPixelTemplate
                                 }
                             }
                             const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());  // points to 'zero' entry
-                            q = Data;
-                            for (i = Count; i != 0; --i)                                  // apply LUT
-                                *(q++) = *(lut0 + (*(p++)));
+                            DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                // apply LUT
+                            task.run();
                         }
                         if (lut == NULL)                                                  // use "normal" transformation
                         {
@@ -559,9 +560,8 @@ class DiMonoOutputPixelTemplate
                                 }
                             }
                             const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());   // points to 'zero' entry
-                            q = Data;
-                            for (i = Count; i != 0; --i)                                  // apply LUT
-                                *(q++) = *(lut0 + (*(p++)));
+                            DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                // apply LUT
+                            task.run();
                         }
                         if (lut == NULL)                                                  // use "normal" transformation
                         {
@@ -687,9 +687,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());  // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                    // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -743,9 +742,8 @@ class DiMonoOutputPixelTemplate
                                 *(q++) = OFstatic_cast(T3, lowvalue + OFstatic_cast(double, i) * gradient);
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, inter->getAbsMinimum());  // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                    // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -846,9 +844,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                    // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -900,9 +897,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                    // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -1020,9 +1016,8 @@ class DiMonoOutputPixelTemplate
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                    // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -1083,21 +1078,25 @@ class DiMonoOutputPixelTemplate
                             DCMIMGLE_TRACE("monochrome rendering: VOI LINEAR #6");
                             const double offset = (width_1 == 0) ? 0 : (high - ((center - 0.5) / width_1 + 0.5) * outrange);
                             const double gradient = (width_1 == 0) ? 0 : outrange / width_1;
-                            for (i = 0; i < ocnt; ++i)                                 // calculating LUT entries
+                            if (DiSIMDTemplate<T1, T3>::isSupported())                 // use vectorized kernel
+                                DiSIMDTemplate<T1, T3>::windowRange(absmin, q, ocnt, leftBorder, rightBorder, offset, gradient, low, high);
+                            else
                             {
-                                value = OFstatic_cast(double, i) + absmin;
-                                if (value <= leftBorder)
-                                    *(q++) = low;                                            // black/white
-                                else if (value > rightBorder)
-                                    *(q++) = high;                                           // white/black
-                                else
-                                    *(q++) = OFstatic_cast(T3, offset + value * gradient);   // gray value
+                                for (i = 0; i < ocnt; ++i)                             // calculating LUT entries
+                                {
+                                    value = OFstatic_cast(double, i) + absmin;
+                                    if (value <= leftBorder)
+                                        *(q++) = low;                                        // black/white
+                                    else if (value > rightBorder)
+                                        *(q++) = high;                                       // white/black
+                                    else
+                                        *(q++) = OFstatic_cast(T3, offset + value * gradient);   // gray value
+                                }
                             }
                         }
                         const T3 *lut0 = lut - OFstatic_cast(T2, absmin);             // points to 'zero' entry
-                        q = Data;
-                        for (i = Count; i != 0; --i)                                  // apply LUT
-                            *(q++) = *(lut0 + (*(p++)));
+                        DiApplyLUTTask<T1, T3> task(p, Data, lut0, Count);                    // apply LUT
+                        task.run();
                     }
                     if (lut == NULL)                                                  // use "normal" transformation
                     {
@@ -1120,15 +1119,20 @@ class DiMonoOutputPixelTemplate
                             DCMIMGLE_TRACE("monochrome rendering: VOI LINEAR #8");
                             const double offset = (width_1 == 0) ? 0 : (high - ((center - 0.5) / width_1 + 0.5) * outrange);
                             const double gradient = (width_1 == 0) ? 0 : outrange / width_1;
-                            for (i = Count; i != 0; --i)
+                            if (DiSIMDTemplate<T1, T3>::isSupported())                // use vectorized kernel
+                                DiSIMDTemplate<T1, T3>::window(p, q, Count, leftBorder, rightBorder, offset, gradient, low, high);
+                            else
                             {
-                                value = OFstatic_cast(double, *(p++));
-                                if (value <= leftBorder)
-                                    *(q++) = low;                                            // black/white
-                                else if (value > rightBorder)
-                                    *(q++) = high;                                           // white/black
-                                else
-                                    *(q++) = OFstatic_cast(T3, offset + value * gradient);   // gray value
+                                for (i = Count; i != 0; --i)
+                                {
+                                    value = OFstatic_cast(double, *(p++));
+                                    if (value <= leftBorder)
+                                        *(q++) = low;                                        // black/white
+                                    else if (value > rightBorder)
+                                        *(q++) = high;                                       // white/black
+                                    else
+                                        *(q++) = OFstatic_cast(T3, offset + value * gradient);   // gray value
+                                }
                             }
                         }
                     }
@@ -29,6 +29,8 @@
 
 #include "dcmtk/dcmimgle/ditranst.h"
 #include "dcmtk/dcmimgle/dipxrept.h"
+#include "dcmtk/dcmimgle/dithread.h"
+#include "dcmtk/dcmimgle/disimdt.h"
 
 
 /*---------------------*
@@ -248,6 +250,111 @@ class DiScaleTemplate
 
  private:
 
+    /// pointer to a member function scaling a band of rows of a single frame
+    typedef void (DiScaleTemplate<T>::*BandFunction)(const T *, T *, const Uint16, const Uint16);
+
+    /** Helper class for scaling the planes and frames (or bands of rows) of an image in parallel
+     */
+    class BandTask
+      : public DiRowBandTask
+    {
+
+     public:
+
+        /** constructor
+         *
+         ** @param  scaler     reference to the scaling object
+         *  @param  function   member function scaling a band of rows of a single frame
+         *  @param  src        array of pointers to source image pixels
+         *  @param  dest       array of pointers to destination image pixels
+         *  @param  srcSize    number of source pixels per frame
+         *  @param  destSize   number of destination pixels per frame
+         *  @param  planes     number of planes
+         *  @param  frames     number of frames
+         *  @param  rows       number of destination rows per frame
+         *  @param  splitRows  divide the rows of a frame into bands if true
+         */
+        BandTask(DiScaleTemplate<T> &scaler,
+                 BandFunction function,
+                 const T *src[],
+                 T *dest[],
+                 const unsigned long srcSize,
+                 const unsigned long destSize,
+                 const int planes,
+                 const unsigned long frames,
+                 const Uint16 rows,
+                 const OFBool splitRows)
+          : DiRowBandTask(planes, frames, rows, (srcSize > destSize) ? srcSize : destSize, splitRows),
+            Scaler(scaler),
+            Function(function),
+            Source(src),
+            Dest(dest),
+            SourceSize(srcSize),
+            DestSize(destSize)
+        {
+        }
+
+
+     protected:
+
+        /** scale a band of rows of a particular plane and frame
+         *
+         ** @param  plane     index of the plane to be processed
+         *  @param  frame     index of the frame to be processed
+         *  @param  firstRow  index of the first destination row to be processed
+         *  @param  rowCount  number of destination rows to be processed
+         */
+        virtual void process(const int plane,
+                             const unsigned long frame,
+                             const Uint16 firstRow,
+                             const Uint16 rowCount)
+        {
+            (Scaler.*Function)(Source[plane] + frame * SourceSize, Dest[plane] + frame * DestSize, firstRow, rowCount);
+        }
+
+
+     private:
+
+        /// reference to the scaling object
+        DiScaleTemplate<T> &Scaler;
+        /// member function scaling a band of rows
+        const BandFunction Function;
+        /// array of pointers to source image pixels
+        const T **Source;
+        /// array of pointers to destination image pixels
+        T **Dest;
+        /// number of source pixels per frame
+        const unsigned long SourceSize;
+        /// number of destination pixels per frame
+        const unsigned long DestSize;
+
+     // --- declarations to avoid compiler warnings
+
+        BandTask(const BandTask &);
+        BandTask &operator=(const BandTask &);
+    };
+
+    /** scale all planes and frames using the given function, either sequentially or in
+     *  parallel (see DicomImageClass::setNumberOfThreads())
+     *
+     ** @param  src        array of pointers to source image pixels
+     *  @param  dest       array of pointers to destination image pixels
+     *  @param  function   member function scaling a band of rows of a single frame
+     *  @param  splitRows  divide the rows of a frame into bands if true, the function is
+     *                     always called for complete frames otherwise
+     */
+    void runBandTask(const T *src[],
+                     T *dest[],
+                     BandFunction function,
+                     const OFBool splitRows)
+    {
+        BandTask task(*this, function, src, dest,
+            OFstatic_cast(unsigned long, Columns) * OFstatic_cast(unsigned long, Rows),
+            OFstatic_cast(unsigned long, this->Dest_X) * OFstatic_cast(unsigned long, this->Dest_Y),
+            this->Planes, this->Frames, this->Dest_Y, splitRows);
+        task.run();
+    }
+
     /** clip image to specified area (only inside image boundaries).
      *  This is an optimization of the more general method clipBorderPixel().
      *
@@ -367,38 +474,39 @@ class DiScaleTemplate
                         T *dest[])
     {
         DCMIMGLE_DEBUG("using replicate pixel scaling algorithm without interpolation");
+        runBandTask(src, dest, &DiScaleTemplate<T>::replicateRows, OFTrue /*splitRows*/);
+    }
+
+    /** enlarge a band of rows of a single frame by an integer factor (see replicatePixel())
+     *
+     ** @param  src       pointer to source pixels of the frame
+     *  @param  dest      pointer to destination pixels of the frame
+     *  @param  firstRow  index of the first destination row to be processed
+     *  @param  rowCount  number of destination rows to be processed
+     */
+    void replicateRows(const T *src,
+                       T *dest,
+                       const Uint16 firstRow,
+                       const Uint16 rowCount)
+    {
         const Uint16 x_factor = this->Dest_X / this->Src_X;
         const Uint16 y_factor = this->Dest_Y / this->Src_Y;
-        const unsigned long x_feed = Columns;
-        const unsigned long y_feed = OFstatic_cast(unsigned long, Rows - this->Src_Y) * OFstatic_cast(unsigned long, Columns);
-        const T *sp;
+        const T *sp = src + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
+        const Uint16 lastRow = firstRow + rowCount;
         Uint16 x;
         Uint16 y;
         Uint16 dx;
-        Uint16 dy;
         const T *p;
-        T *q;
+        T *q = dest + OFstatic_cast(unsigned long, firstRow) * OFstatic_cast(unsigned long, this->Dest_X);
         T value;
-        for (int j = 0; j < this->Planes; ++j)
+        for (y = firstRow; y < lastRow; ++y)
         {
-            sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-            q = dest[j];
-            for (unsigned long f = this->Frames; f != 0; --f)
+            p = sp + OFstatic_cast(unsigned long, y / y_factor) * OFstatic_cast(unsigned long, Columns);
+            for (x = this->Src_X; x != 0; --x)
             {
-                for (y = this->Src_Y; y != 0; --y)
-                {
-                    for (dy = y_factor; dy != 0; --dy)
-                    {
-                        for (x = this->Src_X, p = sp; x != 0; --x)
-                        {
-                            value = *(p++);
-                            for (dx = x_factor; dx != 0; --dx)
-                                *(q++) = value;
-                        }
-                    }
-                    sp += x_feed;
-                }
-                sp += y_feed;
+                value = *(p++);
+                for (dx = x_factor; dx != 0; --dx)
+                    *(q++) = value;
             }
         }
     }
@@ -413,30 +521,37 @@ class DiScaleTemplate
                        T *dest[])
     {
         DCMIMGLE_DEBUG("using suppress pixel scaling algorithm without interpolation");
+        runBandTask(src, dest, &DiScaleTemplate<T>::suppressRows, OFTrue /*splitRows*/);
+    }
+
+    /** shrink a band of rows of a single frame by an integer divisor (see suppressPixel())
+     *
+     ** @param  src       pointer to source pixels of the frame
+     *  @param  dest      pointer to destination pixels of the frame
+     *  @param  firstRow  index of the first destination row to be processed
+     *  @param  rowCount  number of destination rows to be processed
+     */
+    void suppressRows(const T *src,
+                      T *dest,
+                      const Uint16 firstRow,
+                      const Uint16 rowCount)
+    {
         const unsigned int x_divisor = this->Src_X / this->Dest_X;
-        const unsigned long x_feed = OFstatic_cast(unsigned long, this->Src_Y / this->Dest_Y) * OFstatic_cast(unsigned long, Columns) - this->Src_X;
-        const unsigned long y_feed = OFstatic_cast(unsigned long, Rows - this->Src_Y) * OFstatic_cast(unsigned long, Columns);
+        const unsigned long y_feed = OFstatic_cast(unsigned long, this->Src_Y / this->Dest_Y) * OFstatic_cast(unsigned long, Columns);
+        const T *sp = src + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left +
+                      OFstatic_cast(unsigned long, firstRow) * y_feed;
         Uint16 x;
         Uint16 y;
         const T *p;
-        T *q;
-        for (int j = 0; j < this->Planes; ++j)
+        T *q = dest + OFstatic_cast(unsigned long, firstRow) * OFstatic_cast(unsigned long, this->Dest_X);
+        for (y = rowCount; y != 0; --y)
         {
-            p = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-            q = dest[j];
-            for (unsigned long f = this->Frames; f != 0; --f)
+            for (x = this->Dest_X, p = sp; x != 0; --x)
             {
-                for (y = this->Dest_Y; y != 0; --y)
-                {
-                    for (x = this->Dest_X; x != 0; --x)
-                    {
-                        *(q++) = *p;
-                        p += x_divisor;
-                    }
-                    p += x_feed;
-                }
-                p += y_feed;
+                *(q++) = *p;
+                p += x_divisor;
             }
+            sp += y_feed;
         }
     }
 
@@ -450,6 +565,22 @@ class DiScaleTemplate
                     T *dest[])
     {
         DCMIMGLE_DEBUG("using free scaling algorithm without interpolation");
+        runBandTask(src, dest, &DiScaleTemplate<T>::scaleRows, OFFalse /*splitRows*/);
+    }
+
+    /** free scaling of a single frame without interpolation (see scalePixel()).
+     *  The frame is always processed as a whole.
+     *
+     ** @param  src       pointer to source pixels of the frame
+     *  @param  dest      pointer to destination pixels of the frame
+     *  @param  firstRow  index of the first destination row to be processed (not used)
+     *  @param  rowCount  number of destination rows to be processed (not used)
+     */
+    void scaleRows(const T *src,
+                   T *dest,
+                   const Uint16 /* firstRow */,
+                   const Uint16 /* rowCount */)
+    {
         const Uint16 xmin = (this->Dest_X < this->Src_X) ? this->Dest_X : this->Src_X;  // minimum width
         const Uint16 ymin = (this->Dest_Y < this->Src_Y) ? this->Dest_Y : this->Src_Y;  // minimum height
         Uint16 *x_step = new Uint16[xmin];
@@ -483,34 +614,25 @@ class DiScaleTemplate
                 OFBitmanipTemplate<Uint16>::setMem(y_fact, 1, ymin);  // initialize with default values
             if (this->Dest_Y >= this->Src_Y)
                 OFBitmanipTemplate<Uint16>::setMem(y_step, 1, ymin);  // initialize with default values
-            y_step[ymin - 1] += Rows - this->Src_Y;                   // skip to next frame
-            const T *sp;
+            const T *sp = src + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
             Uint16 dx;
             Uint16 dy;
             const T *p;
-            T *q;
+            T *q = dest;
             T value;
-            for (int j = 0; j < this->Planes; ++j)
+            for (y = 0; y < ymin; ++y)
             {
-                sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-                q = dest[j];
-                for (unsigned long f = 0; f < this->Frames; ++f)
+                for (dy = 0; dy < y_fact[y]; ++dy)
                 {
-                    for (y = 0; y < ymin; ++y)
+                    for (x = 0, p = sp; x < xmin; ++x)
                     {
-                        for (dy = 0; dy < y_fact[y]; ++dy)
-                        {
-                            for (x = 0, p = sp; x < xmin; ++x)
-                            {
-                                value = *p;
-                                for (dx = 0; dx < x_fact[x]; ++dx)
-                                    *(q++) = value;
-                                p += x_step[x];
-                            }
-                        }
-                        sp += OFstatic_cast(unsigned long, y_step[y]) * OFstatic_cast(unsigned long, Columns);
+                        value = *p;
+                        for (dx = 0; dx < x_fact[x]; ++dx)
+                            *(q++) = value;
+                        p += x_step[x];
                     }
                 }
+                sp += OFstatic_cast(unsigned long, y_step[y]) * OFstatic_cast(unsigned long, Columns);
             }
         }
         delete[] x_step;
@@ -535,7 +657,23 @@ class DiScaleTemplate
             this->Src_X = Columns;            // temporarily removed 'const' for 'Src_X' in class 'DiTransTemplate'
             this->Src_Y = Rows;               //                             ... 'Src_Y' ...
         }
+        runBandTask(src, dest, &DiScaleTemplate<T>::interpolateRows, OFTrue /*splitRows*/);
+    }
 
+    /** free scaling of a band of rows of a single frame with interpolation (see interpolatePixel()).
+     *  The source rows contributing to the rows before the band are skipped without processing
+     *  the pixels, so each band creates exactly the same output as the whole frame.
+     *
+     ** @param  src       pointer to source pixels of the frame
+     *  @param  dest      pointer to destination pixels of the frame
+     *  @param  firstRow  index of the first destination row to be processed
+     *  @param  rowCount  number of destination rows to be processed
+     */
+    void interpolateRows(const T *src,
+                         T *dest,
+                         const Uint16 firstRow,
+                         const Uint16 rowCount)
+    {
         /*
          *   based on scaling algorithm from "Extended Portable Bitmap Toolkit" (pbmplus10dec91)
          *   (adapted to be used with signed pixel representation, inverse images - mono1,
@@ -547,8 +685,9 @@ class DiScaleTemplate
         const T *p;
         T *q;
         const T *sp = NULL;                         // initialization avoids compiler warning
-        const T *fp;
-        T *sq;
+        const T *fp = src;
+        T *sq = dest + OFstatic_cast(unsigned long, firstRow) * OFstatic_cast(unsigned long, this->Dest_X);
+        const Uint16 lastRow = firstRow + rowCount;
 
         const unsigned long sxscale = OFstatic_cast(unsigned long, (OFstatic_cast(double, this->Dest_X) / OFstatic_cast(double, this->Src_X)) * SCALE_FACTOR);
         const unsigned long syscale = OFstatic_cast(unsigned long, (OFstatic_cast(double, this->Dest_Y) / OFstatic_cast(double, this->Src_Y)) * SCALE_FACTOR);
@@ -560,120 +699,124 @@ class DiScaleTemplate
         if ((xtemp == NULL) || (xvalue == NULL))
         {
             DCMIMGLE_ERROR("can't allocate temporary buffers for interpolation scaling");
-            this->clearPixel(dest);
+            OFBitmanipTemplate<T>::zeroMem(sq, OFstatic_cast(unsigned long, rowCount) * OFstatic_cast(unsigned long, this->Dest_X));
         } else {
-            for (int j = 0; j < this->Planes; ++j)
+            for (x = 0; x < this->Src_X; ++x)
+                xvalue[x] = HALFSCALE_FACTOR;
+            unsigned long yfill = SCALE_FACTOR;
+            unsigned long yleft = syscale;
+            int yneed = 1;
+            int ysrc = 0;
+            if (this->Src_Y == this->Dest_Y)
+                fp += OFstatic_cast(unsigned long, firstRow) * OFstatic_cast(unsigned long, this->Src_X);
+            // rows before the band only update the state of the vertical scaling
+            for (y = (this->Src_Y == this->Dest_Y) ? firstRow : 0; y < lastRow; ++y)
             {
-                fp = src[j];
-                sq = dest[j];
-                for (unsigned long f = this->Frames; f != 0; --f)
+                const OFBool inBand = (y >= firstRow);
+                if (this->Src_Y == this->Dest_Y)
                 {
-                    for (x = 0; x < this->Src_X; ++x)
-                        xvalue[x] = HALFSCALE_FACTOR;
-                    unsigned long yfill = SCALE_FACTOR;
-                    unsigned long yleft = syscale;
-                    int yneed = 1;
-                    int ysrc = 0;
-                    for (y = 0; y < this->Dest_Y; ++y)
+                    sp = fp;
+                    for (x = this->Src_X, p = sp, q = xtemp; x != 0; --x)
+                        *(q++) = *(p++);
+                    fp += this->Src_X;
+                }
+                else
+                {
+                    while (yleft < yfill)
                     {
-                        if (this->Src_Y == this->Dest_Y)
+                        if (yneed && (ysrc < OFstatic_cast(int, this->Src_Y)))
                         {
                             sp = fp;
-                            for (x = this->Src_X, p = sp, q = xtemp; x != 0; --x)
-                                *(q++) = *(p++);
                             fp += this->Src_X;
+                            ++ysrc;
                         }
-                        else
+                        if (inBand)
                         {
-                            while (yleft < yfill)
-                            {
-                                if (yneed && (ysrc < OFstatic_cast(int, this->Src_Y)))
-                                {
-                                    sp = fp;
-                                    fp += this->Src_X;
-                                    ++ysrc;
-                                }
-                                for (x = 0, p = sp; x < this->Src_X; ++x)
-                                    xvalue[x] += yleft * OFstatic_cast(signed long, *(p++));
-                                yfill -= yleft;
-                                yleft = syscale;
-                                yneed = 1;
-                            }
-                            if (yneed && (ysrc < OFstatic_cast(int, this->Src_Y)))
-                            {
-                                sp = fp;
-                                fp += this->Src_X;
-                                ++ysrc;
-                                yneed = 0;
-                            }
-                            signed long v;
-                            for (x = 0, p = sp, q = xtemp; x < this->Src_X; ++x)
-                            {
-                                v = xvalue[x] + yfill * OFstatic_cast(signed long, *(p++));
-                                v /= SCALE_FACTOR;
-                                *(q++) = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
-                                xvalue[x] = HALFSCALE_FACTOR;
-                            }
-                            yleft -= yfill;
-                            if (yleft == 0)
-                            {
-                                yleft = syscale;
-                                yneed = 1;
-                            }
-                            yfill = SCALE_FACTOR;
+                            for (x = 0, p = sp; x < this->Src_X; ++x)
+                                xvalue[x] += yleft * OFstatic_cast(signed long, *(p++));
                         }
-                        if (this->Src_X == this->Dest_X)
+                        yfill -= yleft;
+                        yleft = syscale;
+                        yneed = 1;
+                    }
+                    if (yneed && (ysrc < OFstatic_cast(int, this->Src_Y)))
+                    {
+                        sp = fp;
+                        fp += this->Src_X;
+                        ++ysrc;
+                        yneed = 0;
+                    }
+                    if (inBand)
+                    {
+                        signed long v;
+                        for (x = 0, p = sp, q = xtemp; x < this->Src_X; ++x)
                         {
-                            for (x = this->Dest_X, p = xtemp, q = sq; x != 0; --x)
-                                *(q++) = *(p++);
-                            sq += this->Dest_X;
+                            v = xvalue[x] + yfill * OFstatic_cast(signed long, *(p++));
+                            v /= SCALE_FACTOR;
+                            *(q++) = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
+                            xvalue[x] = HALFSCALE_FACTOR;
                         }
-                        else
+                    }
+                    yleft -= yfill;
+                    if (yleft == 0)
+                    {
+                        yleft = syscale;
+                        yneed = 1;
+                    }
+                    yfill = SCALE_FACTOR;
+                }
+                if (!inBand)
+                    continue;
+                if (this->Src_X == this->Dest_X)
+                {
+                    for (x = this->Dest_X, p = xtemp, q = sq; x != 0; --x)
+                        *(q++) = *(p++);
+                    sq += this->Dest_X;
+                }
+                else
+                {
+                    signed long v = HALFSCALE_FACTOR;
+                    unsigned long xfill = SCALE_FACTOR;
+                    unsigned long xleft;
+                    int xneed = 0;
+                    q = sq;
+                    for (x = 0, p = xtemp; x < this->Src_X; ++x, ++p)
+                    {
+                        xleft = sxscale;
+                        while (xleft >= xfill)
                         {
-                            signed long v = HALFSCALE_FACTOR;
-                            unsigned long xfill = SCALE_FACTOR;
-                            unsigned long xleft;
-                            int xneed = 0;
-                            q = sq;
-                            for (x = 0, p = xtemp; x < this->Src_X; ++x, ++p)
+                            if (xneed)
                             {
-                                xleft = sxscale;
-                                while (xleft >= xfill)
-                                {
-                                    if (xneed)
-                                    {
-                                        ++q;
-                                        v = HALFSCALE_FACTOR;
-                                    }
-                                    v += xfill * OFstatic_cast(signed long, *p);
-                                    v /= SCALE_FACTOR;
-                                    *q = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
-                                    xleft -= xfill;
-                                    xfill = SCALE_FACTOR;
-                                    xneed = 1;
-                                }
-                                if (xleft > 0)
-                                {
-                                    if (xneed)
-                                    {
-                                        ++q;
-                                        v = HALFSCALE_FACTOR;
-                                        xneed = 0;
-                                    }
-                                    v += xleft * OFstatic_cast(signed long, *p);
-                                    xfill -= xleft;
-                                }
+                                ++q;
+                                v = HALFSCALE_FACTOR;
                             }
-                            if (xfill > 0)
-                                v += xfill * OFstatic_cast(signed long, *(--p));
-                            if (!xneed)
+                            v += xfill * OFstatic_cast(signed long, *p);
+                            v /= SCALE_FACTOR;
+                            *q = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
+                            xleft -= xfill;
+                            xfill = SCALE_FACTOR;
+                            xneed = 1;
+                        }
+                        if (xleft > 0)
+                        {
+                            if (xneed)
                             {
-                                v /= SCALE_FACTOR;
-                                *q = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
+                                ++q;
+                                v = HALFSCALE_FACTOR;
+                                xneed = 0;
                             }
-                            sq += this->Dest_X;
+                            v += xleft * OFstatic_cast(signed long, *p);
+                            xfill -= xleft;
                         }
                     }
+                    if (xfill > 0)
+                        v += xfill * OFstatic_cast(signed long, *(--p));
+                    if (!xneed)
+                    {
+                        v /= SCALE_FACTOR;
+                        *q = OFstatic_cast(T, (v > maxvalue) ? maxvalue : v);
+                    }
+                    sq += this->Dest_X;
                 }
             }
         }
@@ -691,10 +834,25 @@ class DiScaleTemplate
                      T *dest[])
     {
         DCMIMGLE_DEBUG("using expand pixel scaling algorithm with interpolation from c't magazine");
+        runBandTask(src, dest, &DiScaleTemplate<T>::expandRows, OFTrue /*splitRows*/);
+    }
+
+    /** expand a band of rows of a single frame with interpolation (see expandPixel())
+     *
+     ** @param  src       pointer to source pixels of the frame
+     *  @param  dest      pointer to destination pixels of the frame
+     *  @param  firstRow  index of the first destination row to be processed
+     *  @param  rowCount  number of destination rows to be processed
+     */
+    void expandRows(const T *src,
+                    T *dest,
+                    const Uint16 firstRow,
+                    const Uint16 rowCount)
+    {
         const double x_factor = OFstatic_cast(double, this->Src_X) / OFstatic_cast(double, this->Dest_X);
         const double y_factor = OFstatic_cast(double, this->Src_Y) / OFstatic_cast(double, this->Dest_Y);
-        const unsigned long f_size = OFstatic_cast(unsigned long, Rows) * OFstatic_cast(unsigned long, Columns);
-        const T *sp;
+        const T *sp = src + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
+        const Uint16 lastRow = firstRow + rowCount;
         double bx, ex;
         double by, ey;
         int bxi, exi;
@@ -709,7 +867,7 @@ class DiScaleTemplate
         Uint16 x;
         Uint16 y;
         const T *p;
-        T *q;
+        T *q = dest + OFstatic_cast(unsigned long, firstRow) * OFstatic_cast(unsigned long, this->Dest_X);
 
         /*
          *   based on scaling algorithm from "c't - Magazin fuer Computertechnik" (c't 11/94)
@@ -717,90 +875,81 @@ class DiScaleTemplate
          *    various bit depths, multi-frame and multi-plane/color images, combined clipping/scaling)
          */
 
-        for (int j = 0; j < this->Planes; ++j)
+        for (y = firstRow; y < lastRow; ++y)
         {
-            sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-            q = dest[j];
-            for (unsigned long f = 0; f < this->Frames; ++f)
+            by = y_factor * OFstatic_cast(double, y);
+            ey = y_factor * (OFstatic_cast(double, y) + 1.0);
+            if (ey > this->Src_Y)
+            {
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
+#endif
+                // see reduceRows()
+                ey = this->Src_Y;
+            }
+            byi = OFstatic_cast(int, by);
+            eyi = OFstatic_cast(int, ey);
+            if (OFstatic_cast(double, eyi) == ey)
+            {
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
+#endif
+                --eyi;
+            }
+            y_part = OFstatic_cast(double, eyi) / y_factor;
+            b_factor = y_part - OFstatic_cast(double, y);
+            t_factor = (OFstatic_cast(double, y) + 1.0) - y_part;
+            for (x = 0; x < this->Dest_X; ++x)
             {
-                for (y = 0; y < this->Dest_Y; ++y)
+                value = 0;
+                bx = x_factor * OFstatic_cast(double, x);
+                ex = x_factor * (OFstatic_cast(double, x) + 1.0);
+                if (ex > this->Src_X)
                 {
-                    by = y_factor * OFstatic_cast(double, y);
-                    ey = y_factor * (OFstatic_cast(double, y) + 1.0);
-                    if (ey > this->Src_Y)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
 #endif
-                        // see reducePixel()
-                        ey = this->Src_Y;
-                    }
-                    byi = OFstatic_cast(int, by);
-                    eyi = OFstatic_cast(int, ey);
-                    if (OFstatic_cast(double, eyi) == ey)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
+                    // see reduceRows()
+                    ex = this->Src_X;
+                }
+                bxi = OFstatic_cast(int, bx);
+                exi = OFstatic_cast(int, ex);
+                if (OFstatic_cast(double, exi) == ex)
+                {
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
 #endif
-                        --eyi;
-                    }
-                    y_part = OFstatic_cast(double, eyi) / y_factor;
-                    b_factor = y_part - OFstatic_cast(double, y);
-                    t_factor = (OFstatic_cast(double, y) + 1.0) - y_part;
-                    for (x = 0; x < this->Dest_X; ++x)
+                    --exi;
+                }
+                x_part = OFstatic_cast(double, exi) / x_factor;
+                l_factor = x_part - OFstatic_cast(double, x);
+                r_factor = (OFstatic_cast(double, x) + 1.0) - x_part;
+                offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
+                for (yi = byi; yi <= eyi; ++yi)
+                {
+                    p = sp + offset + bxi;
+                    for (xi = bxi; xi <= exi; ++xi)
                     {
-                        value = 0;
-                        bx = x_factor * OFstatic_cast(double, x);
-                        ex = x_factor * (OFstatic_cast(double, x) + 1.0);
-                        if (ex > this->Src_X)
+                        sum = OFstatic_cast(double, *(p++));
+                        if (bxi != exi)
                         {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
-#endif
-                            // see reducePixel()
-                            ex = this->Src_X;
+                            if (xi == bxi)
+                                sum *= l_factor;
+                            else
+                                sum *= r_factor;
                         }
-                        bxi = OFstatic_cast(int, bx);
-                        exi = OFstatic_cast(int, ex);
-                        if (OFstatic_cast(double, exi) == ex)
+                        if (byi != eyi)
                         {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
-#endif
-                            --exi;
-                        }
-                        x_part = OFstatic_cast(double, exi) / x_factor;
-                        l_factor = x_part - OFstatic_cast(double, x);
-                        r_factor = (OFstatic_cast(double, x) + 1.0) - x_part;
-                        offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
-                        for (yi = byi; yi <= eyi; ++yi)
-                        {
-                            p = sp + offset + bxi;
-                            for (xi = bxi; xi <= exi; ++xi)
-                            {
-                                sum = OFstatic_cast(double, *(p++));
-                                if (bxi != exi)
-                                {
-                                    if (xi == bxi)
-                                        sum *= l_factor;
-                                    else
-                                        sum *= r_factor;
-                                }
-                                if (byi != eyi)
-                                {
-                                    if (yi == byi)
-                                        sum *= b_factor;
-                                    else
-                                        sum *= t_factor;
-                                }
-                                value += sum;
-                            }
-                            offset += Columns;
+                            if (yi == byi)
+                                sum *= b_factor;
+                            else
+                                sum *= t_factor;
                         }
-                        *(q++) = OFstatic_cast(T, value + 0.5);
+                        value += sum;
                     }
+                    offset += Columns;
                 }
-                sp += f_size;
+                *(q++) = OFstatic_cast(T, value + 0.5);
             }
         }
     }
@@ -815,11 +964,26 @@ class DiScaleTemplate
                      T *dest[])
     {
         DCMIMGLE_DEBUG("using reduce pixel scaling algorithm with interpolation from c't magazine");
+        runBandTask(src, dest, &DiScaleTemplate<T>::reduceRows, OFTrue /*splitRows*/);
+    }
+
+    /** reduce a band of rows of a single frame with interpolation (see reducePixel())
+     *
+     ** @param  src       pointer to source pixels of the frame
+     *  @param  dest      pointer to destination pixels of the frame
+     *  @param  firstRow  index of the first destination row to be processed
+     *  @param  rowCount  number of destination rows to be processed
+     */
+    void reduceRows(const T *src,
+                    T *dest,
+                    const Uint16 firstRow,
+                    const Uint16 rowCount)
+    {
         const double x_factor = OFstatic_cast(double, this->Src_X) / OFstatic_cast(double, this->Dest_X);
         const double y_factor = OFstatic_cast(double, this->Src_Y) / OFstatic_cast(double, this->Dest_Y);
         const double xy_factor = x_factor * y_factor;
-        const unsigned long f_size = OFstatic_cast(unsigned long, Rows) * OFstatic_cast(unsigned long, Columns);
-        const T *sp;
+        const T *sp = src + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
+        const Uint16 lastRow = firstRow + rowCount;
         double bx, ex;
         double by, ey;
         int bxi, exi;
@@ -833,7 +997,7 @@ class DiScaleTemplate
         Uint16 x;
         Uint16 y;
         const T *p;
-        T *q;
+        T *q = dest + OFstatic_cast(unsigned long, firstRow) * OFstatic_cast(unsigned long, this->Dest_X);
 
         /*
          *   based on scaling algorithm from "c't - Magazin fuer Computertechnik" (c't 11/94)
@@ -841,84 +1005,75 @@ class DiScaleTemplate
          *    various bit depths, multi-frame and multi-plane/color images, combined clipping/scaling)
          */
 
-        for (int j = 0; j < this->Planes; ++j)
+        for (y = firstRow; y < lastRow; ++y)
         {
-            sp = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-            q = dest[j];
-            for (unsigned long f = 0; f < this->Frames; ++f)
+            by = y_factor * OFstatic_cast(double, y);
+            ey = y_factor * (OFstatic_cast(double, y) + 1.0);
+            if (ey > this->Src_Y)
             {
-                for (y = 0; y < this->Dest_Y; ++y)
-                {
-                    by = y_factor * OFstatic_cast(double, y);
-                    ey = y_factor * (OFstatic_cast(double, y) + 1.0);
-                    if (ey > this->Src_Y)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  limiting value of 'ey' to 'Src_Y': " << ey << " -> " << this->Src_Y);
 #endif
-                        // yes, this can happen due to rounding, e.g. double(943) / double(471) * double(471)
-                        // is something like 943.00000000000011368683772161602974 and then, the eyi == ey check
-                        // fails to bring eyi back into range!
-                        ey = this->Src_Y;
-                    }
-                    byi = OFstatic_cast(int, by);
-                    eyi = OFstatic_cast(int, ey);
-                    if (OFstatic_cast(double, eyi) == ey)
-                    {
-#ifdef DEBUG            // this output is only useful for debugging purposes
-                        DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
+                // yes, this can happen due to rounding, e.g. double(943) / double(471) * double(471)
+                // is something like 943.00000000000011368683772161602974 and then, the eyi == ey check
+                // fails to bring eyi back into range!
+                ey = this->Src_Y;
+            }
+            byi = OFstatic_cast(int, by);
+            eyi = OFstatic_cast(int, ey);
+            if (OFstatic_cast(double, eyi) == ey)
+            {
+#ifdef DEBUG    // this output is only useful for debugging purposes
+                DCMIMGLE_TRACE("  decreasing value of 'eyi' by 1: " << eyi << " -> " << (eyi - 1));
 #endif
-                        --eyi;
-                    }
-                    b_factor = 1 + OFstatic_cast(double, byi) - by;
-                    t_factor = ey - OFstatic_cast(double, eyi);
-                    for (x = 0; x < this->Dest_X; ++x)
-                    {
-                        value = 0;
-                        bx = x_factor * OFstatic_cast(double, x);
-                        ex = x_factor * (OFstatic_cast(double, x) + 1.0);
-                        if (ex > this->Src_X)
-                        {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
+                --eyi;
+            }
+            b_factor = 1 + OFstatic_cast(double, byi) - by;
+            t_factor = ey - OFstatic_cast(double, eyi);
+            for (x = 0; x < this->Dest_X; ++x)
+            {
+                value = 0;
+                bx = x_factor * OFstatic_cast(double, x);
+                ex = x_factor * (OFstatic_cast(double, x) + 1.0);
+                if (ex > this->Src_X)
+                {
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  limiting value of 'ex' to 'Src_X': " << ex << " -> " << this->Src_X);
 #endif
-                            // see above comment
-                            ex = this->Src_X;
-                        }
-                        bxi = OFstatic_cast(int, bx);
-                        exi = OFstatic_cast(int, ex);
-                        if (OFstatic_cast(double, exi) == ex)
-                        {
-#ifdef DEBUG                // this output is only useful for debugging purposes
-                            DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
+                    // see above comment
+                    ex = this->Src_X;
+                }
+                bxi = OFstatic_cast(int, bx);
+                exi = OFstatic_cast(int, ex);
+                if (OFstatic_cast(double, exi) == ex)
+                {
+#ifdef DEBUG        // this output is only useful for debugging purposes
+                    DCMIMGLE_TRACE("  decreasing value of 'exi' by 1: " << exi << " -> " << (exi - 1));
 #endif
-                            --exi;
-                        }
-                        l_factor = 1 + OFstatic_cast(double, bxi) - bx;
-                        r_factor = ex - OFstatic_cast(double, exi);
-                        offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
-                        for (yi = byi; yi <= eyi; ++yi)
-                        {
-                            p = sp + offset + bxi;
-                            for (xi = bxi; xi <= exi; ++xi)
-                            {
-                                sum = OFstatic_cast(double, *(p++)) / xy_factor;
-                                if (xi == bxi)
-                                    sum *= l_factor;
-                                else if (xi == exi)
-                                    sum *= r_factor;
-                                if (yi == byi)
-                                    sum *= b_factor;
-                                else if (yi == eyi)
-                                    sum *= t_factor;
-                                value += sum;
-                            }
-                            offset += Columns;
-                        }
-                        *(q++) = OFstatic_cast(T, value + 0.5);
+                    --exi;
+                }
+                l_factor = 1 + OFstatic_cast(double, bxi) - bx;
+                r_factor = ex - OFstatic_cast(double, exi);
+                offset = OFstatic_cast(unsigned long, byi) * OFstatic_cast(unsigned long, Columns);
+                for (yi = byi; yi <= eyi; ++yi)
+                {
+                    p = sp + offset + bxi;
+                    for (xi = bxi; xi <= exi; ++xi)
+                    {
+                        sum = OFstatic_cast(double, *(p++)) / xy_factor;
+                        if (xi == bxi)
+                            sum *= l_factor;
+                        else if (xi == exi)
+                            sum *= r_factor;
+                        if (yi == byi)
+                            sum *= b_factor;
+                        else if (yi == eyi)
+                            sum *= t_factor;
+                        value += sum;
                     }
+                    offset += Columns;
                 }
-                sp += f_size;
+                *(q++) = OFstatic_cast(T, value + 0.5);
             }
         }
     }
@@ -932,27 +1087,43 @@ class DiScaleTemplate
                        T *dest[])
     {
         DCMIMGLE_DEBUG("using magnification algorithm with bilinear interpolation contributed by Eduard Stanescu");
+        runBandTask(src, dest, &DiScaleTemplate<T>::bilinearRows, OFFalse /*splitRows*/);
+    }
+
+   /** bilinear interpolation of a single frame (see bilinearPixel()).
+    *  The frame is always processed as a whole.
+    *
+    ** @param  src       pointer to source pixels of the frame
+    *  @param  dest      pointer to destination pixels of the frame
+    *  @param  firstRow  index of the first destination row to be processed (not used)
+    *  @param  rowCount  number of destination rows to be processed (not used)
+    */
+    void bilinearRows(const T *src,
+                      T *dest,
+                      const Uint16 /* firstRow */,
+                      const Uint16 /* rowCount */)
+    {
         const double x_factor = OFstatic_cast(double, this->Src_X) / OFstatic_cast(double, this->Dest_X);
         const double y_factor = OFstatic_cast(double, this->Src_Y) / OFstatic_cast(double, this->Dest_Y);
-        const unsigned long f_size = OFstatic_cast(unsigned long, Rows) * OFstatic_cast(unsigned long, Columns);
         const unsigned long l_offset = OFstatic_cast(unsigned long, this->Src_Y - 1) * OFstatic_cast(unsigned long, this->Dest_X);
+        const int useSIMD = DiSIMDTemplate<T, T>::isSupported();
         Uint16 x;
         Uint16 y;
-        T *pD;
+        T *pD = dest;
         T *pCurrTemp;
         const T *pCurrSrc;
         Uint16 nSrcIndex;
         double dOff;
         T *pT;
         const T *pS;
-        const T *pF;
+        const T *pF = src + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
 
         // buffer used for storing temporarily the interpolated lines
         T *pTemp = new T[OFstatic_cast(unsigned long, this->Src_Y) * OFstatic_cast(unsigned long, this->Dest_X)];
         if (pTemp == NULL)
         {
             DCMIMGLE_ERROR("can't allocate temporary buffer for interpolation scaling");
-            this->clearPixel(dest);
+            OFBitmanipTemplate<T>::zeroMem(dest, OFstatic_cast(unsigned long, this->Dest_X) * OFstatic_cast(unsigned long, this->Dest_Y));
         } else {
 
             /*
@@ -961,90 +1132,87 @@ class DiScaleTemplate
              *    various bit depths, multi-frame multi-plane/color images, combined clipping/scaling)
              */
 
-            for (int j = 0; j < this->Planes; ++j)
+            pT = pCurrTemp = pTemp;
+            pS = pCurrSrc = pF;
+            // first, interpolate the columns:
+            // column 0, just copy the source data column 0
+            for (y = this->Src_Y; y != 0; --y)
             {
-                pF = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-                pD = dest[j];
-                for (unsigned long f = this->Frames; f != 0; --f)
+                *(pCurrTemp) = *(pCurrSrc);
+                pCurrSrc += Columns;
+                pCurrTemp += this->Dest_X;
+            }
+            pCurrSrc = pS;
+            nSrcIndex = 0;
+            // column 1 to column Dest_X - 1
+            for (x = 1; x < this->Dest_X - 1; ++x)
+            {
+                pCurrTemp = ++pT;
+                dOff = x * x_factor - nSrcIndex;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                for (y = 0; y < this->Src_Y; ++y)
                 {
-                    pT = pCurrTemp = pTemp;
-                    pS = pCurrSrc = pF;
-                    // first, interpolate the columns:
-                    // column 0, just copy the source data column 0
-                    for (y = this->Src_Y; y != 0; --y)
-                    {
-                        *(pCurrTemp) = *(pCurrSrc);
-                        pCurrSrc += Columns;
-                        pCurrTemp += this->Dest_X;
-                    }
-                    pCurrSrc = pS;
-                    nSrcIndex = 0;
-                    // column 1 to column Dest_X - 1
-                    for (x = 1; x < this->Dest_X - 1; ++x)
-                    {
-                        pCurrTemp = ++pT;
-                        dOff = x * x_factor - nSrcIndex;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (y = 0; y < this->Src_Y; ++y)
-                        {
-                            // use floating points in order to avoid possible integer overflow
-                            const double v1 = OFstatic_cast(double, *(pCurrSrc));
-                            const double v2 = OFstatic_cast(double, *(pCurrSrc + 1));
-                            *(pCurrTemp) = OFstatic_cast(T, v1 + (v2 - v1) * dOff);
-                            pCurrSrc += Columns;
-                            pCurrTemp += this->Dest_X;
-                        }
-                        // don't go beyond the source data
-                        if ((nSrcIndex < this->Src_X - 2) &&  (x * x_factor >= nSrcIndex + 1))
-                        {
-                            pS++;
-                            nSrcIndex++;
-                        }
-                        pCurrSrc = pS;
-                    }
-                    pCurrTemp = ++pT;
-                    // last column, just copy the source data column Src_X
-                    for (y = this->Src_Y; y != 0; --y)
-                    {
-                        *(pCurrTemp) = *(pCurrSrc);
-                        pCurrSrc += Columns;
-                        pCurrTemp += this->Dest_X;
-                    }
-                    // now the columns are interpolated in temp buffer, so interpolate the lines
-                    pT = pCurrTemp = pTemp;
-                    // line 0, just copy the temp buffer line 0
+                    // use floating points in order to avoid possible integer overflow
+                    const double v1 = OFstatic_cast(double, *(pCurrSrc));
+                    const double v2 = OFstatic_cast(double, *(pCurrSrc + 1));
+                    *(pCurrTemp) = OFstatic_cast(T, v1 + (v2 - v1) * dOff);
+                    pCurrSrc += Columns;
+                    pCurrTemp += this->Dest_X;
+                }
+                // don't go beyond the source data
+                if ((nSrcIndex < this->Src_X - 2) &&  (x * x_factor >= nSrcIndex + 1))
+                {
+                    pS++;
+                    nSrcIndex++;
+                }
+                pCurrSrc = pS;
+            }
+            pCurrTemp = ++pT;
+            // last column, just copy the source data column Src_X
+            for (y = this->Src_Y; y != 0; --y)
+            {
+                *(pCurrTemp) = *(pCurrSrc);
+                pCurrSrc += Columns;
+                pCurrTemp += this->Dest_X;
+            }
+            // now the columns are interpolated in temp buffer, so interpolate the lines
+            pT = pCurrTemp = pTemp;
+            // line 0, just copy the temp buffer line 0
+            for (x = this->Dest_X; x != 0; --x)
+               *(pD++) = *(pCurrTemp++);
+            nSrcIndex = 0;
+            pCurrTemp = pTemp;
+            for (y = 1; y < this->Dest_Y - 1; ++y)
+            {
+                dOff = y * y_factor - nSrcIndex;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                if (useSIMD)
+                {
+                    // the lines are contiguous in memory, so use the vectorized kernel
+                    DiSIMDTemplate<T, T>::interpolate(pCurrTemp, pCurrTemp + this->Dest_X, pD, this->Dest_X, dOff);
+                    pD += this->Dest_X;
+                } else {
                     for (x = this->Dest_X; x != 0; --x)
-                       *(pD++) = *(pCurrTemp++);
-                    nSrcIndex = 0;
-                    pCurrTemp = pTemp;
-                    for (y = 1; y < this->Dest_Y - 1; ++y)
                     {
-                        dOff = y * y_factor - nSrcIndex;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (x = this->Dest_X; x != 0; --x)
-                        {
-                            // use floating points in order to avoid possible integer overflow
-                            const double v1 = OFstatic_cast(double, *(pCurrTemp));
-                            const double v2 = OFstatic_cast(double, *(pCurrTemp + this->Dest_X));
-                            *(pD++) = OFstatic_cast(T, v1 + (v2 - v1) * dOff);
-                            pCurrTemp++;
-                        }
-                        // don't go beyond the source data
-                        if ((nSrcIndex < this->Src_Y - 2) && (y * y_factor >= nSrcIndex + 1))
-                        {
-                            pT += this->Dest_X;
-                            nSrcIndex++;
-                        }
-                        pCurrTemp = pT;
+                        // use floating points in order to avoid possible integer overflow
+                        const double v1 = OFstatic_cast(double, *(pCurrTemp));
+                        const double v2 = OFstatic_cast(double, *(pCurrTemp + this->Dest_X));
+                        *(pD++) = OFstatic_cast(T, v1 + (v2 - v1) * dOff);
+                        pCurrTemp++;
                     }
-                    // the last line, just copy the temp buffer line Src_X
-                    pCurrTemp = pTemp + l_offset;
-                    for (x = this->Dest_X; x != 0; --x)
-                        *(pD++) = *(pCurrTemp++);
-                    // skip to next frame
-                    pF += f_size;
                 }
+                // don't go beyond the source data
+                if ((nSrcIndex < this->Src_Y - 2) && (y * y_factor >= nSrcIndex + 1))
+                {
+                    pT += this->Dest_X;
+                    nSrcIndex++;
+                }
+                pCurrTemp = pT;
             }
+            // the last line, just copy the temp buffer line Src_X
+            pCurrTemp = pTemp + l_offset;
+            for (x = this->Dest_X; x != 0; --x)
+                *(pD++) = *(pCurrTemp++);
         }
         delete[] pTemp;
     }
@@ -1058,31 +1226,46 @@ class DiScaleTemplate
                       T *dest[])
     {
         DCMIMGLE_DEBUG("using magnification algorithm with bicubic interpolation contributed by Eduard Stanescu");
+        runBandTask(src, dest, &DiScaleTemplate<T>::bicubicRows, OFFalse /*splitRows*/);
+    }
+
+   /** bicubic interpolation of a single frame (see bicubicPixel()).
+    *  The frame is always processed as a whole.
+    *
+    ** @param  src       pointer to source pixels of the frame
+    *  @param  dest      pointer to destination pixels of the frame
+    *  @param  firstRow  index of the first destination row to be processed (not used)
+    *  @param  rowCount  number of destination rows to be processed (not used)
+    */
+    void bicubicRows(const T *src,
+                     T *dest,
+                     const Uint16 /* firstRow */,
+                     const Uint16 /* rowCount */)
+    {
         const double minVal = (isSigned()) ? -OFstatic_cast(double, DicomImageClass::maxval(this->Bits - 1, 0)) : 0.0;
         const double maxVal = OFstatic_cast(double, DicomImageClass::maxval(this->Bits - isSigned()));
         const double x_factor = OFstatic_cast(double, this->Src_X) / OFstatic_cast(double, this->Dest_X);
         const double y_factor = OFstatic_cast(double, this->Src_Y) / OFstatic_cast(double, this->Dest_Y);
         const Uint16 xDelta = OFstatic_cast(Uint16, 1 / x_factor);
         const Uint16 yDelta = OFstatic_cast(Uint16, 1 / y_factor);
-        const unsigned long f_size = OFstatic_cast(unsigned long, Rows) * OFstatic_cast(unsigned long, Columns);
         const unsigned long l_offset = OFstatic_cast(unsigned long, this->Src_Y - 1) * OFstatic_cast(unsigned long, this->Dest_X);
         Uint16 x;
         Uint16 y;
-        T *pD;
+        T *pD = dest;
         T *pCurrTemp;
         const T *pCurrSrc;
         Uint16 nSrcIndex;
         double dOff;
         T *pT;
         const T *pS;
-        const T *pF;
+        const T *pF = src + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
 
         // buffer used for storing temporarily the interpolated lines
         T *pTemp = pT = pCurrTemp = new T[OFstatic_cast(unsigned long, this->Src_Y) * OFstatic_cast(unsigned long, this->Dest_X)];
         if (pTemp == NULL)
         {
             DCMIMGLE_ERROR("can't allocate temporary buffer for interpolation scaling");
-            this->clearPixel(dest);
+            OFBitmanipTemplate<T>::zeroMem(dest, OFstatic_cast(unsigned long, this->Dest_X) * OFstatic_cast(unsigned long, this->Dest_Y));
         } else {
 
             /*
@@ -1091,146 +1274,136 @@ class DiScaleTemplate
              *    various bit depths, multi-frame multi-plane/color images, combined clipping/scaling)
              */
 
-            for (int j = 0; j < this->Planes; ++j)
+            pT = pCurrTemp = pTemp;
+            pS = pCurrSrc = pF;
+            // first, interpolate the columns:
+            // column 0, just copy the source data column 0
+            for (y = this->Src_Y; y != 0; --y)
+            {
+                *(pCurrTemp) = *(pCurrSrc);
+                pCurrSrc += Columns;
+                pCurrTemp += this->Dest_X;
+            }
+            pCurrSrc = pS;
+            // for the next few columns, linear interpolation
+            for (x = 1; x < xDelta + 1; ++x)
             {
-                pF = src[j] + OFstatic_cast(unsigned long, Top) * OFstatic_cast(unsigned long, Columns) + Left;
-                pD = dest[j];
-                for (unsigned long f = this->Frames; f != 0; --f)
+                pCurrSrc = pS;
+                pCurrTemp = ++pT;
+                dOff = x * x_factor;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                for (y = this->Src_Y; y != 0; --y)
                 {
-                    pT = pCurrTemp = pTemp;
-                    pS = pCurrSrc = pF;
-                    // first, interpolate the columns:
-                    // column 0, just copy the source data column 0
-                    for (y = this->Src_Y; y != 0; --y)
-                    {
-                        *(pCurrTemp) = *(pCurrSrc);
-                        pCurrSrc += Columns;
-                        pCurrTemp += this->Dest_X;
-                    }
-                    pCurrSrc = pS;
-                    // for the next few columns, linear interpolation
-                    for (x = 1; x < xDelta + 1; ++x)
-                    {
-                        pCurrSrc = pS;
-                        pCurrTemp = ++pT;
-                        dOff = x * x_factor;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (y = this->Src_Y; y != 0; --y)
-                        {
-                            *(pCurrTemp) = OFstatic_cast(T, *(pCurrSrc) + (*(pCurrSrc + 1) - *(pCurrSrc)) * dOff);
-                            pCurrSrc += Columns;
-                            pCurrTemp += this->Dest_X;
-                        }
-                    }
-                    nSrcIndex = 1;
-                    pCurrSrc = ++pS;
-                    // the majority of the columns
-                    for (x = xDelta + 1; x < this->Dest_X - 2 * xDelta; ++x)
-                    {
-                        pCurrTemp = ++pT;
-                        dOff = x * x_factor - nSrcIndex;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (y = this->Src_Y; y != 0; --y)
-                        {
-                            *(pCurrTemp) = OFstatic_cast(T, cubicValue(*(pCurrSrc - 1), *(pCurrSrc), *(pCurrSrc + 1), *(pCurrSrc + 2), dOff, minVal, maxVal));
-                            pCurrSrc += Columns;
-                            pCurrTemp += this->Dest_X;
-                        }
-                        // don't go beyond the source data
-                        if ((nSrcIndex < this->Src_X - 3) && (x * x_factor >= nSrcIndex + 1))
-                        {
-                            pS++;
-                            nSrcIndex++;
-                        }
-                        pCurrSrc = pS;
-                    }
-                    // last few columns except the very last one, linear interpolation
-                    for (x = this->Dest_X - 2 * xDelta; x < this->Dest_X - 1; ++x)
-                    {
-                        pCurrTemp = ++pT;
-                        dOff = x * x_factor - nSrcIndex;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (y = this->Src_Y; y != 0; --y)
-                        {
-                            *(pCurrTemp) = OFstatic_cast(T, *(pCurrSrc) + (*(pCurrSrc + 1) - *(pCurrSrc)) * dOff);
-                            pCurrSrc += Columns;
-                            pCurrTemp += this->Dest_X;
-                        }
-                        // don't go beyond the source data
-                        if ((nSrcIndex < this->Src_X - 2) && (x * x_factor >= nSrcIndex + 1))
-                        {
-                            pS++;
-                            nSrcIndex++;
-                        }
-                        pCurrSrc = pS;
-                    }
-                    // last column, just copy the source data column Src_X
-                    pCurrTemp = pTemp + this->Dest_X - 1;
-                    pCurrSrc = pF + this->Src_X - 1;
-                    for (y = this->Src_Y; y != 0; --y)
-                    {
-                        *(pCurrTemp) = *(pCurrSrc);
-                        pCurrSrc += Columns;
-                        pCurrTemp += this->Dest_X;
-                    }
-                    // now the columns are interpolated in temp buffer, so interpolate the lines
-                    pT = pCurrTemp = pTemp;
-                    // line 0, just copy the temp buffer line 0
-                    for (x = this->Dest_X; x != 0; --x)
-                        *(pD++) = *(pCurrTemp++);
-                    // for the next few lines, linear interpolation between line 0 and 1 of the temp buffer
-                    for (y = 1; y < yDelta + 1; ++y)
-                    {
-                        pCurrTemp = pTemp;
-                        dOff = y * y_factor;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (x = this->Dest_X; x != 0; --x)
-                        {
-                            *(pD++) = OFstatic_cast(T, *(pCurrTemp) + (*(pCurrTemp + this->Dest_X) - *(pCurrTemp)) * dOff);
-                            pCurrTemp++;
-                        }
-                    }
-                    nSrcIndex = 1;
-                    pCurrTemp = pT = pTemp + this->Dest_X;
-                    for (y = yDelta + 1; y < this->Dest_Y - yDelta - 1; ++y)
-                    {
-                        dOff = y * y_factor - nSrcIndex;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (x = this->Dest_X; x != 0; --x)
-                        {
-                            *(pD++) = OFstatic_cast(T, cubicValue(*(pCurrTemp - this->Dest_X),*(pCurrTemp), *(pCurrTemp + this->Dest_X),
-                                                                  *(pCurrTemp + this->Dest_X + this->Dest_X), dOff, minVal, maxVal));
-                            pCurrTemp++;
-                        }
-                        // don't go beyond the source data
-                        if ((nSrcIndex < this->Src_Y - 3) && (y * y_factor >= nSrcIndex + 1))
-                        {
-                            pT += this->Dest_X;
-                            nSrcIndex++;
-                        }
-                        pCurrTemp = pT;
-                    }
-                    // the last few lines except the very last one, linear interpolation in between the second last and the last lines
-                    pCurrTemp = pT = pTemp + OFstatic_cast(unsigned long, this->Src_Y - 2) * OFstatic_cast(unsigned long, this->Dest_X);
-                    for (y = this->Dest_Y - yDelta - 1; y < this->Dest_Y - 1; ++y)
-                    {
-                        dOff = y * y_factor - nSrcIndex;
-                        dOff = (1.0 < dOff) ? 1.0 : dOff;
-                        for (x = this->Dest_X; x != 0; --x)
-                        {
-                            *(pD++) = OFstatic_cast(T, *(pCurrTemp) + (*(pCurrTemp + this->Dest_X) - *(pCurrTemp)) * dOff);
-                            pCurrTemp++;
-                        }
-                        pCurrTemp = pT;
-                    }
-                    // the the last line, just copy the temp buffer line Src_X
-                    pCurrTemp = pTemp + l_offset;
-                    for (x = this->Dest_X; x != 0; --x)
-                        *(pD++) = *(pCurrTemp++);
-                    // skip to next frame
-                    pF += f_size;
+                    *(pCurrTemp) = OFstatic_cast(T, *(pCurrSrc) + (*(pCurrSrc + 1) - *(pCurrSrc)) * dOff);
+                    pCurrSrc += Columns;
+                    pCurrTemp += this->Dest_X;
+                }
+            }
+            nSrcIndex = 1;
+            pCurrSrc = ++pS;
+            // the majority of the columns
+            for (x = xDelta + 1; x < this->Dest_X - 2 * xDelta; ++x)
+            {
+                pCurrTemp = ++pT;
+                dOff = x * x_factor - nSrcIndex;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                for (y = this->Src_Y; y != 0; --y)
+                {
+                    *(pCurrTemp) = OFstatic_cast(T, cubicValue(*(pCurrSrc - 1), *(pCurrSrc), *(pCurrSrc + 1), *(pCurrSrc + 2), dOff, minVal, maxVal));
+                    pCurrSrc += Columns;
+                    pCurrTemp += this->Dest_X;
+                }
+                // don't go beyond the source data
+                if ((nSrcIndex < this->Src_X - 3) && (x * x_factor >= nSrcIndex + 1))
+                {
+                    pS++;
+                    nSrcIndex++;
+                }
+                pCurrSrc = pS;
+            }
+            // last few columns except the very last one, linear interpolation
+            for (x = this->Dest_X - 2 * xDelta; x < this->Dest_X - 1; ++x)
+            {
+                pCurrTemp = ++pT;
+                dOff = x * x_factor - nSrcIndex;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                for (y = this->Src_Y; y != 0; --y)
+                {
+                    *(pCurrTemp) = OFstatic_cast(T, *(pCurrSrc) + (*(pCurrSrc + 1) - *(pCurrSrc)) * dOff);
+                    pCurrSrc += Columns;
+                    pCurrTemp += this->Dest_X;
+                }
+                // don't go beyond the source data
+                if ((nSrcIndex < this->Src_X - 2) && (x * x_factor >= nSrcIndex + 1))
+                {
+                    pS++;
+                    nSrcIndex++;
+                }
+                pCurrSrc = pS;
+            }
+            // last column, just copy the source data column Src_X
+            pCurrTemp = pTemp + this->Dest_X - 1;
+            pCurrSrc = pF + this->Src_X - 1;
+            for (y = this->Src_Y; y != 0; --y)
+            {
+                *(pCurrTemp) = *(pCurrSrc);
+                pCurrSrc += Columns;
+                pCurrTemp += this->Dest_X;
+            }
+            // now the columns are interpolated in temp buffer, so interpolate the lines
+            pT = pCurrTemp = pTemp;
+            // line 0, just copy the temp buffer line 0
+            for (x = this->Dest_X; x != 0; --x)
+                *(pD++) = *(pCurrTemp++);
+            // for the next few lines, linear interpolation between line 0 and 1 of the temp buffer
+            for (y = 1; y < yDelta + 1; ++y)
+            {
+                pCurrTemp = pTemp;
+                dOff = y * y_factor;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                for (x = this->Dest_X; x != 0; --x)
+                {
+                    *(pD++) = OFstatic_cast(T, *(pCurrTemp) + (*(pCurrTemp + this->Dest_X) - *(pCurrTemp)) * dOff);
+                    pCurrTemp++;
+                }
+            }
+            nSrcIndex = 1;
+            pCurrTemp = pT = pTemp + this->Dest_X;
+            for (y = yDelta + 1; y < this->Dest_Y - yDelta - 1; ++y)
+            {
+                dOff = y * y_factor - nSrcIndex;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                for (x = this->Dest_X; x != 0; --x)
+                {
+                    *(pD++) = OFstatic_cast(T, cubicValue(*(pCurrTemp - this->Dest_X),*(pCurrTemp), *(pCurrTemp + this->Dest_X),
+                                                          *(pCurrTemp + this->Dest_X + this->Dest_X), dOff, minVal, maxVal));
+                    pCurrTemp++;
+                }
+                // don't go beyond the source data
+                if ((nSrcIndex < this->Src_Y - 3) && (y * y_factor >= nSrcIndex + 1))
+                {
+                    pT += this->Dest_X;
+                    nSrcIndex++;
+                }
+                pCurrTemp = pT;
+            }
+            // the last few lines except the very last one, linear interpolation in between the second last and the last lines
+            pCurrTemp = pT = pTemp + OFstatic_cast(unsigned long, this->Src_Y - 2) * OFstatic_cast(unsigned long, this->Dest_X);
+            for (y = this->Dest_Y - yDelta - 1; y < this->Dest_Y - 1; ++y)
+            {
+                dOff = y * y_factor - nSrcIndex;
+                dOff = (1.0 < dOff) ? 1.0 : dOff;
+                for (x = this->Dest_X; x != 0; --x)
+                {
+                    *(pD++) = OFstatic_cast(T, *(pCurrTemp) + (*(pCurrTemp + this->Dest_X) - *(pCurrTemp)) * dOff);
+                    pCurrTemp++;
                 }
+                pCurrTemp = pT;
             }
+            // the the last line, just copy the temp buffer line Src_X
+            pCurrTemp = pTemp + l_offset;
+            for (x = this->Dest_X; x != 0; --x)
+                *(pD++) = *(pCurrTemp++);
         }
         delete[] pTemp;
     }
@@ -0,0 +1,158 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: DicomSIMDKernels (Header)
+ *
+ */
+
+
+#ifndef DISIMD_H
+#define DISIMD_H
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/ofstd/oftypes.h"
+
+#include "dcmtk/dcmimgle/didefine.h"
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Class providing vectorized implementations of the arithmetic pixel transformations.
+ *  The instruction set is selected at runtime depending on the capabilities of the CPU.
+ *  All kernels use the same double precision operations (in the same order) as the
+ *  scalar pixel templates, so the results are bit-identical to the scalar code.
+ *  If no suitable instruction set is available (e.g. on non-x86-64 systems), a scalar
+ *  implementation is used.
+ */
+class DCMTK_DCMIMGLE_EXPORT DiSIMDKernels
+{
+
+ public:
+
+    /** instruction sets supported by the kernels
+     */
+    enum E_InstructionSet
+    {
+        /// no vector instructions, use scalar code
+        IS_None,
+        /// SSE2 (x86-64 only)
+        IS_SSE2,
+        /// AVX2 (x86-64 only)
+        IS_AVX2
+    };
+
+    /** number of values processed by a single call of a kernel (recommended maximum)
+     */
+    enum { BlockSize = 1024 };
+
+    /** get instruction set currently used by the kernels
+     *
+     ** @return instruction set currently used
+     */
+    static E_InstructionSet getInstructionSet();
+
+    /** get best instruction set supported by the CPU
+     *
+     ** @return best instruction set supported
+     */
+    static E_InstructionSet getSupportedInstructionSet();
+
+    /** select instruction set used by the kernels.
+     *  If the given instruction set is not supported by the CPU, the best supported one
+     *  is used instead.  This method is mainly intended for testing purposes and should
+     *  not be called while images are processed.
+     *
+     ** @param  set  instruction set to be used (IS_None for scalar code)
+     */
+    static void setInstructionSet(const E_InstructionSet set);
+
+    /** get name of the given instruction set
+     *
+     ** @param  set  instruction set
+     *
+     ** @return name of the instruction set, e.g. "SSE2"
+     */
+    static const char *getInstructionSetName(const E_InstructionSet set);
+
+    /** perform linear transformation (e.g. modality rescale).
+     *  Computes dest[i] = (Sint32)(src[i] * slope + intercept), where the conversion to
+     *  integer truncates towards zero.  The results have to fit into a 32 bit signed integer.
+     *
+     ** @param  src        array of input values
+     *  @param  dest       array of output values (may be the same as 'src')
+     *  @param  count      number of values to be processed
+     *  @param  slope      slope of the linear function
+     *  @param  intercept  intercept of the linear function
+     */
+    static void rescale(const Sint32 *src,
+                        Sint32 *dest,
+                        const size_t count,
+                        const double slope,
+                        const double intercept);
+
+    /** perform linear VOI windowing.
+     *  Computes dest[i] = low if src[i] <= leftBorder, high if src[i] > rightBorder and
+     *  (Sint32)(offset + src[i] * gradient) otherwise, where the conversion to integer
+     *  truncates towards zero.  The results have to fit into a 32 bit signed integer.
+     *
+     ** @param  src          array of input values
+     *  @param  dest         array of output values (may be the same as 'src')
+     *  @param  count        number of values to be processed
+     *  @param  leftBorder   left border of the window
+     *  @param  rightBorder  right border of the window
+     *  @param  offset       offset of the linear function
+     *  @param  gradient     gradient of the linear function
+     *  @param  low          output value for input values left of the window
+     *  @param  high         output value for input values right of the window
+     */
+    static void window(const Sint32 *src,
+                       Sint32 *dest,
+                       const size_t count,
+                       const double leftBorder,
+                       const double rightBorder,
+                       const double offset,
+                       const double gradient,
+                       const Sint32 low,
+                       const Sint32 high);
+
+    /** perform linear interpolation between two arrays of values (e.g. two rows of an image).
+     *  Computes dest[i] = (Sint32)(src1[i] + (src2[i] - src1[i]) * factor), where the
+     *  conversion to integer truncates towards zero.
+     *
+     ** @param  src1    first array of input values
+     *  @param  src2    second array of input values
+     *  @param  dest    array of output values (may be the same as 'src1' or 'src2')
+     *  @param  count   number of values to be processed
+     *  @param  factor  interpolation factor (usually in the range 0..1)
+     */
+    static void interpolate(const Sint32 *src1,
+                            const Sint32 *src2,
+                            Sint32 *dest,
+                            const size_t count,
+                            const double factor);
+
+
+ private:
+
+    /// instruction set currently used by the kernels
+    static E_InstructionSet InstructionSet;
+};
+
+
+#endif
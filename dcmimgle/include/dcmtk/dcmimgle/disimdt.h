@@ -0,0 +1,236 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: DicomSIMDTemplate (Header)
+ *
+ */
+
+
+#ifndef DISIMDT_H
+#define DISIMDT_H
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/ofstd/ofcast.h"
+#include "dcmtk/ofstd/oflimits.h"
+
+#include "dcmtk/dcmimgle/disimd.h"
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Template class for applying the vectorized kernels to pixel data of a particular type.
+ *  The pixel values are converted to and from 32 bit signed integers in blocks, so the
+ *  kernels can only be used if both input and output type fit into this representation
+ *  (see isSupported()).
+ */
+template<class T1, class T2>
+class DiSIMDTemplate
+{
+
+ public:
+
+    /** check whether the kernels can be used for the given input and output type
+     *
+     ** @return true if the kernels can be used, false otherwise
+     */
+    static inline int isSupported()
+    {
+        return ((sizeof(T1) < 4) || OFnumeric_limits<T1>::is_signed) &&
+               ((sizeof(T2) < 4) || OFnumeric_limits<T2>::is_signed);
+    }
+
+    /** perform linear transformation of the given pixel data (see DiSIMDKernels::rescale())
+     *
+     ** @param  src        pointer to input pixel data
+     *  @param  dest       pointer to output pixel data
+     *  @param  count      number of pixels to be processed
+     *  @param  slope      slope of the linear function
+     *  @param  intercept  intercept of the linear function
+     */
+    static void rescale(const T1 *src,
+                        T2 *dest,
+                        const unsigned long count,
+                        const double slope,
+                        const double intercept)
+    {
+        Sint32 buffer[DiSIMDKernels::BlockSize];
+        unsigned long i = 0;
+        unsigned long j;
+        unsigned long n;
+        while (i < count)
+        {
+            n = (count - i < OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize)) ? count - i : OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize);
+            for (j = 0; j < n; ++j)
+                buffer[j] = OFstatic_cast(Sint32, *(src++));
+            DiSIMDKernels::rescale(buffer, buffer, n, slope, intercept);
+            for (j = 0; j < n; ++j)
+                *(dest++) = OFstatic_cast(T2, buffer[j]);
+            i += n;
+        }
+    }
+
+    /** perform linear transformation of consecutive pixel values, e.g. to create an
+     *  optimization LUT (see DiSIMDKernels::rescale())
+     *
+     ** @param  first      first pixel value (has to be an integer)
+     *  @param  dest       pointer to output array
+     *  @param  count      number of pixel values to be processed
+     *  @param  slope      slope of the linear function
+     *  @param  intercept  intercept of the linear function
+     */
+    static void rescaleRange(const double first,
+                             T2 *dest,
+                             const unsigned long count,
+                             const double slope,
+                             const double intercept)
+    {
+        Sint32 buffer[DiSIMDKernels::BlockSize];
+        Sint32 value = OFstatic_cast(Sint32, first);
+        unsigned long i = 0;
+        unsigned long j;
+        unsigned long n;
+        while (i < count)
+        {
+            n = (count - i < OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize)) ? count - i : OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize);
+            for (j = 0; j < n; ++j)
+                buffer[j] = value++;
+            DiSIMDKernels::rescale(buffer, buffer, n, slope, intercept);
+            for (j = 0; j < n; ++j)
+                *(dest++) = OFstatic_cast(T2, buffer[j]);
+            i += n;
+        }
+    }
+
+    /** perform linear VOI windowing of the given pixel data (see DiSIMDKernels::window())
+     *
+     ** @param  src          pointer to input pixel data
+     *  @param  dest         pointer to output pixel data
+     *  @param  count        number of pixels to be processed
+     *  @param  leftBorder   left border of the window
+     *  @param  rightBorder  right border of the window
+     *  @param  offset       offset of the linear function
+     *  @param  gradient     gradient of the linear function
+     *  @param  low          output value for input values left of the window
+     *  @param  high         output value for input values right of the window
+     */
+    static void window(const T1 *src,
+                       T2 *dest,
+                       const unsigned long count,
+                       const double leftBorder,
+                       const double rightBorder,
+                       const double offset,
+                       const double gradient,
+                       const T2 low,
+                       const T2 high)
+    {
+        Sint32 buffer[DiSIMDKernels::BlockSize];
+        unsigned long i = 0;
+        unsigned long j;
+        unsigned long n;
+        while (i < count)
+        {
+            n = (count - i < OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize)) ? count - i : OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize);
+            for (j = 0; j < n; ++j)
+                buffer[j] = OFstatic_cast(Sint32, *(src++));
+            DiSIMDKernels::window(buffer, buffer, n, leftBorder, rightBorder, offset, gradient,
+                OFstatic_cast(Sint32, low), OFstatic_cast(Sint32, high));
+            for (j = 0; j < n; ++j)
+                *(dest++) = OFstatic_cast(T2, buffer[j]);
+            i += n;
+        }
+    }
+
+    /** perform linear VOI windowing of consecutive pixel values, e.g. to create an
+     *  optimization LUT (see DiSIMDKernels::window())
+     *
+     ** @param  first        first pixel value (has to be an integer)
+     *  @param  dest         pointer to output array
+     *  @param  count        number of pixel values to be processed
+     *  @param  leftBorder   left border of the window
+     *  @param  rightBorder  right border of the window
+     *  @param  offset       offset of the linear function
+     *  @param  gradient     gradient of the linear function
+     *  @param  low          output value for input values left of the window
+     *  @param  high         output value for input values right of the window
+     */
+    static void windowRange(const double first,
+                            T2 *dest,
+                            const unsigned long count,
+                            const double leftBorder,
+                            const double rightBorder,
+                            const double offset,
+                            const double gradient,
+                            const T2 low,
+                            const T2 high)
+    {
+        Sint32 buffer[DiSIMDKernels::BlockSize];
+        Sint32 value = OFstatic_cast(Sint32, first);
+        unsigned long i = 0;
+        unsigned long j;
+        unsigned long n;
+        while (i < count)
+        {
+            n = (count - i < OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize)) ? count - i : OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize);
+            for (j = 0; j < n; ++j)
+                buffer[j] = value++;
+            DiSIMDKernels::window(buffer, buffer, n, leftBorder, rightBorder, offset, gradient,
+                OFstatic_cast(Sint32, low), OFstatic_cast(Sint32, high));
+            for (j = 0; j < n; ++j)
+                *(dest++) = OFstatic_cast(T2, buffer[j]);
+            i += n;
+        }
+    }
+
+    /** perform linear interpolation between two rows of pixel data (see DiSIMDKernels::interpolate())
+     *
+     ** @param  src1    pointer to first row of input pixel data
+     *  @param  src2    pointer to second row of input pixel data
+     *  @param  dest    pointer to output pixel data
+     *  @param  count   number of pixels to be processed
+     *  @param  factor  interpolation factor
+     */
+    static void interpolate(const T1 *src1,
+                            const T1 *src2,
+                            T2 *dest,
+                            const unsigned long count,
+                            const double factor)
+    {
+        Sint32 buffer1[DiSIMDKernels::BlockSize];
+        Sint32 buffer2[DiSIMDKernels::BlockSize];
+        unsigned long i = 0;
+        unsigned long j;
+        unsigned long n;
+        while (i < count)
+        {
+            n = (count - i < OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize)) ? count - i : OFstatic_cast(unsigned long, DiSIMDKernels::BlockSize);
+            for (j = 0; j < n; ++j)
+            {
+                buffer1[j] = OFstatic_cast(Sint32, *(src1++));
+                buffer2[j] = OFstatic_cast(Sint32, *(src2++));
+            }
+            DiSIMDKernels::interpolate(buffer1, buffer2, buffer1, n, factor);
+            for (j = 0; j < n; ++j)
+                *(dest++) = OFstatic_cast(T2, buffer1[j]);
+            i += n;
+        }
+    }
+};
+
+
+#endif
@@ -0,0 +1,322 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: DicomPixelBandTask, DicomRowBandTask (Header)
+ *
+ */
+
+
+#ifndef DITHREAD_H
+#define DITHREAD_H
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/ofstd/ofthpool.h"
+
+#include "dcmtk/dcmimgle/diutils.h"
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Abstract base class for processing the pixel data of an image in parallel.
+ *  The pixels are divided into bands of consecutive pixels (i.e. rows) that are
+ *  processed independently from each other by the threads of a thread pool, which
+ *  is shared by all tasks of the process and only created once.
+ *  The number of threads is specified globally by DicomImageClass::setNumberOfThreads().
+ *  Small images are always processed sequentially by the calling thread, as well as
+ *  images processed while the thread pool is used by another thread.
+ */
+class DCMTK_DCMIMGLE_EXPORT DiPixelBandTask
+  : protected OFThreadPool::Task
+{
+
+ public:
+
+    /** constructor
+     *
+     ** @param  count  number of pixels to be processed
+     */
+    DiPixelBandTask(const unsigned long count);
+
+    /** destructor
+     */
+    virtual ~DiPixelBandTask();
+
+    /** process all pixels, either sequentially or in parallel
+     */
+    void run();
+
+
+ protected:
+
+    /** process a band of consecutive pixels.
+     *  This method is called concurrently for different bands, so it should only write
+     *  to the output pixels of the given band.
+     *
+     ** @param  start  index of the first pixel to be processed
+     *  @param  count  number of pixels to be processed
+     */
+    virtual void process(const unsigned long start,
+                         const unsigned long count) = 0;
+
+
+ private:
+
+    /** process a single band (called by the thread pool)
+     *
+     ** @param  index   index of the band to be processed
+     *  @param  thread  index of the calling thread (not used)
+     *
+     ** @return always OFTrue
+     */
+    virtual OFBool execute(const size_t index,
+                           const size_t thread);
+
+    /// total number of pixels to be processed
+    const unsigned long Count;
+    /// number of pixels per band (except for the last one)
+    unsigned long BandSize;
+
+ // --- declarations to avoid compiler warnings
+
+    DiPixelBandTask(const DiPixelBandTask &);
+    DiPixelBandTask &operator=(const DiPixelBandTask &);
+};
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Abstract base class for processing the frames of an image in parallel.
+ *  Each plane of each frame is processed independently from the others.  Optionally, the
+ *  rows of a frame are divided into bands that are also processed independently, e.g. in
+ *  order to speed up the processing of a single frame.  The number of threads is specified
+ *  globally by DicomImageClass::setNumberOfThreads().  The same thread pool as for
+ *  DiPixelBandTask is used, i.e. the frames are processed sequentially while the pool is
+ *  used by another thread.
+ */
+class DCMTK_DCMIMGLE_EXPORT DiRowBandTask
+  : protected OFThreadPool::Task
+{
+
+ public:
+
+    /** constructor
+     *
+     ** @param  planes     number of planes
+     *  @param  frames     number of frames
+     *  @param  rows       number of rows per frame (that can be divided into bands)
+     *  @param  pixels     number of pixels to be processed per frame (used to determine the
+     *                     minimum size of a band)
+     *  @param  splitRows  divide the rows of a frame into bands if true, process complete
+     *                     frames otherwise
+     */
+    DiRowBandTask(const int planes,
+                  const unsigned long frames,
+                  const Uint16 rows,
+                  const unsigned long pixels,
+                  const OFBool splitRows);
+
+    /** destructor
+     */
+    virtual ~DiRowBandTask();
+
+    /** process all planes and frames, either sequentially or in parallel
+     */
+    void run();
+
+
+ protected:
+
+    /** process a band of rows of a particular plane and frame.
+     *  This method is called concurrently for different bands, so it should only write
+     *  to the output rows of the given band.
+     *
+     ** @param  plane     index of the plane to be processed
+     *  @param  frame     index of the frame to be processed
+     *  @param  firstRow  index of the first row to be processed
+     *  @param  rowCount  number of rows to be processed
+     */
+    virtual void process(const int plane,
+                         const unsigned long frame,
+                         const Uint16 firstRow,
+                         const Uint16 rowCount) = 0;
+
+
+ private:
+
+    /** process a single band (called by the thread pool)
+     *
+     ** @param  index   index of the band to be processed
+     *  @param  thread  index of the calling thread (not used)
+     *
+     ** @return always OFTrue
+     */
+    virtual OFBool execute(const size_t index,
+                           const size_t thread);
+
+    /// number of planes
+    const int Planes;
+    /// number of frames
+    const unsigned long Frames;
+    /// number of rows per frame
+    const Uint16 Rows;
+    /// number of pixels to be processed per frame
+    const unsigned long Pixels;
+    /// divide the rows of a frame into bands if true
+    const OFBool SplitRows;
+    /// number of bands per frame
+    unsigned long Bands;
+    /// number of rows per band (except for the last one)
+    Uint16 BandRows;
+
+ // --- declarations to avoid compiler warnings
+
+    DiRowBandTask(const DiRowBandTask &);
+    DiRowBandTask &operator=(const DiRowBandTask &);
+};
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Template class for applying an optimization LUT to the pixel data of an image
+ */
+template<class T1, class T2>
+class DiApplyLUTTask
+  : public DiPixelBandTask
+{
+
+ public:
+
+    /** constructor
+     *
+     ** @param  src    pointer to input pixel data
+     *  @param  dest   pointer to output pixel data
+     *  @param  lut0   pointer to the LUT entry for the input value 0
+     *  @param  count  number of pixels to be processed
+     */
+    DiApplyLUTTask(const T1 *src,
+                   T2 *dest,
+                   const T2 *lut0,
+                   const unsigned long count)
+      : DiPixelBandTask(count),
+        Source(src),
+        Dest(dest),
+        LUT0(lut0)
+    {
+    }
+
+
+ protected:
+
+    /** apply the LUT to a band of pixels
+     *
+     ** @param  start  index of the first pixel to be processed
+     *  @param  count  number of pixels to be processed
+     */
+    virtual void process(const unsigned long start,
+                         const unsigned long count)
+    {
+        const T1 *p = Source + start;
+        T2 *q = Dest + start;
+        const T2 *lut0 = LUT0;
+        for (unsigned long i = count; i != 0; --i)
+            *(q++) = *(lut0 + (*(p++)));
+    }
+
+
+ private:
+
+    /// pointer to input pixel data
+    const T1 *Source;
+    /// pointer to output pixel data
+    T2 *Dest;
+    /// pointer to the LUT entry for the input value 0
+    const T2 *LUT0;
+
+ // --- declarations to avoid compiler warnings
+
+    DiApplyLUTTask(const DiApplyLUTTask<T1, T2> &);
+    DiApplyLUTTask<T1, T2> &operator=(const DiApplyLUTTask<T1, T2> &);
+};
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/** Template class for copying the pixel data of an image (with type conversion)
+ */
+template<class T1, class T2>
+class DiCopyPixelTask
+  : public DiPixelBandTask
+{
+
+ public:
+
+    /** constructor
+     *
+     ** @param  src    pointer to input pixel data
+     *  @param  dest   pointer to output pixel data
+     *  @param  count  number of pixels to be processed
+     */
+    DiCopyPixelTask(const T1 *src,
+                    T2 *dest,
+                    const unsigned long count)
+      : DiPixelBandTask(count),
+        Source(src),
+        Dest(dest)
+    {
+    }
+
+
+ protected:
+
+    /** copy a band of pixels
+     *
+     ** @param  start  index of the first pixel to be processed
+     *  @param  count  number of pixels to be processed
+     */
+    virtual void process(const unsigned long start,
+                         const unsigned long count)
+    {
+        const T1 *p = Source + start;
+        T2 *q = Dest + start;
+        for (unsigned long i = count; i != 0; --i)
+            *(q++) = OFstatic_cast(T2, *(p++));
+    }
+
+
+ private:
+
+    /// pointer to input pixel data
+    const T1 *Source;
+    /// pointer to output pixel data
+    T2 *Dest;
+
+ // --- declarations to avoid compiler warnings
+
+    DiCopyPixelTask(const DiCopyPixelTask<T1, T2> &);
+    DiCopyPixelTask<T1, T2> &operator=(const DiCopyPixelTask<T1, T2> &);
+};
+
+
+#endif
@@ -460,6 +460,23 @@ class DCMTK_DCMIMGLE_EXPORT DicomImageClass
     static EP_Representation determineRepresentation(double minvalue,
                                                      double maxvalue);
 
+    /** set maximum number of threads used for processing the pixel data of an image.
+     *  The pixels are then divided into bands that are processed in parallel, e.g. when
+     *  applying the modality, VOI and presentation LUT transformation to monochrome
+     *  images.  The setting applies to all images.  It is protected by a mutex, so it
+     *  may also be changed while other threads process images; a processing step that
+     *  is already running is not affected.
+     *
+     ** @param  threads  maximum number of threads (default: 1, i.e. no parallel
+     *                   processing).  0 selects the number of processors available.
+     */
+    static void setNumberOfThreads(const unsigned long threads);
+
+    /** get maximum number of threads used for processing the pixel data of an image
+     *
+     ** @return maximum number of threads, 0 for the number of processors available
+     */
+    static unsigned long getNumberOfThreads();
 };
 
 
@@ -0,0 +1,461 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: DicomSIMDKernels (Source)
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/dcmimgle/disimd.h"
+#include "dcmtk/ofstd/ofcast.h"
+
+/*
+ *  The vectorized kernels are only used on x86-64 systems, where the scalar double
+ *  precision arithmetic is also performed with SSE2 instructions (and not with the
+ *  extended precision of the x87 FPU).  Otherwise, the results would not be identical.
+ *  AVX2 is selected at runtime and, therefore, requires compiler support for enabling
+ *  the instruction set for single functions.
+ */
+#if defined(__x86_64__) || defined(_M_X64)
+#define DISIMD_USE_SSE2
+#include <emmintrin.h>
+#if (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5))) && !defined(_WIN32)
+#define DISIMD_USE_AVX2
+#define DISIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (_MSC_VER >= 1700)
+#define DISIMD_USE_AVX2
+#define DISIMD_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+
+/*-------------------------*
+ *  scalar implementation  *
+ *-------------------------*/
+
+static void rescaleScalar(const Sint32 *src,
+                          Sint32 *dest,
+                          const size_t count,
+                          const double slope,
+                          const double intercept)
+{
+    for (size_t i = 0; i < count; ++i)
+        dest[i] = OFstatic_cast(Sint32, OFstatic_cast(double, src[i]) * slope + intercept);
+}
+
+
+static void windowScalar(const Sint32 *src,
+                         Sint32 *dest,
+                         const size_t count,
+                         const double leftBorder,
+                         const double rightBorder,
+                         const double offset,
+                         const double gradient,
+                         const Sint32 low,
+                         const Sint32 high)
+{
+    double value;
+    for (size_t i = 0; i < count; ++i)
+    {
+        value = OFstatic_cast(double, src[i]);
+        if (value <= leftBorder)
+            dest[i] = low;
+        else if (value > rightBorder)
+            dest[i] = high;
+        else
+            dest[i] = OFstatic_cast(Sint32, offset + value * gradient);
+    }
+}
+
+
+static void interpolateScalar(const Sint32 *src1,
+                              const Sint32 *src2,
+                              Sint32 *dest,
+                              const size_t count,
+                              const double factor)
+{
+    double v1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        v1 = OFstatic_cast(double, src1[i]);
+        dest[i] = OFstatic_cast(Sint32, v1 + (OFstatic_cast(double, src2[i]) - v1) * factor);
+    }
+}
+
+
+#ifdef DISIMD_USE_SSE2
+
+/*-----------------------*
+ *  SSE2 implementation  *
+ *-----------------------*/
+
+static void rescaleSSE2(const Sint32 *src,
+                        Sint32 *dest,
+                        const size_t count,
+                        const double slope,
+                        const double intercept)
+{
+    const __m128d s = _mm_set1_pd(slope);
+    const __m128d c = _mm_set1_pd(intercept);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, src + i));
+        const __m128d lo = _mm_cvtepi32_pd(v);
+        const __m128d hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        const __m128i rlo = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(lo, s), c));
+        const __m128i rhi = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(hi, s), c));
+        _mm_storeu_si128(OFreinterpret_cast(__m128i *, dest + i), _mm_unpacklo_epi64(rlo, rhi));
+    }
+    rescaleScalar(src + i, dest + i, count - i, slope, intercept);
+}
+
+
+/* apply window to two values, the borders are handled in the double domain */
+static inline __m128i windowSSE2(const __m128d value,
+                                 const __m128d left,
+                                 const __m128d right,
+                                 const __m128d offset,
+                                 const __m128d gradient,
+                                 const __m128d low,
+                                 const __m128d high)
+{
+    __m128d result = _mm_add_pd(offset, _mm_mul_pd(value, gradient));
+    const __m128d maskR = _mm_cmpgt_pd(value, right);
+    result = _mm_or_pd(_mm_andnot_pd(maskR, result), _mm_and_pd(maskR, high));
+    const __m128d maskL = _mm_cmple_pd(value, left);                      // left border takes precedence
+    result = _mm_or_pd(_mm_andnot_pd(maskL, result), _mm_and_pd(maskL, low));
+    return _mm_cvttpd_epi32(result);
+}
+
+
+static void windowSSE2(const Sint32 *src,
+                       Sint32 *dest,
+                       const size_t count,
+                       const double leftBorder,
+                       const double rightBorder,
+                       const double offset,
+                       const double gradient,
+                       const Sint32 low,
+                       const Sint32 high)
+{
+    const __m128d l = _mm_set1_pd(leftBorder);
+    const __m128d r = _mm_set1_pd(rightBorder);
+    const __m128d o = _mm_set1_pd(offset);
+    const __m128d g = _mm_set1_pd(gradient);
+    const __m128d lv = _mm_set1_pd(OFstatic_cast(double, low));
+    const __m128d hv = _mm_set1_pd(OFstatic_cast(double, high));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, src + i));
+        const __m128i rlo = windowSSE2(_mm_cvtepi32_pd(v), l, r, o, g, lv, hv);
+        const __m128i rhi = windowSSE2(_mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))), l, r, o, g, lv, hv);
+        _mm_storeu_si128(OFreinterpret_cast(__m128i *, dest + i), _mm_unpacklo_epi64(rlo, rhi));
+    }
+    windowScalar(src + i, dest + i, count - i, leftBorder, rightBorder, offset, gradient, low, high);
+}
+
+
+static void interpolateSSE2(const Sint32 *src1,
+                            const Sint32 *src2,
+                            Sint32 *dest,
+                            const size_t count,
+                            const double factor)
+{
+    const __m128d f = _mm_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i v1 = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, src1 + i));
+        const __m128i v2 = _mm_loadu_si128(OFreinterpret_cast(const __m128i *, src2 + i));
+        const __m128d lo1 = _mm_cvtepi32_pd(v1);
+        const __m128d hi1 = _mm_cvtepi32_pd(_mm_shuffle_epi32(v1, _MM_SHUFFLE(1, 0, 3, 2)));
+        const __m128d lo2 = _mm_cvtepi32_pd(v2);
+        const __m128d hi2 = _mm_cvtepi32_pd(_mm_shuffle_epi32(v2, _MM_SHUFFLE(1, 0, 3, 2)));
+        const __m128i rlo = _mm_cvttpd_epi32(_mm_add_pd(lo1, _mm_mul_pd(_mm_sub_pd(lo2, lo1), f)));
+        const __m128i rhi = _mm_cvttpd_epi32(_mm_add_pd(hi1, _mm_mul_pd(_mm_sub_pd(hi2, hi1), f)));
+        _mm_storeu_si128(OFreinterpret_cast(__m128i *, dest + i), _mm_unpacklo_epi64(rlo, rhi));
+    }
+    interpolateScalar(src1 + i, src2 + i, dest + i, count - i, factor);
+}
+
+#endif
+
+
+#ifdef DISIMD_USE_AVX2
+
+/*-----------------------*
+ *  AVX2 implementation  *
+ *-----------------------*/
+
+DISIMD_TARGET_AVX2
+static void rescaleAVX2(const Sint32 *src,
+                        Sint32 *dest,
+                        const size_t count,
+                        const double slope,
+                        const double intercept)
+{
+    const __m256d s = _mm256_set1_pd(slope);
+    const __m256d c = _mm256_set1_pd(intercept);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(OFreinterpret_cast(const __m256i *, src + i));
+        const __m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+        const __m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+        const __m128i rlo = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(lo, s), c));
+        const __m128i rhi = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(hi, s), c));
+        _mm256_storeu_si256(OFreinterpret_cast(__m256i *, dest + i), _mm256_inserti128_si256(_mm256_castsi128_si256(rlo), rhi, 1));
+    }
+    rescaleScalar(src + i, dest + i, count - i, slope, intercept);
+}
+
+
+/* apply window to four values, the borders are handled in the double domain */
+DISIMD_TARGET_AVX2
+static inline __m128i windowAVX2(const __m256d value,
+                                 const __m256d left,
+                                 const __m256d right,
+                                 const __m256d offset,
+                                 const __m256d gradient,
+                                 const __m256d low,
+                                 const __m256d high)
+{
+    __m256d result = _mm256_add_pd(offset, _mm256_mul_pd(value, gradient));
+    result = _mm256_blendv_pd(result, high, _mm256_cmp_pd(value, right, _CMP_GT_OQ));
+    result = _mm256_blendv_pd(result, low, _mm256_cmp_pd(value, left, _CMP_LE_OQ));    // left border takes precedence
+    return _mm256_cvttpd_epi32(result);
+}
+
+
+DISIMD_TARGET_AVX2
+static void windowAVX2(const Sint32 *src,
+                       Sint32 *dest,
+                       const size_t count,
+                       const double leftBorder,
+                       const double rightBorder,
+                       const double offset,
+                       const double gradient,
+                       const Sint32 low,
+                       const Sint32 high)
+{
+    const __m256d l = _mm256_set1_pd(leftBorder);
+    const __m256d r = _mm256_set1_pd(rightBorder);
+    const __m256d o = _mm256_set1_pd(offset);
+    const __m256d g = _mm256_set1_pd(gradient);
+    const __m256d lv = _mm256_set1_pd(OFstatic_cast(double, low));
+    const __m256d hv = _mm256_set1_pd(OFstatic_cast(double, high));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(OFreinterpret_cast(const __m256i *, src + i));
+        const __m128i rlo = windowAVX2(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), l, r, o, g, lv, hv);
+        const __m128i rhi = windowAVX2(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), l, r, o, g, lv, hv);
+        _mm256_storeu_si256(OFreinterpret_cast(__m256i *, dest + i), _mm256_inserti128_si256(_mm256_castsi128_si256(rlo), rhi, 1));
+    }
+    windowScalar(src + i, dest + i, count - i, leftBorder, rightBorder, offset, gradient, low, high);
+}
+
+
+DISIMD_TARGET_AVX2
+static void interpolateAVX2(const Sint32 *src1,
+                            const Sint32 *src2,
+                            Sint32 *dest,
+                            const size_t count,
+                            const double factor)
+{
+    const __m256d f = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i v1 = _mm256_loadu_si256(OFreinterpret_cast(const __m256i *, src1 + i));
+        const __m256i v2 = _mm256_loadu_si256(OFreinterpret_cast(const __m256i *, src2 + i));
+        const __m256d lo1 = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v1));
+        const __m256d hi1 = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v1, 1));
+        const __m256d lo2 = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v2));
+        const __m256d hi2 = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v2, 1));
+        const __m128i rlo = _mm256_cvttpd_epi32(_mm256_add_pd(lo1, _mm256_mul_pd(_mm256_sub_pd(lo2, lo1), f)));
+        const __m128i rhi = _mm256_cvttpd_epi32(_mm256_add_pd(hi1, _mm256_mul_pd(_mm256_sub_pd(hi2, hi1), f)));
+        _mm256_storeu_si256(OFreinterpret_cast(__m256i *, dest + i), _mm256_inserti128_si256(_mm256_castsi128_si256(rlo), rhi, 1));
+    }
+    interpolateScalar(src1 + i, src2 + i, dest + i, count - i, factor);
+}
+
+
+/* check whether the CPU and the operating system support AVX2 */
+static OFBool isAVX2Supported()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return OFFalse;
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || ((_xgetbv(0) & 6) != 6))    // OSXSAVE, XMM and YMM state
+        return OFFalse;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+
+/*--------------------*
+ *  static functions  *
+ *--------------------*/
+
+static DiSIMDKernels::E_InstructionSet detectInstructionSet()
+{
+#ifdef DISIMD_USE_AVX2
+    if (isAVX2Supported())
+        return DiSIMDKernels::IS_AVX2;
+#endif
+#ifdef DISIMD_USE_SSE2
+    return DiSIMDKernels::IS_SSE2;
+#else
+    return DiSIMDKernels::IS_None;
+#endif
+}
+
+
+/*---------------------------*
+ *  static member variables  *
+ *---------------------------*/
+
+DiSIMDKernels::E_InstructionSet DiSIMDKernels::InstructionSet = detectInstructionSet();
+
+
+/********************************************************************/
+
+
+DiSIMDKernels::E_InstructionSet DiSIMDKernels::getInstructionSet()
+{
+    return InstructionSet;
+}
+
+
+DiSIMDKernels::E_InstructionSet DiSIMDKernels::getSupportedInstructionSet()
+{
+    return detectInstructionSet();
+}
+
+
+void DiSIMDKernels::setInstructionSet(const E_InstructionSet set)
+{
+    const E_InstructionSet supported = detectInstructionSet();
+    InstructionSet = (set > supported) ? supported : set;
+}
+
+
+const char *DiSIMDKernels::getInstructionSetName(const E_InstructionSet set)
+{
+    switch (set)
+    {
+        case IS_SSE2:
+            return "SSE2";
+        case IS_AVX2:
+            return "AVX2";
+        default:
+            return "none";
+    }
+}
+
+
+void DiSIMDKernels::rescale(const Sint32 *src,
+                            Sint32 *dest,
+                            const size_t count,
+                            const double slope,
+                            const double intercept)
+{
+    switch (InstructionSet)
+    {
+#ifdef DISIMD_USE_AVX2
+        case IS_AVX2:
+            rescaleAVX2(src, dest, count, slope, intercept);
+            break;
+#endif
+#ifdef DISIMD_USE_SSE2
+        case IS_SSE2:
+            rescaleSSE2(src, dest, count, slope, intercept);
+            break;
+#endif
+        default:
+            rescaleScalar(src, dest, count, slope, intercept);
+    }
+}
+
+
+void DiSIMDKernels::window(const Sint32 *src,
+                           Sint32 *dest,
+                           const size_t count,
+                           const double leftBorder,
+                           const double rightBorder,
+                           const double offset,
+                           const double gradient,
+                           const Sint32 low,
+                           const Sint32 high)
+{
+    switch (InstructionSet)
+    {
+#ifdef DISIMD_USE_AVX2
+        case IS_AVX2:
+            windowAVX2(src, dest, count, leftBorder, rightBorder, offset, gradient, low, high);
+            break;
+#endif
+#ifdef DISIMD_USE_SSE2
+        case IS_SSE2:
+            windowSSE2(src, dest, count, leftBorder, rightBorder, offset, gradient, low, high);
+            break;
+#endif
+        default:
+            windowScalar(src, dest, count, leftBorder, rightBorder, offset, gradient, low, high);
+    }
+}
+
+
+void DiSIMDKernels::interpolate(const Sint32 *src1,
+                                const Sint32 *src2,
+                                Sint32 *dest,
+                                const size_t count,
+                                const double factor)
+{
+    switch (InstructionSet)
+    {
+#ifdef DISIMD_USE_AVX2
+        case IS_AVX2:
+            interpolateAVX2(src1, src2, dest, count, factor);
+            break;
+#endif
+#ifdef DISIMD_USE_SSE2
+        case IS_SSE2:
+            interpolateSSE2(src1, src2, dest, count, factor);
+            break;
+#endif
+        default:
+            interpolateScalar(src1, src2, dest, count, factor);
+    }
+}
@@ -0,0 +1,273 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: DicomPixelBandTask, DicomRowBandTask (Source)
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/dcmimgle/dithread.h"
+
+
+/*---------------------*
+ *  macro definitions  *
+ *---------------------*/
+
+// minimum number of pixels per band, smaller images are processed sequentially
+#define MIN_PIXELS_PER_BAND 65536
+// number of bands per thread, allows for balancing the load between the threads
+#define BANDS_PER_THREAD 4
+
+
+/*---------------------*
+ *  class declaration  *
+ *---------------------*/
+
+/* Thread pool that is shared by all tasks of this process, so the threads are only created
+ * once and not for each processing step.  It is created on first use and created again if
+ * the number of threads (see DicomImageClass::setNumberOfThreads()) has changed.  Since the
+ * pool can only process one task at a time, a task that cannot acquire the pool (e.g. because
+ * another thread renders an image at the same time) is processed sequentially.
+ */
+class DiSharedThreadPool
+{
+
+ public:
+
+    DiSharedThreadPool()
+      : Pool(NULL),
+        Threads(0),
+        InUse(OFFalse),
+        Mutex()
+    {
+    }
+
+    ~DiSharedThreadPool()
+    {
+        delete Pool;
+    }
+
+    /* acquire the pool with the given number of threads (0 = number of processors).
+     * Returns NULL if the pool is in use, otherwise release() has to be called after use.
+     */
+    OFThreadPool *acquire(const unsigned long threads)
+    {
+        if (Mutex.trylock() != 0)
+            return NULL;
+        /* the mutex might be recursive, so also check for a nested call by the same thread */
+        if (InUse)
+        {
+            Mutex.unlock();
+            return NULL;
+        }
+        InUse = OFTrue;
+        if ((Pool == NULL) || (Threads != threads))
+        {
+            delete Pool;
+            Pool = new OFThreadPool(OFstatic_cast(size_t, threads));
+            Threads = threads;
+        }
+        return Pool;
+    }
+
+    /* release the pool acquired before
+     */
+    void release()
+    {
+        InUse = OFFalse;
+        Mutex.unlock();
+    }
+
+
+ private:
+
+    /// thread pool (created on first use)
+    OFThreadPool *Pool;
+    /// number of threads requested when the pool was created
+    unsigned long Threads;
+    /// flag indicating whether the pool is currently used
+    OFBool InUse;
+    /// mutex protecting the pool while it is used
+    OFMutex Mutex;
+
+ // --- declarations to avoid compiler warnings
+
+    DiSharedThreadPool(const DiSharedThreadPool &);
+    DiSharedThreadPool &operator=(const DiSharedThreadPool &);
+};
+
+
+/*------------------*
+ *  static members  *
+ *------------------*/
+
+static DiSharedThreadPool SharedThreadPool;
+
+
+/*----------------*
+ *  constructors  *
+ *----------------*/
+
+DiPixelBandTask::DiPixelBandTask(const unsigned long count)
+  : Count(count),
+    BandSize(count)
+{
+}
+
+
+/*--------------*
+ *  destructor  *
+ *--------------*/
+
+DiPixelBandTask::~DiPixelBandTask()
+{
+}
+
+
+/********************************************************************/
+
+
+void DiPixelBandTask::run()
+{
+    unsigned long threads = DicomImageClass::getNumberOfThreads();
+    OFThreadPool *pool = NULL;
+    if ((threads != 1) && (Count >= 2 * MIN_PIXELS_PER_BAND) && ((pool = SharedThreadPool.acquire(threads)) != NULL))
+    {
+        threads = OFstatic_cast(unsigned long, pool->getNumberOfThreads());
+        if (threads > 1)
+        {
+            /* determine number and size of the bands */
+            unsigned long bands = threads * BANDS_PER_THREAD;
+            if (bands > Count / MIN_PIXELS_PER_BAND)
+                bands = Count / MIN_PIXELS_PER_BAND;
+            BandSize = (Count + bands - 1) / bands;
+            bands = (Count + BandSize - 1) / BandSize;
+            DCMIMGLE_TRACE("processing " << Count << " pixels in " << bands << " bands using up to " << threads << " threads");
+            pool->run(*this, OFstatic_cast(size_t, bands));
+            SharedThreadPool.release();
+            return;
+        }
+        SharedThreadPool.release();
+    }
+    /* process all pixels sequentially */
+    process(0, Count);
+}
+
+
+OFBool DiPixelBandTask::execute(const size_t index,
+                                const size_t /* thread */)
+{
+    const unsigned long start = OFstatic_cast(unsigned long, index) * BandSize;
+    if (start < Count)
+        process(start, (Count - start < BandSize) ? Count - start : BandSize);
+    return OFTrue;
+}
+
+
+/*----------------*
+ *  constructors  *
+ *----------------*/
+
+DiRowBandTask::DiRowBandTask(const int planes,
+                             const unsigned long frames,
+                             const Uint16 rows,
+                             const unsigned long pixels,
+                             const OFBool splitRows)
+  : Planes(planes),
+    Frames(frames),
+    Rows(rows),
+    Pixels(pixels),
+    SplitRows(splitRows),
+    Bands(1),
+    BandRows(rows)
+{
+}
+
+
+/*--------------*
+ *  destructor  *
+ *--------------*/
+
+DiRowBandTask::~DiRowBandTask()
+{
+}
+
+
+/********************************************************************/
+
+
+void DiRowBandTask::run()
+{
+    unsigned long items = OFstatic_cast(unsigned long, Planes) * Frames;
+    const unsigned long maxThreads = DicomImageClass::getNumberOfThreads();
+    OFThreadPool *pool = NULL;
+    if ((maxThreads != 1) && (Rows > 0) && ((items > 1) || SplitRows) &&
+        (items * Pixels >= 2 * MIN_PIXELS_PER_BAND) && ((pool = SharedThreadPool.acquire(maxThreads)) != NULL))
+    {
+        const unsigned long threads = OFstatic_cast(unsigned long, pool->getNumberOfThreads());
+        if (threads > 1)
+        {
+            /* divide the frames into bands if there are not enough frames to keep the threads busy */
+            if (SplitRows && (items < threads * BANDS_PER_THREAD))
+            {
+                Bands = (threads * BANDS_PER_THREAD + items - 1) / items;
+                if (Bands > Pixels / MIN_PIXELS_PER_BAND)
+                    Bands = Pixels / MIN_PIXELS_PER_BAND;
+                if (Bands > Rows)
+                    Bands = Rows;
+                if (Bands < 1)
+                    Bands = 1;
+                BandRows = OFstatic_cast(Uint16, (Rows + Bands - 1) / Bands);
+                Bands = (Rows + BandRows - 1) / BandRows;
+            }
+            items *= Bands;
+            if (items > 1)
+            {
+                DCMIMGLE_TRACE("processing " << Planes << " plane(s) of " << Frames << " frame(s) in " << items
+                    << " bands using up to " << threads << " threads");
+                pool->run(*this, OFstatic_cast(size_t, items));
+                SharedThreadPool.release();
+                return;
+            }
+        }
+        SharedThreadPool.release();
+    }
+    /* process all planes and frames sequentially */
+    for (int plane = 0; plane < Planes; ++plane)
+    {
+        for (unsigned long frame = 0; frame < Frames; ++frame)
+            process(plane, frame, 0, Rows);
+    }
+}
+
+
+OFBool DiRowBandTask::execute(const size_t index,
+                              const size_t /* thread */)
+{
+    const unsigned long band = OFstatic_cast(unsigned long, index) % Bands;
+    const unsigned long frame = (OFstatic_cast(unsigned long, index) / Bands) % Frames;
+    const int plane = OFstatic_cast(int, OFstatic_cast(unsigned long, index) / Bands / Frames);
+    const unsigned long first = band * BandRows;
+    if (first < Rows)
+    {
+        const unsigned long count = (Rows - first < BandRows) ? Rows - first : BandRows;
+        process(plane, frame, OFstatic_cast(Uint16, first), OFstatic_cast(Uint16, count));
+    }
+    return OFTrue;
+}
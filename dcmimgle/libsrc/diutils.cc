@@ -24,6 +24,7 @@
 
 #include "dcmtk/dcmdata/dctypes.h"
 #include "dcmtk/ofstd/ofstream.h"
+#include "dcmtk/ofstd/ofglobal.h"
 
 #include "dcmtk/dcmimgle/diutils.h"
 
@@ -38,6 +39,9 @@
 
 OFLogger DCM_dcmimgleLogger = OFLog::getLogger("dcmtk.dcmimgle");
 
+/// maximum number of threads used for processing the pixel data (0 = number of processors)
+static OFGlobal<unsigned long> NumberOfThreads(1);
+
 
 /*------------------------*
  *  function definitions  *
@@ -137,3 +141,15 @@ EP_Representation DicomImageClass::determineRepresentation(double minvalue,
 #endif
     return EPR_Uint32;
 }
+
+
+void DicomImageClass::setNumberOfThreads(const unsigned long threads)
+{
+    NumberOfThreads.set(threads);
+}
+
+
+unsigned long DicomImageClass::getNumberOfThreads()
+{
+    return NumberOfThreads.get();
+}
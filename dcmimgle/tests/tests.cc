@@ -0,0 +1,32 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: main test program
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/ofstd/oftest.h"
+
+OFTEST_REGISTER(dcmimgle_SIMDKernels);
+OFTEST_REGISTER(dcmimgle_SIMDRendering);
+OFTEST_REGISTER(dcmimgle_ParallelScaling);
+#ifdef WITH_THREADS
+OFTEST_REGISTER(dcmimgle_ParallelScalingConcurrent);
+#endif
+OFTEST_MAIN("dcmimgle")
@@ -0,0 +1,272 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the parallel and vectorized scaling algorithms
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/ofstd/ofvector.h"
+
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+#include "dcmtk/dcmimgle/dcmimage.h"
+#include "dcmtk/dcmimgle/dipixel.h"
+#include "dcmtk/dcmimgle/disimd.h"
+
+
+// create a monochrome image with pseudo-random pixel data
+static void createImage(DcmDataset& dset, Uint16 columns, Uint16 rows, Uint16 frames)
+{
+    const size_t count = OFstatic_cast(size_t, columns) * rows * frames;
+    OFVector<Uint16> pixels(count);
+    Uint32 seed = 4711;
+    for (size_t i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        // smooth gradient plus some noise, so the interpolation results are not trivial
+        pixels[i] = OFstatic_cast(Uint16, ((i % columns) * 7 + (i / columns) * 3 + ((seed >> 8) % 256)) % 4096);
+    }
+    char buffer[16];
+    OFStandard::snprintf(buffer, sizeof(buffer), "%u", OFstatic_cast(unsigned int, frames));
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+    OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+    OFCHECK(dset.putAndInsertString(DCM_NumberOfFrames, buffer).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, rows).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, columns).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 16).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, 12).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_HighBit, 11).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    OFCHECK(dset.putAndInsertUint16Array(DCM_PixelData, &pixels[0], OFstatic_cast(unsigned long, count)).good());
+}
+
+
+// checksum (FNV-1a) over the intermediate pixel data of the given image
+static Uint32 computeChecksum(const DiPixel *pixel)
+{
+    Uint32 hash = 2166136261U;
+    const unsigned long count = pixel->getCount();
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        Uint32 value = 0;
+        switch (pixel->getRepresentation())
+        {
+            case EPR_Uint8:
+                value = OFstatic_cast(const Uint8 *, pixel->getData())[i];
+                break;
+            case EPR_Sint8:
+                value = OFstatic_cast(Uint32, OFstatic_cast(const Sint8 *, pixel->getData())[i]);
+                break;
+            case EPR_Uint16:
+                value = OFstatic_cast(const Uint16 *, pixel->getData())[i];
+                break;
+            case EPR_Sint16:
+                value = OFstatic_cast(Uint32, OFstatic_cast(const Sint16 *, pixel->getData())[i]);
+                break;
+            case EPR_Uint32:
+                value = OFstatic_cast(const Uint32 *, pixel->getData())[i];
+                break;
+            case EPR_Sint32:
+                value = OFstatic_cast(Uint32, OFstatic_cast(const Sint32 *, pixel->getData())[i]);
+                break;
+        }
+        for (int b = 0; b < 4; ++b)
+        {
+            hash ^= (value >> (8 * b)) & 0xff;
+            hash *= 16777619U;
+        }
+    }
+    return hash;
+}
+
+
+// scale all frames of the given image and compare the result with the expected checksum
+static void checkScaledImage(DicomImage& image, unsigned long width, unsigned long height, int interpolate, Uint32 expected)
+{
+    DicomImage *scaled = image.createScaledImage(width, height, interpolate);
+    OFCHECK(scaled != NULL);
+    if (scaled != NULL)
+    {
+        OFCHECK_EQUAL(scaled->getWidth(), width);
+        OFCHECK_EQUAL(scaled->getHeight(), height);
+        const DiPixel *pixel = scaled->getInterData();
+        OFCHECK(pixel != NULL);
+        if (pixel != NULL)
+            OFCHECK_EQUAL(computeChecksum(pixel), expected);
+        delete scaled;
+    }
+}
+
+
+/* Checksums of the images scaled by the original sequential scalar implementation
+ * (columns, rows, frames, width, height, interpolation algorithm, checksum).
+ * Odd sizes as well as up- and down-scaling are covered for all algorithms.
+ */
+static const unsigned long scalingCases[][7] =
+{
+    {   37,   23, 1,   74,   46, 0, 0x1833EC5DU },
+    {   37,   23, 1,   74,   46, 1, 0x1833EC5DU },
+    {   37,   23, 1,   74,   46, 2, 0x1833EC5DU },
+    {   37,   23, 1,   74,   46, 3, 0xFAF97863U },
+    {   37,   23, 1,   74,   46, 4, 0x098EF6EDU },
+    {   37,   23, 1,   53,   41, 0, 0xC85DBA4DU },
+    {   37,   23, 1,   53,   41, 1, 0x2EEBF121U },
+    {   37,   23, 1,   53,   41, 2, 0x9DED6942U },
+    {   37,   23, 1,   53,   41, 3, 0x9E1CE59DU },
+    {   37,   23, 1,   53,   41, 4, 0xC2CFE25EU },
+    {   37,   23, 1,   19,   12, 0, 0x44B905B1U },
+    {   37,   23, 1,   19,   12, 1, 0xE9DDD2ECU },
+    {   37,   23, 1,   19,   12, 2, 0xFCF1444AU },
+    {   37,   23, 1,   19,   12, 3, 0xFCF1444AU },
+    {   37,   23, 1,   19,   12, 4, 0xFCF1444AU },
+    {   37,   23, 1,   12,   23, 0, 0x2AE9AB48U },
+    {   37,   23, 1,   12,   23, 1, 0xCE225750U },
+    {   37,   23, 1,   12,   23, 2, 0x7A6D286CU },
+    {   37,   23, 1,   12,   23, 3, 0x7A6D286CU },
+    {   37,   23, 1,   12,   23, 4, 0x7A6D286CU },
+    {  700,  501, 1, 1400, 1002, 0, 0x07A6FE0DU },
+    {  700,  501, 1, 1400, 1002, 1, 0x07A6FE0DU },
+    {  700,  501, 1, 1400, 1002, 2, 0x07A6FE0DU },
+    {  700,  501, 1, 1400, 1002, 3, 0xB7386C10U },
+    {  700,  501, 1, 1400, 1002, 4, 0xC4E57426U },
+    {  700,  501, 1, 1050,  751, 0, 0x7422D9A9U },
+    {  700,  501, 1, 1050,  751, 1, 0x92A7C8B6U },
+    {  700,  501, 1, 1050,  751, 2, 0x8F690EF8U },
+    {  700,  501, 1, 1050,  751, 3, 0xA9160A48U },
+    {  700,  501, 1, 1050,  751, 4, 0xF6DCB424U },
+    {  700,  501, 1,  350,  251, 0, 0xF382053CU },
+    {  700,  501, 1,  350,  251, 1, 0x996021A0U },
+    {  700,  501, 1,  350,  251, 2, 0x6FA1645AU },
+    {  700,  501, 1,  350,  251, 3, 0x6FA1645AU },
+    {  700,  501, 1,  350,  251, 4, 0x6FA1645AU },
+    {  700,  501, 1,  233,  167, 0, 0x15028FD2U },
+    {  700,  501, 1,  233,  167, 1, 0xE900C678U },
+    {  700,  501, 1,  233,  167, 2, 0xA7551DB8U },
+    {  700,  501, 1,  233,  167, 3, 0xA7551DB8U },
+    {  700,  501, 1,  233,  167, 4, 0xA7551DB8U },
+    {  201,  151, 6,  402,  302, 0, 0x26CBA435U },
+    {  201,  151, 6,  402,  302, 1, 0x26CBA435U },
+    {  201,  151, 6,  402,  302, 2, 0x26CBA435U },
+    {  201,  151, 6,  402,  302, 3, 0x2A0B3C8DU },
+    {  201,  151, 6,  402,  302, 4, 0xC664D82FU },
+    {  201,  151, 6,  301,  227, 0, 0xF6F5413CU },
+    {  201,  151, 6,  301,  227, 1, 0xD5686AABU },
+    {  201,  151, 6,  301,  227, 2, 0xFACF5D8CU },
+    {  201,  151, 6,  301,  227, 3, 0x0425AC3FU },
+    {  201,  151, 6,  301,  227, 4, 0x946C667AU },
+    {  201,  151, 6,  100,   75, 0, 0x7C4A2802U },
+    {  201,  151, 6,  100,   75, 1, 0x522DE620U },
+    {  201,  151, 6,  100,   75, 2, 0xC9C1E84EU },
+    {  201,  151, 6,  100,   75, 3, 0xC9C1E84EU },
+    {  201,  151, 6,  100,   75, 4, 0xC9C1E84EU },
+    {  201,  151, 6,  157,  113, 0, 0xF8A36385U },
+    {  201,  151, 6,  157,  113, 1, 0x3C447F4FU },
+    {  201,  151, 6,  157,  113, 2, 0x6722892AU },
+    {  201,  151, 6,  157,  113, 3, 0x6722892AU },
+    {  201,  151, 6,  157,  113, 4, 0x6722892AU }
+};
+
+
+// the scaled image must neither depend on the number of threads nor on the instruction set
+static void checkScaling(DiSIMDKernels::E_InstructionSet instructionSet, unsigned long threads)
+{
+    DiSIMDKernels::setInstructionSet(instructionSet);
+    DicomImageClass::setNumberOfThreads(threads);
+    for (size_t i = 0; i < sizeof(scalingCases) / sizeof(scalingCases[0]); ++i)
+    {
+        const unsigned long *c = scalingCases[i];
+        DcmDataset dset;
+        createImage(dset, OFstatic_cast(Uint16, c[0]), OFstatic_cast(Uint16, c[1]), OFstatic_cast(Uint16, c[2]));
+        DicomImage image(&dset, EXS_LittleEndianExplicit);
+        OFCHECK_EQUAL(image.getStatus(), EIS_Normal);
+        checkScaledImage(image, c[3], c[4], OFstatic_cast(int, c[5]), OFstatic_cast(Uint32, c[6]));
+    }
+    DiSIMDKernels::setInstructionSet(DiSIMDKernels::getSupportedInstructionSet());
+    DicomImageClass::setNumberOfThreads(1);
+}
+
+
+OFTEST(dcmimgle_ParallelScaling)
+{
+    // sequential scalar code
+    checkScaling(DiSIMDKernels::IS_None, 1);
+    // parallel code (bands of rows for single frames, whole frames otherwise) using SIMD kernels
+    checkScaling(DiSIMDKernels::getSupportedInstructionSet(), 4);
+}
+
+
+#ifdef WITH_THREADS
+
+// thread that scales all test images and counts the results that differ from the expected ones
+class ScalingThread : public OFThread
+{
+public:
+    ScalingThread()
+      : Failures(0)
+    {
+    }
+
+    virtual void run()
+    {
+        for (size_t i = 0; i < sizeof(scalingCases) / sizeof(scalingCases[0]); ++i)
+        {
+            const unsigned long *c = scalingCases[i];
+            DcmDataset dset;
+            createImage(dset, OFstatic_cast(Uint16, c[0]), OFstatic_cast(Uint16, c[1]), OFstatic_cast(Uint16, c[2]));
+            DicomImage image(&dset, EXS_LittleEndianExplicit);
+            DicomImage *scaled = image.createScaledImage(c[3], c[4], OFstatic_cast(int, c[5]));
+            if ((scaled == NULL) || (scaled->getInterData() == NULL) ||
+                (computeChecksum(scaled->getInterData()) != OFstatic_cast(Uint32, c[6])))
+            {
+                ++Failures;
+            }
+            delete scaled;
+        }
+    }
+
+    /// number of images that have not been scaled as expected
+    size_t Failures;
+};
+
+
+OFTEST(dcmimgle_ParallelScalingConcurrent)
+{
+    // the thread pool is shared, so images scaled at the same time by different
+    // threads are partly processed sequentially, which must not change the result
+    DicomImageClass::setNumberOfThreads(4);
+    ScalingThread threads[3];
+    for (size_t i = 0; i < 3; ++i)
+        OFCHECK_EQUAL(threads[i].start(), 0);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        OFCHECK_EQUAL(threads[i].join(), 0);
+        OFCHECK_EQUAL(threads[i].Failures, 0);
+    }
+    // changing the number of threads replaces the shared thread pool
+    checkScaling(DiSIMDKernels::getSupportedInstructionSet(), 2);
+}
+
+#endif // WITH_THREADS
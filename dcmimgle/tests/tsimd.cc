@@ -0,0 +1,214 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmimgle
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: test program for the vectorized pixel transformations
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofvector.h"
+
+#include "dcmtk/dcmdata/dcdatset.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+#include "dcmtk/dcmimgle/dcmimage.h"
+#include "dcmtk/dcmimgle/disimd.h"
+
+
+// create pseudo-random integer values in the range [minValue, maxValue]
+static void createTestData(OFVector<Sint32>& data, size_t count, Sint32 minValue, Sint32 maxValue)
+{
+    Uint32 seed = 4711;
+    const Uint32 range = OFstatic_cast(Uint32, maxValue - minValue) + 1;
+    data.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        data.push_back(minValue + OFstatic_cast(Sint32, (seed >> 8) % range));
+    }
+    // make sure that the extreme values are included
+    if (count > 1)
+    {
+        data[0] = minValue;
+        data[count - 1] = maxValue;
+    }
+}
+
+
+// check the kernels with the given instruction set against the scalar reference
+static void checkKernels(DiSIMDKernels::E_InstructionSet set)
+{
+    DiSIMDKernels::setInstructionSet(set);
+    OFCHECK_EQUAL(DiSIMDKernels::getInstructionSet(), set);
+
+    // odd number of values, so the scalar tail of the vectorized kernels is also used
+    const size_t count = 10007;
+    OFVector<Sint32> src;
+    OFVector<Sint32> dest(count);
+    createTestData(src, count, -40000, 70000);
+
+    // modality rescale
+    static const double slopes[] = { 1.0, 1.0, 0.25, 2.3, -1.7, 1.0 / 3.0 };
+    static const double intercepts[] = { 0.0, -1024.0, 0.0, -17.25, 4095.5, 0.1 };
+    for (size_t j = 0; j < sizeof(slopes) / sizeof(slopes[0]); ++j)
+    {
+        DiSIMDKernels::rescale(&src[0], &dest[0], count, slopes[j], intercepts[j]);
+        size_t errors = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (dest[i] != OFstatic_cast(Sint32, OFstatic_cast(double, src[i]) * slopes[j] + intercepts[j]))
+                ++errors;
+        }
+        OFCHECK_EQUAL(errors, 0);
+    }
+
+    // VOI windowing (same computation as in DiMonoOutputPixelTemplate::window())
+    static const double centers[] = { 2048.0, 40.0, 0.0, -500.5, 30000.0 };
+    static const double widths[] = { 4096.0, 400.0, 1.0, 3.0, 65536.0 };
+    static const Sint32 lows[] = { 0, 255, 0, 65535, 0 };
+    static const Sint32 highs[] = { 255, 0, 65535, 0, 65535 };
+    for (size_t j = 0; j < sizeof(centers) / sizeof(centers[0]); ++j)
+    {
+        const double width_1 = widths[j] - 1;
+        const double leftBorder = centers[j] - 0.5 - width_1 / 2;
+        const double rightBorder = centers[j] - 0.5 + width_1 / 2;
+        const double outrange = OFstatic_cast(double, highs[j]) - OFstatic_cast(double, lows[j]);
+        const double offset = (width_1 == 0) ? 0 : (highs[j] - ((centers[j] - 0.5) / width_1 + 0.5) * outrange);
+        const double gradient = (width_1 == 0) ? 0 : outrange / width_1;
+        DiSIMDKernels::window(&src[0], &dest[0], count, leftBorder, rightBorder, offset, gradient, lows[j], highs[j]);
+        size_t errors = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double value = OFstatic_cast(double, src[i]);
+            Sint32 expected;
+            if (value <= leftBorder)
+                expected = lows[j];
+            else if (value > rightBorder)
+                expected = highs[j];
+            else
+                expected = OFstatic_cast(Sint32, offset + value * gradient);
+            if (dest[i] != expected)
+                ++errors;
+        }
+        OFCHECK_EQUAL(errors, 0);
+    }
+
+    // linear interpolation (same computation as in DiScaleTemplate::bilinearRows())
+    OFVector<Sint32> src2;
+    createTestData(src2, count, -70000, 40000);
+    static const double factors[] = { 0.0, 0.3, 0.5, 0.99, 1.0 };
+    for (size_t j = 0; j < sizeof(factors) / sizeof(factors[0]); ++j)
+    {
+        DiSIMDKernels::interpolate(&src[0], &src2[0], &dest[0], count, factors[j]);
+        size_t errors = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double v1 = OFstatic_cast(double, src[i]);
+            const double v2 = OFstatic_cast(double, src2[i]);
+            if (dest[i] != OFstatic_cast(Sint32, v1 + (v2 - v1) * factors[j]))
+                ++errors;
+        }
+        OFCHECK_EQUAL(errors, 0);
+    }
+}
+
+
+// create a monochrome image with rescale slope and intercept
+static void createImage(DcmDataset& dset, Uint16 columns, Uint16 rows, Uint16 bitsStored, const char *slope, const char *intercept)
+{
+    OFVector<Sint32> data;
+    createTestData(data, OFstatic_cast(size_t, columns) * rows, 0, (1 << bitsStored) - 1);
+    OFVector<Uint16> pixels(data.size());
+    for (size_t i = 0; i < data.size(); ++i)
+        pixels[i] = OFstatic_cast(Uint16, data[i]);
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+    OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, rows).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, columns).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 16).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, bitsStored).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_HighBit, OFstatic_cast(Uint16, bitsStored - 1)).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    OFCHECK(dset.putAndInsertString(DCM_RescaleSlope, slope).good());
+    OFCHECK(dset.putAndInsertString(DCM_RescaleIntercept, intercept).good());
+    OFCHECK(dset.putAndInsertUint16Array(DCM_PixelData, &pixels[0], OFstatic_cast(unsigned long, pixels.size())).good());
+}
+
+
+// render the given image with the given instruction set and output depth
+static void renderImage(DcmDataset& dset, DiSIMDKernels::E_InstructionSet set, int bits, OFVector<Uint8>& output)
+{
+    DiSIMDKernels::setInstructionSet(set);
+    output.clear();
+    DicomImage image(&dset, EXS_LittleEndianExplicit);
+    OFCHECK_EQUAL(image.getStatus(), EIS_Normal);
+    OFCHECK(image.setWindow(-150.0, 1700.0));
+    const unsigned long size = image.getOutputDataSize(bits);
+    const Uint8 *data = OFstatic_cast(const Uint8 *, image.getOutputData(bits));
+    OFCHECK(data != NULL);
+    if (data != NULL)
+        output.insert(output.end(), data, data + size);
+}
+
+
+// the rendered image must not depend on the instruction set
+static void checkRendering(Uint16 columns, Uint16 rows, Uint16 bitsStored, const char *slope, const char *intercept)
+{
+    DcmDataset dset;
+    createImage(dset, columns, rows, bitsStored, slope, intercept);
+    const DiSIMDKernels::E_InstructionSet supported = DiSIMDKernels::getSupportedInstructionSet();
+    for (int bits = 8; bits <= 16; bits += 8)
+    {
+        OFVector<Uint8> reference;
+        OFVector<Uint8> output;
+        renderImage(dset, DiSIMDKernels::IS_None, bits, reference);
+        for (int set = DiSIMDKernels::IS_SSE2; set <= supported; ++set)
+        {
+            renderImage(dset, OFstatic_cast(DiSIMDKernels::E_InstructionSet, set), bits, output);
+            OFCHECK_EQUAL(output.size(), reference.size());
+            if (output.size() == reference.size())
+                OFCHECK(memcmp(&output[0], &reference[0], output.size()) == 0);
+        }
+    }
+    DiSIMDKernels::setInstructionSet(supported);
+}
+
+
+OFTEST(dcmimgle_SIMDKernels)
+{
+    const DiSIMDKernels::E_InstructionSet supported = DiSIMDKernels::getSupportedInstructionSet();
+    for (int set = DiSIMDKernels::IS_None; set <= supported; ++set)
+        checkKernels(OFstatic_cast(DiSIMDKernels::E_InstructionSet, set));
+    DiSIMDKernels::setInstructionSet(supported);
+}
+
+
+OFTEST(dcmimgle_SIMDRendering)
+{
+    // small image, the pixels are transformed directly
+    checkRendering(37, 19, 12, "0.7", "-1024.3");
+    checkRendering(37, 19, 16, "1", "-32768");
+    // large image, an optimization LUT is computed
+    checkRendering(256, 131, 12, "0.7", "-1024.3");
+    checkRendering(256, 131, 12, "1", "-1024");
+    checkRendering(400, 300, 16, "2.5", "0");
+}
@@ -93,6 +93,7 @@ int main(int argc, char *argv[])
   OFBool           opt_usePixelValues = OFTrue;
   OFBool           opt_useModalityRescale = OFFalse;
   OFBool           opt_trueLossless = OFTrue;
+  OFCmdUnsignedInt opt_threads = 1;
   OFBool           opt_lossless = OFTrue;
   OFBool           lossless = OFTrue;  /* see opt_oxfer */
 
@@ -151,6 +152,8 @@ int main(int argc, char *argv[])
     cmd.addSubGroup("other JPEG options:");
       cmd.addOption("--huffman-optimize",    "+ho",    "optimize huffman tables (default)");
       cmd.addOption("--huffman-standard",    "-ho",    "use standard huffman tables if 8 bits/sample");
+      cmd.addOption("--threads",             "+th", 1, "[n]umber: integer (0 = number of CPUs)",
+                                                       "compress up to n frames in parallel (default: 1)");
 
     cmd.addSubGroup("compressed bits per sample (always +ba with +tl):");
       cmd.addOption("--bits-auto",           "+ba",    "choose bits/sample automatically (default)");
@@ -383,6 +386,11 @@ int main(int argc, char *argv[])
       if (cmd.findOption("--huffman-standard")) opt_huffmanOptimize = OFFalse;
       cmd.endOptionBlock();
 
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValue(opt_threads));
+      }
+
       if (cmd.findOption("--smooth"))
       {
         app.checkConflict("--smooth", "--true-lossless", opt_trueLossless);
@@ -651,7 +659,8 @@ int main(int argc, char *argv[])
       opt_useModalityRescale,
       opt_acceptWrongPaletteTags,
       opt_acrNemaCompatibility,
-      opt_trueLossless);
+      opt_trueLossless,
+      OFstatic_cast(size_t, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
@@ -25,6 +25,7 @@
 #include "dcmtk/config/osconfig.h"
 #include "dcmtk/ofstd/oftypes.h"
 #include "dcmtk/dcmdata/dccodec.h"    /* for class DcmCodec */
+#include "dcmtk/dcmdata/dcofsetl.h"   /* for struct DcmOffsetList */
 #include "dcmtk/dcmjpeg/djutils.h"    /* for enums */
 #include "dcmtk/ofstd/oflist.h"
 #include "dcmtk/ofstd/ofstring.h"     /* for class OFString */
@@ -313,6 +314,47 @@ private:
     const DcmCodecParameter *cp,
     DcmStack & objStack) const;
 
+  /** compresses all frames of an image and stores the compressed frames
+   *  in the given pixel sequence (in frame order). Depending on the codec
+   *  parameters, several frames are compressed in parallel, each thread
+   *  using its own encoder instance. The result does not depend on the
+   *  number of threads.
+   *  @param jpeg encoder instance used by the calling thread
+   *  @param toRepParam representation parameter passed to encode()
+   *  @param cp codec parameters for this codec
+   *  @param encoderBits bits per sample passed to createEncoderInstance()
+   *    when creating the encoder instances for the additional threads
+   *  @param image DicomImage object used to render the frames. If NULL,
+   *    the frames are taken from the given pixel data without rendering.
+   *  @param pixelData uncompressed pixel data of all frames ("color by
+   *    pixel"), only used if image is NULL
+   *  @param frameCount number of frames to be compressed
+   *  @param columns number of columns of each frame
+   *  @param rows number of rows of each frame
+   *  @param interpr photometric interpretation of the frames to be compressed
+   *  @param samplesPerPixel samples per pixel of the frames to be compressed
+   *  @param pixelSequence pixel sequence to which the compressed frames are added
+   *  @param offsetList list of frame offsets, updated by this method
+   *  @param compressedSize total size of the compressed frames, increased
+   *    by this method
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  OFCondition encodeFrames(
+    DJEncoder *jpeg,
+    const DcmRepresentationParameter * toRepParam,
+    const DJCodecParameter *cp,
+    Uint8 encoderBits,
+    DicomImage *image,
+    const Uint8 *pixelData,
+    size_t frameCount,
+    Uint16 columns,
+    Uint16 rows,
+    EP_Interpretation interpr,
+    Uint16 samplesPerPixel,
+    DcmPixelSequence *pixelSequence,
+    DcmOffsetList& offsetList,
+    size_t& compressedSize) const;
+
   /** create Lossy Image Compression and Lossy Image Compression Ratio.
    *  @param dataset dataset to be modified
    *  @param ratio image compression ratio > 1. This is not the "quality factor"
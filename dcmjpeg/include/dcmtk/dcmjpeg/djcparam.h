@@ -68,6 +68,8 @@ public:
    *  @param pAcrNemaCompatibility accept old ACR-NEMA images without photometric interpretation
    *    (only "pseudo" lossless encoder)
    *  @param pTrueLosslessMode Enables true lossless compression (replaces old "pseudo lossless" encoder)
+   *  @param pNumberOfThreads maximum number of threads used for compressing the frames of a
+   *    multi-frame image in parallel, 0 for the number of processors (default: 1, i.e. sequential)
    */
   DJCodecParameter(
     E_CompressionColorSpaceConversion pCompressionCSConversion,
@@ -97,7 +99,8 @@ public:
     OFBool pUseModalityRescale = OFFalse,
     OFBool pAcceptWrongPaletteTags = OFFalse,
     OFBool pAcrNemaCompatibility = OFFalse,
-    OFBool pTrueLosslessMode = OFTrue);
+    OFBool pTrueLosslessMode = OFTrue,
+    size_t pNumberOfThreads = 1);
 
   /// copy constructor
   DJCodecParameter(const DJCodecParameter& arg);
@@ -323,6 +326,14 @@ public:
     return forceSingleFragmentPerFrame;
   }
 
+  /** returns maximum number of threads used for compressing the frames of a multi-frame image
+   *  @return maximum number of threads, 0 for the number of processors
+   */
+  size_t getNumberOfThreads() const
+  {
+    return numberOfThreads;
+  }
+
 private:
 
   /// private undefined copy assignment operator
@@ -427,6 +438,11 @@ private:
    */
   OFBool forceSingleFragmentPerFrame;
 
+  /** maximum number of threads used for compressing the frames of a multi-frame image
+   *  in parallel, 0 for the number of processors
+   */
+  size_t numberOfThreads;
+
 };
 
 
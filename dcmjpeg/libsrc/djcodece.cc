@@ -25,6 +25,8 @@
 // ofstd includes
 #include "dcmtk/ofstd/oflist.h"
 #include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofthpool.h"   /* for class OFThreadPool */
+#include "dcmtk/ofstd/ofvector.h"
 
 // dcmdata includes
 #include "dcmtk/dcmdata/dcdatset.h"   /* for class DcmDataset */
@@ -49,6 +51,172 @@
 
 #include <cmath>
 
+
+/** helper class compressing a number of consecutive frames of an image,
+ *  possibly in parallel. Each thread uses its own encoder instance and
+ *  (if the frames have to be rendered) its own output buffer. Since
+ *  DicomImage is not thread-safe, rendering is serialized by a mutex.
+ */
+class DJFrameEncoderTask: public OFThreadPool::Task
+{
+public:
+
+  /** constructor
+   *  @param encoders encoder instances, one for each thread
+   *  @param image DicomImage object used to render the frames, may be NULL
+   *  @param pixelData uncompressed pixel data, only used if image is NULL
+   *  @param columns number of columns of each frame
+   *  @param rows number of rows of each frame
+   *  @param interpr photometric interpretation of the frames
+   *  @param samplesPerPixel samples per pixel of the frames
+   *  @param maxFrames maximum number of frames compressed by a single run
+   */
+  DJFrameEncoderTask(
+    OFVector<DJEncoder *>& encoders,
+    DicomImage *image,
+    const Uint8 *pixelData,
+    Uint16 columns,
+    Uint16 rows,
+    EP_Interpretation interpr,
+    Uint16 samplesPerPixel,
+    size_t maxFrames)
+  : encoders_(encoders)
+  , image_(image)
+  , pixelData_(pixelData)
+  , columns_(columns)
+  , rows_(rows)
+  , interpr_(interpr)
+  , samplesPerPixel_(samplesPerPixel)
+  , firstFrame_(0)
+  , bufferSize_(0)
+  , buffers_(encoders.size(), OFstatic_cast(Uint8 *, NULL))
+  , mutex_()
+  , jpegData(maxFrames, OFstatic_cast(Uint8 *, NULL))
+  , jpegLen(maxFrames, 0)
+  , result(maxFrames, EC_IllegalCall)
+  {
+    if (image_)
+      bufferSize_ = image_->getOutputDataSize(encoders_[0]->bitsPerSample());
+  }
+
+  /// destructor
+  virtual ~DJFrameEncoderTask()
+  {
+    for (size_t i = 0; i < buffers_.size(); ++i)
+      delete[] buffers_[i];
+    clear();
+  }
+
+  /** set the index of the frame that is compressed as the first work item
+   *  @param firstFrame index of the first frame of the next run
+   */
+  void setFirstFrame(size_t firstFrame)
+  {
+    firstFrame_ = firstFrame;
+  }
+
+  /// delete the compressed frames of the last run and reset their status
+  void clear()
+  {
+    for (size_t i = 0; i < jpegData.size(); ++i)
+    {
+      delete[] jpegData[i];
+      jpegData[i] = NULL;
+      jpegLen[i] = 0;
+      // frames that have not been processed are reported as failed
+      result[i] = EC_IllegalCall;
+    }
+  }
+
+  /** compress a single frame
+   *  @param index index of the frame relative to the first frame
+   *  @param thread index of the calling thread
+   *  @return OFTrue if successful, OFFalse otherwise
+   */
+  virtual OFBool execute(const size_t index, const size_t thread)
+  {
+    DJEncoder *jpeg = encoders_[thread];
+    const size_t frame = firstFrame_ + index;
+    const Uint16 bytesPerSample = jpeg->bytesPerSample();
+    const void *frameData = NULL;
+    if (image_)
+    {
+      Uint8 *&buffer = buffers_[thread];
+      mutex_.lock();
+      if (buffer == NULL) buffer = new Uint8[bufferSize_];
+      if (image_->getOutputData(buffer, bufferSize_, jpeg->bitsPerSample(), OFstatic_cast(unsigned long, frame), 0))
+        frameData = buffer;
+      mutex_.unlock();
+    }
+    else
+      frameData = pixelData_ + frame * columns_ * rows_ * samplesPerPixel_ * OFstatic_cast(size_t, bytesPerSample);
+    if (frameData == NULL) result[index] = EC_MemoryExhausted;
+    else if (bytesPerSample == 1)
+    {
+      result[index] = jpeg->encode(columns_, rows_, interpr_, samplesPerPixel_, OFreinterpret_cast(Uint8*, OFconst_cast(void*, frameData)), jpegData[index], jpegLen[index]);
+    } else {
+      result[index] = jpeg->encode(columns_, rows_, interpr_, samplesPerPixel_, OFreinterpret_cast(Uint16*, OFconst_cast(void*, frameData)), jpegData[index], jpegLen[index]);
+    }
+    // the true lossless encoder treats an empty frame as an error (as before),
+    // the other encoders store it unchanged
+    if (result[index].good() && (image_ == NULL) && (jpegLen[index] == 0)) result[index] = EC_CannotChangeRepresentation;
+    return result[index].good();
+  }
+
+private:
+
+  /// private undefined copy constructor
+  DJFrameEncoderTask(const DJFrameEncoderTask&);
+
+  /// private undefined copy assignment operator
+  DJFrameEncoderTask& operator=(const DJFrameEncoderTask&);
+
+  /// encoder instances, one for each thread
+  OFVector<DJEncoder *>& encoders_;
+
+  /// DicomImage object used to render the frames, may be NULL
+  DicomImage *image_;
+
+  /// uncompressed pixel data, only used if image_ is NULL
+  const Uint8 *pixelData_;
+
+  /// number of columns of each frame
+  Uint16 columns_;
+
+  /// number of rows of each frame
+  Uint16 rows_;
+
+  /// photometric interpretation of the frames
+  EP_Interpretation interpr_;
+
+  /// samples per pixel of the frames
+  Uint16 samplesPerPixel_;
+
+  /// index of the frame compressed as the first work item
+  size_t firstFrame_;
+
+  /// size of each output buffer in bytes
+  unsigned long bufferSize_;
+
+  /// output buffers for rendered frames, one for each thread
+  OFVector<Uint8 *> buffers_;
+
+  /// mutex protecting the DicomImage object
+  OFMutex mutex_;
+
+public:
+
+  /// compressed frames of the last run, indexed by work item
+  OFVector<Uint8 *> jpegData;
+
+  /// length of the compressed frames of the last run
+  OFVector<Uint32> jpegLen;
+
+  /// status of the compression of each frame of the last run
+  OFVector<OFCondition> result;
+};
+
+
 DJCodecEncoder::DJCodecEncoder()
 : DcmCodec()
 {
@@ -372,41 +540,13 @@ OFCondition DJCodecEncoder::encodeColorImage(
       // render and compress each frame
       bitsPerSample = jpeg->bitsPerSample();
       size_t frameCount = dimage->getFrameCount();
-      unsigned short bytesPerSample = jpeg->bytesPerSample();
       unsigned short columns = OFstatic_cast(unsigned short, dimage->getWidth());
       unsigned short rows = OFstatic_cast(unsigned short, dimage->getHeight());
-      Uint8 *jpegData = NULL;
-      Uint32 jpegLen  = 0;
-      const void *frame = NULL;
 
       // compute original image size in bytes, ignoring any padding bits.
       uncompressedSize = OFstatic_cast(double, columns * rows * dimage->getDepth() * frameCount * samplesPerPixel) / 8.0;
-      for (unsigned long i=0; (i<frameCount) && (result.good()); i++)
-      {
-        frame = dimage->getOutputData(bitsPerSample, i, 0);
-        if (frame == NULL) result = EC_MemoryExhausted;
-        else
-        {
-          // compress frame
-          jpegData = NULL;
-          if (bytesPerSample == 1)
-          {
-            result = jpeg->encode(columns, rows, interpr, samplesPerPixel, OFreinterpret_cast(Uint8*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          } else {
-            result = jpeg->encode(columns, rows, interpr, samplesPerPixel, OFreinterpret_cast(Uint16*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          }
-
-          // store frame
-          if (result.good())
-          {
-            result = pixelSequence->storeCompressedFrame(offsetList, jpegData, jpegLen, cp->getFragmentSize());
-          }
-
-          // delete block of JPEG data
-          delete[] jpegData;
-          compressedSize += jpegLen;
-        }
-      }
+      result = encodeFrames(jpeg, toRepParam, cp, OFstatic_cast(Uint8, compressedBits), dimage, NULL, frameCount,
+        columns, rows, interpr, samplesPerPixel, pixelSequence, offsetList, compressedSize);
       delete jpeg;
     } else result = EC_MemoryExhausted;
   }
@@ -501,8 +641,6 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
     Uint16 rows = 0;
     Sint32 numberOfFrames = 1;
     EP_Interpretation interpr = EPI_Unknown;
-    Uint8 *jpegData = NULL;
-    Uint32 jpegLen  = 0;
     OFBool byteSwapped = OFFalse;      // true if we have byte-swapped the original pixel data
     OFBool planConfSwitched = OFFalse; // true if planar configuration was toggled
     DcmOffsetList offsetList;
@@ -628,8 +766,6 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
 
     // prepare some variables for encoding
     size_t frameCount = OFstatic_cast(size_t, numberOfFrames);
-    size_t frameSize = columns * rows * samplesPerPixel * bytesAllocated;
-    const Uint8 *framePointer = OFreinterpret_cast(const Uint8 *, pixelData);
     size_t compressedSize = 0;
 
     // create encoder corresponding to bit depth (8 or 16 bit)
@@ -637,30 +773,12 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
     if (jpeg)
     {
       // main loop for compression: compress each frame
-      for (unsigned int i=0; i<frameCount && result.good(); i++)
+      if (result.good())
       {
-        if (bitsAllocated == 8)
-        {
-          jpeg->encode(columns, rows, interpr, samplesPerPixel, OFconst_cast(Uint8*, framePointer), jpegData, jpegLen);
-        }
-        else if (bitsAllocated == 16)
-        {
-          jpeg->encode(columns, rows, interpr, samplesPerPixel, OFreinterpret_cast(Uint16*, OFconst_cast(Uint8*, framePointer)), jpegData, jpegLen);
-        }
-        // update variables
-        compressedSize+=jpegLen;
-        framePointer+=frameSize;
-        if (jpegLen == 0)
-        {
+        result = encodeFrames(jpeg, toRepParam, djcp, OFstatic_cast(Uint8, bitsAllocated), NULL, OFreinterpret_cast(const Uint8 *, pixelData),
+          frameCount, columns, rows, interpr, samplesPerPixel, pixelSequence, offsetList, compressedSize);
+        if (result == EC_CannotChangeRepresentation)
           DCMJPEG_ERROR("True lossless encoder: Error encoding frame");
-          result = EC_CannotChangeRepresentation;
-        }
-        else
-        {
-          result = pixelSequence->storeCompressedFrame(offsetList, jpegData, jpegLen, djcp->getFragmentSize());
-        }
-        // free memory
-        delete[] jpegData;
       }
     }
     else
@@ -735,6 +853,71 @@ OFCondition DJCodecEncoder::encodeTrueLossless(
 }
 
 
+OFCondition DJCodecEncoder::encodeFrames(
+  DJEncoder *jpeg,
+  const DcmRepresentationParameter * toRepParam,
+  const DJCodecParameter *cp,
+  Uint8 encoderBits,
+  DicomImage *image,
+  const Uint8 *pixelData,
+  size_t frameCount,
+  Uint16 columns,
+  Uint16 rows,
+  EP_Interpretation interpr,
+  Uint16 samplesPerPixel,
+  DcmPixelSequence *pixelSequence,
+  DcmOffsetList& offsetList,
+  size_t& compressedSize) const
+{
+  OFCondition result = EC_Normal;
+
+  // there is no need for more threads than frames
+  size_t numberOfThreads = cp->getNumberOfThreads();
+  if (numberOfThreads == 0) numberOfThreads = OFThreadPool::getNumberOfProcessors();
+  if (numberOfThreads > frameCount) numberOfThreads = frameCount;
+  if (numberOfThreads == 0) numberOfThreads = 1;
+
+  // each thread needs its own encoder instance
+  OFVector<DJEncoder *> encoders;
+  encoders.push_back(jpeg);
+  while (encoders.size() < numberOfThreads)
+  {
+    DJEncoder *encoder = createEncoderInstance(toRepParam, cp, encoderBits);
+    if (encoder == NULL) break;
+    encoders.push_back(encoder);
+  }
+  if (encoders.size() > 1)
+    DCMJPEG_DEBUG("compressing " << frameCount << " frames using " << encoders.size() << " threads");
+
+  // compress a limited number of frames at a time (in order to limit the
+  // amount of memory needed) and store them in the original frame order
+  OFThreadPool pool(encoders.size());
+  const size_t framesPerRun = encoders.size() * 4;
+  DJFrameEncoderTask task(encoders, image, pixelData, columns, rows, interpr, samplesPerPixel, framesPerRun);
+  for (size_t firstFrame = 0; (firstFrame < frameCount) && result.good(); firstFrame += framesPerRun)
+  {
+    const size_t numberOfFrames = (frameCount - firstFrame < framesPerRun) ? frameCount - firstFrame : framesPerRun;
+    task.setFirstFrame(firstFrame);
+    pool.run(task, numberOfFrames);
+    for (size_t i = 0; (i < numberOfFrames) && result.good(); ++i)
+    {
+      result = task.result[i];
+      if (result.good())
+      {
+        result = pixelSequence->storeCompressedFrame(offsetList, task.jpegData[i], task.jpegLen[i], cp->getFragmentSize());
+        compressedSize += task.jpegLen[i];
+      }
+    }
+    task.clear();
+  }
+
+  // the encoder of the calling thread is owned by the caller
+  for (size_t i = 1; i < encoders.size(); ++i)
+    delete encoders[i];
+  return result;
+}
+
+
 void DJCodecEncoder::appendCompressionRatio(
   OFString& arg,
   double ratio)
@@ -1185,43 +1368,15 @@ OFCondition DJCodecEncoder::encodeMonochromeImage(
 
       // render and compress each frame
       size_t frameCount = dimage.getFrameCount();
-      unsigned short bytesPerSample = jpeg->bytesPerSample();
       unsigned short columns = OFstatic_cast(unsigned short, dimage.getWidth());
       unsigned short rows = OFstatic_cast(unsigned short, dimage.getHeight());
-      Uint8 *jpegData = NULL;
-      Uint32 jpegLen  = 0;
-      const void *frame = NULL;
 
       // compute original image size in bytes, ignoring any padding bits.
       Uint16 samplesPerPixel = 0;
       if ((dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel)).bad()) samplesPerPixel = 1;
       uncompressedSize = OFstatic_cast(double, columns * rows * pixelDepth * frameCount * samplesPerPixel) / 8.0;
-      for (size_t i=0; (i<frameCount) && (result.good()); i++)
-      {
-        frame = dimage.getOutputData(bitsPerSample, OFstatic_cast(unsigned long, i), 0);
-        if (frame == NULL) result = EC_MemoryExhausted;
-        else
-        {
-          // compress frame
-          jpegData = NULL;
-          if (bytesPerSample == 1)
-          {
-            result = jpeg->encode(columns, rows, EPI_Monochrome2, 1, OFreinterpret_cast(Uint8*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          } else {
-            result = jpeg->encode(columns, rows, EPI_Monochrome2, 1, OFreinterpret_cast(Uint16*, OFconst_cast(void*, frame)), jpegData, jpegLen);
-          }
-
-          // store frame
-          if (result.good())
-          {
-            result = pixelSequence->storeCompressedFrame(offsetList, jpegData, jpegLen, cp->getFragmentSize());
-          }
-
-          // delete block of JPEG data
-          delete[] jpegData;
-          compressedSize += jpegLen;
-        }
-      }
+      result = encodeFrames(jpeg, toRepParam, cp, OFstatic_cast(Uint8, compressedBits), &dimage, NULL, frameCount,
+        columns, rows, EPI_Monochrome2, 1, pixelSequence, offsetList, compressedSize);
       delete jpeg;
     } else result = EC_MemoryExhausted;
   }
@@ -50,7 +50,8 @@ DJCodecParameter::DJCodecParameter(
     OFBool pUseModalityRescale,
     OFBool pAcceptWrongPaletteTags,
     OFBool pAcrNemaCompatibility,
-    OFBool pTrueLosslessMode)
+    OFBool pTrueLosslessMode,
+    size_t pNumberOfThreads)
 : DcmCodecParameter()
 , compressionCSConversion(pCompressionCSConversion)
 , decompressionCSConversion(pDecompressionCSConversion)
@@ -80,6 +81,7 @@ DJCodecParameter::DJCodecParameter(
 , predictor6WorkaroundEnabled_(predictor6WorkaroundEnable)
 , cornellWorkaroundEnabled_(cornellWorkaroundEnable)
 , forceSingleFragmentPerFrame(pForceSingleFragmentPerFrame)
+, numberOfThreads(pNumberOfThreads)
 {
 }
 
@@ -114,6 +116,7 @@ DJCodecParameter::DJCodecParameter(const DJCodecParameter& arg)
 , predictor6WorkaroundEnabled_(arg.predictor6WorkaroundEnabled_)
 , cornellWorkaroundEnabled_(arg.cornellWorkaroundEnabled_)
 , forceSingleFragmentPerFrame(arg.forceSingleFragmentPerFrame)
+, numberOfThreads(arg.numberOfThreads)
 {
 }
 
@@ -64,7 +64,8 @@ void DJEncoderRegistration::registerCodecs(
     OFBool pUseModalityRescale,
     OFBool pAcceptWrongPaletteTags,
     OFBool pAcrNemaCompatibility,
-    OFBool pRealLossless)
+    OFBool pRealLossless,
+    size_t pNumberOfThreads)
 {
   if (! registered)
   {
@@ -96,7 +97,8 @@ void DJEncoderRegistration::registerCodecs(
       pUseModalityRescale,
       pAcceptWrongPaletteTags,
       pAcrNemaCompatibility,
-      pRealLossless);
+      pRealLossless,
+      pNumberOfThreads);
     if (cp)
     {
       // baseline JPEG
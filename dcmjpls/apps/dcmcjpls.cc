@@ -80,6 +80,7 @@ int main(int argc, char *argv[])
 
   // encapsulated pixel data encoding options
   OFCmdUnsignedInt opt_fragmentSize = 0; // 0=unlimited
+  OFCmdUnsignedInt opt_threads = 1;
   OFBool           opt_createOffsetTable = OFTrue;
   JLS_UIDCreation  opt_uidcreation = EJLSUC_default;
   OFBool           opt_secondarycapture = OFFalse;
@@ -154,6 +155,9 @@ LICENSE_FILE_DECLARE_COMMAND_LINE_OPTIONS
     cmd.addSubGroup("JPEG-LS padding of odd-length bitstreams:");
       cmd.addOption("--padding-standard",       "+ps",    "pad with extended EOI marker (default)");
       cmd.addOption("--padding-zero",           "+pz",    "pad with zero byte (non-standard)");
+    cmd.addSubGroup("multi-frame compression:");
+      cmd.addOption("--threads",                "+th", 1, "[n]umber: integer (0 = number of CPUs)",
+                                                          "compress up to n frames in parallel (default: 1)");
 
   cmd.addGroup("encapsulated pixel data encoding options:");
     cmd.addSubGroup("pixel data fragmentation:");
@@ -338,6 +342,12 @@ LICENSE_FILE_EVALUATE_COMMAND_LINE_OPTIONS
       }
       cmd.endOptionBlock();
 
+      // multi-frame compression
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValue(opt_threads));
+      }
+
       // encapsulated pixel data encoding options
       // pixel data fragmentation options
       cmd.beginOptionBlock();
@@ -408,7 +418,8 @@ LICENSE_FILE_EVALUATE_COMMAND_LINE_OPTIONS
       OFstatic_cast(Uint16, opt_t1), OFstatic_cast(Uint16, opt_t2), OFstatic_cast(Uint16, opt_t3),
       OFstatic_cast(Uint16, opt_reset),
       opt_prefer_cooked, opt_fragmentSize, opt_createOffsetTable,
-      opt_uidcreation, opt_secondarycapture, opt_interleaveMode, opt_useFFpadding);
+      opt_uidcreation, opt_secondarycapture, opt_interleaveMode, opt_useFFpadding,
+      OFstatic_cast(size_t, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
@@ -72,6 +72,7 @@ int main(int argc, char *argv[])
   JLS_UIDCreation opt_uidcreation = EJLSUC_default;
   JLS_PlanarConfiguration opt_planarconfig = EJLSPC_restore;
   OFBool opt_ignoreOffsetTable = OFFalse;
+  OFCmdUnsignedInt opt_threads = 1;
 
 #ifdef USE_LICENSE_FILE
 LICENSE_FILE_DECLARATIONS
@@ -113,6 +114,8 @@ LICENSE_FILE_DECLARE_COMMAND_LINE_OPTIONS
       cmd.addOption("--workaround-incpl",       "+wi",    "enable workaround for incomplete JPEG-LS data");
     cmd.addSubGroup("other processing options:");
       cmd.addOption("--ignore-offsettable",     "+io",    "ignore offset table when decompressing");
+      cmd.addOption("--threads",                "+th", 1, "[n]umber: integer (0 = number of CPUs)",
+                                                          "decompress up to n frames in parallel (default: 1)");
 
   cmd.addGroup("output options:");
     cmd.addSubGroup("output file format:");
@@ -184,6 +187,10 @@ LICENSE_FILE_EVALUATE_COMMAND_LINE_OPTIONS
 
       if (cmd.findOption("--workaround-incpl")) opt_forceSingleFragmentPerFrame = OFTrue;
       if (cmd.findOption("--ignore-offsettable")) opt_ignoreOffsetTable = OFTrue;
+      if (cmd.findOption("--threads"))
+      {
+        app.checkValue(cmd.getValue(opt_threads));
+      }
 
       cmd.beginOptionBlock();
       if (cmd.findOption("--read-file"))
@@ -258,7 +265,8 @@ LICENSE_FILE_EVALUATE_COMMAND_LINE_OPTIONS
         opt_uidcreation,
         opt_planarconfig,
         opt_ignoreOffsetTable,
-        opt_forceSingleFragmentPerFrame);
+        opt_forceSingleFragmentPerFrame,
+        OFstatic_cast(size_t, opt_threads));
 
     /* make sure data dictionary is loaded */
     if (!dcmDataDict.isDictionaryLoaded())
@@ -239,6 +239,71 @@ private:
     Uint16 imageSamplesPerPixel,
     Uint16 bytesPerSample);
 
+  /** copies the compressed bitstream of a single frame from the given pixel
+   *  sequence into a newly allocated buffer.
+   *  @param fromPixSeq compressed pixel sequence
+   *  @param cp codec parameters for this codec
+   *  @param frameNo number of frame, starting with 0 for the first frame
+   *  @param currentItem index of the compressed fragment that contains
+   *    all or the first part of the compressed bitstream for the given frameNo.
+   *    Upon return this parameter is updated to contain the index
+   *    of the first compressed fragment of the next frame.
+   *  @param imageFrames number of frames in this image
+   *  @param jlsData compressed bitstream (allocated on the heap with new[])
+   *    returned in this parameter upon success
+   *  @param compressedSize size of the compressed bitstream returned in this parameter
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition readCompressedFrame(
+    DcmPixelSequence * fromPixSeq,
+    const DJLSCodecParameter *cp,
+    Uint32 frameNo,
+    Uint32& currentItem,
+    Sint32 imageFrames,
+    Uint8 *&jlsData,
+    size_t& compressedSize);
+
+  /** decompresses the compressed bitstream of a single frame and stores the
+   *  result in the given buffer. This method does not access the dataset, so
+   *  it may be called concurrently for different frames of the same image.
+   *  @param jlsData compressed bitstream
+   *  @param compressedSize size of the compressed bitstream
+   *  @param buffer pointer to buffer where frame is to be stored
+   *  @param bufSize size of buffer in bytes
+   *  @param imageColumns number of columns for each frame
+   *  @param imageRows number of rows for each frame
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @param bytesPerSample number of bytes per sample
+   *  @param imagePlanarConfiguration planar configuration of the decompressed frame
+   *  @return EC_Normal if successful, an error code otherwise.
+   */
+  static OFCondition decompressFrame(
+    const Uint8 *jlsData,
+    size_t compressedSize,
+    void *buffer,
+    Uint32 bufSize,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample,
+    Uint16 imagePlanarConfiguration);
+
+  /** determines the planar configuration of the decompressed image
+   *  depending on the codec parameters and the dataset.
+   *  @param cp codec parameters for this codec
+   *  @param dataset pointer to dataset in which pixel data element is contained
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @return planar configuration, 0 for color-by-pixel, 1 for color-by-plane
+   */
+  static Uint16 determinePlanarConfiguration(
+    const DJLSCodecParameter *cp,
+    DcmItem *dataset,
+    Uint16 imageSamplesPerPixel);
+
+  /// helper class decompressing a number of frames, possibly in parallel
+  class FrameTask;
+  friend class FrameTask;
+
   /** determines if a given image requires color-by-plane planar configuration
    *  depending on SOP Class UID (DICOM IOD) and photometric interpretation.
    *  All SOP classes defined in the 2003 edition of the DICOM standard or earlier
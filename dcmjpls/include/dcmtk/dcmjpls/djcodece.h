@@ -286,8 +286,8 @@ private:
    *  @param samplesPerPixel image samples per pixel
    *  @param planarConfiguration image planar configuration
    *  @param photometricInterpretation photometric interpretation of the DICOM dataset
-   *  @param pixelSequence object in which the compressed frame is stored
-   *  @param offsetList list of frame offsets updated in this parameter
+   *  @param compressedData compressed frame (allocated on the heap with new[])
+   *    returned in this parameter upon success
    *  @param compressedSize size of compressed frame returned in this parameter
    *  @param djcp parameters for the codec
    *  @return EC_Normal if successful, an error code otherwise
@@ -300,16 +300,15 @@ private:
     Uint16 samplesPerPixel,
     Uint16 planarConfiguration,
     const OFString& photometricInterpretation,
-    DcmPixelSequence *pixelSequence,
-    DcmOffsetList &offsetList,
+    Uint8 *&compressedData,
     unsigned long &compressedSize,
     const DJLSCodecParameter *djcp) const;
 
   /** perform the lossless cooked compression of a single frame
-   *  @param pixelSequence object in which the compressed frame is stored
    *  @param dimage DicomImage instance used to process frame
    *  @param photometricInterpretation photometric interpretation of the DICOM dataset
-   *  @param offsetList list of frame offsets updated in this parameter
+   *  @param compressedData compressed frame (allocated on the heap with new[])
+   *    returned in this parameter upon success
    *  @param compressedSize size of compressed frame returned in this parameter
    *  @param djcp parameters for the codec
    *  @param frame frame index
@@ -317,15 +316,38 @@ private:
    *  @return EC_Normal if successful, an error code otherwise
    */
   OFCondition compressCookedFrame(
-    DcmPixelSequence *pixelSequence,
     DicomImage *dimage,
     const OFString& photometricInterpretation,
-    DcmOffsetList &offsetList,
+    Uint8 *&compressedData,
     unsigned long &compressedSize,
     const DJLSCodecParameter *djcp,
     Uint32 frame,
     Uint16 nearLosslessDeviation) const;
 
+  /// helper class compressing a number of frames, possibly in parallel
+  class FrameTask;
+  friend class FrameTask;
+
+  /** compress all frames of an image, either with the raw or with the cooked
+   *  encoder, and store the compressed frames in the given pixel sequence
+   *  (in frame order). Depending on the codec parameters, several frames are
+   *  compressed in parallel. The result does not depend on the number of threads.
+   *  @param task task that compresses a single frame
+   *  @param frameCount number of frames to be compressed
+   *  @param pixelSequence object in which the compressed frames are stored
+   *  @param offsetList list of frame offsets updated in this parameter
+   *  @param compressedSize total size of the compressed frames returned in this parameter
+   *  @param djcp parameters for the codec
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition compressFrames(
+    FrameTask& task,
+    unsigned long frameCount,
+    DcmPixelSequence *pixelSequence,
+    DcmOffsetList &offsetList,
+    unsigned long &compressedSize,
+    const DJLSCodecParameter *djcp) const;
+
   /** Convert an image from sample interleaved to uninterleaved.
    *  @param target A buffer where the converted image will be stored
    *  @param source The image buffer to be converted
@@ -65,6 +65,8 @@ public:
    *  @param ignoreOffsetTable         flag indicating whether to ignore the offset table when decompressing multiframe images
    *  @param jplsInterleaveMode        flag describing which interleave the JPEG-LS datastream should use
    *  @param useFFbitstreamPadding     flag indicating whether the JPEG-LS bitstream should be FF padded as required by DICOM.
+   *  @param numberOfThreads           maximum number of threads used for compressing the frames of a multi-frame image
+   *                                   in parallel, 0 for the number of processors
    */
    DJLSCodecParameter(
      OFBool preferCookedEncoding,
@@ -79,7 +81,8 @@ public:
      JLS_PlanarConfiguration planarConfiguration = EJLSPC_restore,
      OFBool ignoreOffsetTable = OFFalse,
      interleaveMode jplsInterleaveMode = interleaveLine,
-     OFBool useFFbitstreamPadding = OFTrue );
+     OFBool useFFbitstreamPadding = OFTrue,
+     size_t numberOfThreads = 1);
 
   /** constructor, for use with decoders. Initializes all encoder options to defaults.
    *  @param uidCreation                 mode for SOP Instance UID creation (used both for encoding and decoding)
@@ -87,12 +90,15 @@ public:
    *  @param ignoreOffsetTable           flag indicating whether to ignore the offset table when decompressing multiframe images
    *  @param forceSingleFragmentPerFrame while decompressing a multiframe image, assume one fragment per frame even if the JPEG
    *                                     data for some frame is incomplete
+   *  @param numberOfThreads             maximum number of threads used for decompressing the frames of a multi-frame
+   *                                     image in parallel, 0 for the number of processors
    */
   DJLSCodecParameter(
     JLS_UIDCreation uidCreation = EJLSUC_default,
     JLS_PlanarConfiguration planarConfiguration = EJLSPC_restore,
     OFBool ignoreOffsetTable = OFFalse,
-    OFBool forceSingleFragmentPerFrame = OFFalse);
+    OFBool forceSingleFragmentPerFrame = OFFalse,
+    size_t numberOfThreads = 1);
 
   /// copy constructor
   DJLSCodecParameter(const DJLSCodecParameter& arg);
@@ -224,6 +230,14 @@ public:
     return useFFbitstreamPadding_;
   }
 
+  /** returns maximum number of threads used for compressing or decompressing the frames of a multi-frame image
+   *  @return maximum number of threads, 0 for the number of processors
+   */
+  size_t getNumberOfThreads() const
+  {
+    return numberOfThreads_;
+  }
+
 private:
 
   /// private undefined copy assignment operator
@@ -284,6 +298,14 @@ private:
    */
   OFBool forceSingleFragmentPerFrame_;
 
+  // ****************************************************
+  // **** Parameters used for encoding and decoding  ****
+
+  /** maximum number of threads used for compressing or decompressing the frames
+   *  of a multi-frame image in parallel, 0 for the number of processors
+   */
+  size_t numberOfThreads_;
+
 };
 
 
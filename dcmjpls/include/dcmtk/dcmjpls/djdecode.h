@@ -46,12 +46,15 @@ public:
    *  @param ignoreOffsetTable flag indicating whether to ignore the offset table when decompressing multiframe images
    *  @param forceSingleFragmentPerFrame while decompressing a multiframe image,
    *    assume one fragment per frame even if the JPEG data for some frame is incomplete
+   *  @param numberOfThreads maximum number of threads used for decompressing the frames
+   *    of a multi-frame image in parallel, 0 for the number of processors
    */
   static void registerCodecs(
     JLS_UIDCreation uidcreation = EJLSUC_default,
     JLS_PlanarConfiguration planarconfig = EJLSPC_restore,
     OFBool ignoreOffsetTable = OFFalse,
-    OFBool forceSingleFragmentPerFrame = OFFalse);
+    OFBool forceSingleFragmentPerFrame = OFFalse,
+    size_t numberOfThreads = 1);
 
   /** deregisters decoders.
    *  Attention: Must not be called while other threads might still use
@@ -52,6 +52,8 @@ public:
    *  @param convertToSC               flag indicating whether image should be converted to Secondary Capture upon compression
    *  @param jplsInterleaveMode        flag describing which interleave the JPEG-LS datastream should use
    *  @param useFFbitstreamPadding     flag indicating whether the JPEG-LS bitstream should be FF padded as required by DICOM.
+   *  @param numberOfThreads           maximum number of threads used for compressing the frames of a multi-frame image
+   *                                   in parallel, 0 for the number of processors
    */
   static void registerCodecs(
     Uint16 jpls_t1 = 0,
@@ -64,7 +66,8 @@ public:
     JLS_UIDCreation uidCreation = EJLSUC_default,
     OFBool convertToSC = OFFalse,
     DJLSCodecParameter::interleaveMode jplsInterleaveMode = DJLSCodecParameter::interleaveDefault,
-    OFBool useFFbitstreamPadding = OFTrue );
+    OFBool useFFbitstreamPadding = OFTrue,
+    size_t numberOfThreads = 1);
 
   /** deregisters encoders.
    *  Attention: Must not be called while other threads might still use
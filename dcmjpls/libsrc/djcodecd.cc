@@ -26,6 +26,8 @@
 #include "dcmtk/ofstd/ofcast.h"      /* for casts */
 #include "dcmtk/ofstd/offile.h"      /* for class OFFile */
 #include "dcmtk/ofstd/ofstd.h"       /* for class OFStandard */
+#include "dcmtk/ofstd/ofthpool.h"    /* for class OFThreadPool */
+#include "dcmtk/ofstd/ofvector.h"    /* for class OFVector */
 #include "dcmtk/dcmdata/dcdatset.h"  /* for class DcmDataset */
 #include "dcmtk/dcmdata/dcdeftag.h"  /* for tag constants */
 #include "dcmtk/dcmdata/dcpixseq.h"  /* for class DcmPixelSequence */
@@ -76,6 +78,138 @@ OFBool DJLSDecoderBase::canChangeCoding(
 }
 
 
+/** helper class decompressing a number of consecutive frames of an image,
+ *  possibly in parallel. The compressed bitstreams are read from the pixel
+ *  sequence beforehand, so the frames can be decompressed independently of
+ *  each other and without accessing the dataset.
+ */
+class DJLSDecoderBase::FrameTask: public OFThreadPool::Task
+{
+public:
+
+  /** constructor
+   *  @param pixelData buffer for the uncompressed pixel data of all frames
+   *  @param frameSize size of an uncompressed frame in bytes
+   *  @param imageColumns number of columns for each frame
+   *  @param imageRows number of rows for each frame
+   *  @param imageSamplesPerPixel number of samples per pixel
+   *  @param bytesPerSample number of bytes per sample
+   *  @param imagePlanarConfiguration planar configuration of the decompressed frames
+   */
+  FrameTask(
+    Uint8 *pixelData,
+    Uint32 frameSize,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample,
+    Uint16 imagePlanarConfiguration)
+  : pixelData_(pixelData)
+  , frameSize_(frameSize)
+  , imageColumns_(imageColumns)
+  , imageRows_(imageRows)
+  , imageSamplesPerPixel_(imageSamplesPerPixel)
+  , bytesPerSample_(bytesPerSample)
+  , imagePlanarConfiguration_(imagePlanarConfiguration)
+  , firstFrame_(0)
+  , jlsData()
+  , compressedSize()
+  , result()
+  {
+  }
+
+  /// destructor
+  virtual ~FrameTask()
+  {
+    clear();
+  }
+
+  /** prepare the next run
+   *  @param firstFrame index of the frame decompressed as the first work item
+   *  @param numberOfFrames number of frames decompressed by the next run
+   */
+  void prepare(Sint32 firstFrame, Sint32 numberOfFrames)
+  {
+    firstFrame_ = firstFrame;
+    jlsData.clear();
+    jlsData.resize(numberOfFrames, OFstatic_cast(Uint8 *, NULL));
+    compressedSize.clear();
+    compressedSize.resize(numberOfFrames, 0);
+    // frames that have not been processed are reported as failed
+    result.clear();
+    result.resize(numberOfFrames, EC_IllegalCall);
+  }
+
+  /// delete the compressed bitstreams of the last run
+  void clear()
+  {
+    for (size_t i = 0; i < jlsData.size(); ++i)
+    {
+      delete[] jlsData[i];
+      jlsData[i] = NULL;
+    }
+  }
+
+  /** decompress a single frame
+   *  @param index index of the frame relative to the first frame
+   *  @param thread index of the calling thread (not used)
+   *  @return always OFTrue, since an invalid bitstream of a single frame
+   *    may be ignored (see DJLSCodecParameter::getForceSingleFragmentPerFrame())
+   */
+  virtual OFBool execute(const size_t index, const size_t /* thread */)
+  {
+    const size_t frame = OFstatic_cast(size_t, firstFrame_) + index;
+    result[index] = DJLSDecoderBase::decompressFrame(jlsData[index], compressedSize[index],
+      pixelData_ + frame * frameSize_, frameSize_, imageColumns_, imageRows_,
+      imageSamplesPerPixel_, bytesPerSample_, imagePlanarConfiguration_);
+    return OFTrue;
+  }
+
+private:
+
+  /// private undefined copy constructor
+  FrameTask(const FrameTask&);
+
+  /// private undefined copy assignment operator
+  FrameTask& operator=(const FrameTask&);
+
+  /// buffer for the uncompressed pixel data of all frames
+  Uint8 *pixelData_;
+
+  /// size of an uncompressed frame in bytes
+  Uint32 frameSize_;
+
+  /// number of columns for each frame
+  Uint16 imageColumns_;
+
+  /// number of rows for each frame
+  Uint16 imageRows_;
+
+  /// number of samples per pixel
+  Uint16 imageSamplesPerPixel_;
+
+  /// number of bytes per sample
+  Uint16 bytesPerSample_;
+
+  /// planar configuration of the decompressed frames
+  Uint16 imagePlanarConfiguration_;
+
+  /// index of the frame decompressed as the first work item
+  Sint32 firstFrame_;
+
+public:
+
+  /// compressed bitstreams of the frames of the current run, indexed by work item
+  OFVector<Uint8 *> jlsData;
+
+  /// size of the compressed bitstreams of the current run
+  OFVector<size_t> compressedSize;
+
+  /// status of the decompression of each frame of the last run
+  OFVector<OFCondition> result;
+};
+
+
 OFCondition DJLSDecoderBase::decode(
     const DcmRepresentationParameter * /* fromRepParam */,
     DcmPixelSequence * pixSeq,
@@ -151,45 +285,63 @@ OFCondition DJLSDecoderBase::decode(
   const DJLSCodecParameter *djcp = OFreinterpret_cast(const DJLSCodecParameter *, cp);
 
   // determine planar configuration for uncompressed data
-  OFString imageSopClass;
-  OFString imagePhotometricInterpretation;
-  dataset->findAndGetOFString(DCM_SOPClassUID, imageSopClass);
-  dataset->findAndGetOFString(DCM_PhotometricInterpretation, imagePhotometricInterpretation);
+  Uint16 imagePlanarConfiguration = determinePlanarConfiguration(djcp, dataset, imageSamplesPerPixel);
 
   // allocate space for uncompressed pixel data element
   Uint16 *pixeldata16 = NULL;
   OFCondition result = uncompressedPixelData.createUint16Array(totalSize/sizeof(Uint16), pixeldata16);
   if (result.bad()) return result;
 
-  Uint8 *pixeldata8 = OFreinterpret_cast(Uint8 *, pixeldata16);
   Sint32 currentFrame = 0;
   Uint32 currentItem = 1; // item 0 contains the offset table
-  OFBool done = OFFalse;
+  OFBool frameDecoded = OFFalse;
   OFBool forceSingleFragmentPerFrame = djcp->getForceSingleFragmentPerFrame();
 
-  while (result.good() && !done)
+  // the compressed bitstreams are read one after the other (the position of a frame
+  // in the pixel sequence depends on the previous frames), but then a limited number
+  // of frames is decompressed in parallel
+  OFThreadPool pool(djcp->getNumberOfThreads());
+  if ((pool.getNumberOfThreads() > 1) && (imageFrames > 1))
+    DCMJPLS_DEBUG("JPEG-LS decoder uses up to " << pool.getNumberOfThreads() << " threads");
+  const Sint32 framesPerRun = OFstatic_cast(Sint32, pool.getNumberOfThreads() * 4);
+  FrameTask task(OFreinterpret_cast(Uint8 *, pixeldata16), frameSize, imageColumns, imageRows,
+    imageSamplesPerPixel, bytesPerSample, imagePlanarConfiguration);
+
+  while (result.good() && (currentFrame < imageFrames))
   {
-      DCMJPLS_DEBUG("JPEG-LS decoder processes frame " << (currentFrame+1));
-
-      result = decodeFrame(pixSeq, djcp, dataset, currentFrame, currentItem, pixeldata8, frameSize,
-          imageFrames, imageColumns, imageRows, imageSamplesPerPixel, bytesPerSample);
-
-      // check if we should enforce "one fragment per frame" while
-      // decompressing a multi-frame image even if stream suspension occurs
-      if ((result == EC_JLSInvalidCompressedData) && forceSingleFragmentPerFrame)
+      const Sint32 numberOfFrames = (imageFrames - currentFrame < framesPerRun) ? imageFrames - currentFrame : framesPerRun;
+      task.prepare(currentFrame, numberOfFrames);
+      for (Sint32 i = 0; (i < numberOfFrames) && result.good(); ++i)
       {
-        // frame is incomplete. Nevertheless skip to next frame.
-        // This permits decompression of faulty multi-frame images.
-        DCMJPLS_WARN("JPEG-LS bitstream invalid or incomplete, ignoring (but image is likely to be incomplete).");
-        result = EC_Normal;
+        DCMJPLS_DEBUG("JPEG-LS decoder processes frame " << (currentFrame+i+1));
+        result = readCompressedFrame(pixSeq, djcp, currentFrame+i, currentItem, imageFrames,
+          task.jlsData[i], task.compressedSize[i]);
       }
+      if (result.good()) pool.run(task, numberOfFrames);
 
-      if (result.good())
+      for (Sint32 i = 0; (i < numberOfFrames) && result.good(); ++i)
       {
-        // increment frame number, check if we're finished
-        if (++currentFrame == imageFrames) done = OFTrue;
-        pixeldata8 += frameSize;
+        result = task.result[i];
+
+        // check if we should enforce "one fragment per frame" while
+        // decompressing a multi-frame image even if stream suspension occurs
+        if ((result == EC_JLSInvalidCompressedData) && forceSingleFragmentPerFrame)
+        {
+          // frame is incomplete. Nevertheless skip to next frame.
+          // This permits decompression of faulty multi-frame images.
+          DCMJPLS_WARN("JPEG-LS bitstream invalid or incomplete, ignoring (but image is likely to be incomplete).");
+          result = EC_Normal;
+        }
+        else if (result.good()) frameDecoded = OFTrue;
       }
+      task.clear();
+      currentFrame += numberOfFrames;
+  }
+
+  // update planar configuration if we have decoded a color image
+  if (result.good() && frameDecoded && (imageSamplesPerPixel > 1))
+  {
+    dataset->putAndInsertUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
   }
 
   // Number of Frames might have changed in case the previous value was wrong
@@ -314,50 +466,54 @@ OFCondition DJLSDecoderBase::decodeFrame(
     Uint16 imageSamplesPerPixel,
     Uint16 bytesPerSample)
 {
-  DcmPixelItem *pixItem = NULL;
   Uint8 * jlsData = NULL;
+  size_t compressedSize = 0;
+
+  // get the compressed data
+  OFCondition result = readCompressedFrame(fromPixSeq, cp, frameNo, currentItem, imageFrames, jlsData, compressedSize);
+
+  if (result.good())
+  {
+    // determine planar configuration for uncompressed data
+    Uint16 imagePlanarConfiguration = determinePlanarConfiguration(cp, dataset, imageSamplesPerPixel);
+
+    result = decompressFrame(jlsData, compressedSize, buffer, bufSize, imageColumns, imageRows,
+      imageSamplesPerPixel, bytesPerSample, imagePlanarConfiguration);
+    delete[] jlsData;
+
+    // update planar configuration if we are decoding a color image
+    if (result.good() && (imageSamplesPerPixel > 1))
+    {
+      dataset->putAndInsertUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
+    }
+  }
+
+  return result;
+}
+
+
+OFCondition DJLSDecoderBase::readCompressedFrame(
+    DcmPixelSequence * fromPixSeq,
+    const DJLSCodecParameter *cp,
+    Uint32 frameNo,
+    Uint32& currentItem,
+    Sint32 imageFrames,
+    Uint8 *&jlsData,
+    size_t& compressedSize)
+{
+  DcmPixelItem *pixItem = NULL;
   Uint8 * jlsFragmentData = NULL;
   Uint32 fragmentLength = 0;
-  size_t compressedSize = 0;
   Uint32 fragmentsForThisFrame = 0;
   OFCondition result = EC_Normal;
   OFBool ignoreOffsetTable = cp->ignoreOffsetTable();
+  jlsData = NULL;
+  compressedSize = 0;
 
   // compute the number of JPEG-LS fragments we need in order to decode the next frame
   fragmentsForThisFrame = computeNumberOfFragments(imageFrames, frameNo, currentItem, ignoreOffsetTable, fromPixSeq);
   if (fragmentsForThisFrame == 0) result = EC_JLSCannotComputeNumberOfFragments;
 
-  // determine planar configuration for uncompressed data
-  OFString imageSopClass;
-  OFString imagePhotometricInterpretation;
-  dataset->findAndGetOFString(DCM_SOPClassUID, imageSopClass);
-  dataset->findAndGetOFString(DCM_PhotometricInterpretation, imagePhotometricInterpretation);
-  Uint16 imagePlanarConfiguration = 0; // 0 is color-by-pixel, 1 is color-by-plane
-
-  if (imageSamplesPerPixel > 1)
-  {
-    switch (cp->getPlanarConfiguration())
-    {
-      case EJLSPC_restore:
-        // get planar configuration from dataset
-        imagePlanarConfiguration = 2; // invalid value
-        dataset->findAndGetUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
-        // determine auto default if not found or invalid
-        if (imagePlanarConfiguration > 1)
-          imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
-        break;
-      case EJLSPC_auto:
-        imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
-        break;
-      case EJLSPC_colorByPixel:
-        imagePlanarConfiguration = 0;
-        break;
-      case EJLSPC_colorByPlane:
-        imagePlanarConfiguration = 1;
-        break;
-    }
-  }
-
   // get the size of all the fragments
   if (result.good())
   {
@@ -397,74 +553,81 @@ OFCondition DJLSDecoderBase::decodeFrame(
         }
       }
     } /* while */
+
+    if (result.bad())
+    {
+      delete[] jlsData;
+      jlsData = NULL;
+    }
   }
 
+  return result;
+}
+
+
+OFCondition DJLSDecoderBase::decompressFrame(
+    const Uint8 *jlsData,
+    size_t compressedSize,
+    void *buffer,
+    Uint32 bufSize,
+    Uint16 imageColumns,
+    Uint16 imageRows,
+    Uint16 imageSamplesPerPixel,
+    Uint16 bytesPerSample,
+    Uint16 imagePlanarConfiguration)
+{
+  JlsParameters params;
+  JLS_ERROR err;
+
+  err = JpegLsReadHeader(jlsData, compressedSize, &params);
+  OFCondition result = DJLSError::convert(err);
+
   if (result.good())
   {
-    JlsParameters params;
-    JLS_ERROR err;
+    if (params.width != imageColumns) result = EC_JLSImageDataMismatch;
+    else if (params.height != imageRows) result = EC_JLSImageDataMismatch;
+    else if (params.components != imageSamplesPerPixel) result = EC_JLSImageDataMismatch;
+    else if ((bytesPerSample == 1) && (params.bitspersample > 8)) result = EC_JLSImageDataMismatch;
+    else if ((bytesPerSample == 2) && (params.bitspersample <= 8)) result = EC_JLSImageDataMismatch;
+  }
 
-    err = JpegLsReadHeader(jlsData, compressedSize, &params);
+  if (result.good())
+  {
+    err = JpegLsDecode(buffer, bufSize, jlsData, compressedSize, &params);
     result = DJLSError::convert(err);
 
-    if (result.good())
+    if (result.good() && imageSamplesPerPixel == 3)
     {
-      if (params.width != imageColumns) result = EC_JLSImageDataMismatch;
-      else if (params.height != imageRows) result = EC_JLSImageDataMismatch;
-      else if (params.components != imageSamplesPerPixel) result = EC_JLSImageDataMismatch;
-      else if ((bytesPerSample == 1) && (params.bitspersample > 8)) result = EC_JLSImageDataMismatch;
-      else if ((bytesPerSample == 2) && (params.bitspersample <= 8)) result = EC_JLSImageDataMismatch;
-    }
-
-    if (!result.good())
-    {
-      delete[] jlsData;
-    }
-    else
-    {
-      err = JpegLsDecode(buffer, bufSize, jlsData, compressedSize, &params);
-      result = DJLSError::convert(err);
-      delete[] jlsData;
-
-      if (result.good() && imageSamplesPerPixel == 3)
+      if (imagePlanarConfiguration == 1 && params.ilv != ILV_NONE)
       {
-        if (imagePlanarConfiguration == 1 && params.ilv != ILV_NONE)
-        {
-          // The dataset says this should be planarConfiguration == 1, but
-          // it isn't -> convert it.
-          DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"1\"");
-          if (bytesPerSample == 1)
-            result = createPlanarConfiguration1Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
-          else
-            result = createPlanarConfiguration1Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
-        }
-        else if (imagePlanarConfiguration == 0 && params.ilv != ILV_SAMPLE && params.ilv != ILV_LINE)
-        {
-          // The dataset says this should be planarConfiguration == 0, but
-          // it isn't -> convert it.
-          DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"0\"");
-          if (bytesPerSample == 1)
-            result = createPlanarConfiguration0Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
-          else
-            result = createPlanarConfiguration0Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
-        }
+        // The dataset says this should be planarConfiguration == 1, but
+        // it isn't -> convert it.
+        DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"1\"");
+        if (bytesPerSample == 1)
+          result = createPlanarConfiguration1Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
+        else
+          result = createPlanarConfiguration1Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
       }
-
-      if (result.good())
+      else if (imagePlanarConfiguration == 0 && params.ilv != ILV_SAMPLE && params.ilv != ILV_LINE)
       {
-          // decompression is complete, finally adjust byte order if necessary
-          if (bytesPerSample == 1) // we're writing bytes into words
-          {
-              result = swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, buffer,
-                      bufSize, sizeof(Uint16));
-          }
+        // The dataset says this should be planarConfiguration == 0, but
+        // it isn't -> convert it.
+        DCMJPLS_WARN("different planar configuration in JPEG stream, converting to \"0\"");
+        if (bytesPerSample == 1)
+          result = createPlanarConfiguration0Byte(OFreinterpret_cast(Uint8*, buffer), imageColumns, imageRows);
+        else
+          result = createPlanarConfiguration0Word(OFreinterpret_cast(Uint16*, buffer), imageColumns, imageRows);
       }
+    }
 
-      // update planar configuration if we are decoding a color image
-      if (result.good() && (imageSamplesPerPixel > 1))
-      {
-        dataset->putAndInsertUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
-      }
+    if (result.good())
+    {
+        // decompression is complete, finally adjust byte order if necessary
+        if (bytesPerSample == 1) // we're writing bytes into words
+        {
+            result = swapIfNecessary(gLocalByteOrder, EBO_LittleEndian, buffer,
+                    bufSize, sizeof(Uint16));
+        }
     }
   }
 
@@ -472,6 +635,44 @@ OFCondition DJLSDecoderBase::decodeFrame(
 }
 
 
+Uint16 DJLSDecoderBase::determinePlanarConfiguration(
+    const DJLSCodecParameter *cp,
+    DcmItem *dataset,
+    Uint16 imageSamplesPerPixel)
+{
+  OFString imageSopClass;
+  OFString imagePhotometricInterpretation;
+  dataset->findAndGetOFString(DCM_SOPClassUID, imageSopClass);
+  dataset->findAndGetOFString(DCM_PhotometricInterpretation, imagePhotometricInterpretation);
+  Uint16 imagePlanarConfiguration = 0; // 0 is color-by-pixel, 1 is color-by-plane
+
+  if (imageSamplesPerPixel > 1)
+  {
+    switch (cp->getPlanarConfiguration())
+    {
+      case EJLSPC_restore:
+        // get planar configuration from dataset
+        imagePlanarConfiguration = 2; // invalid value
+        dataset->findAndGetUint16(DCM_PlanarConfiguration, imagePlanarConfiguration);
+        // determine auto default if not found or invalid
+        if (imagePlanarConfiguration > 1)
+          imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
+        break;
+      case EJLSPC_auto:
+        imagePlanarConfiguration = determinePlanarConfiguration(imageSopClass, imagePhotometricInterpretation);
+        break;
+      case EJLSPC_colorByPixel:
+        imagePlanarConfiguration = 0;
+        break;
+      case EJLSPC_colorByPlane:
+        imagePlanarConfiguration = 1;
+        break;
+    }
+  }
+  return imagePlanarConfiguration;
+}
+
+
 OFCondition DJLSDecoderBase::encode(
     const Uint16 * /* pixelData */,
     const Uint32 /* length */,
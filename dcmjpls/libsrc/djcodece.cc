@@ -28,6 +28,8 @@
 #include "dcmtk/ofstd/ofstream.h"
 #include "dcmtk/ofstd/offile.h"      /* for class OFFile */
 #include "dcmtk/ofstd/ofbmanip.h"
+#include "dcmtk/ofstd/ofthpool.h"    /* for class OFThreadPool */
+#include "dcmtk/ofstd/ofvector.h"
 
 // dcmdata includes
 #include "dcmtk/dcmdata/dcdatset.h"  /* for class DcmDataset */
@@ -396,6 +398,248 @@ OFCondition DJLSEncoderBase::updateDerivationDescription(
 }
 
 
+/** helper class compressing a number of consecutive frames of an image,
+ *  possibly in parallel. The frames are either taken directly from the
+ *  uncompressed pixel data (raw encoder) or from the intermediate
+ *  representation of a DicomImage object (cooked encoder). The latter
+ *  is only read while compressing, so it can be shared by all threads.
+ */
+class DJLSEncoderBase::FrameTask: public OFThreadPool::Task
+{
+public:
+
+  /** constructor for the raw encoder
+   *  @param encoder encoder object
+   *  @param djcp parameters for the codec
+   *  @param pixelData uncompressed pixel data of all frames
+   *  @param frameSize size of a single frame in bytes
+   *  @param bitsAllocated number of bits allocated per pixel
+   *  @param columns frame width
+   *  @param rows frame height
+   *  @param samplesPerPixel image samples per pixel
+   *  @param planarConfiguration image planar configuration
+   *  @param photometricInterpretation photometric interpretation of the DICOM dataset
+   */
+  FrameTask(
+    const DJLSEncoderBase& encoder,
+    const DJLSCodecParameter *djcp,
+    const Uint8 *pixelData,
+    unsigned long frameSize,
+    Uint16 bitsAllocated,
+    Uint16 columns,
+    Uint16 rows,
+    Uint16 samplesPerPixel,
+    Uint16 planarConfiguration,
+    const OFString& photometricInterpretation)
+  : encoder_(encoder)
+  , djcp_(djcp)
+  , pixelData_(pixelData)
+  , frameSize_(frameSize)
+  , bitsAllocated_(bitsAllocated)
+  , columns_(columns)
+  , rows_(rows)
+  , samplesPerPixel_(samplesPerPixel)
+  , planarConfiguration_(planarConfiguration)
+  , dimage_(NULL)
+  , photometricInterpretation_(photometricInterpretation)
+  , nearLosslessDeviation_(0)
+  , firstFrame_(0)
+  , frameCount_(0)
+  , compressedData()
+  , compressedSize()
+  , result()
+  {
+  }
+
+  /** constructor for the cooked encoder
+   *  @param encoder encoder object
+   *  @param djcp parameters for the codec
+   *  @param dimage DicomImage instance used to process the frames
+   *  @param photometricInterpretation photometric interpretation of the DICOM dataset
+   *  @param nearLosslessDeviation maximum deviation for near-lossless encoding
+   */
+  FrameTask(
+    const DJLSEncoderBase& encoder,
+    const DJLSCodecParameter *djcp,
+    DicomImage *dimage,
+    const OFString& photometricInterpretation,
+    Uint16 nearLosslessDeviation)
+  : encoder_(encoder)
+  , djcp_(djcp)
+  , pixelData_(NULL)
+  , frameSize_(0)
+  , bitsAllocated_(0)
+  , columns_(0)
+  , rows_(0)
+  , samplesPerPixel_(0)
+  , planarConfiguration_(0)
+  , dimage_(dimage)
+  , photometricInterpretation_(photometricInterpretation)
+  , nearLosslessDeviation_(nearLosslessDeviation)
+  , firstFrame_(0)
+  , frameCount_(0)
+  , compressedData()
+  , compressedSize()
+  , result()
+  {
+  }
+
+  /// destructor
+  virtual ~FrameTask()
+  {
+    clear();
+  }
+
+  /** prepare the next run
+   *  @param firstFrame index of the frame compressed as the first work item
+   *  @param numberOfFrames number of frames compressed by the next run
+   *  @param frameCount total number of frames of the image
+   */
+  void prepare(unsigned long firstFrame, unsigned long numberOfFrames, unsigned long frameCount)
+  {
+    firstFrame_ = firstFrame;
+    frameCount_ = frameCount;
+    compressedData.clear();
+    compressedData.resize(numberOfFrames, OFstatic_cast(Uint8 *, NULL));
+    compressedSize.clear();
+    compressedSize.resize(numberOfFrames, 0);
+    // frames that have not been processed are reported as failed
+    result.clear();
+    result.resize(numberOfFrames, EC_IllegalCall);
+  }
+
+  /// delete the compressed frames of the last run
+  void clear()
+  {
+    for (size_t i = 0; i < compressedData.size(); ++i)
+    {
+      delete[] compressedData[i];
+      compressedData[i] = NULL;
+    }
+  }
+
+  /** compress a single frame
+   *  @param index index of the frame relative to the first frame
+   *  @param thread index of the calling thread (not used)
+   *  @return OFTrue if successful, OFFalse otherwise
+   */
+  virtual OFBool execute(const size_t index, const size_t /* thread */)
+  {
+    const unsigned long frame = firstFrame_ + OFstatic_cast(unsigned long, index);
+    DCMJPLS_DEBUG("JPEG-LS encoder processes frame " << (frame+1) << " of " << frameCount_);
+    if (dimage_)
+    {
+      result[index] = encoder_.compressCookedFrame(dimage_, photometricInterpretation_,
+        compressedData[index], compressedSize[index], djcp_, frame, nearLosslessDeviation_);
+    }
+    else
+    {
+      result[index] = encoder_.compressRawFrame(pixelData_ + frame * frameSize_, bitsAllocated_,
+        columns_, rows_, samplesPerPixel_, planarConfiguration_, photometricInterpretation_,
+        compressedData[index], compressedSize[index], djcp_);
+    }
+    return result[index].good();
+  }
+
+private:
+
+  /// private undefined copy constructor
+  FrameTask(const FrameTask&);
+
+  /// private undefined copy assignment operator
+  FrameTask& operator=(const FrameTask&);
+
+  /// encoder object
+  const DJLSEncoderBase& encoder_;
+
+  /// parameters for the codec
+  const DJLSCodecParameter *djcp_;
+
+  /// uncompressed pixel data of all frames (raw encoder only)
+  const Uint8 *pixelData_;
+
+  /// size of a single frame in bytes (raw encoder only)
+  unsigned long frameSize_;
+
+  /// number of bits allocated per pixel (raw encoder only)
+  Uint16 bitsAllocated_;
+
+  /// frame width (raw encoder only)
+  Uint16 columns_;
+
+  /// frame height (raw encoder only)
+  Uint16 rows_;
+
+  /// image samples per pixel (raw encoder only)
+  Uint16 samplesPerPixel_;
+
+  /// image planar configuration (raw encoder only)
+  Uint16 planarConfiguration_;
+
+  /// DicomImage instance used to process the frames (cooked encoder only)
+  DicomImage *dimage_;
+
+  /// photometric interpretation of the DICOM dataset
+  OFString photometricInterpretation_;
+
+  /// maximum deviation for near-lossless encoding (cooked encoder only)
+  Uint16 nearLosslessDeviation_;
+
+  /// index of the frame compressed as the first work item
+  unsigned long firstFrame_;
+
+  /// total number of frames of the image
+  unsigned long frameCount_;
+
+public:
+
+  /// compressed frames of the last run, indexed by work item
+  OFVector<Uint8 *> compressedData;
+
+  /// size of the compressed frames of the last run
+  OFVector<unsigned long> compressedSize;
+
+  /// status of the compression of each frame of the last run
+  OFVector<OFCondition> result;
+};
+
+
+OFCondition DJLSEncoderBase::compressFrames(
+  FrameTask& task,
+  unsigned long frameCount,
+  DcmPixelSequence *pixelSequence,
+  DcmOffsetList &offsetList,
+  unsigned long &compressedSize,
+  const DJLSCodecParameter *djcp) const
+{
+  OFCondition result = EC_Normal;
+  OFThreadPool pool(djcp->getNumberOfThreads());
+  if ((pool.getNumberOfThreads() > 1) && (frameCount > 1))
+    DCMJPLS_DEBUG("JPEG-LS encoder uses up to " << pool.getNumberOfThreads() << " threads");
+
+  // compress a limited number of frames at a time (in order to limit the
+  // amount of memory needed) and store them in the original frame order
+  const unsigned long framesPerRun = OFstatic_cast(unsigned long, pool.getNumberOfThreads() * 4);
+  for (unsigned long firstFrame = 0; (firstFrame < frameCount) && result.good(); firstFrame += framesPerRun)
+  {
+    const unsigned long numberOfFrames = (frameCount - firstFrame < framesPerRun) ? frameCount - firstFrame : framesPerRun;
+    task.prepare(firstFrame, numberOfFrames, frameCount);
+    pool.run(task, numberOfFrames);
+    for (unsigned long i = 0; (i < numberOfFrames) && result.good(); ++i)
+    {
+      result = task.result[i];
+      if (result.good())
+      {
+        result = pixelSequence->storeCompressedFrame(offsetList, task.compressedData[i], task.compressedSize[i], djcp->getFragmentSize());
+        compressedSize += task.compressedSize[i];
+      }
+    }
+    task.clear();
+  }
+  return result;
+}
+
+
 OFCondition DJLSEncoderBase::losslessRawEncode(
     const Uint16 *pixelData,
     const Uint32 length,
@@ -491,7 +735,6 @@ OFCondition DJLSEncoderBase::losslessRawEncode(
 
   DcmOffsetList offsetList;
   unsigned long compressedSize = 0;
-  unsigned long compressedFrameSize = 0;
   double uncompressedSize = 0.0;
 
   // render and compress each frame
@@ -507,22 +750,14 @@ OFCondition DJLSEncoderBase::losslessRawEncode(
 
     unsigned long frameCount = OFstatic_cast(unsigned long, numberOfFrames);
     unsigned long frameSize = columns * rows * samplesPerPixel * bytesAllocated;
-    const Uint8 *framePointer = OFreinterpret_cast(const Uint8 *, pixelData);
 
     // compute original image size in bytes, ignoring any padding bits.
     uncompressedSize = columns * rows * samplesPerPixel * bitsStored * frameCount / 8.0;
 
-    for (unsigned long i=0; (i<frameCount) && (result.good()); ++i)
-    {
-      // compress frame
-      DCMJPLS_DEBUG("JPEG-LS encoder processes frame " << (i+1) << " of " << frameCount);
-      result = compressRawFrame(framePointer, bitsAllocated, columns, rows,
-          samplesPerPixel, planarConfiguration, photometricInterpretation,
-          pixelSequence, offsetList, compressedFrameSize, djcp);
-
-      compressedSize += compressedFrameSize;
-      framePointer += frameSize;
-    }
+    // compress all frames
+    FrameTask task(*this, djcp, OFreinterpret_cast(const Uint8 *, pixelData), frameSize, bitsAllocated,
+      columns, rows, samplesPerPixel, planarConfiguration, photometricInterpretation);
+    result = compressFrames(task, frameCount, pixelSequence, offsetList, compressedSize, djcp);
   }
 
   // store pixel sequence if everything went well.
@@ -634,15 +869,13 @@ OFCondition DJLSEncoderBase::compressRawFrame(
   Uint16 samplesPerPixel,
   Uint16 planarConfiguration,
   const OFString& /* photometricInterpretation */,
-  DcmPixelSequence *pixelSequence,
-  DcmOffsetList &offsetList,
+  Uint8 *&compressedData,
   unsigned long &compressedSize,
   const DJLSCodecParameter *djcp) const
 {
   OFCondition result = EC_Normal;
   Uint16 bytesAllocated = bitsAllocated / 8;
   Uint32 frameSize = width*height*bytesAllocated*samplesPerPixel;
-  Uint32 fragmentSize = djcp->getFragmentSize();
   JlsParameters jls_params;
   Uint8 *frameBuffer = NULL;
 
@@ -749,10 +982,9 @@ OFCondition DJLSEncoderBase::compressRawFrame(
     {
       compressedSize = OFstatic_cast(unsigned long, bytesWritten);
       fixPaddingIfNecessary(OFstatic_cast(Uint8 *, buffer), size, compressedSize, djcp->getUseFFbitstreamPadding());
-      result = pixelSequence->storeCompressedFrame(offsetList, buffer, compressedSize, fragmentSize);
+      compressedData = buffer;
     }
-
-    delete[] buffer;
+    else delete[] buffer;
   }
 
   if (frameBuffer)
@@ -870,7 +1102,6 @@ OFCondition DJLSEncoderBase::losslessCookedEncode(
 
   DcmOffsetList offsetList;
   unsigned long compressedSize = 0;
-  unsigned long compressedFrameSize = 0;
   double uncompressedSize = 0.0;
 
   // render and compress each frame
@@ -884,15 +1115,9 @@ OFCondition DJLSEncoderBase::losslessCookedEncode(
     uncompressedSize = dimage->getWidth() * dimage->getHeight() *
       bitsPerSample * frameCount * samplesPerPixel / 8.0;
 
-    for (unsigned long i=0; (i<frameCount) && (result.good()); ++i)
-    {
-      // compress frame
-      DCMJPLS_DEBUG("JPEG-LS encoder processes frame " << (i+1) << " of " << frameCount);
-      result = compressCookedFrame(pixelSequence, dimage,
-          photometricInterpretation, offsetList, compressedFrameSize, djcp, i, nearLosslessDeviation);
-
-      compressedSize += compressedFrameSize;
-    }
+    // compress all frames
+    FrameTask task(*this, djcp, dimage, photometricInterpretation, nearLosslessDeviation);
+    result = compressFrames(task, frameCount, pixelSequence, offsetList, compressedSize, djcp);
   }
 
   // store pixel sequence if everything went well.
@@ -942,10 +1167,9 @@ OFCondition DJLSEncoderBase::losslessCookedEncode(
 
 
 OFCondition DJLSEncoderBase::compressCookedFrame(
-  DcmPixelSequence *pixelSequence,
   DicomImage *dimage,
   const OFString& /* photometricInterpretation */,
-  DcmOffsetList &offsetList,
+  Uint8 *&compressedData,
   unsigned long &compressedSize,
   const DJLSCodecParameter *djcp,
   Uint32 frame,
@@ -959,8 +1183,6 @@ OFCondition DJLSEncoderBase::compressCookedFrame(
   int depth = dimage->getDepth();
   if ((depth < 1) || (depth > 16)) return EC_JLSUnsupportedBitDepth;
 
-  Uint32 fragmentSize = djcp->getFragmentSize();
-
   const DiPixel *dinter = dimage->getInterData();
   if (dinter == NULL) return EC_IllegalCall;
 
@@ -1155,12 +1377,12 @@ OFCondition DJLSEncoderBase::compressCookedFrame(
   {
     // 'compressed_buffer_size' now contains the size of the compressed data in buffer
     compressedSize = OFstatic_cast(unsigned long, bytesWritten);
-    fixPaddingIfNecessary(OFstatic_cast(Uint8 *, buffer), compressed_buffer_size, compressedSize, djcp->getUseFFbitstreamPadding());
-    result = pixelSequence->storeCompressedFrame(offsetList, compressed_buffer, compressedSize, fragmentSize);
+    fixPaddingIfNecessary(OFstatic_cast(Uint8 *, compressed_buffer), compressed_buffer_size, compressedSize, djcp->getUseFFbitstreamPadding());
+    compressedData = compressed_buffer;
   }
+  else delete[] compressed_buffer;
 
   delete[] buffer;
-  delete[] compressed_buffer;
   if (frameBuffer)
     delete[] frameBuffer;
 
@@ -36,7 +36,8 @@ DJLSCodecParameter::DJLSCodecParameter(
      JLS_PlanarConfiguration planarConfiguration,
      OFBool ignoreOffsetTble,
      interleaveMode jplsInterleaveMode,
-     OFBool useFFbitstreamPadding)
+     OFBool useFFbitstreamPadding,
+     size_t numberOfThreads)
 : DcmCodecParameter()
 , preferCookedEncoding_(preferCookedEncoding)
 , jpls_t1_(jpls_t1)
@@ -52,6 +53,7 @@ DJLSCodecParameter::DJLSCodecParameter(
 , planarConfiguration_(planarConfiguration)
 , ignoreOffsetTable_(ignoreOffsetTble)
 , forceSingleFragmentPerFrame_(OFFalse)
+, numberOfThreads_(numberOfThreads)
 {
 }
 
@@ -60,7 +62,8 @@ DJLSCodecParameter::DJLSCodecParameter(
     JLS_UIDCreation uidCreation,
     JLS_PlanarConfiguration planarConfiguration,
     OFBool ignoreOffsetTble,
-    OFBool forceSingleFragmentPerFrame)
+    OFBool forceSingleFragmentPerFrame,
+    size_t numberOfThreads)
 : DcmCodecParameter()
 , preferCookedEncoding_(OFTrue)
 , jpls_t1_(0)
@@ -76,6 +79,7 @@ DJLSCodecParameter::DJLSCodecParameter(
 , planarConfiguration_(planarConfiguration)
 , ignoreOffsetTable_(ignoreOffsetTble)
 , forceSingleFragmentPerFrame_(forceSingleFragmentPerFrame)
+, numberOfThreads_(numberOfThreads)
 {
 }
 
@@ -95,6 +99,7 @@ DJLSCodecParameter::DJLSCodecParameter(const DJLSCodecParameter& arg)
 , planarConfiguration_(arg.planarConfiguration_)
 , ignoreOffsetTable_(arg.ignoreOffsetTable_)
 , forceSingleFragmentPerFrame_(arg.forceSingleFragmentPerFrame_)
+, numberOfThreads_(arg.numberOfThreads_)
 {
 }
 
@@ -35,11 +35,12 @@ void DJLSDecoderRegistration::registerCodecs(
     JLS_UIDCreation uidcreation,
     JLS_PlanarConfiguration planarconfig,
     OFBool ignoreOffsetTable,
-    OFBool forceSingleFragmentPerFrame)
+    OFBool forceSingleFragmentPerFrame,
+    size_t numberOfThreads)
 {
   if (! registered_)
   {
-    cp_ = new DJLSCodecParameter(uidcreation, planarconfig, ignoreOffsetTable, forceSingleFragmentPerFrame);
+    cp_ = new DJLSCodecParameter(uidcreation, planarconfig, ignoreOffsetTable, forceSingleFragmentPerFrame, numberOfThreads);
     if (cp_)
     {
       losslessdecoder_ = new DJLSLosslessDecoder();
@@ -43,13 +43,15 @@ void DJLSEncoderRegistration::registerCodecs(
     JLS_UIDCreation uidCreation,
     OFBool convertToSC,
     DJLSCodecParameter::interleaveMode jplsInterleaveMode,
-    OFBool useFFbitstreamPadding)
+    OFBool useFFbitstreamPadding,
+    size_t numberOfThreads)
 {
   if (! registered_)
   {
     cp_ = new DJLSCodecParameter(preferCookedEncoding, jpls_t1, jpls_t2, jpls_t3,
       jpls_reset, fragmentSize, createOffsetTable, uidCreation,
-      convertToSC, EJLSPC_restore, OFFalse, jplsInterleaveMode, useFFbitstreamPadding);
+      convertToSC, EJLSPC_restore, OFFalse, jplsInterleaveMode, useFFbitstreamPadding,
+      numberOfThreads);
 
     if (cp_)
     {
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013-2020, OFFIS e.V.
+ *  Copyright (C) 2013-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -30,6 +30,14 @@
 #include "dcmtk/dcmdata/cmdlnarg.h"  /* for prepareCmdLineArgs */
 #include "dcmtk/dcmnet/dstorscp.h"   /* for DcmStorageSCP */
 #include "dcmtk/dcmtls/tlsopt.h"     /* for DcmTLSOptions */
+#include "dcmtk/dcmdata/dcrledrg.h"  /* for RLE decoder */
+#include "dcmtk/dcmdata/dcrleerg.h"  /* for RLE encoder */
+#include "dcmtk/dcmjpeg/djdecode.h"  /* for JPEG decoders */
+#include "dcmtk/dcmjpeg/djencode.h"  /* for JPEG encoders */
+#include "dcmtk/dcmjpeg/djrplol.h"   /* for JPEG lossless representation parameter */
+#include "dcmtk/dcmjpls/djdecode.h"  /* for JPEG-LS decoders */
+#include "dcmtk/dcmjpls/djencode.h"  /* for JPEG-LS encoders */
+#include "dcmtk/dcmjpls/djrparam.h"  /* for JPEG-LS representation parameter */
 
 
 /* general definitions */
@@ -88,6 +96,10 @@ int main(int argc, char *argv[])
     OFCmdUnsignedInt opt_dimseTimeout = 0;
     OFCmdUnsignedInt opt_acseTimeout = 30;
     OFCmdUnsignedInt opt_maxPDULength = ASC_DEFAULTMAXPDU;
+    OFCmdUnsignedInt opt_preallocate = 0;
+    OFCmdUnsignedInt opt_transcodingWorkers = 2;
+    OFCmdUnsignedInt opt_transcodingQueue = 16;
+    E_TransferSyntax opt_archiveXfer = EXS_Unknown;
     T_DIMSE_BlockingMode opt_blockingMode = DIMSE_BLOCKING;
 
     OFBool opt_showPresentationContexts = OFFalse;  // default: do not show presentation contexts in verbose mode
@@ -153,6 +165,22 @@ int main(int argc, char *argv[])
         cmd.addOption("--normal",              "-B",      "allow implicit format conversions (default)");
         cmd.addOption("--bit-preserving",      "+B",      "write dataset exactly as received");
         cmd.addOption("--ignore",                         "ignore dataset, receive but do not store it");
+      cmd.addSubGroup("archive transfer syntax (only with --normal):");
+        cmd.addOption("--write-xfer-same",     "+xs",     "write with same TS as input (default)");
+        cmd.addOption("--write-xfer-little",   "+xe",     "write with explicit VR little endian TS");
+        cmd.addOption("--write-xfer-rle",      "+xr",     "write with RLE lossless TS");
+        cmd.addOption("--write-xfer-jpeg",     "+xj",     "write with JPEG lossless SV1 TS");
+        cmd.addOption("--write-xfer-jpls",     "+xl",     "write with JPEG-LS lossless TS");
+      cmd.addSubGroup("transcoding:");
+        CONVERT_TO_STRING("[n]umber: integer (0..64, default: " << opt_transcodingWorkers << ")", optString6);
+        cmd.addOption("--transcoding-workers", "+tw",  1, optString6.c_str(),
+                                                          "transcode received datasets in n threads\n(0 = transcode in association thread)");
+        CONVERT_TO_STRING("[n]umber: integer (1..1024, default: " << opt_transcodingQueue << ")", optString7);
+        cmd.addOption("--transcoding-queue",   "+tq",  1, optString7.c_str(),
+                                                          "queue at most n datasets for transcoding");
+      cmd.addSubGroup("other output options:");
+        cmd.addOption("--preallocate",         "+pa",  1, "[m]egabytes: integer (1..1024)",
+                                                          "reserve disk space in chunks of m MB while\nreceiving bit preserving (default: disabled)");
 
     /* evaluate command line */
     prepareCmdLineArgs(argc, argv, OFFIS_CONSOLE_APPLICATION);
@@ -249,14 +277,43 @@ int main(int argc, char *argv[])
         if (cmd.findOption("--normal"))
             opt_datasetStorage = DcmStorageSCP::DGM_StoreToFile;
         if (cmd.findOption("--bit-preserving"))
-        {
-            app.checkConflict("--bit-preserving", "--series-date-subdir", opt_directoryGeneration == DcmStorageSCP::DGM_SeriesDate);
             opt_datasetStorage = DcmStorageSCP::DGM_StoreBitPreserving;
-        }
         if (cmd.findOption("--ignore"))
             opt_datasetStorage = DcmStorageSCP::DSM_Ignore;
         cmd.endOptionBlock();
 
+        cmd.beginOptionBlock();
+        if (cmd.findOption("--write-xfer-same"))
+            opt_archiveXfer = EXS_Unknown;
+        if (cmd.findOption("--write-xfer-little"))
+            opt_archiveXfer = EXS_LittleEndianExplicit;
+        if (cmd.findOption("--write-xfer-rle"))
+            opt_archiveXfer = EXS_RLELossless;
+        if (cmd.findOption("--write-xfer-jpeg"))
+            opt_archiveXfer = EXS_JPEGProcess14SV1;
+        if (cmd.findOption("--write-xfer-jpls"))
+            opt_archiveXfer = EXS_JPEGLSLossless;
+        cmd.endOptionBlock();
+        if (opt_archiveXfer != EXS_Unknown)
+            app.checkConflict("--write-xfer-xxx", "--bit-preserving or --ignore", opt_datasetStorage != DcmStorageSCP::DGM_StoreToFile);
+
+        if (cmd.findOption("--transcoding-workers"))
+        {
+            app.checkDependence("--transcoding-workers", "--write-xfer-xxx", opt_archiveXfer != EXS_Unknown);
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_transcodingWorkers, 0, 64));
+        }
+        if (cmd.findOption("--transcoding-queue"))
+        {
+            app.checkDependence("--transcoding-queue", "--write-xfer-xxx", opt_archiveXfer != EXS_Unknown);
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_transcodingQueue, 1, 1024));
+        }
+
+        if (cmd.findOption("--preallocate"))
+        {
+            app.checkDependence("--preallocate", "--bit-preserving", opt_datasetStorage == DcmStorageSCP::DGM_StoreBitPreserving);
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_preallocate, 1, 1024));
+        }
+
         /* command line parameters */
         app.checkParam(cmd.getParamAndCheckMinMax(1, opt_port, 1, 65535));
 
@@ -294,6 +351,31 @@ int main(int argc, char *argv[])
     storageSCP.setFilenameGenerationMode(opt_filenameGeneration);
     storageSCP.setFilenameExtension(opt_filenameExtension);
     storageSCP.setDatasetStorageMode(opt_datasetStorage);
+    storageSCP.setPreallocationChunkSize(OFstatic_cast(Uint32, opt_preallocate * 1024 * 1024));
+
+    /* transcode received datasets to the archive transfer syntax (if requested) */
+    if (opt_archiveXfer != EXS_Unknown)
+    {
+        /* register the decoders and encoders of all supported compression schemes */
+        DcmRLEDecoderRegistration::registerCodecs();
+        DcmRLEEncoderRegistration::registerCodecs();
+        DJDecoderRegistration::registerCodecs();
+        DJEncoderRegistration::registerCodecs();
+        DJLSDecoderRegistration::registerCodecs();
+        DJLSEncoderRegistration::registerCodecs();
+        if (opt_archiveXfer == EXS_JPEGProcess14SV1)
+        {
+            DJ_RPLossless repParam;
+            storageSCP.setArchiveTransferSyntax(opt_archiveXfer, &repParam);
+        }
+        else if (opt_archiveXfer == EXS_JPEGLSLossless)
+        {
+            DJLSRepresentationParameter repParam(2, OFTrue /* useLosslessProcess */);
+            storageSCP.setArchiveTransferSyntax(opt_archiveXfer, &repParam);
+        } else
+            storageSCP.setArchiveTransferSyntax(opt_archiveXfer);
+        storageSCP.setTranscodingWorkers(opt_transcodingWorkers, opt_transcodingQueue);
+    }
 
     /* load association negotiation profile from configuration file (if specified) */
     if ((opt_configFile != NULL) && (opt_profileName != NULL))
@@ -339,7 +421,16 @@ int main(int argc, char *argv[])
         return EXITCODE_CANNOT_START_SCP_AND_LISTEN;
     }
 
+    /* make sure that all queued datasets have been stored */
+    storageSCP.waitForTranscoding();
+
     /* make sure that everything is cleaned up properly */
+    DcmRLEDecoderRegistration::cleanup();
+    DcmRLEEncoderRegistration::cleanup();
+    DJDecoderRegistration::cleanup();
+    DJEncoderRegistration::cleanup();
+    DJLSDecoderRegistration::cleanup();
+    DJLSEncoderRegistration::cleanup();
 #ifdef DEBUG
     /* useful for debugging with dmalloc */
     dcmDataDict.clear();
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2011-2018, OFFIS e.V.
+ *  Copyright (C) 2011-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -120,6 +120,8 @@ int main(int argc, char *argv[])
     OFCmdUnsignedInt opt_acseTimeout = 30;
     OFCmdUnsignedInt opt_maxReceivePDULength = ASC_DEFAULTMAXPDU;
     OFCmdUnsignedInt opt_maxSendPDULength = 0;
+    OFCmdUnsignedInt opt_maxOperationsInvoked = 1;
+    OFCmdUnsignedInt opt_numAssociations = 1;
     T_DIMSE_BlockingMode opt_blockMode = DIMSE_BLOCKING;
 #ifdef WITH_ZLIB
     OFCmdUnsignedInt opt_compressionLevel = 0;
@@ -196,6 +198,10 @@ int main(int argc, char *argv[])
       cmd.addSubGroup("association handling:");
         cmd.addOption("--multi-associations",  "+ma",     "use multiple associations (one after the other)\nif needed to transfer the instances (default)");
         cmd.addOption("--single-association",  "-ma",     "always use a single association");
+        cmd.addOption("--async-operations",    "+ao",  1, "[n]umber: integer (0 = unlimited)",
+                                                          "propose asynchronous operations window, i.e.\nsend up to n requests without waiting for\nthe responses (default: 1 = synchronous)");
+        cmd.addOption("--threads",             "+th",  1, "[n]umber: integer (1..64)",
+                                                          "send instances over n associations in\nparallel (default: 1 = one at a time)");
       cmd.addSubGroup("other network options:");
         cmd.addOption("--timeout",             "-to",  1, "[s]econds: integer (default: unlimited)",
                                                           "timeout for connection requests");
@@ -319,6 +325,13 @@ int main(int argc, char *argv[])
         if (cmd.findOption("--multi-associations")) opt_multipleAssociations = OFTrue;
         if (cmd.findOption("--single-association")) opt_multipleAssociations = OFFalse;
         cmd.endOptionBlock();
+        if (cmd.findOption("--async-operations"))
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_maxOperationsInvoked, 0, 65535));
+        if (cmd.findOption("--threads"))
+        {
+            app.checkConflict("--threads", "--single-association", !opt_multipleAssociations);
+            app.checkValue(cmd.getValueAndCheckMinMax(opt_numAssociations, 1, 64));
+        }
 
         if (cmd.findOption("--timeout"))
         {
@@ -452,6 +465,7 @@ int main(int argc, char *argv[])
     storageSCU.setACSETimeout(OFstatic_cast(Uint32, opt_acseTimeout));
     storageSCU.setDIMSETimeout(OFstatic_cast(Uint32, opt_dimseTimeout));
     storageSCU.setDIMSEBlockingMode(opt_blockMode);
+    storageSCU.setMaxOperationsInvoked(OFstatic_cast(Uint16, opt_maxOperationsInvoked));
     storageSCU.setVerbosePCMode(opt_showPresentationContexts);
     storageSCU.setDatasetConversionMode(opt_decompressionMode != DcmStorageSCU::DM_never);
     storageSCU.setDecompressionMode(opt_decompressionMode);
@@ -466,8 +480,22 @@ int main(int argc, char *argv[])
         OFLOG_DEBUG(dcmsendLogger, "only a single associations allowed (option --single-association used)");
     }
 
+    /* send the instances over parallel associations (if requested) */
+    if (opt_numAssociations > 1)
+    {
+        OFLOG_INFO(dcmsendLogger, "sending SOP instances over " << opt_numAssociations << " associations in parallel ...");
+        status = storageSCU.sendSOPInstancesInParallel(OFstatic_cast(unsigned int, opt_numAssociations));
+        if (status.bad())
+        {
+            OFLOG_FATAL(dcmsendLogger, "cannot send SOP instances: " << status.text());
+            cleanup();
+            return EXITCODE_CANNOT_SEND_REQUEST;
+        }
+        /* all instances have been processed, so there is nothing left to be negotiated */
+        status = NET_EC_NoPresentationContextsDefined;
+    }
     /* add presentation contexts to be negotiated (if there are still any) */
-    while ((status = storageSCU.addPresentationContexts()).good())
+    while ((opt_numAssociations == 1) && (status = storageSCU.addPresentationContexts()).good())
     {
         if (opt_multipleAssociations)
         {
@@ -50,6 +50,7 @@ END_EXTERN_C
 #include "dcmtk/dcmnet/dcmtrans.h"      /* for dcmSocketSend/ReceiveTimeout */
 #include "dcmtk/dcmnet/dcasccfg.h"      /* for class DcmAssociationConfiguration */
 #include "dcmtk/dcmnet/dcasccff.h"      /* for class DcmAssociationConfigurationFile */
+#include "dcmtk/dcmnet/netmetr.h"       /* for class DcmNetworkMetrics */
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmdata/dcuid.h"
 #include "dcmtk/dcmdata/dcdict.h"
@@ -90,6 +91,7 @@ static char rcsid[] = "$dcmtk: " OFFIS_CONSOLE_APPLICATION " v" OFFIS_DCMTK_VERS
 
 static OFCondition processCommands(T_ASC_Association *assoc);
 static OFCondition acceptAssociation(T_ASC_Network *net, DcmAssociationConfiguration& asccfg, OFBool secureConnection);
+static void writeMetricsFile();
 static OFCondition echoSCP(T_ASC_Association * assoc, T_DIMSE_Message * msg, T_ASC_PresentationContextID presID);
 static OFCondition storeSCP(T_ASC_Association * assoc, T_DIMSE_Message * msg, T_ASC_PresentationContextID presID);
 static void executeOnReception();
@@ -165,6 +167,8 @@ T_DIMSE_BlockingMode opt_blockMode = DIMSE_BLOCKING;
 int                opt_dimse_timeout = 0;
 int                opt_acse_timeout = 30;
 OFCmdSignedInt     opt_socket_timeout = 60;
+OFString           opt_metricsFile;
+OFBool             opt_metricsJSON = OFFalse;
 
 #if defined(HAVE_FORK) || defined(_WIN32)
 OFBool             opt_forkMode = OFFalse;
@@ -301,6 +305,9 @@ int main(int argc, char *argv[])
       cmd.addOption("--abort-during",                      "abort association during receipt of C-STORE-RQ");
       cmd.addOption("--promiscuous",            "-pm",     "promiscuous mode, accept unknown SOP classes\n(not with --config-file)");
       cmd.addOption("--uid-padding",            "-up",     "silently correct space-padded UIDs");
+      cmd.addOption("--metrics-file",           "+mf",  1, "[f]ilename: string",
+                                                           "write network metrics to file f after each\nassociation (Prometheus text format,\nnot with --fork or --inetd)");
+      cmd.addOption("--metrics-json",           "+mj",     "write network metrics in JSON format\n(only with --metrics-file)");
 
     // add TLS specific command line options if (and only if) we are compiling with OpenSSL
     tlsOptions.addTLSCommandlineOptions(cmd);
@@ -544,6 +551,19 @@ int main(int argc, char *argv[])
     if (cmd.findOption("--abort-during")) opt_abortDuringStore = OFTrue;
     if (cmd.findOption("--promiscuous")) opt_promiscuous = OFTrue;
     if (cmd.findOption("--uid-padding")) opt_correctUIDPadding = OFTrue;
+    if (cmd.findOption("--metrics-file"))
+    {
+      // each child process would overwrite the file with its own metrics
+      app.checkConflict("--metrics-file", "--fork", opt_forkMode);
+      app.checkConflict("--metrics-file", "--inetd", opt_inetd_mode);
+      app.checkValue(cmd.getValue(opt_metricsFile));
+      DcmNetworkMetrics::instance().setEnabled(OFTrue);
+    }
+    if (cmd.findOption("--metrics-json"))
+    {
+      app.checkDependence("--metrics-json", "--metrics-file", !opt_metricsFile.empty());
+      opt_metricsJSON = OFTrue;
+    }
 
     if (cmd.findOption("--config-file"))
     {
@@ -1514,10 +1534,45 @@ cleanup:
     exit(1);
   }
 
+  // the metrics of the association have been added to the registry when it was destroyed
+  if (!opt_metricsFile.empty())
+    writeMetricsFile();
+
   return cond;
 }
 
 
+static void writeMetricsFile()
+    /*
+     * This function writes the network metrics collected so far to the file
+     * specified with --metrics-file. The file is written under a temporary name
+     * first and then renamed, so that a reader never sees an incomplete file.
+     */
+{
+  const OFString tempFile = opt_metricsFile + ".tmp";
+  STD_NAMESPACE ofstream out(tempFile.c_str());
+  if (out.good())
+  {
+    if (opt_metricsJSON)
+      DcmNetworkMetrics::instance().writeJSON(out);
+    else
+      DcmNetworkMetrics::instance().writePrometheus(out);
+    out.close();
+  }
+  if (out.fail())
+  {
+    OFLOG_WARN(storescpLogger, "cannot write network metrics to file: " << tempFile);
+    return;
+  }
+  if (!OFStandard::renameFile(tempFile, opt_metricsFile))
+  {
+    // rename() does not replace an existing file on Windows
+    OFStandard::deleteFile(opt_metricsFile);
+    if (!OFStandard::renameFile(tempFile, opt_metricsFile))
+      OFLOG_WARN(storescpLogger, "cannot rename network metrics file " << tempFile << " to " << opt_metricsFile);
+  }
+}
+
 static OFCondition
 processCommands(T_ASC_Association * assoc)
     /*
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2018, OFFIS e.V.
+ *  Copyright (C) 1994-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -97,6 +97,7 @@
 #include "dcmtk/dcmnet/dicom.h"
 #include "dcmtk/dcmnet/lst.h"
 #include "dcmtk/dcmnet/dul.h"
+#include "dcmtk/dcmnet/netmetr.h"
 
 /*
 ** Constant Definitions
@@ -150,6 +151,11 @@ struct DCMTK_DCMNET_EXPORT T_ASC_Network
 
 typedef DUL_PRESENTATIONCONTEXTID T_ASC_PresentationContextID;
 
+/** TCP tuning parameters of an association, see DUL_SOCKETOPTIONS.
+ *  A value-initialized structure (all zeros) keeps the default behaviour.
+ */
+typedef DUL_SOCKETOPTIONS T_ASC_SocketOptions;
+
 enum T_ASC_P_ResultReason
 { /* Part 8, pp 45. */
     ASC_P_ACCEPTANCE              = 0,
@@ -248,6 +254,7 @@ struct DCMTK_DCMNET_EXPORT T_ASC_Association
     unsigned short nextMsgID;     /* should be incremented by user */
     unsigned long sendPDVLength;  /* max length of PDV to send out */
     unsigned char *sendPDVBuffer; /* buffer of size sendPDVLength */
+    DcmAssociationMetrics *metrics; /* NULL if metrics are not collected */
 };
 
 /*
@@ -277,6 +284,29 @@ DCMTK_DCMNET_EXPORT OFCondition ASC_initializeNetwork(
     T_ASC_Network ** network,
     unsigned long options = 0);
 
+/** network instance creation function (constructor) that also sets the TCP
+ *  tuning parameters applied to each transport connection accepted on the
+ *  network. In contrast to ASC_setNetworkSocketOptions(), the buffer sizes are
+ *  set on the listening socket before it starts listening, which makes sure
+ *  that they are taken into account for the TCP window scaling.
+ *  @param role association acceptor, requestor or both
+ *  @param acceptorPort acceptor port for incoming connections.
+ *    For association requestors, zero should be passed here.
+ *  @param timeout timeout for network operations, in seconds
+ *  @param network T_ASC_Network will be allocated and returned in this parameter
+ *  @param socketOptions socket options for accepted connections
+ *  @param options network options. Only DUL_FULLDOMAINNAME is currently defined
+ *    as a possible option.
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition ASC_initializeNetwork(
+    T_ASC_NetworkRole role,
+    int acceptorPort,
+    int timeout,
+    T_ASC_Network ** network,
+    const T_ASC_SocketOptions& socketOptions,
+    unsigned long options = 0);
+
 /** network instance destruction function (destructor)
  *  @param network T_ASC_Network will be freed by this routine
  *  @return EC_Normal if successful, an error code otherwise
@@ -309,6 +339,50 @@ ASC_setTransportLayerType(
     T_ASC_Parameters * params,
     OFBool useSecureLayer);
 
+/** set the TCP tuning parameters used for the transport connection of an
+ *  association requested with the given parameters. The options are
+ *  applied before the connection is established.
+ *  @param params association parameters
+ *  @param options socket options
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_setSocketOptions(
+    T_ASC_Parameters * params,
+    const T_ASC_SocketOptions& options);
+
+/** set the TCP tuning parameters applied to each transport connection that
+ *  is accepted on the given network, i.e.\ before the peer is known. The
+ *  buffer sizes are also set on the listening socket, but depending on the
+ *  operating system, they might not be used for the TCP window scaling of
+ *  the connections accepted afterwards. Use the variant of
+ *  ASC_initializeNetwork() with socket options in order to make sure that
+ *  they are.
+ *  @param network network
+ *  @param options socket options
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_setNetworkSocketOptions(
+    T_ASC_Network * network,
+    const T_ASC_SocketOptions& options);
+
+/** apply TCP tuning parameters to the transport connection of an existing
+ *  association, e.g.\ by an acceptor after the peer has been identified.
+ *  Note that the buffer sizes of an established connection only have a
+ *  limited effect: the TCP window scale factor has been negotiated during
+ *  the TCP handshake, so a larger receive buffer cannot enable or increase
+ *  window scaling anymore. Buffer sizes that require window scaling have to
+ *  be set for the network (see ASC_initializeNetwork()).
+ *  @param assoc association
+ *  @param options socket options
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_applySocketOptions(
+    T_ASC_Association * assoc,
+    const T_ASC_SocketOptions& options);
+
  /*
   * Copies the provided Application Titles in the association parameters.
   */
@@ -368,6 +442,43 @@ ASC_getPresentationAddresses(
     char* calledPresentationAddress,
     size_t calledPresentationAddressSize);
 
+ /*
+  * Sets the Asynchronous Operations Window to be proposed (requestor) or
+  * acknowledged (acceptor).  A value of 0 means unlimited.  The default of
+  * 1/1 is the synchronous mode, in which case the sub-item is not proposed.
+  * As defined in the DICOM standard, both values always refer to the operations
+  * invoked and performed by the requestor.  An acceptor only acknowledges the
+  * window if the requestor proposed one, and should never acknowledge more
+  * than was proposed.
+  */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_setAsyncOperationsWindow(
+    T_ASC_Parameters * params,
+    Uint16 maxOpsInvoked,
+    Uint16 maxOpsPerformed);
+
+ /*
+  * Copies our own Asynchronous Operations Window (see above) into the
+  * supplied variables.
+  */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_getAsyncOperationsWindow(
+    T_ASC_Parameters * params,
+    Uint16 * maxOpsInvoked,
+    Uint16 * maxOpsPerformed);
+
+ /*
+  * Copies the Asynchronous Operations Window received from the peer into the
+  * supplied variables.  If the peer did not send the sub-item, 1/1 (i.e.
+  * synchronous mode) is returned.  For a requestor, the number of operations
+  * invoked as acknowledged by the peer limits the number of outstanding requests.
+  */
+DCMTK_DCMNET_EXPORT OFCondition
+ASC_getPeerAsyncOperationsWindow(
+    T_ASC_Parameters * params,
+    Uint16 * maxOpsInvoked,
+    Uint16 * maxOpsPerformed);
+
  /*
   * Copies the Rejection Parameters stored in the association parameters into
   * the supplied structure.  You must provide storage to copy into.
@@ -614,6 +725,15 @@ ASC_getCopyOfIdentResponse(T_ASC_Parameters * params,
                            char*& buffer,
                            unsigned short& bufferLen);
 
+/** get the metrics collected for an association so far. Metrics are only
+ *  collected if enabled in DcmNetworkMetrics when the association was
+ *  requested or received.
+ *  @param assoc association
+ *  @return pointer to the metrics (owned by the association), NULL if no
+ *    metrics are collected for the association
+ */
+DCMTK_DCMNET_EXPORT DcmAssociationMetrics *ASC_getAssociationMetrics(T_ASC_Association *assoc);
+
 /* TLS/SSL */
 
 /* get peer certificate from open association */
@@ -699,7 +819,7 @@ DCMTK_DCMNET_EXPORT OFCondition
 ASC_acknowledgeRelease(T_ASC_Association * association);
 
 DCMTK_DCMNET_EXPORT OFCondition
-ASC_abortAssociation(T_ASC_Association * association);
+ASC_abortAssociation(T_ASC_Association * association, OFBool waitForClose = OFTrue);
 
 DCMTK_DCMNET_EXPORT OFCondition
 ASC_dropSCPAssociation(T_ASC_Association * association, int timeout = DUL_TIMEOUT);
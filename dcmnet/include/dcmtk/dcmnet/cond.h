@@ -199,6 +199,7 @@ extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_StopAfterAssociation;
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_StopAfterConnectionTimeout;       /* Stop after TCP connection timeout (as requested) */
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_InvalidSCPAssociationProfile;     /* Invalid or non-existing SCP Association Profile */
 extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_AssociatePDUTooLarge;             /* A-ASSOCIATE PDU too large */
+extern DCMTK_DCMNET_EXPORT const OFConditionConst NET_EC_CannotCreateEventPoller;          /* Cannot create event poller */
 
 // This macro creates a condition with given code, severity and text.
 // Making this a macro instead of a function saves the creation of a temporary.
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2003-2013, OFFIS e.V.
+ *  Copyright (C) 2003-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -85,6 +85,15 @@ private:
     DcmAssociationConfiguration& cfg,
     OFConfigFile& config);
 
+  /** parses the socket options in the config file.
+   *  @param cfg association configuration object to initialize
+   *  @param config config file to parse
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  static OFCondition parseSocketOptions(
+    DcmAssociationConfiguration& cfg,
+    OFConfigFile& config);
+
   /** parses the association configuration profile lists in the config file.
    *  @param cfg association configuration object to initialize
    *  @param filename name of config file
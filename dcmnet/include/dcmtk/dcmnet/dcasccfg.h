@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2003-2017, OFFIS e.V.
+ *  Copyright (C) 2003-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -31,12 +31,14 @@
 #include "dcmtk/dcmnet/dccfrsmp.h" /* for class DcmRoleSelectionMap */
 #include "dcmtk/dcmnet/dccfenmp.h" /* for class DcmExtendedNegotiationMap */
 #include "dcmtk/dcmnet/dccfprmp.h" /* for class DcmProfileMap */
+#include "dcmtk/ofstd/ofmap.h"     /* for class OFMap */
 
 
 /** This class maintains a list of association negotiation configuration
  *  profiles. A profile is a combination of the following components:
  *  A list of presentation contexts, an optional list of SCP/SCU role
- *  selection items and an optional list of extended negotiation items.
+ *  selection items, an optional list of extended negotiation items and
+ *  optional TCP socket options.
  *  A presentation context itself consist of an abstract syntax and
  *  a list of transfer syntaxes, the latter each being separate components.
  *  Role selection and extended negotation items are atomic (i.e. they do not
@@ -69,6 +71,8 @@ public:
 
   /** this method prepares a T_ASC_Parameters structure according to the settings
    *  of a profile maintained by this object. It is used by an association initiator.
+   *  The socket options of the profile (if any) are applied when the association
+   *  is requested.
    *  @param symbolic profile name, must not be NULL
    *  @param params T_ASC_Parameters structure to be filled
    *  @return EC_Normal if successful, an error code otherwise
@@ -79,6 +83,7 @@ public:
 
   /** this method evaluates an incoming association request according to the settings
    *  of a profile maintained by this object. It is used by an association acceptor.
+   *  The socket options of the profile (if any) are applied to the connection.
    *  @param symbolic profile name, must not be NULL
    *  @param assoc T_ASC_Association structure to be evaluated
    *  @return EC_Normal if successful, an error code otherwise
@@ -152,24 +157,43 @@ public:
     const unsigned char *rawData,
     Uint32 length);
 
+  /** adds a set of TCP socket options under the given key, which can be
+   *  referenced by one or more profiles.
+   *  @param key socket options key, must not be NULL and not yet be used
+   *  @param options socket options
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition addSocketOptions(
+    const char *key,
+    const T_ASC_SocketOptions& options);
+
+  /** returns the socket options maintained under the given key
+   *  @param key socket options key, must not be NULL
+   *  @return pointer to the socket options, NULL if key is unknown
+   */
+  const T_ASC_SocketOptions *getSocketOptions(const char *key) const;
+
   /** creates a new association negotiation profile under the given key.
    *  A profile consists of a list of presentation contexts and may optionally
-   *  also include a list of SCP/SCU role selection items and a list of
-   *  extended negotiation items. This method checks the consistency of the
-   *  three lists, i.e. makes sure that all abstract syntaxes mentioned either
-   *  in the list of role selection items or the list of extended negotiation
-   *  items are also contained in at least one presentation context.
+   *  also include a list of SCP/SCU role selection items, a list of
+   *  extended negotiation items and a set of socket options. This method checks
+   *  the consistency of the three lists, i.e. makes sure that all abstract
+   *  syntaxes mentioned either in the list of role selection items or the list
+   *  of extended negotiation items are also contained in at least one
+   *  presentation context.
    *  @param key profile key, must not be NULL
    *  @param presentationContextKey presentation context list key, must not be NULL
    *  @param roleSelectionKey role selection list key, may be NULL
    *  @param extendedNegotiationKey extended negotiation list key, may be NULL
+   *  @param socketOptionsKey socket options key, may be NULL
    *  @return EC_Normal if successful, an error code otherwise
    */
   OFCondition addProfile(
     const char *key,
     const char *presentationContextKey,
     const char *roleSelectionKey=NULL,
-    const char *extendedNegotiationKey=NULL);
+    const char *extendedNegotiationKey=NULL,
+    const char *socketOptionsKey=NULL);
 
   /** checks if the profile is known
    *  @param key profile name, must not be NULL
@@ -252,6 +276,9 @@ private:
   /// map of profiles
   DcmProfileMap profiles_;
 
+  /// map of socket options
+  OFMap<OFString, T_ASC_SocketOptions> socketOptions_;
+
   /// Option to always accept a default role as association acceptor.
   /// If OFFalse (default) the acceptor will reject a presentation context proposed
   /// with Default role (no role selection at all) when it is configured for role
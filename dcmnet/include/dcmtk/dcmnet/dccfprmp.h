@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2015, OFFIS e.V.
+ *  Copyright (C) 1994-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -41,11 +41,13 @@ public:
    *  @param presentationContextGroup symbolic identifier of the presentation context list
    *  @param roleSelectionGroup symbolic identifier of the role selection list, may be empty
    *  @param extendedNegotiationGroup symbolic identifier of the extended negotiation list, may be empty
+   *  @param socketOptionsGroup symbolic identifier of the socket options, may be empty
    */
   DcmProfileEntry(
     const OFString& presentationContextGroup,
     const OFString& roleSelectionGroup,
-    const OFString& extendedNegotiationGroup);
+    const OFString& extendedNegotiationGroup,
+    const OFString& socketOptionsGroup = "");
 
   /// copy constructor
   DcmProfileEntry(const DcmProfileEntry& arg);
@@ -71,6 +73,11 @@ public:
    */
   const char *getExtendedNegotiationKey() const;
 
+  /** returns the socket options key
+   *  @return socket options key, NULL if empty
+   */
+  const char *getSocketOptionsKey() const;
+
   /** comparison operator.
    *  @param arg object to compare with
    *  @return true if equal
@@ -79,7 +86,8 @@ public:
   {
     return (presentationContextGroup_ == arg.presentationContextGroup_) 
         && (roleSelectionGroup_ == arg.roleSelectionGroup_)
-        && (extendedNegotiationGroup_ == arg.extendedNegotiationGroup_); 
+        && (extendedNegotiationGroup_ == arg.extendedNegotiationGroup_)
+        && (socketOptionsGroup_ == arg.socketOptionsGroup_);
   }
 
 private:
@@ -92,6 +100,9 @@ private:
 
   /// symbolic identifier of the extended negotiation list, may be empty
   OFString extendedNegotiationGroup_;
+
+  /// symbolic identifier of the socket options, may be empty
+  OFString socketOptionsGroup_;
 };
 
 
@@ -138,13 +149,15 @@ public:
    *  @param presentationContextKey symbolic identifier of the presentation context list, must not be NULL
    *  @param roleSelectionKey symbolic identifier of the role selection list, may be NULL
    *  @param extendedNegotiationKey symbolic identifier of the extended negotiation list, may be NULL
+   *  @param socketOptionsKey symbolic identifier of the socket options, may be NULL
    *  @return EC_Normal if successful, an error code otherwise
    */
   OFCondition add(
     const char *key,
     const char *presentationContextKey,
     const char *roleSelectionKey,
-    const char *extendedNegotiationKey);
+    const char *extendedNegotiationKey,
+    const char *socketOptionsKey = NULL);
 
   /** checks if the key is known
    *  @param key key name, must not be NULL
@@ -170,6 +183,12 @@ public:
    */
   const char *getExtendedNegotiationKey(const char *key) const;
 
+  /** returns the socket options key for the given profile
+   *  @param key key name, must not be NULL
+   *  @return socket options key, NULL if not found or empty
+   */
+  const char *getSocketOptionsKey(const char *key) const;
+
 private:
 
   /// map of profiles
@@ -115,6 +115,17 @@ public:
    */
   virtual ssize_t write(void *buf, size_t nbyte) = 0;
 
+  /** attempts to write the given memory blocks to the transport connection,
+   *  as if they formed a single contiguous block. This allows for sending
+   *  PDU headers and data without copying them into a common buffer first.
+   *  The default implementation calls write() for each block.
+   *  @param buffers array of pointers to the memory blocks
+   *  @param lengths array of numbers of bytes in the memory blocks
+   *  @param count number of memory blocks (i.e. array entries)
+   *  @return number of bytes written, negative number if unsuccessful.
+   */
+  virtual ssize_t writeGathered(const void * const *buffers, const size_t *lengths, size_t count);
+
   /** Closes the transport connection. If a secure connection
    *  is used, a closure alert is sent before the connection
    *  is closed. Abstract method.
@@ -184,13 +195,14 @@ public:
    */
   static OFBool selectReadableAssociation(DcmTransportConnection *connections[], int connCount, int timeout);
 
-protected:
-
-  /** returns the socket file descriptor managed by this object.
+  /** returns the socket file descriptor managed by this object, e.g.\ in
+   *  order to wait for incoming data on many connections at the same time.
    *  @return socket file descriptor
    */
   DcmNativeSocketType getSocket() { return theSocket; }
 
+protected:
+
   /** set the socket file descriptor managed by this object.
    *  @param socket file descriptor
    */
@@ -300,6 +312,16 @@ public:
    */
   virtual ssize_t write(void *buf, size_t nbyte);
 
+  /** attempts to write the given memory blocks to the transport connection,
+   *  as if they formed a single contiguous block. Uses a single system call
+   *  for all blocks where available (i.e.\ writev() or WSASend()).
+   *  @param buffers array of pointers to the memory blocks
+   *  @param lengths array of numbers of bytes in the memory blocks
+   *  @param count number of memory blocks (i.e. array entries)
+   *  @return number of bytes written, negative number if unsuccessful.
+   */
+  virtual ssize_t writeGathered(const void * const *buffers, const size_t *lengths, size_t count);
+
   /** Closes the transport connection. If a secure connection
    *  is used, a closure alert is sent before the connection
    *  is closed.
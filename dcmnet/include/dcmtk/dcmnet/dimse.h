@@ -119,6 +119,15 @@ extern DCMTK_DCMNET_EXPORT OFGlobal<OFBool> dcmPeerRequiresExactUIDCopy; /* defa
  */
 extern DCMTK_DCMNET_EXPORT OFGlobal<Uint32> dcmMaxOutgoingPDUSize; /* default 2^32-1 */
 
+/** global variable specifying the minimum number of bytes of an element value
+ *  that are sent directly from memory (i.e. from the dataset or from the cache
+ *  used for reading values that still reside in file) instead of being copied
+ *  into the association's send buffer first.  Zero copy is never used for data
+ *  that is compressed while being sent (deflated transfer syntax).  A value of
+ *  0 disables zero copy.
+ */
+extern DCMTK_DCMNET_EXPORT OFGlobal<Uint32> dcmZeroCopyThreshold; /* default 4096 */
+
 
 /*
  * General Status Codes.
@@ -1246,6 +1255,36 @@ DIMSE_receiveDataSetInFile(T_ASC_Association *assoc,
                      DcmOutputStream *filestream,
                      DIMSE_ProgressCallback callback, void *callbackData);
 
+/** receive one data set (of instance data) via network from another DICOM application and store in file.
+ *  In addition, the attributes at the beginning of the data set are parsed while the data is received,
+ *  so that the caller does not need to read the file again in order to access e.g. the patient or study
+ *  information. Parsing stops at the first element of the main data set with the given or a higher tag,
+ *  while the complete data set is still written to file.
+ *  @param assoc           The association (network connection to another DICOM application).
+ *  @param blocking        The blocking mode for receiving data (either DIMSE_BLOCKING or DIMSE_NONBLOCKING)
+ *  @param timeout         Timeout interval for receiving data (if the blocking mode is DIMSE_NONBLOCKING).
+ *  @param presID          [out] Contains in the end the ID of the presentation context which was used in the PDVs
+ *                         that were received on the network. If the PDVs show different presentation context
+ *                         IDs, this function will return an error.
+ *  @param filestream      output stream to which the incoming dataset is written
+ *  @param callback        Pointer to a function which shall be called to indicate progress.
+ *  @param callbackData    Pointer to data which shall be passed to the progress indicating function
+ *  @param headerAttributes [out] Data set to which the parsed attributes are added (may be NULL). If the
+ *                         attributes cannot be parsed, a warning is reported and the data set is left
+ *                         incomplete, but the data set is still stored in the file.
+ *  @param stopParsingAtElement Tag of the element at which parsing stops, e.g.\ DCM_PixelData.
+ *                         DCM_UndefinedTagKey means that all attributes are parsed.
+ *  @return EC_Normal if successful, an error code otherwise.
+ */
+DCMTK_DCMNET_EXPORT OFCondition
+DIMSE_receiveDataSetInFile(T_ASC_Association *assoc,
+                     T_DIMSE_BlockingMode blocking, int timeout,
+                     T_ASC_PresentationContextID *presID,
+                     DcmOutputStream *filestream,
+                     DIMSE_ProgressCallback callback, void *callbackData,
+                     DcmDataset *headerAttributes,
+                     const DcmTagKey &stopParsingAtElement);
+
 /** receive and discard one data set (of instance data) via network from another DICOM application.
  *  @param assoc           The association (network connection to another DICOM application).
  *  @param blocking        The blocking mode for receiving data (either DIMSE_BLOCKING or DIMSE_NONBLOCKING)
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2013-2014, OFFIS e.V.
+ *  Copyright (C) 2013-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -27,16 +27,21 @@
 #include "dcmtk/ofstd/offname.h"    /* for OFFilenameCreator */
 #include "dcmtk/dcmnet/scp.h"       /* for base class DcmSCP */
 
+// forward declarations
+class DcmRepresentationParameter;
+
 
 /*---------------------*
  *  class declaration  *
  *---------------------*/
 
 /** Interface class for a Storage Service Class Provider (SCP).
- *  This class supports C-STORE and C-ECHO messages as an SCP.  The received datasets are
- *  always stored as DICOM files with the same Transfer Syntax as used for the network
- *  transmission.  Both the generation of the directory structure and the filenames can
- *  be configured by the user.
+ *  This class supports C-STORE and C-ECHO messages as an SCP.  By default, the received
+ *  datasets are stored as DICOM files with the same Transfer Syntax as used for the network
+ *  transmission.  Optionally, they can be transcoded to an archive Transfer Syntax before
+ *  being stored (see setArchiveTransferSyntax()), which is done by a pool of worker threads
+ *  in order to keep the response time of the C-STORE requests low.  Both the generation of
+ *  the directory structure and the filenames can be configured by the user.
  *  @note The current implementation always requires to load a so-called association
  *    negotiation profile from a configuration file, which specifies the list of
  *    Presentation Contexts (i.e. combination of SOP Class and Transfer Syntaxes) to be
@@ -142,6 +147,23 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCP
      */
     E_DatasetStorageMode getDatasetStorageMode() const;
 
+    /** get the Transfer Syntax the received datasets are transcoded to before being stored
+     *  @return archive Transfer Syntax, EXS_Unknown if the datasets are stored with the
+     *    Transfer Syntax used for the network transmission
+     */
+    E_TransferSyntax getArchiveTransferSyntax() const;
+
+    /** get the number of worker threads transcoding and storing the received datasets
+     *  @return number of worker threads, 0 if the datasets are processed by the thread
+     *    handling the association
+     */
+    size_t getNumberOfTranscodingWorkers() const;
+
+    /** get the maximum number of received datasets waiting to be transcoded
+     *  @return maximum length of the transcoding queue
+     */
+    size_t getTranscodingQueueLength() const;
+
     // set methods
 
     /** specify the output directory to be used for the storage of the received DICOM
@@ -185,6 +207,45 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCP
      */
     void setDatasetStorageMode(const E_DatasetStorageMode mode);
 
+    /** specify a Transfer Syntax the received datasets are transcoded to before being
+     *  stored.  The conversion uses the codecs registered with DcmCodecList, e.g. JPEG-LS
+     *  lossless requires DJLSEncoderRegistration::registerCodecs() to be called first.  If
+     *  the conversion of a dataset fails, it is stored with the Transfer Syntax used for
+     *  the network transmission.  Please note that lossy compression is not recommended
+     *  since the SOP Instance UID of the dataset is not changed.
+     *  The transcoding is only performed in storage mode DGM_StoreToFile.  If the number
+     *  of transcoding workers is not 0 (see setTranscodingWorkers()), each received dataset
+     *  is first written as received to a temporary file in the output directory and the
+     *  C-STORE response reports the result of this step.  The dataset is then added to a
+     *  queue, and a worker transcodes it and calls checkAndProcessSTORERequest(), which
+     *  stores the final file.  If the transcoding fails, the temporary file is renamed to
+     *  the final file, i.e. the dataset is not written again.
+     *  @param  xfer      archive Transfer Syntax.  EXS_Unknown disables the transcoding
+     *                    (default).
+     *  @param  repParam  representation parameter passed to the codec (optional).  A copy
+     *                    of the parameter is stored.
+     */
+    void setArchiveTransferSyntax(const E_TransferSyntax xfer,
+                                  const DcmRepresentationParameter *repParam = NULL);
+
+    /** specify the number of worker threads transcoding the received datasets
+     *  and the maximum number of datasets waiting in the queue.  If the queue is full, the
+     *  thread handling the association waits until a dataset has been processed, i.e. the
+     *  next C-STORE response and the further network transmission are delayed.  The
+     *  settings take effect for the next dataset received.  If transcoding workers are
+     *  already running, this method waits until all queued datasets have been transcoded.
+     *  The default values are specified by DcmStorageSCP::DEF_TranscodingWorkers and
+     *  DcmStorageSCP::DEF_TranscodingQueueLength.
+     *  @param  numWorkers      number of worker threads.  0 means that the datasets are
+     *                          transcoded and stored by the thread handling the association,
+     *                          which is also the case if DCMTK is compiled without thread
+     *                          support.
+     *  @param  maxQueueLength  maximum number of datasets waiting to be processed (at
+     *                          least 1)
+     */
+    void setTranscodingWorkers(const size_t numWorkers,
+                               const size_t maxQueueLength = DEF_TranscodingQueueLength);
+
     // other methods
 
     /** load an association negotiation profile from a configuration file.  This profile
@@ -203,6 +264,13 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCP
     OFCondition loadAssociationConfiguration(const OFString &filename,
                                              const OFString &profile);
 
+    /** wait until all received datasets that are queued for transcoding have been processed.
+     *  This method should be called before the destructor of a derived class is executed,
+     *  since the transcoding workers call virtual methods like checkAndProcessSTORERequest()
+     *  and notifyInstanceStored().
+     */
+    void waitForTranscoding();
+
 
   protected:
 
@@ -220,7 +288,12 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCP
     /** check the given C-STORE request and dataset for validity.  This method is called
      *  by handleIncomingCommand() before sending the response in order to determine the
      *  DIMSE status code to be used for the response message.  If this check has been
-     *  passed successfully, the received dataset is stored as a DICOM file.
+     *  passed successfully, the received dataset is stored as a DICOM file.  If transcoding
+     *  workers are used (see setTranscodingWorkers()), this method is called from the
+     *  worker threads after the dataset has been transcoded, but never concurrently.  In
+     *  this case, the C-STORE response has already been sent, so the returned status code
+     *  is only used to decide whether the temporary file written when the dataset was
+     *  received can be deleted.  Otherwise, this file is kept and an error is reported.
      *  @param  reqMessage  C-STORE request message data structure to be checked and
      *                      processed
      *  @param  fileformat  DICOM fileformat structure containing the C-STORE request
@@ -242,13 +315,26 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCP
     virtual OFCondition generateSTORERequestFilename(const T_DIMSE_C_StoreRQ &reqMessage,
                                                      OFString &filename);
 
+    /** convert a received dataset to the archive Transfer Syntax (see
+     *  setArchiveTransferSyntax()).  This method is called by the transcoding workers, so
+     *  it may be executed concurrently for different datasets.
+     *  @param  dataset  dataset to be converted
+     *  @return status, EC_Normal if successful or if no conversion is needed, an error code
+     *    otherwise.  In the latter case, the dataset is stored with its current Transfer
+     *    Syntax.
+     */
+    virtual OFCondition transcodeDataset(DcmDataset &dataset);
+
     /** notification handler that is called for each DICOM object that has been received
-     *  with a C-STORE request and stored as a DICOM file
+     *  with a C-STORE request and stored as a DICOM file.  If transcoding workers are used
+     *  (see setTranscodingWorkers()), this handler is called from the worker threads after
+     *  the transcoded dataset has been stored, but never concurrently.
      *  @param  filename        filename (with full path) of the object stored
      *  @param  sopClassUID     SOP Class UID of the object stored
      *  @param  sopInstanceUID  SOP Instance UID of the object stored
-     *  @param  dataset         pointer to dataset of the object stored (or NULL if the
-     *                          dataset has been stored directly to file).
+     *  @param  dataset         pointer to dataset of the object stored. If the dataset
+     *                          has been stored directly to file, it only contains the
+     *                          attributes in front of the Pixel Data (7FE0,0010).
      *                          Please note that this dataset will be deleted by the calling
      *                          method, so do not store any references to it!
      */
@@ -257,6 +343,23 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCP
                                       const OFString &sopInstanceUID,
                                       DcmDataset *dataset = NULL) const;
 
+    /** move a DICOM file that has been received to a temporary file (in bit preserving
+     *  mode) to its final place.  The directory and file name are generated from the
+     *  given attributes that have been parsed while receiving the dataset.  Since the file
+     *  is only renamed, its content is neither copied nor read again.
+     *  @param  reqMessage        C-STORE request message data structure of the object
+     *  @param  tempFilename      name of the temporary file that contains the object.
+     *                            The file is deleted in case of error.
+     *  @param  headerAttributes  attributes in front of the Pixel Data (7FE0,0010)
+     *  @param  filename          reference to variable that will store the resulting
+     *                            filename (with full path)
+     *  @return DIMSE status code to be used for the C-STORE response
+     */
+    virtual Uint16 moveReceivedFile(const T_DIMSE_C_StoreRQ &reqMessage,
+                                    const OFString &tempFilename,
+                                    DcmDataset &headerAttributes,
+                                    OFString &filename);
+
     /** generate a directory and file name for a DICOM dataset that has been received.
      *  The naming scheme can be specified by the methods setDirectoryGenerationMode(),
      *  setFilenameGenerationMode() and setFilenameExtension().
@@ -294,6 +397,10 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCP
     static const char *DEF_UndefinedSubdirectory;
     /// default value for the filename extension appended to the generated filenames
     static const char *DEF_FilenameExtension;
+    /// default value for the number of worker threads transcoding the received datasets
+    static const size_t DEF_TranscodingWorkers;
+    /// default value for the maximum number of datasets waiting to be transcoded
+    static const size_t DEF_TranscodingQueueLength;
 
 
 private:
@@ -316,6 +423,43 @@ private:
     OFFilenameCreator FilenameCreator;
     /// mode specifying how to store the received datasets (also allows for skipping the storage)
     E_DatasetStorageMode DatasetStorage;
+    /// Transfer Syntax the received datasets are transcoded to, EXS_Unknown for none
+    E_TransferSyntax ArchiveTransferSyntax;
+    /// representation parameter used for the transcoding (might be NULL)
+    DcmRepresentationParameter *ArchiveRepresentationParameter;
+    /// number of worker threads transcoding and storing the received datasets
+    size_t TranscodingWorkers;
+    /// maximum number of datasets waiting to be transcoded
+    size_t TranscodingQueueLength;
+
+    // internal class that queues the received datasets for the transcoding workers
+    class TranscodingQueue;
+    friend class TranscodingQueue;
+
+    /// queue of received datasets to be transcoded (created on first use)
+    TranscodingQueue *Transcoding;
+
+    /** transcode and store a received dataset.  If there are transcoding workers, the
+     *  dataset is written as received to a temporary file and then queued for the workers,
+     *  otherwise it is transcoded and stored by the calling thread.
+     *  @param  reqMessage  C-STORE request message data structure of the dataset
+     *  @param  fileformat  received dataset, the ownership is taken over
+     *  @return DIMSE status code to be used for the C-STORE response
+     */
+    Uint16 transcodeAndStore(const T_DIMSE_C_StoreRQ &reqMessage,
+                             DcmFileFormat *fileformat);
+
+    /** store a received dataset as a DICOM file (without calling the notification handler).
+     *  If a transcoding worker processes a dataset that has not been transcoded, the
+     *  temporary file written when the dataset was received is renamed instead.
+     *  @param  reqMessage  C-STORE request message data structure of the dataset
+     *  @param  fileformat  received dataset to be stored
+     *  @param  filename    reference to variable that will store the name of the file
+     *  @return DIMSE status code to be used for the C-STORE response
+     */
+    Uint16 storeReceivedDataset(const T_DIMSE_C_StoreRQ &reqMessage,
+                                DcmFileFormat &fileformat,
+                                OFString &filename);
 
     // private undefined copy constructor
     DcmStorageSCP(const DcmStorageSCP &);
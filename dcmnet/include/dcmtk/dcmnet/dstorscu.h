@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2011-2018, OFFIS e.V.
+ *  Copyright (C) 2011-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,7 @@
 #include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
 
 #include "dcmtk/dcmnet/scu.h"       /* for base class DcmSCU */
+#include "dcmtk/ofstd/ofmap.h"      /* for class OFMap */
 
 
 /*---------------------*
@@ -332,10 +333,41 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCU
      *  The sending process can be stopped by overwriting shouldStopAfterCurrentSOPInstance()
      *  in a derived class.  The sending process can be continued with the next SOP instance
      *  by calling sendSOPInstances() again.
+     *  If an Asynchronous Operations Window has been negotiated (see setMaxOperationsInvoked()),
+     *  the next C-STORE requests are sent before the responses to the previous ones are
+     *  received, i.e.\ notifySOPInstanceSent() is called when the response has been received.
+     *  At most 64 requests are outstanding at a time (even if an unlimited window has been
+     *  negotiated), since the responses are only read when this number is reached.
+     *  All responses are received before this method returns.
      *  @return status, EC_Normal if successful, an error code otherwise
      */
     OFCondition sendSOPInstances();
 
+    /** send all SOP instances from the transfer list that are not yet sent over several
+     *  associations in parallel.  The SOP instances are distributed evenly among the
+     *  associations (in the order of the transfer list) and each association is handled by a
+     *  separate thread.  For each association, the presentation contexts are added and
+     *  negotiated and the SOP instances are sent as with addPresentationContexts(),
+     *  initNetwork(), negotiateAssociation() and sendSOPInstances(), i.e.\ a thread uses
+     *  further associations (one after the other) if its SOP instances require more than
+     *  128 presentation contexts.  While a SOP instance is sent, the DICOM file of the next
+     *  SOP instance is loaded (and decompressed if required) by another thread.
+     *  The network parameters of this object (e.g. peer, AE titles, timeouts, maximum PDU
+     *  length and Asynchronous Operations Window) are used for all associations and must not
+     *  be changed while this method is running.  Please note that neither a secure transport
+     *  layer (TLS) nor an association configuration file is supported by this method.
+     *  The methods notifySOPInstanceToBeSent(), notifySOPInstanceSent() and
+     *  shouldStopAfterCurrentSOPInstance() are called from the different threads but never
+     *  concurrently.  If shouldStopAfterCurrentSOPInstance() returns OFTrue, all threads stop
+     *  after their current SOP instance.
+     *  If DCMTK is compiled without thread support, the associations are processed one after
+     *  the other.
+     *  @param  numAssociations  maximum number of associations used in parallel
+     *  @return status, EC_Normal if successful, an error code otherwise (the first error
+     *    that occurred on any of the associations)
+     */
+    OFCondition sendSOPInstancesInParallel(const unsigned int numAssociations);
+
     /** get some status information on the overall sending process.  This text can for example
      *  be output to the logger (on the level at the user's option).
      *  @param  summary  reference to a string in which the summary is stored
@@ -510,6 +542,39 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCU
 
   private:
 
+    class FileLoader;
+    friend class FileLoader;
+    class SendTask;
+    friend class SendTask;
+    class WorkerSCU;
+    friend class WorkerSCU;
+
+    /** compact or delete the dataset of the given transfer entry (if requested) after the
+     *  SOP instance has been sent successfully
+     *  @param  transferEntry  reference to transfer entry that has been sent
+     */
+    void handleDatasetAfterSend(TransferEntry &transferEntry);
+
+    /** receive C-STORE responses to outstanding requests that were sent asynchronously
+     *  and notify the user of this class about each SOP instance that has been processed
+     *  @param  outstandingEntries  transfer entries of the outstanding requests (mapped by
+     *                              message ID).  Entries are removed when their response
+     *                              has been received.
+     *  @param  maxOutstanding      receive responses until at most this number of requests
+     *                              is outstanding
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    OFCondition receiveSTOREResponses(OFMap<Uint16, TransferEntry *> &outstandingEntries,
+                                      const size_t maxOutstanding);
+
+    /** start loading the DICOM file of the next SOP instance that is to be sent on the
+     *  current association (if any) in a separate thread
+     *  @param  currentEntry  iterator pointing to the transfer entry currently sent
+     *  @return file loader for the next SOP instance (to be deleted by the caller), NULL if
+     *    there is no such SOP instance or if the thread could not be started
+     */
+    FileLoader *prefetchNextFile(OFListIterator(TransferEntry *) currentEntry);
+
     /// association counter
     unsigned long AssociationCounter;
     /// presentation context counter
@@ -532,6 +597,8 @@ class DCMTK_DCMNET_EXPORT DcmStorageSCU
     OFList<TransferEntry *> TransferList;
     /// iterator pointing to the current entry in the list of SOP instances to be transferred
     OFListIterator(TransferEntry *) CurrentTransferEntry;
+    /// flag indicating whether to load the next DICOM file while a SOP instance is sent
+    OFBool PrefetchMode;
 
     // private undefined copy constructor
     DcmStorageSCU(const DcmStorageSCU &);
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2019, OFFIS e.V.
+ *  Copyright (C) 1994-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -173,6 +173,52 @@ public:
   virtual void callback(unsigned long mode) = 0;
 };
 
+/** state of a socket option that can be switched on or off
+ */
+typedef enum {
+    /// keep the default, i.e.\ the setting of the environment variable
+    /// (if any) or the operating system default
+    DUL_SOCKOPT_DEFAULT = 0,
+    /// switch the option off
+    DUL_SOCKOPT_DISABLED,
+    /// switch the option on
+    DUL_SOCKOPT_ENABLED
+}   DUL_SOCKETOPTIONSTATE;
+
+/** TCP tuning parameters applied to the socket of an association when the
+ *  transport connection is created (see DUL_RequestAssociation() and
+ *  DUL_ReceiveAssociationRQ()) or later on by DUL_SetSocketOptions().
+ *  A value of 0 (or DUL_SOCKOPT_DEFAULT) keeps the default behaviour, so a
+ *  structure initialized with zeros does not change anything. Options not
+ *  supported by the operating system are ignored with a warning.
+ */
+typedef struct {
+    /// size of the socket send buffer (SO_SNDBUF) in bytes, 0 = default
+    /// (environment variable TCP_BUFFER_LENGTH or operating system default)
+    int sendBufferSize;
+    /// size of the socket receive buffer (SO_RCVBUF) in bytes, 0 = default
+    /// (environment variable TCP_BUFFER_LENGTH or operating system default)
+    int receiveBufferSize;
+    /// disable the Nagle algorithm (TCP_NODELAY) if enabled, default is
+    /// the environment variable TCP_NODELAY or the compile time setting
+    DUL_SOCKETOPTIONSTATE tcpNoDelay;
+    /// send acknowledgements immediately (TCP_QUICKACK, Linux only). Note
+    /// that the kernel may switch back to delayed acknowledgements later.
+    DUL_SOCKETOPTIONSTATE tcpQuickAck;
+    /// send TCP keepalive probes on idle connections (SO_KEEPALIVE)
+    DUL_SOCKETOPTIONSTATE keepAlive;
+    /// idle time in seconds before the first keepalive probe, 0 = default
+    int keepAliveIdle;
+    /// interval in seconds between keepalive probes, 0 = default
+    int keepAliveInterval;
+    /// number of unanswered keepalive probes before the connection is
+    /// dropped, 0 = default
+    int keepAliveCount;
+    /// time in microseconds to busy poll for incoming data (SO_BUSY_POLL,
+    /// Linux only), 0 = no busy polling
+    int busyPoll;
+}   DUL_SOCKETOPTIONS;
+
 typedef struct {
     char applicationContextName[DUL_LEN_NAME + 1];
     char callingAPTitle[DUL_LEN_TITLE + 1];
@@ -188,6 +234,8 @@ typedef struct {
     LST_HEAD *acceptedPresentationContext;
     unsigned short maximumOperationsInvoked;
     unsigned short maximumOperationsPerformed;
+    unsigned short peerMaximumOperationsInvoked;
+    unsigned short peerMaximumOperationsPerformed;
     char callingImplementationClassUID[DICOM_UI_LENGTH + 1];
     char callingImplementationVersionName[16 + 1];
     char calledImplementationClassUID[DICOM_UI_LENGTH + 1];
@@ -199,6 +247,10 @@ typedef struct {
     UserIdentityNegotiationSubItemAC *ackUserIdentNeg;
 
     OFBool useSecureLayer;
+
+    /// socket options applied to the transport connection of an association
+    /// requested with these parameters
+    DUL_SOCKETOPTIONS socketOptions;
 }   DUL_ASSOCIATESERVICEPARAMETERS;
 
 /** Enum describing the possible role settings for role negotiation sub items.
@@ -416,6 +468,19 @@ DUL_AcknowledgeAssociationRQ(
   DUL_ASSOCIATESERVICEPARAMETERS * params,
   int activatePDUStorage);
 
+/** initialize the network. An acceptor creates the socket listening for
+ *  incoming connections.
+ *  @param mode DUL_AEREQUESTOR, DUL_AEACCEPTOR or DUL_AEBOTH
+ *  @param param pointer to the port number (int) listened on by an acceptor
+ *  @param timeout timeout for network operations, in seconds
+ *  @param options network options
+ *  @param network returns the network key
+ *  @param socketOptions socket options applied to each transport connection
+ *    accepted on the network (may be NULL). The buffer sizes are also set on
+ *    the listening socket before listen() is called, so that they are taken
+ *    into account for the TCP window scaling of the accepted connections.
+ *  @return EC_Normal if successful, an error code otherwise
+ */
 DCMTK_DCMNET_EXPORT OFCondition
 DUL_InitializeNetwork(
   const char *mode,
@@ -423,7 +488,8 @@ DUL_InitializeNetwork(
   int timeout,
   unsigned long
   options,
-  DUL_NETWORKKEY ** network);
+  DUL_NETWORKKEY ** network,
+  const DUL_SOCKETOPTIONS *socketOptions = NULL);
 
 DCMTK_DCMNET_EXPORT OFCondition
 DUL_ReceiveAssociationRQ(
@@ -451,7 +517,7 @@ DUL_RequestAssociation(
 
 /* Define functions for releasing/aborting Associations.
 */
-DCMTK_DCMNET_EXPORT OFCondition DUL_AbortAssociation(DUL_ASSOCIATIONKEY ** association);
+DCMTK_DCMNET_EXPORT OFCondition DUL_AbortAssociation(DUL_ASSOCIATIONKEY ** association, OFBool waitForClose = OFTrue);
 DCMTK_DCMNET_EXPORT OFCondition DUL_DropAssociation(DUL_ASSOCIATIONKEY ** association);
 DCMTK_DCMNET_EXPORT OFCondition DUL_CloseTransportConnection(DUL_ASSOCIATIONKEY ** association);
 DCMTK_DCMNET_EXPORT OFCondition DUL_DropNetwork(DUL_NETWORKKEY ** network);
@@ -516,6 +582,43 @@ DCMTK_DCMNET_EXPORT OFCondition DUL_setTransportLayer(DUL_NETWORKKEY *callerNetw
 DCMTK_DCMNET_EXPORT void DUL_activateCompatibilityMode(DUL_ASSOCIATIONKEY *dulassoc, unsigned long mode);
 DCMTK_DCMNET_EXPORT void DUL_activateCallback(DUL_ASSOCIATIONKEY *dulassoc, DUL_ModeCallback *cb);
 
+/** get the number of P-DATA-TF PDUs and bytes (including the PDU headers)
+ *  sent and received on the given association so far
+ *  @param dulassoc the association
+ *  @param pdusSent returns the number of P-DATA-TF PDUs sent
+ *  @param bytesSent returns the number of bytes sent in P-DATA-TF PDUs
+ *  @param pdusReceived returns the number of P-DATA-TF PDUs received
+ *  @param bytesReceived returns the number of bytes received in P-DATA-TF PDUs
+ */
+DCMTK_DCMNET_EXPORT void DUL_getDataPDUStatistics(DUL_ASSOCIATIONKEY *dulassoc,
+                                                  unsigned long& pdusSent,
+                                                  Uint64& bytesSent,
+                                                  unsigned long& pdusReceived,
+                                                  Uint64& bytesReceived);
+
+/** apply socket options to the transport connection of an established
+ *  association, e.g.\ after the acceptor has identified the peer
+ *  @param dulassoc the association
+ *  @param options the socket options to be applied
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition DUL_SetSocketOptions(DUL_ASSOCIATIONKEY *dulassoc,
+                                                     const DUL_SOCKETOPTIONS *options);
+
+/** set the socket options applied to each transport connection accepted on
+ *  the given network. These options are used instead of the ones contained
+ *  in the service parameters passed to DUL_ReceiveAssociationRQ(). The buffer
+ *  sizes are also set on the listening socket, but depending on the operating
+ *  system, they might not be used for the TCP window scaling of connections
+ *  accepted afterwards. Pass the options to DUL_InitializeNetwork() instead
+ *  in order to make sure that they are.
+ *  @param callerNetworkKey the network
+ *  @param options the socket options to be applied
+ *  @return EC_Normal if successful, an error code otherwise
+ */
+DCMTK_DCMNET_EXPORT OFCondition DUL_SetNetworkSocketOptions(DUL_NETWORKKEY *callerNetworkKey,
+                                                            const DUL_SOCKETOPTIONS *options);
+
 /*
  * function allowing to retrieve the peer certificate from the DUL layer
  */
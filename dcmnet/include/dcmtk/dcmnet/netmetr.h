@@ -0,0 +1,257 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Classes collecting latency and throughput metrics of
+ *           associations and DIMSE messages
+ *
+ */
+
+#ifndef NETMETR_H
+#define NETMETR_H
+
+#include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofstring.h"
+#include "dcmtk/ofstd/ofstream.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/ofstd/oftypes.h"
+#include "dcmtk/dcmnet/dndefine.h"
+
+
+/** Statistics of all operations of one kind, e.g.\ the DIMSE commands sent on
+ *  an association. Times are measured in seconds.
+ */
+struct DCMTK_DCMNET_EXPORT DcmNetworkOperationMetrics
+{
+  /** Constructor, initializes all values with 0
+   */
+  DcmNetworkOperationMetrics();
+
+  /** Add a single operation
+   *  @param numBytes [in] Number of bytes transferred by the operation
+   *  @param seconds  [in] Duration of the operation in seconds
+   */
+  void add(const Uint64 numBytes,
+           const double seconds);
+
+  /** Add all operations of another set of statistics
+   *  @param other [in] Statistics to be added
+   */
+  void merge(const DcmNetworkOperationMetrics& other);
+
+  /// Number of operations
+  Uint64 count;
+  /// Number of bytes transferred by all operations
+  Uint64 bytes;
+  /// Total duration of all operations in seconds
+  double totalTime;
+  /// Duration of the longest operation in seconds
+  double maxTime;
+};
+
+
+/** Metrics collected for an association, or for all associations between the
+ *  same application entities if the metrics are aggregated by DcmNetworkMetrics.
+ *  The object is created by the ASC layer when an association is requested or
+ *  received while the collection of metrics is enabled, see
+ *  ASC_getAssociationMetrics().
+ */
+class DCMTK_DCMNET_EXPORT DcmAssociationMetrics
+{
+public:
+
+  /** Constructor
+   */
+  DcmAssociationMetrics();
+
+  /** Add the metrics of another association. The role, AE titles and peer
+   *  address are not changed.
+   *  @param other [in] Metrics to be added
+   */
+  void merge(const DcmAssociationMetrics& other);
+
+  /// OFTrue if we requested the association, OFFalse if we accepted it
+  OFBool requestor;
+  /// Our AE title
+  OFString ourAETitle;
+  /// AE title of the peer
+  OFString peerAETitle;
+  /// Presentation address of the peer, i.e.\ host name or IP address for
+  /// accepted associations and "host:port" for requested associations
+  OFString peerAddress;
+  /// Number of associations the metrics have been collected for
+  Uint64 associations;
+  /// Time (as returned by OFTimer::getTime()) when the association was created
+  double startTime;
+  /// Time (as returned by OFTimer::getTime()) when the negotiation has started
+  double negotiationStartTime;
+  /// Duration of the association negotiation
+  DcmNetworkOperationMetrics negotiation;
+  /// Lifetime of the association, from the request until the association is destroyed
+  DcmNetworkOperationMetrics lifetime;
+  /// DIMSE commands sent
+  DcmNetworkOperationMetrics commandsSent;
+  /// Datasets sent
+  DcmNetworkOperationMetrics datasetsSent;
+  /// DIMSE commands received, measured from the first fragment received
+  DcmNetworkOperationMetrics commandsReceived;
+  /// Datasets received
+  DcmNetworkOperationMetrics datasetsReceived;
+  /// DIMSE commands handled by an SCP, including the receipt of datasets
+  /// and sending the responses
+  DcmNetworkOperationMetrics commandsHandled;
+  /// Number of P-DATA-TF PDUs sent
+  Uint64 pdusSent;
+  /// Number of bytes sent in P-DATA-TF PDUs (including the PDU headers)
+  Uint64 pduBytesSent;
+  /// Number of P-DATA-TF PDUs received
+  Uint64 pdusReceived;
+  /// Number of bytes received in P-DATA-TF PDUs (including the PDU headers)
+  Uint64 pduBytesReceived;
+};
+
+
+/** Abstract listener that is notified by DcmNetworkMetrics about each
+ *  association that has ended
+ */
+class DCMTK_DCMNET_EXPORT DcmNetworkMetricsListener
+{
+public:
+
+  /** Virtual destructor
+   */
+  virtual ~DcmNetworkMetricsListener() {}
+
+  /** Called after an association has ended. The method can be called from
+   *  different threads, but never concurrently.
+   *  @param metrics [in] Metrics of the association
+   */
+  virtual void notifyAssociationMetrics(const DcmAssociationMetrics& metrics) = 0;
+};
+
+
+/** Registry collecting the metrics of all associations of the process. The
+ *  metrics of associations between the same application entities (role, AE
+ *  titles and peer address) are aggregated, so that slow peers can be identified.
+ *  Collecting metrics is disabled by default. The metrics can be written in
+ *  the Prometheus text exposition format or as JSON. All methods can be called
+ *  concurrently from different threads.
+ */
+class DCMTK_DCMNET_EXPORT DcmNetworkMetrics
+{
+public:
+
+  /** Get the only instance of this class
+   *  @return Reference to the registry
+   */
+  static DcmNetworkMetrics& instance();
+
+  /** Enable or disable the collection of metrics. Only associations created
+   *  while the collection is enabled are taken into account.
+   *  @param enabled [in] OFTrue to enable, OFFalse to disable the collection
+   */
+  void setEnabled(const OFBool enabled);
+
+  /** Check whether the collection of metrics is enabled
+   *  @return OFTrue if enabled, OFFalse otherwise
+   */
+  OFBool isEnabled() const;
+
+  /** Register a listener that is notified about each association that ends
+   *  @param listener [in] Listener, not deleted by the registry
+   */
+  void addListener(DcmNetworkMetricsListener* listener);
+
+  /** Unregister a listener
+   *  @param listener [in] Listener registered before
+   */
+  void removeListener(DcmNetworkMetricsListener* listener);
+
+  /** Add the metrics of an association that has ended and notify all listeners.
+   *  Called by ASC_destroyAssociation().
+   *  @param metrics [in] Metrics of the association
+   */
+  void addAssociation(const DcmAssociationMetrics& metrics);
+
+  /** Add the time an incoming association or DIMSE message had to wait for a
+   *  worker thread, e.g.\ in DcmSCPPool or DcmSCPReactor
+   *  @param seconds [in] Waiting time in seconds
+   */
+  void addQueueWait(const double seconds);
+
+  /** Get the aggregated metrics of all associations
+   *  @return Metrics of all associations that have ended
+   */
+  DcmAssociationMetrics getTotals() const;
+
+  /** Get the statistics of the queue waiting times
+   *  @return Statistics of the waiting times
+   */
+  DcmNetworkOperationMetrics getQueueWait() const;
+
+  /** Get the aggregated metrics per peer
+   *  @return Metrics per role, AE titles and peer address
+   */
+  OFList<DcmAssociationMetrics> getPeerMetrics() const;
+
+  /** Discard all metrics collected so far
+   */
+  void reset();
+
+  /** Write all metrics in the Prometheus text exposition format
+   *  @param out [out] Output stream
+   */
+  void writePrometheus(STD_NAMESPACE ostream& out) const;
+
+  /** Write all metrics as a JSON object
+   *  @param out [out] Output stream
+   */
+  void writeJSON(STD_NAMESPACE ostream& out) const;
+
+private:
+
+  /** Private constructor, use instance()
+   */
+  DcmNetworkMetrics();
+
+  /// Private undefined copy constructor
+  DcmNetworkMetrics(const DcmNetworkMetrics& src);
+
+  /// Private undefined assignment operator
+  DcmNetworkMetrics& operator=(const DcmNetworkMetrics& src);
+
+  /// Mutex protecting all members
+  mutable OFMutex m_mutex;
+
+  /// Flag indicating whether metrics are collected
+  OFBool m_enabled;
+
+  /// Aggregated metrics per peer
+  OFList<DcmAssociationMetrics> m_peers;
+
+  /// Statistics of the queue waiting times
+  DcmNetworkOperationMetrics m_queueWait;
+
+  /// Registered listeners
+  OFList<DcmNetworkMetricsListener*> m_listeners;
+
+  /// Mutex serializing the notification of the listeners
+  OFMutex m_notifyMutex;
+};
+
+#endif // NETMETR_H
@@ -345,6 +345,19 @@ public:
      */
     void setProgressNotificationMode(const OFBool mode);
 
+    /** Set the maximum number of outstanding operations that the SCU is allowed to invoke
+     *  asynchronously (see DcmSCPConfig::setMaxOperationsPerformed())
+     *  @param maxOps [in] Maximum number of operations performed, 0 means unlimited
+     *                     (default: 1, i.e.\ no asynchronous operations)
+     */
+    void setMaxOperationsPerformed(const Uint16 maxOps);
+
+    /** Set the size of the chunks in which disk space is reserved in advance when a
+     *  dataset is received directly to file (see DcmSCPConfig::setPreallocationChunkSize())
+     *  @param chunkSize [in] Chunk size in bytes, 0 disables the preallocation (default)
+     */
+    void setPreallocationChunkSize(const Uint32 chunkSize);
+
     /** Option to always accept a default role as association acceptor.
      *  If OFFalse (default) the acceptor will reject a presentation context proposed
      *  with Default role (no role selection at all) when it is configured for role
@@ -432,6 +445,18 @@ public:
      */
     OFBool getProgressNotificationMode() const;
 
+    /** Returns the maximum number of outstanding operations that the SCU is allowed to
+     *  invoke asynchronously
+     *  @return The maximum number of operations performed, 0 means unlimited
+     */
+    Uint16 getMaxOperationsPerformed() const;
+
+    /** Returns the size of the chunks in which disk space is reserved in advance when
+     *  a dataset is received directly to file
+     *  @return The chunk size in bytes, 0 if disabled
+     */
+    Uint32 getPreallocationChunkSize() const;
+
     /** Get access to the configuration of the SCP. Note that the functionality
      *  on the configuration object is shadowed by other API functions of DcmSCP.
      *  The existing functions are provided in order to not break users of this
@@ -701,6 +726,31 @@ protected:
                                             const T_ASC_PresentationContextID presID,
                                             const OFString& filename);
 
+    /** Receive C-STORE request (and store accompanying dataset directly to file).
+     *  The dataset is stored exactly as received, i.e. without any conversions.
+     *  In addition, the attributes at the beginning of the dataset are parsed while
+     *  the dataset is being received, so that information like the patient or study
+     *  data is available without reading the file again afterwards.
+     *  @param reqMessage           [in]  The C-STORE request message that was received
+     *  @param presID               [in]  The presentation context to be used. By default,
+     *                                    the presentation context of the request is used.
+     *  @param filename             [in]  The filename used to store the received dataset
+     *  @param headerAttributes     [out] Dataset that receives the attributes in front of
+     *                                    the stop element (if not NULL). If the header
+     *                                    cannot be parsed, it is left incomplete, which
+     *                                    is not regarded as an error.
+     *  @param stopParsingAtElement [in]  Parsing ends at the first element of the main
+     *                                    dataset with this or a higher tag. By default,
+     *                                    everything but the pixel data and the attributes
+     *                                    following it is parsed.
+     *  @return status, EC_Normal if successful, an error code otherwise
+     */
+    virtual OFCondition receiveSTORERequest(T_DIMSE_C_StoreRQ& reqMessage,
+                                            const T_ASC_PresentationContextID presID,
+                                            const OFString& filename,
+                                            DcmDataset* headerAttributes,
+                                            const DcmTagKey& stopParsingAtElement = DCM_PixelData);
+
     /** Respond to the C-STORE request (with details from the request message)
      *  @param presID        [in] The presentation context ID to respond to
      *  @param reqMessage    [in] The C-STORE request that should be responded to
@@ -1015,6 +1065,16 @@ protected:
      */
     virtual OFCondition processAssociationRQ();
 
+    /** Evaluate the current association request and send the response to the SCU, i.e.
+     *  acknowledge or refuse the association. Unlike processAssociationRQ(), this function
+     *  does not handle any incoming DIMSE commands.
+     *  @param acknowledged [out] OFTrue if the association was acknowledged, OFFalse if it
+     *                            was refused (or if the response could not be sent)
+     *  @return EC_Normal if association request could be processed, ASC_NULLKEY otherwise
+     *          (only if internal association structure is invalid, should never happen)
+     */
+    virtual OFCondition respondToAssociationRQ(OFBool& acknowledged);
+
     /** This function checks all presentation contexts proposed by the SCU whether they are
      *  supported or not. It is not an error if no common presentation context could be
      *  identified with the SCU; only issues like problems in memory management etc. are
@@ -1035,6 +1095,26 @@ protected:
      */
     virtual void handleAssociation();
 
+    /** Receive a single DIMSE command on the current association and handle it by calling
+     *  handleIncomingCommand(). The DIMSE blocking mode and timeout of the SCP configuration
+     *  are used for receiving the command.
+     *  @return EC_Normal if a command was received and handled successfully. Otherwise, the
+     *          error returned, e.g. DUL_PEERREQUESTEDRELEASE or DUL_PEERABORTEDASSOCIATION,
+     *          should be passed to handleAssociationTermination().
+     */
+    virtual OFCondition receiveAndHandleCommand();
+
+    /** Clean up after the handling of DIMSE commands on the current association has ended,
+     *  i.e.\ acknowledge a release request, notify about an aborted association or abort
+     *  the association in case of an error.
+     *  @param cond         [in] The condition that ended the handling of DIMSE commands
+     *  @param waitForClose [in] Wait for the peer to close the connection after aborting
+     *                           the association if OFTrue (default). Otherwise, the caller
+     *                           is responsible for waiting before the association is dropped.
+     */
+    virtual void handleAssociationTermination(const OFCondition& cond,
+                                              const OFBool waitForClose = OFTrue);
+
     /** Send a DIMSE command and possibly also a dataset from a data object via network to
      *  another DICOM application
      *  @param presID          [in]  Presentation context ID to be used for message
@@ -1102,11 +1182,16 @@ protected:
      *                             IDs, this function will return an error.
      *  @param reqMessage  [in]    The C-STORE request message that was received
      *  @param filename    [in]    Name of the file that is created to store the received dataset
+     *  @param headerAttributes [out] Dataset that receives the attributes in front of the
+     *                             stop element while receiving (if not NULL)
+     *  @param stopParsingAtElement [in] Tag of the element where parsing the header ends
      *  @return EC_Normal if dataset could be received successfully, an error code otherwise
      */
     OFCondition receiveSTORERequestDataset(T_ASC_PresentationContextID* presID,
                                            T_DIMSE_C_StoreRQ& reqMessage,
-                                           const OFString& filename);
+                                           const OFString& filename,
+                                           DcmDataset* headerAttributes = NULL,
+                                           const DcmTagKey& stopParsingAtElement = DCM_PixelData);
 
     /** Add given element to existing status detail object or create new one.
      *  @param statusDetail  The status detail to add the element to. Status detail
@@ -223,6 +223,42 @@ public:
    */
   void setAlwaysAcceptDefaultRole(const OFBool enabled);
 
+  /** Set the maximum number of outstanding operations that the SCU is allowed to invoke
+   *  asynchronously, i.e.\ without waiting for the responses. This value is only used if
+   *  the SCU proposes an Asynchronous Operations Window during association negotiation,
+   *  and the smaller one of both values is acknowledged. The operations are still
+   *  performed one after the other by the SCP.
+   *  @param maxOps [in] Maximum number of operations performed, 0 means unlimited.
+   *                     The default value of 1 means that operations are not performed
+   *                     asynchronously. This is also what DICOM assumes if the window
+   *                     is not negotiated at all, i.e.\ an SCP only accepts requests
+   *                     that are sent asynchronously if the application enables this
+   *                     explicitly (e.g.\ because its request handlers do not rely on
+   *                     the response being sent before the next request is received).
+   */
+  void setMaxOperationsPerformed(const Uint16 maxOps);
+
+  /** Set the size of the chunks in which disk space is reserved in advance when a
+   *  dataset is received directly to file (see DcmSCP::receiveSTORERequest()).
+   *  Data that has been written is also removed from the page cache, since it is
+   *  not expected to be read again soon. This avoids fragmentation and reduces the
+   *  memory pressure when receiving very large objects, but has no effect on systems
+   *  that do not support it (see DcmOutputFileStream::setPreallocationChunkSize()).
+   *  @param chunkSize [in] Chunk size in bytes, 0 disables the preallocation (default)
+   */
+  void setPreallocationChunkSize(const Uint32 chunkSize);
+
+  /** Set the TCP tuning parameters (socket buffer sizes, Nagle algorithm, keepalive
+   *  etc.) used for the connections accepted by the SCP. The buffer sizes are also
+   *  set on the listening socket, so they are taken into account for the TCP window
+   *  scaling (see ASC_initializeNetwork()). Socket options defined in the profile of
+   *  an association configuration file take precedence. Must be called before
+   *  listening for associations in order to take effect.
+   *  @param options [in] The socket options, a value-initialized structure keeps
+   *                      the defaults
+   */
+  void setSocketOptions(const T_ASC_SocketOptions& options);
+
   /* Get methods for SCP settings */
 
   /** Returns TCP/IP port number SCP listens for new connection requests
@@ -298,6 +334,24 @@ public:
    */
   OFBool getProgressNotificationMode() const;
 
+  /** Returns the maximum number of outstanding operations that the SCU is allowed to
+   *  invoke asynchronously (see setMaxOperationsPerformed())
+   *  @return The maximum number of operations performed, 0 means unlimited
+   */
+  Uint16 getMaxOperationsPerformed() const;
+
+  /** Returns the size of the chunks in which disk space is reserved in advance when
+   *  a dataset is received directly to file (see setPreallocationChunkSize())
+   *  @return The chunk size in bytes, 0 if disabled
+   */
+  Uint32 getPreallocationChunkSize() const;
+
+  /** Returns the TCP tuning parameters used for the connections accepted by the SCP
+   *  (unless defined in an association configuration file)
+   *  @return The socket options
+   */
+  const T_ASC_SocketOptions& getSocketOptions() const;
+
   /** Returns true if an external transport layer (e.g. TLS) is enabled,
    *  false if the default, transparent layer is used.
    *  @return true if an external transport layer is enabled
@@ -413,6 +467,15 @@ protected:
   /// Progress notification mode (default: OFTrue)
   OFBool m_progressNotificationMode;
 
+  /// Maximum number of outstanding operations the SCU may invoke (default: 1)
+  Uint16 m_maxOperationsPerformed;
+
+  /// Chunk size for reserving disk space when receiving to file (default: 0)
+  Uint32 m_preallocationChunkSize;
+
+  /// TCP tuning parameters of the accepted connections (default: all unset)
+  T_ASC_SocketOptions m_socketOptions;
+
   /// The transport layer in use for communication (e.g. for TLS). 
   /// Default is NULL for the normal TCP layer.
   DcmTransportLayer *m_tLayer; /// Doesn't have ownership
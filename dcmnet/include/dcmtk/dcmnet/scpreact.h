@@ -0,0 +1,500 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Class listening for association requests and serving all
+ *           associations by a small number of event-driven I/O threads
+ *           that wait for incoming data, and a pool of worker threads
+ *           that handle the incoming DIMSE messages. Thus, the number of
+ *           associations is not limited by the number of threads.
+ *
+ */
+
+#ifndef SCPREACT_H
+#define SCPREACT_H
+
+#include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
+
+#if defined(WITH_THREADS) && !defined(_WIN32) // Requires threads and POSIX sockets
+
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/dcmnet/scpthrd.h"
+#include "dcmtk/dcmnet/scpcfg.h"
+#include "dcmtk/dcmnet/assoc.h"
+
+/** Base class for implementing an event-driven SCP with one thread listening
+ *  for incoming TCP/IP connections, a small number of I/O threads waiting for
+ *  incoming data on all acknowledged associations, and a pool of worker
+ *  threads that negotiate the associations and handle the incoming DIMSE
+ *  messages. An association does not occupy any thread while it is idle, so
+ *  many more associations can be served simultaneously than with
+ *  DcmBaseSCPPool, which dedicates a thread to each association.
+ *  On Linux, the I/O threads use epoll(7), on other systems poll().
+ *  The I/O threads read the incoming data of an association into memory
+ *  until a complete DIMSE message (command and dataset, if any) or another
+ *  PDU has arrived, so that a worker thread never waits for a slow peer.
+ *  Thus, the memory needed per association is up to the size of the
+ *  largest DIMSE message received. On secure (TLS) connections, the data
+ *  cannot be inspected by the I/O threads, so the session is handed to a
+ *  worker thread as soon as any data arrives, and the worker thread may
+ *  block until the rest of the message has been received.
+ *  This base class is abstract.
+ *  @remark This class is only available if DCMTK is compiled with thread
+ *    support enabled, and not on Windows.
+ *  @warning This class is EXPERIMENTAL. Be careful to use it in production
+ *    environment.
+ */
+class DCMTK_DCMNET_EXPORT DcmBaseSCPReactor
+{
+private:
+
+  class BufferedConnection;
+
+public:
+
+  /** Abstract base class that handles forwarding the configuration and
+   *  T_ASC_Association to the actual SCP class for each association.
+   *  A session is handled by at most one worker thread at a time, but
+   *  consecutive DIMSE messages may be handled by different threads.
+   */
+  class DCMTK_DCMNET_EXPORT DcmBaseSCPSession
+  {
+    public:
+
+      /** Virtual Destructor
+       */
+      virtual ~DcmBaseSCPSession();
+
+      /** Set SCP configuration that should be used by the session in order
+       *  to handle incoming association requests (presentation contexts, etc.).
+       *  @param config A DcmSharedSCPConfig object to be used by this session.
+       *  @return EC_Normal, if configuration is accepted, error code
+       *          otherwise.
+       */
+      virtual OFCondition setSharedConfig(const DcmSharedSCPConfig& config) = 0;
+
+      /** Acknowledge or refuse the given association. A refused association
+       *  is dropped later on by calling dropAssociation().
+       *  @param assoc The association to be negotiated. Must not be NULL.
+       *  @param acknowledged Returns OFTrue if the association was
+       *         acknowledged, OFFalse otherwise.
+       *  @return EC_Normal if association was negotiated properly (i.e. was
+       *          acknowledged or refused), an error code otherwise.
+       */
+      virtual OFCondition negotiate(T_ASC_Association* assoc,
+                                    OFBool& acknowledged) = 0;
+
+      /** Receive and handle the next DIMSE command. Called whenever data
+       *  is available on the acknowledged association.
+       *  @return EC_Normal if a command was handled, the condition to be
+       *          passed to endAssociation() otherwise.
+       */
+      virtual OFCondition processNextCommand() = 0;
+
+      /** End the handling of the association, e.g.\ acknowledge the release
+       *  request. The association is dropped later on by calling
+       *  dropAssociation().
+       *  @param reason The reason why the association ends, e.g. the
+       *         condition returned by processNextCommand().
+       */
+      virtual void endAssociation(const OFCondition& reason) = 0;
+
+      /** Drop the association without waiting for the peer to close the
+       *  connection. Called after the peer has closed the connection, or
+       *  after the ACSE timeout.
+       */
+      virtual void dropAssociation() = 0;
+
+      /** Get the transport connection of the acknowledged association.
+       *  @return The transport connection, NULL if there is none.
+       */
+      virtual DcmTransportConnection* getTransportConnection() = 0;
+
+    protected:
+
+      /** Protected constructor which is called within the derived class
+       *  DcmSCPReactor in order to create a session.
+       */
+      DcmBaseSCPSession();
+
+    private:
+
+      friend class DcmBaseSCPReactor;
+
+      /// Possible states of a session
+      enum state
+      {
+        /// Session is being negotiated or handled by a worker thread
+        BUSY,
+        /// Session waits for incoming data in one of the I/O threads
+        ARMED,
+        /// Session is queued for a worker thread after data arrived
+        READABLE,
+        /// Session is queued for a worker thread after the DIMSE timeout
+        TIMED_OUT,
+        /// Association has ended, waiting for the peer to close the connection
+        LINGERING,
+        /// Session is queued for a worker thread in order to be dropped
+        CLOSING
+      };
+
+      /// Association to be negotiated by the next worker thread, NULL afterwards
+      T_ASC_Association* m_assoc;
+      /// Index of the I/O thread waiting for data on this session
+      size_t m_ioThread;
+      /// Socket of the association, -1 if not yet assigned to an I/O thread
+      int m_socket;
+      /// Flag indicating whether the socket has been added to the I/O thread
+      OFBool m_watched;
+      /// Current state of the session, guarded by the mutex of the I/O thread
+      state m_state;
+      /// Time when an armed or lingering session times out, 0 for never
+      time_t m_deadline;
+      /// Time (as returned by OFTimer::getTime()) when the session has been queued
+      double m_queueTime;
+      /// Connection buffering incoming DIMSE messages, NULL for TLS connections
+      BufferedConnection* m_connection;
+  };
+
+  /** Virtual destructor, frees internal memory.
+   */
+  virtual ~DcmBaseSCPReactor();
+
+  /** Set the number of I/O threads waiting for incoming data. Each I/O
+   *  thread is responsible for a share of the associations. A single
+   *  thread is usually sufficient since it only dispatches events.
+   *  @param numThreads Number of I/O threads (default: 1, minimum: 1).
+   */
+  virtual void setNumberOfIOThreads(const Uint16 numThreads);
+
+  /** Get the number of I/O threads waiting for incoming data.
+   *  @return Number of I/O threads.
+   */
+  virtual Uint16 getNumberOfIOThreads() const;
+
+  /** Set the number of worker threads handling the incoming DIMSE messages.
+   *  This is the maximum number of DIMSE messages handled simultaneously.
+   *  @param numThreads Number of worker threads. The default value of 0 means
+   *         one thread per processor, but at least four threads.
+   */
+  virtual void setNumberOfWorkerThreads(const Uint16 numThreads);
+
+  /** Get the number of worker threads handling the incoming DIMSE messages.
+   *  @return Number of worker threads, 0 means one thread per processor.
+   */
+  virtual Uint16 getNumberOfWorkerThreads() const;
+
+  /** Set the maximum number of simultaneous associations. Further association
+   *  requests are rejected with the reason "local limit exceeded".
+   *  @param maxAssociations Maximum number of associations (default: 1024).
+   */
+  virtual void setMaxAssociations(const Uint16 maxAssociations);
+
+  /** Get the maximum number of simultaneous associations.
+   *  @return Maximum number of associations.
+   */
+  virtual Uint16 getMaxAssociations() const;
+
+  /** Get number of currently active associations, i.e. associations that
+   *  are negotiated or have been acknowledged and not ended yet.
+   *  @return Number of associations currently handled.
+   */
+  virtual size_t numAssociations();
+
+  /** Listen for incoming association requests. The I/O and worker threads
+   *  are started before and stopped after listening. The A-ASSOCIATE-RQ PDU
+   *  is received by the calling thread, everything else is done by the I/O
+   *  and worker threads.
+   *  @return Error code if a serious error occurs during initialization or
+   *          listening. Returns EC_Normal only after
+   *          stopAfterCurrentAssociations() has been called and all
+   *          associations have ended.
+   */
+  virtual OFCondition listen();
+
+  /** Return handle to the SCP configuration that is used to configure how to
+   *  handle incoming associations. For the reactor, e.g. by providing settings
+   *  for TCP connection timeout, and for the sessions, e.g. by configuration
+   *  presentation contexts and the like. In both DIMSE blocking modes,
+   *  associations that do not send any data within the DIMSE timeout are
+   *  aborted (no timeout if the DIMSE timeout is 0), and so are associations
+   *  that do not complete a DIMSE message that has been started within the
+   *  DIMSE timeout (or the ACSE timeout if the DIMSE timeout is 0).
+   *  @return The SCP configuration(s).
+   */
+  virtual DcmSCPConfig& getConfig();
+
+  /** If called, the reactor stops listening for incoming requests (after the
+   *  connection timeout has expired) and returns from listen() as soon as
+   *  all current associations have ended.
+   */
+  virtual void stopAfterCurrentAssociations();
+
+protected:
+
+  /** Constructor. Initializes internal member variables.
+   */
+  DcmBaseSCPReactor();
+
+  /** Create SCP session for an incoming association.
+   *  @return The session created
+   */
+  virtual DcmBaseSCPSession* createSCPSession() = 0;
+
+  /** Reject association using the given reason, e.g.\ because maximum number
+   *  of associations is currently already served.
+   *  @param assoc The association to reject
+   *  @param reason The rejection reason
+   */
+  void rejectAssociation(T_ASC_Association* assoc,
+                         const T_ASC_RejectParametersReason& reason);
+
+  /** Drops association and clears internal structures to free memory
+   *  @param assoc The association to free
+   */
+  virtual void dropAndDestroyAssociation(T_ASC_Association* assoc);
+
+private:
+
+  class IOThread;
+  class WorkerThread;
+
+  // Needed to keep MS VC6 happy
+  friend class IOThread;
+  friend class WorkerThread;
+  friend class BufferedConnection;
+
+  /// Possible run modes of the reactor
+  enum runmode
+  {
+    /// Listen for new connections
+    LISTEN,
+    /// Stop listening for new connections
+    STOP,
+    /// Shutting down I/O and worker threads
+    SHUTDOWN
+  };
+
+  /** Start I/O and worker threads.
+   *  @return EC_Normal if all threads could be started, an error code otherwise.
+   */
+  OFCondition startThreads();
+
+  /** Stop and delete all I/O and worker threads.
+   */
+  void stopThreads();
+
+  /** Append session to the queue of sessions to be handled by the worker
+   *  threads.
+   *  @param session The session, NULL to stop one worker thread
+   */
+  void enqueue(DcmBaseSCPSession* session);
+
+  /** Handle queued sessions until a NULL entry is dequeued. Called by the
+   *  worker threads.
+   */
+  void processQueue();
+
+  /** Negotiate or continue a session in the calling worker thread.
+   *  @param session The session to be handled
+   */
+  void handleSession(DcmBaseSCPSession* session);
+
+  /** Wait for further data on the given session, i.e. hand it to an I/O
+   *  thread, or queue it again if data is already available.
+   *  @param session The session to be continued
+   */
+  void continueSession(DcmBaseSCPSession* session);
+
+  /** Hand the given session to an I/O thread that waits for the peer to
+   *  close the connection after the association has ended.
+   *  @param session The session that has ended
+   */
+  void lingerSession(DcmBaseSCPSession* session);
+
+  /** Stop watching the given session and end its association without
+   *  waiting for the peer to close the connection.
+   *  @param session The session to be ended
+   *  @param reason The condition that ended the association
+   */
+  void endSession(DcmBaseSCPSession* session,
+                  const OFCondition& reason);
+
+  /** Hand the given session to its I/O thread (which is chosen on the first
+   *  call) that waits for incoming data or for the connection being closed.
+   *  @param session The session to be watched
+   *  @param lingering OFTrue if the association has ended, OFFalse otherwise
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition watchSession(DcmBaseSCPSession* session,
+                           const OFBool lingering);
+
+  /** Drop the association of the given session and free its memory.
+   *  @param session The session to be closed
+   */
+  void closeSession(DcmBaseSCPSession* session);
+
+  /// Mutex that guards the number of associations and the run mode
+  OFMutex m_criticalSection;
+  /// Number of associations currently handled
+  size_t m_numAssociations;
+
+  /// Mutex that guards the queue of sessions
+  OFMutex m_queueMutex;
+  /// Sessions to be handled by the worker threads
+  OFList<DcmBaseSCPSession*> m_queue;
+  /// Number of entries in the queue of sessions
+  OFSemaphore m_queueSize;
+
+  /// I/O threads waiting for incoming data
+  OFVector<IOThread*> m_ioThreads;
+  /// Worker threads handling the queued sessions
+  OFVector<WorkerThread*> m_workers;
+  /// Index of the I/O thread to be used for the next association
+  size_t m_nextIOThread;
+
+  /// SCP configuration to be used by reactor and all sessions
+  DcmSCPConfig m_cfg;
+  /// Number of I/O threads
+  Uint16 m_numIOThreads;
+  /// Number of worker threads, 0 means one per processor
+  Uint16 m_numWorkers;
+  /// Maximum number of simultaneous associations
+  Uint16 m_maxAssociations;
+
+  /// Current run mode of reactor
+  runmode m_runMode;
+
+  /** Private undefined copy constructor. Shall never be called.
+   *  @param src Source object
+   */
+  DcmBaseSCPReactor(const DcmBaseSCPReactor& src);
+
+  /** Private undefined assignment operator. Shall never be called.
+   *  @param src Source object
+   *  @return Reference to this
+   */
+  DcmBaseSCPReactor& operator=(const DcmBaseSCPReactor& src);
+};
+
+/** Implementation of an event-driven DICOM SCP server. The reactor waits for
+ *  incoming TCP/IP connection requests, accepts them on TCP/IP level and hands
+ *  the association to one of its worker threads for negotiation. Afterwards,
+ *  the association is watched by an I/O thread that hands it to a worker
+ *  thread whenever a DIMSE message arrives. The maximum number of
+ *  simultaneous associations is configurable. The default is 1024. If this
+ *  number is reached, an incoming request is rejected with the error "local
+ *  limit exceeded".
+ *  @tparam SCP the service class provider to be instantiated for each request,
+ *    should follow the @ref SCPSession_Concept.
+ *  @tparam SCPReactor the base SCP reactor class to use. Use this parameter if
+ *    you want to use a different implementation (probably derived from
+ *    DcmBaseSCPReactor) as base class for implementing the SCP reactor.
+ *  @tparam BaseSCPSession the base SCP session class to use.
+ */
+template<typename SCP = DcmThreadSCP, typename SCPReactor = DcmBaseSCPReactor, typename BaseSCPSession = OFTypename SCPReactor::DcmBaseSCPSession>
+class DcmSCPReactor : public SCPReactor
+{
+public:
+
+    /** Default construct a DcmSCPReactor object.
+     */
+    DcmSCPReactor() : SCPReactor()
+    {
+    }
+
+private:
+
+    /** Helper class to use any class as an SCPSession as long as it is a
+     *  model of the @ref SCPSession_Concept.
+     */
+    struct SCPSession : public BaseSCPSession
+                      , private SCP
+    {
+        /** Construct a SCPSession.
+         */
+        SCPSession()
+          : BaseSCPSession()
+          , SCP()
+        {
+        }
+
+        /** Set the shared configuration for this session.
+         *  @param config a DcmSharedSCPConfig object to be used by this session.
+         *  @return the result of the underlying SCP implementation.
+         */
+        virtual OFCondition setSharedConfig(const DcmSharedSCPConfig& config)
+        {
+            return SCP::setSharedConfig(config);
+        }
+
+        /** Acknowledge or refuse the given association.
+         *  @param assoc The association to be negotiated
+         *  @param acknowledged Returns OFTrue if association was acknowledged
+         *  @return the result of the underlying SCP implementation.
+         */
+        virtual OFCondition negotiate(T_ASC_Association* assoc,
+                                      OFBool& acknowledged)
+        {
+            return SCP::negotiate(assoc, acknowledged);
+        }
+
+        /** Receive and handle the next DIMSE command.
+         *  @return the result of the underlying SCP implementation.
+         */
+        virtual OFCondition processNextCommand()
+        {
+            return SCP::processNextCommand();
+        }
+
+        /** End the handling of the association.
+         *  @param reason The reason why the association ends
+         */
+        virtual void endAssociation(const OFCondition& reason)
+        {
+            SCP::endAssociation(reason);
+        }
+
+        /** Drop the association.
+         */
+        virtual void dropAssociation()
+        {
+            SCP::dropAssociation();
+        }
+
+        /** Get the transport connection of the association.
+         *  @return the result of the underlying SCP implementation.
+         */
+        virtual DcmTransportConnection* getTransportConnection()
+        {
+            return SCP::getTransportConnection();
+        }
+    };
+
+    /** Create a session to be used for handling an association.
+     *  @return a pointer to a newly created SCP session.
+     */
+    virtual BaseSCPSession* createSCPSession()
+    {
+        return new SCPSession;
+    }
+};
+
+#endif // WITH_THREADS && !_WIN32
+
+#endif // SCPREACT_H
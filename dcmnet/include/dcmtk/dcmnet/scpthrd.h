@@ -58,6 +58,59 @@ public:
    */
   virtual OFCondition run(T_ASC_Association* incomingAssoc);
 
+  /** Negotiate an already established (on TCP/IP level) connection, i.e.
+   *  acknowledge or refuse the association request, without handling any
+   *  DIMSE commands. This function is used in an event-driven context (see
+   *  DcmBaseSCPReactor) where a central thread waits for incoming data on
+   *  many associations and calls processNextCommand() whenever a DIMSE
+   *  message arrives. If the association is refused, the association
+   *  termination is notified before the function returns, and the caller
+   *  has to call dropAssociation() later on.
+   *  @param incomingAssoc the association of the connection.
+   *  @param acknowledged returns OFTrue if the association was acknowledged,
+   *         OFFalse otherwise.
+   *  @return If negotiation fails, e.g. because the given association is not
+   *          valid, an error is reported. In all other cases, e.g. if no
+   *          presentation contexts could be negotiated with the requesting
+   *          SCU, EC_Normal is returned.
+   */
+  virtual OFCondition negotiate(T_ASC_Association* incomingAssoc,
+                                OFBool& acknowledged);
+
+  /** Receive and handle the next DIMSE command on the association that has
+   *  been acknowledged by negotiate(). The caller should make sure that data
+   *  is available on the connection since the DIMSE blocking mode and timeout
+   *  of the SCP configuration are used for receiving the command.
+   *  @return EC_Normal if a command was handled, otherwise the condition
+   *          that should be passed to endAssociation(), e.g.
+   *          DUL_PEERREQUESTEDRELEASE.
+   */
+  virtual OFCondition processNextCommand();
+
+  /** End the handling of the current association, i.e.\ acknowledge the
+   *  release request, abort the association in case of an error and notify
+   *  about the association termination. Afterwards, the peer is expected to
+   *  close the connection, and the caller has to call dropAssociation().
+   *  @param reason the condition returned by processNextCommand() or the
+   *         reason why the association is terminated otherwise, e.g.
+   *         DIMSE_NODATAAVAILABLE if the peer did not send any data within
+   *         the DIMSE timeout.
+   */
+  virtual void endAssociation(const OFCondition& reason);
+
+  /** Drop the current association and free its memory. Unlike the DcmSCP
+   *  default behavior, this function does not wait for the peer to close
+   *  the connection, i.e. the caller should make sure that the peer had a
+   *  chance to do so before.
+   */
+  virtual void dropAssociation();
+
+  /** Get the transport connection of the current association, e.g.\ in order
+   *  to wait for incoming data on the underlying socket.
+   *  @return the transport connection, NULL if there is no association.
+   */
+  virtual DcmTransportConnection* getTransportConnection();
+
   /** Get access to the DcmSharedSCPConfig object. The shared configuration can be used
    *  to provide other SCPs with the same configuration without the need to copy it.
    *  @return a reference to the DcmSharedSCPConfig object used by this DcmSCP object.
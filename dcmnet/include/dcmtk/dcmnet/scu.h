@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2008-2019, OFFIS e.V.
+ *  Copyright (C) 2008-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -203,7 +203,10 @@ public:
      */
     virtual ~DcmSCU();
 
-    /** Add presentation context to be used for association negotiation
+    /** Add presentation context to be used for association negotiation.
+     *  A presentation context with the same abstract syntax, transfer syntaxes
+     *  and role as one that has already been added is ignored, so it is not
+     *  proposed twice.
      *  @param abstractSyntax [in] Abstract syntax name in UID format
      *  @param xferSyntaxes   [in] List of transfer syntaxes to be added for the given abstract
      *                             syntax
@@ -272,6 +275,12 @@ public:
      *  instance can be converted automatically to the network transfer syntax that was
      *  negotiated (and is specified by the parameter 'presID'). However, this feature is
      *  disabled by default. See setDatasetConversionMode() on how to enable it.
+     *  When sending a DICOM file, large element values like the pixel data are not loaded
+     *  into memory but read from the file in chunks while the request is being sent, i.e.\
+     *  the amount of memory needed does not depend on the size of the SOP instance. This
+     *  does not apply if the dataset conversion is enabled (see setDatasetConversionMode())
+     *  and the pixel data has to be compressed or decompressed for the negotiated transfer
+     *  syntax. In this case, the whole SOP instance is loaded into memory.
      *  @param presID        [in]  Contains in the end the ID of the presentation context which
      *                             was specified in the DIMSE command. If 0 is given, the
      *                             function tries to find an appropriate presentation context
@@ -302,6 +311,54 @@ public:
                                          const OFString& moveOriginatorAETitle = "",
                                          const Uint16 moveOriginatorMsgID      = 0);
 
+    /** This function sends a C-STORE request on the currently opened association but does
+     *  not wait for the corresponding response, i.e.\ several requests can be outstanding
+     *  at the same time (asynchronous operations). The maximum number of outstanding requests
+     *  is limited by the Asynchronous Operations Window negotiated with the peer (see
+     *  setMaxOperationsInvoked() and getNegotiatedMaxOperationsInvoked()). If this maximum
+     *  is already reached, a response is received first and kept for a subsequent call of
+     *  receiveSTOREResponse(). Without a negotiated window, only one request can be
+     *  outstanding at a time.
+     *  @param presID        [in]  ID of the presentation context to be used for the DIMSE
+     *                             command. If 0 is given, the function tries to find an
+     *                             appropriate presentation context itself (see
+     *                             sendSTORERequest() for details).
+     *  @param dicomFile     [in]  The filename of the DICOM file to be sent. Alternatively, a
+     *                             dataset can be given in the next parameter. If both are given
+     *                             the dataset from the file name is used.
+     *  @param dataset       [in]  The dataset to be sent. Alternatively, a filename can be
+     *                             specified in the previous parameter. If both are given the
+     *                             dataset from the filename is used.
+     *  @param messageID     [out] The message ID of the request sent. It is used to match
+     *                             the request with the response (see receiveSTOREResponse()).
+     *  @param moveOriginatorAETitle [in] If this C-STORE is started due to a C-MOVE request,
+     *                               this parameter informs the C-STORE SCP about the C-MOVE
+     *                               client's AE title.
+     *  @param moveOriginatorMsgID   [in] If this C-STORE is started due to a C-MOVE request,
+     *                               this parameter informs the C-STORE SCP about the C-MOVE
+     *                               message ID.
+     *  @return EC_Normal if the request could be sent successfully, error code otherwise
+     */
+    virtual OFCondition sendSTORERequestAsync(const T_ASC_PresentationContextID presID,
+                                              const OFFilename& dicomFile,
+                                              DcmDataset* dataset,
+                                              Uint16& messageID,
+                                              const OFString& moveOriginatorAETitle = "",
+                                              const Uint16 moveOriginatorMsgID      = 0);
+
+    /** This function receives the response to one of the outstanding C-STORE requests that
+     *  were sent by sendSTORERequestAsync(). Responses that have already been received while
+     *  sending further requests are returned first (in the order of their arrival).
+     *  @param messageIDRespondedTo [out] The message ID of the request the response refers to
+     *  @param rspStatusCode        [out] The response status code received. 0 means success,
+     *                                    others can be found in the DICOM standard.
+     *  @return EC_Normal if a response was received successfully, EC_IllegalCall if there is
+     *          no outstanding request, error code otherwise. Please note that EC_Normal is also
+     *          returned if the receiver sends a response denoting failure of the storage request.
+     */
+    virtual OFCondition receiveSTOREResponse(Uint16& messageIDRespondedTo,
+                                             Uint16& rspStatusCode);
+
     /** Sends a C-MOVE Request on given presentation context and receives list of responses.
      *  The function receives the first response and then calls the function handleMOVEResponse()
      *  which gets the relevant presentation context together with the response dataset and
@@ -646,6 +703,17 @@ public:
      */
     void setConnectionTimeout(const Sint32 connectionTimeout);
 
+    /** Set the TCP tuning parameters (socket buffer sizes, Nagle algorithm,
+     *  keepalive etc.) used for the associations of this SCU. In contrast to
+     *  the environment variables TCP_BUFFER_LENGTH and TCP_NODELAY, the options
+     *  only affect this SCU. Socket options defined in the profile of an
+     *  association configuration file take precedence. Must be called before
+     *  initNetwork() in order to take effect.
+     *  @param options [in] The socket options, a value-initialized structure
+     *                      keeps the defaults
+     */
+    void setSocketOptions(const T_ASC_SocketOptions& options);
+
     /** Set an association configuration file and profile to be used
      *  @param filename [in] File name of the association configuration file
      *  @param profile  [in] Profile inside the association negotiation file
@@ -673,7 +741,8 @@ public:
 
     /** Set the mode that specifies whether the transfer syntax of the dataset can be changed
      *  for network transmission. This mainly covers the compression/decompression of datasets,
-     *  which is disabled by default.
+     *  which is disabled by default. Please note that a dataset that has to be compressed or
+     *  decompressed is loaded into memory completely, even if it is sent from a DICOM file.
      *  @param mode [in] Allow dataset conversion if OFTrue
      */
     void setDatasetConversionMode(const OFBool mode);
@@ -685,6 +754,14 @@ public:
      */
     void setProgressNotificationMode(const OFBool mode);
 
+    /** Set the maximum number of outstanding operations to be proposed in the Asynchronous
+     *  Operations Window during association negotiation. The default value of 1 means that
+     *  operations are performed synchronously and that the window is not proposed at all.
+     *  @param maxOps [in] Maximum number of operations that this SCU wants to invoke without
+     *                     waiting for the responses, 0 means unlimited
+     */
+    void setMaxOperationsInvoked(const Uint16 maxOps);
+
     /* Get methods */
 
     /** Get current connection status
@@ -692,6 +769,24 @@ public:
      */
     OFBool isConnected() const;
 
+    /** Check whether the current association can still be used for sending requests,
+     *  e.g.\ after it has been idle for some time. This is not the case if the SCU is
+     *  not connected, or if data has been received while no request was outstanding,
+     *  which means that the peer has released or aborted the association or closed
+     *  the connection.
+     *  @return OFTrue if the association can be used, OFFalse otherwise
+     */
+    OFBool isAssociationUsable() const;
+
+    /** Get the metrics collected for the current association so far, e.g.\ the time
+     *  needed for sending and receiving DIMSE messages. Metrics are only collected if
+     *  enabled in DcmNetworkMetrics when the association is negotiated. When the
+     *  association ends, its metrics are added to DcmNetworkMetrics.
+     *  @return Metrics of the current association, NULL if not connected or if no
+     *    metrics are collected. The pointer becomes invalid when the association ends.
+     */
+    const DcmAssociationMetrics* getAssociationMetrics() const;
+
     /** Returns maximum PDU length configured to be received by SCU
      *  @return Maximum PDU length in bytes
      */
@@ -742,6 +837,12 @@ public:
      */
     Sint32 getConnectionTimeout() const;
 
+    /** Returns the TCP tuning parameters used for the associations of this SCU
+     *  (unless defined in an association configuration file)
+     *  @return The socket options
+     */
+    const T_ASC_SocketOptions& getSocketOptions() const;
+
     /** Returns the storage directory used for storing objects received with C-STORE requests
      *  in the context of C-GET sessions. Default is empty string which refers to the current
      *  working directory.
@@ -777,6 +878,26 @@ public:
      */
     OFBool getProgressNotificationMode() const;
 
+    /** Get the maximum number of outstanding operations to be proposed in the Asynchronous
+     *  Operations Window
+     *  @return Maximum number of operations invoked (0 means unlimited)
+     */
+    Uint16 getMaxOperationsInvoked() const;
+
+    /** Get the maximum number of outstanding operations that have been negotiated for the
+     *  current association, i.e.\ the number of C-STORE requests that can be sent by
+     *  sendSTORERequestAsync() without receiving the responses
+     *  @return Maximum number of operations invoked (0 means unlimited, 1 if no association
+     *          is active or no Asynchronous Operations Window has been negotiated)
+     */
+    Uint16 getNegotiatedMaxOperationsInvoked() const;
+
+    /** Get the number of C-STORE requests sent by sendSTORERequestAsync() that have not yet
+     *  been returned by receiveSTOREResponse()
+     *  @return Number of outstanding C-STORE requests
+     */
+    size_t getNumberOfOutstandingSTORERequests() const;
+
     /** Returns whether SCU is configured to create a TLS connection with the SCP
      *  @return OFFalse for this class but may be overridden by derived classes
      */
@@ -979,6 +1100,38 @@ private:
      */
     DcmSCU& operator=(const DcmSCU& src);
 
+    /** Sends a C-STORE request without waiting for the response (see sendSTORERequest())
+     *  @param presID                [in]  ID of the presentation context (0 = find automatically)
+     *  @param dicomFile             [in]  The filename of the DICOM file to be sent
+     *  @param dataset               [in]  The dataset to be sent (if no filename is given)
+     *  @param messageID             [out] The message ID of the request sent
+     *  @param moveOriginatorAETitle [in]  C-MOVE originator AE title (optional)
+     *  @param moveOriginatorMsgID   [in]  C-MOVE originator message ID (optional)
+     *  @return EC_Normal if the request could be sent successfully, error code otherwise
+     */
+    OFCondition sendSTORERequestMessage(const T_ASC_PresentationContextID presID,
+                                        const OFFilename& dicomFile,
+                                        DcmDataset* dataset,
+                                        Uint16& messageID,
+                                        const OFString& moveOriginatorAETitle,
+                                        const Uint16 moveOriginatorMsgID);
+
+    /** Receives the next C-STORE response from the network and checks that it refers to one
+     *  of the outstanding requests, which is then removed from the list. If no valid response
+     *  can be received, all outstanding requests are discarded, since their responses cannot be
+     *  matched reliably anymore.
+     *  @param messageIDRespondedTo [out] The message ID of the request the response refers to
+     *  @param rspStatusCode        [out] The response status code received
+     *  @return EC_Normal if a valid response was received, error code otherwise
+     */
+    OFCondition receiveSTOREResponseMessage(Uint16& messageIDRespondedTo,
+                                            Uint16& rspStatusCode);
+
+    /** Forgets about all outstanding C-STORE requests (e.g.\ after a network error),
+     *  so that they are not waited for anymore
+     */
+    void discardOutstandingSTORERequests();
+
     /// Association of this SCU. This class only handles 1 association at a time.
     T_ASC_Association* m_assoc;
 
@@ -1069,6 +1222,36 @@ private:
     /// Progress notification mode (default: enabled)
     OFBool m_progressNotificationMode;
 
+    /// Maximum number of operations invoked to be proposed (default: 1, i.e.\ synchronous)
+    Uint16 m_maxOperationsInvoked;
+
+    /// TCP tuning parameters used for the associations
+    T_ASC_SocketOptions m_socketOptions;
+
+    /// Response to a C-STORE request that was received but not yet returned to the caller
+    struct DCMTK_DCMNET_EXPORT DcmSCUStoreResponse
+    {
+        /** Constructor
+         *  @param id     [in] Message ID of the request the response refers to
+         *  @param status [in] Response status code
+         */
+        DcmSCUStoreResponse(const Uint16 id, const Uint16 status)
+            : messageID(id)
+            , statusCode(status)
+        {
+        }
+        /// Message ID of the request the response refers to
+        Uint16 messageID;
+        /// Response status code
+        Uint16 statusCode;
+    };
+
+    /// Message IDs of the C-STORE requests for which no response has been received yet
+    OFList<Uint16> m_outstandingStoreRequests;
+
+    /// C-STORE responses received but not yet returned by receiveSTOREResponse()
+    OFList<DcmSCUStoreResponse> m_receivedStoreResponses;
+
     /** Returns next available message ID free to be used by SCU
      *  @return Next free message ID
      */
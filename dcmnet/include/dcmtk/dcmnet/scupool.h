@@ -0,0 +1,280 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Class maintaining a pool of established associations that
+ *           can be reused by subsequent (and concurrent) senders
+ *
+ */
+
+#ifndef SCUPOOL_H
+#define SCUPOOL_H
+
+#include "dcmtk/config/osconfig.h"  /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oflist.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmnet/scu.h"
+
+#include <ctime>
+
+
+/** Class maintaining a pool of associations to one or more peers. Instead of
+ *  negotiating a new association for each (small) transfer, a sender acquires
+ *  a connected DcmSCU from the pool, uses it and returns it to the pool, where
+ *  the association is kept alive for subsequent requests to the same peer
+ *  (host, port and AE titles). If the presentation context needed by a
+ *  subsequent request has not been negotiated, the association is released and
+ *  renegotiated with the additional presentation context, i.e.\ the set of
+ *  presentation contexts grows lazily. Idle associations are released after
+ *  a configurable timeout. All methods can be called concurrently from
+ *  different threads, each DcmSCU is only handed out to one caller at a time.
+ */
+class DCMTK_DCMNET_EXPORT DcmSCUPool
+{
+public:
+
+  /** Constructor
+   */
+  DcmSCUPool();
+
+  /** Virtual destructor, releases all idle associations. All DcmSCU objects
+   *  acquired from this pool must have been returned before.
+   */
+  virtual ~DcmSCUPool();
+
+  /** Get a DcmSCU with an association to the given peer on which the given
+   *  abstract syntax has been accepted with one of the given transfer syntaxes.
+   *  An idle association from the pool is reused if possible, otherwise a new
+   *  association is negotiated. The DcmSCU must be returned to the pool by
+   *  releaseSCU() or discardSCU() after use. If the peer has already rejected
+   *  the abstract syntax on an idle association and no other association to
+   *  the peer can be used, NET_EC_NoAcceptablePresentationContexts is returned
+   *  immediately without renegotiating the association.
+   *  @param peerHostName   [in]  Host name or IP address of the peer
+   *  @param peerPort       [in]  TCP port of the peer
+   *  @param aeTitle        [in]  Calling AE title
+   *  @param peerAETitle    [in]  Called AE title
+   *  @param abstractSyntax [in]  Abstract syntax (SOP class UID) required
+   *  @param xferSyntaxes   [in]  Transfer syntaxes proposed for the abstract syntax
+   *  @param scu            [out] Connected DcmSCU, NULL in case of error
+   *  @param presID         [out] ID of the accepted presentation context for the
+   *                              abstract syntax, 0 in case of error
+   *  @return EC_Normal if successful, NET_EC_NoAcceptablePresentationContexts if
+   *    the peer did not accept the abstract syntax, another error code otherwise
+   */
+  OFCondition acquireSCU(const OFString& peerHostName,
+                         const Uint16 peerPort,
+                         const OFString& aeTitle,
+                         const OFString& peerAETitle,
+                         const OFString& abstractSyntax,
+                         const OFList<OFString>& xferSyntaxes,
+                         DcmSCU*& scu,
+                         T_ASC_PresentationContextID& presID);
+
+  /** Return a DcmSCU acquired from this pool, so that its association can be
+   *  reused. If the association is no longer usable or if the maximum number of
+   *  idle associations is reached, the association is released and the DcmSCU
+   *  is deleted.
+   *  @param scu [inout] DcmSCU to be returned, set to NULL afterwards
+   */
+  void releaseSCU(DcmSCU*& scu);
+
+  /** Return a DcmSCU acquired from this pool that should not be reused, e.g.\ after
+   *  a network error. The association is aborted and the DcmSCU is deleted.
+   *  @param scu [inout] DcmSCU to be discarded, set to NULL afterwards
+   */
+  void discardSCU(DcmSCU*& scu);
+
+  /** Release all idle associations that have not been used for longer than the
+   *  idle timeout. This is also done by acquireSCU() and releaseSCU(), but can be
+   *  called periodically in order to release associations when there is no traffic.
+   *  @return number of associations released
+   */
+  size_t closeExpiredAssociations();
+
+  /** Release all idle associations
+   */
+  void closeIdleAssociations();
+
+  /** Set the time after which idle associations are released
+   *  @param seconds [in] Timeout in seconds (default: 60), 0 releases
+   *                      associations as soon as they are returned
+   */
+  void setIdleTimeout(const Uint32 seconds);
+
+  /** Set the maximum number of idle associations kept in the pool
+   *  @param count [in] Maximum number of idle associations (default: 8)
+   */
+  void setMaxIdleAssociations(const size_t count);
+
+  /** Get the time after which idle associations are released
+   *  @return Timeout in seconds
+   */
+  Uint32 getIdleTimeout() const;
+
+  /** Get the maximum number of idle associations kept in the pool
+   *  @return Maximum number of idle associations
+   */
+  size_t getMaxIdleAssociations() const;
+
+  /** Get the number of idle associations currently kept in the pool
+   *  @return Number of idle associations
+   */
+  size_t getNumberOfIdleAssociations() const;
+
+protected:
+
+  /** Create a new DcmSCU. Can be overwritten by derived classes in order to
+   *  configure further parameters like timeouts, the maximum PDU length or a
+   *  secure transport layer. Peer, AE titles and presentation contexts are set
+   *  by the pool.
+   *  @return new DcmSCU object, which is deleted by the pool
+   */
+  virtual DcmSCU* createSCU();
+
+private:
+
+  /// Association maintained by the pool
+  struct DCMTK_DCMNET_EXPORT Entry
+  {
+    /** Constructor
+     *  @param peerHostName [in] Host name or IP address of the peer
+     *  @param peerPort     [in] TCP port of the peer
+     *  @param aeTitle      [in] Calling AE title
+     *  @param peerAETitle  [in] Called AE title
+     */
+    Entry(const OFString& peerHostName,
+          const Uint16 peerPort,
+          const OFString& aeTitle,
+          const OFString& peerAETitle)
+    : scu(NULL)
+    , peer(peerHostName)
+    , port(peerPort)
+    , ourAETitle(aeTitle)
+    , peerAETitle(peerAETitle)
+    , lastUsed(0)
+    , rejected()
+    {
+    }
+
+    /** Check whether this association refers to the given peer and AE titles
+     *  @param peerHostName [in] Host name or IP address of the peer
+     *  @param peerPort     [in] TCP port of the peer
+     *  @param aeTitle      [in] Calling AE title
+     *  @param peerAETitle  [in] Called AE title
+     *  @return OFTrue if peer and AE titles match, OFFalse otherwise
+     */
+    OFBool matches(const OFString& peerHostName,
+                   const Uint16 peerPort,
+                   const OFString& aeTitle,
+                   const OFString& peerAETitle) const
+    {
+      return (port == peerPort) && (peer == peerHostName) &&
+             (ourAETitle == aeTitle) && (this->peerAETitle == peerAETitle);
+    }
+
+    /** Check whether the peer has rejected the given abstract syntax on this
+     *  association
+     *  @param abstractSyntax [in] Abstract syntax
+     *  @return OFTrue if the abstract syntax has been rejected, OFFalse otherwise
+     */
+    OFBool isRejected(const OFString& abstractSyntax) const
+    {
+      for (OFListConstIterator(OFString) it = rejected.begin(); it != rejected.end(); ++it)
+      {
+        if (*it == abstractSyntax)
+          return OFTrue;
+      }
+      return OFFalse;
+    }
+
+    /// SCU with the association
+    DcmSCU* scu;
+    /// Host name or IP address of the peer
+    OFString peer;
+    /// TCP port of the peer
+    Uint16 port;
+    /// Calling AE title
+    OFString ourAETitle;
+    /// Called AE title
+    OFString peerAETitle;
+    /// Time when the association has been returned to the pool
+    time_t lastUsed;
+    /// Abstract syntaxes the peer has not accepted on this association
+    OFList<OFString> rejected;
+  };
+
+  /** Find an accepted presentation context for the given abstract syntax and
+   *  one of the given transfer syntaxes
+   *  @param scu            [in] Connected SCU
+   *  @param abstractSyntax [in] Abstract syntax
+   *  @param xferSyntaxes   [in] Transfer syntaxes
+   *  @return ID of the presentation context, 0 if none found
+   */
+  static T_ASC_PresentationContextID findPresentationContext(DcmSCU& scu,
+                                                             const OFString& abstractSyntax,
+                                                             const OFList<OFString>& xferSyntaxes);
+
+  /** Negotiate a (new) association for the given entry
+   *  @param entry [in] Entry with the SCU to be connected
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition negotiate(Entry& entry);
+
+  /** Remove all expired idle associations from the pool (must be called while
+   *  the mutex is locked)
+   *  @param expired [out] List the expired entries are appended to
+   */
+  void removeExpiredEntries(OFList<Entry*>& expired);
+
+  /** Close the associations of the given entries and delete them
+   *  @param entries [inout] Entries to be closed, cleared afterwards
+   *  @param abort   [in]    Abort the associations if OFTrue, release them otherwise
+   */
+  static void closeEntries(OFList<Entry*>& entries,
+                           const OFBool abort);
+
+  /** Find and remove the entry of an acquired SCU (must be called while the
+   *  mutex is locked)
+   *  @param scu [in] SCU handed out by the pool
+   *  @return entry of the SCU, NULL if the SCU does not belong to this pool
+   */
+  Entry* removeBusyEntry(const DcmSCU* scu);
+
+  /// Private undefined copy constructor
+  DcmSCUPool(const DcmSCUPool& src);
+
+  /// Private undefined assignment operator
+  DcmSCUPool& operator=(const DcmSCUPool& src);
+
+  /// Mutex protecting the lists of associations
+  mutable OFMutex m_mutex;
+
+  /// Idle associations, the most recently used one first
+  OFList<Entry*> m_idle;
+
+  /// Associations currently handed out to a caller
+  OFList<Entry*> m_busy;
+
+  /// Time in seconds after which idle associations are released
+  Uint32 m_idleTimeout;
+
+  /// Maximum number of idle associations
+  size_t m_maxIdle;
+};
+
+#endif // SCUPOOL_H
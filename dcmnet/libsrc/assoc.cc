@@ -118,6 +118,7 @@
 #include "dcmtk/ofstd/ofconsol.h"
 #include "dcmtk/ofstd/ofstd.h"
 #include "dcmtk/dcmnet/dcmtrans.h"
+#include "dcmtk/ofstd/oftimer.h"
 
 /*
 ** Constant Definitions
@@ -213,12 +214,13 @@ typedef struct {
 */
 
 
-OFCondition
-ASC_initializeNetwork(T_ASC_NetworkRole role,
-                      int acceptorPort,
-                      int timeout,
-                      T_ASC_Network ** network,
-                      unsigned long options)
+static OFCondition
+initializeNetwork(T_ASC_NetworkRole role,
+                  int acceptorPort,
+                  int timeout,
+                  T_ASC_Network ** network,
+                  const T_ASC_SocketOptions * socketOptions,
+                  unsigned long options)
 {
     const char *mode;
 
@@ -239,7 +241,7 @@ ASC_initializeNetwork(T_ASC_NetworkRole role,
         break;
     }
 
-    OFCondition cond = DUL_InitializeNetwork(mode, &acceptorPort, timeout, DUL_ORDERBIGENDIAN | options, &netkey);
+    OFCondition cond = DUL_InitializeNetwork(mode, &acceptorPort, timeout, DUL_ORDERBIGENDIAN | options, &netkey, socketOptions);
     if (cond.bad()) return cond;
 
     *network = (T_ASC_Network *) malloc(sizeof(T_ASC_Network));
@@ -251,6 +253,27 @@ ASC_initializeNetwork(T_ASC_NetworkRole role,
     return EC_Normal;
 }
 
+OFCondition
+ASC_initializeNetwork(T_ASC_NetworkRole role,
+                      int acceptorPort,
+                      int timeout,
+                      T_ASC_Network ** network,
+                      unsigned long options)
+{
+    return initializeNetwork(role, acceptorPort, timeout, network, NULL, options);
+}
+
+OFCondition
+ASC_initializeNetwork(T_ASC_NetworkRole role,
+                      int acceptorPort,
+                      int timeout,
+                      T_ASC_Network ** network,
+                      const T_ASC_SocketOptions& socketOptions,
+                      unsigned long options)
+{
+    return initializeNetwork(role, acceptorPort, timeout, network, &socketOptions, options);
+}
+
 OFCondition
 ASC_dropNetwork(T_ASC_Network ** network)
 {
@@ -323,6 +346,12 @@ ASC_createAssociationParameters(T_ASC_Parameters ** params,
     (*params)->theirMaxPDUReceiveSize = 0;      /* not yet negotiated */
     (*params)->modeCallback = NULL;
 
+    /* synchronous mode, i.e. no asynchronous operations window */
+    (*params)->DULparams.maximumOperationsInvoked = 1;
+    (*params)->DULparams.maximumOperationsPerformed = 1;
+    (*params)->DULparams.peerMaximumOperationsInvoked = 1;
+    (*params)->DULparams.peerMaximumOperationsPerformed = 1;
+
     /* set something unusable */
     ASC_setPresentationAddresses(*params,
                                  "calling Presentation Address",
@@ -461,6 +490,43 @@ ASC_getPresentationAddresses(T_ASC_Parameters * params,
     return EC_Normal;
 }
 
+OFCondition
+ASC_setAsyncOperationsWindow(T_ASC_Parameters * params,
+                             Uint16 maxOpsInvoked,
+                             Uint16 maxOpsPerformed)
+{
+    params->DULparams.maximumOperationsInvoked = maxOpsInvoked;
+    params->DULparams.maximumOperationsPerformed = maxOpsPerformed;
+
+    return EC_Normal;
+}
+
+OFCondition
+ASC_getAsyncOperationsWindow(T_ASC_Parameters * params,
+                             Uint16 * maxOpsInvoked,
+                             Uint16 * maxOpsPerformed)
+{
+    if (maxOpsInvoked)
+        *maxOpsInvoked = params->DULparams.maximumOperationsInvoked;
+    if (maxOpsPerformed)
+        *maxOpsPerformed = params->DULparams.maximumOperationsPerformed;
+
+    return EC_Normal;
+}
+
+OFCondition
+ASC_getPeerAsyncOperationsWindow(T_ASC_Parameters * params,
+                                 Uint16 * maxOpsInvoked,
+                                 Uint16 * maxOpsPerformed)
+{
+    if (maxOpsInvoked)
+        *maxOpsInvoked = params->DULparams.peerMaximumOperationsInvoked;
+    if (maxOpsPerformed)
+        *maxOpsPerformed = params->DULparams.peerMaximumOperationsPerformed;
+
+    return EC_Normal;
+}
+
 OFCondition
 ASC_getRejectParameters(T_ASC_Parameters * params,
                         T_ASC_RejectParameters * rejectParameters)
@@ -1514,7 +1580,13 @@ ASC_dumpParameters(OFString& str, T_ASC_Parameters * params, ASC_associateType d
         << "Our Max PDU Receive Size:    "
         << params->ourMaxPDUReceiveSize << OFendl
         << "Their Max PDU Receive Size:  "
-        << params->theirMaxPDUReceiveSize << OFendl;
+        << params->theirMaxPDUReceiveSize << OFendl
+        << "Our Async Operations Window: "
+        << params->DULparams.maximumOperationsInvoked << "/"
+        << params->DULparams.maximumOperationsPerformed << OFendl
+        << "Their Async Operations Window: "
+        << params->DULparams.peerMaximumOperationsInvoked << "/"
+        << params->DULparams.peerMaximumOperationsPerformed << OFendl;
 
     outstream << "Presentation Contexts:" << OFendl;
     for (i=0; i<ASC_countPresentationContexts(params); i++) {
@@ -1681,6 +1753,57 @@ ASC_associationWaiting(T_ASC_Network * network, int timeout)
     return nfound > 0;
 }
 
+/*
+ * Association metrics
+ */
+
+static void
+createAssociationMetrics(T_ASC_Association *assoc, OFBool requestor)
+{
+    /* metrics are only collected if enabled when the association is created */
+    if (!DcmNetworkMetrics::instance().isEnabled()) return;
+
+    DcmAssociationMetrics *metrics = new DcmAssociationMetrics();
+    const DUL_ASSOCIATESERVICEPARAMETERS& dulParams = assoc->params->DULparams;
+    metrics->requestor = requestor;
+    metrics->associations = 1;
+    metrics->startTime = OFTimer::getTime();
+    metrics->negotiationStartTime = metrics->startTime;
+    if (requestor)
+    {
+        metrics->ourAETitle = dulParams.callingAPTitle;
+        metrics->peerAETitle = dulParams.calledAPTitle;
+        metrics->peerAddress = dulParams.calledPresentationAddress;
+    } else {
+        metrics->ourAETitle = dulParams.calledAPTitle;
+        metrics->peerAETitle = dulParams.callingAPTitle;
+        metrics->peerAddress = dulParams.callingPresentationAddress;
+    }
+    assoc->metrics = metrics;
+}
+
+static void
+addNegotiationMetrics(T_ASC_Association *assoc)
+{
+    if (assoc->metrics != NULL)
+        assoc->metrics->negotiation.add(0, OFTimer::getDiff(assoc->metrics->negotiationStartTime));
+}
+
+static void
+updatePDUMetrics(T_ASC_Association *assoc)
+{
+    /* the counters of the DUL layer are lost when the association is dropped */
+    if ((assoc->metrics != NULL) && (assoc->DULassociation != NULL))
+    {
+        unsigned long pdusSent = 0;
+        unsigned long pdusReceived = 0;
+        DUL_getDataPDUStatistics(assoc->DULassociation, pdusSent, assoc->metrics->pduBytesSent,
+            pdusReceived, assoc->metrics->pduBytesReceived);
+        assoc->metrics->pdusSent = pdusSent;
+        assoc->metrics->pdusReceived = pdusReceived;
+    }
+}
+
 /*
  * Association creation and termination
  */
@@ -1698,6 +1821,14 @@ ASC_destroyAssociation(T_ASC_Association ** association)
         ASC_dropAssociation(*association);
     }
 
+    if ((*association)->metrics != NULL) {
+        DcmAssociationMetrics *metrics = (*association)->metrics;
+        metrics->lifetime.add(0, OFTimer::getDiff(metrics->startTime));
+        DcmNetworkMetrics::instance().addAssociation(*metrics);
+        delete metrics;
+        (*association)->metrics = NULL;
+    }
+
     if ((*association)->params != NULL) {
         cond = ASC_destroyAssociationParameters(&(*association)->params);
         if (cond.bad()) return cond;
@@ -1771,6 +1902,9 @@ ASC_receiveAssociation(T_ASC_Network * network,
 
     if (cond.bad()) return cond;
 
+    /* the negotiation starts with the receipt of the association request */
+    createAssociationMetrics(*assoc, OFFalse /* requestor */);
+
     /* mark the presentation contexts as being proposed */
     l = &params->DULparams.requestedPresentationContext;
     if (*l != NULL) {
@@ -1889,6 +2023,7 @@ ASC_requestAssociation(T_ASC_Network * network,
     (*assoc)->nextMsgID = 1;
     (*assoc)->sendPDVLength = 0;
     (*assoc)->sendPDVBuffer = NULL;
+    createAssociationMetrics(*assoc, OFTrue /* requestor */);
 
     params->DULparams.maxPDU = params->ourMaxPDUReceiveSize;
     OFStandard::strlcpy(params->DULparams.callingImplementationClassUID,
@@ -1900,7 +2035,7 @@ ASC_requestAssociation(T_ASC_Network * network,
                                   &(*assoc)->params->DULparams,
                                   &(*assoc)->DULassociation,
                                   retrieveRawPDU);
-
+    addNegotiationMetrics(*assoc);
 
     if (retrieveRawPDU && assoc && ((*assoc)->DULassociation))
     {
@@ -1997,6 +2132,7 @@ ASC_acknowledgeAssociation(
     OFCondition cond = DUL_AcknowledgeAssociationRQ(&assoc->DULassociation,
                                         &assoc->params->DULparams,
                                         retrieveRawPDU);
+    addNegotiationMetrics(assoc);
 
     if (retrieveRawPDU && (assoc->DULassociation))
     {
@@ -2069,6 +2205,7 @@ ASC_rejectAssociation(
         &association->DULassociation,
         &l_abort,
         retrieveRawPDU);
+    addNegotiationMetrics(association);
 
     if (retrieveRawPDU && (association->DULassociation))
     {
@@ -2098,12 +2235,12 @@ OFCondition ASC_acknowledgeRelease(T_ASC_Association *association)
 
 
 OFCondition
-ASC_abortAssociation(T_ASC_Association * association)
+ASC_abortAssociation(T_ASC_Association * association, OFBool waitForClose)
 {
     if (association == NULL) return ASC_NULLKEY;
     if (association->DULassociation == NULL) return ASC_NULLKEY;
 
-    OFCondition cond = DUL_AbortAssociation(&association->DULassociation);
+    OFCondition cond = DUL_AbortAssociation(&association->DULassociation, waitForClose);
     return cond;
 }
 
@@ -2117,6 +2254,7 @@ ASC_dropSCPAssociation(T_ASC_Association * association, int timeout)
     if (association->DULassociation == NULL) return EC_Normal;
 
     ASC_dataWaiting(association, timeout);
+    updatePDUMetrics(association);
     OFCondition cond = DUL_DropAssociation(&association->DULassociation);
 
     return cond;
@@ -2130,6 +2268,7 @@ ASC_dropAssociation(T_ASC_Association * association)
     if (association == NULL) return EC_Normal;
     if (association->DULassociation == NULL) return EC_Normal;
 
+    updatePDUMetrics(association);
     OFCondition cond = DUL_DropAssociation(&association->DULassociation);
     return cond;
 }
@@ -2156,6 +2295,36 @@ ASC_setTransportLayerType(
   return EC_Normal;
 }
 
+OFCondition
+ASC_setSocketOptions(
+    T_ASC_Parameters * params,
+    const T_ASC_SocketOptions& options)
+{
+  if (params == NULL) return ASC_NULLKEY;
+  params->DULparams.socketOptions = options;
+  return EC_Normal;
+}
+
+OFCondition
+ASC_setNetworkSocketOptions(
+    T_ASC_Network * network,
+    const T_ASC_SocketOptions& options)
+{
+  if (network == NULL) return ASC_NULLKEY;
+  return DUL_SetNetworkSocketOptions(network->network, &options);
+}
+
+OFCondition
+ASC_applySocketOptions(
+    T_ASC_Association * assoc,
+    const T_ASC_SocketOptions& options)
+{
+  if (assoc == NULL) return ASC_NULLKEY;
+  /* remember the options, so that they can be inspected later on */
+  if (assoc->params) assoc->params->DULparams.socketOptions = options;
+  return DUL_SetSocketOptions(assoc->DULassociation, &options);
+}
+
 OFCondition
 ASC_setTransportLayer(T_ASC_Network *network, DcmTransportLayer *newLayer, int takeoverOwnership)
 {
@@ -2163,6 +2332,13 @@ ASC_setTransportLayer(T_ASC_Network *network, DcmTransportLayer *newLayer, int t
   return DUL_setTransportLayer(network->network, newLayer, takeoverOwnership);
 }
 
+DcmAssociationMetrics *ASC_getAssociationMetrics(T_ASC_Association *assoc)
+{
+  if (assoc == NULL) return NULL;
+  updatePDUMetrics(assoc);
+  return assoc->metrics;
+}
+
 unsigned long ASC_getPeerCertificateLength(T_ASC_Association *assoc)
 {
   if (assoc==NULL) return 0;
@@ -92,6 +92,8 @@ makeOFConditionConst(NET_EC_StopAfterAssociation,            OFM_dcmnet, 1076, O
 makeOFConditionConst(NET_EC_StopAfterConnectionTimeout,      OFM_dcmnet, 1077, OF_ok, "Stop after TCP connection timeout (as requested)");
 makeOFConditionConst(NET_EC_InvalidSCPAssociationProfile,    OFM_dcmnet, 1078, OF_error, "Invalid or non-existing SCP Association Profile");
 makeOFConditionConst(NET_EC_AssociatePDUTooLarge,            OFM_dcmnet, 1079, OF_error, "A-ASSOCIATE PDU too large");
+makeOFConditionConst(NET_EC_CannotCreateEventPoller,         OFM_dcmnet, 1080, OF_error, "Cannot create event poller");
+// codes 1081 to 1083 are used for the socket options of the association negotiation profiles
 
 
 OFString& DimseCondition::dump(OFString& str, OFCondition cond)
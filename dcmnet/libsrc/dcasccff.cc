@@ -32,6 +32,7 @@
 #define L2_PRESENTATIONCONTEXTS        "PRESENTATIONCONTEXTS"
 #define L2_PROFILES                    "PROFILES"
 #define L2_SCPSCUROLESELECTION         "SCPSCUROLESELECTION"
+#define L2_SOCKETOPTIONS               "SOCKETOPTIONS"
 #define L2_TRANSFERSYNTAXES            "TRANSFERSYNTAXES"
 
 #define L0_EXTENDEDNEGOTIATION         "EXTENDEDNEGOTIATION"
@@ -40,6 +41,16 @@
 #define L0_PRESENTATIONCONTEXT_X       "PRESENTATIONCONTEXT"
 #define L0_ROLE_X                      "ROLE"
 #define L0_SCPSCUROLESELECTION         "SCPSCUROLESELECTION"
+#define L0_SOCKETOPTIONS               "SOCKETOPTIONS"
+#define L0_SENDBUFFERSIZE              "SENDBUFFERSIZE"
+#define L0_RECEIVEBUFFERSIZE           "RECEIVEBUFFERSIZE"
+#define L0_TCPNODELAY                  "TCPNODELAY"
+#define L0_TCPQUICKACK                 "TCPQUICKACK"
+#define L0_KEEPALIVE                   "KEEPALIVE"
+#define L0_KEEPALIVEIDLE               "KEEPALIVEIDLE"
+#define L0_KEEPALIVEINTERVAL           "KEEPALIVEINTERVAL"
+#define L0_KEEPALIVECOUNT              "KEEPALIVECOUNT"
+#define L0_BUSYPOLL                    "BUSYPOLL"
 #define L0_TRANSFERSYNTAX_X            "TRANSFERSYNTAX"
 
 
@@ -76,6 +87,10 @@ OFCondition DcmAssociationConfigurationFile::initialize(
   result = parseExtendedNegotiationItems(cfg, config);
   if (result.bad()) return result;
 
+  // parse socket options
+  result = parseSocketOptions(cfg, config);
+  if (result.bad()) return result;
+
   // parse profiles
   result = parseProfiles(cfg, config);
 
@@ -395,6 +410,90 @@ OFCondition DcmAssociationConfigurationFile::parseExtendedNegotiationItems(
 }
 
 
+// creates the error condition for an invalid socket option value
+static OFCondition makeSocketOptionError(const char *section, const char *entry, const char *value)
+{
+  OFString s("invalid value '");
+  s += value;
+  s += "' for entry ";
+  s += entry;
+  s += " in socket options section ";
+  s += section;
+  s += " in config file";
+  return makeOFCondition(OFM_dcmnet, 1083, OF_error, s.c_str());
+}
+
+// parses a non-negative integer socket option, absent entries are left unchanged
+static OFCondition parseIntegerSocketOption(OFConfigFile& config, const char *section, const char *entry, int& option)
+{
+  const char *value = config.get_entry(entry);
+  if (value)
+  {
+    long l = 0;
+    char c = 0;
+    if ((sscanf(value, "%ld%c", &l, &c) != 1) || (l < 0) || (l > 0x7fffffffL))
+      return makeSocketOptionError(section, entry, value);
+    option = OFstatic_cast(int, l);
+  }
+  return EC_Normal;
+}
+
+// parses a socket option that can be switched on or off, absent entries are left unchanged
+static OFCondition parseBooleanSocketOption(OFConfigFile& config, const char *section, const char *entry, DUL_SOCKETOPTIONSTATE& option)
+{
+  const char *value = config.get_entry(entry);
+  if (value)
+  {
+    OFString s;
+    while (*value)
+    {
+      if (! isspace(TO_UCHAR(*value))) s += (char) (toupper(TO_UCHAR(*value)));
+      ++value;
+    }
+    if ((s == "YES") || (s == "TRUE") || (s == "ON") || (s == "1"))
+      option = DUL_SOCKOPT_ENABLED;
+    else if ((s == "NO") || (s == "FALSE") || (s == "OFF") || (s == "0"))
+      option = DUL_SOCKOPT_DISABLED;
+    else if (s == "DEFAULT")
+      option = DUL_SOCKOPT_DEFAULT;
+    else
+      return makeSocketOptionError(section, entry, config.get_entry(entry));
+  }
+  return EC_Normal;
+}
+
+OFCondition DcmAssociationConfigurationFile::parseSocketOptions(
+  DcmAssociationConfiguration& cfg,
+  OFConfigFile& config)
+{
+  OFCondition result = EC_Normal;
+  config.set_section(2, L2_SOCKETOPTIONS);
+  if (! config.section_valid(2)) return result; // socket options are optional, may be absent
+
+  const char *key = NULL;
+  config.first_section(1);
+  while (config.section_valid(1))
+  {
+    key = config.get_keyword(1);
+    T_ASC_SocketOptions options = T_ASC_SocketOptions();
+    result = parseIntegerSocketOption(config, key, L0_SENDBUFFERSIZE, options.sendBufferSize);
+    if (result.good()) result = parseIntegerSocketOption(config, key, L0_RECEIVEBUFFERSIZE, options.receiveBufferSize);
+    if (result.good()) result = parseBooleanSocketOption(config, key, L0_TCPNODELAY, options.tcpNoDelay);
+    if (result.good()) result = parseBooleanSocketOption(config, key, L0_TCPQUICKACK, options.tcpQuickAck);
+    if (result.good()) result = parseBooleanSocketOption(config, key, L0_KEEPALIVE, options.keepAlive);
+    if (result.good()) result = parseIntegerSocketOption(config, key, L0_KEEPALIVEIDLE, options.keepAliveIdle);
+    if (result.good()) result = parseIntegerSocketOption(config, key, L0_KEEPALIVEINTERVAL, options.keepAliveInterval);
+    if (result.good()) result = parseIntegerSocketOption(config, key, L0_KEEPALIVECOUNT, options.keepAliveCount);
+    if (result.good()) result = parseIntegerSocketOption(config, key, L0_BUSYPOLL, options.busyPoll);
+    if (result.good()) result = cfg.addSocketOptions(key, options);
+    if (result.bad()) return result;
+    config.next_section(1);
+  }
+
+  return result;
+}
+
+
 OFCondition DcmAssociationConfigurationFile::parseProfiles(
   DcmAssociationConfiguration& cfg,
   OFConfigFile& config)
@@ -412,9 +511,11 @@ OFCondition DcmAssociationConfigurationFile::parseProfiles(
   const char *context = NULL;
   const char *role = NULL;
   const char *extneg = NULL;
+  const char *sockopt = NULL;
   OFString scontext;
   OFString srole;
   OFString sextneg;
+  OFString ssockopt;
   const char *c;
   OFCondition result = EC_Normal;
 
@@ -434,6 +535,7 @@ OFCondition DcmAssociationConfigurationFile::parseProfiles(
     }
     role = config.get_entry(L0_SCPSCUROLESELECTION);
     extneg = config.get_entry(L0_EXTENDEDNEGOTIATION);
+    sockopt = config.get_entry(L0_SOCKETOPTIONS);
 
     // do name mangling for presentation context key
     c = context;
@@ -471,7 +573,20 @@ OFCondition DcmAssociationConfigurationFile::parseProfiles(
       extneg = sextneg.c_str();
     }
 
-    result = cfg.addProfile(key, context, role, extneg);
+    // do name mangling for socket options key
+    if (sockopt)
+    {
+      c = sockopt;
+      ssockopt.clear();
+      while (*c)
+      {
+        if (! isspace(TO_UCHAR(*c))) ssockopt += (char) (toupper(TO_UCHAR(*c)));
+        ++c;
+      }
+      sockopt = ssockopt.c_str();
+    }
+
+    result = cfg.addProfile(key, context, role, extneg, sockopt);
     if (result.bad()) return result;
     config.next_section(1);
   }
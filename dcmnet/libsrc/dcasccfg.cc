@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2003-2017, OFFIS e.V.
+ *  Copyright (C) 2003-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -30,6 +30,7 @@ DcmAssociationConfiguration::DcmAssociationConfiguration()
 , roleselection_()
 , extneg_()
 , profiles_()
+, socketOptions_()
 , alwaysAcceptDefaultRole_(OFFalse)
 {
 }
@@ -44,8 +45,12 @@ DcmAssociationConfiguration::DcmAssociationConfiguration(const DcmAssociationCon
   contexts_(arg.contexts_),
   roleselection_(arg.roleselection_),
   extneg_(arg.extneg_),
-  profiles_(arg.profiles_)
+  profiles_(arg.profiles_),
+  socketOptions_(),
+  alwaysAcceptDefaultRole_(arg.alwaysAcceptDefaultRole_)
 {
+  // OFMap only provides an assignment operator but no copy constructor
+  socketOptions_ = arg.socketOptions_;
 }
 
 /// Copy assignment operator, performs deep copy
@@ -60,6 +65,8 @@ DcmAssociationConfiguration& DcmAssociationConfiguration::operator=(const DcmAss
     roleselection_ = arg.roleselection_;
     extneg_ = arg.extneg_;
     profiles_ = arg.profiles_;
+    socketOptions_ = arg.socketOptions_;
+    alwaysAcceptDefaultRole_ = arg.alwaysAcceptDefaultRole_;
   }
   return *this;
 }
@@ -71,6 +78,7 @@ void DcmAssociationConfiguration::clear()
   roleselection_.clear();
   extneg_.clear();
   profiles_.clear();
+  socketOptions_.clear();
   alwaysAcceptDefaultRole_ = OFFalse;
 }
 
@@ -122,11 +130,40 @@ OFCondition DcmAssociationConfiguration::addExtendedNegotiation(
   return extneg_.add(key, abstractSyntaxUID, rawData, length);
 }
 
+OFCondition DcmAssociationConfiguration::addSocketOptions(
+  const char *key,
+  const T_ASC_SocketOptions& options)
+{
+  if (!key) return EC_IllegalCall;
+
+  if (socketOptions_.find(OFString(key)) != socketOptions_.end())
+  {
+    // error: key already present
+    OFString s("two sets of socket options defined for key: ");
+    s += key;
+    return makeOFCondition(OFM_dcmnet, 1081, OF_error, s.c_str());
+  }
+  socketOptions_.insert(OFMake_pair(OFString(key), options));
+  return EC_Normal;
+}
+
+const T_ASC_SocketOptions *DcmAssociationConfiguration::getSocketOptions(const char *key) const
+{
+  if (key)
+  {
+    OFMap<OFString, T_ASC_SocketOptions>::const_iterator it = socketOptions_.find(OFString(key));
+    if (it != socketOptions_.end())
+      return &(*it).second;
+  }
+  return NULL;
+}
+
 OFCondition DcmAssociationConfiguration::addProfile(
   const char *key,
   const char *presentationContextKey,
   const char *roleSelectionKey,
-  const char *extendedNegotiationKey)
+  const char *extendedNegotiationKey,
+  const char *socketOptionsKey)
 {
   if ((!key)||(!presentationContextKey)) return EC_IllegalCall;
 
@@ -153,7 +190,15 @@ OFCondition DcmAssociationConfiguration::addProfile(
     if (status.bad()) return status;
   }
 
-  return profiles_.add(key, presentationContextKey, roleSelectionKey, extendedNegotiationKey);
+  if (socketOptionsKey && !getSocketOptions(socketOptionsKey))
+  {
+    // error: key undefined
+    OFString s("socket options key undefined: ");
+    s += socketOptionsKey;
+    return makeOFCondition(OFM_dcmnet, 1082, OF_error, s.c_str());
+  }
+
+  return profiles_.add(key, presentationContextKey, roleSelectionKey, extendedNegotiationKey, socketOptionsKey);
 }
 
 
@@ -382,6 +427,11 @@ OFCondition DcmAssociationConfiguration::setAssociationParameters(
     }
   }
 
+  // set socket options if present
+  const T_ASC_SocketOptions *options = getSocketOptions(profiles_.getSocketOptionsKey(profile));
+  if (options && result.good())
+    result = ASC_setSocketOptions(&params, *options);
+
   return result;
 }
 
@@ -594,6 +644,11 @@ OFCondition DcmAssociationConfiguration::evaluateAssociationParameters(
       else delete enlist;
   }
 
+  // apply socket options to the connection if present
+  const T_ASC_SocketOptions *options = getSocketOptions(profiles_.getSocketOptionsKey(profile));
+  if (options && result.good())
+    result = ASC_applySocketOptions(&assoc, *options);
+
   return result;
 }
 
@@ -740,6 +795,22 @@ void DcmAssociationConfiguration::dumpProfile(
   {
     out << "No role selection items configured" << OFendl;
   }
+  // dump socket options
+  const char* sockopt = profile->getSocketOptionsKey();
+  const T_ASC_SocketOptions* options = getSocketOptions(sockopt);
+  if ( options )
+  {
+    out << "Dumping socket options " << sockopt << OFendl;
+    out << "  Send buffer size: " << options->sendBufferSize << ", receive buffer size: " << options->receiveBufferSize << OFendl;
+    out << "  TCP_NODELAY: " << options->tcpNoDelay << ", TCP_QUICKACK: " << options->tcpQuickAck << " (0=default, 1=off, 2=on)" << OFendl;
+    out << "  Keepalive: " << options->keepAlive << ", idle: " << options->keepAliveIdle << " s, interval: " << options->keepAliveInterval
+        << " s, count: " << options->keepAliveCount << OFendl;
+    out << "  Busy poll: " << options->busyPoll << " us" << OFendl;
+  }
+  else
+  {
+    out << "No socket options configured" << OFendl;
+  }
   // print footer for this profile
   out << "-----------------------------------------------------------" << OFendl;
 }
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2003-2015, OFFIS e.V.
+ *  Copyright (C) 2003-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -29,10 +29,12 @@
 DcmProfileEntry::DcmProfileEntry(
     const OFString& presentationContextGroup,
     const OFString& roleSelectionGroup,
-    const OFString& extendedNegotiationGroup)
+    const OFString& extendedNegotiationGroup,
+    const OFString& socketOptionsGroup)
 : presentationContextGroup_(presentationContextGroup)
 , roleSelectionGroup_(roleSelectionGroup)
 , extendedNegotiationGroup_(extendedNegotiationGroup)
+, socketOptionsGroup_(socketOptionsGroup)
 {
 }
 
@@ -40,6 +42,7 @@ DcmProfileEntry::DcmProfileEntry(const DcmProfileEntry& arg)
 : presentationContextGroup_(arg.presentationContextGroup_)
 , roleSelectionGroup_(arg.roleSelectionGroup_)
 , extendedNegotiationGroup_(arg.extendedNegotiationGroup_)
+, socketOptionsGroup_(arg.socketOptionsGroup_)
 {
 }
 
@@ -50,6 +53,7 @@ DcmProfileEntry& DcmProfileEntry::operator=(const DcmProfileEntry& arg)
     presentationContextGroup_ = arg.presentationContextGroup_;
     roleSelectionGroup_ = arg.roleSelectionGroup_;
     extendedNegotiationGroup_ = arg.extendedNegotiationGroup_;
+    socketOptionsGroup_ = arg.socketOptionsGroup_;
   }
   return *this;
 }
@@ -73,6 +77,11 @@ const char *DcmProfileEntry::getExtendedNegotiationKey() const
   if (extendedNegotiationGroup_.size() == 0) return NULL; else return extendedNegotiationGroup_.c_str();
 }
 
+const char *DcmProfileEntry::getSocketOptionsKey() const
+{
+  if (socketOptionsGroup_.size() == 0) return NULL; else return socketOptionsGroup_.c_str();
+}
+
 /* ========================================================= */
 
 DcmProfileMap::DcmProfileMap()
@@ -150,7 +159,8 @@ OFCondition DcmProfileMap::add(
     const char *key,
     const char *presentationContextKey,
     const char *roleSelectionKey,
-    const char *extendedNegotiationKey)
+    const char *extendedNegotiationKey,
+    const char *socketOptionsKey)
 {
   if ((!key)||(!presentationContextKey)) return EC_IllegalCall;
 
@@ -159,13 +169,15 @@ OFCondition DcmProfileMap::add(
   if (roleSelectionKey) roleKey = roleSelectionKey;
   OFString extnegKey;
   if (extendedNegotiationKey) extnegKey = extendedNegotiationKey;
+  OFString sockoptKey;
+  if (socketOptionsKey) sockoptKey = socketOptionsKey;
 
   OFString skey(key);
   OFMap<OFString, DcmProfileEntry*>::iterator it = map_.find(skey);
 
   if (it == map_.end())
   {
-    DcmProfileEntry *newentry = new DcmProfileEntry(presKey, roleKey, extnegKey);
+    DcmProfileEntry *newentry = new DcmProfileEntry(presKey, roleKey, extnegKey, sockoptKey);
     map_.insert(OFPair<OFString, DcmProfileEntry*>(skey, newentry));
   }
   else
@@ -227,3 +239,18 @@ const char *DcmProfileMap::getExtendedNegotiationKey(const char *key) const
   }
   return NULL;
 }
+
+
+const char *DcmProfileMap::getSocketOptionsKey(const char *key) const
+{
+  if (key)
+  {
+    OFMap<OFString, DcmProfileEntry*>::const_iterator it = map_.find(OFString(key));
+    if (it != map_.end())
+    {
+      if ( (*it).second != NULL)
+        return (*it).second->getSocketOptionsKey();
+    }
+  }
+  return NULL;
+}
@@ -44,6 +44,9 @@ BEGIN_EXTERN_C
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 END_EXTERN_C
 
 #ifdef DCMTK_HAVE_POLL
@@ -60,6 +63,9 @@ enum
 #endif
 };
 
+/* maximum number of memory blocks passed to a single gathered write call */
+#define DCMNET_MAX_GATHERED_BLOCKS 16
+
 OFGlobal<Sint32> dcmSocketSendTimeout(60);
 OFGlobal<Sint32> dcmSocketReceiveTimeout(60);
 
@@ -305,6 +311,31 @@ OFBool DcmTransportConnection::selectReadableAssociation(DcmTransportConnection
   return safeSelectReadableAssociation(connections, connCount, timeout);
 }
 
+ssize_t DcmTransportConnection::writeGathered(const void * const *buffers, const size_t *lengths, size_t count)
+{
+  ssize_t total = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    size_t offset = 0;
+    while (offset < lengths[i])
+    {
+      const ssize_t nbytes = write(OFconst_cast(char *, OFstatic_cast(const char *, buffers[i])) + offset, lengths[i] - offset);
+      if (nbytes > 0)
+        offset += nbytes;
+      else if ((nbytes < 0) && (OFStandard::getLastNetworkErrorCode().value() == DCMNET_EINTR))
+        continue;
+      else
+      {
+        /* report the number of bytes written so far, if any */
+        total += offset;
+        return (total > 0) ? total : nbytes;
+      }
+    }
+    total += offset;
+  }
+  return total;
+}
+
 void DcmTransportConnection::dumpConnectionParameters(STD_NAMESPACE ostream& out)
 {
     OFString str;
@@ -356,6 +387,85 @@ ssize_t DcmTCPConnection::write(void *buf, size_t nbyte)
 #endif
 }
 
+ssize_t DcmTCPConnection::writeGathered(const void * const *buffers, const size_t *lengths, size_t count)
+{
+#if defined(HAVE_WINSOCK_H) || defined(HAVE_SYS_UIO_H)
+  ssize_t total = 0;
+  size_t index = 0;
+  size_t offset = 0;  /* number of bytes of buffers[index] already written */
+  while (OFTrue)
+  {
+    /* skip memory blocks that have been written completely */
+    while ((index < count) && (offset == lengths[index]))
+    {
+      ++index;
+      offset = 0;
+    }
+    if (index == count) break;
+
+    /* collect the remaining memory blocks (as many as possible) */
+#ifdef HAVE_WINSOCK_H
+    WSABUF vec[DCMNET_MAX_GATHERED_BLOCKS];
+#else
+    struct iovec vec[DCMNET_MAX_GATHERED_BLOCKS];
+#endif
+    size_t n = 0;
+    for (size_t i = index; (i < count) && (n < DCMNET_MAX_GATHERED_BLOCKS); ++i, ++n)
+    {
+      const size_t skip = (i == index) ? offset : 0;
+#ifdef HAVE_WINSOCK_H
+      vec[n].buf = OFconst_cast(char *, OFstatic_cast(const char *, buffers[i])) + skip;
+      vec[n].len = OFstatic_cast(ULONG, lengths[i] - skip);
+#else
+      vec[n].iov_base = OFconst_cast(char *, OFstatic_cast(const char *, buffers[i])) + skip;
+      vec[n].iov_len = lengths[i] - skip;
+#endif
+    }
+
+    /* send them with a single system call */
+    ssize_t nbytes;
+#ifdef HAVE_WINSOCK_H
+    DWORD sent = 0;
+    if (WSASend(getSocket(), vec, OFstatic_cast(DWORD, n), &sent, 0, NULL, NULL) == 0)
+      nbytes = OFstatic_cast(ssize_t, sent);
+    else
+      nbytes = -1;
+#else
+    nbytes = ::writev(getSocket(), vec, OFstatic_cast(int, n));
+#endif
+    if (nbytes <= 0)
+    {
+      if ((nbytes < 0) && (OFStandard::getLastNetworkErrorCode().value() == DCMNET_EINTR))
+        continue;
+      /* report the number of bytes written so far, if any */
+      return (total > 0) ? total : nbytes;
+    }
+    total += nbytes;
+
+    /* advance to the first byte not written yet */
+    size_t remaining = OFstatic_cast(size_t, nbytes);
+    while (remaining > 0)
+    {
+      const size_t left = lengths[index] - offset;
+      if (remaining >= left)
+      {
+        remaining -= left;
+        ++index;
+        offset = 0;
+      }
+      else
+      {
+        offset += remaining;
+        remaining = 0;
+      }
+    }
+  }
+  return total;
+#else
+  return DcmTransportConnection::writeGathered(buffers, lengths, count);
+#endif
+}
+
 void DcmTCPConnection::close()
 {
   closeTransportConnection();
@@ -110,6 +110,7 @@
 #include "dcmtk/dcmdata/dcdicent.h"    /* for class DcmDictEntry, needed for MSVC5 */
 #include "dcmtk/dcmdata/dcwcache.h"    /* for class DcmWriteCache */
 #include "dcmtk/dcmdata/dcvrui.h"      /* for class DcmUniqueIdentifier */
+#include "dcmtk/ofstd/oftimer.h"       /* for class OFTimer */
 
 
 /*
@@ -123,6 +124,7 @@
  *  layers, e. g. TLS, IP or below.
  */
 OFGlobal<Uint32> dcmMaxOutgoingPDUSize((Uint32) -1);
+OFGlobal<Uint32> dcmZeroCopyThreshold(4096);
 
 /*
  * Other global variables (should be used very, very rarely).
@@ -680,10 +682,11 @@ sendDcmDataset(
     offile_off_t rtnLength;
     Uint32 bytesTransmitted = 0;
     DUL_PDVLIST pdvList;
-    DUL_PDV pdv;
+    DUL_PDV pdv[2];
     /* the following variable is currently unused, leave it for future use */
     unsigned long pdvCount = 0;
     DcmWriteCache wcache;
+    const double startTime = OFTimer::getTime();
 
     /* initialize some local variables (we want to use the association's send buffer */
     /* to store data) this buffer can only take a certain number of elements */
@@ -702,6 +705,10 @@ sendDcmDataset(
     /* on the basis of the association's buffer, create a buffer variable that we can write to */
     DcmOutputBufferStream outBuf(buf, bufLen);
 
+    /* large element values are not copied to the buffer but sent directly (see below). */
+    /* This is safe since the buffer is always flushed before the dataset is accessed again. */
+    outBuf.setZeroCopyThreshold(dcmZeroCopyThreshold.get());
+
     /* prepare all elements in the DcmDataset variable for transfer */
     obj->transferInit();
 
@@ -748,23 +755,26 @@ sendDcmDataset(
 
         if (written) outBuf.flush(); // flush stream including embedded compression codec.
 
-        /* get buffer and its length, assign to local variable */
+        /* get buffer and its length, assign to local variable. An element value */
+        /* that has not been copied to the buffer follows the buffer's contents. */
         void *fullBuf = NULL;
-        outBuf.flushBuffer(fullBuf, rtnLength);
+        const void *valueBuf = NULL;
+        offile_off_t valueLength = 0;
+        outBuf.flushBuffer(fullBuf, rtnLength, valueBuf, valueLength);
 
         last = written && outBuf.isFlushed();
 
         /* if the buffer is not empty, do something with its contents */
-        if (rtnLength > 0)
+        if (rtnLength + valueLength > 0)
         {
             /* rtnLength could be odd */
-            if (rtnLength & 1)
+            if ((rtnLength + valueLength) & 1)
             {
               /* this should only happen if we use a stream compressed transfer
                * syntax and then only at the very end of the stream. Everything
                * else is a failure.
                */
-              if (!last)
+              if (!last || (valueLength > 0))
               {
                 return makeDcmnetCondition(DIMSEC_SENDFAILED, OF_error,
                   "DIMSE Failed to send message: odd block length encountered");
@@ -778,20 +788,35 @@ sendDcmDataset(
               cbuf[rtnLength++] = 0; // add zero pad byte
             }
 
-            /* initialize a DUL_PDV variable with the buffer's data */
-            pdv.fragmentLength = OFstatic_cast(unsigned long, rtnLength);
-            pdv.presentationContextID = presID;
-            pdv.pdvType = pdvType;
-            pdv.lastPDV = last;
-            pdv.data = fullBuf;
+            /* initialize a DUL_PDV variable with the buffer's data and another */
+            /* one with the element value, so both are sent without being copied */
+            pdvList.count = 0;
+            if (rtnLength > 0)
+            {
+                pdv[pdvList.count].fragmentLength = OFstatic_cast(unsigned long, rtnLength);
+                pdv[pdvList.count].data = fullBuf;
+                ++pdvList.count;
+            }
+            if (valueLength > 0)
+            {
+                pdv[pdvList.count].fragmentLength = OFstatic_cast(unsigned long, valueLength);
+                pdv[pdvList.count].data = OFconst_cast(void *, valueBuf);
+                ++pdvList.count;
+            }
+            for (unsigned long i = 0; i < pdvList.count; ++i)
+            {
+                pdv[i].presentationContextID = presID;
+                pdv[i].pdvType = pdvType;
+                /* only the very last fragment of the message is marked as last */
+                pdv[i].lastPDV = last && (i + 1 == pdvList.count);
+            }
 
-            /* append this PDV to a PDV list structure, set the counter variable */
-            /* to 1 since this structure contains only 1 element */
-            pdvList.count = 1;
-            pdvList.pdv = &pdv;
+            /* assign the PDVs to a PDV list structure */
+            pdvList.pdv = pdv;
 
             /* dump some information if required */
-            DCMNET_TRACE("DIMSE sendDcmDataset: sending " << pdv.fragmentLength << " bytes");
+            DCMNET_TRACE("DIMSE sendDcmDataset: sending " << (rtnLength + valueLength) << " bytes"
+                << ((valueLength > 0) ? " (zero copy)" : ""));
 
             /* send information over the network to the other DICOM application */
             dulCond = DUL_WritePDVs(&assoc->DULassociation, &pdvList);
@@ -799,7 +824,7 @@ sendDcmDataset(
                 return makeDcmnetSubCondition(DIMSEC_SENDFAILED, OF_error, "DIMSE Failed to send message", dulCond);
 
             /* count the bytes and the amount of PDVs which were transmitted */
-            bytesTransmitted += OFstatic_cast(Uint32, rtnLength);
+            bytesTransmitted += OFstatic_cast(Uint32, rtnLength + valueLength);
             pdvCount += pdvList.count;
 
             /* execute callback function to indicate progress */
@@ -812,6 +837,14 @@ sendDcmDataset(
     /* indicate the end of the transfer */
     obj->transferEnd();
 
+    /* update the metrics of the association (if collected) */
+    if (assoc->metrics)
+    {
+        DcmNetworkOperationMetrics& metrics = (pdvType == DUL_COMMANDPDV) ?
+            assoc->metrics->commandsSent : assoc->metrics->datasetsSent;
+        metrics.add(bytesTransmitted, OFTimer::getDiff(startTime));
+    }
+
     return EC_Normal;
 }
 
@@ -1078,6 +1111,7 @@ DIMSE_receiveCommand(
     E_TransferSyntax xferSyntax;
     DcmDataset *cmdSet;
     OFCondition econd = EC_Normal;
+    double startTime = 0;
 
     if (statusDetail) *statusDetail = NULL;
     if (commandSet) *commandSet = NULL;
@@ -1131,6 +1165,8 @@ DIMSE_receiveCommand(
         if (pdvCount == 0)
         {
             pid = pdv.presentationContextID;
+            /* the time waited for the first fragment does not count as receive time */
+            startTime = OFTimer::getTime();
         }
         else if (pdv.presentationContextID != pid)
         {
@@ -1190,6 +1226,10 @@ DIMSE_receiveCommand(
     /* indicate the end of the transfer */
     cmdSet->transferEnd();
 
+    /* update the metrics of the association (if collected) */
+    if (assoc->metrics && cond.good())
+        assoc->metrics->commandsReceived.add(bytesRead, OFTimer::getDiff(startTime));
+
     /* dump information if required */
     DCMNET_TRACE("DIMSE receiveCommand: " << pdvCount << " PDVs (" << bytesRead << " bytes), PresID=" << (int) pid);
 
@@ -1399,6 +1439,23 @@ DIMSE_receiveDataSetInFile(
         DcmOutputStream *filestream,
         DIMSE_ProgressCallback callback,
         void *callbackData)
+{
+    return DIMSE_receiveDataSetInFile(assoc, blocking, timeout, presID, filestream,
+        callback, callbackData, NULL /* headerAttributes */, DCM_UndefinedTagKey);
+}
+
+
+OFCondition
+DIMSE_receiveDataSetInFile(
+        T_ASC_Association *assoc,
+        T_DIMSE_BlockingMode blocking,
+        int timeout,
+        T_ASC_PresentationContextID *presID,
+        DcmOutputStream *filestream,
+        DIMSE_ProgressCallback callback,
+        void *callbackData,
+        DcmDataset *headerAttributes,
+        const DcmTagKey &stopParsingAtElement)
 {
     OFCondition cond = EC_Normal;
     DUL_PDV pdv;
@@ -1409,11 +1466,25 @@ DIMSE_receiveDataSetInFile(
     DIC_UL bytesRead = 0;
 
     if ((assoc == NULL) || (presID==NULL) || (filestream==NULL)) return DIMSE_NULLKEY;
+    const double startTime = OFTimer::getTime();
+
+    /* the attributes at the beginning of the data set are parsed from the same buffers that are written to file */
+    DcmInputBufferStream headerBuf;
+    OFBool parseHeader = (headerAttributes != NULL);
+    if (parseHeader)
+    {
+        /* reaching the stop element is expected, so do not report a warning */
+        headerAttributes->setQuietStopParsing(OFTrue);
+        headerAttributes->transferInit();
+    }
 
     *presID = 0;        /* invalid value */
     offile_off_t written = 0;
     while (!last)
     {
+        /* make the stream remember any bytes of the header that have not been parsed yet */
+        if (parseHeader) headerBuf.releaseBuffer();
+
         cond = DIMSE_readNextPDV(assoc, blocking, timeout, &pdv);
         if (cond != EC_Normal) last = OFTrue; // terminate loop
 
@@ -1471,6 +1542,24 @@ DIMSE_receiveDataSetInFile(
           }
         }
 
+        if (!last && parseHeader)
+        {
+          if (pdv.fragmentLength > 0) headerBuf.setBuffer(pdv.data, pdv.fragmentLength);
+          if (pdv.lastPDV) headerBuf.setEos();
+          OFCondition econd = headerAttributes->readUntilTag(headerBuf, xferSyntax, EGL_noChange, DCM_MaxReadLength, stopParsingAtElement);
+          if (econd != EC_StreamNotifyClient)
+          {
+            /* the header is complete (or cannot be parsed), the rest of the data set is only written to file */
+            if (econd.bad())
+            {
+              DCMNET_WARN(DIMSE_warn_str(assoc) << "DIMSE receiveDataSetInFile: cannot parse header attributes ("
+                  << econd.text() << ")");
+            }
+            headerAttributes->transferEnd();
+            parseHeader = OFFalse;
+          }
+        }
+
         if (!last)
         {
           bytesRead += pdv.fragmentLength;
@@ -1487,6 +1576,12 @@ DIMSE_receiveDataSetInFile(
         }
     }
 
+    if (parseHeader) headerAttributes->transferEnd();
+
+    /* update the metrics of the association (if collected) */
+    if (assoc->metrics && cond.good())
+        assoc->metrics->datasetsReceived.add(bytesRead, OFTimer::getDiff(startTime));
+
     /* set the Presentation Context ID we received */
     *presID = pid;
     return cond;
@@ -1546,6 +1641,7 @@ DIMSE_receiveDataSetInMemory(
 
     /* create a buffer variable which can be used to store the received information */
     DcmInputBufferStream dataBuf;
+    const double startTime = OFTimer::getTime();
 
     /* prepare the DcmDataset variable for transfer of data */
     dset->transferInit();
@@ -1679,6 +1775,10 @@ DIMSE_receiveDataSetInMemory(
         return cond;
     }
 
+    /* update the metrics of the association (if collected) */
+    if (assoc->metrics)
+        assoc->metrics->datasetsReceived.add(bytesRead, OFTimer::getDiff(startTime));
+
     /* if the global variable says so, we want to save the */
     /* DIMSE command's information to a file */
     if (g_dimse_save_dimse_data) saveDimseFragment(dset, OFFalse, OFTrue);
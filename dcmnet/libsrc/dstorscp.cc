@@ -24,15 +24,320 @@
 
 #include "dcmtk/dcmnet/dstorscp.h"
 #include "dcmtk/dcmnet/diutil.h"
+#include "dcmtk/dcmdata/dcpixel.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/ofstd/ofvector.h"
 #include "dcmtk/ofstd/ofstdinc.h"
 #include <ctime>
 
+BEGIN_EXTERN_C
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>       /* for open() */
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>      /* for close() */
+#endif
+#ifdef HAVE_IO_H
+#include <io.h>          /* for open() and close() on Win32 */
+#endif
+END_EXTERN_C
+
+/* maximum number of attempts to create a temporary file */
+#define MAX_TEMPFILE_ATTEMPTS 16
+
 
 // constant definitions
 
 const char *DcmStorageSCP::DEF_StandardSubdirectory  = "data";
 const char *DcmStorageSCP::DEF_UndefinedSubdirectory = "undef";
 const char *DcmStorageSCP::DEF_FilenameExtension     = "";
+const size_t DcmStorageSCP::DEF_TranscodingWorkers     = 2;
+const size_t DcmStorageSCP::DEF_TranscodingQueueLength = 16;
+
+
+// number of temporary files created by this process so far
+static unsigned long TempFileCounter = 0;
+
+#ifdef WITH_THREADS
+// mutex that guards the number of temporary files
+static OFMutex TempFileMutex;
+#endif
+
+
+// create a new (empty) temporary file in the given directory. The name is unique within
+// the process (process ID and counter), and the file is created exclusively,
+// so that an existing file (e.g. of another process) is never used.
+static OFCondition createTemporaryFile(const OFString &directory,
+                                       OFString &filename)
+{
+    for (size_t attempt = 0; attempt < MAX_TEMPFILE_ATTEMPTS; ++attempt)
+    {
+#ifdef WITH_THREADS
+        TempFileMutex.lock();
+#endif
+        const unsigned long counter = ++TempFileCounter;
+#ifdef WITH_THREADS
+        TempFileMutex.unlock();
+#endif
+        OFOStringStream stream;
+        stream << "tmp_" << STD_NAMESPACE hex << OFStandard::getProcessID() << '_' << counter << ".part" << OFStringStream_ends;
+        OFSTRINGSTREAM_GETSTR(stream, tmpString)
+        OFStandard::combineDirAndFilename(filename, directory, tmpString);
+        OFSTRINGSTREAM_FREESTR(tmpString);
+        // O_EXCL makes sure that the file did not exist yet
+        const int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd >= 0)
+        {
+            close(fd);
+            return EC_Normal;
+        }
+    }
+    filename.clear();
+    return EC_CouldNotGenerateFilename;
+}
+
+
+#ifdef WITH_THREADS
+
+// implementation of the internal class that queues the received datasets (which have
+// already been written to a temporary file) and transcodes them in separate worker threads
+
+class DcmStorageSCP::TranscodingQueue
+{
+
+    // forward declarations of the internal helper classes
+    struct Job;
+    class Worker;
+
+  public:
+
+    TranscodingQueue(DcmStorageSCP &scp,
+                     const size_t maxQueueLength)
+      : SCP(scp),
+        Workers(),
+        Jobs(),
+        Mutex(),
+        HandlerMutex(),
+        FreeSlots(OFstatic_cast(unsigned int, maxQueueLength)),
+        QueuedJobs(0),
+        Pending(0),
+        CurrentJob(NULL)
+    {
+    }
+
+    ~TranscodingQueue()
+    {
+        // tell each worker to exit after the remaining jobs have been processed
+        for (size_t i = 0; i < Workers.size(); ++i)
+            enqueue(NULL);
+        for (OFVector<Worker *>::iterator it = Workers.begin(); it != Workers.end(); ++it)
+        {
+            (*it)->join();
+            delete *it;
+        }
+    }
+
+    // start the given number of worker threads, returns the number actually started
+    size_t start(const size_t numWorkers)
+    {
+        for (size_t i = 0; i < numWorkers; ++i)
+        {
+            Worker *worker = new Worker(*this);
+            if (worker->start() == 0)
+                Workers.push_back(worker);
+            else
+            {
+                delete worker;
+                break;
+            }
+        }
+        return Workers.size();
+    }
+
+    // add a received dataset to the queue, waits while the queue is full
+    void push(const T_DIMSE_C_StoreRQ &reqMessage,
+              DcmFileFormat *fileformat,
+              const OFString &receivedFilename)
+    {
+        if (FreeSlots.trywait() != 0)
+        {
+            DCMNET_DEBUG("transcoding queue is full, waiting for a worker to transcode a dataset");
+            FreeSlots.wait();
+        }
+        Mutex.lock();
+        ++Pending;
+        Mutex.unlock();
+        enqueue(new Job(reqMessage, fileformat, receivedFilename));
+    }
+
+    // get the temporary file the given dataset has been written to when it was received,
+    // provided that the dataset is currently processed and has not been transcoded
+    OFBool getReceivedFile(const DcmFileFormat &fileformat,
+                           OFString &receivedFilename)
+    {
+        OFBool result = OFFalse;
+        Mutex.lock();
+        if ((CurrentJob != NULL) && (CurrentJob->FileFormat == &fileformat) &&
+            (CurrentJob->FileFormat->getDataset()->getCurrentXfer() == CurrentJob->ReceivedXfer))
+        {
+            receivedFilename = CurrentJob->ReceivedFilename;
+            result = OFTrue;
+        }
+        Mutex.unlock();
+        return result;
+    }
+
+    // wait until all queued datasets have been transcoded
+    void waitUntilEmpty()
+    {
+        Mutex.lock();
+        while (Pending > 0)
+        {
+            Mutex.unlock();
+            OFStandard::milliSleep(10);
+            Mutex.lock();
+        }
+        Mutex.unlock();
+    }
+
+    // add a job to the queue and wake up a worker (NULL tells the worker to exit)
+    void enqueue(Job *job)
+    {
+        Mutex.lock();
+        Jobs.push_back(job);
+        Mutex.unlock();
+        QueuedJobs.post();
+    }
+
+    // process jobs until an empty job is fetched (called by the worker threads)
+    void process()
+    {
+        while (OFTrue)
+        {
+            QueuedJobs.wait();
+            Mutex.lock();
+            Job *job = Jobs.front();
+            Jobs.pop_front();
+            Mutex.unlock();
+            if (job == NULL)
+                break;
+            // the conversion (e.g. compression) is done in parallel
+            SCP.transcodeDataset(*job->FileFormat->getDataset());
+            // but the handlers (which store the dataset) are never called concurrently
+            HandlerMutex.lock();
+            setCurrentJob(job);
+            const Uint16 statusCode = SCP.checkAndProcessSTORERequest(job->Request, *job->FileFormat);
+            setCurrentJob(NULL);
+            HandlerMutex.unlock();
+            // the temporary file still exists unless it has been renamed to the final file
+            if (OFStandard::fileExists(job->ReceivedFilename))
+            {
+                if (statusCode == STATUS_Success)
+                    OFStandard::deleteFile(job->ReceivedFilename);
+                else
+                    DCMNET_ERROR("cannot store received object, which is kept in file: " << job->ReceivedFilename);
+            }
+            delete job->FileFormat;
+            delete job;
+            FreeSlots.post();
+            Mutex.lock();
+            --Pending;
+            Mutex.unlock();
+        }
+    }
+
+  private:
+
+    // set the job whose dataset is currently stored
+    void setCurrentJob(Job *job)
+    {
+        Mutex.lock();
+        CurrentJob = job;
+        Mutex.unlock();
+    }
+
+    /// received dataset to be transcoded and stored
+    struct Job
+    {
+        Job(const T_DIMSE_C_StoreRQ &reqMessage,
+            DcmFileFormat *fileformat,
+            const OFString &receivedFilename)
+          : Request(reqMessage),
+            FileFormat(fileformat),
+            ReceivedFilename(receivedFilename),
+            ReceivedXfer(fileformat->getDataset()->getCurrentXfer())
+        {
+        }
+
+        /// C-STORE request message data structure of the dataset
+        T_DIMSE_C_StoreRQ Request;
+        /// received dataset
+        DcmFileFormat *FileFormat;
+        /// name of the temporary file the dataset has been written to when received
+        OFString ReceivedFilename;
+        /// transfer syntax of the temporary file
+        E_TransferSyntax ReceivedXfer;
+    };
+
+    /// worker thread processing the queued jobs
+    class Worker
+      : public OFThread
+    {
+
+      public:
+
+        Worker(TranscodingQueue &queue)
+          : Queue(queue)
+        {
+        }
+
+      protected:
+
+        virtual void run()
+        {
+            Queue.process();
+        }
+
+      private:
+
+        /// queue the jobs are fetched from
+        TranscodingQueue &Queue;
+    };
+
+    /// storage SCP the datasets are stored by
+    DcmStorageSCP &SCP;
+    /// worker threads
+    OFVector<Worker *> Workers;
+    /// jobs waiting to be processed
+    OFList<Job *> Jobs;
+    /// mutex protecting the job list, the number of pending jobs and the current job
+    OFMutex Mutex;
+    /// mutex serializing the calls of the handlers that store the datasets
+    OFMutex HandlerMutex;
+    /// number of free slots in the queue
+    OFSemaphore FreeSlots;
+    /// number of jobs in the queue (including the empty jobs)
+    OFSemaphore QueuedJobs;
+    /// number of datasets that have been queued but not yet transcoded
+    size_t Pending;
+    /// job whose dataset is currently stored (if any)
+    Job *CurrentJob;
+
+    // private undefined copy constructor
+    TranscodingQueue(const TranscodingQueue &);
+
+    // private undefined assignment operator
+    TranscodingQueue &operator=(const TranscodingQueue &);
+};
+
+#else // WITH_THREADS
+
+// without thread support, the datasets are always processed by the calling thread
+class DcmStorageSCP::TranscodingQueue
+{
+};
+
+#endif // WITH_THREADS
 
 
 // implementation of the main interface class
@@ -46,7 +351,12 @@ DcmStorageSCP::DcmStorageSCP()
     DirectoryGeneration(DGM_Default),
     FilenameGeneration(FGM_Default),
     FilenameCreator(),
-    DatasetStorage(DSM_Default)
+    DatasetStorage(DSM_Default),
+    ArchiveTransferSyntax(EXS_Unknown),
+    ArchiveRepresentationParameter(NULL),
+    TranscodingWorkers(DEF_TranscodingWorkers),
+    TranscodingQueueLength(DEF_TranscodingQueueLength),
+    Transcoding(NULL)
 {
     // make sure that the SCP at least supports C-ECHO with default transfer syntax
     OFList<OFString> transferSyntaxes;
@@ -72,6 +382,14 @@ void DcmStorageSCP::clear()
     DirectoryGeneration = DGM_Default;
     FilenameGeneration = FGM_Default;
     DatasetStorage = DSM_Default;
+    // stop the transcoding workers (after the queued datasets have been stored)
+    delete Transcoding;
+    Transcoding = NULL;
+    ArchiveTransferSyntax = EXS_Unknown;
+    delete ArchiveRepresentationParameter;
+    ArchiveRepresentationParameter = NULL;
+    TranscodingWorkers = DEF_TranscodingWorkers;
+    TranscodingQueueLength = DEF_TranscodingQueueLength;
 }
 
 
@@ -107,6 +425,24 @@ DcmStorageSCP::E_DatasetStorageMode DcmStorageSCP::getDatasetStorageMode() const
 }
 
 
+E_TransferSyntax DcmStorageSCP::getArchiveTransferSyntax() const
+{
+    return ArchiveTransferSyntax;
+}
+
+
+size_t DcmStorageSCP::getNumberOfTranscodingWorkers() const
+{
+    return TranscodingWorkers;
+}
+
+
+size_t DcmStorageSCP::getTranscodingQueueLength() const
+{
+    return TranscodingQueueLength;
+}
+
+
 // set methods
 
 OFCondition DcmStorageSCP::setOutputDirectory(const OFString &directory)
@@ -158,6 +494,29 @@ void DcmStorageSCP::setDatasetStorageMode(const E_DatasetStorageMode mode)
 }
 
 
+void DcmStorageSCP::setArchiveTransferSyntax(const E_TransferSyntax xfer,
+                                             const DcmRepresentationParameter *repParam)
+{
+    // the settings are used by the transcoding workers, so stop them first
+    delete Transcoding;
+    Transcoding = NULL;
+    ArchiveTransferSyntax = xfer;
+    delete ArchiveRepresentationParameter;
+    ArchiveRepresentationParameter = (repParam != NULL) ? repParam->clone() : NULL;
+}
+
+
+void DcmStorageSCP::setTranscodingWorkers(const size_t numWorkers,
+                                          const size_t maxQueueLength)
+{
+    // the new settings are used when the next dataset is queued
+    delete Transcoding;
+    Transcoding = NULL;
+    TranscodingWorkers = numWorkers;
+    TranscodingQueueLength = (maxQueueLength > 0) ? maxQueueLength : 1;
+}
+
+
 // further public methods
 
 OFCondition DcmStorageSCP::loadAssociationConfiguration(const OFString &filename,
@@ -172,6 +531,15 @@ OFCondition DcmStorageSCP::loadAssociationConfiguration(const OFString &filename
 }
 
 
+void DcmStorageSCP::waitForTranscoding()
+{
+#ifdef WITH_THREADS
+    if (Transcoding != NULL)
+        Transcoding->waitUntilEmpty();
+#endif
+}
+
+
 // protected methods
 
 OFCondition DcmStorageSCP::handleIncomingCommand(T_DIMSE_Message *incomingMsg,
@@ -195,24 +563,46 @@ OFCondition DcmStorageSCP::handleIncomingCommand(T_DIMSE_Message *incomingMsg,
             if (DatasetStorage == DGM_StoreBitPreserving)
             {
                 OFString filename;
-                // generate filename with full path (and create subdirectories if needed)
-                status = generateSTORERequestFilename(storeReq, filename);
-                if (status.good())
+                // the attributes in front of the pixel data are parsed while receiving,
+                // so there is no need to read the file again afterwards
+                DcmDataset headerAttributes;
+                if (DirectoryGeneration == DGM_SeriesDate)
                 {
-                    if (OFStandard::fileExists(filename))
-                        DCMNET_WARN("file already exists, overwriting: " << filename);
-                    // receive dataset directly to file
-                    status = receiveSTORERequest(storeReq, presInfo.presentationContextID, filename);
+                    // the directory name depends on the dataset, so receive it to a temporary
+                    // file in the output directory first and move it to its final place later
+                    OFString tempFilename;
+                    status = createTemporaryFile(OutputDirectory, tempFilename);
                     if (status.good())
                     {
-                        // call the notification handler (default implementation outputs to the logger)
-                        notifyInstanceStored(filename, storeReq.AffectedSOPClassUID, storeReq.AffectedSOPInstanceUID);
-                        rspStatusCode = STATUS_Success;
+                        status = receiveSTORERequest(storeReq, presInfo.presentationContextID, tempFilename, &headerAttributes);
+                        if (status.good())
+                            rspStatusCode = moveReceivedFile(storeReq, tempFilename, headerAttributes, filename);
+                        else
+                            OFStandard::deleteFile(tempFilename);
+                    } else
+                        DCMNET_ERROR("cannot create temporary file for object to be received in: " << OutputDirectory);
+                } else {
+                    // generate filename with full path (and create subdirectories if needed)
+                    status = generateSTORERequestFilename(storeReq, filename);
+                    if (status.good())
+                    {
+                        if (OFStandard::fileExists(filename))
+                            DCMNET_WARN("file already exists, overwriting: " << filename);
+                        // receive dataset directly to file
+                        status = receiveSTORERequest(storeReq, presInfo.presentationContextID, filename, &headerAttributes);
+                        if (status.good())
+                            rspStatusCode = STATUS_Success;
                     }
                 }
+                if (status.good() && (rspStatusCode == STATUS_Success))
+                {
+                    // call the notification handler (default implementation outputs to the logger)
+                    notifyInstanceStored(filename, storeReq.AffectedSOPClassUID, storeReq.AffectedSOPInstanceUID, &headerAttributes);
+                }
             } else {
-                DcmFileFormat fileformat;
-                DcmDataset *reqDataset = fileformat.getDataset();
+                // the dataset is kept beyond this method if it is queued for transcoding
+                DcmFileFormat *fileformat = new DcmFileFormat();
+                DcmDataset *reqDataset = fileformat->getDataset();
                 // receive dataset in memory
                 status = receiveSTORERequest(storeReq, presInfo.presentationContextID, reqDataset);
                 if (status.good())
@@ -223,11 +613,18 @@ OFCondition DcmStorageSCP::handleIncomingCommand(T_DIMSE_Message *incomingMsg,
                         // output debug message that dataset is not stored
                         DCMNET_DEBUG("received dataset is not stored since the storage mode is set to 'ignore'");
                         rspStatusCode = STATUS_Success;
+                    }
+                    else if (ArchiveTransferSyntax != EXS_Unknown)
+                    {
+                        // store and transcode the dataset (probably in a worker thread)
+                        rspStatusCode = transcodeAndStore(storeReq, fileformat);
+                        fileformat = NULL;
                     } else {
                         // check and process C-STORE request
-                        rspStatusCode = checkAndProcessSTORERequest(storeReq, fileformat);
+                        rspStatusCode = checkAndProcessSTORERequest(storeReq, *fileformat);
                     }
                 }
+                delete fileformat;
             }
             // send C-STORE response (with DIMSE status code)
             if (status.good())
@@ -257,12 +654,26 @@ Uint16 DcmStorageSCP::checkAndProcessSTORERequest(const T_DIMSE_C_StoreRQ &reqMe
                                                   DcmFileFormat &fileformat)
 {
     DCMNET_DEBUG("checking and processing C-STORE request");
+    OFString filename;
+    const Uint16 statusCode = storeReceivedDataset(reqMessage, fileformat, filename);
+    if (statusCode == STATUS_Success)
+    {
+        // call the notification handler (default implementation outputs to the logger)
+        notifyInstanceStored(filename, reqMessage.AffectedSOPClassUID, reqMessage.AffectedSOPInstanceUID, fileformat.getDataset());
+    }
+    return statusCode;
+}
+
+
+Uint16 DcmStorageSCP::storeReceivedDataset(const T_DIMSE_C_StoreRQ &reqMessage,
+                                           DcmFileFormat &fileformat,
+                                           OFString &filename)
+{
     Uint16 statusCode = STATUS_STORE_Error_CannotUnderstand;
     DcmDataset *dataset = fileformat.getDataset();
     // perform some basic checks on the request dataset
     if ((dataset != NULL) && !dataset->isEmpty())
     {
-        OFString filename;
         OFString directoryName;
         OFString sopClassUID = reqMessage.AffectedSOPClassUID;
         OFString sopInstanceUID = reqMessage.AffectedSOPInstanceUID;
@@ -277,19 +688,30 @@ Uint16 DcmStorageSCP::checkAndProcessSTORERequest(const T_DIMSE_C_StoreRQ &reqMe
             {
                 if (OFStandard::fileExists(filename))
                     DCMNET_WARN("file already exists, overwriting: " << filename);
-                // store the received dataset to file (with default settings)
-                status = fileformat.saveFile(filename);
-                if (status.good())
-                {
-                    // call the notification handler (default implementation outputs to the logger)
-                    notifyInstanceStored(filename, sopClassUID, sopInstanceUID, dataset);
+                OFBool renamed = OFFalse;
+#ifdef WITH_THREADS
+                // a dataset that has not been transcoded by a worker only needs to be moved from
+                // the temporary file written when it was received (which fails on some systems,
+                // e.g. Windows, if the file already exists, so it is written again in this case)
+                OFString receivedFilename;
+                if ((Transcoding != NULL) && Transcoding->getReceivedFile(fileformat, receivedFilename))
+                    renamed = OFStandard::renameFile(receivedFilename, filename);
+#endif
+                if (renamed)
                     statusCode = STATUS_Success;
-                } else {
-                    DCMNET_ERROR("cannot store received object: " << filename << ": " << status.text());
-                    statusCode = STATUS_STORE_Refused_OutOfResources;
+                else {
+                    // store the received dataset to file (with default settings), use the
+                    // current transfer syntax since the dataset might have been transcoded
+                    status = fileformat.saveFile(filename, dataset->getCurrentXfer());
+                    if (status.good())
+                        statusCode = STATUS_Success;
+                    else {
+                        DCMNET_ERROR("cannot store received object: " << filename << ": " << status.text());
+                        statusCode = STATUS_STORE_Refused_OutOfResources;
 
-                    // delete incomplete file
-                    OFStandard::deleteFile(filename);
+                        // delete incomplete file
+                        OFStandard::deleteFile(filename);
+                    }
                 }
             } else {
                 DCMNET_ERROR("cannot create directory for received object: " << directoryName << ": " << status.text());
@@ -323,6 +745,120 @@ OFCondition DcmStorageSCP::generateSTORERequestFilename(const T_DIMSE_C_StoreRQ
 }
 
 
+Uint16 DcmStorageSCP::moveReceivedFile(const T_DIMSE_C_StoreRQ &reqMessage,
+                                       const OFString &tempFilename,
+                                       DcmDataset &headerAttributes,
+                                       OFString &filename)
+{
+    Uint16 statusCode = STATUS_STORE_Refused_OutOfResources;
+    OFString directoryName;
+    OFString sopClassUID = reqMessage.AffectedSOPClassUID;
+    OFString sopInstanceUID = reqMessage.AffectedSOPInstanceUID;
+    // generate filename (with full path) from the attributes parsed while receiving
+    OFCondition status = generateDirAndFilename(filename, directoryName, sopClassUID, sopInstanceUID, &headerAttributes);
+    if (status.good())
+    {
+        DCMNET_DEBUG("generated filename for received object: " << filename);
+        // create the output directory (if needed)
+        status = OFStandard::createDirectory(directoryName, OutputDirectory /* rootDir */);
+        if (status.good())
+        {
+            if (OFStandard::fileExists(filename))
+            {
+                DCMNET_WARN("file already exists, overwriting: " << filename);
+                OFStandard::deleteFile(filename);
+            }
+            // the file is only renamed, i.e. the data is neither copied nor read again
+            if (OFStandard::renameFile(tempFilename, filename))
+                statusCode = STATUS_Success;
+            else
+                DCMNET_ERROR("cannot move received object to file: " << filename);
+        } else
+            DCMNET_ERROR("cannot create directory for received object: " << directoryName << ": " << status.text());
+    } else
+        DCMNET_ERROR("cannot generate directory or file name for received object: " << status.text());
+    // delete the temporary file in case of error
+    if (statusCode != STATUS_Success)
+        OFStandard::deleteFile(tempFilename);
+    return statusCode;
+}
+
+
+OFCondition DcmStorageSCP::transcodeDataset(DcmDataset &dataset)
+{
+    OFCondition status = EC_Normal;
+    const E_TransferSyntax currentXfer = dataset.getCurrentXfer();
+    if ((ArchiveTransferSyntax != EXS_Unknown) && (currentXfer != ArchiveTransferSyntax))
+    {
+        const DcmXfer archiveXfer(ArchiveTransferSyntax);
+        DCMNET_DEBUG("transcoding received dataset to " << archiveXfer.getXferName());
+        status = dataset.chooseRepresentation(ArchiveTransferSyntax, ArchiveRepresentationParameter);
+        if (status.good() && !dataset.canWriteXfer(ArchiveTransferSyntax, currentXfer))
+            status = EC_CannotChangeRepresentation;
+        if (status.bad())
+        {
+            DCMNET_WARN("cannot transcode received dataset to " << archiveXfer.getXferName()
+                << ", storing it with the network transfer syntax: " << status.text());
+            // make sure that the dataset is stored with the original representation
+            dataset.chooseRepresentation(currentXfer, NULL);
+        }
+    }
+    return status;
+}
+
+
+Uint16 DcmStorageSCP::transcodeAndStore(const T_DIMSE_C_StoreRQ &reqMessage,
+                                        DcmFileFormat *fileformat)
+{
+#ifdef WITH_THREADS
+    if ((Transcoding == NULL) && (TranscodingWorkers > 0))
+    {
+        // start the workers on first use
+        Transcoding = new TranscodingQueue(*this, TranscodingQueueLength);
+        if (Transcoding->start(TranscodingWorkers) == 0)
+        {
+            DCMNET_WARN("cannot start transcoding workers, transcoding received datasets synchronously");
+            delete Transcoding;
+            Transcoding = NULL;
+            TranscodingWorkers = 0;
+        }
+    }
+    if (Transcoding != NULL)
+    {
+        Uint16 statusCode = STATUS_STORE_Error_CannotUnderstand;
+        DcmDataset *dataset = fileformat->getDataset();
+        if (!dataset->isEmpty())
+        {
+            // write the dataset as received to a temporary file before the response is sent,
+            // so that it is never lost, the final file is written by a worker
+            OFString tempFilename;
+            OFCondition status = createTemporaryFile(OutputDirectory, tempFilename);
+            if (status.good())
+                status = fileformat->saveFile(tempFilename, dataset->getCurrentXfer());
+            if (status.good())
+            {
+                // the queue takes over the ownership and waits if it is full
+                Transcoding->push(reqMessage, fileformat, tempFilename);
+                return STATUS_Success;
+            }
+            DCMNET_ERROR("cannot store received object to temporary file in: " << OutputDirectory << ": " << status.text());
+            statusCode = STATUS_STORE_Refused_OutOfResources;
+            // delete incomplete file
+            if (!tempFilename.empty())
+                OFStandard::deleteFile(tempFilename);
+        }
+        delete fileformat;
+        return statusCode;
+    }
+#endif
+    // no workers, so transcode and store the dataset in this thread
+    transcodeDataset(*fileformat->getDataset());
+    const Uint16 statusCode = checkAndProcessSTORERequest(reqMessage, *fileformat);
+    delete fileformat;
+    return statusCode;
+}
+
+
 void DcmStorageSCP::notifyInstanceStored(const OFString &filename,
                                          const OFString & /*sopClassUID*/,
                                          const OFString & /*sopInstanceUID*/,
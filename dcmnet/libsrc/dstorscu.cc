@@ -23,6 +23,8 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 
 #include "dcmtk/ofstd/ofdatime.h"
+#include "dcmtk/ofstd/ofthpool.h"
+#include "dcmtk/ofstd/ofvector.h"
 #include "dcmtk/dcmdata/dccodec.h"
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmdata/dcdatutl.h"
@@ -36,6 +38,11 @@
 #define STATUS_STORE_Pending_NoPresentationContext 0xffff
 #define STATUS_STORE_Pending_InvalidDatasetPointer 0xfffe
 
+// maximum number of outstanding C-STORE requests in asynchronous mode. The responses
+// are only read when this limit is reached, so they must fit into the socket buffers;
+// otherwise, the peer might block on sending a response and stop reading our requests.
+#define MAX_OUTSTANDING_STORE_REQUESTS 64
+
 
 // helper functions
 
@@ -61,6 +68,298 @@ static const OFString &dicomToHostFilename(const OFString &dicomFilename,
 }
 
 
+// implementation of the internal class that loads a DICOM file (and converts it to the
+// network transfer syntax) in a separate thread while the previous SOP instance is sent
+
+class DcmStorageSCU::FileLoader
+  : public OFThread
+{
+
+  public:
+
+    FileLoader(const TransferEntry *entry,
+               const OFFilename &filename,
+               const E_FileReadMode readMode,
+               const E_TransferSyntax networkXfer)
+      : Entry(entry),
+        FileFormat(),
+        Status(EC_Normal),
+        Filename(filename),
+        ReadMode(readMode),
+        NetworkXfer(networkXfer)
+    {
+    }
+
+    /// transfer entry the file belongs to (only used for identification)
+    const TransferEntry *Entry;
+    /// DICOM file loaded
+    DcmFileFormat FileFormat;
+    /// status of loading the file
+    OFCondition Status;
+
+  protected:
+
+    virtual void run()
+    {
+        Status = FileFormat.loadFile(Filename, EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ReadMode);
+        if (Status.good() && (NetworkXfer != EXS_Unknown) && (FileFormat.getDataset()->getOriginalXfer() != NetworkXfer))
+        {
+            // errors are not reported here since the conversion is tried again when the
+            // SOP instance is sent, but an existing representation is then reused
+            FileFormat.getDataset()->chooseRepresentation(NetworkXfer, NULL);
+        }
+    }
+
+  private:
+
+    /// name of the DICOM file
+    const OFFilename Filename;
+    /// read mode passed to loadFile()
+    const E_FileReadMode ReadMode;
+    /// transfer syntax of the presentation context, EXS_Unknown if no conversion
+    const E_TransferSyntax NetworkXfer;
+};
+
+
+// implementation of the internal classes that send SOP instances over parallel associations
+
+class DcmStorageSCU::SendTask
+  : public OFThreadPool::Task
+{
+
+  public:
+
+    SendTask(DcmStorageSCU &scu)
+      : SCU(scu),
+        Workers(),
+        Status(EC_Normal),
+        Mutex(),
+        StopRequested(OFFalse)
+    {
+    }
+
+    virtual ~SendTask();
+
+    // send the SOP instances of one worker (i.e. one work item)
+    virtual OFBool execute(const size_t index,
+                           const size_t thread);
+
+    // forward the notification to the main SCU (serialized)
+    void notifySOPInstanceToBeSent(const TransferEntry &transferEntry)
+    {
+        Mutex.lock();
+        SCU.notifySOPInstanceToBeSent(transferEntry);
+        Mutex.unlock();
+    }
+
+    // forward the notification to the main SCU (serialized)
+    void notifySOPInstanceSent(const TransferEntry &transferEntry)
+    {
+        Mutex.lock();
+        SCU.notifySOPInstanceSent(transferEntry);
+        Mutex.unlock();
+    }
+
+    // ask the main SCU whether to stop, which then applies to all workers
+    OFBool shouldStopAfterCurrentSOPInstance()
+    {
+        Mutex.lock();
+        if (!StopRequested)
+            StopRequested = SCU.shouldStopAfterCurrentSOPInstance();
+        const OFBool result = StopRequested;
+        Mutex.unlock();
+        return result;
+    }
+
+    // check whether the sending process has been stopped
+    OFBool isStopRequested()
+    {
+        Mutex.lock();
+        const OFBool result = StopRequested;
+        Mutex.unlock();
+        return result;
+    }
+
+    // get the number of the next association (counted by the main SCU)
+    unsigned long getNextAssociationNumber()
+    {
+        Mutex.lock();
+        const unsigned long result = ++SCU.AssociationCounter;
+        Mutex.unlock();
+        return result;
+    }
+
+    /// main SCU, the transfer list of which is sent
+    DcmStorageSCU &SCU;
+    /// workers, each sending a part of the transfer list
+    OFVector<WorkerSCU *> Workers;
+    /// first error that occurred on any of the associations
+    OFCondition Status;
+
+  private:
+
+    /// mutex serializing the access to the main SCU
+    OFMutex Mutex;
+    /// flag indicating whether the sending process should be stopped
+    OFBool StopRequested;
+
+    // private undefined copy constructor
+    SendTask(const SendTask &);
+
+    // private undefined assignment operator
+    SendTask &operator=(const SendTask &);
+};
+
+
+class DcmStorageSCU::WorkerSCU
+  : public DcmStorageSCU
+{
+
+  public:
+
+    WorkerSCU(SendTask &task)
+      : DcmStorageSCU(),
+        Task(task)
+    {
+        // use the same parameters as the main SCU
+        const DcmStorageSCU &scu = task.SCU;
+        setPeerHostName(scu.getPeerHostName());
+        setPeerPort(scu.getPeerPort());
+        setPeerAETitle(scu.getPeerAETitle());
+        setAETitle(scu.getAETitle());
+        setMaxReceivePDULength(scu.getMaxReceivePDULength());
+        setACSETimeout(scu.getACSETimeout());
+        setDIMSETimeout(scu.getDIMSETimeout());
+        setDIMSEBlockingMode(scu.getDIMSEBlockingMode());
+        setConnectionTimeout(scu.getConnectionTimeout());
+        setMaxOperationsInvoked(scu.getMaxOperationsInvoked());
+        setVerbosePCMode(scu.getVerbosePCMode());
+        setDatasetConversionMode(scu.getDatasetConversionMode());
+        setProgressNotificationMode(scu.getProgressNotificationMode());
+        DecompressionMode = scu.DecompressionMode;
+        HaltOnUnsuccessfulStoreMode = scu.HaltOnUnsuccessfulStoreMode;
+        AllowIllegalProposalMode = scu.AllowIllegalProposalMode;
+        MoveOriginatorAETitle = scu.MoveOriginatorAETitle;
+        MoveOriginatorMsgID = scu.MoveOriginatorMsgID;
+        PrefetchMode = OFTrue;
+    }
+
+    virtual ~WorkerSCU()
+    {
+        // the transfer entries are owned by the main SCU
+        TransferList.clear();
+        CurrentTransferEntry = TransferList.begin();
+    }
+
+    void addTransferEntry(TransferEntry *transferEntry)
+    {
+        TransferList.push_back(transferEntry);
+        CurrentTransferEntry = TransferList.begin();
+    }
+
+    unsigned long getPresentationContextCounter() const
+    {
+        return PresentationContextCounter;
+    }
+
+    // send all SOP instances of this worker (using as many associations as needed)
+    OFCondition sendAllSOPInstances();
+
+    virtual OFCondition negotiateAssociation()
+    {
+        // number the associations of all workers consecutively (the counter is increased
+        // by the base class)
+        AssociationCounter = Task.getNextAssociationNumber() - 1;
+        return DcmStorageSCU::negotiateAssociation();
+    }
+
+  protected:
+
+    virtual void notifySOPInstanceToBeSent(const TransferEntry &transferEntry)
+    {
+        Task.notifySOPInstanceToBeSent(transferEntry);
+    }
+
+    virtual void notifySOPInstanceSent(const TransferEntry &transferEntry)
+    {
+        Task.notifySOPInstanceSent(transferEntry);
+    }
+
+    virtual OFBool shouldStopAfterCurrentSOPInstance()
+    {
+        return Task.shouldStopAfterCurrentSOPInstance();
+    }
+
+  private:
+
+    /// task this worker belongs to
+    SendTask &Task;
+
+    // private undefined copy constructor
+    WorkerSCU(const WorkerSCU &);
+
+    // private undefined assignment operator
+    WorkerSCU &operator=(const WorkerSCU &);
+};
+
+
+DcmStorageSCU::SendTask::~SendTask()
+{
+    for (size_t i = 0; i < Workers.size(); ++i)
+        delete Workers[i];
+}
+
+
+OFBool DcmStorageSCU::SendTask::execute(const size_t index,
+                                        const size_t /* thread */)
+{
+    const OFCondition status = Workers[index]->sendAllSOPInstances();
+    if (status.bad())
+    {
+        Mutex.lock();
+        // only the first error is reported to the caller
+        if (Status.good())
+            Status = status;
+        Mutex.unlock();
+    }
+    return status.good();
+}
+
+
+OFCondition DcmStorageSCU::WorkerSCU::sendAllSOPInstances()
+{
+    OFCondition status;
+    // add presentation contexts to be negotiated (as long as there are any)
+    while (!Task.isStopRequested() && (status = addPresentationContexts()).good())
+    {
+        status = initNetwork();
+        if (status.good())
+            status = negotiateAssociation();
+        if (status.good())
+        {
+            status = sendSOPInstances();
+            if (status.good())
+                releaseAssociation();
+            else if (status == DUL_PEERREQUESTEDRELEASE)
+                closeAssociation(DCMSCU_PEER_REQUESTED_RELEASE);
+            else if (status == DUL_PEERABORTEDASSOCIATION)
+                closeAssociation(DCMSCU_PEER_ABORTED_ASSOCIATION);
+            else
+                abortAssociation();
+        }
+        // continue with a new association for the remaining SOP instances (if any)
+        else if (status == NET_EC_NoAcceptablePresentationContexts)
+            status = EC_Normal;
+        if (status.bad())
+            break;
+    }
+    // all SOP instances have been processed
+    if (status == NET_EC_NoPresentationContextsDefined)
+        status = EC_Normal;
+    return status;
+}
+
+
 // implementation of the internal class/struct for a single transfer entry
 
 DcmStorageSCU::TransferEntry::TransferEntry(const OFFilename &filename,
@@ -148,7 +447,8 @@ DcmStorageSCU::DcmStorageSCU()
     MoveOriginatorAETitle(),
     MoveOriginatorMsgID(0),
     TransferList(),
-    CurrentTransferEntry()
+    CurrentTransferEntry(),
+    PrefetchMode(OFFalse)
 {
     CurrentTransferEntry = TransferList.begin();
 }
@@ -794,6 +1094,20 @@ OFCondition DcmStorageSCU::sendSOPInstances()
     if (!TransferList.empty())
     {
         DcmDataset *dataset = NULL;
+        // determine whether C-STORE requests can be sent asynchronously on this association
+        Uint16 maxOperations = getNegotiatedMaxOperationsInvoked();
+        const OFBool asyncMode = (maxOperations != 1);
+        if (asyncMode)
+        {
+            // an unlimited (or very large) window is limited in order to avoid a deadlock
+            if ((maxOperations == 0) || (maxOperations > MAX_OUTSTANDING_STORE_REQUESTS))
+                maxOperations = MAX_OUTSTANDING_STORE_REQUESTS;
+            DCMNET_DEBUG("sending C-STORE requests asynchronously (up to " << maxOperations << " outstanding requests)");
+        }
+        // transfer entries of the outstanding requests (asynchronous mode only)
+        OFMap<Uint16, TransferEntry *> outstandingEntries;
+        // DICOM file loaded in the background (prefetch mode only)
+        FileLoader *nextFile = NULL;
         // iterate over the list of SOP instance to be transferred
         // (continue with next SOP instance if there already was a transmission)
         OFListConstIterator(TransferEntry *) lastEntry = TransferList.end();
@@ -803,6 +1117,9 @@ OFCondition DcmStorageSCU::sendSOPInstances()
             if (!(*CurrentTransferEntry)->RequestSent)
             {
                 DcmFileFormat fileformat;
+                DcmFileFormat *loadedFile = &fileformat;
+                FileLoader *currentFile = NULL;
+                OFBool responsePending = OFFalse;
                 // check whether SOP instance can be sent on this association
                 // (i.e. whether it has been negotiated for this association)
                 if ((*CurrentTransferEntry)->PresentationContextID == 0)
@@ -829,14 +1146,30 @@ OFCondition DcmStorageSCU::sendSOPInstances()
                     }
                 } else {
                     DCMNET_DEBUG("sending SOP instance from file: " << (*CurrentTransferEntry)->Filename);
-                    // load SOP instance from DICOM file
-                    status = fileformat.loadFile((*CurrentTransferEntry)->Filename, EXS_Unknown, EGL_noChange,
-                        DCM_MaxReadLength, (*CurrentTransferEntry)->FileReadMode);
+                    // check whether the DICOM file has been loaded while the previous SOP instance was sent
+                    if (nextFile != NULL)
+                    {
+                        nextFile->join();
+                        if (nextFile->Entry == *CurrentTransferEntry)
+                            currentFile = nextFile;
+                        else
+                            delete nextFile;
+                        nextFile = NULL;
+                    }
+                    if (currentFile != NULL)
+                    {
+                        status = currentFile->Status;
+                        loadedFile = &currentFile->FileFormat;
+                    } else {
+                        // load SOP instance from DICOM file
+                        status = fileformat.loadFile((*CurrentTransferEntry)->Filename, EXS_Unknown, EGL_noChange,
+                            DCM_MaxReadLength, (*CurrentTransferEntry)->FileReadMode);
+                    }
                     if (status.good())
                     {
                         // do not store the dataset pointer in the transfer entry, because this pointer
                         // will become invalid for the next iteration of this while-loop.
-                        dataset = fileformat.getDataset();
+                        dataset = loadedFile->getDataset();
                     } else {
                         DCMNET_ERROR("cannot send SOP instance from file: " << (*CurrentTransferEntry)->Filename
                             << ": " << status.text());
@@ -867,14 +1200,30 @@ OFCondition DcmStorageSCU::sendSOPInstances()
                             }
                         }
                     }
+                    // load the DICOM file of the next SOP instance while the current one is sent
+                    if (PrefetchMode)
+                        nextFile = prefetchNextFile(CurrentTransferEntry);
                     // determine size of the dataset (in bytes) based on the original transfer syntax
                     (*CurrentTransferEntry)->DatasetSize = dataset->calcElementLength(dataset->getOriginalXfer(), g_dimse_send_sequenceType_encoding);
                     // notify user of this class that the current SOP instance is to be sent
                     notifySOPInstanceToBeSent(**CurrentTransferEntry);
                     // call the inherited method from the base class doing the real work
-                    status = sendSTORERequest((*CurrentTransferEntry)->PresentationContextID, "" /* filename */,
-                        dataset, (*CurrentTransferEntry)->ResponseStatusCode,
-                        MoveOriginatorAETitle, MoveOriginatorMsgID);
+                    if (asyncMode)
+                    {
+                        Uint16 messageID = 0;
+                        status = sendSTORERequestAsync((*CurrentTransferEntry)->PresentationContextID, "" /* filename */,
+                            dataset, messageID, MoveOriginatorAETitle, MoveOriginatorMsgID);
+                        if (status.good())
+                        {
+                            // the response is received later (see below)
+                            outstandingEntries[messageID] = *CurrentTransferEntry;
+                            responsePending = OFTrue;
+                        }
+                    } else {
+                        status = sendSTORERequest((*CurrentTransferEntry)->PresentationContextID, "" /* filename */,
+                            dataset, (*CurrentTransferEntry)->ResponseStatusCode,
+                            MoveOriginatorAETitle, MoveOriginatorMsgID);
+                    }
                     // store some further information (even in case of error)
                     (*CurrentTransferEntry)->AssociationNumber = AssociationCounter;
                     (*CurrentTransferEntry)->NetworkTransferSyntax = dataset->getCurrentXfer();
@@ -882,23 +1231,12 @@ OFCondition DcmStorageSCU::sendSOPInstances()
                 // if it was successful (i.e. even if DIMSE status is not 0x0000 = success) ...
                 if (status.good())
                 {
-                    // ... remember that this SOP instance has already been sent
-                    (*CurrentTransferEntry)->RequestSent = OFTrue;
-                    // check whether we need to compact or delete the dataset
-                    if ((*CurrentTransferEntry)->Filename.isEmpty() && ((*CurrentTransferEntry)->Dataset != NULL))
+                    if (!responsePending)
                     {
-                        if ((*CurrentTransferEntry)->DatasetHandlingMode == HM_compactAfterSend)
-                        {
-                            DCMNET_DEBUG("compacting dataset after successful send");
-                            (*CurrentTransferEntry)->Dataset->compactElements(256 /* maxLength */);
-                        }
-                        else if ((*CurrentTransferEntry)->DatasetHandlingMode == HM_deleteAfterSend)
-                        {
-                            DCMNET_DEBUG("deleting dataset after successful send");
-                            delete (*CurrentTransferEntry)->Dataset;
-                            // forget about this dataset (e.g. in order to avoid double deletion)
-                            (*CurrentTransferEntry)->Dataset = NULL;
-                        }
+                        // ... remember that this SOP instance has already been sent
+                        (*CurrentTransferEntry)->RequestSent = OFTrue;
+                        // check whether we need to compact or delete the dataset
+                        handleDatasetAfterSend(**CurrentTransferEntry);
                     }
                 } else {
                     // if the SOP instance could not be sent because no acceptable presentation context was found
@@ -914,13 +1252,41 @@ OFCondition DcmStorageSCU::sendSOPInstances()
                         status = EC_Normal;
                 }
                 // notify user of this class that the current SOP instance has been processed
-                notifySOPInstanceSent(**CurrentTransferEntry);
+                // (in asynchronous mode, this is done when the response has been received)
+                if (!responsePending)
+                    notifySOPInstanceSent(**CurrentTransferEntry);
+                delete currentFile;
+                // receive responses as long as the window is full
+                if (status.good() && asyncMode && (outstandingEntries.size() >= maxOperations))
+                    status = receiveSTOREResponses(outstandingEntries, maxOperations - 1);
             }
             ++CurrentTransferEntry;
             // check whether the sending process should be stopped
             if (shouldStopAfterCurrentSOPInstance())
                 break;
         }
+        // the DICOM file loaded in the background is not needed (anymore)
+        if (nextFile != NULL)
+        {
+            nextFile->join();
+            delete nextFile;
+        }
+        // receive the responses to all outstanding requests
+        if (!outstandingEntries.empty())
+        {
+            OFCondition result = EC_Normal;
+            if (status.good() || (status != DIMSE_ILLEGALASSOCIATION))
+                result = receiveSTOREResponses(outstandingEntries, 0 /* maxOutstanding */);
+            // notify user of this class about the SOP instances that remain without response
+            OFMap<Uint16, TransferEntry *>::iterator iter = outstandingEntries.begin();
+            while (iter != outstandingEntries.end())
+            {
+                notifySOPInstanceSent(*(iter->second));
+                ++iter;
+            }
+            if (status.good())
+                status = result;
+        }
     } else {
         // report an error to the caller
         status = NET_EC_NoSOPInstancesToSend;
@@ -929,6 +1295,129 @@ OFCondition DcmStorageSCU::sendSOPInstances()
 }
 
 
+OFCondition DcmStorageSCU::sendSOPInstancesInParallel(const unsigned int numAssociations)
+{
+    // check whether there are any instances in the transfer list
+    if (TransferList.empty())
+        return NET_EC_NoSOPInstancesToSend;
+    const size_t numToBeSent = getNumberOfSOPInstancesToBeSent();
+    if (numToBeSent == 0)
+        return EC_Normal;
+    // use at most one association per SOP instance
+    size_t numWorkers = (numAssociations > 0) ? OFstatic_cast(size_t, numAssociations) : 1;
+    if (numWorkers > numToBeSent)
+        numWorkers = numToBeSent;
+    SendTask task(*this);
+    for (size_t i = 0; i < numWorkers; ++i)
+        task.Workers.push_back(new WorkerSCU(task));
+    // distribute the SOP instances that are not yet sent evenly among the workers
+    size_t count = 0;
+    OFListIterator(TransferEntry *) transferEntry = TransferList.begin();
+    OFListConstIterator(TransferEntry *) lastEntry = TransferList.end();
+    while (transferEntry != lastEntry)
+    {
+        if (!(*transferEntry)->RequestSent)
+            task.Workers[count++ % numWorkers]->addTransferEntry(*transferEntry);
+        ++transferEntry;
+    }
+    DCMNET_DEBUG("sending " << numToBeSent << " SOP instances over " << numWorkers << " associations in parallel");
+    OFThreadPool pool(numWorkers);
+    pool.run(task, numWorkers);
+    // count total number of presentation contexts
+    for (size_t i = 0; i < numWorkers; ++i)
+        PresentationContextCounter += task.Workers[i]->getPresentationContextCounter();
+    // any subsequent call of addPresentationContexts() continues with the first SOP instance not sent
+    CurrentTransferEntry = TransferList.begin();
+    return task.Status;
+}
+
+
+void DcmStorageSCU::handleDatasetAfterSend(TransferEntry &transferEntry)
+{
+    // check whether we need to compact or delete the dataset
+    if (transferEntry.Filename.isEmpty() && (transferEntry.Dataset != NULL))
+    {
+        if (transferEntry.DatasetHandlingMode == HM_compactAfterSend)
+        {
+            DCMNET_DEBUG("compacting dataset after successful send");
+            transferEntry.Dataset->compactElements(256 /* maxLength */);
+        }
+        else if (transferEntry.DatasetHandlingMode == HM_deleteAfterSend)
+        {
+            DCMNET_DEBUG("deleting dataset after successful send");
+            delete transferEntry.Dataset;
+            // forget about this dataset (e.g. in order to avoid double deletion)
+            transferEntry.Dataset = NULL;
+        }
+    }
+}
+
+
+OFCondition DcmStorageSCU::receiveSTOREResponses(OFMap<Uint16, TransferEntry *> &outstandingEntries,
+                                                 const size_t maxOutstanding)
+{
+    OFCondition status = EC_Normal;
+    Uint16 messageID = 0;
+    Uint16 statusCode = 0;
+    while (status.good() && (outstandingEntries.size() > maxOutstanding))
+    {
+        status = receiveSTOREResponse(messageID, statusCode);
+        if (status.good())
+        {
+            OFMap<Uint16, TransferEntry *>::iterator iter = outstandingEntries.find(messageID);
+            if (iter != outstandingEntries.end())
+            {
+                TransferEntry *entry = iter->second;
+                outstandingEntries.erase(iter);
+                // remember that this SOP instance has been sent and store the DIMSE status
+                entry->RequestSent = OFTrue;
+                entry->ResponseStatusCode = statusCode;
+                handleDatasetAfterSend(*entry);
+                // notify user of this class that the SOP instance has been processed
+                notifySOPInstanceSent(*entry);
+            } else {
+                // should never happen since the base class checks the message ID
+                DCMNET_WARN("received C-STORE response for unknown request (MsgID " << messageID << ")");
+            }
+        }
+    }
+    return status;
+}
+
+
+DcmStorageSCU::FileLoader *DcmStorageSCU::prefetchNextFile(OFListIterator(TransferEntry *) currentEntry)
+{
+    // determine the next SOP instance that is to be sent
+    OFListConstIterator(TransferEntry *) lastEntry = TransferList.end();
+    OFListIterator(TransferEntry *) nextEntry = currentEntry;
+    do
+    {
+        ++nextEntry;
+    } while ((nextEntry != lastEntry) && (*nextEntry)->RequestSent);
+    // check whether it is sent on this association and from a DICOM file
+    if ((nextEntry == lastEntry) || ((*nextEntry)->PresentationContextID == 0) || (*nextEntry)->Filename.isEmpty())
+        return NULL;
+    // determine the transfer syntax the dataset is converted to (if required)
+    E_TransferSyntax networkXfer = EXS_Unknown;
+    if (getDatasetConversionMode())
+    {
+        OFString abstractSyntax, transferSyntax;
+        findPresentationContext((*nextEntry)->PresentationContextID, abstractSyntax, transferSyntax);
+        if (!transferSyntax.empty())
+            networkXfer = DcmXfer(transferSyntax.c_str()).getXfer();
+    }
+    DCMNET_TRACE("loading DICOM file in the background: " << (*nextEntry)->Filename);
+    FileLoader *loader = new FileLoader(*nextEntry, (*nextEntry)->Filename, (*nextEntry)->FileReadMode, networkXfer);
+    if (loader->start() != 0)
+    {
+        // the file will be loaded when the SOP instance is sent
+        delete loader;
+        loader = NULL;
+    }
+    return loader;
+}
+
+
 void DcmStorageSCU::notifySOPInstanceToBeSent(const TransferEntry & /*transferEntry*/)
 {
     // do nothing in the default implementation
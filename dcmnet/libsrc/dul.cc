@@ -173,11 +173,7 @@ get_association_parameter(void *paramAddress,
   DUL_DATA_TYPE paramType, size_t paramLength,
   DUL_DATA_TYPE outputType, void *outputAddress, size_t outputLength);
 
-#ifdef _WIN32
-static void setTCPBufferLength(SOCKET sock);
-#else
-static void setTCPBufferLength(int sock);
-#endif
+static void setTCPBufferLength(DcmNativeSocketType sock, int sendBufferSize, int receiveBufferSize, const char *caller);
 
 static OFCondition checkNetwork(PRIVATE_NETWORKKEY ** networkKey);
 static OFCondition checkAssociation(PRIVATE_ASSOCIATIONKEY ** association);
@@ -276,6 +272,54 @@ void DUL_activateCompatibilityMode(DUL_ASSOCIATIONKEY *dulassoc, unsigned long m
   }
 }
 
+void DUL_getDataPDUStatistics(DUL_ASSOCIATIONKEY *dulassoc,
+                              unsigned long& pdusSent,
+                              Uint64& bytesSent,
+                              unsigned long& pdusReceived,
+                              Uint64& bytesReceived)
+{
+  if (dulassoc)
+  {
+    PRIVATE_ASSOCIATIONKEY *assoc = (PRIVATE_ASSOCIATIONKEY *)dulassoc;
+    pdusSent = assoc->dataPDUsSent;
+    bytesSent = assoc->dataBytesSent;
+    pdusReceived = assoc->dataPDUsReceived;
+    bytesReceived = assoc->dataBytesReceived;
+  } else {
+    pdusSent = pdusReceived = 0;
+    bytesSent = bytesReceived = 0;
+  }
+}
+
+OFCondition DUL_SetSocketOptions(DUL_ASSOCIATIONKEY *dulassoc, const DUL_SOCKETOPTIONS *options)
+{
+  PRIVATE_ASSOCIATIONKEY *assoc = (PRIVATE_ASSOCIATIONKEY *)dulassoc;
+  if ((options == NULL) || (assoc == NULL) || (assoc->connection == NULL))
+    return DUL_NULLKEY;
+  return PRV_ApplySocketOptions(assoc->connection->getSocket(), options, "DUL");
+}
+
+OFCondition DUL_SetNetworkSocketOptions(DUL_NETWORKKEY *callerNetworkKey, const DUL_SOCKETOPTIONS *options)
+{
+  PRIVATE_NETWORKKEY *net = (PRIVATE_NETWORKKEY *)callerNetworkKey;
+  if ((options == NULL) || (net == NULL))
+    return DUL_NULLKEY;
+  net->socketOptions = *options;
+  /* the listening socket already exists, so the buffer sizes might not be
+   * considered for the window scaling of the connections accepted from now on
+   */
+#ifdef _WIN32
+  if (net->networkSpecific.TCP.listenSocket != INVALID_SOCKET)
+#else
+  if (net->networkSpecific.TCP.listenSocket >= 0)
+#endif
+  {
+    if ((options->sendBufferSize > 0) || (options->receiveBufferSize > 0))
+      setTCPBufferLength(net->networkSpecific.TCP.listenSocket, options->sendBufferSize, options->receiveBufferSize, "DUL");
+  }
+  return EC_Normal;
+}
+
 void DUL_activateCallback(DUL_ASSOCIATIONKEY *dulassoc, DUL_ModeCallback *cb)
 {
   if (dulassoc)
@@ -353,7 +397,8 @@ unsigned long DUL_getPeerCertificateLength(DUL_ASSOCIATIONKEY *dulassoc)
 OFCondition
 DUL_InitializeNetwork(const char *mode,
                       void *networkParameter, int timeout, unsigned long opt,
-                      DUL_NETWORKKEY ** networkKey)
+                      DUL_NETWORKKEY ** networkKey,
+                      const DUL_SOCKETOPTIONS *socketOptions)
 {
     // default return value if something goes wrong
     *networkKey = NULL;
@@ -376,6 +421,10 @@ DUL_InitializeNetwork(const char *mode,
     PRIVATE_NETWORKKEY *key = NULL;
     OFCondition cond = createNetworkKey(mode, timeout, opt, &key);
 
+    // the socket options are needed before the listening socket is created
+    if (cond.good() && (socketOptions != NULL))
+      key->socketOptions = *socketOptions;
+
     // initialize network
     if (cond.good()) cond = initializeNetworkTCP(&key, networkParameter);
 
@@ -1069,6 +1118,9 @@ DUL_AcknowledgeRelease(DUL_ASSOCIATIONKEY ** callerAssociation)
 **
 ** Parameter Dictionary:
 **      callerAssociation  The handle for the association to be aborted.
+**      waitForClose       If false, return after sending the A-ABORT PDU
+**                         without waiting for the network to close. The
+**                         caller has to drop the association later on.
 **
 ** Return Values:
 **
@@ -1077,7 +1129,7 @@ DUL_AcknowledgeRelease(DUL_ASSOCIATIONKEY ** callerAssociation)
 **      Description of the algorithm (optional) and any other notes.
 */
 OFCondition
-DUL_AbortAssociation(DUL_ASSOCIATIONKEY ** callerAssociation)
+DUL_AbortAssociation(DUL_ASSOCIATIONKEY ** callerAssociation, OFBool waitForClose)
 {
     DUL_ABORTITEMS abortItems = { 0, DUL_SCU_INITIATED_ABORT, 0 };
     int event = 0;
@@ -1091,7 +1143,7 @@ DUL_AbortAssociation(DUL_ASSOCIATIONKEY ** callerAssociation)
     cond = PRV_StateMachine(NULL, association, A_ABORT_REQ, (*association)->protocolState, &abortItems);
     if (cond.bad()) return cond;
 
-    OFBool done = OFFalse;
+    OFBool done = !waitForClose;
     while (!done)
     {
         cond = PRV_NextPDUType(association, DUL_NOBLOCK, PRV_DEFAULTTIMEOUT, &pduType); // may return DUL_NETWORKCLOSED.
@@ -1930,55 +1982,9 @@ receiveTransportConnectionTCP(PRIVATE_NETWORKKEY ** network,
         msg += OFStandard::getLastNetworkErrorCode().message();
         return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, msg.c_str());
     }
-    setTCPBufferLength(sock);
-
-    /*
-     * Disable the so-called Nagle algorithm (if requested).
-     * This might provide a better network performance on some systems/environments.
-     * By default, the algorithm is not disabled unless DISABLE_NAGLE_ALGORITHM is defined.
-     * The default behavior can be changed by setting the environment variable TCP_NODELAY.
-     */
-
-#ifdef DONT_DISABLE_NAGLE_ALGORITHM
-#ifdef _MSC_VER
-#pragma message("The macro DONT_DISABLE_NAGLE_ALGORITHM is not supported anymore. See 'macros.txt' for details.")
-#else
-#warning The macro DONT_DISABLE_NAGLE_ALGORITHM is not supported anymore. See "macros.txt" for details.
-#endif
-#endif
-
-#ifdef DISABLE_NAGLE_ALGORITHM
-    int tcpNoDelay = 1; // disable
-#else
-    int tcpNoDelay = 0; // don't disable
-#endif
-    char* tcpNoDelayString = NULL;
-    DCMNET_TRACE("checking whether environment variable TCP_NODELAY is set");
-    if ((tcpNoDelayString = getenv("TCP_NODELAY")) != NULL)
-    {
-      if (sscanf(tcpNoDelayString, "%d", &tcpNoDelay) != 1)
-      {
-        DCMNET_WARN("DUL: cannot parse environment variable TCP_NODELAY=" << tcpNoDelayString);
-      }
-    } else
-      DCMNET_TRACE("  environment variable TCP_NODELAY not set, using the default value (" << tcpNoDelay << ")");
-    if (tcpNoDelay) {
-#ifdef DISABLE_NAGLE_ALGORITHM
-      DCMNET_DEBUG("DUL: disabling Nagle algorithm as defined at compilation time (DISABLE_NAGLE_ALGORITHM)");
-#else
-      DCMNET_DEBUG("DUL: disabling Nagle algorithm as requested at runtime (TCP_NODELAY=" << tcpNoDelayString << ")");
-#endif
-      if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&tcpNoDelay, sizeof(tcpNoDelay)) < 0)
-      {
-        OFString msg = "TCP Initialization Error: ";
-        msg += OFStandard::getLastNetworkErrorCode().message();
-        return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, msg.c_str());
-      }
-#ifdef DISABLE_NAGLE_ALGORITHM
-    } else {
-      DCMNET_DEBUG("DUL: do not disable Nagle algorithm as requested at runtime (TCP_NODELAY=" << tcpNoDelayString << ")");
-#endif
-    }
+    OFCondition cond = PRV_ApplySocketOptions(sock, &(*network)->socketOptions, "DUL");
+    if (cond.bad())
+        return cond;
 
     // create string containing numerical IP address.
     OFString client_dns_name;
@@ -2127,6 +2133,7 @@ createNetworkKey(const char *mode,
         (*key)->timeout = DEFAULT_TIMEOUT;
 
     (*key)->options = opt;
+    memset(&(*key)->socketOptions, 0, sizeof((*key)->socketOptions));
 
     return EC_Normal;
 }
@@ -2248,6 +2255,13 @@ initializeNetworkTCP(PRIVATE_NETWORKKEY ** key, void *parameter)
         return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, msg.c_str());
       }
 
+      /* The TCP window scale factor of an accepted connection is negotiated
+       * before accept() returns and is based on the receive buffer size of the
+       * listening socket, which is inherited by the accepted sockets. So set
+       * the buffer sizes before the socket starts listening.
+       */
+      setTCPBufferLength(sock, (*key)->socketOptions.sendBufferSize, (*key)->socketOptions.receiveBufferSize, "DUL");
+
       /* Listen on the socket */
       if (listen(sock, PRV_LISTENBACKLOG) < 0)
       {
@@ -2337,6 +2351,10 @@ createAssociationKey(PRIVATE_NETWORKKEY ** networkKey,
     key->logHandle = NULL;
     key->connection = NULL;
     key->modeCallback = NULL;
+    key->dataPDUsSent = 0;
+    key->dataPDUsReceived = 0;
+    key->dataBytesSent = 0;
+    key->dataBytesReceived = 0;
     *associationKey = key;
     return EC_Normal;
 }
@@ -2412,10 +2430,13 @@ get_association_parameter(void *paramAddress,
 /* setTCPBufferLength
 **
 ** Purpose:
-**      Initialize the length of the buffer.
+**      Initialize the length of the TCP send and receive buffers.
 **
 ** Parameter Dictionary:
-**      sock  Socket descriptor.
+**      sock               Socket descriptor.
+**      sendBufferSize     Size of the send buffer, 0 for the default.
+**      receiveBufferSize  Size of the receive buffer, 0 for the default.
+**      caller             Name of the calling module (for log messages).
 **
 ** Return Values:
 **      None
@@ -2424,39 +2445,213 @@ get_association_parameter(void *paramAddress,
 ** Notes:
 **
 ** Algorithm:
-**      Description of the algorithm (optional) and any other notes.
+**      Buffer sizes not given explicitly are taken from the environment
+**      variable TCP_BUFFER_LENGTH (if set).
 */
-#ifdef _WIN32
-static void setTCPBufferLength(SOCKET sock)
-#else
-static void setTCPBufferLength(int sock)
-#endif
+static void setTCPBufferLength(DcmNativeSocketType sock, int sendBufferSize, int receiveBufferSize, const char *caller)
 {
     char *TCPBufferLength;
-    int bufLen;
+    int bufLen = 0;
 
-    /*
-     * check whether environment variable TCP_BUFFER_LENGTH is set.
-     * If not, the the operating system is responsible for selecting
-     * appropriate values for the TCP send and receive buffer lengths.
-     */
-    DCMNET_TRACE("checking whether environment variable TCP_BUFFER_LENGTH is set");
-    if ((TCPBufferLength = getenv("TCP_BUFFER_LENGTH")) != NULL) {
-        if (sscanf(TCPBufferLength, "%d", &bufLen) == 1) {
+    if ((sendBufferSize <= 0) || (receiveBufferSize <= 0))
+    {
+        /*
+         * check whether environment variable TCP_BUFFER_LENGTH is set.
+         * If not, the the operating system is responsible for selecting
+         * appropriate values for the TCP send and receive buffer lengths.
+         */
+        DCMNET_TRACE("checking whether environment variable TCP_BUFFER_LENGTH is set");
+        if ((TCPBufferLength = getenv("TCP_BUFFER_LENGTH")) != NULL) {
+            if (sscanf(TCPBufferLength, "%d", &bufLen) == 1) {
+                if (bufLen == 0)
+                    bufLen = 65536; // a socket buffer size of 64K gives good throughput for image transmission
+            } else {
+                DCMNET_WARN(caller << ": cannot parse environment variable TCP_BUFFER_LENGTH=" << TCPBufferLength);
+                bufLen = 0;
+            }
+        } else
+            DCMNET_TRACE("  environment variable TCP_BUFFER_LENGTH not set, using the system defaults");
+        if (sendBufferSize <= 0) sendBufferSize = bufLen;
+        if (receiveBufferSize <= 0) receiveBufferSize = bufLen;
+    }
+
+    if ((sendBufferSize > 0) || (receiveBufferSize > 0))
+    {
 #if defined(SO_SNDBUF) && defined(SO_RCVBUF)
-            if (bufLen == 0)
-                bufLen = 65536; // a socket buffer size of 64K gives good throughput for image transmission
-            DCMNET_DEBUG("DUL: setting TCP buffer length to " << bufLen << " bytes");
-            (void) setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *) &bufLen, sizeof(bufLen));
-            (void) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &bufLen, sizeof(bufLen));
+        if (sendBufferSize > 0)
+        {
+            DCMNET_DEBUG(caller << ": setting TCP send buffer length to " << sendBufferSize << " bytes");
+            (void) setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *) &sendBufferSize, sizeof(sendBufferSize));
+        }
+        if (receiveBufferSize > 0)
+        {
+            DCMNET_DEBUG(caller << ": setting TCP receive buffer length to " << receiveBufferSize << " bytes");
+            (void) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &receiveBufferSize, sizeof(receiveBufferSize));
+        }
 #else
-            DCMNET_WARN("DUL: setTCPBufferLength: cannot set TCP buffer length socket option: "
-                << "code disabled because SO_SNDBUF and SO_RCVBUF constants are unknown");
+        DCMNET_WARN(caller << ": setTCPBufferLength: cannot set TCP buffer length socket option: "
+            << "code disabled because SO_SNDBUF and SO_RCVBUF constants are unknown");
 #endif // SO_SNDBUF and SO_RCVBUF
-        } else
-            DCMNET_WARN("DUL: cannot parse environment variable TCP_BUFFER_LENGTH=" << TCPBufferLength);
-    } else
-        DCMNET_TRACE("  environment variable TCP_BUFFER_LENGTH not set, using the system defaults");
+    }
+}
+
+
+/* setOptionalSocketOption
+**
+** Purpose:
+**      Set an integer socket option that is not essential for the
+**      communication, i.e. failures are only reported as a warning.
+*/
+static void setOptionalSocketOption(DcmNativeSocketType sock, int level, int option, int value,
+                                    const char *name, const char *caller)
+{
+    DCMNET_DEBUG(caller << ": setting socket option " << name << " to " << value);
+    if (setsockopt(sock, level, option, (char *) &value, sizeof(value)) < 0)
+        DCMNET_WARN(caller << ": cannot set socket option " << name << ": "
+            << OFStandard::getLastNetworkErrorCode().message());
+}
+
+
+/* PRV_ApplySocketOptions
+**
+** Purpose:
+**      Apply the socket options of an association to a socket.
+**
+** Parameter Dictionary:
+**      sock       Socket descriptor.
+**      options    Socket options, NULL for the defaults.
+**      caller     Name of the calling module (for log messages).
+**
+** Return Values:
+**      EC_Normal if successful, DULC_TCPINITERROR if the Nagle algorithm
+**      could not be disabled.
+**
+** Notes:
+**      Options that are not supported by the operating system and
+**      failures to set optional tuning parameters are only reported
+**      as a warning.
+*/
+OFCondition
+PRV_ApplySocketOptions(DcmNativeSocketType sock,
+                       const DUL_SOCKETOPTIONS * options, const char *caller)
+{
+    DUL_SOCKETOPTIONS defaults;
+    if (options == NULL)
+    {
+        memset(&defaults, 0, sizeof(defaults));
+        options = &defaults;
+    }
+
+    setTCPBufferLength(sock, options->sendBufferSize, options->receiveBufferSize, caller);
+
+    /*
+     * Disable the so-called Nagle algorithm (if requested).
+     * This might provide a better network performance on some systems/environments.
+     * By default, the algorithm is not disabled unless DISABLE_NAGLE_ALGORITHM is defined.
+     * The default behavior can be changed by setting the environment variable TCP_NODELAY
+     * or by the socket options of the association.
+     */
+
+#ifdef DONT_DISABLE_NAGLE_ALGORITHM
+#ifdef _MSC_VER
+#pragma message("The macro DONT_DISABLE_NAGLE_ALGORITHM is not supported anymore. See 'macros.txt' for details.")
+#else
+#warning The macro DONT_DISABLE_NAGLE_ALGORITHM is not supported anymore. See "macros.txt" for details.
+#endif
+#endif
+
+#ifdef DISABLE_NAGLE_ALGORITHM
+    int tcpNoDelay = 1; // disable
+#else
+    int tcpNoDelay = 0; // don't disable
+#endif
+    if (options->tcpNoDelay != DUL_SOCKOPT_DEFAULT)
+    {
+        tcpNoDelay = (options->tcpNoDelay == DUL_SOCKOPT_ENABLED) ? 1 : 0;
+        DCMNET_DEBUG(caller << ": " << (tcpNoDelay ? "disabling" : "not disabling")
+            << " Nagle algorithm as requested by the socket options of the association");
+    }
+    else
+    {
+        char* tcpNoDelayString = NULL;
+        DCMNET_TRACE("checking whether environment variable TCP_NODELAY is set");
+        if ((tcpNoDelayString = getenv("TCP_NODELAY")) != NULL)
+        {
+          if (sscanf(tcpNoDelayString, "%d", &tcpNoDelay) != 1)
+          {
+            DCMNET_WARN(caller << ": cannot parse environment variable TCP_NODELAY=" << tcpNoDelayString);
+          }
+          else
+          {
+            DCMNET_DEBUG(caller << ": " << (tcpNoDelay ? "disabling" : "not disabling")
+                << " Nagle algorithm as requested at runtime (TCP_NODELAY=" << tcpNoDelayString << ")");
+          }
+        } else {
+          DCMNET_TRACE("  environment variable TCP_NODELAY not set, using the default value (" << tcpNoDelay << ")");
+#ifdef DISABLE_NAGLE_ALGORITHM
+          DCMNET_DEBUG(caller << ": disabling Nagle algorithm as defined at compilation time (DISABLE_NAGLE_ALGORITHM)");
+#endif
+        }
+    }
+    // an explicit request to keep the Nagle algorithm is also passed to the socket
+    if (tcpNoDelay || (options->tcpNoDelay == DUL_SOCKOPT_DISABLED))
+    {
+      if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&tcpNoDelay, sizeof(tcpNoDelay)) < 0)
+      {
+        OFString msg = "TCP Initialization Error: ";
+        msg += OFStandard::getLastNetworkErrorCode().message();
+        return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, msg.c_str());
+      }
+    }
+
+    if (options->tcpQuickAck != DUL_SOCKOPT_DEFAULT)
+    {
+#ifdef TCP_QUICKACK
+        setOptionalSocketOption(sock, IPPROTO_TCP, TCP_QUICKACK, (options->tcpQuickAck == DUL_SOCKOPT_ENABLED) ? 1 : 0, "TCP_QUICKACK", caller);
+#else
+        DCMNET_WARN(caller << ": socket option TCP_QUICKACK not supported on this platform, ignored");
+#endif
+    }
+
+    if (options->keepAlive != DUL_SOCKOPT_DEFAULT)
+        setOptionalSocketOption(sock, SOL_SOCKET, SO_KEEPALIVE, (options->keepAlive == DUL_SOCKOPT_ENABLED) ? 1 : 0, "SO_KEEPALIVE", caller);
+    if (options->keepAliveIdle > 0)
+    {
+#if defined(TCP_KEEPIDLE)
+        setOptionalSocketOption(sock, IPPROTO_TCP, TCP_KEEPIDLE, options->keepAliveIdle, "TCP_KEEPIDLE", caller);
+#elif defined(TCP_KEEPALIVE)
+        // macOS uses a different name for the same option
+        setOptionalSocketOption(sock, IPPROTO_TCP, TCP_KEEPALIVE, options->keepAliveIdle, "TCP_KEEPALIVE", caller);
+#else
+        DCMNET_WARN(caller << ": socket option TCP_KEEPIDLE not supported on this platform, ignored");
+#endif
+    }
+    if (options->keepAliveInterval > 0)
+    {
+#ifdef TCP_KEEPINTVL
+        setOptionalSocketOption(sock, IPPROTO_TCP, TCP_KEEPINTVL, options->keepAliveInterval, "TCP_KEEPINTVL", caller);
+#else
+        DCMNET_WARN(caller << ": socket option TCP_KEEPINTVL not supported on this platform, ignored");
+#endif
+    }
+    if (options->keepAliveCount > 0)
+    {
+#ifdef TCP_KEEPCNT
+        setOptionalSocketOption(sock, IPPROTO_TCP, TCP_KEEPCNT, options->keepAliveCount, "TCP_KEEPCNT", caller);
+#else
+        DCMNET_WARN(caller << ": socket option TCP_KEEPCNT not supported on this platform, ignored");
+#endif
+    }
+
+    if (options->busyPoll > 0)
+    {
+#ifdef SO_BUSY_POLL
+        setOptionalSocketOption(sock, SOL_SOCKET, SO_BUSY_POLL, options->busyPoll, "SO_BUSY_POLL", caller);
+#else
+        DCMNET_WARN(caller << ": socket option SO_BUSY_POLL not supported on this platform, ignored");
+#endif
+    }
+    return EC_Normal;
 }
 
 
@@ -2490,6 +2685,8 @@ DUL_DumpParams(OFString& ret_str, DUL_ASSOCIATESERVICEPARAMETERS * params)
         << "AP TITLE:     " << params->respondingAPTitle << OFendl
         << "MAX PDU:      " << (int)params->maxPDU << OFendl
         << "Peer MAX PDU: " << (int)params->peerMaxPDU << OFendl
+        << "MAX OPS:      " << params->maximumOperationsInvoked << "/" << params->maximumOperationsPerformed << OFendl
+        << "Peer MAX OPS: " << params->peerMaximumOperationsInvoked << "/" << params->peerMaximumOperationsPerformed << OFendl
         << "PRES ADDR:    " << params->callingPresentationAddress << OFendl
         << "PRES ADDR:    " << params->calledPresentationAddress << OFendl
         << "REQ IMP UID:  " << params->callingImplementationClassUID << OFendl;
@@ -2766,8 +2963,10 @@ clearRequestorsParams(DUL_ASSOCIATESERVICEPARAMETERS * params)
     params->calledPresentationAddress[0] = '\0';
     params->requestedPresentationContext = NULL;
     params->acceptedPresentationContext = NULL;
-    params->maximumOperationsInvoked = 0;
-    params->maximumOperationsPerformed = 0;
+    params->maximumOperationsInvoked = 1;
+    params->maximumOperationsPerformed = 1;
+    params->peerMaximumOperationsInvoked = 1;
+    params->peerMaximumOperationsPerformed = 1;
     params->callingImplementationClassUID[0] = '\0';
     params->callingImplementationVersionName[0] = '\0';
     params->requestedExtNegList = NULL;
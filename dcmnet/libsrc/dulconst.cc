@@ -92,6 +92,10 @@ static OFCondition
 constructMaxLength(unsigned long maxPDU, DUL_MAXLENGTH * max,
                    unsigned long *rtnLen);
 static OFCondition
+constructAsyncOperations(unsigned short maxOpsInvoked,
+                         unsigned short maxOpsPerformed,
+                         PRV_ASYNCOPERATIONS * async, unsigned long *rtnLen);
+static OFCondition
 constructSCUSCPRoles(unsigned char type,
                      DUL_ASSOCIATESERVICEPARAMETERS * params,
                      LST_HEAD ** lst,
@@ -113,6 +117,9 @@ streamUserInfo(DUL_USERINFO * userInfo, unsigned char *b,
 static OFCondition
 streamMaxLength(DUL_MAXLENGTH * max, unsigned char *b,
                 unsigned long *length);
+static OFCondition
+streamAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *b,
+                      unsigned long *length);
 static OFCondition
     streamSCUSCPList(LST_HEAD ** lst, unsigned char *b, unsigned long *length);
 static OFCondition
@@ -845,7 +852,20 @@ constructUserInfo(unsigned char type, DUL_ASSOCIATESERVICEPARAMETERS * params,
     totalUserInfoLength += length;
     *rtnLen += length;
 
-    // user info sub-item 53H (async operations) is not yet implemented!
+    // construct user info sub-item 53H: asynchronous operations window.
+    // The sub-item is only proposed if a window other than the default (1/1)
+    // is requested, and only acknowledged if the requestor proposed it.
+    if (((type == DUL_TYPEASSOCIATERQ) &&
+         ((params->maximumOperationsInvoked != 1) || (params->maximumOperationsPerformed != 1))) ||
+        ((type == DUL_TYPEASSOCIATEAC) &&
+         ((params->peerMaximumOperationsInvoked != 1) || (params->peerMaximumOperationsPerformed != 1))))
+    {
+        cond = constructAsyncOperations(params->maximumOperationsInvoked,
+            params->maximumOperationsPerformed, &userInfo->asyncOperations, &length);
+        if (cond.bad()) return cond;
+        totalUserInfoLength += length;
+        *rtnLen += length;
+    }
 
     // construct user info sub-item 55H: implementation version name
     if (type == DUL_TYPEASSOCIATERQ) {
@@ -945,6 +965,39 @@ constructMaxLength(unsigned long maxPDU, DUL_MAXLENGTH * max,
 }
 
 
+/* constructAsyncOperations
+**
+** Purpose:
+**  Construct the Asynchronous Operations Window part of the PDU
+**
+** Parameter Dictionary:
+**  maxOpsInvoked    Maximum number of operations invoked
+**  maxOpsPerformed  Maximum number of operations performed
+**  async            The sub-item that is to be constructed
+**  rtnLen           Length of the sub-item constructed
+**
+** Return Values:
+**
+**
+** Algorithm:
+**  Description of the algorithm (optional) and any other notes.
+*/
+static OFCondition
+constructAsyncOperations(unsigned short maxOpsInvoked,
+                         unsigned short maxOpsPerformed,
+                         PRV_ASYNCOPERATIONS * async, unsigned long *rtnLen)
+{
+    async->type = DUL_TYPEASYNCOPERATIONS;
+    async->rsv1 = 0;
+    async->length = 4;
+    async->maximumOperationsInvoked = maxOpsInvoked;
+    async->maximumOperationsProvided = maxOpsPerformed;
+    *rtnLen = 8;
+
+    return EC_Normal;
+}
+
+
 /* constructSCUSCPRoles
 **
 ** Purpose:
@@ -1298,7 +1351,14 @@ streamUserInfo(DUL_USERINFO * userInfo, unsigned char *b,
     b += subLength;
     *length += subLength;
 
-    // user info sub-item 53H (async operations) is not yet implemented!
+    // stream user info sub-item 53H: asynchronous operations window
+    if (userInfo->asyncOperations.type == DUL_TYPEASYNCOPERATIONS) {
+        cond = streamAsyncOperations(&userInfo->asyncOperations, b, &subLength);
+        if (cond.bad())
+            return cond;
+        b += subLength;
+        *length += subLength;
+    }
 
 #ifdef OLD_USER_INFO_SUB_ITEM_ORDER
     /* prior DCMTK releases did not encode user information sub items
@@ -1389,6 +1449,38 @@ streamMaxLength(DUL_MAXLENGTH * max, unsigned char *b,
     return EC_Normal;
 }
 
+/* streamAsyncOperations
+**
+** Purpose:
+**  Convert the Asynchronous Operations Window sub-item into stream format
+**
+** Parameter Dictionary:
+**  async   The sub-item to be converted to stream format
+**  b       The stream version (output)
+**  length  Length of the stream version
+**
+** Return Values:
+**
+**
+** Algorithm:
+**  Description of the algorithm (optional) and any other notes.
+*/
+static OFCondition
+streamAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *b,
+                      unsigned long *length)
+{
+    *b++ = async->type;
+    *b++ = async->rsv1;
+    COPY_SHORT_BIG(async->length, b);
+    b += 2;
+    COPY_SHORT_BIG(async->maximumOperationsInvoked, b);
+    b += 2;
+    COPY_SHORT_BIG(async->maximumOperationsProvided, b);
+
+    *length = 8;
+    return EC_Normal;
+}
+
 /* streamSCUSCPList
 **
 ** Purpose:
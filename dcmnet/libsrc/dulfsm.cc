@@ -133,6 +133,9 @@ enum
 #endif
 };
 
+/* maximum number of P-DATA PDUs sent with a single gathered write call */
+#define DUL_MAX_GATHERED_PDUS 8
+
 static OFCondition
 AE_1_TransportConnect(PRIVATE_NETWORKKEY ** network,
         PRIVATE_ASSOCIATIONKEY ** association, int nextState, void *params);
@@ -248,8 +251,8 @@ static OFCondition
 sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
              DUL_PDVLIST * pdvList);
 static OFCondition
-writeDataPDU(PRIVATE_ASSOCIATIONKEY ** association,
-             DUL_DATAPDU * pdu);
+writeDataPDUs(PRIVATE_ASSOCIATIONKEY ** association,
+              DUL_DATAPDU * pdus, unsigned long count);
 static void clearPDUCache(PRIVATE_ASSOCIATIONKEY ** association);
 static void closeTransport(PRIVATE_ASSOCIATIONKEY ** association);
 static void closeTransportTCP(PRIVATE_ASSOCIATIONKEY ** association);
@@ -288,11 +291,6 @@ defragmentTCP(DcmTransportConnection *connection, DUL_BLOCKOPTIONS block, time_t
 
 static OFString dump_pdu(const char *type, void *buffer, unsigned long length);
 
-#ifdef _WIN32
-static void setTCPBufferLength(SOCKET sock);
-#else
-static void setTCPBufferLength(int sock);
-#endif
 
 OFCondition
 translatePresentationContextList(LST_HEAD ** internalList,
@@ -1021,6 +1019,14 @@ AE_3_AssociateConfirmationAccept(PRIVATE_NETWORKKEY ** /*network*/,
         (*association)->maxPDV = assoc.userInfo.maxLength.maxLength;
         (*association)->maxPDVAcceptor =
             assoc.userInfo.maxLength.maxLength;
+        /* asynchronous operations window (1/1 if not negotiated) */
+        if (assoc.userInfo.asyncOperations.type == DUL_TYPEASYNCOPERATIONS) {
+            service->peerMaximumOperationsInvoked = assoc.userInfo.asyncOperations.maximumOperationsInvoked;
+            service->peerMaximumOperationsPerformed = assoc.userInfo.asyncOperations.maximumOperationsProvided;
+        } else {
+            service->peerMaximumOperationsInvoked = 1;
+            service->peerMaximumOperationsPerformed = 1;
+        }
         OFStandard::strlcpy(service->calledImplementationClassUID,
                assoc.userInfo.implementationClassUID.data, DICOM_UI_LENGTH + 1);
         OFStandard::strlcpy(service->calledImplementationVersionName,
@@ -1226,6 +1232,14 @@ AE_6_ExamineAssociateRequest(PRIVATE_NETWORKKEY ** /*network*/,
         (*association)->maxPDV = assoc.userInfo.maxLength.maxLength;
         (*association)->maxPDVRequestor =
             assoc.userInfo.maxLength.maxLength;
+        /* asynchronous operations window (1/1 if not negotiated) */
+        if (assoc.userInfo.asyncOperations.type == DUL_TYPEASYNCOPERATIONS) {
+            service->peerMaximumOperationsInvoked = assoc.userInfo.asyncOperations.maximumOperationsInvoked;
+            service->peerMaximumOperationsPerformed = assoc.userInfo.asyncOperations.maximumOperationsProvided;
+        } else {
+            service->peerMaximumOperationsInvoked = 1;
+            service->peerMaximumOperationsPerformed = 1;
+        }
         OFStandard::strlcpy(service->callingImplementationClassUID,
                assoc.userInfo.implementationClassUID.data, DICOM_UI_LENGTH + 1);
         OFStandard::strlcpy(service->callingImplementationVersionName,
@@ -1409,6 +1423,10 @@ DT_2_IndicatePData(PRIVATE_NETWORKKEY ** /*network*/,
     if (cond.bad())
         return cond;
 
+    /* update the transfer statistics of the association (PDU header and body) */
+    (*association)->dataPDUsReceived++;
+    (*association)->dataBytesReceived += 6 + pduLength;
+
     /* count the amount of PDVs in the current PDU */
     length = pduLength;                     //set length to the PDU's length
     pdvCount = 0;                           //set counter variable to 0
@@ -2277,6 +2295,19 @@ requestAssociationTCP(PRIVATE_NETWORKKEY ** network,
       return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, msg.c_str());
     }
 
+    // apply the socket options before connecting, so that the buffer sizes
+    // are taken into account for the TCP window scaling
+    OFCondition cond = PRV_ApplySocketOptions(s, &params->socketOptions, "DULFSM");
+    if (cond.bad())
+    {
+#ifdef HAVE_WINSOCK_H
+      (void) closesocket(s);
+#else
+      (void) close(s);
+#endif
+      return cond;
+    }
+
 #ifdef HAVE_WINSOCK_H
     u_long arg = TRUE;
 #else
@@ -2470,56 +2501,6 @@ requestAssociationTCP(PRIVATE_NETWORKKEY ** network,
           msg += OFStandard::getLastNetworkErrorCode().message();
           return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, msg.c_str());
         }
-        setTCPBufferLength(s);
-
-        /*
-         * Disable the so-called Nagle algorithm (if requested).
-         * This might provide a better network performance on some systems/environments.
-         * By default, the algorithm is not disabled unless DISABLE_NAGLE_ALGORITHM is defined.
-         * The default behavior can be changed by setting the environment variable TCP_NODELAY.
-         */
-
-#ifdef DONT_DISABLE_NAGLE_ALGORITHM
-#ifdef _MSC_VER
-#pragma message("The macro DONT_DISABLE_NAGLE_ALGORITHM is not supported anymore. See 'macros.txt' for details.")
-#else
-#warning The macro DONT_DISABLE_NAGLE_ALGORITHM is not supported anymore. See "macros.txt" for details.
-#endif
-#endif
-
-#ifdef DISABLE_NAGLE_ALGORITHM
-        int tcpNoDelay = 1; // disable
-#else
-        int tcpNoDelay = 0; // don't disable
-#endif
-        char* tcpNoDelayString = NULL;
-        DCMNET_TRACE("checking whether environment variable TCP_NODELAY is set");
-        if ((tcpNoDelayString = getenv("TCP_NODELAY")) != NULL)
-        {
-          if (sscanf(tcpNoDelayString, "%d", &tcpNoDelay) != 1)
-          {
-            DCMNET_WARN("DULFSM: cannot parse environment variable TCP_NODELAY=" << tcpNoDelayString);
-          }
-        } else
-          DCMNET_TRACE("  environment variable TCP_NODELAY not set, using the default value (" << tcpNoDelay << ")");
-        if (tcpNoDelay) {
-#ifdef DISABLE_NAGLE_ALGORITHM
-          DCMNET_DEBUG("DULFSM: disabling Nagle algorithm as defined at compilation time (DISABLE_NAGLE_ALGORITHM)");
-#else
-          DCMNET_DEBUG("DULFSM: disabling Nagle algorithm as requested at runtime (TCP_NODELAY=" << tcpNoDelayString << ")");
-#endif
-          if (setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (char*)&tcpNoDelay, sizeof(tcpNoDelay)) < 0)
-          {
-            OFString msg = "TCP Initialization Error: ";
-            msg += OFStandard::getLastNetworkErrorCode().message();
-            return makeDcmnetCondition(DULC_TCPINITERROR, OF_error, msg.c_str());
-          }
-#ifdef DISABLE_NAGLE_ALGORITHM
-        } else {
-          DCMNET_DEBUG("DULFSM: do not disable Nagle algorithm as requested at runtime (TCP_NODELAY=" << tcpNoDelayString << ")");
-#endif
-        }
-
         return (*association)->connection->clientSideHandshake();
     }
 }
@@ -2981,7 +2962,8 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
 
     OFBool localLast;
     unsigned char *p;
-    DUL_DATAPDU dataPDU;
+    DUL_DATAPDU dataPDUs[DUL_MAX_GATHERED_PDUS];
+    unsigned long pduCount = 0;
     OFBool firstTrip;
 
     /* assign the amount of PDVs in the array and the PDV array itself to local variables */
@@ -3029,9 +3011,17 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
             localLast = ((pdvLength == length) && pdv->lastPDV);
             /* construct a data PDU */
             cond = constructDataPDU(p, pdvLength, pdv->pdvType,
-                           pdv->presentationContextID, localLast, &dataPDU);
-            /* send the constructed PDU over the network */
-            cond = writeDataPDU(association, &dataPDU);
+                           pdv->presentationContextID, localLast, &dataPDUs[pduCount]);
+            if (cond.good())
+            {
+                /* send the constructed PDUs over the network as soon as the array is full, */
+                /* the PDU data is still in the caller's buffers, so it need not be copied */
+                if (++pduCount == DUL_MAX_GATHERED_PDUS)
+                {
+                    cond = writeDataPDUs(association, dataPDUs, pduCount);
+                    pduCount = 0;
+                }
+            }
 
             /* adjust the pointer to the data, so that he points to data which still has to be sent */
             p += pdvLength;
@@ -3042,11 +3032,14 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
         pdv++;
 
     }
+    /* send the remaining PDUs over the network */
+    if (cond.good() && (pduCount > 0))
+        cond = writeDataPDUs(association, dataPDUs, pduCount);
     /* return corresponding result value */
     return cond;
 }
 
-/* writeDataPDU
+/* writeDataPDUs
 **
 ** Purpose:
 **      Send the data through the socket interface (for TCP).
@@ -3054,66 +3047,74 @@ sendPDataTCP(PRIVATE_ASSOCIATIONKEY ** association,
 ** Parameter Dictionary:
 **
 **      association     Handle to the Association
-**      pdu             The data unit that is to be sent thru the socket
+**      pdus            The data units that are to be sent thru the socket
+**      count           Number of data units
 **
 ** Return Values:
 **
 **
 ** Notes:
+**      The PDU heads and the PDV data of all data units are sent
+**      with a single (gathered) write call, without copying them.
 **
 ** Algorithm:
 **      Description of the algorithm (optional) and any other notes.
 */
 
 static OFCondition
-writeDataPDU(PRIVATE_ASSOCIATIONKEY ** association,
-             DUL_DATAPDU * pdu)
+writeDataPDUs(PRIVATE_ASSOCIATIONKEY ** association,
+              DUL_DATAPDU * pdus, unsigned long count)
 {
     unsigned char
-        head[24];
+        heads[DUL_MAX_GATHERED_PDUS][24];
+    const void
+        *buffers[2 * DUL_MAX_GATHERED_PDUS];
+    size_t
+        lengths[2 * DUL_MAX_GATHERED_PDUS];
     unsigned long
-        length;
-    int
+        length,
+        total = 0;
+    ssize_t
         nbytes;
 
-    /* construct a stream variable that will contain PDU head information */
-    /* (in detail, this variable will contain PDU type, PDU reserved field, */
-    /* PDU length, PDV length, presentation context ID, message control header) */
-    /* (note that our representation of a PDU can only contain one PDV.) */
-    OFCondition cond = streamDataPDUHead(pdu, head, sizeof(head), &length);
-    if (cond.bad()) return cond;
+    if (count > DUL_MAX_GATHERED_PDUS) return EC_IllegalParameter;
 
-    /* send the PDU head information (see above) */
-    do
+    for (unsigned long i = 0; i < count; i++)
     {
-      nbytes = (*association)->connection ? (*association)->connection->write((char*)head, size_t(length)) : 0;
-    } while (nbytes == -1 && OFStandard::getLastNetworkErrorCode().value() == DCMNET_EINTR);
+        /* construct a stream variable that will contain PDU head information */
+        /* (in detail, this variable will contain PDU type, PDU reserved field, */
+        /* PDU length, PDV length, presentation context ID, message control header) */
+        /* (note that our representation of a PDU can only contain one PDV.) */
+        OFCondition cond = streamDataPDUHead(&pdus[i], heads[i], sizeof(heads[i]), &length);
+        if (cond.bad()) return cond;
 
-    /* if not all head information was sent, return an error */
-    if ((unsigned long) nbytes != length)
-    {
-        OFString msg = "TCP I/O Error (";
-        msg += OFStandard::getLastNetworkErrorCode().message();
-        msg += ") occurred in routine: writeDataPDU";
-        return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, msg.c_str());
+        /* the PDU head is followed by the PDU's PDV data */
+        buffers[2 * i] = heads[i];
+        lengths[2 * i] = length;
+        buffers[2 * i + 1] = pdus[i].presentationDataValue.data;
+        lengths[2 * i + 1] = pdus[i].presentationDataValue.length - 2;
+        total += length + pdus[i].presentationDataValue.length - 2;
     }
 
-    /* send the PDU's PDV data (note that our representation of a PDU can only contain one PDV.) */
+    /* send the PDU heads and data */
     do
     {
-      nbytes = (*association)->connection ? (*association)->connection->write((char*)pdu->presentationDataValue.data,
-        size_t(pdu->presentationDataValue.length - 2)) : 0;
+      nbytes = (*association)->connection ? (*association)->connection->writeGathered(buffers, lengths, 2 * count) : 0;
     } while (nbytes == -1 && OFStandard::getLastNetworkErrorCode().value() == DCMNET_EINTR);
 
-        /* if not all head information was sent, return an error */
-    if ((unsigned long) nbytes != pdu->presentationDataValue.length - 2)
+    /* if not all information was sent, return an error */
+    if ((unsigned long) nbytes != total)
     {
         OFString msg = "TCP I/O Error (";
         msg += OFStandard::getLastNetworkErrorCode().message();
-        msg += ") occurred in routine: writeDataPDU";
+        msg += ") occurred in routine: writeDataPDUs";
         return makeDcmnetCondition(DULC_TCPIOERROR, OF_error, msg.c_str());
     }
 
+    /* update the transfer statistics of the association */
+    (*association)->dataPDUsSent += count;
+    (*association)->dataBytesSent += total;
+
     /* return ok */
     return EC_Normal;
 }
@@ -3766,59 +3767,6 @@ dump_pdu(const char *type, void *buffer, unsigned long length)
 
 
 
-/* setTCPBufferLength
-**
-** Purpose:
-**      This routine checks for the existence of an environment
-**      variable (TCP_BUFFER_LENGTH).  If that variable is defined (and
-**      is a legal integer), this routine sets the socket SNDBUF and RCVBUF
-**      variables to the value defined in TCP_BUFFER_LENGTH.
-**
-** Parameter Dictionary:
-**      sock            Socket descriptor (identifier)
-**
-** Return Values:
-**      None
-**
-** Notes:
-**
-** Algorithm:
-**      Description of the algorithm (optional) and any other notes.
-*/
-
-#ifdef _WIN32
-static void setTCPBufferLength(SOCKET sock)
-#else
-static void setTCPBufferLength(int sock)
-#endif
-{
-    char *TCPBufferLength;
-    int bufLen;
-
-    /*
-     * check whether environment variable TCP_BUFFER_LENGTH is set.
-     * If not, the the operating system is responsible for selecting
-     * appropriate values for the TCP send and receive buffer lengths.
-     */
-    DCMNET_TRACE("checking whether environment variable TCP_BUFFER_LENGTH is set");
-    if ((TCPBufferLength = getenv("TCP_BUFFER_LENGTH")) != NULL) {
-        if (sscanf(TCPBufferLength, "%d", &bufLen) == 1) {
-#if defined(SO_SNDBUF) && defined(SO_RCVBUF)
-            if (bufLen == 0)
-                bufLen = 65536; // a socket buffer size of 64K gives good throughput for image transmission
-            DCMNET_DEBUG("DULFSM: setting TCP buffer length to " << bufLen << " bytes");
-            (void) setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *) &bufLen, sizeof(bufLen));
-            (void) setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &bufLen, sizeof(bufLen));
-#else
-            DCMNET_WARN("DULFSM: setTCPBufferLength: cannot set TCP buffer length socket option: "
-                << "code disabled because SO_SNDBUF and SO_RCVBUF constants are unknown");
-#endif // SO_SNDBUF and SO_RCVBUF
-        } else
-            DCMNET_WARN("DULFSM: cannot parse environment variable TCP_BUFFER_LENGTH=" << TCPBufferLength);
-    } else
-        DCMNET_TRACE("  environment variable TCP_BUFFER_LENGTH not set, using the system defaults");
-}
-
 /* translatePresentationContextList
 **
 ** Purpose:
@@ -89,6 +89,9 @@ parseUserInfo(DUL_USERINFO * userInfo,
 static OFCondition
 parseMaxPDU(DUL_MAXLENGTH * max, unsigned char *buf,
             unsigned long *itemLength, unsigned long availData);
+static OFCondition
+parseAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *buf,
+            unsigned long *itemLength, unsigned long availData);
 static OFCondition
     parseDummy(unsigned char *buf, unsigned long *itemLength,
             unsigned long availData);
@@ -514,7 +517,7 @@ parseUserInfo(DUL_USERINFO * userInfo,
             break;
 
         case DUL_TYPEASYNCOPERATIONS:
-            cond = parseDummy(buf, &length, userLength);
+            cond = parseAsyncOperations(&userInfo->asyncOperations, buf, &length, userLength);
             if (cond.bad())
                 return cond;
             buf += length;
@@ -641,6 +644,54 @@ parseMaxPDU(DUL_MAXLENGTH * max, unsigned char *buf,
     return EC_Normal;
 }
 
+/* parseAsyncOperations
+**
+** Purpose:
+**      Parse the buffer and extract the Asynchronous Operations Window structure.
+**
+** Parameter Dictionary:
+**      async           The structure to hold the Asynchronous Operations Window item
+**      buf             The buffer that is to be parsed (input/output value)
+**      itemLength      Length of structure extracted (output value)
+**      availData       Number of bytes announced to be available for this sub item (input value)
+**
+** Return Values:
+**
+** Notes:
+**
+** Algorithm:
+**      Description of the algorithm (optional) and any other notes.
+*/
+static OFCondition
+parseAsyncOperations(PRV_ASYNCOPERATIONS * async, unsigned char *buf,
+            unsigned long *itemLength, unsigned long availData)
+{
+    // We want to read 8 bytes of data, is there enough data?
+    if (availData < 8)
+        return makeLengthError("asynchronous operations window", availData, 8);
+
+    async->type = *buf++;
+    async->rsv1 = *buf++;
+    EXTRACT_SHORT_BIG(buf, async->length);
+    buf += 2;
+    EXTRACT_SHORT_BIG(buf, async->maximumOperationsInvoked);
+    buf += 2;
+    EXTRACT_SHORT_BIG(buf, async->maximumOperationsProvided);
+    *itemLength = 2 + 2 + async->length;
+
+    if (async->length != 4)
+        DCMNET_WARN("Invalid length (" << async->length << ") for asynchronous operations window item, must be 4");
+
+    // Is there less data than the length field claims there is?
+    if (availData - 4 < async->length)
+        return makeLengthError("asynchronous operations window", availData, 0, async->length);
+
+    DCMNET_TRACE("Maximum Operations Invoked: " << async->maximumOperationsInvoked
+        << ", Maximum Operations Performed: " << async->maximumOperationsProvided);
+
+    return EC_Normal;
+}
+
 /* parseDummy
 **
 ** Purpose:
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2010, OFFIS e.V.
+ *  Copyright (C) 1994-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -108,6 +108,9 @@ OFCondition
 parseAssociate(unsigned char *buf, unsigned long len,
 	       PRV_ASSOCIATEPDU * pdu);
 OFCondition
+PRV_ApplySocketOptions(DcmNativeSocketType sock,
+		       const DUL_SOCKETOPTIONS * options, const char *caller);
+OFCondition
 PRV_NextPDUType(PRIVATE_ASSOCIATIONKEY ** association,
 		DUL_BLOCKOPTIONS block, int timeout, unsigned char *type);
 
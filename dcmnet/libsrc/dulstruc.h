@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1994-2017, OFFIS e.V.
+ *  Copyright (C) 1994-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were partly developed by
@@ -105,6 +105,7 @@ typedef struct {
       int tLayerOwned;
   }   TCP;
     }   networkSpecific;
+    DUL_SOCKETOPTIONS socketOptions;
 }   PRIVATE_NETWORKKEY;
 
 typedef struct {
@@ -147,6 +148,10 @@ typedef struct {
     unsigned long fragmentBufferLength;
     unsigned char *fragmentBuffer;
     DUL_ModeCallback *modeCallback;
+    unsigned long dataPDUsSent;
+    unsigned long dataPDUsReceived;
+    Uint64 dataBytesSent;
+    Uint64 dataBytesReceived;
 }   PRIVATE_ASSOCIATIONKEY;
 
 #define KEY_NETWORK "KEY NETWORK"
@@ -238,7 +243,7 @@ typedef struct user_info {
     unsigned char rsv1;
     unsigned short length;
     DUL_MAXLENGTH maxLength;                             // 51H: maximum length
-    PRV_ASYNCOPERATIONS asyncOperations;                 // 53H: async operations (not yet implemented!)
+    PRV_ASYNCOPERATIONS asyncOperations;                 // 53H: asynchronous operations window
     DUL_SUBITEM implementationClassUID;                  // 52H: implementation class UID
     DUL_SUBITEM implementationVersionName;               // 55H: implementation version name
     LST_HEAD *SCUSCPRoleList;                            // 54H: SCP/SCU role selection
@@ -0,0 +1,443 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Classes collecting latency and throughput metrics of
+ *           associations and DIMSE messages
+ *
+ */
+
+#include "dcmtk/config/osconfig.h" /* make sure OS specific configuration is included first */
+
+#include "dcmtk/dcmnet/netmetr.h"
+#include "dcmtk/ofstd/ofstd.h"
+
+
+/* ------------------------------------------------------------------------- */
+
+// write a floating point value independent of the current locale
+static void writeSeconds(STD_NAMESPACE ostream& out, const double value)
+{
+  char buf[64];
+  OFStandard::ftoa(buf, sizeof(buf), value, OFStandard::ftoa_format_f, 0, 6);
+  out << buf;
+}
+
+
+// write a string value with the escape sequences needed for Prometheus labels and JSON
+static void writeEscaped(STD_NAMESPACE ostream& out, const OFString& value)
+{
+  for (size_t i = 0; i < value.length(); ++i)
+  {
+    const char c = value.at(i);
+    if ((c == '"') || (c == '\\'))
+      out << '\\' << c;
+    else if (c == '\n')
+      out << "\\n";
+    else if (OFstatic_cast(unsigned char, c) >= 0x20)
+      out << c;
+  }
+}
+
+
+// write the labels identifying the peer of aggregated association metrics
+static void writeLabels(STD_NAMESPACE ostream& out, const DcmAssociationMetrics& metrics)
+{
+  out << "{role=\"" << (metrics.requestor ? "requestor" : "acceptor") << "\",our_ae=\"";
+  writeEscaped(out, metrics.ourAETitle);
+  out << "\",peer_ae=\"";
+  writeEscaped(out, metrics.peerAETitle);
+  out << "\",peer_address=\"";
+  writeEscaped(out, metrics.peerAddress);
+  out << "\"}";
+}
+
+
+// write the Prometheus metrics of one kind of operations for all peers
+static void writePrometheusOperation(STD_NAMESPACE ostream& out,
+                                     const OFList<DcmAssociationMetrics>& peers,
+                                     DcmNetworkOperationMetrics DcmAssociationMetrics::* member,
+                                     const char* name,
+                                     const char* description,
+                                     const OFBool withBytes)
+{
+  OFListConstIterator(DcmAssociationMetrics) it;
+  out << "# HELP dcmnet_" << name << "_total Number of " << description << "\n"
+      << "# TYPE dcmnet_" << name << "_total counter\n";
+  for (it = peers.begin(); it != peers.end(); ++it)
+  {
+    out << "dcmnet_" << name << "_total";
+    writeLabels(out, *it);
+    out << " " << ((*it).*member).count << "\n";
+  }
+  out << "# HELP dcmnet_" << name << "_seconds_total Total duration of " << description << "\n"
+      << "# TYPE dcmnet_" << name << "_seconds_total counter\n";
+  for (it = peers.begin(); it != peers.end(); ++it)
+  {
+    out << "dcmnet_" << name << "_seconds_total";
+    writeLabels(out, *it);
+    out << " ";
+    writeSeconds(out, ((*it).*member).totalTime);
+    out << "\n";
+  }
+  out << "# HELP dcmnet_" << name << "_seconds_max Maximum duration of " << description << "\n"
+      << "# TYPE dcmnet_" << name << "_seconds_max gauge\n";
+  for (it = peers.begin(); it != peers.end(); ++it)
+  {
+    out << "dcmnet_" << name << "_seconds_max";
+    writeLabels(out, *it);
+    out << " ";
+    writeSeconds(out, ((*it).*member).maxTime);
+    out << "\n";
+  }
+  if (withBytes)
+  {
+    out << "# HELP dcmnet_" << name << "_bytes_total Number of bytes of " << description << "\n"
+        << "# TYPE dcmnet_" << name << "_bytes_total counter\n";
+    for (it = peers.begin(); it != peers.end(); ++it)
+    {
+      out << "dcmnet_" << name << "_bytes_total";
+      writeLabels(out, *it);
+      out << " " << ((*it).*member).bytes << "\n";
+    }
+  }
+}
+
+
+// write the Prometheus metrics of one counter for all peers
+static void writePrometheusCounter(STD_NAMESPACE ostream& out,
+                                   const OFList<DcmAssociationMetrics>& peers,
+                                   Uint64 DcmAssociationMetrics::* member,
+                                   const char* name,
+                                   const char* description)
+{
+  out << "# HELP dcmnet_" << name << "_total Number of " << description << "\n"
+      << "# TYPE dcmnet_" << name << "_total counter\n";
+  for (OFListConstIterator(DcmAssociationMetrics) it = peers.begin(); it != peers.end(); ++it)
+  {
+    out << "dcmnet_" << name << "_total";
+    writeLabels(out, *it);
+    out << " " << (*it).*member << "\n";
+  }
+}
+
+
+// write the statistics of one kind of operations as a JSON object
+static void writeJSONOperation(STD_NAMESPACE ostream& out,
+                               const DcmNetworkOperationMetrics& metrics,
+                               const OFBool withBytes)
+{
+  out << "{\"count\":" << metrics.count;
+  if (withBytes)
+    out << ",\"bytes\":" << metrics.bytes;
+  out << ",\"seconds\":";
+  writeSeconds(out, metrics.totalTime);
+  out << ",\"maxSeconds\":";
+  writeSeconds(out, metrics.maxTime);
+  out << "}";
+}
+
+
+/* ------------------------------------------------------------------------- */
+
+DcmNetworkOperationMetrics::DcmNetworkOperationMetrics()
+: count(0)
+, bytes(0)
+, totalTime(0.0)
+, maxTime(0.0)
+{
+}
+
+
+void DcmNetworkOperationMetrics::add(const Uint64 numBytes,
+                                     const double seconds)
+{
+  ++count;
+  bytes += numBytes;
+  totalTime += seconds;
+  if (seconds > maxTime)
+    maxTime = seconds;
+}
+
+
+void DcmNetworkOperationMetrics::merge(const DcmNetworkOperationMetrics& other)
+{
+  count += other.count;
+  bytes += other.bytes;
+  totalTime += other.totalTime;
+  if (other.maxTime > maxTime)
+    maxTime = other.maxTime;
+}
+
+
+/* ------------------------------------------------------------------------- */
+
+DcmAssociationMetrics::DcmAssociationMetrics()
+: requestor(OFFalse)
+, ourAETitle()
+, peerAETitle()
+, peerAddress()
+, associations(0)
+, startTime(0.0)
+, negotiationStartTime(0.0)
+, negotiation()
+, lifetime()
+, commandsSent()
+, datasetsSent()
+, commandsReceived()
+, datasetsReceived()
+, commandsHandled()
+, pdusSent(0)
+, pduBytesSent(0)
+, pdusReceived(0)
+, pduBytesReceived(0)
+{
+}
+
+
+void DcmAssociationMetrics::merge(const DcmAssociationMetrics& other)
+{
+  associations += other.associations;
+  negotiation.merge(other.negotiation);
+  lifetime.merge(other.lifetime);
+  commandsSent.merge(other.commandsSent);
+  datasetsSent.merge(other.datasetsSent);
+  commandsReceived.merge(other.commandsReceived);
+  datasetsReceived.merge(other.datasetsReceived);
+  commandsHandled.merge(other.commandsHandled);
+  pdusSent += other.pdusSent;
+  pduBytesSent += other.pduBytesSent;
+  pdusReceived += other.pdusReceived;
+  pduBytesReceived += other.pduBytesReceived;
+}
+
+
+/* ------------------------------------------------------------------------- */
+
+DcmNetworkMetrics& DcmNetworkMetrics::instance()
+{
+  static DcmNetworkMetrics instance_;
+  return instance_;
+}
+
+
+/* the constructor of this global object makes sure that the registry is
+ * created before main starts, i.e. before any thread can access it.
+ */
+static class DcmNetworkMetricsInitializer
+{
+public:
+  DcmNetworkMetricsInitializer()
+  {
+    DcmNetworkMetrics::instance();
+  }
+} dcmNetworkMetricsInitializer;
+
+
+DcmNetworkMetrics::DcmNetworkMetrics()
+: m_mutex()
+, m_enabled(OFFalse)
+, m_peers()
+, m_queueWait()
+, m_listeners()
+, m_notifyMutex()
+{
+}
+
+
+void DcmNetworkMetrics::setEnabled(const OFBool enabled)
+{
+  m_mutex.lock();
+  m_enabled = enabled;
+  m_mutex.unlock();
+}
+
+
+OFBool DcmNetworkMetrics::isEnabled() const
+{
+  m_mutex.lock();
+  const OFBool result = m_enabled;
+  m_mutex.unlock();
+  return result;
+}
+
+
+void DcmNetworkMetrics::addListener(DcmNetworkMetricsListener* listener)
+{
+  if (listener == NULL)
+    return;
+  m_mutex.lock();
+  m_listeners.push_back(listener);
+  m_mutex.unlock();
+}
+
+
+void DcmNetworkMetrics::removeListener(DcmNetworkMetricsListener* listener)
+{
+  // make sure that the listener is not called anymore when this method returns
+  m_notifyMutex.lock();
+  m_mutex.lock();
+  m_listeners.remove(listener);
+  m_mutex.unlock();
+  m_notifyMutex.unlock();
+}
+
+
+void DcmNetworkMetrics::addAssociation(const DcmAssociationMetrics& metrics)
+{
+  m_notifyMutex.lock();
+  m_mutex.lock();
+  OFListIterator(DcmAssociationMetrics) it = m_peers.begin();
+  while ((it != m_peers.end()) && !(((*it).requestor == metrics.requestor) &&
+    ((*it).ourAETitle == metrics.ourAETitle) && ((*it).peerAETitle == metrics.peerAETitle) &&
+    ((*it).peerAddress == metrics.peerAddress)))
+  {
+    ++it;
+  }
+  if (it == m_peers.end())
+  {
+    DcmAssociationMetrics peer;
+    peer.requestor = metrics.requestor;
+    peer.ourAETitle = metrics.ourAETitle;
+    peer.peerAETitle = metrics.peerAETitle;
+    peer.peerAddress = metrics.peerAddress;
+    it = m_peers.insert(m_peers.end(), peer);
+  }
+  (*it).merge(metrics);
+  const OFList<DcmNetworkMetricsListener*> listeners = m_listeners;
+  m_mutex.unlock();
+  // the listeners are notified outside of the lock, so they can access the registry
+  for (OFListConstIterator(DcmNetworkMetricsListener*) l = listeners.begin(); l != listeners.end(); ++l)
+    (*l)->notifyAssociationMetrics(metrics);
+  m_notifyMutex.unlock();
+}
+
+
+void DcmNetworkMetrics::addQueueWait(const double seconds)
+{
+  m_mutex.lock();
+  m_queueWait.add(0, seconds);
+  m_mutex.unlock();
+}
+
+
+DcmAssociationMetrics DcmNetworkMetrics::getTotals() const
+{
+  DcmAssociationMetrics result;
+  m_mutex.lock();
+  for (OFListConstIterator(DcmAssociationMetrics) it = m_peers.begin(); it != m_peers.end(); ++it)
+    result.merge(*it);
+  m_mutex.unlock();
+  return result;
+}
+
+
+DcmNetworkOperationMetrics DcmNetworkMetrics::getQueueWait() const
+{
+  m_mutex.lock();
+  const DcmNetworkOperationMetrics result = m_queueWait;
+  m_mutex.unlock();
+  return result;
+}
+
+
+OFList<DcmAssociationMetrics> DcmNetworkMetrics::getPeerMetrics() const
+{
+  m_mutex.lock();
+  const OFList<DcmAssociationMetrics> result = m_peers;
+  m_mutex.unlock();
+  return result;
+}
+
+
+void DcmNetworkMetrics::reset()
+{
+  m_mutex.lock();
+  m_peers.clear();
+  m_queueWait = DcmNetworkOperationMetrics();
+  m_mutex.unlock();
+}
+
+
+void DcmNetworkMetrics::writePrometheus(STD_NAMESPACE ostream& out) const
+{
+  const OFList<DcmAssociationMetrics> peers = getPeerMetrics();
+  const DcmNetworkOperationMetrics queueWait = getQueueWait();
+  writePrometheusCounter(out, peers, &DcmAssociationMetrics::associations, "associations", "associations");
+  writePrometheusOperation(out, peers, &DcmAssociationMetrics::negotiation, "association_negotiation", "association negotiations", OFFalse);
+  writePrometheusOperation(out, peers, &DcmAssociationMetrics::lifetime, "association_lifetime", "associations (lifetime)", OFFalse);
+  writePrometheusOperation(out, peers, &DcmAssociationMetrics::commandsSent, "commands_sent", "DIMSE commands sent", OFTrue);
+  writePrometheusOperation(out, peers, &DcmAssociationMetrics::datasetsSent, "datasets_sent", "datasets sent", OFTrue);
+  writePrometheusOperation(out, peers, &DcmAssociationMetrics::commandsReceived, "commands_received", "DIMSE commands received", OFTrue);
+  writePrometheusOperation(out, peers, &DcmAssociationMetrics::datasetsReceived, "datasets_received", "datasets received", OFTrue);
+  writePrometheusOperation(out, peers, &DcmAssociationMetrics::commandsHandled, "commands_handled", "DIMSE commands handled", OFFalse);
+  writePrometheusCounter(out, peers, &DcmAssociationMetrics::pdusSent, "pdus_sent", "P-DATA-TF PDUs sent");
+  writePrometheusCounter(out, peers, &DcmAssociationMetrics::pduBytesSent, "pdu_bytes_sent", "bytes sent in P-DATA-TF PDUs");
+  writePrometheusCounter(out, peers, &DcmAssociationMetrics::pdusReceived, "pdus_received", "P-DATA-TF PDUs received");
+  writePrometheusCounter(out, peers, &DcmAssociationMetrics::pduBytesReceived, "pdu_bytes_received", "bytes received in P-DATA-TF PDUs");
+  out << "# HELP dcmnet_queue_wait_total Number of waits for a worker thread\n"
+      << "# TYPE dcmnet_queue_wait_total counter\n"
+      << "dcmnet_queue_wait_total " << queueWait.count << "\n"
+      << "# HELP dcmnet_queue_wait_seconds_total Total time waited for a worker thread\n"
+      << "# TYPE dcmnet_queue_wait_seconds_total counter\n"
+      << "dcmnet_queue_wait_seconds_total ";
+  writeSeconds(out, queueWait.totalTime);
+  out << "\n"
+      << "# HELP dcmnet_queue_wait_seconds_max Maximum time waited for a worker thread\n"
+      << "# TYPE dcmnet_queue_wait_seconds_max gauge\n"
+      << "dcmnet_queue_wait_seconds_max ";
+  writeSeconds(out, queueWait.maxTime);
+  out << "\n";
+}
+
+
+void DcmNetworkMetrics::writeJSON(STD_NAMESPACE ostream& out) const
+{
+  const OFList<DcmAssociationMetrics> peers = getPeerMetrics();
+  const DcmNetworkOperationMetrics queueWait = getQueueWait();
+  out << "{\"queueWait\":";
+  writeJSONOperation(out, queueWait, OFFalse);
+  out << ",\"peers\":[";
+  for (OFListConstIterator(DcmAssociationMetrics) it = peers.begin(); it != peers.end(); ++it)
+  {
+    if (it != peers.begin())
+      out << ",";
+    out << "{\"role\":\"" << ((*it).requestor ? "requestor" : "acceptor") << "\",\"ourAETitle\":\"";
+    writeEscaped(out, (*it).ourAETitle);
+    out << "\",\"peerAETitle\":\"";
+    writeEscaped(out, (*it).peerAETitle);
+    out << "\",\"peerAddress\":\"";
+    writeEscaped(out, (*it).peerAddress);
+    out << "\",\"associations\":" << (*it).associations << ",\"negotiation\":";
+    writeJSONOperation(out, (*it).negotiation, OFFalse);
+    out << ",\"lifetime\":";
+    writeJSONOperation(out, (*it).lifetime, OFFalse);
+    out << ",\"commandsSent\":";
+    writeJSONOperation(out, (*it).commandsSent, OFTrue);
+    out << ",\"datasetsSent\":";
+    writeJSONOperation(out, (*it).datasetsSent, OFTrue);
+    out << ",\"commandsReceived\":";
+    writeJSONOperation(out, (*it).commandsReceived, OFTrue);
+    out << ",\"datasetsReceived\":";
+    writeJSONOperation(out, (*it).datasetsReceived, OFTrue);
+    out << ",\"commandsHandled\":";
+    writeJSONOperation(out, (*it).commandsHandled, OFFalse);
+    out << ",\"pdusSent\":" << (*it).pdusSent << ",\"pduBytesSent\":" << (*it).pduBytesSent
+        << ",\"pdusReceived\":" << (*it).pdusReceived << ",\"pduBytesReceived\":" << (*it).pduBytesReceived
+        << "}";
+  }
+  out << "]}" << OFendl;
+}
@@ -25,6 +25,7 @@
 #include "dcmtk/dcmnet/assoc.h"
 #include "dcmtk/dcmnet/scp.h"
 #include "dcmtk/dcmtls/tlslayer.h"
+#include "dcmtk/ofstd/oftimer.h"
 
 // ----------------------------------------------------------------------------
 
@@ -113,7 +114,7 @@ OFCondition DcmSCP::openListenPort()
         return result;
 
     // Initialize network, i.e. create an instance of T_ASC_Network*.
-    cond = ASC_initializeNetwork(NET_ACCEPTOR, OFstatic_cast(int, m_cfg->getPort()), m_cfg->getACSETimeout(), &m_network);
+    cond = ASC_initializeNetwork(NET_ACCEPTOR, OFstatic_cast(int, m_cfg->getPort()), m_cfg->getACSETimeout(), &m_network, m_cfg->getSocketOptions());
     if (cond.bad())
     {
         m_network = NULL;
@@ -423,6 +424,21 @@ OFCondition DcmSCP::waitForAssociationRQ(T_ASC_Network* network)
 
 OFCondition DcmSCP::processAssociationRQ()
 {
+    OFBool acknowledged = OFFalse;
+    OFCondition cond = respondToAssociationRQ(acknowledged);
+
+    // Go ahead and handle the association (i.e. handle the caller's requests) in this process
+    if (cond.good() && acknowledged)
+        handleAssociation();
+
+    return cond;
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmSCP::respondToAssociationRQ(OFBool& acknowledged)
+{
+    acknowledged = OFFalse;
     DcmSCPActionType desiredAction = DCMSCP_ACTION_UNDEFINED;
     if ((m_assoc == NULL) || (m_assoc->params == NULL))
         return ASC_NULLKEY;
@@ -529,9 +545,7 @@ OFCondition DcmSCP::processAssociationRQ()
     else
         DCMNET_DEBUG(ASC_dumpParameters(tempStr, m_assoc->params, ASC_ASSOC_AC));
 
-    // Go ahead and handle the association (i.e. handle the caller's requests) in this process
-    handleAssociation();
-
+    acknowledged = OFTrue;
     return EC_Normal;
 }
 
@@ -550,6 +564,23 @@ OFCondition DcmSCP::negotiateAssociation()
         OFString tempStr;
         DCMNET_ERROR(DimseCondition::dump(tempStr, result));
     }
+    else
+    {
+        // Acknowledge asynchronous operations window (if proposed by the SCU). The number
+        // of operations invoked by the SCU is limited by our configuration (0 = unlimited),
+        // while the SCP itself never invokes operations asynchronously.
+        Uint16 maxOpsInvoked = 1;
+        Uint16 maxOpsPerformed = 1;
+        ASC_getPeerAsyncOperationsWindow(m_assoc->params, &maxOpsInvoked, &maxOpsPerformed);
+        if ((maxOpsInvoked != 1) || (maxOpsPerformed != 1))
+        {
+            const Uint16 maxOps = m_cfg->getMaxOperationsPerformed();
+            if ((maxOpsInvoked == 0) || ((maxOps != 0) && (maxOps < maxOpsInvoked)))
+                maxOpsInvoked = maxOps;
+            ASC_setAsyncOperationsWindow(m_assoc->params, maxOpsInvoked, 1);
+            DCMNET_DEBUG("Asynchronous Operations Window acknowledged: " << maxOpsInvoked << "/1");
+        }
+    }
     return result;
 }
 
@@ -587,31 +618,56 @@ void DcmSCP::handleAssociation()
         return;
     }
 
-    // Receive a DIMSE command and perform all the necessary actions. (Note that ReceiveAndHandleCommands()
-    // will always return a value 'cond' for which 'cond.bad()' will be true. This value indicates that either
+    // Receive a DIMSE command and perform all the necessary actions. (Note that the loop will always
+    // end with a value 'cond' for which 'cond.bad()' will be true. This value indicates that either
     // some kind of error occurred, or that the peer aborted the association (DUL_PEERABORTEDASSOCIATION),
-    // or that the peer requested the release of the association (DUL_PEERREQUESTEDRELEASE).) (Also note
-    // that ReceiveAndHandleCommands() will never return EC_Normal.)
+    // or that the peer requested the release of the association (DUL_PEERREQUESTEDRELEASE).)
     OFCondition cond = EC_Normal;
-    T_DIMSE_Message message;
-    T_ASC_PresentationContextID presID;
 
     // start a loop to be able to receive more than one DIMSE command
     while (cond.good())
-    {
-        // receive a DIMSE command over the network
-        cond = DIMSE_receiveCommand(
-            m_assoc, m_cfg->getDIMSEBlockingMode(), m_cfg->getDIMSETimeout(), &presID, &message, NULL);
+        cond = receiveAndHandleCommand();
 
-        // check if peer did release or abort, or if we have a valid message
-        if (cond.good())
-        {
-            DcmPresentationContextInfo presInfo;
-            getPresentationContextInfo(m_assoc, presID, presInfo);
-            cond = handleIncomingCommand(&message, presInfo);
-        }
-    }
     // Clean up on association termination.
+    handleAssociationTermination(cond);
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmSCP::receiveAndHandleCommand()
+{
+    if (m_assoc == NULL)
+        return DIMSE_ILLEGALASSOCIATION;
+
+    T_DIMSE_Message message;
+    T_ASC_PresentationContextID presID;
+
+    // receive a DIMSE command over the network
+    OFCondition cond = DIMSE_receiveCommand(
+        m_assoc, m_cfg->getDIMSEBlockingMode(), m_cfg->getDIMSETimeout(), &presID, &message, NULL);
+
+    // check if peer did release or abort, or if we have a valid message
+    if (cond.good())
+    {
+        DcmPresentationContextInfo presInfo;
+        getPresentationContextInfo(m_assoc, presID, presInfo);
+        const double startTime = OFTimer::getTime();
+        cond = handleIncomingCommand(&message, presInfo);
+        // update the metrics of the association (if collected)
+        if ((m_assoc != NULL) && (m_assoc->metrics != NULL))
+            m_assoc->metrics->commandsHandled.add(0, OFTimer::getDiff(startTime));
+    }
+    return cond;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmSCP::handleAssociationTermination(const OFCondition& cond,
+                                          const OFBool waitForClose)
+{
+    if (m_assoc == NULL)
+        return;
+
     if (cond == DUL_PEERREQUESTEDRELEASE)
     {
         notifyReleaseRequest();
@@ -624,7 +680,7 @@ void DcmSCP::handleAssociation()
     else
     {
         notifyDIMSEError(cond);
-        ASC_abortAssociation(m_assoc);
+        ASC_abortAssociation(m_assoc, waitForClose);
     }
 }
 
@@ -777,6 +833,15 @@ OFCondition DcmSCP::receiveSTORERequest(T_DIMSE_C_StoreRQ& reqMessage,
 OFCondition DcmSCP::receiveSTORERequest(T_DIMSE_C_StoreRQ& reqMessage,
                                         const T_ASC_PresentationContextID presID,
                                         const OFString& filename)
+{
+    return receiveSTORERequest(reqMessage, presID, filename, NULL /* headerAttributes */);
+}
+
+OFCondition DcmSCP::receiveSTORERequest(T_DIMSE_C_StoreRQ& reqMessage,
+                                        const T_ASC_PresentationContextID presID,
+                                        const OFString& filename,
+                                        DcmDataset* headerAttributes,
+                                        const DcmTagKey& stopParsingAtElement)
 {
     // Do some basic validity checks
     if (m_assoc == NULL)
@@ -802,7 +867,7 @@ OFCondition DcmSCP::receiveSTORERequest(T_DIMSE_C_StoreRQ& reqMessage,
     }
 
     // Receive dataset (directly to file)
-    cond = receiveSTORERequestDataset(&presIDdset, reqMessage, filename);
+    cond = receiveSTORERequestDataset(&presIDdset, reqMessage, filename, headerAttributes, stopParsingAtElement);
     if (cond.bad())
     {
         DCMNET_DEBUG(DIMSE_dumpMessage(tempStr, reqMessage, DIMSE_INCOMING, NULL, presID));
@@ -1623,7 +1688,9 @@ OFCondition DcmSCP::receiveDIMSEDataset(T_ASC_PresentationContextID* presID, Dcm
 // (and store it directly to file)
 OFCondition DcmSCP::receiveSTORERequestDataset(T_ASC_PresentationContextID* presID,
                                                T_DIMSE_C_StoreRQ& reqMessage,
-                                               const OFString& filename)
+                                               const OFString& filename,
+                                               DcmDataset* headerAttributes,
+                                               const DcmTagKey& stopParsingAtElement)
 {
     if (m_assoc == NULL)
         return DIMSE_ILLEGALASSOCIATION;
@@ -1637,6 +1704,8 @@ OFCondition DcmSCP::receiveSTORERequestDataset(T_ASC_PresentationContextID* pres
         = DIMSE_createFilestream(filename, &reqMessage, m_assoc, *presID, OFTrue /*writeMetaheader*/, &filestream);
     if (cond.good())
     {
+        // Reserve disk space while receiving (if enabled)
+        filestream->setPreallocationChunkSize(m_cfg->getPreallocationChunkSize());
         if (m_cfg->getProgressNotificationMode())
         {
             cond = DIMSE_receiveDataSetInFile(m_assoc,
@@ -1645,7 +1714,9 @@ OFCondition DcmSCP::receiveSTORERequestDataset(T_ASC_PresentationContextID* pres
                                               presID,
                                               filestream,
                                               callbackRECEIVEProgress,
-                                              this /*callbackData*/);
+                                              this /*callbackData*/,
+                                              headerAttributes,
+                                              stopParsingAtElement);
         }
         else
         {
@@ -1655,7 +1726,9 @@ OFCondition DcmSCP::receiveSTORERequestDataset(T_ASC_PresentationContextID* pres
                                               presID,
                                               filestream,
                                               NULL /*callback*/,
-                                              NULL /*callbackData*/);
+                                              NULL /*callbackData*/,
+                                              headerAttributes,
+                                              stopParsingAtElement);
         }
         delete filestream;
         if (cond.good())
@@ -1893,6 +1966,20 @@ void DcmSCP::setProgressNotificationMode(const OFBool mode)
 
 // ----------------------------------------------------------------------------
 
+void DcmSCP::setMaxOperationsPerformed(const Uint16 maxOps)
+{
+    m_cfg->setMaxOperationsPerformed(maxOps);
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmSCP::setPreallocationChunkSize(const Uint32 chunkSize)
+{
+    m_cfg->setPreallocationChunkSize(chunkSize);
+}
+
+// ----------------------------------------------------------------------------
+
 void DcmSCP::setAlwaysAcceptDefaultRole(const OFBool enabled)
 {
     m_cfg->setAlwaysAcceptDefaultRole(enabled);
@@ -1993,6 +2080,20 @@ OFBool DcmSCP::getProgressNotificationMode() const
 
 // ----------------------------------------------------------------------------
 
+Uint16 DcmSCP::getMaxOperationsPerformed() const
+{
+    return m_cfg->getMaxOperationsPerformed();
+}
+
+// ----------------------------------------------------------------------------
+
+Uint32 DcmSCP::getPreallocationChunkSize() const
+{
+    return m_cfg->getPreallocationChunkSize();
+}
+
+// ----------------------------------------------------------------------------
+
 OFBool DcmSCP::isConnected() const
 {
     return (m_assoc != NULL) && (m_assoc->DULassociation != NULL);
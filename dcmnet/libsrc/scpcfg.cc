@@ -40,6 +40,9 @@ DcmSCPConfig::DcmSCPConfig() :
   m_connectionTimeout(1000),
   m_respondWithCalledAETitle(OFTrue),
   m_progressNotificationMode(OFTrue),
+  m_maxOperationsPerformed(1),   // no asynchronous operations, i.e. as if not negotiated
+  m_preallocationChunkSize(0),
+  m_socketOptions(),
   m_tLayer(NULL)
 {
 }
@@ -67,7 +70,10 @@ DcmSCPConfig::DcmSCPConfig(const DcmSCPConfig &old) :
   m_verbosePCMode(old.m_verbosePCMode),
   m_connectionTimeout(old.m_connectionTimeout),
   m_respondWithCalledAETitle(old.m_respondWithCalledAETitle),
-  m_progressNotificationMode(old.m_progressNotificationMode)
+  m_progressNotificationMode(old.m_progressNotificationMode),
+  m_maxOperationsPerformed(old.m_maxOperationsPerformed),
+  m_preallocationChunkSize(old.m_preallocationChunkSize),
+  m_socketOptions(old.m_socketOptions)
 {
   // nothing more to do
 }
@@ -93,6 +99,9 @@ DcmSCPConfig& DcmSCPConfig::operator=(const DcmSCPConfig &obj)
     m_connectionTimeout = obj.m_connectionTimeout;
     m_respondWithCalledAETitle = obj.m_respondWithCalledAETitle;
     m_progressNotificationMode = obj.m_progressNotificationMode;
+    m_maxOperationsPerformed = obj.m_maxOperationsPerformed;
+    m_preallocationChunkSize = obj.m_preallocationChunkSize;
+    m_socketOptions = obj.m_socketOptions;
   }
   return *this;
 }
@@ -204,6 +213,27 @@ void DcmSCPConfig::setAlwaysAcceptDefaultRole(const OFBool enabled)
 
 // ----------------------------------------------------------------------------
 
+void DcmSCPConfig::setMaxOperationsPerformed(const Uint16 maxOps)
+{
+  m_maxOperationsPerformed = maxOps;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmSCPConfig::setPreallocationChunkSize(const Uint32 chunkSize)
+{
+  m_preallocationChunkSize = chunkSize;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmSCPConfig::setSocketOptions(const T_ASC_SocketOptions& options)
+{
+  m_socketOptions = options;
+}
+
+// ----------------------------------------------------------------------------
+
 /* Get methods for SCP settings and current association information */
 
 OFBool DcmSCPConfig::getRefuseAssociation() const
@@ -297,6 +327,27 @@ OFBool DcmSCPConfig::getProgressNotificationMode() const
 
 // ----------------------------------------------------------------------------
 
+Uint16 DcmSCPConfig::getMaxOperationsPerformed() const
+{
+  return m_maxOperationsPerformed;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint32 DcmSCPConfig::getPreallocationChunkSize() const
+{
+  return m_preallocationChunkSize;
+}
+
+// ----------------------------------------------------------------------------
+
+const T_ASC_SocketOptions& DcmSCPConfig::getSocketOptions() const
+{
+  return m_socketOptions;
+}
+
+// ----------------------------------------------------------------------------
+
 OFBool DcmSCPConfig::transportLayerEnabled() const
 {
   return (m_tLayer != NULL);
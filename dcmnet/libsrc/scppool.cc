@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 2012-2020, OFFIS e.V.
+ *  Copyright (C) 2012-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -29,6 +29,7 @@
 #include "dcmtk/dcmnet/scppool.h"
 #include "dcmtk/dcmnet/diutil.h"
 #include "dcmtk/dcmtls/tlslayer.h"
+#include "dcmtk/ofstd/oftimer.h"
 
 // ----------------------------------------------------------------------------
 
@@ -61,7 +62,7 @@ OFCondition DcmBaseSCPPool::listen()
 
   /* Initialize network, i.e. create an instance of T_ASC_Network*. */
   T_ASC_Network *network = NULL;
-  OFCondition cond = ASC_initializeNetwork( NET_ACCEPTOR, OFstatic_cast(int, m_cfg.getPort()), m_cfg.getACSETimeout(), &network );
+  OFCondition cond = ASC_initializeNetwork( NET_ACCEPTOR, OFstatic_cast(int, m_cfg.getPort()), m_cfg.getACSETimeout(), &network, m_cfg.getSocketOptions() );
   if( cond.bad() )
     return cond;
 
@@ -344,6 +345,9 @@ void DcmBaseSCPPool::DcmBaseSCPWorker::run()
   {
     T_ASC_Association *param = m_assoc;
     m_assoc = NULL;
+    /* time between the receipt of the association request and the start of the worker */
+    if (param->metrics != NULL)
+      DcmNetworkMetrics::instance().addQueueWait(OFTimer::getDiff(param->metrics->negotiationStartTime));
     result = workerListen(param);
     DCMNET_DEBUG("DcmBaseSCPPool: Worker thread #" << threadID() << " returns with code: " << result.text() );
   }
@@ -0,0 +1,1424 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Class listening for association requests and serving all
+ *  associations by a small number of event-driven I/O threads that wait
+ *  for incoming data, and a pool of worker threads that handle the
+ *  incoming DIMSE messages.
+ *
+ */
+
+#include "dcmtk/config/osconfig.h" /* make sure OS specific configuration is included first */
+
+#if defined(WITH_THREADS) && !defined(_WIN32) // Requires threads and POSIX sockets
+
+#include "dcmtk/dcmnet/scpreact.h"
+#include "dcmtk/dcmnet/diutil.h"
+#include "dcmtk/dcmnet/dcmtrans.h"
+#include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/dcmtls/tlslayer.h"
+#include "dcmtk/ofstd/ofthpool.h"
+#include "dcmtk/ofstd/oftimer.h"
+#include "dulstruc.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+BEGIN_EXTERN_C
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+END_EXTERN_C
+
+/// maximum number of events retrieved by a single call of epoll_wait()
+#define DCMNET_REACTOR_MAX_EVENTS 64
+
+/// number of bytes read from a socket at once by an I/O thread
+#define DCMNET_REACTOR_READ_SIZE 65536
+
+/// size of a PDU header (type, reserved byte, 32 bit length)
+#define DCMNET_REACTOR_PDU_HEADER 6
+
+/// size of a PDV item header (32 bit length, presentation context ID, message control header)
+#define DCMNET_REACTOR_PDV_HEADER 6
+
+
+/* *********************************************************************** */
+/*                   DcmBaseSCPReactor::BufferedConnection class           */
+/* *********************************************************************** */
+
+/** Transport connection that replaces the TCP connection of an association.
+ *  An I/O thread reads the incoming data into a buffer and parses the PDUs
+ *  in order to find out when a complete DIMSE message has arrived. The
+ *  association reads the buffered data first. Buffer and parser are only
+ *  accessed by the thread that currently owns the session, i.e. either by
+ *  its I/O thread or by a worker thread.
+ */
+class DcmBaseSCPReactor::BufferedConnection : public DcmTransportConnection
+{
+public:
+
+  /** Constructor
+   *  @param connection The TCP connection to be wrapped, takes over ownership
+   *  @param maxPDULength Maximum length of a PDU to be buffered, 0 for no
+   *         limit. Longer PDUs are handed to the association immediately.
+   */
+  BufferedConnection(DcmTransportConnection* connection,
+                     const Uint32 maxPDULength);
+
+  /** Destructor, deletes the wrapped connection (which closes the socket)
+   */
+  virtual ~BufferedConnection();
+
+  /** Replace the transport connection of the given association by a
+   *  buffered connection.
+   *  @param assoc The association
+   *  @param maxPDULength Maximum length of a PDU to be buffered
+   *  @return The buffered connection, NULL if the association has no
+   *          transport connection
+   */
+  static BufferedConnection* install(T_ASC_Association* assoc,
+                                     const Uint32 maxPDULength);
+
+  /** Read data from the socket into the buffer. Must only be called if data
+   *  is available, so that the call does not block.
+   *  @return OFFalse if the connection has been closed, an error occurred or
+   *          the data cannot be parsed, OFTrue otherwise
+   */
+  OFBool fill();
+
+  /** Check whether a complete DIMSE message (or any other PDU) is buffered,
+   *  or whether the association has to handle the connection anyway, e.g.
+   *  because it has been closed by the peer.
+   *  @return OFTrue if the association can read without waiting for the peer
+   */
+  OFBool hasCompleteMessage() const;
+
+  /** Check whether the beginning of a DIMSE message is buffered.
+   *  @return OFTrue if data of an incomplete message is buffered
+   */
+  OFBool hasPartialMessage() const;
+
+  virtual OFCondition serverSideHandshake();
+  virtual OFCondition clientSideHandshake();
+  virtual OFCondition renegotiate(const char *newSuite);
+  virtual ssize_t read(void *buf, size_t nbyte);
+  virtual ssize_t write(void *buf, size_t nbyte);
+  virtual ssize_t writeGathered(const void * const *buffers, const size_t *lengths, size_t count);
+  virtual void close();
+  virtual void closeTransportConnection();
+  virtual unsigned long getPeerCertificateLength();
+  virtual unsigned long getPeerCertificate(void *buf, unsigned long bufLen);
+  virtual OFBool networkDataAvailable(int timeout);
+  virtual OFBool isTransparentConnection();
+  virtual OFString& dumpConnectionParameters(OFString& str);
+
+private:
+
+  /** Parse all complete PDUs that have not been parsed yet, and update the
+   *  end of the complete DIMSE messages.
+   */
+  void parse();
+
+  /** Check whether the DIMSE command collected so far announces a dataset.
+   *  @return OFTrue if a dataset follows, OFFalse otherwise
+   */
+  OFBool commandHasDataset() const;
+
+  /// Wrapped TCP connection
+  DcmTransportConnection* m_connection;
+  /// Maximum length of a PDU to be buffered
+  const Uint32 m_maxPDULength;
+  /// Buffered data, m_readPos to m_end have not yet been read by the association
+  OFVector<unsigned char> m_buffer;
+  /// Position of the next byte to be read by the association
+  size_t m_readPos;
+  /// End of the buffered data
+  size_t m_end;
+  /// Position of the next PDU to be parsed
+  size_t m_parsed;
+  /// End of the last complete DIMSE message or PDU other than P-DATA-TF
+  size_t m_complete;
+  /// Command fragments of the DIMSE message currently received
+  OFVector<unsigned char> m_command;
+  /// Flag indicating that the command is complete and a dataset is received
+  OFBool m_inDataset;
+  /// Flag indicating that the data is not buffered any more, e.g. after an error
+  OFBool m_passThrough;
+};
+
+// ----------------------------------------------------------------------------
+
+DcmBaseSCPReactor::BufferedConnection::BufferedConnection(DcmTransportConnection* connection,
+                                                          const Uint32 maxPDULength)
+  : DcmTransportConnection(-1 /* do not set the socket options again */),
+    m_connection(connection),
+    m_maxPDULength(maxPDULength),
+    m_buffer(),
+    m_readPos(0),
+    m_end(0),
+    m_parsed(0),
+    m_complete(0),
+    m_command(),
+    m_inDataset(OFFalse),
+    m_passThrough(OFFalse)
+{
+  setSocket(connection->getSocket());
+}
+
+// ----------------------------------------------------------------------------
+
+DcmBaseSCPReactor::BufferedConnection::~BufferedConnection()
+{
+  delete m_connection;
+}
+
+// ----------------------------------------------------------------------------
+
+DcmBaseSCPReactor::BufferedConnection* DcmBaseSCPReactor::BufferedConnection::install(T_ASC_Association* assoc,
+                                                                                      const Uint32 maxPDULength)
+{
+  PRIVATE_ASSOCIATIONKEY* key = OFreinterpret_cast(PRIVATE_ASSOCIATIONKEY*, assoc->DULassociation);
+  if ((key == NULL) || (key->connection == NULL))
+    return NULL;
+  BufferedConnection* connection = new BufferedConnection(key->connection, maxPDULength);
+  key->connection = connection;
+  return connection;
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPReactor::BufferedConnection::fill()
+{
+  if (m_passThrough)
+    return OFFalse;
+  // move the unread data to the beginning of the buffer
+  if (m_readPos > 0)
+  {
+    if (m_end > m_readPos)
+      memmove(&m_buffer[0], &m_buffer[m_readPos], m_end - m_readPos);
+    m_end -= m_readPos;
+    m_parsed = (m_parsed > m_readPos) ? m_parsed - m_readPos : 0;
+    m_complete = (m_complete > m_readPos) ? m_complete - m_readPos : 0;
+    m_readPos = 0;
+  }
+  if (m_buffer.size() < m_end + DCMNET_REACTOR_READ_SIZE)
+    m_buffer.resize(m_end + DCMNET_REACTOR_READ_SIZE);
+  const ssize_t bytesRead = m_connection->read(&m_buffer[m_end], DCMNET_REACTOR_READ_SIZE);
+  if (bytesRead <= 0)
+  {
+    // let the association detect the closed connection or the error
+    m_passThrough = OFTrue;
+    return OFFalse;
+  }
+  m_end += OFstatic_cast(size_t, bytesRead);
+  parse();
+  return !m_passThrough;
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPReactor::BufferedConnection::hasCompleteMessage() const
+{
+  if (m_passThrough)
+    return OFTrue;
+  return m_complete > m_readPos;
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPReactor::BufferedConnection::hasPartialMessage() const
+{
+  return (m_end > m_readPos) && (m_end > m_complete);
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::BufferedConnection::parse()
+{
+  while (m_end - m_parsed >= DCMNET_REACTOR_PDU_HEADER)
+  {
+    const unsigned char* pdu = &m_buffer[m_parsed];
+    const size_t pduLength = (OFstatic_cast(size_t, pdu[2]) << 24) | (OFstatic_cast(size_t, pdu[3]) << 16) |
+                             (OFstatic_cast(size_t, pdu[4]) << 8) | OFstatic_cast(size_t, pdu[5]);
+    if ((m_maxPDULength > 0) && (pduLength > m_maxPDULength))
+    {
+      // do not buffer an invalid PDU, the association reports the error
+      m_passThrough = OFTrue;
+      return;
+    }
+    if (m_end - m_parsed - DCMNET_REACTOR_PDU_HEADER < pduLength)
+      break;
+    const size_t pduEnd = m_parsed + DCMNET_REACTOR_PDU_HEADER + pduLength;
+    // any PDU other than P-DATA-TF is handed to the association as a whole
+    OFBool messageComplete = (pdu[0] != 0x04);
+    size_t pos = m_parsed + DCMNET_REACTOR_PDU_HEADER;
+    while (!messageComplete && (pduEnd - pos >= DCMNET_REACTOR_PDV_HEADER))
+    {
+      const unsigned char* pdv = &m_buffer[pos];
+      const size_t pdvLength = (OFstatic_cast(size_t, pdv[0]) << 24) | (OFstatic_cast(size_t, pdv[1]) << 16) |
+                               (OFstatic_cast(size_t, pdv[2]) << 8) | OFstatic_cast(size_t, pdv[3]);
+      if ((pdvLength < 2) || (pdvLength > pduEnd - pos - 4))
+      {
+        m_passThrough = OFTrue;
+        return;
+      }
+      const unsigned char control = pdv[5];
+      if (control & 0x01)
+      {
+        // command fragment, the last one tells whether a dataset follows
+        m_command.insert(m_command.end(), pdv + DCMNET_REACTOR_PDV_HEADER, pdv + 4 + pdvLength);
+        if (control & 0x02)
+        {
+          m_inDataset = commandHasDataset();
+          messageComplete = !m_inDataset;
+          m_command.clear();
+        }
+      }
+      else if (control & 0x02)
+      {
+        // last dataset fragment
+        messageComplete = OFTrue;
+      }
+      pos += 4 + pdvLength;
+    }
+    m_parsed = pduEnd;
+    if (messageComplete)
+    {
+      m_complete = pduEnd;
+      m_command.clear();
+      m_inDataset = OFFalse;
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPReactor::BufferedConnection::commandHasDataset() const
+{
+  // the command set is always encoded with Little Endian Implicit VR
+  size_t pos = 0;
+  const size_t size = m_command.size();
+  while (size - pos >= 8)
+  {
+    const unsigned char* elem = &m_command[pos];
+    const Uint16 group = OFstatic_cast(Uint16, elem[0] | (elem[1] << 8));
+    const Uint16 element = OFstatic_cast(Uint16, elem[2] | (elem[3] << 8));
+    const size_t length = OFstatic_cast(size_t, elem[4]) | (OFstatic_cast(size_t, elem[5]) << 8) |
+                          (OFstatic_cast(size_t, elem[6]) << 16) | (OFstatic_cast(size_t, elem[7]) << 24);
+    pos += 8;
+    if (length > size - pos)
+      break;
+    if ((group == 0x0000) && (element == 0x0800) && (length >= 2))
+      return OFstatic_cast(Uint16, m_command[pos] | (m_command[pos + 1] << 8)) != DIMSE_DATASET_NULL;
+    pos += length;
+  }
+  // an invalid command is handed to the association immediately
+  return OFFalse;
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::BufferedConnection::serverSideHandshake()
+{
+  return m_connection->serverSideHandshake();
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::BufferedConnection::clientSideHandshake()
+{
+  return m_connection->clientSideHandshake();
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::BufferedConnection::renegotiate(const char *newSuite)
+{
+  return m_connection->renegotiate(newSuite);
+}
+
+// ----------------------------------------------------------------------------
+
+ssize_t DcmBaseSCPReactor::BufferedConnection::read(void *buf, size_t nbyte)
+{
+  if (m_readPos < m_end)
+  {
+    const size_t count = (nbyte < m_end - m_readPos) ? nbyte : m_end - m_readPos;
+    memcpy(buf, &m_buffer[m_readPos], count);
+    m_readPos += count;
+    return OFstatic_cast(ssize_t, count);
+  }
+  return m_connection->read(buf, nbyte);
+}
+
+// ----------------------------------------------------------------------------
+
+ssize_t DcmBaseSCPReactor::BufferedConnection::write(void *buf, size_t nbyte)
+{
+  return m_connection->write(buf, nbyte);
+}
+
+// ----------------------------------------------------------------------------
+
+ssize_t DcmBaseSCPReactor::BufferedConnection::writeGathered(const void * const *buffers, const size_t *lengths, size_t count)
+{
+  return m_connection->writeGathered(buffers, lengths, count);
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::BufferedConnection::close()
+{
+  m_connection->close();
+  setSocket(m_connection->getSocket());
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::BufferedConnection::closeTransportConnection()
+{
+  m_connection->closeTransportConnection();
+  setSocket(m_connection->getSocket());
+}
+
+// ----------------------------------------------------------------------------
+
+unsigned long DcmBaseSCPReactor::BufferedConnection::getPeerCertificateLength()
+{
+  return m_connection->getPeerCertificateLength();
+}
+
+// ----------------------------------------------------------------------------
+
+unsigned long DcmBaseSCPReactor::BufferedConnection::getPeerCertificate(void *buf, unsigned long bufLen)
+{
+  return m_connection->getPeerCertificate(buf, bufLen);
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPReactor::BufferedConnection::networkDataAvailable(int timeout)
+{
+  if (m_readPos < m_end)
+    return OFTrue;
+  return m_connection->networkDataAvailable(timeout);
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPReactor::BufferedConnection::isTransparentConnection()
+{
+  return m_connection->isTransparentConnection();
+}
+
+// ----------------------------------------------------------------------------
+
+OFString& DcmBaseSCPReactor::BufferedConnection::dumpConnectionParameters(OFString& str)
+{
+  return m_connection->dumpConnectionParameters(str);
+}
+
+
+/* *********************************************************************** */
+/*                        DcmBaseSCPReactor::IOThread class                */
+/* *********************************************************************** */
+
+/** Thread waiting for incoming data on a share of the associations of the
+ *  reactor. Sessions with a complete DIMSE message, or without any data
+ *  within the DIMSE timeout, are handed to the worker threads.
+ */
+class DcmBaseSCPReactor::IOThread : public OFThread
+{
+public:
+
+  /** Constructor
+   *  @param reactor The reactor this thread belongs to
+   *  @param idleTimeout Number of seconds after which an idle session is
+   *         handed to the worker threads for termination, 0 for no timeout
+   *  @param partialTimeout Number of seconds after which a session that
+   *         has not completed a DIMSE message is handed to the worker
+   *         threads for termination, 0 for no timeout
+   *  @param lingerTimeout Number of seconds to wait for the peer to close
+   *         the connection after the association has ended
+   */
+  IOThread(DcmBaseSCPReactor& reactor,
+           const Uint32 idleTimeout,
+           const Uint32 partialTimeout,
+           const Uint32 lingerTimeout);
+
+  /** Destructor, closes the event poller
+   */
+  virtual ~IOThread();
+
+  /** Create the event poller and the pipe used for waking up the thread.
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition initialize();
+
+  /** Wait for incoming data on the socket of a session. The session is
+   *  added to the sessions watched by this thread on the first call.
+   *  @param session The session, must not be watched by another thread
+   *  @param lingering OFTrue if the association has ended and the thread
+   *         should wait for the peer to close the connection
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  OFCondition watch(DcmBaseSCPSession* session,
+                    const OFBool lingering);
+
+  /** Remove a session from the sessions watched by this thread.
+   *  @param session The session, must neither be armed nor lingering
+   */
+  void remove(DcmBaseSCPSession* session);
+
+  /** Tell the thread to exit as soon as possible.
+   */
+  void shutdown();
+
+protected:
+
+  /** Event loop of the thread.
+   */
+  virtual void run();
+
+private:
+
+  /** Wake up the thread if it is waiting for events.
+   */
+  void wakeUp();
+
+  /** Read all pending bytes from the wake up pipe.
+   */
+  void drainWakeUpPipe();
+
+  /** Update the state of a session after an event has been reported on its
+   *  socket. The data of a buffered connection is read, and the session is
+   *  only handed to the worker threads after a complete DIMSE message has
+   *  arrived. The caller must hold the mutex.
+   *  @param session The session
+   *  @return OFTrue if the session has to be handed to the worker threads
+   */
+  OFBool dispatch(DcmBaseSCPSession* session);
+
+  /** Compute the time when an armed session times out.
+   *  @param session The session
+   *  @param now The current time
+   *  @return The deadline, 0 for no timeout
+   */
+  time_t armedDeadline(const DcmBaseSCPSession* session,
+                       const time_t now) const;
+
+  /** Collect armed or lingering sessions whose deadline has passed.
+   *  The caller must hold the mutex.
+   *  @param ready List to which the timed out sessions are appended
+   */
+  void collectTimedOutSessions(OFList<DcmBaseSCPSession*>& ready);
+
+  /// Reactor this thread belongs to
+  DcmBaseSCPReactor& m_reactor;
+  /// Idle timeout in seconds, 0 for no timeout
+  const Uint32 m_idleTimeout;
+  /// Timeout in seconds for completing a DIMSE message, 0 for no timeout
+  const Uint32 m_partialTimeout;
+  /// Timeout in seconds for the peer to close the connection
+  const Uint32 m_lingerTimeout;
+  /// Mutex that guards the list of sessions, their states and the stop flag
+  OFMutex m_mutex;
+  /// Sessions watched by this thread
+  OFList<DcmBaseSCPSession*> m_sessions;
+  /// Pipe used for waking up the thread, read end first
+  int m_wakeUpPipe[2];
+#ifdef HAVE_SYS_EPOLL_H
+  /// File descriptor of the epoll instance
+  int m_epoll;
+#endif
+  /// Flag indicating that the thread should exit
+  OFBool m_stop;
+};
+
+// ----------------------------------------------------------------------------
+
+DcmBaseSCPReactor::IOThread::IOThread(DcmBaseSCPReactor& reactor,
+                                      const Uint32 idleTimeout,
+                                      const Uint32 partialTimeout,
+                                      const Uint32 lingerTimeout)
+  : OFThread(),
+    m_reactor(reactor),
+    m_idleTimeout(idleTimeout),
+    m_partialTimeout(partialTimeout),
+    m_lingerTimeout(lingerTimeout),
+    m_mutex(),
+    m_sessions(),
+#ifdef HAVE_SYS_EPOLL_H
+    m_epoll(-1),
+#endif
+    m_stop(OFFalse)
+{
+  m_wakeUpPipe[0] = -1;
+  m_wakeUpPipe[1] = -1;
+}
+
+// ----------------------------------------------------------------------------
+
+DcmBaseSCPReactor::IOThread::~IOThread()
+{
+#ifdef HAVE_SYS_EPOLL_H
+  if (m_epoll >= 0)
+    close(m_epoll);
+#endif
+  if (m_wakeUpPipe[0] >= 0)
+    close(m_wakeUpPipe[0]);
+  if (m_wakeUpPipe[1] >= 0)
+    close(m_wakeUpPipe[1]);
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::IOThread::initialize()
+{
+  if (pipe(m_wakeUpPipe) != 0)
+  {
+    DCMNET_ERROR("DcmBaseSCPReactor: Cannot create pipe: " << OFStandard::getLastSystemErrorCode().message());
+    return NET_EC_CannotCreateEventPoller;
+  }
+  // neither writing nor draining the pipe must ever block
+  fcntl(m_wakeUpPipe[0], F_SETFL, fcntl(m_wakeUpPipe[0], F_GETFL) | O_NONBLOCK);
+  fcntl(m_wakeUpPipe[1], F_SETFL, fcntl(m_wakeUpPipe[1], F_GETFL) | O_NONBLOCK);
+#ifdef HAVE_SYS_EPOLL_H
+  m_epoll = epoll_create(DCMNET_REACTOR_MAX_EVENTS);
+  if (m_epoll < 0)
+  {
+    DCMNET_ERROR("DcmBaseSCPReactor: Cannot create epoll instance: " << OFStandard::getLastSystemErrorCode().message());
+    return NET_EC_CannotCreateEventPoller;
+  }
+  // the wake up pipe is the only entry without a session
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeUpPipe[0], &ev) != 0)
+  {
+    DCMNET_ERROR("DcmBaseSCPReactor: Cannot watch pipe: " << OFStandard::getLastSystemErrorCode().message());
+    return NET_EC_CannotCreateEventPoller;
+  }
+#endif
+  return EC_Normal;
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::IOThread::watch(DcmBaseSCPSession* session,
+                                               const OFBool lingering)
+{
+  const time_t now = time(NULL);
+  m_mutex.lock();
+  const OFBool added = !session->m_watched;
+  if (added)
+  {
+    m_sessions.push_back(session);
+    session->m_watched = OFTrue;
+  }
+  if (lingering)
+  {
+    session->m_state = DcmBaseSCPSession::LINGERING;
+    session->m_deadline = now + m_lingerTimeout;
+  }
+  else
+  {
+    session->m_state = DcmBaseSCPSession::ARMED;
+    session->m_deadline = armedDeadline(session, now);
+  }
+#ifdef HAVE_SYS_EPOLL_H
+  // one-shot: after an event the socket is disabled until the session is watched again
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.ptr = session;
+  if (epoll_ctl(m_epoll, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, session->m_socket, &ev) != 0)
+  {
+    session->m_state = DcmBaseSCPSession::BUSY;
+    m_mutex.unlock();
+    DCMNET_ERROR("DcmBaseSCPReactor: Cannot watch socket: " << OFStandard::getLastSystemErrorCode().message());
+    return NET_EC_CannotCreateEventPoller;
+  }
+  m_mutex.unlock();
+#else
+  m_mutex.unlock();
+  wakeUp();
+#endif
+  return EC_Normal;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::IOThread::remove(DcmBaseSCPSession* session)
+{
+  m_mutex.lock();
+  m_sessions.remove(session);
+  session->m_watched = OFFalse;
+#ifdef HAVE_SYS_EPOLL_H
+  // the socket is still open, so the entry has to be removed explicitly
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, session->m_socket, &ev);
+#endif
+  m_mutex.unlock();
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::IOThread::shutdown()
+{
+  m_mutex.lock();
+  m_stop = OFTrue;
+  m_mutex.unlock();
+  wakeUp();
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::IOThread::wakeUp()
+{
+  const char c = 0;
+  // if the pipe is full, the thread will wake up anyway
+  if (write(m_wakeUpPipe[1], &c, 1) < 0) { /* nothing to do */ }
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::IOThread::drainWakeUpPipe()
+{
+  char buf[64];
+  while (read(m_wakeUpPipe[0], buf, sizeof(buf)) > 0) { /* nothing to do */ }
+}
+
+// ----------------------------------------------------------------------------
+
+OFBool DcmBaseSCPReactor::IOThread::dispatch(DcmBaseSCPSession* session)
+{
+  // only armed and lingering sessions are owned by the I/O thread
+  if (session->m_state == DcmBaseSCPSession::ARMED)
+  {
+    BufferedConnection* connection = session->m_connection;
+    if ((connection != NULL) && connection->fill() && !connection->hasCompleteMessage())
+    {
+      // wait for the rest of the message without occupying a worker thread
+      session->m_deadline = armedDeadline(session, time(NULL));
+#ifdef HAVE_SYS_EPOLL_H
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN | EPOLLONESHOT;
+      ev.data.ptr = session;
+      if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, session->m_socket, &ev) == 0)
+        return OFFalse;
+      // the worker thread will notice the problem when reading
+      DCMNET_ERROR("DcmBaseSCPReactor: Cannot watch socket: " << OFStandard::getLastSystemErrorCode().message());
+#else
+      return OFFalse;
+#endif
+    }
+    session->m_state = DcmBaseSCPSession::READABLE;
+  }
+  else if (session->m_state == DcmBaseSCPSession::LINGERING)
+    session->m_state = DcmBaseSCPSession::CLOSING;
+  else
+    return OFFalse;
+  return OFTrue;
+}
+
+// ----------------------------------------------------------------------------
+
+time_t DcmBaseSCPReactor::IOThread::armedDeadline(const DcmBaseSCPSession* session,
+                                                  const time_t now) const
+{
+  if ((session->m_connection != NULL) && session->m_connection->hasPartialMessage())
+    return (m_partialTimeout > 0) ? now + m_partialTimeout : 0;
+  return (m_idleTimeout > 0) ? now + m_idleTimeout : 0;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::IOThread::collectTimedOutSessions(OFList<DcmBaseSCPSession*>& ready)
+{
+  const time_t now = time(NULL);
+  for (OFListIterator(DcmBaseSCPSession*) it = m_sessions.begin(); it != m_sessions.end(); ++it)
+  {
+    DcmBaseSCPSession* session = *it;
+    if (((session->m_state == DcmBaseSCPSession::ARMED) || (session->m_state == DcmBaseSCPSession::LINGERING)) &&
+        (session->m_deadline != 0) && (now >= session->m_deadline))
+    {
+#ifdef HAVE_SYS_EPOLL_H
+      // disable the socket so that no event is reported for the session any more
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.data.ptr = session;
+      epoll_ctl(m_epoll, EPOLL_CTL_MOD, session->m_socket, &ev);
+#endif
+      // a lingering session is dropped without waiting any longer
+      if (session->m_state == DcmBaseSCPSession::ARMED)
+        session->m_state = DcmBaseSCPSession::TIMED_OUT;
+      else
+        session->m_state = DcmBaseSCPSession::CLOSING;
+      ready.push_back(session);
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::IOThread::run()
+{
+  // check for timed out sessions once per second
+  const int pollTimeout = 1000;
+  OFList<DcmBaseSCPSession*> ready;
+#ifdef HAVE_SYS_EPOLL_H
+  struct epoll_event events[DCMNET_REACTOR_MAX_EVENTS];
+#else
+  OFVector<struct pollfd> fds;
+  OFVector<DcmBaseSCPSession*> polled;
+#endif
+  while (1)
+  {
+#ifdef HAVE_SYS_EPOLL_H
+    m_mutex.lock();
+    const OFBool stop = m_stop;
+    m_mutex.unlock();
+    if (stop)
+      break;
+
+    const int nfound = epoll_wait(m_epoll, events, DCMNET_REACTOR_MAX_EVENTS, pollTimeout);
+    if ((nfound < 0) && (errno != EINTR))
+    {
+      DCMNET_ERROR("DcmBaseSCPReactor: Waiting for events failed: " << OFStandard::getLastSystemErrorCode().message());
+      OFStandard::milliSleep(100);
+    }
+
+    m_mutex.lock();
+    for (int i = 0; i < nfound; ++i)
+    {
+      DcmBaseSCPSession* session = OFstatic_cast(DcmBaseSCPSession*, events[i].data.ptr);
+      if (session == NULL)
+        drainWakeUpPipe();
+      else if (dispatch(session))
+        ready.push_back(session);
+    }
+#else
+    // only the I/O thread changes the state of an armed or lingering session,
+    // so the polled sessions remain valid while the mutex is not held
+    struct pollfd pfd;
+    pfd.fd = m_wakeUpPipe[0];
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    fds.clear();
+    polled.clear();
+    m_mutex.lock();
+    const OFBool stop = m_stop;
+    fds.push_back(pfd);
+    for (OFListIterator(DcmBaseSCPSession*) it = m_sessions.begin(); it != m_sessions.end(); ++it)
+    {
+      if (((*it)->m_state == DcmBaseSCPSession::ARMED) || ((*it)->m_state == DcmBaseSCPSession::LINGERING))
+      {
+        pfd.fd = (*it)->m_socket;
+        fds.push_back(pfd);
+        polled.push_back(*it);
+      }
+    }
+    m_mutex.unlock();
+    if (stop)
+      break;
+
+    const int nfound = poll(&fds[0], OFstatic_cast(nfds_t, fds.size()), pollTimeout);
+    if ((nfound < 0) && (errno != EINTR))
+    {
+      DCMNET_ERROR("DcmBaseSCPReactor: Waiting for events failed: " << OFStandard::getLastSystemErrorCode().message());
+      OFStandard::milliSleep(100);
+    }
+
+    m_mutex.lock();
+    if (nfound > 0)
+    {
+      if (fds[0].revents != 0)
+        drainWakeUpPipe();
+      for (size_t i = 1; i < fds.size(); ++i)
+      {
+        if ((fds[i].revents != 0) && dispatch(polled[i - 1]))
+          ready.push_back(polled[i - 1]);
+      }
+    }
+#endif
+    collectTimedOutSessions(ready);
+    m_mutex.unlock();
+
+    // hand the sessions to the worker threads
+    while (!ready.empty())
+    {
+      m_reactor.enqueue(ready.front());
+      ready.pop_front();
+    }
+  }
+}
+
+
+/* *********************************************************************** */
+/*                        DcmBaseSCPReactor::WorkerThread class            */
+/* *********************************************************************** */
+
+/** Thread handling the sessions queued by the reactor.
+ */
+class DcmBaseSCPReactor::WorkerThread : public OFThread
+{
+public:
+
+  /** Constructor
+   *  @param reactor The reactor this thread belongs to
+   */
+  WorkerThread(DcmBaseSCPReactor& reactor)
+    : OFThread(),
+      m_reactor(reactor)
+  {
+  }
+
+protected:
+
+  /** Handle queued sessions until the thread is told to exit.
+   */
+  virtual void run()
+  {
+    m_reactor.processQueue();
+  }
+
+private:
+
+  /// Reactor this thread belongs to
+  DcmBaseSCPReactor& m_reactor;
+};
+
+
+/* *********************************************************************** */
+/*                        DcmBaseSCPReactor class                          */
+/* *********************************************************************** */
+
+DcmBaseSCPReactor::DcmBaseSCPReactor()
+  : m_criticalSection(),
+    m_numAssociations(0),
+    m_queueMutex(),
+    m_queue(),
+    m_queueSize(0),
+    m_ioThreads(),
+    m_workers(),
+    m_nextIOThread(0),
+    m_cfg(),
+    m_numIOThreads(1),
+    m_numWorkers(0),
+    m_maxAssociations(1024),
+    m_runMode( LISTEN )
+{
+}
+
+// ----------------------------------------------------------------------------
+
+DcmBaseSCPReactor::~DcmBaseSCPReactor()
+{
+  stopThreads();
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::listen()
+{
+  m_criticalSection.lock();
+  m_runMode = LISTEN;
+  m_criticalSection.unlock();
+
+  /* Copy the config to a shared config that is shared by all sessions. */
+  DcmSharedSCPConfig sharedConfig(m_cfg);
+
+  /* Initialize network, i.e. create an instance of T_ASC_Network*. */
+  T_ASC_Network *network = NULL;
+  OFCondition cond = ASC_initializeNetwork( NET_ACCEPTOR, OFstatic_cast(int, m_cfg.getPort()), m_cfg.getACSETimeout(), &network );
+  if( cond.bad() )
+    return cond;
+
+  if (m_cfg.transportLayerEnabled())
+  {
+    cond = ASC_setTransportLayer(network, m_cfg.getTransportLayer(), 0 /* Do not take over ownership */);
+    if (cond.bad())
+    {
+        DCMNET_ERROR("DcmBaseSCPReactor: Error setting secured transport layer: " << cond.text());
+    }
+  }
+
+  /* Start the I/O and worker threads */
+  if (cond.good())
+    cond = startThreads();
+
+  runmode mode = LISTEN;
+  while ( mode == LISTEN && cond.good() )
+  {
+    // Every incoming connection is handled in a new association object
+    T_ASC_Association *assoc = NULL;
+    OFBool useSecureLayer = m_cfg.transportLayerEnabled();
+
+    // Listen to a socket for timeout seconds for an association request, accepts TCP connection.
+    cond = ASC_receiveAssociation( network, &assoc, m_cfg.getMaxReceivePDULength(), NULL, NULL, useSecureLayer,
+        m_cfg.getConnectionBlockingMode(), OFstatic_cast(int, m_cfg.getConnectionTimeout()) );
+
+    /* If we have a connection request, hand it to a worker thread for negotiation */
+    if (cond.good())
+    {
+      OFBool busy = OFFalse;
+      m_criticalSection.lock();
+      if (m_numAssociations >= m_maxAssociations)
+        busy = OFTrue;
+      else
+        ++m_numAssociations;
+      m_criticalSection.unlock();
+
+      if (busy)
+      {
+        DCMNET_DEBUG("DcmBaseSCPReactor: Maximum number of associations reached, rejecting association request");
+        rejectAssociation(assoc, ASC_REASON_SP_PRES_LOCALLIMITEXCEEDED);
+        dropAndDestroyAssociation(assoc);
+      }
+      else
+      {
+        DcmBaseSCPSession* session = createSCPSession();
+        if (session == NULL)
+        {
+          rejectAssociation(assoc, ASC_REASON_SP_PRES_TEMPORARYCONGESTION);
+          dropAndDestroyAssociation(assoc);
+          m_criticalSection.lock();
+          --m_numAssociations;
+          m_criticalSection.unlock();
+        }
+        else
+        {
+          session->setSharedConfig(sharedConfig);
+          session->m_assoc = assoc;
+          enqueue(session);
+        }
+      }
+    }
+
+    /* If error occurred while receiving association, clean up */
+    else
+    {
+      /* Handle timeout and errors differently */
+      if ( cond == DUL_NOASSOCIATIONREQUEST )
+      {
+        ASC_destroyAssociation( &assoc );
+      }
+      else
+      {
+        dropAndDestroyAssociation(assoc);
+        DCMNET_ERROR("DcmBaseSCPReactor: Error receiving association: " << cond.text());
+      }
+    }
+    // ... and keep listening ...
+    cond = EC_Normal;
+
+    m_criticalSection.lock();
+    mode = m_runMode;
+    m_criticalSection.unlock();
+  }
+
+  /* Wait until all associations have ended */
+  while (numAssociations() > 0)
+    OFStandard::milliSleep(50);
+
+  m_criticalSection.lock();
+  m_runMode = SHUTDOWN;
+  m_criticalSection.unlock();
+
+  stopThreads();
+
+  /* In the end, clean up the rest of the memory and drop network */
+  ASC_dropNetwork(&network);
+
+  return cond;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::stopAfterCurrentAssociations()
+{
+  m_criticalSection.lock();
+  if (m_runMode == LISTEN )
+    m_runMode = STOP;
+  m_criticalSection.unlock();
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::setNumberOfIOThreads(const Uint16 numThreads)
+{
+  m_numIOThreads = (numThreads > 0) ? numThreads : 1;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmBaseSCPReactor::getNumberOfIOThreads() const
+{
+  return m_numIOThreads;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::setNumberOfWorkerThreads(const Uint16 numThreads)
+{
+  m_numWorkers = numThreads;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmBaseSCPReactor::getNumberOfWorkerThreads() const
+{
+  return m_numWorkers;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::setMaxAssociations(const Uint16 maxAssociations)
+{
+  m_maxAssociations = maxAssociations;
+}
+
+// ----------------------------------------------------------------------------
+
+Uint16 DcmBaseSCPReactor::getMaxAssociations() const
+{
+  return m_maxAssociations;
+}
+
+// ----------------------------------------------------------------------------
+
+size_t DcmBaseSCPReactor::numAssociations()
+{
+  m_criticalSection.lock();
+  const size_t result = m_numAssociations;
+  m_criticalSection.unlock();
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+DcmSCPConfig& DcmBaseSCPReactor::getConfig()
+{
+  return m_cfg;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::rejectAssociation(T_ASC_Association *assoc,
+                                          const T_ASC_RejectParametersReason& reason)
+{
+  T_ASC_RejectParameters rej;
+  rej.result = ASC_RESULT_REJECTEDTRANSIENT;
+  rej.source = ASC_SOURCE_SERVICEPROVIDER_PRESENTATION_RELATED;
+  rej.reason = reason;
+  ASC_rejectAssociation( assoc, &rej );
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::dropAndDestroyAssociation(T_ASC_Association *assoc)
+{
+  if (assoc)
+  {
+    ASC_dropAssociation( assoc );
+    ASC_destroyAssociation( &assoc );
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::startThreads()
+{
+  /* Idle associations are aborted after the DIMSE timeout in both blocking modes,
+   * since no worker thread waits for their data. A DIMSE message that has been
+   * started must be completed within the DIMSE timeout, or the ACSE timeout if
+   * there is no DIMSE timeout, so that a stalled peer cannot keep its buffer.
+   */
+  const Uint32 idleTimeout = m_cfg.getDIMSETimeout();
+  const Uint32 partialTimeout = (idleTimeout > 0) ? idleTimeout : m_cfg.getACSETimeout();
+  size_t numWorkers = m_numWorkers;
+  if (numWorkers == 0)
+  {
+    /* Handling DIMSE messages usually also means waiting for disk I/O */
+    numWorkers = OFThreadPool::getNumberOfProcessors();
+    if (numWorkers < 4)
+      numWorkers = 4;
+  }
+
+  DCMNET_DEBUG("DcmBaseSCPReactor: Starting " << m_numIOThreads << " I/O thread(s) and "
+    << numWorkers << " worker thread(s)");
+  m_nextIOThread = 0;
+  for (size_t i = 0; i < m_numIOThreads; ++i)
+  {
+    IOThread* thread = new IOThread(*this, idleTimeout, partialTimeout, m_cfg.getACSETimeout());
+    OFCondition cond = thread->initialize();
+    if (cond.good() && (thread->start() != 0))
+      cond = NET_EC_CannotStartSCPThread;
+    if (cond.bad())
+    {
+      delete thread;
+      return cond;
+    }
+    m_ioThreads.push_back(thread);
+  }
+  for (size_t j = 0; j < numWorkers; ++j)
+  {
+    WorkerThread* thread = new WorkerThread(*this);
+    if (thread->start() != 0)
+    {
+      delete thread;
+      return NET_EC_CannotStartSCPThread;
+    }
+    m_workers.push_back(thread);
+  }
+  return EC_Normal;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::stopThreads()
+{
+  // one NULL entry in the queue stops one worker thread
+  for (size_t i = 0; i < m_workers.size(); ++i)
+    enqueue(NULL);
+  for (size_t j = 0; j < m_workers.size(); ++j)
+  {
+    m_workers[j]->join();
+    delete m_workers[j];
+  }
+  m_workers.clear();
+  for (size_t k = 0; k < m_ioThreads.size(); ++k)
+  {
+    m_ioThreads[k]->shutdown();
+    m_ioThreads[k]->join();
+    delete m_ioThreads[k];
+  }
+  m_ioThreads.clear();
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::enqueue(DcmBaseSCPSession* session)
+{
+  if (session != NULL)
+    session->m_queueTime = OFTimer::getTime();
+  m_queueMutex.lock();
+  m_queue.push_back(session);
+  m_queueMutex.unlock();
+  m_queueSize.post();
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::processQueue()
+{
+  while (1)
+  {
+    m_queueSize.wait();
+    m_queueMutex.lock();
+    DcmBaseSCPSession* session = m_queue.front();
+    m_queue.pop_front();
+    m_queueMutex.unlock();
+    if (session == NULL)
+      break;
+    if (DcmNetworkMetrics::instance().isEnabled())
+      DcmNetworkMetrics::instance().addQueueWait(OFTimer::getDiff(session->m_queueTime));
+    handleSession(session);
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::handleSession(DcmBaseSCPSession* session)
+{
+  if (session->m_assoc != NULL)
+  {
+    /* New association: acknowledge or refuse it */
+    T_ASC_Association* assoc = session->m_assoc;
+    session->m_assoc = NULL;
+    /* The data of secure connections cannot be inspected by the I/O threads */
+    if (!m_cfg.transportLayerEnabled())
+      session->m_connection = BufferedConnection::install(assoc, m_cfg.getMaxReceivePDULength());
+    OFBool acknowledged = OFFalse;
+    OFCondition cond = session->negotiate(assoc, acknowledged);
+    if (cond.bad())
+      DCMNET_ERROR("DcmBaseSCPReactor: Error negotiating association: " << cond.text());
+    if (acknowledged)
+      continueSession(session);
+    else
+      lingerSession(session);
+  }
+  else if (session->m_state == DcmBaseSCPSession::CLOSING)
+  {
+    /* Peer has closed the connection (or did not do so in time) */
+    closeSession(session);
+  }
+  else if (session->m_state == DcmBaseSCPSession::TIMED_OUT)
+  {
+    if ((session->m_connection != NULL) && session->m_connection->hasPartialMessage())
+      DCMNET_DEBUG("DcmBaseSCPReactor: DIMSE message not completed within timeout, ending association");
+    else
+      DCMNET_DEBUG("DcmBaseSCPReactor: No data received within DIMSE timeout, ending association");
+    endSession(session, DIMSE_NODATAAVAILABLE);
+    lingerSession(session);
+  }
+  else
+  {
+    /* Data has arrived: handle the next DIMSE message */
+    OFCondition cond = session->processNextCommand();
+    if (cond.good())
+      continueSession(session);
+    else
+    {
+      endSession(session, cond);
+      lingerSession(session);
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::continueSession(DcmBaseSCPSession* session)
+{
+  DcmTransportConnection* connection = session->getTransportConnection();
+  if (connection == NULL)
+  {
+    closeSession(session);
+    return;
+  }
+
+  /* Data may already be buffered (e.g. by the TLS layer or the buffered
+   * connection), which would not be signalled on the socket. Queue the
+   * session again in this case, unless the next message is incomplete.
+   */
+  const OFBool available = (session->m_connection != NULL)
+    ? session->m_connection->hasCompleteMessage()
+    : connection->networkDataAvailable(0);
+  if (available)
+  {
+    session->m_state = DcmBaseSCPSession::READABLE;
+    enqueue(session);
+    return;
+  }
+
+  OFCondition cond = watchSession(session, OFFalse /* lingering */);
+  if (cond.bad())
+  {
+    endSession(session, cond);
+    closeSession(session);
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::endSession(DcmBaseSCPSession* session,
+                                   const OFCondition& reason)
+{
+  /* Ending the association may close the socket (e.g. after an A-ABORT),
+   * so stop watching it first. Otherwise, the registration of a new
+   * connection that reuses the same descriptor could be removed later on.
+   */
+  if (session->m_watched)
+    m_ioThreads[session->m_ioThread]->remove(session);
+  session->endAssociation(reason);
+  /* The connection may have been deleted, and no message is received anymore */
+  session->m_connection = NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::lingerSession(DcmBaseSCPSession* session)
+{
+  /* Do not block a worker thread while waiting for the peer to close the
+   * connection after the association has been released, aborted or refused.
+   */
+  if (session->getTransportConnection() == NULL)
+    closeSession(session);
+  else if (watchSession(session, OFTrue /* lingering */).bad())
+    closeSession(session);
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmBaseSCPReactor::watchSession(DcmBaseSCPSession* session,
+                                            const OFBool lingering)
+{
+  if (session->m_socket < 0)
+  {
+    /* Distribute the associations among the I/O threads */
+    session->m_socket = session->getTransportConnection()->getSocket();
+    m_criticalSection.lock();
+    session->m_ioThread = m_nextIOThread;
+    m_nextIOThread = (m_nextIOThread + 1) % m_ioThreads.size();
+    m_criticalSection.unlock();
+  }
+  return m_ioThreads[session->m_ioThread]->watch(session, lingering);
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmBaseSCPReactor::closeSession(DcmBaseSCPSession* session)
+{
+  if (session->m_watched)
+    m_ioThreads[session->m_ioThread]->remove(session);
+  session->dropAssociation();
+  delete session;
+
+  m_criticalSection.lock();
+  --m_numAssociations;
+  m_criticalSection.unlock();
+}
+
+
+/* *********************************************************************** */
+/*                        DcmBaseSCPReactor::DcmBaseSCPSession class       */
+/* *********************************************************************** */
+
+DcmBaseSCPReactor::DcmBaseSCPSession::DcmBaseSCPSession()
+  : m_assoc(NULL),
+    m_ioThread(0),
+    m_socket(-1),
+    m_watched(OFFalse),
+    m_state(BUSY),
+    m_deadline(0),
+    m_queueTime(0),
+    m_connection(NULL)
+{
+}
+
+// ----------------------------------------------------------------------------
+
+DcmBaseSCPReactor::DcmBaseSCPSession::~DcmBaseSCPSession()
+{
+  // do nothing
+}
+
+#endif // WITH_THREADS && !_WIN32
@@ -76,3 +76,67 @@ OFCondition DcmThreadSCP::run(T_ASC_Association* incomingAssoc)
   return result;
 
 }
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmThreadSCP::negotiate(T_ASC_Association* incomingAssoc,
+                                    OFBool& acknowledged)
+{
+  acknowledged = OFFalse;
+  if (incomingAssoc == NULL)
+  {
+    DCMNET_ERROR("Illegal Association handed to DcmSCP's negotiate(assoc) method");
+    return DIMSE_ILLEGALASSOCIATION;
+  }
+  if (isConnected())
+    return DIMSE_ILLEGALASSOCIATION;
+
+  m_assoc = incomingAssoc;
+
+  OFCondition result = respondToAssociationRQ(acknowledged);
+  if (result.bad() || !acknowledged)
+  {
+    acknowledged = OFFalse;
+    notifyAssociationTermination();
+  }
+  return result;
+}
+
+// ----------------------------------------------------------------------------
+
+OFCondition DcmThreadSCP::processNextCommand()
+{
+  return receiveAndHandleCommand();
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmThreadSCP::endAssociation(const OFCondition& reason)
+{
+  if (isConnected())
+  {
+    // the caller waits for the peer to close the connection
+    handleAssociationTermination(reason, OFFalse /* waitForClose */);
+    notifyAssociationTermination();
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void DcmThreadSCP::dropAssociation()
+{
+  if (m_assoc)
+  {
+    ASC_dropSCPAssociation(m_assoc, 0 /* do not wait */);
+    ASC_destroyAssociation(&m_assoc);
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+DcmTransportConnection* DcmThreadSCP::getTransportConnection()
+{
+  if (m_assoc == NULL)
+    return NULL;
+  return DUL_getTransportConnection(m_assoc->DULassociation);
+}
@@ -54,6 +54,10 @@ DcmSCU::DcmSCU()
     , m_verbosePCMode(OFFalse)
     , m_datasetConversionMode(OFFalse)
     , m_progressNotificationMode(OFTrue)
+    , m_maxOperationsInvoked(1)
+    , m_socketOptions()
+    , m_outstandingStoreRequests()
+    , m_receivedStoreResponses()
 {
     OFStandard::initializeNetwork();
 }
@@ -83,6 +87,9 @@ void DcmSCU::freeNetwork()
     // Cleanup old DIMSE request if any
     delete m_openDIMSERequest;
     m_openDIMSERequest = NULL;
+    // Forget about outstanding C-STORE requests and responses (if any)
+    m_outstandingStoreRequests.clear();
+    m_receivedStoreResponses.clear();
 }
 
 DcmSCU::~DcmSCU()
@@ -131,6 +138,14 @@ OFCondition DcmSCU::initNetwork()
     /* structure. The default values are "ANY-SCU" and "ANY-SCP". */
     ASC_setAPTitles(m_params, m_ourAETitle.c_str(), m_peerAETitle.c_str(), NULL);
 
+    /* propose asynchronous operations window (if requested). This SCU does not */
+    /* perform any operations asynchronously, i.e. they are performed one by one. */
+    if (m_maxOperationsInvoked != 1)
+        ASC_setAsyncOperationsWindow(m_params, m_maxOperationsInvoked, 1);
+
+    /* set the TCP tuning parameters, may be overridden by the association configuration */
+    ASC_setSocketOptions(m_params, m_socketOptions);
+
     /* Figure out the presentation addresses and copy the */
     /* corresponding values into the association parameters.*/
     DIC_NODENAME peerHost;
@@ -316,6 +331,30 @@ OFCondition DcmSCU::addPresentationContext(const OFString& abstractSyntax,
                                            const T_ASC_SC_ROLE role)
 
 {
+    /* do not propose exactly the same presentation context twice (e.g. when a context
+     * is added again before renegotiating an association), but keep contexts with the
+     * same abstract syntax and different transfer syntaxes, which are proposed on purpose
+     */
+    OFListConstIterator(DcmSCUPresContext) contIt = m_presContexts.begin();
+    while (contIt != m_presContexts.end())
+    {
+        OFBool same = (contIt->abstractSyntaxName == abstractSyntax) && (contIt->roleSelect == role) &&
+                      (contIt->transferSyntaxes.size() == xferSyntaxes.size());
+        OFListConstIterator(OFString) xfer  = contIt->transferSyntaxes.begin();
+        OFListConstIterator(OFString) other = xferSyntaxes.begin();
+        while (same && (other != xferSyntaxes.end()))
+        {
+            same = (*xfer == *other);
+            xfer++;
+            other++;
+        }
+        if (same)
+        {
+            DCMNET_TRACE("Presentation context for " << abstractSyntax << " has already been added, ignoring");
+            return EC_Normal;
+        }
+        contIt++;
+    }
 
     DcmSCUPresContext presContext;
     presContext.abstractSyntaxName          = abstractSyntax;
@@ -678,22 +717,17 @@ OFCondition DcmSCU::sendECHORequest(const T_ASC_PresentationContextID presID)
 /*                            C-STORE functionality                          */
 /* ************************************************************************* */
 
-// Sends C-STORE request to another DICOM application
-OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
-                                     const OFFilename& dicomFile,
-                                     DcmDataset* dataset,
-                                     Uint16& rspStatusCode,
-                                     const OFString& moveOriginatorAETitle,
-                                     const Uint16 moveOriginatorMsgID)
+// Sends C-STORE request to another DICOM application (without receiving the response)
+OFCondition DcmSCU::sendSTORERequestMessage(const T_ASC_PresentationContextID presID,
+                                            const OFFilename& dicomFile,
+                                            DcmDataset* dataset,
+                                            Uint16& messageID,
+                                            const OFString& moveOriginatorAETitle,
+                                            const Uint16 moveOriginatorMsgID)
 {
-    // Do some basic validity checks
-    if (!isConnected())
-        return DIMSE_ILLEGALASSOCIATION;
-
     OFCondition cond;
     OFString tempStr;
     T_ASC_PresentationContextID pcid = presID;
-    DcmDataset* statusDetail         = NULL;
     T_DIMSE_Message msg;
     // Make sure everything is zeroed (especially options)
     memset((char*)&msg, 0, sizeof(msg));
@@ -710,6 +744,11 @@ OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
         fileformat = new DcmFileFormat();
         if (fileformat == NULL)
             return EC_MemoryExhausted;
+        /* Large element values (e.g. pixel data) are not loaded into memory (see default
+         * value of parameter 'maxReadLength') but read from file in chunks while the dataset
+         * is sent, so that the memory needed does not depend on the size of the SOP instance
+         * (unless the transfer syntax has to be converted, see below).
+         */
         cond = fileformat->loadFile(dicomFile);
         if (cond.bad())
         {
@@ -832,7 +871,20 @@ OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
         return cond;
     }
 
-    /* Receive response */
+    /* Remember request until the response is received */
+    messageID = req->MessageID;
+    m_outstandingStoreRequests.push_back(messageID);
+    return cond;
+}
+
+// Receives the next C-STORE response and matches it with the outstanding requests
+OFCondition DcmSCU::receiveSTOREResponseMessage(Uint16& messageIDRespondedTo,
+                                                Uint16& rspStatusCode)
+{
+    OFCondition cond;
+    OFString tempStr;
+    T_ASC_PresentationContextID pcid = 0;
+    DcmDataset* statusDetail         = NULL;
     T_DIMSE_Message rsp;
     // Make sure everything is zeroed (especially options)
     memset((char*)&rsp, 0, sizeof(rsp));
@@ -840,6 +892,8 @@ OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
     if (cond.bad())
     {
         DCMNET_ERROR("Failed receiving DIMSE response: " << DimseCondition::dump(tempStr, cond));
+        /* The responses to the outstanding requests cannot be matched anymore */
+        discardOutstandingSTORERequests();
         return cond;
     }
 
@@ -862,19 +916,139 @@ OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
                      << OFstatic_cast(unsigned int, rsp.CommandField));
         DCMNET_DEBUG(DIMSE_dumpMessage(tempStr, rsp, DIMSE_INCOMING, NULL, pcid));
         delete statusDetail;
+        discardOutstandingSTORERequests();
         return DIMSE_BADCOMMANDTYPE;
     }
     T_DIMSE_C_StoreRSP storeRsp = rsp.msg.CStoreRSP;
     rspStatusCode               = storeRsp.DimseStatus;
+    messageIDRespondedTo        = storeRsp.MessageIDBeingRespondedTo;
     if (statusDetail != NULL)
     {
         DCMNET_DEBUG("Response has status detail:" << OFendl << DcmObject::PrintHelper(*statusDetail));
         delete statusDetail;
     }
 
+    /* Find the request the response refers to */
+    OFListIterator(Uint16) it = m_outstandingStoreRequests.begin();
+    while ((it != m_outstandingStoreRequests.end()) && (*it != messageIDRespondedTo))
+        ++it;
+    if (it == m_outstandingStoreRequests.end())
+    {
+        if (m_outstandingStoreRequests.size() != 1)
+        {
+            char buf[256];
+            OFStandard::snprintf(buf, sizeof(buf), "DIMSE: Unexpected Response MsgId: %d (no such outstanding C-STORE request)",
+                OFstatic_cast(int, messageIDRespondedTo));
+            discardOutstandingSTORERequests();
+            return makeDcmnetCondition(DIMSEC_UNEXPECTEDRESPONSE, OF_error, buf);
+        }
+        /* For compatibility reasons, accept a wrong ID if there is only one request */
+        DCMNET_WARN("Received C-STORE response with unexpected MsgId " << messageIDRespondedTo
+            << " (expected " << m_outstandingStoreRequests.front() << ")");
+        messageIDRespondedTo = m_outstandingStoreRequests.front();
+        it = m_outstandingStoreRequests.begin();
+    }
+    m_outstandingStoreRequests.erase(it);
+
+    return cond;
+}
+
+// Forgets about the outstanding C-STORE requests after an error
+void DcmSCU::discardOutstandingSTORERequests()
+{
+    if (!m_outstandingStoreRequests.empty())
+    {
+        DCMNET_WARN("Discarding " << m_outstandingStoreRequests.size()
+            << " outstanding C-STORE request(s), the response(s) will not be received");
+        m_outstandingStoreRequests.clear();
+    }
+}
+
+// Sends C-STORE request to another DICOM application and receives the response
+OFCondition DcmSCU::sendSTORERequest(const T_ASC_PresentationContextID presID,
+                                     const OFFilename& dicomFile,
+                                     DcmDataset* dataset,
+                                     Uint16& rspStatusCode,
+                                     const OFString& moveOriginatorAETitle,
+                                     const Uint16 moveOriginatorMsgID)
+{
+    // Do some basic validity checks
+    if (!isConnected())
+        return DIMSE_ILLEGALASSOCIATION;
+
+    /* Send request */
+    Uint16 messageID = 0;
+    OFCondition cond = sendSTORERequestMessage(presID, dicomFile, dataset, messageID,
+        moveOriginatorAETitle, moveOriginatorMsgID);
+    if (cond.bad())
+        return cond;
+
+    /* Receive response, keep responses to other (asynchronous) requests for later */
+    Uint16 messageIDRespondedTo = 0;
+    Uint16 statusCode = 0;
+    do {
+        cond = receiveSTOREResponseMessage(messageIDRespondedTo, statusCode);
+        if (cond.bad())
+            return cond;
+        if (messageIDRespondedTo != messageID)
+            m_receivedStoreResponses.push_back(DcmSCUStoreResponse(messageIDRespondedTo, statusCode));
+    } while (messageIDRespondedTo != messageID);
+    rspStatusCode = statusCode;
+
     return cond;
 }
 
+// Sends C-STORE request to another DICOM application without waiting for the response
+OFCondition DcmSCU::sendSTORERequestAsync(const T_ASC_PresentationContextID presID,
+                                          const OFFilename& dicomFile,
+                                          DcmDataset* dataset,
+                                          Uint16& messageID,
+                                          const OFString& moveOriginatorAETitle,
+                                          const Uint16 moveOriginatorMsgID)
+{
+    // Do some basic validity checks
+    if (!isConnected())
+        return DIMSE_ILLEGALASSOCIATION;
+
+    OFCondition cond;
+    /* Make sure that the negotiated window is not exceeded */
+    const Uint16 maxOps = getNegotiatedMaxOperationsInvoked();
+    while ((maxOps > 0) && (m_outstandingStoreRequests.size() >= maxOps))
+    {
+        Uint16 messageIDRespondedTo = 0;
+        Uint16 statusCode = 0;
+        DCMNET_DEBUG("Maximum number of outstanding C-STORE requests (" << maxOps << ") reached, "
+            << "waiting for response");
+        cond = receiveSTOREResponseMessage(messageIDRespondedTo, statusCode);
+        if (cond.bad())
+            return cond;
+        m_receivedStoreResponses.push_back(DcmSCUStoreResponse(messageIDRespondedTo, statusCode));
+    }
+    /* Send request */
+    return sendSTORERequestMessage(presID, dicomFile, dataset, messageID,
+        moveOriginatorAETitle, moveOriginatorMsgID);
+}
+
+// Receives the response to one of the outstanding C-STORE requests
+OFCondition DcmSCU::receiveSTOREResponse(Uint16& messageIDRespondedTo,
+                                         Uint16& rspStatusCode)
+{
+    /* Return responses that have already been received first */
+    if (!m_receivedStoreResponses.empty())
+    {
+        messageIDRespondedTo = m_receivedStoreResponses.front().messageID;
+        rspStatusCode        = m_receivedStoreResponses.front().statusCode;
+        m_receivedStoreResponses.pop_front();
+        return EC_Normal;
+    }
+    // Do some basic validity checks
+    if (!isConnected())
+        return DIMSE_ILLEGALASSOCIATION;
+    if (m_outstandingStoreRequests.empty())
+        return EC_IllegalCall;
+    return receiveSTOREResponseMessage(messageIDRespondedTo, rspStatusCode);
+}
+
 /* ************************************************************************* */
 /*                            C-MOVE functionality                           */
 /* ************************************************************************* */
@@ -2281,6 +2455,11 @@ void DcmSCU::setConnectionTimeout(const Sint32 connectionTimeout)
     dcmConnectionTimeout.set(connectionTimeout);
 }
 
+void DcmSCU::setSocketOptions(const T_ASC_SocketOptions& options)
+{
+    m_socketOptions = options;
+}
+
 void DcmSCU::setAssocConfigFileAndProfile(const OFString& filename, const OFString& profile)
 {
     m_assocConfigFilename = filename;
@@ -2312,6 +2491,11 @@ void DcmSCU::setProgressNotificationMode(const OFBool mode)
     m_progressNotificationMode = mode;
 }
 
+void DcmSCU::setMaxOperationsInvoked(const Uint16 maxOps)
+{
+    m_maxOperationsInvoked = maxOps;
+}
+
 /* Get methods */
 
 OFBool DcmSCU::isConnected() const
@@ -2319,6 +2503,24 @@ OFBool DcmSCU::isConnected() const
     return (m_assoc != NULL) && (m_assoc->DULassociation != NULL);
 }
 
+OFBool DcmSCU::isAssociationUsable() const
+{
+    if (!isConnected())
+        return OFFalse;
+    // data received for outstanding requests are responses
+    if (!m_outstandingStoreRequests.empty())
+        return OFTrue;
+    // otherwise, this can only be a release or abort request or the end of the connection
+    return !ASC_dataWaiting(m_assoc, 0);
+}
+
+const DcmAssociationMetrics* DcmSCU::getAssociationMetrics() const
+{
+    if (!isConnected())
+        return NULL;
+    return ASC_getAssociationMetrics(m_assoc);
+}
+
 Uint32 DcmSCU::getMaxReceivePDULength() const
 {
     return m_maxReceivePDULength;
@@ -2369,6 +2571,11 @@ Sint32 DcmSCU::getConnectionTimeout() const
     return dcmConnectionTimeout.get();
 }
 
+const T_ASC_SocketOptions& DcmSCU::getSocketOptions() const
+{
+    return m_socketOptions;
+}
+
 OFString DcmSCU::getStorageDir() const
 {
     return m_storageDir;
@@ -2394,6 +2601,29 @@ OFBool DcmSCU::getProgressNotificationMode() const
     return m_progressNotificationMode;
 }
 
+Uint16 DcmSCU::getMaxOperationsInvoked() const
+{
+    return m_maxOperationsInvoked;
+}
+
+Uint16 DcmSCU::getNegotiatedMaxOperationsInvoked() const
+{
+    Uint16 maxOps = 1;
+    if (isConnected())
+    {
+        ASC_getPeerAsyncOperationsWindow(m_params, &maxOps, NULL);
+        /* never exceed the proposed window (0 means unlimited) */
+        if ((m_maxOperationsInvoked != 0) && ((maxOps == 0) || (maxOps > m_maxOperationsInvoked)))
+            maxOps = m_maxOperationsInvoked;
+    }
+    return maxOps;
+}
+
+size_t DcmSCU::getNumberOfOutstandingSTORERequests() const
+{
+    return m_outstandingStoreRequests.size();
+}
+
 OFCondition DcmSCU::getDatasetInfo(DcmDataset* dataset,
                                    OFString& sopClassUID,
                                    OFString& sopInstanceUID,
@@ -0,0 +1,389 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Class maintaining a pool of established associations that
+ *           can be reused by subsequent (and concurrent) senders
+ *
+ */
+
+#include "dcmtk/config/osconfig.h" /* make sure OS specific configuration is included first */
+
+#include "dcmtk/dcmnet/scupool.h"
+#include "dcmtk/dcmnet/diutil.h"
+
+
+DcmSCUPool::DcmSCUPool()
+: m_mutex()
+, m_idle()
+, m_busy()
+, m_idleTimeout(60)
+, m_maxIdle(8)
+{
+}
+
+
+DcmSCUPool::~DcmSCUPool()
+{
+  if (!m_busy.empty())
+    DCMNET_WARN("SCU pool destroyed while " << m_busy.size() << " association(s) still in use");
+  closeIdleAssociations();
+  // the SCUs in use cannot be deleted since they are still referenced by the caller,
+  // so only the pool's bookkeeping is removed
+  while (!m_busy.empty())
+  {
+    delete m_busy.front();
+    m_busy.pop_front();
+  }
+}
+
+
+OFCondition DcmSCUPool::acquireSCU(const OFString& peerHostName,
+                                   const Uint16 peerPort,
+                                   const OFString& aeTitle,
+                                   const OFString& peerAETitle,
+                                   const OFString& abstractSyntax,
+                                   const OFList<OFString>& xferSyntaxes,
+                                   DcmSCU*& scu,
+                                   T_ASC_PresentationContextID& presID)
+{
+  scu = NULL;
+  presID = 0;
+  if (xferSyntaxes.empty())
+    return NET_EC_NoPresentationContextsDefined;
+
+  Entry* entry = NULL;
+  OFBool renegotiate = OFFalse;
+  OFBool rejected = OFFalse;
+  OFList<Entry*> unusable;
+  m_mutex.lock();
+  removeExpiredEntries(unusable);
+  OFListIterator(Entry*) it = m_idle.begin();
+  while (it != m_idle.end())
+  {
+    if ((*it)->matches(peerHostName, peerPort, aeTitle, peerAETitle))
+    {
+      if (!(*it)->scu->isAssociationUsable())
+      {
+        // the peer closed the association while it was idle
+        unusable.push_back(*it);
+        it = m_idle.erase(it);
+        continue;
+      }
+      presID = findPresentationContext(*(*it)->scu, abstractSyntax, xferSyntaxes);
+      if (presID != 0)
+      {
+        // the most recently used association with the required presentation context
+        entry = *it;
+        renegotiate = OFFalse;
+        m_idle.erase(it);
+        break;
+      }
+      if ((*it)->isRejected(abstractSyntax))
+      {
+        // the peer has already rejected the abstract syntax on this association,
+        // so renegotiating it (or negotiating a new one) would be pointless
+        rejected = OFTrue;
+      }
+      // remember the first association to the same peer, which is renegotiated
+      // if there is no association with the required presentation context
+      else if (entry == NULL)
+      {
+        entry = *it;
+        renegotiate = OFTrue;
+      }
+    }
+    ++it;
+  }
+  if ((entry == NULL) && rejected)
+  {
+    m_mutex.unlock();
+    closeEntries(unusable, OFTrue /* abort */);
+    DCMNET_DEBUG("Presentation context for " << abstractSyntax << " already rejected by " << peerAETitle);
+    return NET_EC_NoAcceptablePresentationContexts;
+  }
+  if (renegotiate)
+    m_idle.remove(entry);
+  if (entry == NULL)
+    entry = new Entry(peerHostName, peerPort, aeTitle, peerAETitle);
+  m_busy.push_back(entry);
+  m_mutex.unlock();
+
+  // close the associations that are no longer needed (outside of the lock)
+  closeEntries(unusable, OFTrue /* abort */);
+
+  OFCondition cond = EC_Normal;
+  if (entry->scu == NULL)
+  {
+    // negotiate a new association
+    entry->scu = createSCU();
+    entry->scu->setPeerHostName(peerHostName);
+    entry->scu->setPeerPort(peerPort);
+    entry->scu->setAETitle(aeTitle);
+    entry->scu->setPeerAETitle(peerAETitle);
+    cond = entry->scu->addPresentationContext(abstractSyntax, xferSyntaxes);
+    if (cond.good())
+      cond = negotiate(*entry);
+  }
+  else if (renegotiate)
+  {
+    // the association has been negotiated without the presentation context that is
+    // needed now, so negotiate it again with the additional presentation context
+    DCMNET_DEBUG("Renegotiating pooled association to " << peerAETitle << " for " << abstractSyntax);
+    entry->scu->releaseAssociation();
+    cond = entry->scu->addPresentationContext(abstractSyntax, xferSyntaxes);
+    if (cond.good())
+      cond = negotiate(*entry);
+  }
+  else
+    DCMNET_DEBUG("Reusing pooled association to " << peerAETitle);
+
+  // an association on which the peer did not accept any presentation context is
+  // kept as well, so that the rejection is remembered for subsequent requests
+  if ((cond == NET_EC_NoAcceptablePresentationContexts) && entry->scu->isConnected())
+    cond = EC_Normal;
+
+  if (cond.good())
+  {
+    presID = findPresentationContext(*entry->scu, abstractSyntax, xferSyntaxes);
+    if (presID == 0)
+    {
+      // the association can still be used for other presentation contexts
+      DCMNET_DEBUG("Presentation context for " << abstractSyntax << " not accepted by " << peerAETitle);
+      entry->rejected.push_back(abstractSyntax);
+      scu = entry->scu;
+      releaseSCU(scu);
+      return NET_EC_NoAcceptablePresentationContexts;
+    }
+    scu = entry->scu;
+  }
+  else
+  {
+    m_mutex.lock();
+    m_busy.remove(entry);
+    m_mutex.unlock();
+    delete entry->scu;
+    delete entry;
+  }
+  return cond;
+}
+
+
+void DcmSCUPool::releaseSCU(DcmSCU*& scu)
+{
+  if (scu == NULL)
+    return;
+  OFList<Entry*> closing;
+  m_mutex.lock();
+  Entry* entry = removeBusyEntry(scu);
+  if (entry == NULL)
+  {
+    m_mutex.unlock();
+    DCMNET_ERROR("SCU returned to a pool it does not belong to (ignored)");
+    return;
+  }
+  if (entry->scu->isAssociationUsable() && (m_idleTimeout > 0) && (m_maxIdle > 0))
+  {
+    entry->lastUsed = time(NULL);
+    m_idle.push_front(entry);
+    // release the least recently used associations if there are too many
+    while (m_idle.size() > m_maxIdle)
+    {
+      closing.push_back(m_idle.back());
+      m_idle.pop_back();
+    }
+    removeExpiredEntries(closing);
+  }
+  else
+    closing.push_back(entry);
+  m_mutex.unlock();
+  closeEntries(closing, OFFalse /* release */);
+  scu = NULL;
+}
+
+
+void DcmSCUPool::discardSCU(DcmSCU*& scu)
+{
+  if (scu == NULL)
+    return;
+  OFList<Entry*> closing;
+  m_mutex.lock();
+  Entry* entry = removeBusyEntry(scu);
+  m_mutex.unlock();
+  if (entry == NULL)
+  {
+    DCMNET_ERROR("SCU returned to a pool it does not belong to (ignored)");
+    return;
+  }
+  closing.push_back(entry);
+  closeEntries(closing, OFTrue /* abort */);
+  scu = NULL;
+}
+
+
+size_t DcmSCUPool::closeExpiredAssociations()
+{
+  OFList<Entry*> expired;
+  m_mutex.lock();
+  removeExpiredEntries(expired);
+  m_mutex.unlock();
+  const size_t count = expired.size();
+  closeEntries(expired, OFFalse /* release */);
+  return count;
+}
+
+
+void DcmSCUPool::closeIdleAssociations()
+{
+  OFList<Entry*> idle;
+  m_mutex.lock();
+  idle = m_idle;
+  m_idle.clear();
+  m_mutex.unlock();
+  closeEntries(idle, OFFalse /* release */);
+}
+
+
+void DcmSCUPool::setIdleTimeout(const Uint32 seconds)
+{
+  m_mutex.lock();
+  m_idleTimeout = seconds;
+  m_mutex.unlock();
+}
+
+
+void DcmSCUPool::setMaxIdleAssociations(const size_t count)
+{
+  m_mutex.lock();
+  m_maxIdle = count;
+  m_mutex.unlock();
+}
+
+
+Uint32 DcmSCUPool::getIdleTimeout() const
+{
+  m_mutex.lock();
+  const Uint32 result = m_idleTimeout;
+  m_mutex.unlock();
+  return result;
+}
+
+
+size_t DcmSCUPool::getMaxIdleAssociations() const
+{
+  m_mutex.lock();
+  const size_t result = m_maxIdle;
+  m_mutex.unlock();
+  return result;
+}
+
+
+size_t DcmSCUPool::getNumberOfIdleAssociations() const
+{
+  m_mutex.lock();
+  const size_t result = m_idle.size();
+  m_mutex.unlock();
+  return result;
+}
+
+
+DcmSCU* DcmSCUPool::createSCU()
+{
+  return new DcmSCU();
+}
+
+
+T_ASC_PresentationContextID DcmSCUPool::findPresentationContext(DcmSCU& scu,
+                                                                const OFString& abstractSyntax,
+                                                                const OFList<OFString>& xferSyntaxes)
+{
+  // prefer the transfer syntaxes in the given order
+  for (OFListConstIterator(OFString) it = xferSyntaxes.begin(); it != xferSyntaxes.end(); ++it)
+  {
+    const T_ASC_PresentationContextID presID = scu.findPresentationContextID(abstractSyntax, *it);
+    if (presID != 0)
+      return presID;
+  }
+  return 0;
+}
+
+
+OFCondition DcmSCUPool::negotiate(Entry& entry)
+{
+  OFCondition cond = entry.scu->initNetwork();
+  if (cond.good())
+    cond = entry.scu->negotiateAssociation();
+  if (cond.bad())
+  {
+    OFString tempStr;
+    DCMNET_ERROR("Cannot negotiate association to " << entry.peerAETitle << " at "
+      << entry.peer << ":" << entry.port << ": " << DimseCondition::dump(tempStr, cond));
+  }
+  return cond;
+}
+
+
+void DcmSCUPool::removeExpiredEntries(OFList<Entry*>& expired)
+{
+  const time_t now = time(NULL);
+  OFListIterator(Entry*) it = m_idle.begin();
+  while (it != m_idle.end())
+  {
+    // also handle a system clock that has been set back
+    if ((now < (*it)->lastUsed) || (OFstatic_cast(Uint32, now - (*it)->lastUsed) >= m_idleTimeout))
+    {
+      expired.push_back(*it);
+      it = m_idle.erase(it);
+    }
+    else
+      ++it;
+  }
+}
+
+
+void DcmSCUPool::closeEntries(OFList<Entry*>& entries,
+                              const OFBool abort)
+{
+  while (!entries.empty())
+  {
+    Entry* entry = entries.front();
+    entries.pop_front();
+    if (entry->scu->isConnected())
+    {
+      if (abort || !entry->scu->isAssociationUsable())
+        entry->scu->abortAssociation();
+      else
+        entry->scu->releaseAssociation();
+    }
+    delete entry->scu;
+    delete entry;
+  }
+}
+
+
+DcmSCUPool::Entry* DcmSCUPool::removeBusyEntry(const DcmSCU* scu)
+{
+  for (OFListIterator(Entry*) it = m_busy.begin(); it != m_busy.end(); ++it)
+  {
+    if ((*it)->scu == scu)
+    {
+      Entry* entry = *it;
+      m_busy.erase(it);
+      return entry;
+    }
+  }
+  return NULL;
+}
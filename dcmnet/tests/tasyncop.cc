@@ -0,0 +1,311 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test negotiation and use of the Asynchronous Operations Window
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmnet/scp.h"
+#include "dcmtk/dcmnet/dstorscu.h"
+
+
+/// port used by the tests in this file
+#define ASYNC_TEST_PORT 11116
+
+/// number of SOP instances sent in each test
+#define ASYNC_TEST_INSTANCES 12
+
+
+/** Storage SCP that accepts C-STORE requests (without storing the datasets)
+ *  and handles exactly one association in a separate thread
+ */
+struct AsyncStoreSCP : DcmSCP, OFThread
+{
+    AsyncStoreSCP()
+      : DcmSCP()
+      , m_listen_result(EC_NotYetImplemented)
+      , m_received(0)
+      , m_abortAfter(0)
+    {
+        DcmSCPConfig& config = getConfig();
+        config.setPort(ASYNC_TEST_PORT);
+        config.setAETitle("ASYNC_SCP");
+        config.setConnectionBlockingMode(DUL_NOBLOCK);
+        config.setConnectionTimeout(10);
+        OFList<OFString> xfers;
+        xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+        xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+        OFCHECK(config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    }
+
+    virtual OFCondition handleIncomingCommand(T_DIMSE_Message* incomingMsg,
+                                              const DcmPresentationContextInfo& presInfo)
+    {
+        if (incomingMsg->CommandField == DIMSE_C_STORE_RQ)
+        {
+            T_DIMSE_C_StoreRQ& req = incomingMsg->msg.CStoreRQ;
+            DcmDataset* dataset = NULL;
+            OFCondition cond = receiveSTORERequest(req, presInfo.presentationContextID, dataset);
+            delete dataset;
+            if (cond.good())
+            {
+                ++m_received;
+                // abort the association without sending a response (if requested)
+                if (m_received == m_abortAfter)
+                    return DIMSE_ILLEGALASSOCIATION;
+                cond = sendSTOREResponse(presInfo.presentationContextID, req, STATUS_Success);
+            }
+            return cond;
+        }
+        return DcmSCP::handleIncomingCommand(incomingMsg, presInfo);
+    }
+
+    virtual OFBool stopAfterCurrentAssociation()
+    {
+        return OFTrue;
+    }
+
+    virtual OFBool stopAfterConnectionTimeout()
+    {
+        return OFTrue;
+    }
+
+    virtual void run()
+    {
+        m_listen_result = listen();
+    }
+
+    /// result returned by listen()
+    OFCondition m_listen_result;
+    /// number of C-STORE requests received
+    size_t m_received;
+    /// abort the association instead of responding to this request (0 = never)
+    size_t m_abortAfter;
+};
+
+
+/** Storage SCU that counts the SOP instances processed
+ */
+struct CountingStorageSCU : DcmStorageSCU
+{
+    CountingStorageSCU()
+      : DcmStorageSCU()
+      , m_sent(0)
+      , m_success(0)
+    {
+    }
+
+    virtual void notifySOPInstanceSent(const TransferEntry& transferEntry)
+    {
+        ++m_sent;
+        if (transferEntry.RequestSent && (transferEntry.ResponseStatusCode == STATUS_Success))
+            ++m_success;
+    }
+
+    /// number of SOP instances processed
+    size_t m_sent;
+    /// number of SOP instances stored successfully
+    size_t m_success;
+};
+
+
+// create a small dataset that can be sent to the storage SCP
+static DcmDataset* createDataset(const size_t number)
+{
+    char uid[100];
+    char buffer[16];
+    OFStandard::snprintf(buffer, sizeof(buffer), "%u", OFstatic_cast(unsigned int, number));
+    DcmDataset* dset = new DcmDataset();
+    OFCHECK(dset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT)).good());
+    OFCHECK(dset->putAndInsertString(DCM_InstanceNumber, buffer).good());
+    OFCHECK(dset->putAndInsertString(DCM_PatientName, "Async^Test").good());
+    return dset;
+}
+
+
+// configure SCU for the test SCP
+static void configureSCU(DcmSCU& scu, const Uint16 maxOps)
+{
+    scu.setAETitle("ASYNC_SCU");
+    scu.setPeerAETitle("ASYNC_SCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(ASYNC_TEST_PORT);
+    scu.setMaxOperationsInvoked(maxOps);
+}
+
+
+// send the datasets with the given SCU and check the negotiated window
+static void sendAsync(const Uint16 proposed, const Uint16 accepted, const Uint16 expected)
+{
+    AsyncStoreSCP scp;
+    scp.setMaxOperationsPerformed(accepted);
+    scp.start();
+    OFStandard::sleep(1);
+
+    DcmSCU scu;
+    configureSCU(scu, proposed);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    OFCHECK(scu.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+    OFCHECK_EQUAL(scu.getNegotiatedMaxOperationsInvoked(), expected);
+
+    const T_ASC_PresentationContextID presID = scu.findAnyPresentationContextID(UID_SecondaryCaptureImageStorage, UID_LittleEndianExplicitTransferSyntax);
+    OFCHECK(presID != 0);
+    OFList<Uint16> messageIDs;
+    size_t responses = 0;
+    Uint16 messageID = 0;
+    Uint16 status = 0;
+    for (size_t i = 0; i < ASYNC_TEST_INSTANCES; ++i)
+    {
+        DcmDataset* dset = createDataset(i);
+        OFCHECK(scu.sendSTORERequestAsync(presID, "", dset, messageID).good());
+        delete dset;
+        messageIDs.push_back(messageID);
+        // the window must never be exceeded
+        OFCHECK(scu.getNumberOfOutstandingSTORERequests() <= ((expected == 0) ? ASYNC_TEST_INSTANCES : expected));
+        // receive a response from time to time
+        if (i % 5 == 4)
+        {
+            OFCHECK(scu.receiveSTOREResponse(messageID, status).good());
+            OFCHECK_EQUAL(status, STATUS_Success);
+            messageIDs.remove(messageID);
+            ++responses;
+        }
+    }
+    // receive all remaining responses, each message ID is responded to exactly once
+    while (scu.getNumberOfOutstandingSTORERequests() > 0)
+    {
+        OFCHECK(scu.receiveSTOREResponse(messageID, status).good());
+        OFCHECK_EQUAL(status, STATUS_Success);
+        const size_t count = messageIDs.size();
+        messageIDs.remove(messageID);
+        OFCHECK_EQUAL(messageIDs.size(), count - 1);
+        ++responses;
+    }
+    OFCHECK(messageIDs.empty());
+    OFCHECK_EQUAL(responses, ASYNC_TEST_INSTANCES);
+    OFCHECK(scu.receiveSTOREResponse(messageID, status) == EC_IllegalCall);
+    // synchronous requests still work on the same association
+    DcmDataset* dset = createDataset(ASYNC_TEST_INSTANCES);
+    OFCHECK(scu.sendSTORERequest(presID, "", dset, status).good());
+    OFCHECK_EQUAL(status, STATUS_Success);
+    delete dset;
+    OFCHECK(scu.releaseAssociation().good());
+    scp.join();
+    OFCHECK_EQUAL(scp.m_received, ASYNC_TEST_INSTANCES + 1);
+}
+
+
+OFTEST_FLAGS(dcmnet_async_operations_window, EF_Slow)
+{
+    // window proposed, SCP limits it
+    sendAsync(4, 3, 3);
+    // window proposed, SCP allows more
+    sendAsync(5, 0, 5);
+    // unlimited window proposed and accepted
+    sendAsync(0, 0, 0);
+    // window proposed, but not supported by the SCP
+    sendAsync(4, 1, 1);
+    // no window proposed
+    sendAsync(1, 8, 1);
+}
+
+
+// send the given number of datasets with the storage SCU
+static void sendStorageSCU(const Uint16 proposed, const Uint16 accepted, const Uint16 expected, const size_t instances)
+{
+    AsyncStoreSCP scp;
+    scp.setMaxOperationsPerformed(accepted);
+    scp.start();
+    OFStandard::sleep(1);
+
+    CountingStorageSCU scu;
+    configureSCU(scu, proposed);
+    for (size_t i = 0; i < instances; ++i)
+        OFCHECK(scu.addDataset(createDataset(i), EXS_LittleEndianExplicit, DcmStorageSCU::HM_deleteAfterRemove).good());
+    OFCHECK(scu.addPresentationContexts().good());
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+    OFCHECK_EQUAL(scu.getNegotiatedMaxOperationsInvoked(), expected);
+    OFCHECK(scu.sendSOPInstances().good());
+    OFCHECK_EQUAL(scu.getNumberOfOutstandingSTORERequests(), 0);
+    OFCHECK_EQUAL(scu.m_sent, instances);
+    OFCHECK_EQUAL(scu.m_success, instances);
+    OFCHECK(scu.releaseAssociation().good());
+    scp.join();
+    OFCHECK_EQUAL(scp.m_received, instances);
+}
+
+
+OFTEST_FLAGS(dcmnet_async_storage_scu, EF_Slow)
+{
+    // window limited by the SCP
+    sendStorageSCU(8, 4, 4, ASYNC_TEST_INSTANCES);
+    // unlimited window, the number of outstanding requests is still limited
+    sendStorageSCU(0, 0, 0, 1000);
+}
+
+
+OFTEST_FLAGS(dcmnet_async_operations_abort, EF_Slow)
+{
+    AsyncStoreSCP scp;
+    scp.setMaxOperationsPerformed(0);
+    scp.m_abortAfter = 3;
+    scp.start();
+    OFStandard::sleep(1);
+
+    DcmSCU scu;
+    configureSCU(scu, 8);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    OFCHECK(scu.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+    const T_ASC_PresentationContextID presID = scu.findAnyPresentationContextID(UID_SecondaryCaptureImageStorage, UID_LittleEndianExplicitTransferSyntax);
+    Uint16 messageID = 0;
+    Uint16 status = 0;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        DcmDataset* dset = createDataset(i);
+        // the last request may fail, since the SCP aborts the association
+        OFCondition cond = scu.sendSTORERequestAsync(presID, "", dset, messageID);
+        OFCHECK(cond.good() || (i == 3));
+        delete dset;
+    }
+    // the responses to the first two requests are received
+    OFCHECK(scu.receiveSTOREResponse(messageID, status).good());
+    OFCHECK(scu.receiveSTOREResponse(messageID, status).good());
+    // the other requests are discarded after the association has been aborted
+    OFCHECK(scu.receiveSTOREResponse(messageID, status).bad());
+    OFCHECK_EQUAL(scu.getNumberOfOutstandingSTORERequests(), 0);
+    scu.closeAssociation(DCMSCU_PEER_ABORTED_ASSOCIATION);
+    scp.join();
+    OFCHECK_EQUAL(scp.m_received, 3);
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,1045 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Benchmark measuring DIMSE latency and throughput between an
+ *           in-process SCP pool and SCU over the loopback interface
+ *
+ *  The benchmark is not part of the unit tests since its results depend on
+ *  the machine it is run on. Typical usage is to run it once for a reference
+ *  version of the toolkit and once for the version to be compared, e.g.
+ *
+ *    dcmnet_bench --output-file before.json
+ *    dcmnet_bench --quick --output-csv
+ *
+ *  The Nagle algorithm is disabled for SCP and SCU (TCP_NODELAY), since it
+ *  results in latencies in the order of the delayed acknowledgement timeout
+ *  for small messages. Option --with-nagle additionally runs all scenarios
+ *  with the Nagle algorithm enabled.
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/ofconapp.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/oftimer.h"
+#include "dcmtk/ofstd/ofdatime.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/ofstd/ofstream.h"
+#include "dcmtk/dcmdata/dcdict.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmdata/cmdlnarg.h"
+#include "dcmtk/dcmnet/diutil.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/scu.h"
+
+#ifdef WITH_OPENSSL
+#include "dcmtk/ofstd/oftempf.h"
+#include "dcmtk/dcmtls/tlslayer.h"
+#include "dcmtk/dcmtls/tlsscu.h"
+
+BEGIN_EXTERN_C
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+END_EXTERN_C
+#endif
+
+#include <cstdlib>                    /* for qsort() */
+
+
+#define OFFIS_CONSOLE_APPLICATION "dcmnet_bench"
+
+static OFLogger benchLogger = OFLog::getLogger("dcmtk.tests." OFFIS_CONSOLE_APPLICATION);
+
+static char rcsid[] = "$dcmtk: " OFFIS_CONSOLE_APPLICATION " v"
+  OFFIS_DCMTK_VERSION " " OFFIS_DCMTK_RELEASEDATE " $";
+
+// exit codes for this command line tool
+// (common codes are defined in "ofexit.h" included from "ofconapp.h")
+
+// output file errors
+#define EXITCODE_CANNOT_WRITE_OUTPUT_FILE        40
+// network errors
+#define EXITCODE_CANNOT_SEND_REQUEST             62
+#define EXITCODE_CANNOT_START_SCP_AND_LISTEN     64
+#define EXITCODE_CANNOT_CREATE_TRANSPORT_LAYER   71
+
+#define SHORTCOL 4
+#define LONGCOL 20
+
+#define BENCH_SCP_AETITLE "BENCH_SCP"
+#define BENCH_SCU_AETITLE "BENCH_SCU"
+
+
+#ifdef WITH_THREADS
+
+/// settings of a benchmark run
+struct BenchmarkSettings
+{
+    BenchmarkSettings()
+      : port(11125)
+      , maxPDU(ASC_DEFAULTMAXPDU)
+      , associations(20)
+      , echoCount(1000)
+      , storeCount(50)
+      , objectSizes()
+      , concurrency()
+      , scalingSize(256 * 1024)
+      , plain(OFTrue)
+      , tls(OFTrue)
+      , tcpNoDelay(OFTrue)
+    {
+    }
+
+    /// port of the plain SCP, the TLS SCP listens on the next port
+    Uint16 port;
+    /// maximum PDU size used by SCP and SCU
+    Uint32 maxPDU;
+    /// number of associations negotiated for measuring the association setup
+    size_t associations;
+    /// number of C-ECHO requests sent on a single association
+    size_t echoCount;
+    /// number of C-STORE requests sent for each object size and SCU thread
+    size_t storeCount;
+    /// sizes of the pixel data sent with C-STORE in bytes
+    OFVector<size_t> objectSizes;
+    /// numbers of concurrent SCU threads storing objects to the SCP pool
+    OFVector<size_t> concurrency;
+    /// pixel data size used for measuring the concurrency scaling
+    size_t scalingSize;
+    /// measure unencrypted associations
+    OFBool plain;
+    /// measure TLS secured associations
+    OFBool tls;
+    /// disable the Nagle algorithm on both ends of the associations
+    OFBool tcpNoDelay;
+};
+
+
+/// result of a single benchmark scenario
+struct BenchmarkResult
+{
+    BenchmarkResult(const OFString& scenarioName,
+                    const BenchmarkSettings& settings,
+                    const OFBool secure,
+                    const size_t size,
+                    const size_t threads)
+      : scenario(scenarioName)
+      , tls(secure)
+      , tcpNoDelay(settings.tcpNoDelay)
+      , objectSize(size)
+      , concurrency(threads)
+      , failures(0)
+      , seconds(0.0)
+      , latencies()
+    {
+    }
+
+    /// name of the scenario, i.e. "associate", "echo", "store" or "store-concurrent"
+    OFString scenario;
+    /// OFTrue if the scenario has been run over TLS secured associations
+    OFBool tls;
+    /// OFTrue if the scenario has been run with the Nagle algorithm disabled
+    OFBool tcpNoDelay;
+    /// size of the pixel data sent with each C-STORE request, 0 for other scenarios
+    size_t objectSize;
+    /// number of SCU threads running concurrently
+    size_t concurrency;
+    /// number of failed operations
+    size_t failures;
+    /// wall clock time needed for all operations in seconds
+    double seconds;
+    /// latencies of the successful operations in seconds
+    OFVector<double> latencies;
+};
+
+
+/** SCP worker answering C-ECHO and C-STORE requests. The datasets received are
+ *  kept in memory and discarded immediately so that only the network and DIMSE
+ *  layers are measured.
+ */
+struct BenchmarkSCP : DcmThreadSCP
+{
+    virtual OFCondition handleIncomingCommand(T_DIMSE_Message* incomingMsg,
+                                              const DcmPresentationContextInfo& presInfo)
+    {
+        if (incomingMsg->CommandField == DIMSE_C_STORE_RQ)
+        {
+            T_DIMSE_C_StoreRQ& req = incomingMsg->msg.CStoreRQ;
+            DcmDataset* dataset = NULL;
+            OFCondition cond = receiveSTORERequest(req, presInfo.presentationContextID, dataset);
+            if (cond.good())
+                cond = sendSTOREResponse(presInfo.presentationContextID, req, STATUS_Success);
+            delete dataset;
+            return cond;
+        }
+        return DcmThreadSCP::handleIncomingCommand(incomingMsg, presInfo);
+    }
+};
+
+
+/// SCP pool running the BenchmarkSCP workers in a separate thread
+struct BenchmarkPool : DcmSCPPool<BenchmarkSCP>, OFThread
+{
+    BenchmarkPool() : DcmSCPPool<BenchmarkSCP>(), OFThread(), m_listen_result(EC_Normal) {}
+
+    /// result returned by listen()
+    OFCondition m_listen_result;
+
+protected:
+    virtual void run()
+    {
+        m_listen_result = listen();
+    }
+};
+
+
+/** create a dataset of the Secondary Capture Image Storage SOP Class with
+ *  pixel data of the given size
+ *  @param size size of the pixel data in bytes, rounded up to an even number
+ *  @return new dataset, to be deleted by the caller
+ */
+static DcmDataset *createDataset(const size_t size)
+{
+    char uid[100];
+    const size_t length = (size + 1) & ~OFstatic_cast(size_t, 1);
+    DcmDataset *dataset = new DcmDataset;
+    dataset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage);
+    dataset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+    dataset->putAndInsertString(DCM_StudyInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_STUDY_UID_ROOT));
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT));
+    dataset->putAndInsertString(DCM_PatientName, "Benchmark^Dataset");
+    dataset->putAndInsertString(DCM_PatientID, OFFIS_CONSOLE_APPLICATION);
+    dataset->putAndInsertString(DCM_Modality, "OT");
+    if (length > 0)
+    {
+        Uint8 *pixels = NULL;
+        if (dataset->putAndInsertUint8Array(DCM_PixelData, NULL, 0).good())
+        {
+            DcmElement *element = NULL;
+            if (dataset->findAndGetElement(DCM_PixelData, element).good() &&
+                element->createUint8Array(OFstatic_cast(Uint32, length), pixels).good())
+            {
+                for (size_t i = 0; i < length; ++i)
+                    pixels[i] = OFstatic_cast(Uint8, i * 7);
+            }
+        }
+    }
+    return dataset;
+}
+
+
+/** get the socket options used by SCP and SCU of the benchmark
+ *  @param settings benchmark settings
+ *  @return socket options switching the Nagle algorithm on or off
+ */
+static T_ASC_SocketOptions getSocketOptions(const BenchmarkSettings& settings)
+{
+    T_ASC_SocketOptions options;
+    memset(&options, 0, sizeof(options));
+    options.tcpNoDelay = settings.tcpNoDelay ? DUL_SOCKOPT_ENABLED : DUL_SOCKOPT_DISABLED;
+    return options;
+}
+
+
+/** create an SCU connecting to the plain or TLS SCP of the benchmark
+ *  @param settings benchmark settings
+ *  @param tls create a TLS SCU if OFTrue
+ *  @return new SCU with the presentation contexts needed, to be deleted by the caller
+ */
+static DcmSCU *createSCU(const BenchmarkSettings& settings, const OFBool tls)
+{
+    DcmSCU *scu = NULL;
+#ifdef WITH_OPENSSL
+    if (tls)
+    {
+        DcmTLSSCU *tlsSCU = new DcmTLSSCU;
+        // the SCP uses a self-signed certificate created for this run
+        tlsSCU->setPeerCertVerification(DCV_ignoreCertificate);
+        scu = tlsSCU;
+    }
+    else
+#endif
+        scu = new DcmSCU;
+    scu->setAETitle(BENCH_SCU_AETITLE);
+    scu->setPeerAETitle(BENCH_SCP_AETITLE);
+    scu->setPeerHostName("localhost");
+    scu->setPeerPort(OFstatic_cast(Uint16, tls ? settings.port + 1 : settings.port));
+    scu->setMaxReceivePDULength(settings.maxPDU);
+    scu->setSocketOptions(getSocketOptions(settings));
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    scu->addPresentationContext(UID_VerificationSOPClass, xfers);
+    scu->addPresentationContext(UID_SecondaryCaptureImageStorage, xfers);
+    return scu;
+}
+
+
+/** negotiate an association with the SCP of the benchmark
+ *  @param scu SCU to be connected, created by createSCU()
+ *  @return EC_Normal if the association has been accepted, an error code otherwise
+ */
+static OFCondition connectSCU(DcmSCU& scu)
+{
+    OFCondition cond = scu.initNetwork();
+    if (cond.good())
+        cond = scu.negotiateAssociation();
+    return cond;
+}
+
+
+/** send C-STORE requests on a single association and record their latencies
+ *  @param scu connected SCU
+ *  @param dataset dataset to be sent
+ *  @param count number of C-STORE requests to be sent
+ *  @param result result the latencies and failures are added to
+ */
+static void storeDatasets(DcmSCU& scu, DcmDataset *dataset, const size_t count, BenchmarkResult& result)
+{
+    const T_ASC_PresentationContextID presID =
+        scu.findAnyPresentationContextID(UID_SecondaryCaptureImageStorage, UID_LittleEndianExplicitTransferSyntax);
+    for (size_t i = 0; i < count; ++i)
+    {
+        Uint16 status = 0;
+        const double start = OFTimer::getTime();
+        OFCondition cond = scu.sendSTORERequest(presID, "", dataset, status);
+        if (cond.good() && (status == STATUS_Success))
+            result.latencies.push_back(OFTimer::getDiff(start));
+        else
+        {
+            OFLOG_ERROR(benchLogger, "C-STORE request failed: " << (cond.good() ? DU_cstoreStatusString(status) : cond.text()));
+            ++result.failures;
+            if (cond.bad())
+            {
+                // the remaining requests cannot be sent on this association
+                result.failures += count - i - 1;
+                break;
+            }
+        }
+    }
+}
+
+
+/// SCU thread storing datasets concurrently to other SCU threads
+struct BenchmarkClient : OFThread
+{
+    BenchmarkClient(const BenchmarkSettings& settings, const OFBool tls, const size_t size)
+      : OFThread()
+      , m_result("store-concurrent", settings, tls, size, 1)
+      , m_settings(settings)
+      , m_tls(tls)
+    {
+    }
+
+    /// result of this thread
+    BenchmarkResult m_result;
+
+protected:
+    virtual void run()
+    {
+        // each thread needs its own dataset since writing it changes its transfer state
+        DcmDataset *dataset = createDataset(m_result.objectSize);
+        DcmSCU *scu = createSCU(m_settings, m_tls);
+        OFCondition cond = connectSCU(*scu);
+        if (cond.good())
+        {
+            storeDatasets(*scu, dataset, m_settings.storeCount, m_result);
+            scu->releaseAssociation();
+        }
+        else
+        {
+            OFLOG_ERROR(benchLogger, "Cannot negotiate association: " << cond.text());
+            m_result.failures += m_settings.storeCount;
+        }
+        delete scu;
+        delete dataset;
+    }
+
+private:
+    const BenchmarkSettings& m_settings;
+    const OFBool m_tls;
+};
+
+
+/// measure the time needed for negotiating an association
+static BenchmarkResult benchmarkAssociate(const BenchmarkSettings& settings, const OFBool tls)
+{
+    BenchmarkResult result("associate", settings, tls, 0, 1);
+    const OFTimer timer;
+    for (size_t i = 0; i < settings.associations; ++i)
+    {
+        DcmSCU *scu = createSCU(settings, tls);
+        OFCondition cond = scu->initNetwork();
+        if (cond.good())
+        {
+            const double start = OFTimer::getTime();
+            cond = scu->negotiateAssociation();
+            if (cond.good())
+            {
+                result.latencies.push_back(OFTimer::getDiff(start));
+                scu->releaseAssociation();
+            }
+        }
+        if (cond.bad())
+        {
+            OFLOG_ERROR(benchLogger, "Cannot negotiate association: " << cond.text());
+            ++result.failures;
+        }
+        delete scu;
+    }
+    result.seconds = timer.getDiff();
+    return result;
+}
+
+
+/// measure the round trip time of C-ECHO requests on a single association
+static BenchmarkResult benchmarkEcho(const BenchmarkSettings& settings, const OFBool tls)
+{
+    BenchmarkResult result("echo", settings, tls, 0, 1);
+    DcmSCU *scu = createSCU(settings, tls);
+    OFCondition cond = connectSCU(*scu);
+    if (cond.good())
+    {
+        const T_ASC_PresentationContextID presID =
+            scu->findAnyPresentationContextID(UID_VerificationSOPClass, UID_LittleEndianExplicitTransferSyntax);
+        const OFTimer timer;
+        for (size_t i = 0; i < settings.echoCount; ++i)
+        {
+            const double start = OFTimer::getTime();
+            cond = scu->sendECHORequest(presID);
+            if (cond.bad())
+            {
+                OFLOG_ERROR(benchLogger, "C-ECHO request failed: " << cond.text());
+                result.failures += settings.echoCount - i;
+                break;
+            }
+            result.latencies.push_back(OFTimer::getDiff(start));
+        }
+        result.seconds = timer.getDiff();
+        scu->releaseAssociation();
+    }
+    else
+    {
+        OFLOG_ERROR(benchLogger, "Cannot negotiate association: " << cond.text());
+        result.failures = settings.echoCount;
+    }
+    delete scu;
+    return result;
+}
+
+
+/// measure the throughput of C-STORE requests with the given object size on a single association
+static BenchmarkResult benchmarkStore(const BenchmarkSettings& settings, const OFBool tls, const size_t size)
+{
+    BenchmarkResult result("store", settings, tls, size, 1);
+    DcmDataset *dataset = createDataset(size);
+    DcmSCU *scu = createSCU(settings, tls);
+    OFCondition cond = connectSCU(*scu);
+    if (cond.good())
+    {
+        const OFTimer timer;
+        storeDatasets(*scu, dataset, settings.storeCount, result);
+        result.seconds = timer.getDiff();
+        scu->releaseAssociation();
+    }
+    else
+    {
+        OFLOG_ERROR(benchLogger, "Cannot negotiate association: " << cond.text());
+        result.failures = settings.storeCount;
+    }
+    delete scu;
+    delete dataset;
+    return result;
+}
+
+
+/// measure the aggregated C-STORE throughput of concurrent SCU threads
+static BenchmarkResult benchmarkConcurrency(const BenchmarkSettings& settings, const OFBool tls, const size_t threads)
+{
+    BenchmarkResult result("store-concurrent", settings, tls, settings.scalingSize, threads);
+    OFVector<BenchmarkClient*> clients;
+    for (size_t i = 0; i < threads; ++i)
+        clients.push_back(new BenchmarkClient(settings, tls, settings.scalingSize));
+    const OFTimer timer;
+    for (OFVector<BenchmarkClient*>::iterator it = clients.begin(); it != clients.end(); ++it)
+        (*it)->start();
+    for (OFVector<BenchmarkClient*>::iterator it = clients.begin(); it != clients.end(); ++it)
+        (*it)->join();
+    result.seconds = timer.getDiff();
+    for (OFVector<BenchmarkClient*>::iterator it = clients.begin(); it != clients.end(); ++it)
+    {
+        const OFVector<double>& latencies = (*it)->m_result.latencies;
+        result.latencies.insert(result.latencies.end(), latencies.begin(), latencies.end());
+        result.failures += (*it)->m_result.failures;
+        delete *it;
+    }
+    return result;
+}
+
+
+/** configure an SCP pool of the benchmark, start it and wait until it accepts associations
+ *  @param pool SCP pool to be started
+ *  @param settings benchmark settings
+ *  @param tlsLayer transport layer for TLS, NULL for plain associations
+ *  @return EC_Normal if the SCP pool accepts associations, an error code otherwise
+ */
+static OFCondition startPool(BenchmarkPool& pool, const BenchmarkSettings& settings, DcmTransportLayer *tlsLayer)
+{
+    DcmSCPConfig& config = pool.getConfig();
+    config.setAETitle(BENCH_SCP_AETITLE);
+    config.setPort(OFstatic_cast(Uint16, (tlsLayer != NULL) ? settings.port + 1 : settings.port));
+    config.setMaxReceivePDULength(settings.maxPDU);
+    config.setHostLookupEnabled(OFFalse);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    config.setTransportLayer(tlsLayer);
+    config.setSocketOptions(getSocketOptions(settings));
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCondition cond = config.addPresentationContext(UID_VerificationSOPClass, xfers);
+    if (cond.good())
+        cond = config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers);
+    if (cond.bad())
+        return cond;
+    size_t maxThreads = 1;
+    for (OFVector<size_t>::const_iterator it = settings.concurrency.begin(); it != settings.concurrency.end(); ++it)
+        if (*it > maxThreads) maxThreads = *it;
+    pool.setMaxThreads(OFstatic_cast(Uint16, maxThreads));
+    pool.start();
+
+    // wait (up to 10 seconds) until the pool accepts associations
+    for (int i = 0; i < 100; ++i)
+    {
+        OFStandard::milliSleep(100);
+        if (pool.m_listen_result.bad())
+            return pool.m_listen_result;
+        DcmSCU *scu = createSCU(settings, tlsLayer != NULL);
+        cond = connectSCU(*scu);
+        if (cond.good())
+            scu->releaseAssociation();
+        delete scu;
+        if (cond.good())
+            break;
+    }
+    return cond;
+}
+
+
+/// stop an SCP pool started by startPool()
+static void stopPool(BenchmarkPool& pool)
+{
+    pool.stopAfterCurrentAssociations();
+    pool.join();
+}
+
+
+#ifdef WITH_OPENSSL
+
+/** create a private key and a self-signed certificate for the TLS SCP
+ *  @param keyFile name of the file the private key is written to (PEM format)
+ *  @param certFile name of the file the certificate is written to (PEM format)
+ *  @return OFTrue if successful, OFFalse otherwise
+ */
+static OFBool createSelfSignedCertificate(const char *keyFile, const char *certFile)
+{
+    OFBool result = OFFalse;
+    EVP_PKEY *pkey = NULL;
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL);
+    if (ctx && (EVP_PKEY_keygen_init(ctx) > 0) && (EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) > 0))
+        EVP_PKEY_keygen(ctx, &pkey);
+    EVP_PKEY_CTX_free(ctx);
+    X509 *cert = X509_new();
+    if (pkey && cert)
+    {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_get_notBefore(cert), 0);
+        X509_gmtime_adj(X509_get_notAfter(cert), 86400);
+        X509_set_pubkey(cert, pkey);
+        X509_NAME *name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, OFreinterpret_cast(const unsigned char *, "localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        if (X509_sign(cert, pkey, EVP_sha256()) > 0)
+        {
+            BIO *keyBio = BIO_new_file(keyFile, "w");
+            BIO *certBio = BIO_new_file(certFile, "w");
+            result = keyBio && certBio &&
+                PEM_write_bio_PrivateKey(keyBio, pkey, NULL, NULL, 0, NULL, NULL) &&
+                PEM_write_bio_X509(certBio, cert);
+            BIO_free(keyBio);
+            BIO_free(certBio);
+        }
+    }
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    return result;
+}
+
+#endif
+
+
+// write a floating point value independent of the current locale
+static void writeNumber(STD_NAMESPACE ostream& out, const double value, const int precision = 3)
+{
+    char buf[64];
+    OFStandard::ftoa(buf, sizeof(buf), value, OFStandard::ftoa_format_f, 0, precision);
+    out << buf;
+}
+
+
+// compare function for qsort, sorts latencies in ascending order
+static int compareLatencies(const void *a, const void *b)
+{
+    const double da = *OFstatic_cast(const double *, a);
+    const double db = *OFstatic_cast(const double *, b);
+    return (da < db) ? -1 : ((da > db) ? 1 : 0);
+}
+
+
+/// statistics derived from a benchmark result
+struct BenchmarkStatistics
+{
+    explicit BenchmarkStatistics(const BenchmarkResult& result)
+      : operations(result.latencies.size())
+      , operationsPerSecond(0.0)
+      , bytesPerSecond(0.0)
+      , min(0.0), mean(0.0), p50(0.0), p95(0.0), p99(0.0), max(0.0)
+    {
+        if (result.seconds > 0.0)
+        {
+            operationsPerSecond = OFstatic_cast(double, operations) / result.seconds;
+            bytesPerSecond = operationsPerSecond * OFstatic_cast(double, result.objectSize);
+        }
+        if (operations > 0)
+        {
+            // latencies are reported in microseconds
+            OFVector<double> sorted(result.latencies);
+            qsort(&sorted[0], sorted.size(), sizeof(double), compareLatencies);
+            double sum = 0.0;
+            for (size_t i = 0; i < operations; ++i)
+                sum += sorted[i];
+            min = sorted.front() * 1e6;
+            max = sorted.back() * 1e6;
+            mean = sum / OFstatic_cast(double, operations) * 1e6;
+            p50 = percentile(sorted, 50) * 1e6;
+            p95 = percentile(sorted, 95) * 1e6;
+            p99 = percentile(sorted, 99) * 1e6;
+        }
+    }
+
+    // nearest-rank percentile of sorted values
+    static double percentile(const OFVector<double>& sorted, const size_t p)
+    {
+        size_t rank = (p * sorted.size() + 99) / 100;
+        return sorted[(rank > 0) ? rank - 1 : 0];
+    }
+
+    size_t operations;
+    double operationsPerSecond;
+    double bytesPerSecond;
+    double min, mean, p50, p95, p99, max;
+};
+
+
+/// write the benchmark results in JSON format
+static void writeJSON(STD_NAMESPACE ostream& out,
+                      const BenchmarkSettings& settings,
+                      const OFList<BenchmarkResult>& results)
+{
+    out << "{" << OFendl;
+    out << "  \"benchmark\": \"" OFFIS_CONSOLE_APPLICATION "\"," << OFendl;
+    out << "  \"dcmtkVersion\": \"" OFFIS_DCMTK_VERSION_STRING "\"," << OFendl;
+    out << "  \"date\": \"" << OFDateTime::getCurrentDateTime() << "\"," << OFendl;
+    out << "  \"settings\": {\"maxPDU\": " << settings.maxPDU
+        << ", \"associations\": " << settings.associations
+        << ", \"echoCount\": " << settings.echoCount
+        << ", \"storeCount\": " << settings.storeCount << "}," << OFendl;
+    out << "  \"results\": [";
+    for (OFListConstIterator(BenchmarkResult) it = results.begin(); it != results.end(); ++it)
+    {
+        const BenchmarkStatistics stats(*it);
+        out << ((it == results.begin()) ? "" : ",") << OFendl;
+        out << "    {\"scenario\": \"" << it->scenario
+            << "\", \"transport\": \"" << (it->tls ? "tls" : "plain")
+            << "\", \"tcpNoDelay\": " << (it->tcpNoDelay ? "true" : "false")
+            << ", \"objectSize\": " << it->objectSize
+            << ", \"concurrency\": " << it->concurrency
+            << ", \"operations\": " << stats.operations
+            << ", \"failures\": " << it->failures
+            << ", \"seconds\": ";
+        writeNumber(out, it->seconds, 6);
+        out << ", \"operationsPerSecond\": ";
+        writeNumber(out, stats.operationsPerSecond);
+        out << ", \"bytesPerSecond\": ";
+        writeNumber(out, stats.bytesPerSecond, 0);
+        out << ", \"latencyMicroseconds\": {\"min\": ";
+        writeNumber(out, stats.min);
+        out << ", \"mean\": ";
+        writeNumber(out, stats.mean);
+        out << ", \"p50\": ";
+        writeNumber(out, stats.p50);
+        out << ", \"p95\": ";
+        writeNumber(out, stats.p95);
+        out << ", \"p99\": ";
+        writeNumber(out, stats.p99);
+        out << ", \"max\": ";
+        writeNumber(out, stats.max);
+        out << "}}";
+    }
+    out << OFendl << "  ]" << OFendl << "}" << OFendl;
+}
+
+
+/// write the benchmark results in CSV format, one line per scenario
+static void writeCSV(STD_NAMESPACE ostream& out,
+                     const OFList<BenchmarkResult>& results)
+{
+    out << "scenario,transport,tcp_nodelay,object_size,concurrency,operations,failures,seconds,"
+        << "operations_per_second,bytes_per_second,latency_min_us,latency_mean_us,"
+        << "latency_p50_us,latency_p95_us,latency_p99_us,latency_max_us" << OFendl;
+    for (OFListConstIterator(BenchmarkResult) it = results.begin(); it != results.end(); ++it)
+    {
+        const BenchmarkStatistics stats(*it);
+        out << it->scenario << "," << (it->tls ? "tls" : "plain") << ","
+            << (it->tcpNoDelay ? 1 : 0) << "," << it->objectSize << "," << it->concurrency << ","
+            << stats.operations << "," << it->failures << ",";
+        writeNumber(out, it->seconds, 6);
+        out << ",";
+        writeNumber(out, stats.operationsPerSecond);
+        out << ",";
+        writeNumber(out, stats.bytesPerSecond, 0);
+        out << ",";
+        writeNumber(out, stats.min);
+        out << ",";
+        writeNumber(out, stats.mean);
+        out << ",";
+        writeNumber(out, stats.p50);
+        out << ",";
+        writeNumber(out, stats.p95);
+        out << ",";
+        writeNumber(out, stats.p99);
+        out << ",";
+        writeNumber(out, stats.max);
+        out << OFendl;
+    }
+}
+
+
+/** parse a comma separated list of numbers. A number may be followed by the
+ *  suffix "k" or "m" (kilobytes or megabytes) if units are allowed.
+ *  @param text list to be parsed
+ *  @param values vector the numbers are added to
+ *  @param withUnits OFTrue if the suffixes "k" and "m" are allowed
+ *  @return OFTrue if the list is valid and contains positive numbers only
+ */
+static OFBool parseList(const char *text, OFVector<size_t>& values, const OFBool withUnits)
+{
+    values.clear();
+    OFString list(text);
+    size_t pos = 0;
+    while (pos <= list.length())
+    {
+        size_t end = list.find(',', pos);
+        if (end == OFString_npos)
+            end = list.length();
+        OFString item = list.substr(pos, end - pos);
+        size_t factor = 1;
+        if (withUnits && !item.empty())
+        {
+            const char unit = item.at(item.length() - 1);
+            if ((unit == 'k') || (unit == 'K'))
+                factor = 1024;
+            else if ((unit == 'm') || (unit == 'M'))
+                factor = 1024 * 1024;
+            if (factor > 1)
+                item.erase(item.length() - 1);
+        }
+        if (item.empty() || (item.find_first_not_of("0123456789") != OFString_npos))
+            return OFFalse;
+        const size_t value = OFstatic_cast(size_t, atol(item.c_str())) * factor;
+        if (value == 0)
+            return OFFalse;
+        values.push_back(value);
+        pos = end + 1;
+    }
+    return !values.empty();
+}
+
+
+// log a short summary of a benchmark result
+static void logResult(const BenchmarkResult& result)
+{
+    const BenchmarkStatistics stats(result);
+    OFOStringStream stream;
+    stream << result.scenario << " (" << (result.tls ? "tls" : "plain");
+    if (!result.tcpNoDelay)
+        stream << ", nagle";
+    if (result.objectSize > 0)
+        stream << ", " << result.objectSize << " bytes";
+    if (result.concurrency > 1)
+        stream << ", " << result.concurrency << " threads";
+    stream << "): " << stats.operations << " operations, ";
+    writeNumber(stream, stats.operationsPerSecond, 1);
+    stream << " ops/s";
+    if (result.objectSize > 0)
+    {
+        stream << ", ";
+        writeNumber(stream, stats.bytesPerSecond / (1024.0 * 1024.0), 1);
+        stream << " MB/s";
+    }
+    stream << ", median latency ";
+    writeNumber(stream, stats.p50, 1);
+    stream << " us" << OFStringStream_ends;
+    OFSTRINGSTREAM_GETOFSTRING(stream, text)
+    OFLOG_INFO(benchLogger, text);
+}
+
+
+/// run all scenarios of the benchmark for the plain or TLS SCP
+static void runScenarios(const BenchmarkSettings& settings, const OFBool tls, OFList<BenchmarkResult>& results)
+{
+    if (settings.associations > 0)
+        results.push_back(benchmarkAssociate(settings, tls));
+    if (settings.echoCount > 0)
+        results.push_back(benchmarkEcho(settings, tls));
+    if (settings.storeCount > 0)
+    {
+        for (OFVector<size_t>::const_iterator it = settings.objectSizes.begin(); it != settings.objectSizes.end(); ++it)
+            results.push_back(benchmarkStore(settings, tls, *it));
+        for (OFVector<size_t>::const_iterator it = settings.concurrency.begin(); it != settings.concurrency.end(); ++it)
+            results.push_back(benchmarkConcurrency(settings, tls, *it));
+    }
+}
+
+#endif // WITH_THREADS
+
+
+int main(int argc, char *argv[])
+{
+    OFConsoleApplication app(OFFIS_CONSOLE_APPLICATION, "Measure DIMSE latency and throughput over loopback", rcsid);
+
+#ifdef WITH_THREADS
+    BenchmarkSettings settings;
+    OFCmdUnsignedInt opt_port = settings.port;
+    OFCmdUnsignedInt opt_maxPDU = settings.maxPDU;
+    OFCmdUnsignedInt opt_associations = settings.associations;
+    OFCmdUnsignedInt opt_echoCount = settings.echoCount;
+    OFCmdUnsignedInt opt_storeCount = settings.storeCount;
+    const char *opt_sizes = "16k,256k,4m";
+    const char *opt_concurrency = "1,2,4,8";
+    const char *opt_scalingSize = "256k";
+    const char *opt_outputFile = NULL;
+    OFBool opt_csv = OFFalse;
+    OFBool opt_withNagle = OFFalse;
+
+    OFStandard::initializeNetwork();
+#ifdef WITH_OPENSSL
+    DcmTLSTransportLayer::initializeOpenSSL();
+#endif
+
+    OFCommandLine cmd;
+    cmd.setOptionColumns(LONGCOL, SHORTCOL);
+    cmd.addGroup("general options:", LONGCOL, SHORTCOL + 2);
+      cmd.addOption("--help",             "-h",      "print this help text and exit", OFCommandLine::AF_Exclusive);
+      cmd.addOption("--version",                     "print version information and exit", OFCommandLine::AF_Exclusive);
+      OFLog::addOptions(cmd);
+    cmd.addGroup("benchmark options:");
+      cmd.addSubGroup("scenarios:");
+        cmd.addOption("--associations",   "-na",  1, "[n]umber: integer (default: 20)", "negotiate n associations (0 = skip)");
+        cmd.addOption("--echo-count",     "-ne",  1, "[n]umber: integer (default: 1000)", "send n C-ECHO requests (0 = skip)");
+        cmd.addOption("--store-count",    "-ns",  1, "[n]umber: integer (default: 50)", "send n C-STORE requests per object size\nand thread (0 = skip)");
+        cmd.addOption("--object-sizes",   "-os",  1, "[l]ist: string (default: 16k,256k,4m)", "comma separated pixel data sizes in bytes,\nsuffix k or m for kilobytes or megabytes");
+        cmd.addOption("--concurrency",    "-nc",  1, "[l]ist: string (default: 1,2,4,8)", "comma separated numbers of concurrent SCUs");
+        cmd.addOption("--scaling-size",   "-ss",  1, "[s]ize: string (default: 256k)", "pixel data size for concurrent SCUs");
+        cmd.addOption("--quick",          "-qr",     "run a short benchmark (e.g. as smoke test)");
+      cmd.addSubGroup("transport:");
+#ifdef WITH_OPENSSL
+        cmd.addOption("--all-transports", "+at",     "measure plain and TLS associations (default)");
+        cmd.addOption("--plain-only",     "+po",     "measure plain associations only");
+        cmd.addOption("--tls-only",       "+to",     "measure TLS associations only");
+#endif
+      cmd.addSubGroup("network:");
+        cmd.addOption("--port",           "-p",   1, "[n]umber: integer (default: 11125)", "port of the plain SCP, port n+1 is used\nfor the TLS SCP");
+        cmd.addOption("--max-pdu",        "-pdu", 1, "[n]umber of bytes: integer (4096..131072)", "set max receive pdu to n bytes (default: 16384)");
+        cmd.addOption("--with-nagle",     "+wn",     "also measure with the Nagle algorithm enabled\n(default: TCP_NODELAY on both ends only)");
+    cmd.addGroup("output options:");
+      cmd.addOption("--output-json",      "+oj",     "write results in JSON format (default)");
+      cmd.addOption("--output-csv",       "+oc",     "write results in CSV format");
+      cmd.addOption("--output-file",      "-of",  1, "[f]ilename: string", "write results to file f instead of stdout");
+
+    prepareCmdLineArgs(argc, argv, OFFIS_CONSOLE_APPLICATION);
+    if (app.parseCommandLine(cmd, argc, argv))
+    {
+        if (cmd.hasExclusiveOption())
+        {
+            if (cmd.findOption("--version"))
+            {
+                app.printHeader(OFTrue /*print host identifier*/);
+                return EXITCODE_NO_ERROR;
+            }
+        }
+
+        OFLog::configureFromCommandLine(cmd, app);
+
+        if (cmd.findOption("--quick"))
+        {
+            opt_associations = 3;
+            opt_echoCount = 50;
+            opt_storeCount = 5;
+            opt_sizes = "16k,1m";
+            opt_concurrency = "1,2";
+        }
+        if (cmd.findOption("--associations")) app.checkValue(cmd.getValue(opt_associations));
+        if (cmd.findOption("--echo-count")) app.checkValue(cmd.getValue(opt_echoCount));
+        if (cmd.findOption("--store-count")) app.checkValue(cmd.getValue(opt_storeCount));
+        if (cmd.findOption("--object-sizes")) app.checkValue(cmd.getValue(opt_sizes));
+        if (cmd.findOption("--concurrency")) app.checkValue(cmd.getValue(opt_concurrency));
+        if (cmd.findOption("--scaling-size")) app.checkValue(cmd.getValue(opt_scalingSize));
+#ifdef WITH_OPENSSL
+        cmd.beginOptionBlock();
+        if (cmd.findOption("--all-transports")) settings.plain = settings.tls = OFTrue;
+        if (cmd.findOption("--plain-only")) { settings.plain = OFTrue; settings.tls = OFFalse; }
+        if (cmd.findOption("--tls-only")) { settings.plain = OFFalse; settings.tls = OFTrue; }
+        cmd.endOptionBlock();
+#endif
+        if (cmd.findOption("--port")) app.checkValue(cmd.getValueAndCheckMinMax(opt_port, 1, 65534));
+        if (cmd.findOption("--max-pdu")) app.checkValue(cmd.getValueAndCheckMinMax(opt_maxPDU, ASC_MINIMUMPDUSIZE, ASC_MAXIMUMPDUSIZE));
+        if (cmd.findOption("--with-nagle")) opt_withNagle = OFTrue;
+        cmd.beginOptionBlock();
+        if (cmd.findOption("--output-json")) opt_csv = OFFalse;
+        if (cmd.findOption("--output-csv")) opt_csv = OFTrue;
+        cmd.endOptionBlock();
+        if (cmd.findOption("--output-file")) app.checkValue(cmd.getValue(opt_outputFile));
+    }
+
+#ifndef WITH_OPENSSL
+    settings.tls = OFFalse;
+#endif
+    settings.port = OFstatic_cast(Uint16, opt_port);
+    settings.maxPDU = OFstatic_cast(Uint32, opt_maxPDU);
+    settings.associations = OFstatic_cast(size_t, opt_associations);
+    settings.echoCount = OFstatic_cast(size_t, opt_echoCount);
+    settings.storeCount = OFstatic_cast(size_t, opt_storeCount);
+    OFVector<size_t> scalingSize;
+    if (!parseList(opt_sizes, settings.objectSizes, OFTrue))
+        app.printError("invalid list of object sizes");
+    if (!parseList(opt_concurrency, settings.concurrency, OFFalse))
+        app.printError("invalid list of concurrent SCUs");
+    if (!parseList(opt_scalingSize, scalingSize, OFTrue) || (scalingSize.size() != 1))
+        app.printError("invalid pixel data size for concurrent SCUs");
+    settings.scalingSize = scalingSize.front();
+
+    OFLOG_DEBUG(benchLogger, rcsid << OFendl);
+
+    /* make sure data dictionary is loaded */
+    if (!dcmDataDict.isDictionaryLoaded())
+    {
+        OFLOG_WARN(benchLogger, "no data dictionary loaded, check environment variable: "
+            << DCM_DICT_ENVIRONMENT_VARIABLE);
+    }
+
+    int result = EXITCODE_NO_ERROR;
+    OFList<BenchmarkResult> results;
+    // the scenarios are run with the Nagle algorithm disabled first
+    for (int variant = 0; (variant < (opt_withNagle ? 2 : 1)) && (result == EXITCODE_NO_ERROR); ++variant)
+    {
+        settings.tcpNoDelay = (variant == 0);
+        if (settings.plain)
+        {
+            BenchmarkPool pool;
+            OFCondition cond = startPool(pool, settings, NULL);
+            if (cond.good())
+                runScenarios(settings, OFFalse, results);
+            else
+            {
+                OFLOG_FATAL(benchLogger, "cannot start SCP on port " << settings.port << ": " << cond.text());
+                result = EXITCODE_CANNOT_START_SCP_AND_LISTEN;
+            }
+            stopPool(pool);
+        }
+#ifdef WITH_OPENSSL
+        if (settings.tls && (result == EXITCODE_NO_ERROR))
+        {
+            OFTempFile keyFile(O_RDWR, "", OFFIS_CONSOLE_APPLICATION, ".key");
+            OFTempFile certFile(O_RDWR, "", OFFIS_CONSOLE_APPLICATION, ".pem");
+            DcmTLSTransportLayer tlsLayer(NET_ACCEPTOR, NULL, OFTrue);
+            if (keyFile.getStatus().bad() || certFile.getStatus().bad() ||
+                !createSelfSignedCertificate(keyFile.getFilename(), certFile.getFilename()) ||
+                tlsLayer.setPrivateKeyFile(keyFile.getFilename(), DCF_Filetype_PEM).bad() ||
+                tlsLayer.setCertificateFile(certFile.getFilename(), DCF_Filetype_PEM).bad() ||
+                !tlsLayer.checkPrivateKeyMatchesCertificate())
+            {
+                OFLOG_FATAL(benchLogger, "cannot create TLS transport layer with self-signed certificate");
+                result = EXITCODE_CANNOT_CREATE_TRANSPORT_LAYER;
+            }
+            else
+            {
+                tlsLayer.setCertificateVerification(DCV_ignoreCertificate);
+                BenchmarkPool pool;
+                OFCondition cond = startPool(pool, settings, &tlsLayer);
+                if (cond.good())
+                    runScenarios(settings, OFTrue, results);
+                else
+                {
+                    OFLOG_FATAL(benchLogger, "cannot start TLS SCP on port " << settings.port + 1 << ": " << cond.text());
+                    result = EXITCODE_CANNOT_START_SCP_AND_LISTEN;
+                }
+                stopPool(pool);
+            }
+        }
+#endif
+    }
+
+    for (OFListConstIterator(BenchmarkResult) it = results.begin(); it != results.end(); ++it)
+    {
+        logResult(*it);
+        if ((it->failures > 0) && (result == EXITCODE_NO_ERROR))
+            result = EXITCODE_CANNOT_SEND_REQUEST;
+    }
+
+    if (opt_outputFile != NULL)
+    {
+        STD_NAMESPACE ofstream output(opt_outputFile);
+        if (!output.good())
+        {
+            OFLOG_FATAL(benchLogger, "cannot write output file: " << opt_outputFile);
+            return EXITCODE_CANNOT_WRITE_OUTPUT_FILE;
+        }
+        if (opt_csv)
+            writeCSV(output, results);
+        else
+            writeJSON(output, settings, results);
+    }
+    else if (opt_csv)
+        writeCSV(COUT, results);
+    else
+        writeJSON(COUT, settings, results);
+
+    OFStandard::shutdownNetwork();
+    return result;
+#else // WITH_THREADS
+    (void) argc;
+    (void) argv;
+    app.printError("this benchmark requires DCMTK to be compiled with thread support");
+    return EXITCODE_NO_ERROR;
+#endif
+}
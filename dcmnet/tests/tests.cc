@@ -25,6 +25,7 @@
 
 OFTEST_REGISTER(dcmnet_dimseDump_nullByte);
 OFTEST_REGISTER(dcmnet_dimseStatusClass);
+OFTEST_REGISTER(dcmnet_socket_options_config);
 
 #ifdef WITH_THREADS
 OFTEST_REGISTER(dcmnet_scp_pool);
@@ -38,6 +39,23 @@ OFTEST_REGISTER(dcmnet_scp_no_stop_wo_request_block);
 OFTEST_REGISTER(dcmnet_scp_no_term_notify_without_association);
 OFTEST_REGISTER(dcmnet_scp_role_selection);
 OFTEST_REGISTER(dcmnet_scu_session_handler);
+OFTEST_REGISTER(dcmnet_async_operations_window);
+OFTEST_REGISTER(dcmnet_async_storage_scu);
+OFTEST_REGISTER(dcmnet_async_operations_abort);
+OFTEST_REGISTER(dcmnet_storage_scp_bit_preserving);
+OFTEST_REGISTER(dcmnet_storage_scp_transcoding);
+OFTEST_REGISTER(dcmnet_scu_pool);
+OFTEST_REGISTER(dcmnet_scu_pool_rejected);
+OFTEST_REGISTER(dcmnet_storage_scu_parallel);
+OFTEST_REGISTER(dcmnet_storage_scu_parallel_stop);
+OFTEST_REGISTER(dcmnet_scu_store_file_streamed);
+OFTEST_REGISTER(dcmnet_network_metrics);
+#ifndef _WIN32
+OFTEST_REGISTER(dcmnet_socket_options_applied);
+OFTEST_REGISTER(dcmnet_scp_reactor);
+OFTEST_REGISTER(dcmnet_scp_reactor_limits);
+OFTEST_REGISTER(dcmnet_scp_reactor_partial_message);
+#endif
 #endif // WITH_THREADS
 
 OFTEST_MAIN("dcmnet")
@@ -0,0 +1,154 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test collection of association and DIMSE metrics
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstream.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/scu.h"
+#include "dcmtk/dcmnet/netmetr.h"
+
+
+/// port used by the tests in this file
+#define METRICS_TEST_PORT 11123
+
+
+/// listener counting the associations it has been notified about
+struct CountingListener : DcmNetworkMetricsListener
+{
+    CountingListener() : m_count(0) {}
+
+    virtual void notifyAssociationMetrics(const DcmAssociationMetrics& /* metrics */)
+    {
+        ++m_count;
+    }
+
+    int m_count;
+};
+
+
+struct MetricsPool : DcmSCPPool<>, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = listen();
+    }
+};
+
+
+OFTEST_FLAGS(dcmnet_network_metrics, EF_Slow)
+{
+    DcmNetworkMetrics& registry = DcmNetworkMetrics::instance();
+    registry.reset();
+    registry.setEnabled(OFTrue);
+    CountingListener listener;
+    registry.addListener(&listener);
+
+    MetricsPool scp;
+    DcmSCPConfig& config = scp.getConfig();
+    config.setAETitle("METRICS_SCP");
+    config.setPort(METRICS_TEST_PORT);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(config.addPresentationContext(UID_VerificationSOPClass, xfers).good());
+    scp.start();
+    OFStandard::sleep(2);
+
+    DcmSCU scu;
+    scu.setAETitle("METRICS_SCU");
+    scu.setPeerAETitle("METRICS_SCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(METRICS_TEST_PORT);
+    OFCHECK(scu.getAssociationMetrics() == NULL);
+    OFCHECK(scu.addPresentationContext(UID_VerificationSOPClass, xfers).good());
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+    OFCHECK(scu.sendECHORequest(0).good());
+    OFCHECK(scu.sendECHORequest(0).good());
+
+    // the metrics of the running association are available from the SCU
+    const DcmAssociationMetrics* current = scu.getAssociationMetrics();
+    OFCHECK(current != NULL);
+    if (current != NULL)
+    {
+        OFCHECK(current->requestor);
+        OFCHECK_EQUAL(current->ourAETitle, "METRICS_SCU");
+        OFCHECK_EQUAL(current->peerAETitle, "METRICS_SCP");
+        OFCHECK_EQUAL(current->negotiation.count, 1);
+        OFCHECK_EQUAL(current->commandsSent.count, 2);
+        OFCHECK_EQUAL(current->commandsReceived.count, 2);
+        OFCHECK(current->commandsSent.bytes > 0);
+    }
+    OFCHECK(scu.releaseAssociation().good());
+
+    // the acceptor's association has been destroyed when the pool has stopped
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.result.good());
+
+    // one association as requestor and one as acceptor
+    const DcmAssociationMetrics totals = registry.getTotals();
+    OFCHECK_EQUAL(totals.associations, 2);
+    OFCHECK_EQUAL(totals.negotiation.count, 2);
+    OFCHECK_EQUAL(totals.commandsSent.count, 4);
+    OFCHECK_EQUAL(totals.commandsReceived.count, 4);
+    OFCHECK_EQUAL(totals.commandsHandled.count, 2);
+    OFCHECK_EQUAL(totals.datasetsSent.count, 0);
+    OFCHECK(totals.pdusSent >= 4);
+    OFCHECK(totals.pduBytesSent > 0);
+    OFCHECK_EQUAL(totals.pdusSent, totals.pdusReceived);
+    OFCHECK_EQUAL(totals.pduBytesSent, totals.pduBytesReceived);
+    OFCHECK_EQUAL(registry.getPeerMetrics().size(), 2);
+    OFCHECK_EQUAL(registry.getQueueWait().count, 1);
+    OFCHECK_EQUAL(listener.m_count, 2);
+
+    OFOStringStream prometheus;
+    registry.writePrometheus(prometheus);
+    prometheus << OFStringStream_ends;
+    OFSTRINGSTREAM_GETOFSTRING(prometheus, prometheusText)
+    OFCHECK(prometheusText.find("dcmnet_associations_total{role=\"requestor\",our_ae=\"METRICS_SCU\",peer_ae=\"METRICS_SCP\"") != OFString_npos);
+    OFCHECK(prometheusText.find("dcmnet_commands_sent_seconds_total{") != OFString_npos);
+    OFCHECK(prometheusText.find("dcmnet_queue_wait_total 1") != OFString_npos);
+
+    OFOStringStream json;
+    registry.writeJSON(json);
+    json << OFStringStream_ends;
+    OFSTRINGSTREAM_GETOFSTRING(json, jsonText)
+    OFCHECK(jsonText.find("\"peerAETitle\":\"METRICS_SCU\"") != OFString_npos);
+    OFCHECK(jsonText.find("\"commandsHandled\":{\"count\":2") != OFString_npos);
+
+    // associations are not collected while disabled
+    registry.removeListener(&listener);
+    registry.setEnabled(OFFalse);
+    registry.reset();
+    OFCHECK_EQUAL(registry.getTotals().associations, 0);
+    OFCHECK(registry.getPeerMetrics().empty());
+}
+
+#endif // WITH_THREADS
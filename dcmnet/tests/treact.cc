@@ -0,0 +1,247 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test the event-driven SCP reactor
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#if defined(WITH_THREADS) && !defined(_WIN32)
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmnet/scpreact.h"
+#include "dcmtk/dcmnet/scu.h"
+#include "dcmtk/dcmnet/dcmtrans.h"
+
+
+/// port used by the tests in this file
+#define REACTOR_TEST_PORT 11117
+
+/// number of simultaneous associations in the test
+#define REACTOR_TEST_ASSOCIATIONS 40
+
+
+struct TestReactor : DcmSCPReactor<>, OFThread
+{
+    OFCondition result;
+
+    TestReactor()
+      : DcmSCPReactor<>()
+      , OFThread()
+      , result(EC_NotYetImplemented)
+    {
+        DcmSCPConfig& config = getConfig();
+        config.setAETitle("ReactorTestSCP");
+        config.setPort(REACTOR_TEST_PORT);
+        config.setConnectionBlockingMode(DUL_NOBLOCK);
+        // Dead time during which the reactor is unable to respond to
+        // stopAfterCurrentAssociations().
+        config.setConnectionTimeout(1);
+        OFList<OFString> xfers;
+        xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+        xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+        config.addPresentationContext(UID_VerificationSOPClass, xfers);
+    }
+
+protected:
+    void run()
+    {
+        result = listen();
+    }
+};
+
+
+// create an SCU that is connected to the reactor, or NULL if the association was not accepted
+static DcmSCU* connectSCU()
+{
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    DcmSCU* scu = new DcmSCU;
+    scu->setAETitle("ReactorTestSCU");
+    scu->setPeerAETitle("ReactorTestSCP");
+    scu->setPeerHostName("localhost");
+    scu->setPeerPort(REACTOR_TEST_PORT);
+    scu->addPresentationContext(UID_VerificationSOPClass, xfers);
+    if (scu->initNetwork().bad() || scu->negotiateAssociation().bad())
+    {
+        delete scu;
+        scu = NULL;
+    }
+    return scu;
+}
+
+
+/* Test starts a reactor with a single I/O thread and two worker threads.
+ * Many more associations than threads are opened from a single SCU thread
+ * and kept open at the same time, while C-ECHO messages are sent on all of
+ * them in turn.
+ */
+OFTEST_FLAGS(dcmnet_scp_reactor, EF_Slow)
+{
+    TestReactor reactor;
+    reactor.setNumberOfIOThreads(1);
+    reactor.setNumberOfWorkerThreads(2);
+    reactor.start();
+    OFStandard::sleep(1);
+
+    OFVector<DcmSCU*> scus;
+    for (size_t i = 0; i < REACTOR_TEST_ASSOCIATIONS; ++i)
+    {
+        DcmSCU* scu = connectSCU();
+        OFCHECK(scu != NULL);
+        if (scu)
+            scus.push_back(scu);
+    }
+    OFCHECK_EQUAL(reactor.numAssociations(), REACTOR_TEST_ASSOCIATIONS);
+
+    // all associations are served alternately by the same threads
+    for (size_t round = 0; round < 3; ++round)
+    {
+        for (size_t j = 0; j < scus.size(); ++j)
+            OFCHECK(scus[j]->sendECHORequest(0).good());
+    }
+
+    for (size_t k = 0; k < scus.size(); ++k)
+    {
+        OFCHECK(scus[k]->releaseAssociation().good());
+        delete scus[k];
+    }
+
+    // Request shutdown.
+    reactor.stopAfterCurrentAssociations();
+    reactor.join();
+
+    OFCHECK(reactor.result.good());
+    OFCHECK_EQUAL(reactor.numAssociations(), 0);
+}
+
+
+/* Test that association requests exceeding the maximum number of
+ * associations are rejected, and that idle associations are aborted
+ * after the DIMSE timeout.
+ */
+OFTEST_FLAGS(dcmnet_scp_reactor_limits, EF_Slow)
+{
+    TestReactor reactor;
+    reactor.setMaxAssociations(2);
+    reactor.setNumberOfWorkerThreads(1);
+    reactor.getConfig().setDIMSEBlockingMode(DIMSE_NONBLOCKING);
+    reactor.getConfig().setDIMSETimeout(2);
+    reactor.start();
+    OFStandard::sleep(1);
+
+    DcmSCU* scu1 = connectSCU();
+    DcmSCU* scu2 = connectSCU();
+    OFCHECK(scu1 != NULL);
+    OFCHECK(scu2 != NULL);
+    // a third association is rejected
+    DcmSCU* scu3 = connectSCU();
+    OFCHECK(scu3 == NULL);
+    delete scu3;
+    OFCHECK_EQUAL(reactor.numAssociations(), 2);
+
+    // keep the first association busy, the second one is aborted
+    for (size_t i = 0; i < 4; ++i)
+    {
+        OFStandard::sleep(1);
+        if (scu1)
+            OFCHECK(scu1->sendECHORequest(0).good());
+    }
+    if (scu2)
+        OFCHECK(scu2->sendECHORequest(0).bad());
+    // the aborted association is closed as soon as the peer disconnects
+    delete scu2;
+    OFStandard::sleep(1);
+    OFCHECK_EQUAL(reactor.numAssociations(), 1);
+
+    if (scu1)
+        OFCHECK(scu1->releaseAssociation().good());
+    delete scu1;
+
+    reactor.stopAfterCurrentAssociations();
+    reactor.join();
+    OFCHECK(reactor.result.good());
+}
+
+/* Test that a peer that stops sending in the middle of a DIMSE message does
+ * not block the only worker thread, and that its association is aborted
+ * after the DIMSE timeout, also in blocking mode.
+ */
+OFTEST_FLAGS(dcmnet_scp_reactor_partial_message, EF_Slow)
+{
+    TestReactor reactor;
+    reactor.setNumberOfWorkerThreads(1);
+    reactor.getConfig().setDIMSEBlockingMode(DIMSE_BLOCKING);
+    reactor.getConfig().setDIMSETimeout(3);
+    reactor.start();
+    OFStandard::sleep(1);
+
+    // negotiate an association on the ACSE level only
+    T_ASC_Network* net = NULL;
+    T_ASC_Parameters* params = NULL;
+    T_ASC_Association* assoc = NULL;
+    const char* xfers[] = { UID_LittleEndianImplicitTransferSyntax };
+    OFCHECK(ASC_initializeNetwork(NET_REQUESTOR, 0, 30, &net).good());
+    OFCHECK(ASC_createAssociationParameters(&params, ASC_DEFAULTMAXPDU).good());
+    ASC_setAPTitles(params, "StalledSCU", "ReactorTestSCP", NULL);
+    ASC_setPresentationAddresses(params, "localhost", "localhost:11117");
+    ASC_addPresentationContext(params, 1, UID_VerificationSOPClass, xfers, 1);
+    OFCHECK(ASC_requestAssociation(net, params, &assoc).good());
+    DcmTransportConnection* connection = (assoc != NULL) ? DUL_getTransportConnection(assoc->DULassociation) : NULL;
+    OFCHECK(connection != NULL);
+    if (connection != NULL)
+    {
+        // P-DATA-TF PDU announcing 18 bytes of which only a few are sent
+        unsigned char pdu[] = { 0x04, 0x00, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x0e, 0x01, 0x01 };
+        OFCHECK_EQUAL(connection->write(pdu, sizeof(pdu)), OFstatic_cast(ssize_t, sizeof(pdu)));
+    }
+    OFStandard::sleep(1);
+
+    // another association is served in the meantime
+    DcmSCU* scu = connectSCU();
+    OFCHECK(scu != NULL);
+    if (scu)
+    {
+        OFCHECK(scu->sendECHORequest(0).good());
+        OFCHECK(scu->releaseAssociation().good());
+    }
+    delete scu;
+
+    // the stalled association is aborted, i.e. an A-ABORT PDU is received
+    if (connection != NULL)
+    {
+        OFCHECK(connection->networkDataAvailable(5));
+        unsigned char pduType = 0;
+        OFCHECK_EQUAL(connection->read(&pduType, 1), 1);
+        OFCHECK_EQUAL(pduType, 0x07);
+    }
+    if (assoc != NULL)
+    {
+        ASC_dropAssociation(assoc);
+        ASC_destroyAssociation(&assoc);
+    }
+    ASC_dropNetwork(&net);
+
+    reactor.stopAfterCurrentAssociations();
+    reactor.join();
+    OFCHECK(reactor.result.good());
+    OFCHECK_EQUAL(reactor.numAssociations(), 0);
+}
+
+#endif // WITH_THREADS && !_WIN32
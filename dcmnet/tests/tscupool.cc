@@ -0,0 +1,277 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test reuse of associations by DcmSCUPool
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/scupool.h"
+
+
+/// port used by the tests in this file
+#define POOL_TEST_PORT 11119
+
+/// port used by the test with a peer that rejects presentation contexts
+#define POOL_REJECT_TEST_PORT 11131
+
+/// number of concurrent senders
+#define POOL_TEST_SENDERS 4
+
+/// number of associations requested from the SCP
+static int associationCount = 0;
+
+/// mutex protecting associationCount
+static OFMutex associationCountMutex;
+
+
+static int getAssociationCount()
+{
+    associationCountMutex.lock();
+    const int result = associationCount;
+    associationCountMutex.unlock();
+    return result;
+}
+
+
+/** SCP worker that counts the association requests (before the association
+ *  is acknowledged, so the count is up-to-date when the SCU is connected)
+ */
+struct CountingSCP : DcmThreadSCP
+{
+    virtual void notifyAssociationRequest(const T_ASC_Parameters& params, DcmSCPActionType& desiredAction)
+    {
+        associationCountMutex.lock();
+        ++associationCount;
+        associationCountMutex.unlock();
+        DcmThreadSCP::notifyAssociationRequest(params, desiredAction);
+    }
+};
+
+
+struct CountingPool : DcmSCPPool<CountingSCP>, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = listen();
+    }
+};
+
+
+/** Sender that repeatedly sends C-ECHO requests over pooled associations
+ */
+struct PoolSender : OFThread
+{
+    PoolSender(DcmSCUPool& pool, const OFList<OFString>& xfers)
+    : m_pool(pool)
+    , m_xfers(xfers)
+    , m_failures(0)
+    {
+    }
+
+    DcmSCUPool& m_pool;
+    const OFList<OFString>& m_xfers;
+    int m_failures;
+
+protected:
+    void run()
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            DcmSCU* scu = NULL;
+            T_ASC_PresentationContextID presID = 0;
+            if (m_pool.acquireSCU("localhost", POOL_TEST_PORT, "POOL_SCU", "POOL_SCP",
+                UID_VerificationSOPClass, m_xfers, scu, presID).good() &&
+                scu->sendECHORequest(presID).good())
+            {
+                m_pool.releaseSCU(scu);
+            }
+            else
+            {
+                ++m_failures;
+                m_pool.discardSCU(scu);
+            }
+        }
+    }
+
+private:
+    PoolSender(const PoolSender&);
+    PoolSender& operator=(const PoolSender&);
+};
+
+
+OFTEST_FLAGS(dcmnet_scu_pool, EF_Slow)
+{
+    CountingPool scp;
+    DcmSCPConfig& config = scp.getConfig();
+    config.setAETitle("POOL_SCP");
+    config.setPort(POOL_TEST_PORT);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    scp.setMaxThreads(POOL_TEST_SENDERS + 2);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(config.addPresentationContext(UID_VerificationSOPClass, xfers).good());
+    OFCHECK(config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    scp.start();
+    OFStandard::sleep(2);
+
+    DcmSCUPool pool;
+    DcmSCU* scu = NULL;
+    DcmSCU* first = NULL;
+    T_ASC_PresentationContextID presID = 0;
+
+    // the association is kept after the first request and reused for the second one
+    OFCHECK(pool.acquireSCU("localhost", POOL_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_VerificationSOPClass, xfers, scu, presID).good());
+    OFCHECK(scu != NULL && presID != 0);
+    OFCHECK(scu != NULL && scu->sendECHORequest(presID).good());
+    first = scu;
+    pool.releaseSCU(scu);
+    OFCHECK(scu == NULL);
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 1);
+    OFCHECK(pool.acquireSCU("localhost", POOL_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_VerificationSOPClass, xfers, scu, presID).good());
+    OFCHECK(scu == first);
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 0);
+    OFCHECK(scu != NULL && scu->sendECHORequest(presID).good());
+    pool.releaseSCU(scu);
+    OFCHECK_EQUAL(getAssociationCount(), 1);
+
+    // a further SOP class requires renegotiation, the previous one is still available afterwards
+    OFCHECK(pool.acquireSCU("localhost", POOL_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_SecondaryCaptureImageStorage, xfers, scu, presID).good());
+    OFCHECK(scu != NULL && presID != 0);
+    pool.releaseSCU(scu);
+    OFCHECK_EQUAL(getAssociationCount(), 2);
+    OFCHECK(pool.acquireSCU("localhost", POOL_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_VerificationSOPClass, xfers, scu, presID).good());
+    OFCHECK(scu != NULL && scu->sendECHORequest(presID).good());
+    pool.releaseSCU(scu);
+    OFCHECK_EQUAL(getAssociationCount(), 2);
+
+    // a SOP class that is not supported by the peer is reported, the association is kept
+    OFCHECK(pool.acquireSCU("localhost", POOL_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_MRImageStorage, xfers, scu, presID) == NET_EC_NoAcceptablePresentationContexts);
+    OFCHECK(scu == NULL && presID == 0);
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 1);
+
+    // a different called AE title is not served by the pooled association
+    OFCHECK(pool.acquireSCU("localhost", POOL_TEST_PORT, "POOL_SCU", "OTHER_SCP", UID_VerificationSOPClass, xfers, scu, presID).good());
+    OFCHECK(scu != NULL && scu->sendECHORequest(presID).good());
+    const int countBefore = getAssociationCount();
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 1);
+    pool.releaseSCU(scu);
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 2);
+
+    // concurrent senders get separate associations
+    OFVector<PoolSender*> senders;
+    for (size_t i = 0; i < POOL_TEST_SENDERS; ++i)
+    {
+        senders.push_back(new PoolSender(pool, xfers));
+        senders.back()->start();
+    }
+    for (size_t i = 0; i < POOL_TEST_SENDERS; ++i)
+    {
+        senders[i]->join();
+        OFCHECK_EQUAL(senders[i]->m_failures, 0);
+        delete senders[i];
+    }
+    OFCHECK(getAssociationCount() <= countBefore + POOL_TEST_SENDERS);
+    OFCHECK(pool.getNumberOfIdleAssociations() <= POOL_TEST_SENDERS + 1);
+
+    // idle associations are released after the timeout
+    pool.setIdleTimeout(1);
+    OFStandard::sleep(2);
+    const size_t idle = pool.getNumberOfIdleAssociations();
+    OFCHECK(idle > 0);
+    OFCHECK_EQUAL(pool.closeExpiredAssociations(), idle);
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 0);
+
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.result.good());
+}
+
+OFTEST_FLAGS(dcmnet_scu_pool_rejected, EF_Slow)
+{
+    // the SCP only supports the Verification SOP Class
+    CountingPool scp;
+    DcmSCPConfig& config = scp.getConfig();
+    config.setAETitle("POOL_SCP");
+    config.setPort(POOL_REJECT_TEST_PORT);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    scp.setMaxThreads(2);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(config.addPresentationContext(UID_VerificationSOPClass, xfers).good());
+    scp.start();
+    OFStandard::sleep(2);
+
+    DcmSCUPool pool;
+    DcmSCU* scu = NULL;
+    T_ASC_PresentationContextID presID = 0;
+    const int countBefore = getAssociationCount();
+
+    // the association on which no presentation context has been accepted is kept
+    OFCHECK(pool.acquireSCU("localhost", POOL_REJECT_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_CTImageStorage, xfers, scu, presID) == NET_EC_NoAcceptablePresentationContexts);
+    OFCHECK(scu == NULL && presID == 0);
+    OFCHECK_EQUAL(getAssociationCount(), countBefore + 1);
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 1);
+
+    // further requests for the rejected abstract syntax fail without negotiation
+    for (int i = 0; i < 3; ++i)
+    {
+        OFCHECK(pool.acquireSCU("localhost", POOL_REJECT_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_CTImageStorage, xfers, scu, presID) == NET_EC_NoAcceptablePresentationContexts);
+        OFCHECK(scu == NULL && presID == 0);
+    }
+    OFCHECK_EQUAL(getAssociationCount(), countBefore + 1);
+
+    // a supported abstract syntax renegotiates the association (proposing the
+    // rejected presentation context only once), which is then reused
+    OFCHECK(pool.acquireSCU("localhost", POOL_REJECT_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_VerificationSOPClass, xfers, scu, presID).good());
+    OFCHECK(scu != NULL && presID != 0);
+    OFCHECK(scu != NULL && scu->sendECHORequest(presID).good());
+    pool.releaseSCU(scu);
+    OFCHECK_EQUAL(getAssociationCount(), countBefore + 2);
+
+    // another unsupported abstract syntax is negotiated once, then fails fast, too
+    OFCHECK(pool.acquireSCU("localhost", POOL_REJECT_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_MRImageStorage, xfers, scu, presID) == NET_EC_NoAcceptablePresentationContexts);
+    OFCHECK_EQUAL(getAssociationCount(), countBefore + 3);
+    OFCHECK(pool.acquireSCU("localhost", POOL_REJECT_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_MRImageStorage, xfers, scu, presID) == NET_EC_NoAcceptablePresentationContexts);
+    OFCHECK(pool.acquireSCU("localhost", POOL_REJECT_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_CTImageStorage, xfers, scu, presID) == NET_EC_NoAcceptablePresentationContexts);
+    OFCHECK_EQUAL(getAssociationCount(), countBefore + 3);
+
+    // the association can still be used for the supported abstract syntax
+    OFCHECK(pool.acquireSCU("localhost", POOL_REJECT_TEST_PORT, "POOL_SCU", "POOL_SCP", UID_VerificationSOPClass, xfers, scu, presID).good());
+    OFCHECK(scu != NULL && scu->sendECHORequest(presID).good());
+    pool.releaseSCU(scu);
+    OFCHECK_EQUAL(getAssociationCount(), countBefore + 3);
+    OFCHECK_EQUAL(pool.getNumberOfIdleAssociations(), 1);
+
+    pool.closeIdleAssociations();
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.result.good());
+}
+
+#endif // WITH_THREADS
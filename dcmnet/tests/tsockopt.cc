@@ -0,0 +1,239 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test per-association socket options
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/oftempf.h"
+#include "dcmtk/ofstd/offile.h"
+#include "dcmtk/dcmnet/dcasccfg.h"
+#include "dcmtk/dcmnet/dcasccff.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/dcmtrans.h"
+
+#if defined(WITH_THREADS) && !defined(_WIN32)
+BEGIN_EXTERN_C
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+#ifdef HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif
+END_EXTERN_C
+#endif
+
+
+/// port used by the tests in this file
+#define SOCKOPT_TEST_PORT 11124
+
+
+/// association configuration file with socket options
+static const char *sockoptConfig =
+    "[[TransferSyntaxes]]\n"
+    "[Uncompressed]\n"
+    "TransferSyntax1 = LittleEndianImplicit\n"
+    "[[PresentationContexts]]\n"
+    "[Verification]\n"
+    "PresentationContext1 = VerificationSOPClass\\Uncompressed\n"
+    "[[SocketOptions]]\n"
+    "[WAN]\n"
+    "SendBufferSize    = 4194304\n"
+    "ReceiveBufferSize = 2097152\n"
+    "KeepAlive         = yes\n"
+    "KeepAliveIdle     = 60\n"
+    "[LAN]\n"
+    "TCPNoDelay        = on\n"
+    "TCPQuickAck       = off\n"
+    "[[Profiles]]\n"
+    "[Remote]\n"
+    "PresentationContexts = Verification\n"
+    "SocketOptions = wan\n"
+    "[Local]\n"
+    "PresentationContexts = Verification\n"
+    "SocketOptions = LAN\n"
+    "[Plain]\n"
+    "PresentationContexts = Verification\n";
+
+
+static OFCondition readConfig(DcmAssociationConfiguration& cfg, const char *content)
+{
+    OFTempFile temp;
+    if (temp.getStatus().bad())
+        return temp.getStatus();
+    OFFile f;
+    f.fopen(temp.getFilename(), "wb");
+    f.fputs(content);
+    f.fclose();
+    return DcmAssociationConfigurationFile::initialize(cfg, temp.getFilename());
+}
+
+
+OFTEST(dcmnet_socket_options_config)
+{
+    DcmAssociationConfiguration cfg;
+    OFCHECK(readConfig(cfg, sockoptConfig).good());
+
+    const T_ASC_SocketOptions *wan = cfg.getSocketOptions("WAN");
+    OFCHECK(wan != NULL);
+    if (wan != NULL)
+    {
+        OFCHECK_EQUAL(wan->sendBufferSize, 4194304);
+        OFCHECK_EQUAL(wan->receiveBufferSize, 2097152);
+        OFCHECK_EQUAL(wan->keepAlive, DUL_SOCKOPT_ENABLED);
+        OFCHECK_EQUAL(wan->keepAliveIdle, 60);
+        OFCHECK_EQUAL(wan->keepAliveInterval, 0);
+        OFCHECK_EQUAL(wan->tcpNoDelay, DUL_SOCKOPT_DEFAULT);
+    }
+    const T_ASC_SocketOptions *lan = cfg.getSocketOptions("LAN");
+    OFCHECK(lan != NULL);
+    if (lan != NULL)
+    {
+        OFCHECK_EQUAL(lan->tcpNoDelay, DUL_SOCKOPT_ENABLED);
+        OFCHECK_EQUAL(lan->tcpQuickAck, DUL_SOCKOPT_DISABLED);
+        OFCHECK_EQUAL(lan->sendBufferSize, 0);
+    }
+
+    // the profile passes the socket options to the association parameters
+    T_ASC_Parameters *params = NULL;
+    OFCHECK(ASC_createAssociationParameters(&params, ASC_DEFAULTMAXPDU).good());
+    OFCHECK(cfg.setAssociationParameters("REMOTE", *params).good());
+    OFCHECK_EQUAL(params->DULparams.socketOptions.receiveBufferSize, 2097152);
+    OFCHECK_EQUAL(params->DULparams.socketOptions.keepAlive, DUL_SOCKOPT_ENABLED);
+    ASC_destroyAssociationParameters(&params);
+
+    // a profile without socket options keeps the defaults
+    OFCHECK(ASC_createAssociationParameters(&params, ASC_DEFAULTMAXPDU).good());
+    OFCHECK(cfg.setAssociationParameters("PLAIN", *params).good());
+    OFCHECK_EQUAL(params->DULparams.socketOptions.receiveBufferSize, 0);
+    OFCHECK_EQUAL(params->DULparams.socketOptions.tcpNoDelay, DUL_SOCKOPT_DEFAULT);
+    ASC_destroyAssociationParameters(&params);
+
+    // a copy of the configuration contains the socket options
+    DcmAssociationConfiguration copy(cfg);
+    OFCHECK(copy.getSocketOptions("LAN") != NULL);
+
+    // invalid values and undefined references are rejected
+    OFString invalid(sockoptConfig);
+    invalid.replace(invalid.find("= 60"), 4, "= -1");
+    DcmAssociationConfiguration cfg2;
+    OFCHECK(readConfig(cfg2, invalid.c_str()).bad());
+    invalid = sockoptConfig;
+    invalid.replace(invalid.find("= on"), 4, "= maybe");
+    DcmAssociationConfiguration cfg3;
+    OFCHECK(readConfig(cfg3, invalid.c_str()).bad());
+    invalid = sockoptConfig;
+    invalid.replace(invalid.find("= LAN"), 5, "= MAN");
+    DcmAssociationConfiguration cfg4;
+    OFCHECK(readConfig(cfg4, invalid.c_str()).bad());
+}
+
+
+#if defined(WITH_THREADS) && !defined(_WIN32)
+
+struct SocketOptionsPool : DcmSCPPool<>, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = listen();
+    }
+};
+
+
+static int getIntSocketOption(DcmNativeSocketType sock, int level, int option)
+{
+    int value = -1;
+#ifdef HAVE_DECLARATION_SOCKLEN_T
+    socklen_t len = sizeof(value);
+#elif defined(HAVE_INTP_GETSOCKOPT)
+    int len = OFstatic_cast(int, sizeof(value));
+#else
+    size_t len = sizeof(value);
+#endif
+    if (getsockopt(sock, level, option, (char *) &value, &len) < 0)
+        return -1;
+    return value;
+}
+
+
+OFTEST_FLAGS(dcmnet_socket_options_applied, EF_Slow)
+{
+    SocketOptionsPool scp;
+    DcmSCPConfig& config = scp.getConfig();
+    config.setAETitle("SOCKOPT_SCP");
+    config.setPort(SOCKOPT_TEST_PORT);
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(config.addPresentationContext(UID_VerificationSOPClass, xfers).good());
+    scp.start();
+    OFStandard::sleep(2);
+
+    T_ASC_Network *net = NULL;
+    T_ASC_Parameters *params = NULL;
+    T_ASC_Association *assoc = NULL;
+    OFCHECK(ASC_initializeNetwork(NET_REQUESTOR, 0, 30, &net).good());
+    OFCHECK(ASC_createAssociationParameters(&params, ASC_DEFAULTMAXPDU).good());
+    ASC_setAPTitles(params, "SOCKOPT_SCU", "SOCKOPT_SCP", NULL);
+    char peer[64];
+    sprintf(peer, "localhost:%d", SOCKOPT_TEST_PORT);
+    ASC_setPresentationAddresses(params, "localhost", peer);
+    const char *ts[] = { UID_LittleEndianImplicitTransferSyntax };
+    OFCHECK(ASC_addPresentationContext(params, 1, UID_VerificationSOPClass, ts, 1).good());
+    T_ASC_SocketOptions options = T_ASC_SocketOptions();
+    options.tcpNoDelay = DUL_SOCKOPT_ENABLED;
+    options.keepAlive = DUL_SOCKOPT_ENABLED;
+    OFCHECK(ASC_setSocketOptions(params, options).good());
+    OFCHECK(ASC_requestAssociation(net, params, &assoc).good());
+
+    DcmTransportConnection *connection = (assoc != NULL) ? DUL_getTransportConnection(assoc->DULassociation) : NULL;
+    OFCHECK(connection != NULL);
+    if (connection != NULL)
+    {
+        const DcmNativeSocketType sock = connection->getSocket();
+        OFCHECK(getIntSocketOption(sock, IPPROTO_TCP, TCP_NODELAY) != 0);
+        OFCHECK(getIntSocketOption(sock, SOL_SOCKET, SO_KEEPALIVE) != 0);
+
+        // options can also be changed on the established connection
+        options.keepAlive = DUL_SOCKOPT_DISABLED;
+        OFCHECK(ASC_applySocketOptions(assoc, options).good());
+        OFCHECK_EQUAL(getIntSocketOption(sock, SOL_SOCKET, SO_KEEPALIVE), 0);
+    }
+
+    if (assoc != NULL)
+    {
+        OFCHECK(ASC_releaseAssociation(assoc).good());
+        ASC_destroyAssociation(&assoc);
+    }
+    ASC_dropNetwork(&net);
+
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.result.good());
+}
+
+#endif // WITH_THREADS && !_WIN32
@@ -0,0 +1,398 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test receiving datasets directly to file and transcoding
+ *           received datasets with DcmStorageSCP
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmdata/dcrledrg.h"
+#include "dcmtk/dcmdata/dcrleerg.h"
+#include "dcmtk/dcmnet/dstorscp.h"
+#include "dcmtk/dcmnet/scu.h"
+
+BEGIN_EXTERN_C
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#endif
+END_EXTERN_C
+
+
+/// port used by the tests in this file
+#define STORAGE_TEST_PORT 11118
+
+/// port used by the transcoding test
+#define TRANSCODING_TEST_PORT 11127
+
+/// output directory used by the tests in this file
+#define STORAGE_TEST_DIRECTORY "tstorscp.out"
+
+/// number of rows and columns of the image sent
+#define STORAGE_TEST_IMAGE_SIZE 1024
+
+/// output directory used by the transcoding test
+#define TRANSCODING_TEST_DIRECTORY "tstorscp_xfer.out"
+
+/// number of images sent by the transcoding test
+#define TRANSCODING_TEST_IMAGES 5
+
+/// number of rows and columns of the images sent by the transcoding test
+#define TRANSCODING_TEST_IMAGE_SIZE 256
+
+
+/** Storage SCP that handles exactly one association in a separate thread
+ *  and remembers the attributes passed to the notification handler
+ */
+struct BitPreservingStorageSCP : DcmStorageSCP, OFThread
+{
+    BitPreservingStorageSCP()
+      : DcmStorageSCP()
+      , m_listen_result(EC_NotYetImplemented)
+      , m_filename()
+      , m_patientName()
+      , m_hasPixelData(OFTrue)
+    {
+        DcmSCPConfig& config = getConfig();
+        config.setPort(STORAGE_TEST_PORT);
+        config.setAETitle("STORE_SCP");
+        config.setConnectionBlockingMode(DUL_NOBLOCK);
+        config.setConnectionTimeout(10);
+        OFList<OFString> xfers;
+        xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+        OFCHECK(config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+        OFCHECK(setOutputDirectory(STORAGE_TEST_DIRECTORY).good());
+        setDatasetStorageMode(DGM_StoreBitPreserving);
+        setDirectoryGenerationMode(DGM_SeriesDate);
+        // use chunks that are smaller than the dataset
+        setPreallocationChunkSize(1024 * 1024);
+    }
+
+    virtual void notifyInstanceStored(const OFString& filename,
+                                      const OFString& /* sopClassUID */,
+                                      const OFString& /* sopInstanceUID */,
+                                      DcmDataset* dataset) const
+    {
+        m_filename = filename;
+        if (dataset != NULL)
+        {
+            dataset->findAndGetOFString(DCM_PatientName, m_patientName);
+            m_hasPixelData = dataset->tagExists(DCM_PixelData);
+        }
+    }
+
+    virtual OFBool stopAfterCurrentAssociation()
+    {
+        return OFTrue;
+    }
+
+    virtual OFBool stopAfterConnectionTimeout()
+    {
+        return OFTrue;
+    }
+
+    virtual void run()
+    {
+        m_listen_result = listen();
+    }
+
+    /// result returned by listen()
+    OFCondition m_listen_result;
+    /// name of the file stored
+    mutable OFString m_filename;
+    /// patient's name parsed while receiving
+    mutable OFString m_patientName;
+    /// OFTrue if the pixel data has been parsed while receiving
+    mutable OFBool m_hasPixelData;
+};
+
+
+// remove a directory (that must be empty) and return the name of its parent
+static OFString removeDirectory(const OFString& dirName)
+{
+#ifdef _WIN32
+    _rmdir(dirName.c_str());
+#else
+    rmdir(dirName.c_str());
+#endif
+    OFString parent;
+    return OFStandard::getDirNameFromPath(parent, dirName);
+}
+
+
+OFTEST_FLAGS(dcmnet_storage_scp_bit_preserving, EF_Slow)
+{
+    OFCHECK(OFStandard::createDirectory(STORAGE_TEST_DIRECTORY, "").good());
+    BitPreservingStorageSCP scp;
+    scp.start();
+    OFStandard::sleep(1);
+
+    // create an image that is larger than the chunks reserved by the SCP
+    char uid[100];
+    DcmDataset dset;
+    OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT)).good());
+    OFCHECK(dset.putAndInsertString(DCM_SeriesDate, "20210304").good());
+    OFCHECK(dset.putAndInsertString(DCM_PatientName, "Bit^Preserving").good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Rows, STORAGE_TEST_IMAGE_SIZE).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_Columns, STORAGE_TEST_IMAGE_SIZE).good());
+    OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 16).good());
+    const unsigned long numPixels = STORAGE_TEST_IMAGE_SIZE * STORAGE_TEST_IMAGE_SIZE;
+    Uint16* pixels = new Uint16[numPixels];
+    for (unsigned long i = 0; i < numPixels; ++i)
+        pixels[i] = OFstatic_cast(Uint16, i * 7);
+    OFCHECK(dset.putAndInsertUint16Array(DCM_PixelData, pixels, numPixels).good());
+
+    DcmSCU scu;
+    scu.setAETitle("STORE_SCU");
+    scu.setPeerAETitle("STORE_SCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(STORAGE_TEST_PORT);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    OFCHECK(scu.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+    const T_ASC_PresentationContextID presID = scu.findAnyPresentationContextID(UID_SecondaryCaptureImageStorage, UID_LittleEndianExplicitTransferSyntax);
+    Uint16 status = 0;
+    OFCHECK(scu.sendSTORERequest(presID, "", &dset, status).good());
+    OFCHECK_EQUAL(status, STATUS_Success);
+    OFCHECK(scu.releaseAssociation().good());
+    scp.join();
+    OFCHECK(scp.m_listen_result.good());
+
+    // the header has been parsed while receiving, and the file has been moved
+    // to the subdirectory that is generated from the series date
+    OFCHECK_EQUAL(scp.m_patientName, "Bit^Preserving");
+    OFCHECK(!scp.m_hasPixelData);
+    OFString expected;
+    OFStandard::combineDirAndFilename(expected, STORAGE_TEST_DIRECTORY, "data");
+    expected += PATH_SEPARATOR;
+    expected += "2021";
+    expected += PATH_SEPARATOR;
+    expected += "03";
+    expected += PATH_SEPARATOR;
+    expected += "04";
+    OFString filename;
+    OFStandard::combineDirAndFilename(filename, expected, "SC.");
+    filename += uid;
+    OFCHECK_EQUAL(scp.m_filename, filename);
+
+    // no temporary file is left, and the file contains the complete dataset
+    OFList<OFString> files;
+    OFCHECK_EQUAL(OFStandard::searchDirectoryRecursively(STORAGE_TEST_DIRECTORY, files), 1);
+    DcmFileFormat fileformat;
+    OFCHECK(fileformat.loadFile(filename).good());
+    const Uint16* received = NULL;
+    unsigned long count = 0;
+    OFCHECK(fileformat.getDataset()->findAndGetUint16Array(DCM_PixelData, received, &count).good());
+    OFCHECK_EQUAL(count, numPixels);
+    OFCHECK(received != NULL && memcmp(received, pixels, numPixels * sizeof(Uint16)) == 0);
+    delete[] pixels;
+
+    // clean up
+    OFStandard::deleteFile(filename);
+    OFString dirName = expected;
+    while (!dirName.empty() && (dirName != STORAGE_TEST_DIRECTORY))
+        dirName = removeDirectory(dirName);
+    removeDirectory(STORAGE_TEST_DIRECTORY);
+}
+
+
+/** Storage SCP that handles exactly one association in a separate thread
+ *  and stores the received datasets with the given archive transfer syntax
+ */
+struct TranscodingStorageSCP : DcmStorageSCP, OFThread
+{
+    TranscodingStorageSCP(const size_t numWorkers,
+                          const E_TransferSyntax archiveXfer)
+      : DcmStorageSCP()
+      , m_listen_result(EC_NotYetImplemented)
+      , m_checked(0)
+      , m_filenames()
+    {
+        DcmSCPConfig& config = getConfig();
+        config.setPort(TRANSCODING_TEST_PORT);
+        config.setAETitle("STORE_SCP");
+        config.setConnectionBlockingMode(DUL_NOBLOCK);
+        config.setConnectionTimeout(10);
+        OFList<OFString> xfers;
+        xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+        OFCHECK(config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+        OFCHECK(setOutputDirectory(TRANSCODING_TEST_DIRECTORY).good());
+        setDirectoryGenerationMode(DGM_NoSubdirectory);
+        setArchiveTransferSyntax(archiveXfer);
+        // use the smallest queue so that the association has to wait for the workers
+        setTranscodingWorkers(numWorkers, 1);
+    }
+
+    ~TranscodingStorageSCP()
+    {
+        waitForTranscoding();
+    }
+
+    virtual Uint16 checkAndProcessSTORERequest(const T_DIMSE_C_StoreRQ& reqMessage,
+                                               DcmFileFormat& fileformat)
+    {
+        ++m_checked;
+        return DcmStorageSCP::checkAndProcessSTORERequest(reqMessage, fileformat);
+    }
+
+    virtual void notifyInstanceStored(const OFString& filename,
+                                      const OFString& /* sopClassUID */,
+                                      const OFString& /* sopInstanceUID */,
+                                      DcmDataset* /* dataset */) const
+    {
+        m_filenames.push_back(filename);
+    }
+
+    virtual OFBool stopAfterCurrentAssociation()
+    {
+        return OFTrue;
+    }
+
+    virtual OFBool stopAfterConnectionTimeout()
+    {
+        return OFTrue;
+    }
+
+    virtual void run()
+    {
+        m_listen_result = listen();
+    }
+
+    /// result returned by listen()
+    OFCondition m_listen_result;
+    /// number of calls of checkAndProcessSTORERequest()
+    size_t m_checked;
+    /// names of the files stored
+    mutable OFList<OFString> m_filenames;
+};
+
+
+// count the files written by the transcoding test (with or without temporary files)
+static size_t countStoredFiles(const OFBool temporaryFiles)
+{
+    size_t count = 0;
+    OFList<OFString> files;
+    OFStandard::searchDirectoryRecursively(TRANSCODING_TEST_DIRECTORY, files, "", "", OFFalse);
+    for (OFListIterator(OFString) it = files.begin(); it != files.end(); ++it)
+    {
+        if (temporaryFiles || (it->find(".part") == OFString_npos))
+            ++count;
+    }
+    return count;
+}
+
+
+OFTEST_FLAGS(dcmnet_storage_scp_transcoding, EF_Slow)
+{
+    DcmRLEDecoderRegistration::registerCodecs();
+    DcmRLEEncoderRegistration::registerCodecs();
+    const unsigned long numPixels = TRANSCODING_TEST_IMAGE_SIZE * TRANSCODING_TEST_IMAGE_SIZE;
+    Uint8* pixels = new Uint8[numPixels];
+    for (unsigned long i = 0; i < numPixels; ++i)
+        pixels[i] = OFstatic_cast(Uint8, (i / 64) % 256);
+
+    // transcode synchronously as well as in worker threads, the last run uses a
+    // transfer syntax without registered codec, so the datasets cannot be transcoded
+    const size_t numWorkers[] = { 0, 2, 2 };
+    const E_TransferSyntax archiveXfers[] = { EXS_RLELossless, EXS_RLELossless, EXS_JPEGLSLossless };
+    const E_TransferSyntax storedXfers[] = { EXS_RLELossless, EXS_RLELossless, EXS_LittleEndianExplicit };
+    for (size_t run = 0; run < 3; ++run)
+    {
+        OFCHECK(OFStandard::createDirectory(TRANSCODING_TEST_DIRECTORY, "").good());
+        TranscodingStorageSCP scp(numWorkers[run], archiveXfers[run]);
+        scp.start();
+        OFStandard::sleep(1);
+
+        DcmSCU scu;
+        scu.setAETitle("STORE_SCU");
+        scu.setPeerAETitle("STORE_SCP");
+        scu.setPeerHostName("localhost");
+        scu.setPeerPort(TRANSCODING_TEST_PORT);
+        OFList<OFString> xfers;
+        xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+        OFCHECK(scu.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+        OFCHECK(scu.initNetwork().good());
+        OFCHECK(scu.negotiateAssociation().good());
+        const T_ASC_PresentationContextID presID = scu.findAnyPresentationContextID(UID_SecondaryCaptureImageStorage, UID_LittleEndianExplicitTransferSyntax);
+        for (int i = 0; i < TRANSCODING_TEST_IMAGES; ++i)
+        {
+            char uid[100];
+            DcmDataset dset;
+            OFCHECK(dset.putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+            OFCHECK(dset.putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT)).good());
+            OFCHECK(dset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+            OFCHECK(dset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+            OFCHECK(dset.putAndInsertUint16(DCM_Rows, TRANSCODING_TEST_IMAGE_SIZE).good());
+            OFCHECK(dset.putAndInsertUint16(DCM_Columns, TRANSCODING_TEST_IMAGE_SIZE).good());
+            OFCHECK(dset.putAndInsertUint16(DCM_BitsAllocated, 8).good());
+            OFCHECK(dset.putAndInsertUint16(DCM_BitsStored, 8).good());
+            OFCHECK(dset.putAndInsertUint16(DCM_HighBit, 7).good());
+            OFCHECK(dset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+            OFCHECK(dset.putAndInsertUint8Array(DCM_PixelData, pixels, numPixels).good());
+            Uint16 status = 0;
+            OFCHECK(scu.sendSTORERequest(presID, "", &dset, status).good());
+            OFCHECK_EQUAL(status, STATUS_Success);
+            // the dataset has been written to disk before the response was sent
+            OFCHECK_EQUAL(countStoredFiles(OFTrue), OFstatic_cast(size_t, i + 1));
+        }
+        OFCHECK(scu.releaseAssociation().good());
+        scp.join();
+        OFCHECK(scp.m_listen_result.good());
+        scp.waitForTranscoding();
+
+        // all images have been checked and stored, no temporary file is left
+        OFCHECK_EQUAL(scp.m_checked, TRANSCODING_TEST_IMAGES);
+        OFCHECK_EQUAL(scp.m_filenames.size(), TRANSCODING_TEST_IMAGES);
+        OFCHECK_EQUAL(countStoredFiles(OFTrue), OFstatic_cast(size_t, TRANSCODING_TEST_IMAGES));
+        OFCHECK_EQUAL(countStoredFiles(OFFalse), OFstatic_cast(size_t, TRANSCODING_TEST_IMAGES));
+        for (OFListIterator(OFString) it = scp.m_filenames.begin(); it != scp.m_filenames.end(); ++it)
+        {
+            DcmFileFormat fileformat;
+            OFCHECK(fileformat.loadFile(*it).good());
+            DcmDataset* dataset = fileformat.getDataset();
+            OFCHECK_EQUAL(dataset->getOriginalXfer(), storedXfers[run]);
+            OFCHECK(dataset->chooseRepresentation(EXS_LittleEndianExplicit, NULL).good());
+            // the decompressed pixel data is encoded as OW
+            DcmElement* pixelData = NULL;
+            Uint8* received = NULL;
+            OFCHECK(dataset->findAndGetElement(DCM_PixelData, pixelData).good());
+            OFCHECK(pixelData != NULL && pixelData->getUint8Array(received).good());
+            OFCHECK(pixelData != NULL && pixelData->getLength() == numPixels);
+            OFCHECK(received != NULL && memcmp(received, pixels, numPixels) == 0);
+            OFStandard::deleteFile(*it);
+        }
+        removeDirectory(TRANSCODING_TEST_DIRECTORY);
+    }
+    delete[] pixels;
+    DcmRLEEncoderRegistration::cleanup();
+    DcmRLEDecoderRegistration::cleanup();
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,421 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmnet
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test sending SOP instances over parallel associations and
+ *           sending large DICOM files without loading them into memory
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/dcmdata/dctk.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmnet/dstorscu.h"
+
+
+/// port used by the tests in this file
+#define PARALLEL_TEST_PORT 11122
+
+/// number of SOP instances sent from file in each test
+#define PARALLEL_TEST_FILES 12
+
+/// number of SOP instances sent from memory in each test
+#define PARALLEL_TEST_DATASETS 4
+
+/// size of the pixel data sent from file (larger than DCM_MaxReadLength)
+#define STREAMING_TEST_PIXEL_SIZE (1024 * 1024)
+
+/// number of C-STORE requests received by the SCP
+static size_t receivedCount = 0;
+
+/// length of the pixel data received last by the SCP
+static Uint32 receivedPixelLength = 0;
+
+/// sum of the pixel data values received last by the SCP
+static Uint32 receivedPixelSum = 0;
+
+/// mutex protecting receivedCount and the pixel data information
+static OFMutex receivedCountMutex;
+
+
+static size_t getReceivedCount()
+{
+    receivedCountMutex.lock();
+    const size_t result = receivedCount;
+    receivedCountMutex.unlock();
+    return result;
+}
+
+
+/** Storage SCP worker that accepts C-STORE requests (without storing the datasets)
+ */
+struct ParallelStoreSCP : DcmThreadSCP
+{
+    virtual OFCondition handleIncomingCommand(T_DIMSE_Message* incomingMsg,
+                                              const DcmPresentationContextInfo& presInfo)
+    {
+        if (incomingMsg->CommandField == DIMSE_C_STORE_RQ)
+        {
+            T_DIMSE_C_StoreRQ& req = incomingMsg->msg.CStoreRQ;
+            DcmDataset* dataset = NULL;
+            OFCondition cond = receiveSTORERequest(req, presInfo.presentationContextID, dataset);
+            const Uint8* pixels = NULL;
+            unsigned long length = 0;
+            if (dataset != NULL)
+                dataset->findAndGetUint8Array(DCM_PixelData, pixels, &length);
+            if (cond.good())
+            {
+                receivedCountMutex.lock();
+                ++receivedCount;
+                receivedPixelLength = OFstatic_cast(Uint32, length);
+                receivedPixelSum = 0;
+                for (unsigned long i = 0; i < length; ++i)
+                    receivedPixelSum += pixels[i];
+                receivedCountMutex.unlock();
+                cond = sendSTOREResponse(presInfo.presentationContextID, req, STATUS_Success);
+            }
+            delete dataset;
+            return cond;
+        }
+        return DcmThreadSCP::handleIncomingCommand(incomingMsg, presInfo);
+    }
+};
+
+
+struct ParallelStorePool : DcmSCPPool<ParallelStoreSCP>, OFThread
+{
+    ParallelStorePool()
+      : DcmSCPPool<ParallelStoreSCP>()
+      , OFThread()
+      , m_listen_result(EC_NotYetImplemented)
+    {
+        DcmSCPConfig& config = getConfig();
+        config.setPort(PARALLEL_TEST_PORT);
+        config.setAETitle("PARALLEL_SCP");
+        config.setConnectionBlockingMode(DUL_NOBLOCK);
+        config.setConnectionTimeout(1);
+        OFList<OFString> xfers;
+        xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+        xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+        OFCHECK(config.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+        setMaxThreads(PARALLEL_TEST_FILES + PARALLEL_TEST_DATASETS);
+    }
+
+    virtual void run()
+    {
+        m_listen_result = listen();
+    }
+
+    /// result returned by listen()
+    OFCondition m_listen_result;
+};
+
+
+/** Storage SCU that counts the SOP instances processed and checks that it is
+ *  never notified concurrently
+ */
+struct ParallelStorageSCU : DcmStorageSCU
+{
+    ParallelStorageSCU(const size_t stopAfter = 0)
+      : DcmStorageSCU()
+      , m_toBeSent(0)
+      , m_sent(0)
+      , m_success(0)
+      , m_concurrent(0)
+      , m_inNotification(OFFalse)
+      , m_stopAfter(stopAfter)
+    {
+        setAETitle("PARALLEL_SCU");
+        setPeerAETitle("PARALLEL_SCP");
+        setPeerHostName("localhost");
+        setPeerPort(PARALLEL_TEST_PORT);
+    }
+
+    virtual void notifySOPInstanceToBeSent(const TransferEntry& /* transferEntry */)
+    {
+        enterNotification();
+        ++m_toBeSent;
+        leaveNotification();
+    }
+
+    virtual void notifySOPInstanceSent(const TransferEntry& transferEntry)
+    {
+        enterNotification();
+        ++m_sent;
+        if (transferEntry.RequestSent && (transferEntry.ResponseStatusCode == STATUS_Success))
+            ++m_success;
+        leaveNotification();
+    }
+
+    virtual OFBool shouldStopAfterCurrentSOPInstance()
+    {
+        return (m_stopAfter > 0) && (m_sent >= m_stopAfter);
+    }
+
+    void enterNotification()
+    {
+        if (m_inNotification)
+            ++m_concurrent;
+        m_inNotification = OFTrue;
+        // give other threads the chance to interfere
+        OFStandard::milliSleep(2);
+    }
+
+    void leaveNotification()
+    {
+        m_inNotification = OFFalse;
+    }
+
+    /// number of SOP instances to be sent
+    size_t m_toBeSent;
+    /// number of SOP instances processed
+    size_t m_sent;
+    /// number of SOP instances stored successfully
+    size_t m_success;
+    /// number of concurrent notifications detected
+    size_t m_concurrent;
+    /// flag indicating whether a notification is currently processed
+    OFBool m_inNotification;
+    /// stop after the given number of SOP instances, 0 = never
+    size_t m_stopAfter;
+};
+
+
+// create a small dataset that can be sent to the storage SCP
+static DcmDataset* createDataset(const size_t number)
+{
+    char uid[100];
+    char buffer[16];
+    OFStandard::snprintf(buffer, sizeof(buffer), "%u", OFstatic_cast(unsigned int, number));
+    DcmDataset* dset = new DcmDataset();
+    OFCHECK(dset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT)).good());
+    OFCHECK(dset->putAndInsertString(DCM_InstanceNumber, buffer).good());
+    OFCHECK(dset->putAndInsertString(DCM_PatientName, "Parallel^Test").good());
+    return dset;
+}
+
+
+// get the name of a test file
+static OFString getFilename(const size_t number)
+{
+    char buffer[32];
+    OFStandard::snprintf(buffer, sizeof(buffer), "tstorscu_%u.dcm", OFstatic_cast(unsigned int, number));
+    return buffer;
+}
+
+
+// create the test files and add them (and some datasets) to the transfer list
+static void addSOPInstances(DcmStorageSCU& scu)
+{
+    for (size_t i = 0; i < PARALLEL_TEST_FILES; ++i)
+    {
+        DcmFileFormat fileformat(createDataset(i), OFFalse /* deepCopy */);
+        OFCHECK(fileformat.saveFile(getFilename(i), EXS_LittleEndianExplicit).good());
+        OFCHECK(scu.addDicomFile(getFilename(i)).good());
+    }
+    for (size_t i = 0; i < PARALLEL_TEST_DATASETS; ++i)
+        OFCHECK(scu.addDataset(createDataset(PARALLEL_TEST_FILES + i), EXS_LittleEndianExplicit, DcmStorageSCU::HM_deleteAfterRemove).good());
+}
+
+
+static void deleteFiles()
+{
+    for (size_t i = 0; i < PARALLEL_TEST_FILES; ++i)
+        OFStandard::deleteFile(getFilename(i));
+}
+
+
+OFTEST_FLAGS(dcmnet_storage_scu_parallel, EF_Slow)
+{
+    ParallelStorePool scp;
+    scp.start();
+    OFStandard::sleep(1);
+    receivedCount = 0;
+
+    ParallelStorageSCU scu;
+    addSOPInstances(scu);
+    const size_t total = PARALLEL_TEST_FILES + PARALLEL_TEST_DATASETS;
+    OFCHECK(scu.sendSOPInstancesInParallel(3).good());
+    OFCHECK_EQUAL(scu.getAssociationCounter(), 3);
+    OFCHECK_EQUAL(scu.getNumberOfSOPInstancesToBeSent(), 0);
+    OFCHECK_EQUAL(scu.m_toBeSent, total);
+    OFCHECK_EQUAL(scu.m_sent, total);
+    OFCHECK_EQUAL(scu.m_success, total);
+    OFCHECK_EQUAL(scu.m_concurrent, 0);
+    OFCHECK_EQUAL(getReceivedCount(), total);
+    // nothing left to be sent
+    OFCHECK(scu.sendSOPInstancesInParallel(3).good());
+    OFCHECK_EQUAL(scu.getAssociationCounter(), 3);
+    // send everything again with more associations than SOP instances
+    scu.resetSentStatus();
+    OFCHECK(scu.sendSOPInstancesInParallel(2 * total).good());
+    OFCHECK_EQUAL(scu.getAssociationCounter(), 3 + total);
+    OFCHECK_EQUAL(scu.m_success, 2 * total);
+    OFCHECK_EQUAL(getReceivedCount(), 2 * total);
+
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.m_listen_result.good());
+    deleteFiles();
+}
+
+
+OFTEST_FLAGS(dcmnet_storage_scu_parallel_stop, EF_Slow)
+{
+    ParallelStorePool scp;
+    scp.start();
+    OFStandard::sleep(1);
+    receivedCount = 0;
+
+    ParallelStorageSCU scu(5 /* stopAfter */);
+    addSOPInstances(scu);
+    const size_t total = PARALLEL_TEST_FILES + PARALLEL_TEST_DATASETS;
+    OFCHECK(scu.sendSOPInstancesInParallel(3).good());
+    // each association stops after its current SOP instance
+    OFCHECK(scu.m_sent >= 5);
+    OFCHECK(scu.m_sent < total);
+    OFCHECK_EQUAL(scu.m_sent, scu.m_success);
+    OFCHECK_EQUAL(scu.getNumberOfSOPInstancesToBeSent(), total - scu.m_sent);
+    OFCHECK_EQUAL(getReceivedCount(), scu.m_sent);
+
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.m_listen_result.good());
+    deleteFiles();
+}
+
+
+/** SCU that replaces the file being sent when the first part of the dataset
+ *  has been sent
+ */
+struct StreamingSCU : DcmSCU
+{
+    StreamingSCU()
+      : DcmSCU()
+      , m_filename()
+      , m_replacement(NULL)
+    {
+    }
+
+    virtual void notifySENDProgress(const unsigned long byteCount)
+    {
+        if (m_replacement != NULL)
+        {
+            OFCHECK(m_replacement->saveFile(m_filename, EXS_LittleEndianExplicit).good());
+            m_replacement = NULL;
+        }
+        DcmSCU::notifySENDProgress(byteCount);
+    }
+
+    /// name of the file to be replaced
+    OFString m_filename;
+    /// dataset the file is replaced with (if not NULL)
+    DcmFileFormat* m_replacement;
+};
+
+
+OFTEST_FLAGS(dcmnet_scu_store_file_streamed, EF_Slow)
+{
+    ParallelStorePool scp;
+    scp.start();
+    OFStandard::sleep(1);
+    receivedCount = 0;
+
+    // create a file with pixel data that is not loaded when the file is read
+    const OFString filename = getFilename(0);
+    Uint8* pixels = new Uint8[STREAMING_TEST_PIXEL_SIZE];
+    Uint32 pixelSum = 0;
+    for (size_t i = 0; i < STREAMING_TEST_PIXEL_SIZE; ++i)
+    {
+        pixels[i] = OFstatic_cast(Uint8, i * 7);
+        pixelSum += pixels[i];
+    }
+    DcmDataset* dset = createDataset(0);
+    OFCHECK(dset->putAndInsertUint8Array(DCM_PixelData, pixels, STREAMING_TEST_PIXEL_SIZE).good());
+    delete[] pixels;
+    DcmFileFormat original(dset, OFFalse /* deepCopy */);
+    OFCHECK(original.saveFile(filename, EXS_LittleEndianExplicit).good());
+
+    StreamingSCU scu;
+    scu.setAETitle("PARALLEL_SCU");
+    scu.setPeerAETitle("PARALLEL_SCP");
+    scu.setPeerHostName("localhost");
+    scu.setPeerPort(PARALLEL_TEST_PORT);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    OFCHECK(scu.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    OFCHECK(scu.initNetwork().good());
+    OFCHECK(scu.negotiateAssociation().good());
+
+    // send the file given by its name
+    Uint16 status = 0;
+    OFCHECK(scu.sendSTORERequest(0, filename, NULL, status).good());
+    OFCHECK_EQUAL(status, STATUS_Success);
+    OFCHECK_EQUAL(getReceivedCount(), 1);
+    receivedCountMutex.lock();
+    OFCHECK_EQUAL(receivedPixelLength, STREAMING_TEST_PIXEL_SIZE);
+    OFCHECK_EQUAL(receivedPixelSum, pixelSum);
+    receivedCountMutex.unlock();
+
+    // the pixel data of a file given by its name is read while it is sent, so
+    // replacing the pixel data in the file during the transmission is noticed
+    pixels = new Uint8[STREAMING_TEST_PIXEL_SIZE];
+    memset(pixels, 0, STREAMING_TEST_PIXEL_SIZE);
+    dset = createDataset(0);
+    OFCHECK(dset->putAndInsertUint8Array(DCM_PixelData, pixels, STREAMING_TEST_PIXEL_SIZE).good());
+    delete[] pixels;
+    DcmFileFormat replacement(dset, OFFalse /* deepCopy */);
+    scu.m_filename = filename;
+    scu.m_replacement = &replacement;
+    OFCHECK(scu.sendSTORERequest(0, filename, NULL, status).good());
+    OFCHECK_EQUAL(status, STATUS_Success);
+    OFCHECK(scu.m_replacement == NULL);
+    OFCHECK_EQUAL(getReceivedCount(), 2);
+    receivedCountMutex.lock();
+    OFCHECK_EQUAL(receivedPixelLength, STREAMING_TEST_PIXEL_SIZE);
+    OFCHECK(receivedPixelSum < pixelSum);
+    receivedCountMutex.unlock();
+    OFCHECK(original.saveFile(filename, EXS_LittleEndianExplicit).good());
+
+    // the pixel data of a dataset read from file is not loaded by sending it
+    DcmFileFormat fileformat;
+    OFCHECK(fileformat.loadFile(filename).good());
+    DcmElement* pixelData = NULL;
+    OFCHECK(fileformat.getDataset()->findAndGetElement(DCM_PixelData, pixelData).good());
+    OFCHECK(pixelData != NULL && !pixelData->valueLoaded());
+    OFCHECK(scu.sendSTORERequest(0, "", fileformat.getDataset(), status).good());
+    OFCHECK_EQUAL(status, STATUS_Success);
+    OFCHECK(pixelData != NULL && !pixelData->valueLoaded());
+    OFCHECK_EQUAL(getReceivedCount(), 3);
+    receivedCountMutex.lock();
+    OFCHECK_EQUAL(receivedPixelLength, STREAMING_TEST_PIXEL_SIZE);
+    OFCHECK_EQUAL(receivedPixelSum, pixelSum);
+    receivedCountMutex.unlock();
+    OFCHECK(scu.releaseAssociation().good());
+
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.m_listen_result.good());
+    OFStandard::deleteFile(filename);
+}
+
+#endif // WITH_THREADS
@@ -64,6 +64,7 @@ int main (int argc, char *argv[])
     const char *opt_storageArea = NULL;
     OFBool opt_print = OFFalse;
     OFBool opt_isNewFlag = OFTrue;
+    OFBool opt_convert = OFFalse;
 
 #ifdef WITH_TCPWRAPPER
     // this code makes sure that the linker cannot optimize away
@@ -86,6 +87,7 @@ int main (int argc, char *argv[])
      OFLog::addOptions(cmd);
      cmd.addOption("--print",   "-p", "list contents of database index file");
      cmd.addOption("--not-new", "-n", "set instance reviewed status to 'not new'");
+     cmd.addOption("--convert-legacy", "-c", "convert database index file from legacy format");
 
     /* evaluate command line */
     prepareCmdLineArgs(argc, argv, OFFIS_CONSOLE_APPLICATION);
@@ -123,6 +125,9 @@ int main (int argc, char *argv[])
 
         if (cmd.findOption("--not-new"))
             opt_isNewFlag = OFFalse;
+
+        if (cmd.findOption("--convert-legacy"))
+            opt_convert = OFTrue;
     }
 
     /* print resource identifier */
@@ -135,6 +140,17 @@ int main (int argc, char *argv[])
             << DCM_DICT_ENVIRONMENT_VARIABLE);
     }
 
+    /* convert index file before it is opened */
+    if (opt_convert)
+    {
+        OFLOG_INFO(dcmqridxLogger, "converting database index file in: " << opt_storageArea);
+        if (DcmQueryRetrieveIndexDatabaseHandle::convertLegacyIndexFile(opt_storageArea).bad())
+        {
+            OFLOG_FATAL(dcmqridxLogger, "cannot convert database index file in: " << opt_storageArea);
+            return 1;
+        }
+    }
+
     OFCondition cond;
     DcmQueryRetrieveIndexDatabaseHandle hdl(opt_storageArea, DB_UpperMaxStudies, DB_UpperMaxBytesPerStudy, cond);
     if (cond.good())
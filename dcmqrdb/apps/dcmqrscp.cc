@@ -170,6 +170,11 @@ main(int argc, char *argv[])
       cmd.addOption("--move-aetitle",           "-ZA",     "restrict move dest. to requesting AE title");
       cmd.addOption("--move-host",              "-ZH",     "restrict move destination to requesting host");
       cmd.addOption("--move-vendor",            "-ZV",     "restrict move destination to requesting vendor");
+#ifdef WITH_THREADS
+    cmd.addSubGroup("move sub-operations:");
+      cmd.addOption("--move-associations",      "-ma",  1, "[n]umber: integer (1..16, default: 1)",
+                                                           "send instances to move destination over n\nparallel sub-associations");
+#endif
     cmd.addSubGroup("restriction of query/retrieve models:");
       cmd.addOption("--no-patient-root",        "-QP",     "do not support Patient Root Q/R models");
       cmd.addOption("--no-study-root",          "-QS",     "do not support Study Root Q/R models");
@@ -386,6 +391,9 @@ main(int argc, char *argv[])
       if (cmd.findOption("--move-host")) options.restrictMoveToSameHost_ = OFTrue;
       if (cmd.findOption("--move-vendor")) options.restrictMoveToSameVendor_ = OFTrue;
       cmd.endOptionBlock();
+#ifdef WITH_THREADS
+      if (cmd.findOption("--move-associations")) app.checkValue(cmd.getValueAndCheckMinMax(options.maxMoveSubAssociations_, 1, 16));
+#endif
 
       if (cmd.findOption("--no-patient-root")) options.supportPatientRoot_ = OFFalse;
       if (cmd.findOption("--no-study-root")) options.supportStudyRoot_ = OFFalse;
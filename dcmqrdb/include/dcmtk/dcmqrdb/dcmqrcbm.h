@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1993-2018, OFFIS e.V.
+ *  Copyright (C) 1993-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -26,11 +26,13 @@
 #include "dcmtk/dcmnet/dimse.h"
 #include "dcmtk/dcmnet/dcasccfg.h"
 #include "dcmtk/dcmqrdb/qrdefine.h"
+#include "dcmtk/ofstd/ofvector.h"
 
 class DcmQueryRetrieveDatabaseHandle;
 class DcmQueryRetrieveOptions;
 class DcmQueryRetrieveConfig;
 class DcmQueryRetrieveDatabaseStatus;
+class OFThreadPool;
 
 /** this class maintains the context information that is passed to the
  *  callback function called by DIMSE_moveProvider.
@@ -61,7 +63,8 @@ public:
     , associationConfiguration_(associationConfiguration)
     , priorStatus(priorstatus)
     , origAssoc(assoc)
-    , subAssoc(NULL)
+    , subAssocs()
+    , subOpPool(NULL)
     , config(cfg)
     , assocStarted(OFFalse)
     , origMsgId(msgid)
@@ -79,8 +82,12 @@ public:
       origAETitle[0] = '\0';
       origHostName[0] = '\0';
       dstAETitle[0] = '\0';
+      dstHostNamePlusPort[0] = '\0';
     }
 
+    /// destructor
+    ~DcmQueryRetrieveMoveContext();
+
     /** callback handler called by the DIMSE_storeProvider callback function.
      *  @param cancelled (in) flag indicating whether a C-CANCEL was received
      *  @param request original move request (in)
@@ -114,11 +121,42 @@ private:
     /// private undefined assignment operator
     DcmQueryRetrieveMoveContext& operator=(const DcmQueryRetrieveMoveContext& other);
 
+    /// result of a single store sub-operation
+    enum SubOperationResult
+    {
+      /// sub-operation has not been performed (yet)
+      SOR_Pending,
+      /// sub-operation completed successfully
+      SOR_Completed,
+      /// sub-operation completed with a warning status
+      SOR_Warning,
+      /// sub-operation failed
+      SOR_Failed,
+      /** sub-operation failed on the network level before the request has been
+       *  sent completely, the sub-association is no longer usable. The
+       *  sub-operation can safely be repeated on another sub-association.
+       */
+      SOR_AssociationFailed,
+      /** the request has been sent completely but no response has been
+       *  received, the sub-association is no longer usable. The move
+       *  destination might have stored the instance, so the sub-operation is
+       *  not repeated (which could store it twice) but counted as failed.
+       */
+      SOR_Unknown
+    };
+
+    struct SubOperation;
+    class SubOperationTask;
+    friend class SubOperationTask;
+
     void addFailedUIDInstance(const char *sopInstance);
-    OFCondition performMoveSubOp(DIC_UI sopClass, DIC_UI sopInstance, char *fname);
+    void performMoveSubOp(T_ASC_Association *assoc, SubOperation& subOp);
+    void performMoveSubOps(OFVector<SubOperation>& subOps);
     OFCondition buildSubAssociation(T_DIMSE_C_MoveRQ *request);
+    OFCondition requestSubAssociation(T_ASC_Association **assoc);
+    void abortSubAssociation(T_ASC_Association **assoc);
     OFCondition closeSubAssociation();
-    void moveNextImage(DcmQueryRetrieveDatabaseStatus * dbStatus);
+    void moveNextImages(DcmQueryRetrieveDatabaseStatus * dbStatus);
     void failAllSubOperations(DcmQueryRetrieveDatabaseStatus * dbStatus);
     void buildFailedInstanceList(DcmDataset ** rspIds);
     OFBool mapMoveDestination(
@@ -141,8 +179,15 @@ private:
     /// pointer to original association on which the C-MOVE-RQ was received
     T_ASC_Association   *origAssoc;     /* association of requestor */
 
-    /// pointer to sub-association for outgoing C-STORE-RQ
-    T_ASC_Association   *subAssoc;      /* sub-association */
+    /** sub-associations for outgoing C-STORE-RQ. The store sub-operations
+     *  are performed in parallel if there is more than one sub-association.
+     */
+    OFVector<T_ASC_Association *> subAssocs;
+
+    /** thread pool performing the store sub-operations, one thread per
+     *  sub-association. Created once for all sub-operations of a move request.
+     */
+    OFThreadPool *subOpPool;
 
     /// pointer to Q/R configuration
     const DcmQueryRetrieveConfig *config;
@@ -168,6 +213,9 @@ private:
     /// destination title for move
     DIC_AE dstAETitle;
 
+    /// host name and port of move destination
+    DIC_NODENAME dstHostNamePlusPort;
+
     /// instance UIDs of failed store sub-ops
     char *failedUIDs;
 
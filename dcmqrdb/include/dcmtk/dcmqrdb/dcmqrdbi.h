@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1993-2017, OFFIS e.V.
+ *  Copyright (C) 1993-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -28,6 +28,7 @@
 #include "dcmtk/dcmnet/dicom.h"
 #include "dcmtk/dcmnet/dimse.h"
 #include "dcmtk/ofstd/offname.h"
+#include "dcmtk/ofstd/ofvector.h"
 
 struct StudyDescRecord;
 struct DB_Private_Handle;
@@ -40,8 +41,22 @@ class DcmQueryRetrieveConfig;
 
 #define DBINDEXFILE  "index.dat"
 #define DBMAGIC      "QRDB"
-#define DBVERSION    5
-#define DBHEADERSIZE 6
+#define DBVERSION    6
+
+/* the header of the index file starts with the magic word and the version
+ * number in hexadecimal notation (DBIDENTSIZE characters). It is followed by
+ * the generation counter (Uint64 in the byte order of the host) at offset
+ * DBGENERATIONOFFSET, which is incremented with each modification of the
+ * index records. The attribute index uses it to detect that it is outdated.
+ */
+#define DBIDENTSIZE        6
+#define DBGENERATIONOFFSET 8
+#define DBHEADERSIZE       16
+
+/* version of the legacy index file format with fixed-size records that can
+ * be converted to the current format, see convertLegacyIndexFile()
+ */
+#define DBLEGACYVERSION 5
 
 #if DBVERSION > 0xFF
 #error maximum database version reached, you have to invent a new mechanism
@@ -265,6 +280,18 @@ public:
    *  @param storeArea name of storage area, must not be NULL
    */
   static void printIndexFile (char *storeArea);
+
+  /** convert the index file of the given storage area from the legacy
+   *  format (version DBLEGACYVERSION), which stores a fixed-size binary copy
+   *  of struct IdxRecord per instance, to the current compact format.
+   *  Index files that already use the current format are left unchanged.
+   *  The attribute index of the storage area is deleted and rebuilt when the
+   *  storage area is opened the next time. No other process should access the
+   *  storage area during the conversion.
+   *  @param storeArea name of storage area, must not be NULL
+   *  @return EC_Normal if successful, an error code otherwise
+   */
+  static OFCondition convertLegacyIndexFile(const char *storeArea);
   
   /** search for a SOP class and SOP instance UIDs in index file. 
   *  @param storeArea name of storage area, must not be NULL
@@ -397,6 +424,49 @@ private:
       DB_LEVEL        infLevel,
       DB_LEVEL        lowestLevel);
 
+  /** check whether the attribute index file can be used, i.e.\ whether it
+   *  reflects the current state of the index file.
+   *  @param rebuild if OFTrue, rebuild the attribute index file if it is out
+   *    of date. Requires an exclusive lock on the index file.
+   *  @return OFTrue if the attribute index file can be used, OFFalse otherwise
+   */
+  OFBool DB_KeyIndexAvailable(OFBool rebuild);
+
+  /** rebuild the attribute index file from the index file.
+   *  Requires an exclusive lock on the index file.
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition DB_KeyIndexRebuild();
+
+  /** determine the numbers of all index records that may have the given
+   *  attribute value, using the attribute index file if possible.
+   *  If the attribute index file cannot be used, the numbers of all index
+   *  records are returned. Callers must verify each record.
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param value attribute value
+   *  @param prefixMatch if OFTrue, return records with values starting with the given value
+   *  @param records record numbers returned in ascending order in this parameter
+   */
+  void DB_KeyIndexFind(int key, const char *value, OFBool prefixMatch, OFVector<int>& records);
+
+  /** determine the index records that may match the current find or move
+   *  request by means of the attribute index file. Only keys that are actually
+   *  compared by hierarchicalCompare() are taken into account.
+   *  @param qLevel top level of the information model
+   *  @return OFTrue if a list of candidate records has been created,
+   *    OFFalse if all records have to be checked
+   */
+  OFBool DB_SelectCandidates(DB_LEVEL qLevel);
+
+  /** get next index record to be checked for the current find or move request,
+   *  i.e.\ the next candidate record if DB_SelectCandidates() has been successful,
+   *  the next record in use otherwise.
+   *  @param idx pointer to index number, updated upon successful return
+   *  @param idxRec pointer to index record structure
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition DB_IdxGetNextCandidate(int *idx, IdxRecord *idxRec);
+
   /// database handle
   DB_Private_Handle *handle_;
 
@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1993-2018, OFFIS e.V.
+ *  Copyright (C) 1993-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -25,6 +25,7 @@
 #include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
 
 #include "dcmtk/ofstd/ofoption.h"
+#include "dcmtk/ofstd/ofvector.h"
 #include "dcmtk/dcmnet/dicom.h"
 #include "dcmtk/dcmdata/dcdatset.h"
 #include "dcmtk/dcmdata/dcuid.h"
@@ -40,6 +41,8 @@ BEGIN_EXTERN_C
 #endif
 END_EXTERN_C
 
+class DcmQueryRetrieveKeyIndex;
+
 // include this file in doxygen documentation
 
 /** @file dcmqridx.h
@@ -209,6 +212,7 @@ struct DCMTK_DCMQRDB_EXPORT DB_UidList
 struct DCMTK_DCMQRDB_EXPORT DB_CounterList
 {
     int idxCounter ;
+    char SOPInstanceUID [UI_MAX_LENGTH+1] ;
     struct DB_CounterList *next ;
 };
 
@@ -244,6 +248,13 @@ struct DCMTK_DCMQRDB_EXPORT DB_Private_Handle
     int NumberRemainOperations ;
     DB_QUERY_CLASS rootLevel ;
     DB_UidList *uidList ;
+    DcmQueryRetrieveKeyIndex *keyIndex ;
+    OFBool useCandidates ;
+    OFVector<int> candidates ;
+    size_t nextCandidate ;
+    char *readBuffer ;
+    long readBufferOffset ;
+    long readBufferLength ;
 
     DB_Private_Handle()
     : pidx(0)
@@ -261,6 +272,13 @@ struct DCMTK_DCMQRDB_EXPORT DB_Private_Handle
     , NumberRemainOperations(0)
     , rootLevel(STUDY_ROOT)
     , uidList(NULL)
+    , keyIndex(NULL)
+    , useCandidates(OFFalse)
+    , candidates()
+    , nextCandidate(0)
+    , readBuffer(NULL)
+    , readBufferOffset(0)
+    , readBufferLength(0)
     {
     }
 };
@@ -350,8 +368,10 @@ struct DCMTK_DCMQRDB_EXPORT ImagesofStudyArray
 /* ENSURE THAT DBVERSION IS INCREMENTED WHENEVER ONE OF THESE STRUCTS IS MODIFIED */
 
 /** this class manages an instance entry of the index file.
- *  Each instance/image record within the index.dat file is
- *  a direct (binary) copy of this structure.
+ *  Each instance/image record within the index.dat file is stored
+ *  in the compact format described below. In the legacy index file
+ *  format (DBLEGACYVERSION), each record was a direct (binary) copy
+ *  of this structure, which is still needed to convert such files.
  */
 struct DCMTK_DCMQRDB_EXPORT IdxRecord
 {
@@ -422,5 +442,27 @@ private:
     /* undefined */ IdxRecord& operator=(const IdxRecord& copy);
 };
 
+/* ENSURE THAT DBVERSION IS INCREMENTED WHENEVER THE RECORD FORMAT IS MODIFIED */
+
+/* Layout of the instance records in the index.dat file. The records follow
+ * the study descriptors and start at a multiple of DB_RECORDALIGN bytes from
+ * the first record. A record is identified by this multiple, i.e. the record
+ * number passed to DB_IdxRead() is no longer a consecutive number.
+ * Each record consists of a header of DB_RECORDHEADERSIZE bytes:
+ *   Uint32  size of the record in bytes (including header and padding)
+ *   Uint16  number of bytes used (including the header)
+ *   Uint8   record status (DB_RECORD_FREE or DB_RECORD_USED)
+ *   Uint8   instance reviewed status (hstat)
+ * followed by RecordedDate (double), ImageSize (Uint32) and the values of
+ * filename, SOPClassUID, param[0..NBPARAMETERS-1] and InstanceDescription,
+ * each terminated by a NUL byte. Numbers are stored in the byte order of
+ * the host, like the study descriptors. The size of a record never changes,
+ * a free record is re-used for a new record that fits into it.
+ */
+#define DB_RECORDALIGN          8
+#define DB_RECORDHEADERSIZE     8
+#define DB_RECORD_FREE          0
+#define DB_RECORD_USED          1
+
 
 #endif
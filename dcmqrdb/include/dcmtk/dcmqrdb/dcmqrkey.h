@@ -0,0 +1,261 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: class DcmQueryRetrieveKeyIndex
+ *
+ */
+
+#ifndef DCMQRKEY_H
+#define DCMQRKEY_H
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+#include "dcmtk/ofstd/oftypes.h"
+#include "dcmtk/ofstd/ofcond.h"
+#include "dcmtk/ofstd/ofstring.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/dcmqrdb/qrdefine.h"
+
+struct IdxRecord;
+
+/* ENSURE THAT DBKEYVERSION IS INCREMENTED WHENEVER THE KEY INDEX FILE FORMAT IS MODIFIED */
+
+#define DBKEYINDEXFILE  "index.key"
+#define DBKEYMAGIC      "QRKEYIDX"
+#define DBKEYVERSION    2
+
+/* the following constants identify the attributes for which a
+ * secondary index is maintained in the key index file.
+ * numbers must be continuous, starting with 0.
+ */
+
+#define KEYIDX_PatientID                0
+#define KEYIDX_StudyInstanceUID         1
+#define KEYIDX_SeriesInstanceUID        2
+#define KEYIDX_SOPInstanceUID           3
+#define KEYIDX_StudyDate                4
+#define KEYIDX_AccessionNumber          5
+
+#define NBKEYINDEXES                    6
+
+/// maximum number of characters of an attribute value stored in the key index
+#define KEYIDX_MAX_LENGTH               64
+
+/** this class maintains the "index.key" file that accompanies the "index.dat"
+ *  file of a storage area. For each of the attributes listed above, the file
+ *  contains a B+ tree that maps the (trimmed) attribute value to the numbers
+ *  of all index records having this value. Values are compared bytewise, and
+ *  values longer than KEYIDX_MAX_LENGTH characters are truncated, so a lookup
+ *  may return records that do not match the search value exactly. Callers
+ *  must always verify the returned records against their matching criteria.
+ *
+ *  The key index does not perform any locking on its own. All methods must
+ *  be called while holding a lock on the corresponding index file, i.e. a
+ *  shared lock for lookups and an exclusive lock for modifications.
+ *
+ *  Each modification marks the key index as "dirty" until commit() is called
+ *  after the corresponding change of the index file has been written. commit()
+ *  records the generation counter of the index file, which is incremented with
+ *  each modification of the index records. This allows isUpToDate() to detect
+ *  changes of the index file that have not been reflected in the key index,
+ *  e.g. by a crashed process. In this case the key index must not be used but
+ *  rebuilt.
+ */
+class DCMTK_DCMQRDB_EXPORT DcmQueryRetrieveKeyIndex
+{
+public:
+  /// default constructor
+  DcmQueryRetrieveKeyIndex();
+
+  /// destructor, closes the key index file
+  ~DcmQueryRetrieveKeyIndex();
+
+  /** open the given key index file, create it if it does not exist.
+   *  A file with an invalid or unsupported format is reinitialized.
+   *  @param filename path to the key index file
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition open(const char *filename);
+
+  /// close the key index file
+  void close();
+
+  /// return OFTrue if the key index file is open
+  OFBool isOpen() const { return fd_ >= 0; }
+
+  /** check whether the key index reflects the current state of the index file
+   *  @param indexGeneration current generation counter of the index file
+   *  @return OFTrue if the key index can be used for lookups, OFFalse otherwise
+   */
+  OFBool isUpToDate(Uint64 indexGeneration);
+
+  /** remove all entries from the key index. The key index remains "dirty"
+   *  until commit() is called.
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition clear();
+
+  /** add the attribute values of the given index record to the key index
+   *  @param idxRec index record
+   *  @param idx number of the index record within the index file
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition addRecord(const IdxRecord& idxRec, int idx);
+
+  /** remove the attribute values of the given index record from the key index
+   *  @param idxRec index record, as currently stored in the index file
+   *  @param idx number of the index record within the index file
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition removeRecord(const IdxRecord& idxRec, int idx);
+
+  /** mark the key index as consistent with the given state of the index file
+   *  @param indexGeneration current generation counter of the index file
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition commit(Uint64 indexGeneration);
+
+  /** find all records with the given attribute value. The record numbers are
+   *  appended to the given list in no particular order.
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param value attribute value, leading and trailing spaces are ignored
+   *  @param length length of the attribute value
+   *  @param records list the record numbers are appended to
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition findEqual(int key, const char *value, size_t length, OFVector<int>& records);
+
+  /** find all records with an attribute value that starts with the given prefix.
+   *  The record numbers are appended to the given list in no particular order.
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param prefix value prefix, leading spaces are ignored
+   *  @param length length of the prefix
+   *  @param records list the record numbers are appended to
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition findPrefix(int key, const char *prefix, size_t length, OFVector<int>& records);
+
+  /** find all records with an attribute value within the given range.
+   *  The record numbers are appended to the given list in no particular order.
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param lower lower bound (inclusive) as created by makeKey(), NULL for an open range
+   *  @param upper upper bound (inclusive) as created by makeKey(), NULL for an open range
+   *  @param records list the record numbers are appended to
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition findRange(int key, const char *lower, const char *upper, OFVector<int>& records);
+
+  /** convert an attribute value to the form stored in the key index, i.e.\ remove
+   *  leading and trailing spaces, convert dates to "YYYYMMDD" format and truncate
+   *  the result to KEYIDX_MAX_LENGTH characters.
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param value attribute value
+   *  @param length length of the attribute value
+   *  @param result key value returned in this parameter
+   *  @return OFTrue if the value can be indexed, OFFalse if the value is empty
+   *    or cannot be converted (e.g. an invalid date)
+   */
+  static OFBool makeKey(int key, const char *value, size_t length, OFString& result);
+
+private:
+
+  /// private undefined copy constructor
+  DcmQueryRetrieveKeyIndex(const DcmQueryRetrieveKeyIndex& other);
+
+  /// private undefined assignment operator
+  DcmQueryRetrieveKeyIndex& operator=(const DcmQueryRetrieveKeyIndex& other);
+
+  /// helper structures, declared and defined in the implementation file
+  struct Header;
+  struct Entry;
+  struct Node;
+
+  /** read the file header into memory and check its validity
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition readHeader();
+
+  /** write the file header
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition writeHeader();
+
+  /** read the header (unless modified by this object) and set the dirty flag
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition beginUpdate();
+
+  /** read a tree page from file
+   *  @param page page number
+   *  @param node node the page is decoded into
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition readNode(Uint32 page, Node& node);
+
+  /** write a tree page to file
+   *  @param page page number
+   *  @param node node to be encoded
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition writeNode(Uint32 page, const Node& node);
+
+  /** insert an entry into the subtree starting at the given page
+   *  @param page page number of the subtree root
+   *  @param entry entry to be inserted
+   *  @param split set to OFTrue if the page has been split
+   *  @param separator first entry of the new page after a split
+   *  @param newPage page number of the new page after a split
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition insertEntry(Uint32 page, const Entry& entry, OFBool& split, Entry& separator, Uint32& newPage);
+
+  /** insert an entry into the tree for the given attribute
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param entry entry to be inserted
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition insert(int key, const Entry& entry);
+
+  /** remove an entry from the tree for the given attribute, if present
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param entry entry to be removed
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition remove(int key, const Entry& entry);
+
+  /** append the record numbers of all entries between the given bounds
+   *  @param key attribute, one of the KEYIDX_xxx constants
+   *  @param lower lower bound (inclusive), zero padded
+   *  @param upper upper bound (inclusive), zero padded
+   *  @param records list the record numbers are appended to
+   *  @return EC_Normal upon success, an error code otherwise
+   */
+  OFCondition scan(int key, const unsigned char *lower, const unsigned char *upper, OFVector<int>& records);
+
+  /// file descriptor of the key index file, -1 if not open
+  int fd_;
+
+  /// file header, valid while the file is open
+  Header *header_;
+
+  /// OFTrue if this object has set the dirty flag and not yet committed
+  OFBool updating_;
+
+  /// path to the key index file
+  OFString filename_;
+};
+
+#endif
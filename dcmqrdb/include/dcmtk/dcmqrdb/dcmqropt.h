@@ -1,6 +1,6 @@
 /*
  *
- *  Copyright (C) 1993-2017, OFFIS e.V.
+ *  Copyright (C) 1993-2021, OFFIS e.V.
  *  All rights reserved.  See COPYRIGHT file for details.
  *
  *  This software and supporting documentation were developed by
@@ -84,6 +84,11 @@ public:
   /// maximum number of parallel associations accepted
   int               maxAssociations_;
 
+  /** maximum number of parallel sub-associations to the move destination
+   *  over which the store sub-operations of a C-MOVE request are spread
+   */
+  OFCmdUnsignedInt  maxMoveSubAssociations_;
+
   /// maximum PDU size
   OFCmdUnsignedInt  maxPDU_;
 
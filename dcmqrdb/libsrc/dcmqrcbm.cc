@@ -32,6 +32,7 @@
 #include "dcmtk/dcmqrdb/dcmqrdbs.h"
 #include "dcmtk/dcmqrdb/dcmqrdbi.h"
 #include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofthpool.h"
 
 BEGIN_EXTERN_C
 #ifdef HAVE_FCNTL_H
@@ -40,11 +41,15 @@ BEGIN_EXTERN_C
 END_EXTERN_C
 
 
-static void moveSubOpProgressCallback(void * /* callbackData */,
+static void moveSubOpProgressCallback(void *callbackData,
     T_DIMSE_StoreProgress *progress,
     T_DIMSE_C_StoreRQ * /*req*/)
 {
-  //DcmQueryRetrieveMoveContext *context = OFstatic_cast(DcmQueryRetrieveMoveContext *, callbackData);
+  /* DIMSE_storeUser() reports the end of the transmission only after the
+   * request has been sent completely
+   */
+  if (progress->state == DIMSE_StoreEnd)
+    *OFstatic_cast(OFBool *, callbackData) = OFTrue;
   // We can't use oflog for the pdu output, but we use a special logger for
   // generating this output. If it is set to level "INFO" we generate the
   // output, if it's set to "DEBUG" then we'll assume that there is debug output
@@ -68,6 +73,107 @@ static void moveSubOpProgressCallback(void * /* callbackData */,
   }
 }
 
+/** a store sub-operation, i.e.\ an instance to be sent to the move destination
+ */
+struct DcmQueryRetrieveMoveContext::SubOperation
+{
+    /// SOP class UID of the instance
+    DIC_UI sopClass;
+
+    /// SOP instance UID of the instance
+    DIC_UI sopInstance;
+
+    /// name of the file that contains the instance
+    char fileName[MAXPATHLEN + 1];
+
+    /// result of the sub-operation
+    SubOperationResult result;
+
+    /// true if the sub-operation has already been repeated after a failed sub-association
+    OFBool retried;
+
+    /// true if the C-STORE request of the last attempt has been sent completely
+    OFBool requestSent;
+};
+
+/** helper class that performs a number of store sub-operations in parallel.
+ *  Each thread of the thread pool uses the sub-association with the same index.
+ */
+class DcmQueryRetrieveMoveContext::SubOperationTask : public OFThreadPool::Task
+{
+public:
+
+    /** constructor
+     *  @param context move context that owns the sub-associations
+     *  @param subOps sub-operations to be performed
+     */
+    SubOperationTask(DcmQueryRetrieveMoveContext& context, OFVector<SubOperation *>& subOps)
+    : context_(context)
+    , subOps_(subOps)
+    , assocFailed_(new OFBool[context.subAssocs.size()])
+    {
+        for (size_t i = 0; i < context_.subAssocs.size(); ++i)
+            assocFailed_[i] = OFFalse;
+    }
+
+    /// destructor
+    virtual ~SubOperationTask()
+    {
+        delete[] assocFailed_;
+    }
+
+    /** check whether a sub-association failed while performing the sub-operations
+     *  @param index index of the sub-association
+     *  @return OFTrue if the sub-association is no longer usable, OFFalse otherwise
+     */
+    OFBool associationFailed(const size_t index) const
+    {
+        return assocFailed_[index];
+    }
+
+    /** perform a single sub-operation on the sub-association of the calling thread
+     *  @param index index of the sub-operation
+     *  @param thread index of the calling thread and its sub-association
+     *  @return always OFTrue, failed sub-operations are reported in their result
+     */
+    virtual OFBool execute(const size_t index, const size_t thread)
+    {
+        /* once the sub-association of this thread has failed, the remaining
+         * sub-operations are left pending for the other sub-associations
+         */
+        if (!assocFailed_[thread]) {
+            SubOperation& subOp = *subOps_[index];
+            context_.performMoveSubOp(context_.subAssocs[thread], subOp);
+            if ((subOp.result == SOR_AssociationFailed) || (subOp.result == SOR_Unknown)) {
+                assocFailed_[thread] = OFTrue;
+            }
+        }
+        return OFTrue;
+    }
+
+private:
+
+    /// private undefined copy constructor
+    SubOperationTask(const SubOperationTask& other);
+
+    /// private undefined assignment operator
+    SubOperationTask& operator=(const SubOperationTask& other);
+
+    /// move context that owns the sub-associations
+    DcmQueryRetrieveMoveContext& context_;
+
+    /// sub-operations to be performed
+    OFVector<SubOperation *>& subOps_;
+
+    /// flag for each sub-association indicating whether it failed
+    OFBool *assocFailed_;
+};
+
+DcmQueryRetrieveMoveContext::~DcmQueryRetrieveMoveContext()
+{
+    delete subOpPool;
+}
+
 void DcmQueryRetrieveMoveContext::callbackHandler(
     /* in */
     OFBool cancelled, T_DIMSE_C_MoveRQ *request,
@@ -110,7 +216,7 @@ void DcmQueryRetrieveMoveContext::callbackHandler(
     }
 
     if (dbStatus.status() == STATUS_Pending) {
-        moveNextImage(&dbStatus);
+        moveNextImages(&dbStatus);
     }
 
     if (dbStatus.status() != STATUS_Pending) {
@@ -188,7 +294,7 @@ void DcmQueryRetrieveMoveContext::addFailedUIDInstance(const char *sopInstance)
     }
 }
 
-OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_UI sopInstance, char *fname)
+void DcmQueryRetrieveMoveContext::performMoveSubOp(T_ASC_Association *assoc, SubOperation& subOp)
 {
     OFCondition cond = EC_Normal;
     T_DIMSE_C_StoreRQ req;
@@ -196,6 +302,18 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
     DIC_US msgId;
     T_ASC_PresentationContextID presId;
     DcmDataset *stDetail = NULL;
+    const char *sopClass = subOp.sopClass;
+    const char *fname = subOp.fileName;
+
+    /* which presentation context should be used */
+    presId = ASC_findAcceptedPresentationContextID(assoc,
+        sopClass);
+    if (presId == 0) {
+        subOp.result = SOR_Failed;
+        DCMQRDB_ERROR("Move SCP: storeSCU: [file: " << fname << "] No presentation context for: ("
+            << dcmSOPClassUIDToModality(sopClass, "OT") << ") " << sopClass);
+        return;
+    }
 
 #ifdef LOCK_IMAGE_FILES
     /* shared lock image file */
@@ -209,29 +327,17 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
         /* due to quota system the file could have been deleted */
         DCMQRDB_ERROR("Move SCP: storeSCU: [file: " << fname << "]: "
             << OFStandard::getLastSystemErrorCode().message());
-        nFailed++;
-        addFailedUIDInstance(sopInstance);
-        return EC_Normal;
+        subOp.result = SOR_Failed;
+        return;
     }
     dcmtk_flock(lockfd, LOCK_SH);
 #endif
 
-    msgId = subAssoc->nextMsgID++;
-
-    /* which presentation context should be used */
-    presId = ASC_findAcceptedPresentationContextID(subAssoc,
-        sopClass);
-    if (presId == 0) {
-        nFailed++;
-        addFailedUIDInstance(sopInstance);
-        DCMQRDB_ERROR("Move SCP: storeSCU: [file: " << fname << "] No presentation context for: ("
-            << dcmSOPClassUIDToModality(sopClass, "OT") << ") " << sopClass);
-        return DIMSE_NOVALIDPRESENTATIONCONTEXTID;
-    }
+    msgId = assoc->nextMsgID++;
 
     req.MessageID = msgId;
     OFStandard::strlcpy(req.AffectedSOPClassUID, sopClass, DIC_UI_LEN + 1); // see declaration of DIC_UI in dcmtk/dcmnet/dicom.h
-    OFStandard::strlcpy(req.AffectedSOPInstanceUID, sopInstance, DIC_UI_LEN + 1);
+    OFStandard::strlcpy(req.AffectedSOPInstanceUID, subOp.sopInstance, DIC_UI_LEN + 1);
     req.DataSetType = DIMSE_DATASET_PRESENT;
     req.Priority = priority;
     req.opts = (O_STORE_MOVEORIGINATORAETITLE | O_STORE_MOVEORIGINATORID);
@@ -241,8 +347,9 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
     DCMQRDB_INFO("Store SCU RQ: MsgID " << msgId << ", ("
         << dcmSOPClassUIDToModality(sopClass, "OT") << ")");
 
-    cond = DIMSE_storeUser(subAssoc, presId, &req,
-        fname, NULL, moveSubOpProgressCallback, this,
+    subOp.requestSent = OFFalse;
+    cond = DIMSE_storeUser(assoc, presId, &req,
+        fname, NULL, moveSubOpProgressCallback, &subOp.requestSent,
         options_.blockMode_, options_.dimse_timeout_,
         &rsp, &stDetail);
 
@@ -257,40 +364,82 @@ OFCondition DcmQueryRetrieveMoveContext::performMoveSubOp(DIC_UI sopClass, DIC_U
             << DU_cstoreStatusString(rsp.DimseStatus) << "]");
         if (rsp.DimseStatus == STATUS_Success) {
             /* everything ok */
-            nCompleted++;
+            subOp.result = SOR_Completed;
         } else if (DICOM_WARNING_STATUS(rsp.DimseStatus)) {
             /* a warning status message */
-            nWarning++;
+            subOp.result = SOR_Warning;
             DCMQRDB_ERROR("Move SCP: Store Warning: Response Status: " <<
                     DU_cstoreStatusString(rsp.DimseStatus));
         } else {
-            nFailed++;
-            addFailedUIDInstance(sopInstance);
+            subOp.result = SOR_Failed;
             /* print a status message */
             DCMQRDB_ERROR("Move SCP: Store Failed: Response Status: " <<
                 DU_cstoreStatusString(rsp.DimseStatus));
         }
     } else {
-        nFailed++;
-        addFailedUIDInstance(sopInstance);
+        /* there is no response, so the sub-association is in an undefined state
+         * and cannot be used anymore. If the request has been sent completely,
+         * the move destination might have stored the instance anyway.
+         */
         OFString temp_str;
-        DCMQRDB_ERROR("Move SCP: storeSCU: Store Request Failed: " << DimseCondition::dump(temp_str, cond));
+        if (subOp.requestSent) {
+            subOp.result = SOR_Unknown;
+            DCMQRDB_ERROR("Move SCP: storeSCU: No Response to Store Request, outcome unknown: "
+                << DimseCondition::dump(temp_str, cond));
+        } else {
+            subOp.result = SOR_AssociationFailed;
+            DCMQRDB_ERROR("Move SCP: storeSCU: Store Request Failed: " << DimseCondition::dump(temp_str, cond));
+        }
     }
     if (stDetail != NULL) {
         DCMQRDB_INFO("  Status Detail:" << OFendl << DcmObject::PrintHelper(*stDetail));
         delete stDetail;
     }
-    return cond;
+}
+
+void DcmQueryRetrieveMoveContext::performMoveSubOps(OFVector<SubOperation>& subOps)
+{
+    OFVector<SubOperation *> pendingSubOps;
+    OFVector<SubOperation>::iterator it;
+
+    for (it = subOps.begin(); it != subOps.end(); ++it) {
+        if (it->result == SOR_Pending) pendingSubOps.push_back(&(*it));
+    }
+    if (pendingSubOps.empty() || subAssocs.empty()) return;
+
+    /* each thread of the pool uses its own sub-association, so the pool is only
+     * replaced if the number of sub-associations has decreased in the meantime
+     */
+    if ((subOpPool != NULL) && (subOpPool->getNumberOfThreads() != subAssocs.size())) {
+        delete subOpPool;
+        subOpPool = NULL;
+    }
+    if (subOpPool == NULL) {
+        subOpPool = new OFThreadPool(subAssocs.size());
+    }
+    SubOperationTask task(*this, pendingSubOps);
+    subOpPool->run(task, pendingSubOps.size());
+
+    /* replace the sub-associations that failed by new ones, drop them if this is not possible */
+    OFVector<T_ASC_Association *> usableAssocs;
+    for (size_t i = 0; i < subAssocs.size(); ++i) {
+        if (task.associationFailed(i)) {
+            abortSubAssociation(&subAssocs[i]);
+            if (requestSubAssociation(&subAssocs[i]).bad()) {
+                DCMQRDB_WARN("moveSCP: Cannot replace failed Sub-Association, continuing with fewer Sub-Associations");
+                continue;
+            }
+        }
+        usableAssocs.push_back(subAssocs[i]);
+    }
+    subAssocs = usableAssocs;
 }
 
 OFCondition DcmQueryRetrieveMoveContext::buildSubAssociation(T_DIMSE_C_MoveRQ *request)
 {
     OFCondition cond = EC_Normal;
     DIC_NODENAME dstHostName;
-    DIC_NODENAME dstHostNamePlusPort;
     int dstPortNumber;
-    T_ASC_Parameters *params = NULL;
-    OFString temp_str;
 
     OFStandard::strlcpy(dstAETitle, request->MoveDestination, DIC_AE_LEN + 1);
 
@@ -311,32 +460,64 @@ OFCondition DcmQueryRetrieveMoveContext::buildSubAssociation(T_DIMSE_C_MoveRQ *r
         request->MoveDestination, dstHostName, DIC_NODENAME_LEN + 1, &dstPortNumber)) {
         return QR_EC_InvalidPeer;
     }
-    if (cond.good()) {
-        cond = ASC_createAssociationParameters(&params, ASC_DEFAULTMAXPDU);
-        if (cond.bad()) {
-            DCMQRDB_ERROR("moveSCP: Cannot create Association-params for sub-ops: " << DimseCondition::dump(temp_str, cond));
+    OFStandard::snprintf(dstHostNamePlusPort, sizeof(DIC_NODENAME), "%s:%d", dstHostName, dstPortNumber);
+
+#ifdef WITH_THREADS
+    const size_t numAssocs = (options_.maxMoveSubAssociations_ > 1) ? OFstatic_cast(size_t, options_.maxMoveSubAssociations_) : 1;
+#else
+    /* without thread support, the sub-operations cannot be performed in parallel */
+    const size_t numAssocs = 1;
+#endif
+    while (cond.good() && (subAssocs.size() < numAssocs)) {
+        T_ASC_Association *assoc = NULL;
+        cond = requestSubAssociation(&assoc);
+        if (cond.good()) {
+            subAssocs.push_back(assoc);
+        } else if (!subAssocs.empty()) {
+            /* the move destination might limit the number of parallel associations */
+            DCMQRDB_WARN("moveSCP: Continuing with " << subAssocs.size() << " Sub-Association(s)");
+            cond = EC_Normal;
+            break;
         }
     }
+
     if (cond.good()) {
-        OFStandard::snprintf(dstHostNamePlusPort, sizeof(DIC_NODENAME), "%s:%d", dstHostName, dstPortNumber);
-        ASC_setPresentationAddresses(params, OFStandard::getHostName().c_str(),
-            dstHostNamePlusPort);
-        ASC_setAPTitles(params, ourAETitle.c_str(), dstAETitle,NULL);
+        assocStarted = OFTrue;
+    }
+    return cond;
+}
 
-        if (options_.outgoingProfile.empty()) {
-            cond = addAllStoragePresentationContexts(params);
-        } else {
-            cond = associationConfiguration_.setAssociationParameters(options_.outgoingProfile.c_str(), *params);
-        }
-        if (cond.bad()) {
-            DCMQRDB_ERROR(DimseCondition::dump(temp_str, cond));
-        }
-        DCMQRDB_DEBUG("Request Parameters:" << OFendl << ASC_dumpParameters(temp_str, params, ASC_ASSOC_RQ));
+OFCondition DcmQueryRetrieveMoveContext::requestSubAssociation(T_ASC_Association **assoc)
+{
+    OFCondition cond = EC_Normal;
+    T_ASC_Parameters *params = NULL;
+    OFString temp_str;
+
+    *assoc = NULL;
+    cond = ASC_createAssociationParameters(&params, ASC_DEFAULTMAXPDU);
+    if (cond.bad()) {
+        DCMQRDB_ERROR("moveSCP: Cannot create Association-params for sub-ops: " << DimseCondition::dump(temp_str, cond));
+        return cond;
+    }
+
+    ASC_setPresentationAddresses(params, OFStandard::getHostName().c_str(),
+        dstHostNamePlusPort);
+    ASC_setAPTitles(params, ourAETitle.c_str(), dstAETitle,NULL);
+
+    if (options_.outgoingProfile.empty()) {
+        cond = addAllStoragePresentationContexts(params);
+    } else {
+        cond = associationConfiguration_.setAssociationParameters(options_.outgoingProfile.c_str(), *params);
+    }
+    if (cond.bad()) {
+        DCMQRDB_ERROR(DimseCondition::dump(temp_str, cond));
     }
+    DCMQRDB_DEBUG("Request Parameters:" << OFendl << ASC_dumpParameters(temp_str, params, ASC_ASSOC_RQ));
+
     if (cond.good()) {
         /* create association */
         DCMQRDB_INFO("Requesting Sub-Association");
-        cond = ASC_requestAssociation(options_.net_, params, &subAssoc);
+        cond = ASC_requestAssociation(options_.net_, params, assoc);
         if (cond.bad()) {
             if (cond == DUL_ASSOCIATIONREJECTED) {
                 T_ASC_RejectParameters rej;
@@ -349,33 +530,62 @@ OFCondition DcmQueryRetrieveMoveContext::buildSubAssociation(T_DIMSE_C_MoveRQ *r
         }
     }
 
-    if (cond.good()) {
-        assocStarted = OFTrue;
+    if (cond.bad()) {
+        /* the association (if any) owns the parameters */
+        if (*assoc != NULL) {
+            ASC_dropAssociation(*assoc);
+            ASC_destroyAssociation(assoc);
+        } else {
+            ASC_destroyAssociationParameters(&params);
+        }
     }
     return cond;
 }
 
+void DcmQueryRetrieveMoveContext::abortSubAssociation(T_ASC_Association **assoc)
+{
+    OFCondition cond = EC_Normal;
+    OFString temp_str;
+
+    DCMQRDB_INFO("Aborting Sub-Association");
+    cond = ASC_abortAssociation(*assoc);
+    if (cond.bad()) {
+        DCMQRDB_ERROR("moveSCP: Sub-Association Abort Failed: " << DimseCondition::dump(temp_str, cond));
+    }
+    cond = ASC_dropAssociation(*assoc);
+    if (cond.bad()) {
+        DCMQRDB_ERROR("moveSCP: Sub-Association Drop Failed: " << DimseCondition::dump(temp_str, cond));
+    }
+    cond = ASC_destroyAssociation(assoc);
+    if (cond.bad()) {
+        DCMQRDB_ERROR("moveSCP: Sub-Association Destroy Failed: " << DimseCondition::dump(temp_str, cond));
+    }
+}
+
 OFCondition DcmQueryRetrieveMoveContext::closeSubAssociation()
 {
     OFCondition cond = EC_Normal;
 
-    if (subAssoc != NULL) {
+    for (OFVector<T_ASC_Association *>::iterator it = subAssocs.begin(); it != subAssocs.end(); ++it) {
         /* release association */
         OFString temp_str;
         DCMQRDB_INFO("Releasing Sub-Association");
-        cond = ASC_releaseAssociation(subAssoc);
+        cond = ASC_releaseAssociation(*it);
         if (cond.bad()) {
             DCMQRDB_ERROR("moveSCP: Sub-Association Release Failed: " << DimseCondition::dump(temp_str, cond));
         }
-        cond = ASC_dropAssociation(subAssoc);
+        cond = ASC_dropAssociation(*it);
         if (cond.bad()) {
             DCMQRDB_ERROR("moveSCP: Sub-Association Drop Failed: " << DimseCondition::dump(temp_str, cond));
         }
-        cond = ASC_destroyAssociation(&subAssoc);
+        cond = ASC_destroyAssociation(&(*it));
         if (cond.bad()) {
             DCMQRDB_ERROR("moveSCP: Sub-Association Destroy Failed: " << DimseCondition::dump(temp_str, cond));
         }
     }
+    subAssocs.clear();
+    delete subOpPool;
+    subOpPool = NULL;
 
     if (assocStarted) {
         assocStarted = OFFalse;
@@ -384,36 +594,79 @@ OFCondition DcmQueryRetrieveMoveContext::closeSubAssociation()
     return cond;
 }
 
-void DcmQueryRetrieveMoveContext::moveNextImage(DcmQueryRetrieveDatabaseStatus * dbStatus)
+void DcmQueryRetrieveMoveContext::moveNextImages(DcmQueryRetrieveDatabaseStatus * dbStatus)
 {
-    OFCondition cond = EC_Normal;
     OFCondition dbcond = EC_Normal;
-    DIC_UI subImgSOPClass;      /* sub-operation image SOP Class */
-    DIC_UI subImgSOPInstance;   /* sub-operation image SOP Instance */
-    char subImgFileName[MAXPATHLEN + 1];    /* sub-operation image file */
-
-    /* clear out strings */
-    memset(subImgFileName, 0, sizeof(subImgFileName));
-    memset(subImgSOPClass, 0, sizeof(subImgSOPClass));
-    memset(subImgSOPInstance,0, sizeof(subImgSOPInstance));
+    OFVector<SubOperation> subOps;
+    OFVector<SubOperation>::iterator it;
+
+    /* get one DB response per sub-association */
+    while ((subOps.size() < subAssocs.size()) && (dbStatus->status() == STATUS_Pending)) {
+        SubOperation subOp;
+        /* clear out strings */
+        memset(&subOp, 0, sizeof(subOp));
+        subOp.result = SOR_Pending;
+        subOp.retried = OFFalse;
+        subOp.requestSent = OFFalse;
+        dbcond = dbHandle.nextMoveResponse(
+            subOp.sopClass, sizeof(subOp.sopClass), subOp.sopInstance, sizeof(subOp.sopInstance),
+            subOp.fileName, sizeof(subOp.fileName), &nRemaining, dbStatus);
+        if (dbcond.bad()) {
+            DCMQRDB_ERROR("moveSCP: Database: nextMoveResponse Failed ("
+                    << DU_cmoveStatusString(dbStatus->status()) << "):");
+        }
+        if (dbStatus->status() == STATUS_Pending) {
+            subOps.push_back(subOp);
+        }
+    }
 
-    /* get DB response */
-    dbcond = dbHandle.nextMoveResponse(
-        subImgSOPClass, sizeof(subImgSOPClass), subImgSOPInstance, sizeof(subImgSOPInstance), subImgFileName, sizeof(subImgFileName), &nRemaining, dbStatus);
-    if (dbcond.bad()) {
-        DCMQRDB_ERROR("moveSCP: Database: nextMoveResponse Failed ("
-                << DU_cmoveStatusString(dbStatus->status()) << "):");
+    /* perform sub-ops, repeat those that failed due to a broken sub-association once */
+    OFBool repeat = !subOps.empty();
+    while (repeat) {
+        performMoveSubOps(subOps);
+        repeat = OFFalse;
+        for (it = subOps.begin(); it != subOps.end(); ++it) {
+            if (it->result == SOR_AssociationFailed) {
+                if (!it->retried && !subAssocs.empty()) {
+                    DCMQRDB_INFO("moveSCP: Repeating Move Sub-Op for: " << it->sopInstance);
+                    it->result = SOR_Pending;
+                    it->retried = OFTrue;
+                    repeat = OFTrue;
+                } else {
+                    it->result = SOR_Failed;
+                }
+            } else if (it->result == SOR_Unknown) {
+                /* never repeat a request that the move destination might have processed */
+                DCMQRDB_WARN("moveSCP: Not repeating Move Sub-Op with unknown outcome for: " << it->sopInstance);
+                it->result = SOR_Failed;
+            } else if (it->result == SOR_Pending) {
+                /* not performed since its sub-association failed in the meantime */
+                repeat = !subAssocs.empty();
+            }
+        }
     }
 
-    if (dbStatus->status() == STATUS_Pending) {
-        /* perform sub-op */
-        cond = performMoveSubOp(subImgSOPClass, subImgSOPInstance, subImgFileName);
-        if (cond != EC_Normal) {
-            OFString temp_str;
-            DCMQRDB_ERROR("moveSCP: Move Sub-Op Failed: " << DimseCondition::dump(temp_str, cond));
-            /* clear condition stack */
+    /* update the counters reported in the move responses */
+    for (it = subOps.begin(); it != subOps.end(); ++it) {
+        switch (it->result) {
+            case SOR_Completed:
+                nCompleted++;
+                break;
+            case SOR_Warning:
+                nWarning++;
+                break;
+            default:
+                nFailed++;
+                addFailedUIDInstance(it->sopInstance);
+                break;
         }
     }
+
+    if (subAssocs.empty() && (dbStatus->status() == STATUS_Pending)) {
+        /* no sub-association left, must fail the remaining sub-operations */
+        DCMQRDB_ERROR("moveSCP: No Sub-Association left, failing remaining Move Sub-Ops");
+        failAllSubOperations(dbStatus);
+    }
 }
 
 void DcmQueryRetrieveMoveContext::failAllSubOperations(DcmQueryRetrieveDatabaseStatus * dbStatus)
@@ -32,6 +32,12 @@ BEGIN_EXTERN_C
 #ifdef HAVE_SYS_PARAM_H
 #include <sys/param.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_IO_H
+#include <io.h>
+#endif
 END_EXTERN_C
 
 #include "dcmtk/ofstd/ofstd.h"
@@ -42,6 +48,7 @@ END_EXTERN_C
 #include "dcmtk/dcmqrdb/dcmqropt.h"
 #include "dcmtk/ofstd/ofstdinc.h"
 #include "dcmtk/dcmqrdb/dcmqridx.h"
+#include "dcmtk/dcmqrdb/dcmqrkey.h"
 #include "dcmtk/dcmnet/diutil.h"
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmdata/dcmatch.h"
@@ -416,29 +423,284 @@ static long DB_lseek(int fildes, long offset, int whence)
 }
 
 /******************************
- *      Read an Index record
+ *      Determine the size of the index file
  */
 
-OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxRead (int idx, IdxRecord *idxRec)
+static OFBool DB_GetIndexFileSize(DB_Private_Handle *phandle, Uint64& size)
 {
+    struct stat st;
+    if (fstat(phandle -> pidx, &st) < 0)
+        return OFFalse;
+    size = OFstatic_cast(Uint64, st.st_size);
+    return OFTrue;
+}
 
-    /*** Goto the right index in file
-    **/
+/******************************
+ *      Layout of the record area, see dcmqridx.h
+ */
 
-    DB_lseek (handle_ -> pidx, OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC + idx * SIZEOF_IDXRECORD), SEEK_SET) ;
+/* file offset of the first index record */
+#define DB_RECORDAREA           OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC)
 
-    /*** Read the record
-    **/
+/* offsets of the status fields within the record header */
+#define DB_RECORDSTATUSOFFSET   6
+#define DB_RECORDHSTATOFFSET    7
 
-    if (read (handle_ -> pidx, (char *) idxRec, SIZEOF_IDXRECORD) != SIZEOF_IDXRECORD)
-        return (QR_EC_IndexDatabaseError) ;
+/* minimum size of a record: header, RecordedDate and ImageSize */
+#define DB_MINRECORDSIZE        (DB_RECORDHEADERSIZE + sizeof (double) + sizeof (Uint32))
 
-    DB_lseek (handle_ -> pidx, OFstatic_cast(long, DBHEADERSIZE), SEEK_SET) ;
+/* upper limit for the size of an encoded record */
+#define DB_MAXRECORDSIZE        ((DB_RECORDHEADERSIZE + SIZEOF_IDXRECORD + DB_RECORDALIGN - 1) / DB_RECORDALIGN * DB_RECORDALIGN)
 
-    /*** Initialize record links
-    **/
+/* size of the buffer used to read ahead while scanning the index file */
+#define DB_READBUFFERSIZE       65536
+
+struct DB_RecordHeader
+{
+    Uint32 size ;
+    Uint16 length ;
+    Uint8  status ;
+    Uint8  hstat ;
+};
+
+static long DB_RecordOffset (int idx)
+{
+    return DB_RECORDAREA + OFstatic_cast(long, idx) * DB_RECORDALIGN ;
+}
+
+static void DB_GetRecordHeader (const char *data, DB_RecordHeader& header)
+{
+    memcpy (&header. size, data, sizeof (header. size)) ;
+    memcpy (&header. length, data + 4, sizeof (header. length)) ;
+    header. status = OFstatic_cast(Uint8, data [DB_RECORDSTATUSOFFSET]) ;
+    header. hstat = OFstatic_cast(Uint8, data [DB_RECORDHSTATOFFSET]) ;
+}
+
+static void DB_PutRecordHeader (char *data, const DB_RecordHeader& header)
+{
+    memcpy (data, &header. size, sizeof (header. size)) ;
+    memcpy (data + 4, &header. length, sizeof (header. length)) ;
+    data [DB_RECORDSTATUSOFFSET] = OFstatic_cast(char, header. status) ;
+    data [DB_RECORDHSTATOFFSET] = OFstatic_cast(char, header. hstat) ;
+}
+
+static OFBool DB_RecordHeaderValid (const DB_RecordHeader& header)
+{
+    return (header. size % DB_RECORDALIGN == 0) &&
+           (header. size <= DB_MAXRECORDSIZE) &&
+           (header. length >= DB_MINRECORDSIZE) &&
+           (header. length <= header. size) &&
+           (header. status <= DB_RECORD_USED) ;
+}
+
+/******************************
+ *      Encode and decode an Index record
+ */
+
+static char *DB_EncodeString (char *p, const char *value, size_t maxLength)
+{
+    size_t length = 0 ;
+    if (value != NULL) {
+        while ((length < maxLength) && (value [length] != '\0'))
+            length++ ;
+        memcpy (p, value, length) ;
+    }
+    p [length] = '\0' ;
+    return p + length + 1 ;
+}
 
+static const char *DB_DecodeString (const char *p, const char *end, char *value, size_t maxLength)
+{
+    if (p == NULL)
+        return NULL ;
+    const char *q = OFstatic_cast(const char *, memchr (p, '\0', OFstatic_cast(size_t, end - p))) ;
+    if (q == NULL)
+        return NULL ;
+    size_t length = OFstatic_cast(size_t, q - p) ;
+    if (length > maxLength)
+        length = maxLength ;
+    memcpy (value, p, length) ;
+    value [length] = '\0' ;
+    return q + 1 ;
+}
+
+/* Encode an Index record into buffer, which must provide DB_MAXRECORDSIZE
+ * bytes, and return the size of the encoded record including padding.
+ */
+static Uint32 DB_IdxEncode (IdxRecord *idxRec, Uint8 status, char *buffer)
+{
+    IdxRecord limits ;
+    DB_IdxInitRecord (&limits, 0) ;
     DB_IdxInitRecord (idxRec, 1) ;
+
+    char *p = buffer + DB_RECORDHEADERSIZE ;
+    memcpy (p, &idxRec -> RecordedDate, sizeof (idxRec -> RecordedDate)) ;
+    p += sizeof (idxRec -> RecordedDate) ;
+    memcpy (p, &idxRec -> ImageSize, sizeof (idxRec -> ImageSize)) ;
+    p += sizeof (idxRec -> ImageSize) ;
+    p = DB_EncodeString (p, idxRec -> filename, DBC_MAXSTRING) ;
+    p = DB_EncodeString (p, idxRec -> SOPClassUID, UI_MAX_LENGTH) ;
+    for (int i = 0 ; i < NBPARAMETERS ; i++)
+        p = DB_EncodeString (p, idxRec -> param [i]. PValueField, OFstatic_cast(size_t, limits. param [i]. ValueLength)) ;
+    p = DB_EncodeString (p, idxRec -> InstanceDescription, DESCRIPTION_MAX_LENGTH) ;
+
+    DB_RecordHeader header ;
+    header. length = OFstatic_cast(Uint16, p - buffer) ;
+    header. size = (header. length + DB_RECORDALIGN - 1) / DB_RECORDALIGN * DB_RECORDALIGN ;
+    header. status = status ;
+    header. hstat = OFstatic_cast(Uint8, idxRec -> hstat) ;
+    memset (p, 0, header. size - header. length) ;
+    DB_PutRecordHeader (buffer, header) ;
+    return header. size ;
+}
+
+/* Decode an encoded Index record. A free record is decoded as an empty
+ * record, i.e. with an empty filename.
+ */
+static OFBool DB_IdxDecode (const char *data, IdxRecord *idxRec)
+{
+    DB_RecordHeader header ;
+    DB_GetRecordHeader (data, header) ;
+
+    /* set tags, links and maximum value lengths, clear all values */
+    DB_IdxInitRecord (idxRec, 0) ;
+    idxRec -> filename [0] = '\0' ;
+    idxRec -> SOPClassUID [0] = '\0' ;
+    idxRec -> InstanceDescription [0] = '\0' ;
+    idxRec -> RecordedDate = 0.0 ;
+    idxRec -> ImageSize = 0 ;
+    idxRec -> hstat = OFstatic_cast(char, header. hstat) ;
+
+    if (header. status != DB_RECORD_USED) {
+        for (int i = 0 ; i < NBPARAMETERS ; i++)
+            idxRec -> param [i]. ValueLength = 0 ;
+        return OFTrue ;
+    }
+
+    const char *p = data + DB_RECORDHEADERSIZE ;
+    const char *end = data + header. length ;
+    memcpy (&idxRec -> RecordedDate, p, sizeof (idxRec -> RecordedDate)) ;
+    p += sizeof (idxRec -> RecordedDate) ;
+    memcpy (&idxRec -> ImageSize, p, sizeof (idxRec -> ImageSize)) ;
+    p += sizeof (idxRec -> ImageSize) ;
+    p = DB_DecodeString (p, end, idxRec -> filename, DBC_MAXSTRING) ;
+    p = DB_DecodeString (p, end, idxRec -> SOPClassUID, UI_MAX_LENGTH) ;
+    for (int i = 0 ; i < NBPARAMETERS ; i++) {
+        DB_SmallDcmElmt& elem = idxRec -> param [i] ;
+        p = DB_DecodeString (p, end, elem. PValueField, OFstatic_cast(size_t, elem. ValueLength)) ;
+        elem. ValueLength = (p == NULL) ? 0 : OFstatic_cast(Uint32, strlen (elem. PValueField)) ;
+    }
+    p = DB_DecodeString (p, end, idxRec -> InstanceDescription, DESCRIPTION_MAX_LENGTH) ;
+
+    if (p == NULL) {
+        idxRec -> filename [0] = '\0' ;
+        return OFFalse ;
+    }
+    return OFTrue ;
+}
+
+/******************************
+ *      Read and write parts of the record area
+ *
+ *      Reads are served from a buffer. While the index file is scanned, a
+ *      complete buffer is read ahead, otherwise only the maximum size of a
+ *      single record. The buffer is invalidated whenever the index file is
+ *      locked, unlocked or written.
+ */
+
+static const char *DB_IdxReadData (DB_Private_Handle *phandle, long offset, long length, OFBool readAhead)
+{
+    if ((offset >= phandle -> readBufferOffset) &&
+        (offset + length <= phandle -> readBufferOffset + phandle -> readBufferLength))
+        return phandle -> readBuffer + (offset - phandle -> readBufferOffset) ;
+
+    if (phandle -> readBuffer == NULL)
+        phandle -> readBuffer = new char [DB_READBUFFERSIZE] ;
+    phandle -> readBufferOffset = offset ;
+    phandle -> readBufferLength = 0 ;
+
+    if (DB_lseek (phandle -> pidx, offset, SEEK_SET) != offset)
+        return NULL ;
+    const long bytesRead = OFstatic_cast(long, read (phandle -> pidx, phandle -> readBuffer, readAhead ? DB_READBUFFERSIZE : DB_MAXRECORDSIZE)) ;
+    if (bytesRead > 0)
+        phandle -> readBufferLength = bytesRead ;
+    return (phandle -> readBufferLength >= length) ? phandle -> readBuffer : NULL ;
+}
+
+static OFBool DB_IdxWriteData (DB_Private_Handle *phandle, long offset, const char *data, size_t length)
+{
+    phandle -> readBufferLength = 0 ;
+    return (DB_lseek (phandle -> pidx, offset, SEEK_SET) == offset) &&
+           (OFstatic_cast(size_t, write (phandle -> pidx, data, length)) == length) ;
+}
+
+/******************************
+ *      Read the generation counter from the header of the index file
+ */
+
+static OFBool DB_GetGeneration(DB_Private_Handle *phandle, Uint64& generation)
+{
+    generation = 0;
+    if (DB_lseek (phandle -> pidx, OFstatic_cast(long, DBGENERATIONOFFSET), SEEK_SET) < 0)
+        return OFFalse;
+    return read (phandle -> pidx, OFreinterpret_cast(char *, &generation), sizeof (generation)) == sizeof (generation);
+}
+
+/******************************
+ *      Increment the generation counter in the header of the index file.
+ *      Must be called (with exclusive lock) before index records are
+ *      added or removed.
+ */
+
+static OFBool DB_NextGeneration(DB_Private_Handle *phandle, Uint64& generation)
+{
+    if (! DB_GetGeneration (phandle, generation))
+        return OFFalse;
+    ++generation;
+    return DB_IdxWriteData (phandle, DBGENERATIONOFFSET, OFreinterpret_cast(const char *, &generation), sizeof (generation));
+}
+
+/******************************
+ *      Check whether the attribute index reflects the index file
+ */
+
+static OFBool DB_KeyIndexUpToDate(DB_Private_Handle *phandle)
+{
+    Uint64 generation = 0;
+    return (phandle -> keyIndex != NULL) &&
+           DB_GetGeneration(phandle, generation) &&
+           phandle -> keyIndex -> isUpToDate(generation);
+}
+
+/* Read the complete record idx. Returns NULL at the end of the index file,
+ * for an incomplete record at the end of the index file and if no valid
+ * record starts at the given position.
+ */
+static const char *DB_IdxReadRecord (DB_Private_Handle *phandle, int idx, OFBool readAhead)
+{
+    const long offset = DB_RecordOffset (idx) ;
+    const char *data = DB_IdxReadData (phandle, offset, DB_RECORDHEADERSIZE, readAhead) ;
+    if (data == NULL)
+        return NULL ;
+
+    DB_RecordHeader header ;
+    DB_GetRecordHeader (data, header) ;
+    if (! DB_RecordHeaderValid (header)) {
+        DCMQRDB_ERROR("invalid index record at offset " << offset << " in " << phandle -> indexFilename) ;
+        return NULL ;
+    }
+    return DB_IdxReadData (phandle, offset, OFstatic_cast(long, header. size), readAhead) ;
+}
+
+/******************************
+ *      Read an Index record
+ */
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxRead (int idx, IdxRecord *idxRec)
+{
+    const char *data = (idx >= 0) ? DB_IdxReadRecord (handle_, idx, OFFalse) : NULL ;
+    if ((data == NULL) || ! DB_IdxDecode (data, idxRec))
+        return (QR_EC_IndexDatabaseError) ;
     return EC_Normal ;
 }
 
@@ -446,37 +708,117 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxRead (int idx, IdxRecord
 /******************************
  *      Add an Index record
  *      Returns the index allocated for this record
+ *
+ *      The record is re-using the first free record that is large enough
+ *      or appended to the index file. It is written in two steps: first
+ *      marked as free record, then the status is changed to used. If the
+ *      process terminates or a write fails in between, the index file
+ *      never contains a partially written record that appears to be
+ *      in use. A partially appended record at the end of the file is
+ *      removed again.
  */
 
 static OFCondition DB_IdxAdd (DB_Private_Handle *phandle, int *idx, IdxRecord *idxRec)
 {
-    IdxRecord   rec ;
     OFCondition cond = EC_Normal;
-
-    /*** Find free place for the record
-    *** A place is free if filename is empty
+    DB_RecordHeader header ;
+    const char *data ;
+    char *buffer = new char [DB_MAXRECORDSIZE] ;
+    const Uint32 size = DB_IdxEncode (idxRec, DB_RECORD_FREE, buffer) ;
+
+    /*** Find free place for the record (first fit).
+    *** Free records keep their size, so that the position of all records
+    *** remains stable.
     **/
 
+    OFBool found = OFFalse ;
     *idx = 0 ;
+    while (!found && ((data = DB_IdxReadRecord (phandle, *idx, OFTrue)) != NULL)) {
+        DB_GetRecordHeader (data, header) ;
+        if ((header. status == DB_RECORD_FREE) && (header. size >= size))
+            found = OFTrue ;
+        else
+            *idx += OFstatic_cast(int, header. size / DB_RECORDALIGN) ;
+    }
 
-    DB_lseek (phandle -> pidx, OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC), SEEK_SET) ;
-    while (read (phandle -> pidx, (char *) &rec, SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD) {
-        if (rec. filename [0] == '\0')
-            break ;
-        (*idx)++ ;
+    /*** We have either found a free place or we are at the end of the
+    *** valid records. Remaining data is an incomplete record left by an
+    *** interrupted write, unless it starts with an invalid header.
+    **/
+
+    const long offset = DB_RecordOffset (*idx) ;
+    Uint64 fileSize = 0 ;
+    Uint64 generation = 0 ;
+    if (found) {
+        /* keep the size of the re-used record */
+        memcpy (buffer, &header. size, sizeof (header. size)) ;
+    }
+    else if (! DB_GetIndexFileSize (phandle, fileSize))
+        cond = QR_EC_IndexDatabaseError ;
+    else if (OFstatic_cast(Uint64, offset) < fileSize) {
+        data = DB_IdxReadData (phandle, offset, DB_RECORDHEADERSIZE, OFFalse) ;
+        if (data != NULL) {
+            DB_GetRecordHeader (data, header) ;
+            if (! DB_RecordHeaderValid (header))
+                cond = QR_EC_IndexDatabaseError ;
+        }
     }
 
-    /*** We have either found a free place or we are at the end of file. **/
+    /*** Add the record to the attribute index first.
+    *** If the record cannot be written, the attribute index remains marked
+    *** as out of date and will be rebuilt.
+    **/
 
+    OFBool keyIndex = cond.good() && DB_KeyIndexUpToDate(phandle) ;
+    if (keyIndex && phandle -> keyIndex -> addRecord(*idxRec, *idx).bad())
+        keyIndex = OFFalse ;
 
-    DB_lseek (phandle -> pidx, OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC + (*idx) * SIZEOF_IDXRECORD), SEEK_SET) ;
+    /*** Advance the generation counter, then write the record as a free
+    *** record first and mark it as used
+    **/
 
-    if (write (phandle -> pidx, (char *) idxRec, SIZEOF_IDXRECORD) != SIZEOF_IDXRECORD)
-        cond = QR_EC_IndexDatabaseError ;
+    if (cond.good())
+    {
+        if (! DB_NextGeneration (phandle, generation))
+            cond = QR_EC_IndexDatabaseError ;
+#ifdef _WIN32
+        else if (!found && (OFstatic_cast(Uint64, offset) < fileSize) && (_chsize (phandle -> pidx, offset) < 0))
+#else
+        else if (!found && (OFstatic_cast(Uint64, offset) < fileSize) && (ftruncate (phandle -> pidx, offset) < 0))
+#endif
+            cond = QR_EC_IndexDatabaseError ;
+        else if (! DB_IdxWriteData (phandle, offset, buffer, size))
+            cond = QR_EC_IndexDatabaseError ;
+        else
+        {
+            const char status = DB_RECORD_USED ;
+            if (! DB_IdxWriteData (phandle, offset + DB_RECORDSTATUSOFFSET, &status, 1))
+                cond = QR_EC_IndexDatabaseError ;
+        }
+
+        if (cond.bad())
+        {
+            DCMQRDB_ERROR("DB_IdxAdd: cannot write index record: " << OFStandard::getLastSystemErrorCode().message());
+
+            /*** Remove a partially appended record.
+            *** A re-used record remains free, since its status is not changed.
+            **/
+
+#ifdef _WIN32
+            if (!found && (_chsize (phandle -> pidx, offset) < 0))
+#else
+            if (!found && (ftruncate (phandle -> pidx, offset) < 0))
+#endif
+                DCMQRDB_ERROR("DB_IdxAdd: cannot truncate index file: " << OFStandard::getLastSystemErrorCode().message());
+        }
+    }
     else
-        cond = EC_Normal ;
+        DCMQRDB_ERROR("DB_IdxAdd: cannot determine free place in " << phandle -> indexFilename) ;
 
-    DB_lseek (phandle -> pidx, OFstatic_cast(long, DBHEADERSIZE), SEEK_SET) ;
+    delete[] buffer ;
+
+    if (keyIndex && cond.good())
+        phandle -> keyIndex -> commit(generation) ;
 
     return cond ;
 }
@@ -502,7 +844,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_StudyDescChange(StudyDescRec
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxInitLoop(int *idx)
 {
-    DB_lseek (handle_ -> pidx, OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC), SEEK_SET) ;
     *idx = -1 ;
     return EC_Normal ;
 }
@@ -514,19 +855,27 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxInitLoop(int *idx)
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxGetNext(int *idx, IdxRecord *idxRec)
 {
+    const char *data ;
+    DB_RecordHeader header ;
 
-    (*idx)++ ;
-    DB_lseek (handle_ -> pidx, OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC + OFstatic_cast(long, *idx) * SIZEOF_IDXRECORD), SEEK_SET) ;
-    while (read (handle_ -> pidx, (char *) idxRec, SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD) {
-        if (idxRec -> filename [0] != '\0') {
-            DB_IdxInitRecord (idxRec, 1) ;
+    /*** Skip the current record
+    **/
 
-            return EC_Normal ;
-        }
-        (*idx)++ ;
+    if (*idx < 0)
+        *idx = 0 ;
+    else if ((data = DB_IdxReadRecord (handle_, *idx, OFTrue)) != NULL) {
+        DB_GetRecordHeader (data, header) ;
+        *idx += OFstatic_cast(int, header. size / DB_RECORDALIGN) ;
     }
+    else
+        return QR_EC_IndexDatabaseError ;
 
-    DB_lseek (handle_ -> pidx, OFstatic_cast(long, DBHEADERSIZE), SEEK_SET) ;
+    while ((data = DB_IdxReadRecord (handle_, *idx, OFTrue)) != NULL) {
+        DB_GetRecordHeader (data, header) ;
+        if (header. status == DB_RECORD_USED)
+            return DB_IdxDecode (data, idxRec) ? EC_Normal : QR_EC_IndexDatabaseError ;
+        *idx += OFstatic_cast(int, header. size / DB_RECORDALIGN) ;
+    }
 
     return QR_EC_IndexDatabaseError ;
 }
@@ -552,24 +901,32 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_GetStudyDesc (StudyDescRecor
 
 /******************************
  *      Remove an Index record
- *      Just put a record with filename == ""
+ *      Just mark the record as free
  */
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxRemove(int idx)
 {
     IdxRecord   rec ;
     OFCondition cond = EC_Normal;
+    Uint64      generation = 0 ;
 
-    DB_lseek (handle_ -> pidx, OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC + OFstatic_cast(long, idx) * SIZEOF_IDXRECORD), SEEK_SET) ;
-    DB_IdxInitRecord (&rec, 0) ;
+    /*** Remove the record from the attribute index first
+    **/
+
+    OFBool keyIndex = DB_KeyIndexUpToDate(handle_) ;
+    if (keyIndex && ((DB_IdxRead (idx, &rec) != EC_Normal) || handle_ -> keyIndex -> removeRecord(rec, idx).bad()))
+        keyIndex = OFFalse ;
 
-    rec. filename [0] = '\0' ;
-    if (write (handle_ -> pidx, (char *) &rec, SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD)
+    const char status = DB_RECORD_FREE ;
+    if ((idx >= 0) && (DB_IdxReadRecord (handle_, idx, OFFalse) != NULL) &&
+        DB_NextGeneration (handle_, generation) &&
+        DB_IdxWriteData (handle_, DB_RecordOffset (idx) + DB_RECORDSTATUSOFFSET, &status, 1))
         cond = EC_Normal ;
     else
         cond = QR_EC_IndexDatabaseError ;
 
-    DB_lseek (handle_ -> pidx, OFstatic_cast(long, DBHEADERSIZE), SEEK_SET) ;
+    if (keyIndex && cond.good())
+        handle_ -> keyIndex -> commit(generation) ;
 
     return cond ;
 }
@@ -583,6 +940,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_lock(OFBool exclusive)
     } else {
         lockmode = LOCK_SH;     /* shared lock */
     }
+    handle_->readBufferLength = 0;
     if (dcmtk_flock(handle_->pidx, lockmode) < 0) {
         dcmtk_plockerr("DB_lock");
         return QR_EC_IndexDatabaseError;
@@ -592,6 +950,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_lock(OFBool exclusive)
 
 OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_unlock()
 {
+    handle_->readBufferLength = 0;
     if (dcmtk_flock(handle_->pidx, LOCK_UN) < 0) {
         dcmtk_plockerr("DB_unlock");
         return QR_EC_IndexDatabaseError;
@@ -1308,6 +1667,272 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::hierarchicalCompare (
     return QR_EC_IndexDatabaseError;
 }
 
+/* ========================= ATTRIBUTE INDEX ========================= */
+
+/************************
+ *      Get the attribute index for a tag, -1 if none
+ */
+
+static int DB_GetKeyIndex (const DcmTagKey& tag)
+{
+    if (tag == DCM_PatientID) return KEYIDX_PatientID ;
+    if (tag == DCM_StudyInstanceUID) return KEYIDX_StudyInstanceUID ;
+    if (tag == DCM_SeriesInstanceUID) return KEYIDX_SeriesInstanceUID ;
+    if (tag == DCM_SOPInstanceUID) return KEYIDX_SOPInstanceUID ;
+    if (tag == DCM_StudyDate) return KEYIDX_StudyDate ;
+    if (tag == DCM_AccessionNumber) return KEYIDX_AccessionNumber ;
+    return -1 ;
+}
+
+extern "C" int DB_CompareRecordNumbers(const void *ve1, const void *ve2)
+{
+    const int i1 = *OFstatic_cast(const int *, ve1) ;
+    const int i2 = *OFstatic_cast(const int *, ve2) ;
+    return (i1 < i2) ? -1 : ((i1 > i2) ? 1 : 0) ;
+}
+
+/************************
+ *      Sort a list of record numbers and remove duplicates
+ */
+
+static void DB_SortRecordNumbers (OFVector<int>& records)
+{
+    if (records.size() < 2)
+        return ;
+    qsort(&records[0], records.size(), sizeof(int), DB_CompareRecordNumbers) ;
+    size_t n = 1 ;
+    for (size_t i = 1 ; i < records.size() ; i++)
+        if (records[i] != records[n - 1])
+            records[n++] = records[i] ;
+    records.resize(n) ;
+}
+
+/************************
+ *      Look up the records that may match a query key in the attribute index.
+ *      The matching rules of DcmAttributeMatching are approximated as follows:
+ *      UID lists are looked up value by value, dates and date ranges as a
+ *      range of dates, and other values either exactly or, if they contain
+ *      wildcards, by the literal prefix before the first wildcard.
+ *      Returns OFFalse if the query key cannot be used to restrict the search.
+ */
+
+static OFBool DB_KeyIndexLookup (DcmQueryRetrieveKeyIndex& keyIndex, int key, const DB_SmallDcmElmt& elem, OFVector<int>& records)
+{
+    const char *pBegin = elem. PValueField ;
+    const char *pEnd = pBegin + elem. ValueLength ;
+    const char *p ;
+    OFStandard::trimString(pBegin, pEnd) ;
+
+    /* universal matching */
+    if (pBegin == pEnd)
+        return OFFalse ;
+
+    /* only use 7-bit ASCII values, others may be subject to character set conversion */
+    for (p = pBegin ; p != pEnd ; p++)
+        if ((OFstatic_cast(unsigned char, *p) < 0x20) || (OFstatic_cast(unsigned char, *p) > 0x7e))
+            return OFFalse ;
+
+    switch (key) {
+    case KEYIDX_StudyInstanceUID:
+    case KEYIDX_SeriesInstanceUID:
+    case KEYIDX_SOPInstanceUID:
+        /* list of UID matching */
+        while (pBegin != pEnd) {
+            for (p = pBegin ; (p != pEnd) && (*p != '\\') ; p++) ;
+            if ((p == pBegin) || ((p != pEnd) && (p + 1 == pEnd)))
+                return OFFalse ;
+            if (keyIndex. findEqual(key, pBegin, p - pBegin, records). bad())
+                return OFFalse ;
+            pBegin = (p == pEnd) ? p : p + 1 ;
+        }
+        return OFTrue ;
+
+    case KEYIDX_StudyDate:
+        {
+            /* single date or date range */
+            OFString lower, upper ;
+            for (p = pBegin ; (p != pEnd) && (*p != '-') ; p++) ;
+            if (p == pEnd) {
+                if (! DcmQueryRetrieveKeyIndex::makeKey(key, pBegin, pEnd - pBegin, lower))
+                    return OFFalse ;
+                upper = lower ;
+            } else {
+                if ((p == pBegin) && (p + 1 == pEnd))
+                    return OFFalse ;
+                if ((p != pBegin) && ! DcmQueryRetrieveKeyIndex::makeKey(key, pBegin, p - pBegin, lower))
+                    return OFFalse ;
+                if ((p + 1 != pEnd) && ! DcmQueryRetrieveKeyIndex::makeKey(key, p + 1, pEnd - p - 1, upper))
+                    return OFFalse ;
+            }
+            return keyIndex. findRange(key, lower. empty() ? NULL : lower. c_str(),
+                upper. empty() ? NULL : upper. c_str(), records). good() ;
+        }
+
+    default:
+        /* single value or wildcard matching */
+        for (p = pBegin ; (p != pEnd) && (*p != '*') && (*p != '?') ; p++) ;
+        if (p == pEnd)
+            return keyIndex. findEqual(key, pBegin, pEnd - pBegin, records). good() ;
+        if (p == pBegin)
+            return OFFalse ;
+        return keyIndex. findPrefix(key, pBegin, p - pBegin, records). good() ;
+    }
+}
+
+OFBool DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexAvailable(OFBool rebuild)
+{
+    if (handle_ -> keyIndex == NULL)
+        return OFFalse ;
+    if (DB_KeyIndexUpToDate(handle_))
+        return OFTrue ;
+    return rebuild && DB_KeyIndexRebuild(). good() ;
+}
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexRebuild()
+{
+    int         idx ;
+    IdxRecord   idxRec ;
+    OFCondition cond ;
+    Uint64      generation = 0 ;
+
+    DCMQRDB_INFO("rebuilding attribute index for " << handle_ -> indexFilename) ;
+    cond = handle_ -> keyIndex -> clear() ;
+    DB_IdxInitLoop (&idx) ;
+    while (cond. good() && (DB_IdxGetNext (&idx, &idxRec) == EC_Normal))
+        cond = handle_ -> keyIndex -> addRecord(idxRec, idx) ;
+    if (cond. good() && ! DB_GetGeneration(handle_, generation))
+        cond = QR_EC_IndexDatabaseError ;
+    if (cond. good())
+        cond = handle_ -> keyIndex -> commit(generation) ;
+    if (cond. bad())
+        DCMQRDB_WARN("cannot rebuild attribute index, searching index file sequentially") ;
+    return cond ;
+}
+
+void DcmQueryRetrieveIndexDatabaseHandle::DB_KeyIndexFind(int key, const char *value, OFBool prefixMatch, OFVector<int>& records)
+{
+    records. clear() ;
+    if ((value != NULL) && (value [0] != '\0') && DB_KeyIndexAvailable(OFFalse)) {
+        const size_t length = strlen(value) ;
+        OFCondition cond = prefixMatch ? handle_ -> keyIndex -> findPrefix(key, value, length, records)
+                                       : handle_ -> keyIndex -> findEqual(key, value, length, records) ;
+        if (cond. good()) {
+            DB_SortRecordNumbers(records) ;
+            return ;
+        }
+        records. clear() ;
+    }
+
+    /* attribute index not usable, check all records in use */
+    int idx = 0 ;
+    const char *data ;
+    DB_RecordHeader header ;
+    while ((data = DB_IdxReadRecord (handle_, idx, OFTrue)) != NULL) {
+        DB_GetRecordHeader (data, header) ;
+        if (header. status == DB_RECORD_USED)
+            records. push_back(idx) ;
+        idx += OFstatic_cast(int, header. size / DB_RECORDALIGN) ;
+    }
+}
+
+OFBool DcmQueryRetrieveIndexDatabaseHandle::DB_SelectCandidates(DB_LEVEL qLevel)
+{
+    DB_ElementList *plist ;
+    DB_LEVEL    XTagLevel = PATIENT_LEVEL ;
+    DcmTagKey   XTag ;
+    OFVector<int> records ;
+    OFBool      restricted = OFFalse ;
+    int         level ;
+
+    handle_ -> candidates. clear() ;
+    handle_ -> nextCandidate = 0 ;
+
+    if (! DB_KeyIndexAvailable(OFFalse))
+        return OFFalse ;
+
+    /*** hierarchicalCompare() fails for every record if a UID key above
+    *** the query level is missing, do not hide this by an empty candidate list
+    **/
+
+    for (level = qLevel ; level < handle_ -> queryLevel ; level++) {
+        DB_GetUIDTag ((DB_LEVEL) level, &XTag) ;
+        for (plist = handle_ -> findRequestList ; plist ; plist = plist -> next)
+            if (plist -> elem. XTag == XTag)
+                break ;
+        if (plist == NULL)
+            return OFFalse ;
+    }
+
+    for (plist = handle_ -> findRequestList ; plist ; plist = plist -> next) {
+        const int key = DB_GetKeyIndex (plist -> elem. XTag) ;
+        if (key < 0)
+            continue ;
+
+        /** Only use keys that are compared by hierarchicalCompare():
+        ** UID keys above the query level, all keys at the query level and
+        ** patient keys at study level in the Study Root Information Model
+        */
+
+        DB_GetTagLevel (plist -> elem. XTag, &XTagLevel) ;
+        if (XTagLevel < qLevel) {
+            if ((XTagLevel != PATIENT_LEVEL) || (handle_ -> queryLevel != STUDY_LEVEL) || (qLevel != STUDY_LEVEL))
+                continue ;
+        }
+        else if (XTagLevel < handle_ -> queryLevel) {
+            DB_GetUIDTag (XTagLevel, &XTag) ;
+            if (! (plist -> elem. XTag == XTag))
+                continue ;
+        }
+        else if (XTagLevel > handle_ -> queryLevel)
+            continue ;
+
+        records. clear() ;
+        if (! DB_KeyIndexLookup (*handle_ -> keyIndex, key, plist -> elem, records))
+            continue ;
+        DB_SortRecordNumbers (records) ;
+
+        if (restricted) {
+            /* intersect with the candidates of the previous keys */
+            OFVector<int>& candidates = handle_ -> candidates ;
+            size_t i = 0, j = 0, n = 0 ;
+            while ((i < candidates. size()) && (j < records. size())) {
+                if (candidates [i] < records [j])
+                    i++ ;
+                else if (records [j] < candidates [i])
+                    j++ ;
+                else {
+                    candidates [n++] = candidates [i++] ;
+                    j++ ;
+                }
+            }
+            candidates. resize(n) ;
+        }
+        else
+            handle_ -> candidates. swap(records) ;
+        restricted = OFTrue ;
+
+        if (handle_ -> candidates. empty())
+            break ;
+    }
+
+    if (restricted)
+        DCMQRDB_DEBUG("attribute index: " << handle_ -> candidates. size() << " candidate records") ;
+    return restricted ;
+}
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::DB_IdxGetNextCandidate(int *idx, IdxRecord *idxRec)
+{
+    if (! handle_ -> useCandidates)
+        return DB_IdxGetNext (idx, idxRec) ;
+
+    while (handle_ -> nextCandidate < handle_ -> candidates. size()) {
+        *idx = handle_ -> candidates [handle_ -> nextCandidate++] ;
+        if ((DB_IdxRead (*idx, idxRec) == EC_Normal) && (idxRec -> filename [0] != '\0'))
+            return EC_Normal ;
+    }
+    return QR_EC_IndexDatabaseError ;
+}
+
 /********************
 **      Start find in Database
 **/
@@ -1485,12 +2110,15 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startFindRequest(
     }
 
     /**** Goto the beginning of Index File
-    **** Then find the first matching image
+    **** Then find the first matching image.
+    **** The index file is only locked while it is searched, so that
+    **** storage processes are not blocked while the responses are sent.
     ***/
 
     DB_lock(OFFalse);
 
     DB_IdxInitLoop (&(handle_->idxCounter)) ;
+    handle_->useCandidates = DB_SelectCandidates(qLevel) ;
     MatchFound = OFFalse ;
     cond = EC_Normal ;
 
@@ -1500,7 +2128,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startFindRequest(
         /*** Exit loop if read error (or end of file)
         **/
 
-        if (DB_IdxGetNext (&(handle_->idxCounter), &idxRec) != EC_Normal)
+        if (DB_IdxGetNextCandidate (&(handle_->idxCounter), &idxRec) != EC_Normal)
             break ;
 
         /*** Exit loop if error or matching OK
@@ -1514,6 +2142,8 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startFindRequest(
             break ;
     }
 
+    DB_unlock();
+
     /**** If an error occurred in Matching function
     ****    return a failed status
     ***/
@@ -1526,9 +2156,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startFindRequest(
         DCMQRDB_DEBUG("DB_startFindRequest () : STATUS_FIND_Failed_UnableToProcess");
 #endif
         status->setStatus(STATUS_FIND_Failed_UnableToProcess);
-
-        DB_unlock();
-
         return (cond) ;
     }
 
@@ -1562,9 +2189,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startFindRequest(
         DCMQRDB_DEBUG("DB_startFindRequest () : STATUS_Success");
 #endif
         status->setStatus(STATUS_Success);
-
-        DB_unlock();
-
         return (EC_Normal) ;
     }
 
@@ -1597,9 +2221,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
 #endif
         *findResponseIdentifiers = NULL ;
         status->setStatus(STATUS_Success);
-
-        DB_unlock();
-
         return (EC_Normal) ;
     }
 
@@ -1737,9 +2358,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
             << DcmObject::PrintHelper(**findResponseIdentifiers));
 #endif
     } else {
-
-        DB_unlock();
-
         return (QR_EC_IndexDatabaseError) ;
     }
 
@@ -1755,19 +2373,24 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
     DB_FreeElementList (handle_->findResponseList) ;
     handle_->findResponseList = NULL ;
 
-    /***** ... and find the next one
+    /***** ... and find the next one.
+    ***** The index file may have been modified since the last call:
+    ***** removed records are skipped and records that have been
+    ***** re-used for other instances are matched again.
     ****/
 
     MatchFound = OFFalse ;
     cond = EC_Normal ;
 
+    DB_lock(OFFalse);
+
     CharsetConsideringMatcher dbmatch(*handle_);
     while (1) {
 
         /*** Exit loop if read error (or end of file)
         **/
 
-        if (DB_IdxGetNext (&(handle_->idxCounter), &idxRec) != EC_Normal)
+        if (DB_IdxGetNextCandidate (&(handle_->idxCounter), &idxRec) != EC_Normal)
             break ;
 
         /*** If Response already found
@@ -1788,6 +2411,8 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
 
     }
 
+    DB_unlock();
+
     /**** If an error occurred in Matching function
     ****    return status is pending
     ***/
@@ -1800,9 +2425,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextFindResponse (
         DCMQRDB_DEBUG("DB_nextFindResponse () : STATUS_FIND_Failed_UnableToProcess");
 #endif
         status->setStatus(STATUS_FIND_Failed_UnableToProcess);
-
-        DB_unlock();
-
         return (cond) ;
     }
 
@@ -1857,9 +2479,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::cancelFindRequest (DcmQueryRetr
     handle_->uidList = NULL ;
 
     status->setStatus(STATUS_FIND_Cancel_MatchingTerminatedDueToCancelRequest);
-
-    DB_unlock();
-
     return (EC_Normal) ;
 }
 
@@ -2179,12 +2798,13 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
 
     CharsetConsideringMatcher dbmatch(*handle_);
     DB_IdxInitLoop (&(handle_->idxCounter)) ;
+    handle_->useCandidates = DB_SelectCandidates(qLevel) ;
     while (1) {
 
         /*** Exit loop if read error (or end of file)
         **/
 
-        if (DB_IdxGetNext (&(handle_->idxCounter), &idxRec) != EC_Normal)
+        if (DB_IdxGetNextCandidate (&(handle_->idxCounter), &idxRec) != EC_Normal)
             break ;
 
         /*** If matching found
@@ -2195,12 +2815,14 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
         if (MatchFound) {
             pidxlist = (DB_CounterList *) malloc (sizeof( DB_CounterList ) ) ;
             if (pidxlist == NULL) {
+                DB_unlock();
                 status->setStatus(STATUS_FIND_Refused_OutOfResources);
                 return (QR_EC_IndexDatabaseError) ;
             }
 
             pidxlist->next = NULL ;
             pidxlist->idxCounter = handle_->idxCounter ;
+            OFStandard::strlcpy(pidxlist->SOPInstanceUID, idxRec.SOPInstanceUID, sizeof(pidxlist->SOPInstanceUID)) ;
             handle_->NumberRemainOperations++ ;
             if ( handle_->moveCounterList == NULL )
                 handle_->moveCounterList = lastidxlist = pidxlist ;
@@ -2211,6 +2833,12 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
         }
     }
 
+    /**** The matching records are re-read by nextMoveResponse(),
+    ****    so the index file does not remain locked in the meantime
+    ***/
+
+    DB_unlock();
+
     DB_FreeElementList (handle_->findRequestList) ;
     handle_->findRequestList = NULL ;
 
@@ -2237,9 +2865,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::startMoveRequest(
         DCMQRDB_DEBUG("DB_startMoveRequest : STATUS_Success");
 #endif
         status->setStatus(STATUS_Success);
-
-        DB_unlock();
-
         return (EC_Normal) ;
     }
 
@@ -2258,46 +2883,59 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::nextMoveResponse(
 {
     IdxRecord           idxRec ;
     DB_CounterList              *nextlist ;
+    OFCondition         cond = EC_Normal;
 
-    /**** If all matching images have been retrieved,
-    ****    status is success
-    ***/
+    while (handle_->NumberRemainOperations > 0) {
 
-    if ( handle_->NumberRemainOperations <= 0 ) {
-        status->setStatus(STATUS_Success);
+        /**** Goto the next matching image number of Index File
+        ***/
 
+        DB_lock(OFFalse);
+        cond = DB_IdxRead (handle_->moveCounterList->idxCounter, &idxRec) ;
         DB_unlock();
 
-        return (EC_Normal) ;
-    }
-
-    /**** Goto the next matching image number of Index File
-    ***/
-
-    if (DB_IdxRead (handle_->moveCounterList->idxCounter, &idxRec) != EC_Normal) {
+        if (cond != EC_Normal) {
 #ifdef DEBUG
-        DCMQRDB_DEBUG("DB_nextMoveResponse : STATUS_MOVE_Failed_UnableToProcess");
+            DCMQRDB_DEBUG("DB_nextMoveResponse : STATUS_MOVE_Failed_UnableToProcess");
 #endif
-        status->setStatus(STATUS_MOVE_Failed_UnableToProcess);
+            status->setStatus(STATUS_MOVE_Failed_UnableToProcess);
+            return (QR_EC_IndexDatabaseError) ;
+        }
 
-        DB_unlock();
+        --handle_->NumberRemainOperations ;
+        nextlist = handle_->moveCounterList->next ;
 
-        return (QR_EC_IndexDatabaseError) ;
-    }
+        /**** Skip the image if it has been removed from the database
+        ****    since the move request was started
+        ***/
 
-    OFStandard::strlcpy(SOPClassUID, (char *) idxRec. SOPClassUID, SOPClassUIDSize) ;
-    OFStandard::strlcpy(SOPInstanceUID, (char *) idxRec. SOPInstanceUID, SOPInstanceUIDSize) ;
-    OFStandard::strlcpy(imageFileName, (char *) idxRec. filename, imageFileNameSize) ;
+        if ((idxRec. filename [0] == '\0') || (strcmp (idxRec. SOPInstanceUID, handle_->moveCounterList->SOPInstanceUID) != 0)) {
+            DCMQRDB_WARN("DB_nextMoveResponse: instance no longer in database, skipping: " << handle_->moveCounterList->SOPInstanceUID);
+            free (handle_->moveCounterList) ;
+            handle_->moveCounterList = nextlist ;
+            continue ;
+        }
 
-    *numberOfRemainingSubOperations = OFstatic_cast(unsigned short, (--handle_->NumberRemainOperations));
+        OFStandard::strlcpy(SOPClassUID, (char *) idxRec. SOPClassUID, SOPClassUIDSize) ;
+        OFStandard::strlcpy(SOPInstanceUID, (char *) idxRec. SOPInstanceUID, SOPInstanceUIDSize) ;
+        OFStandard::strlcpy(imageFileName, (char *) idxRec. filename, imageFileNameSize) ;
 
-    nextlist = handle_->moveCounterList->next ;
-    free (handle_->moveCounterList) ;
-    handle_->moveCounterList = nextlist ;
-    status->setStatus(STATUS_Pending);
+        *numberOfRemainingSubOperations = OFstatic_cast(unsigned short, handle_->NumberRemainOperations);
+
+        free (handle_->moveCounterList) ;
+        handle_->moveCounterList = nextlist ;
+        status->setStatus(STATUS_Pending);
 #ifdef DEBUG
-    DCMQRDB_DEBUG("DB_nextMoveResponse : STATUS_Pending");
+        DCMQRDB_DEBUG("DB_nextMoveResponse : STATUS_Pending");
 #endif
+        return (EC_Normal) ;
+    }
+
+    /**** If all matching images have been retrieved,
+    ****    status is success
+    ***/
+
+    status->setStatus(STATUS_Success);
     return (EC_Normal) ;
 }
 
@@ -2314,9 +2952,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::cancelMoveRequest (DcmQueryRetr
     }
 
     status->setStatus(STATUS_MOVE_Cancel_SubOperationsTerminatedDueToCancelIndication);
-
-    DB_unlock();
-
     return (EC_Normal) ;
 }
 
@@ -2392,6 +3027,7 @@ int DcmQueryRetrieveIndexDatabaseHandle::deleteOldestStudy(StudyDescRecord *pStu
     size_t n ;
     int idx = 0 ;
     IdxRecord idxRec ;
+    OFVector<int> records ;
 
     oldestStudy = 0 ;
     OldestDate = 0.0 ;
@@ -2413,13 +3049,16 @@ int DcmQueryRetrieveIndexDatabaseHandle::deleteOldestStudy(StudyDescRecord *pStu
 #endif
 
     n = strlen(pStudyDesc[oldestStudy].StudyInstanceUID) ;
-    while ( DB_IdxRead (idx, &idxRec) == EC_Normal ) {
+    DB_KeyIndexFind(KEYIDX_StudyInstanceUID, pStudyDesc[oldestStudy].StudyInstanceUID, OFTrue, records) ;
+    for (OFVector<int>::const_iterator it = records.begin(); it != records.end(); ++it) {
 
+    idx = *it ;
+    if ( DB_IdxRead (idx, &idxRec) != EC_Normal )
+        continue ;
     if ( ! ( strncmp(idxRec. StudyInstanceUID, pStudyDesc[oldestStudy].StudyInstanceUID, n) ) ) {
         DB_IdxRemove (idx) ;
         deleteImageFile(idxRec.filename);
     }
-    idx++ ;
     }
 
     pStudyDesc[oldestStudy].NumberofRegistratedImages = 0 ;
@@ -2442,6 +3081,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::deleteOldestImages(StudyDescRec
     int nbimages = 0 , s = 0;
     size_t n ;
     long DeletedSize ;
+    OFVector<int> records ;
 
 #ifdef DEBUG
     DCMQRDB_DEBUG("deleteOldestImages RequiredSize = " << RequiredSize);
@@ -2457,8 +3097,11 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::deleteOldestImages(StudyDescRec
     /** Find all images having the same StudyUID
      */
 
-    DB_IdxInitLoop (&(handle_ -> idxCounter)) ;
-    while ( DB_IdxGetNext(&(handle_ -> idxCounter), &idxRec) == EC_Normal ) {
+    DB_KeyIndexFind(KEYIDX_StudyInstanceUID, StudyUID, OFTrue, records) ;
+    for (OFVector<int>::const_iterator it = records.begin(); it != records.end(); ++it) {
+    handle_ -> idxCounter = *it ;
+    if ( ( DB_IdxRead(handle_ -> idxCounter, &idxRec) != EC_Normal ) || ( idxRec. filename [0] == '\0' ) )
+        continue ;
     if ( ! ( strncmp(idxRec. StudyInstanceUID, StudyUID, n) ) ) {
 
         StudyArray[nbimages]. idxCounter = handle_ -> idxCounter ;
@@ -2620,6 +3263,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::removeDuplicateImage(
     int idx = 0;
     IdxRecord idxRec ;
     int studyIdx = 0;
+    OFVector<int> records ;
 
     studyIdx = matchStudyUIDInStudyDesc (pStudyDesc, (char*)StudyInstanceUID,
                         (int)(handle_ -> maxStudiesAllowed)) ;
@@ -2629,8 +3273,12 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::removeDuplicateImage(
     return EC_Normal;
     }
 
-    while (DB_IdxRead(idx, &idxRec) == EC_Normal) {
+    DB_KeyIndexFind(KEYIDX_SOPInstanceUID, SOPInstanceUID, OFFalse, records) ;
+    for (OFVector<int>::const_iterator it = records.begin(); it != records.end(); ++it) {
 
+    idx = *it ;
+    if (DB_IdxRead(idx, &idxRec) != EC_Normal)
+        continue ;
     if (strcmp(idxRec.SOPInstanceUID, SOPInstanceUID) == 0) {
 
 #ifdef DEBUG
@@ -2648,7 +3296,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::removeDuplicateImage(
         pStudyDesc[studyIdx].NumberofRegistratedImages--;
         pStudyDesc[studyIdx].StudySize -= idxRec.ImageSize;
     }
-    idx++;
     }
     /* the study record should be written to file later */
     return EC_Normal;
@@ -2825,10 +3472,19 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
     DCMQRDB_DEBUG("-- END Parameters to Register in DB");
 #endif
 
-    /**** Goto the end of IndexFile, and write the record
+    stat(imageFileName, &stat_buf) ;
+    idxRec. ImageSize = (int)(stat_buf. st_size) ;
+
+    /* we only have second accuracy */
+    idxRec. RecordedDate =  (double) time(NULL);
+
+    /**** Goto the end of IndexFile, and write the record.
+    **** Everything that does not depend on the index file has been
+    **** done before, in order to keep the exclusive lock short.
     ***/
 
     DB_lock(OFTrue);
+    DB_KeyIndexAvailable(OFTrue);
 
     pStudyDesc = (StudyDescRecord *)malloc (SIZEOF_STUDYDESC) ;
     if (pStudyDesc == NULL) {
@@ -2841,12 +3497,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::storeRequest (
     memset((char *)pStudyDesc, 0, SIZEOF_STUDYDESC);
     DB_GetStudyDesc(pStudyDesc) ;
 
-    stat(imageFileName, &stat_buf) ;
-    idxRec. ImageSize = (int)(stat_buf. st_size) ;
-
-    /* we only have second accuracy */
-    idxRec. RecordedDate =  (double) time(NULL);
-
     /*
      * If the image is already stored remove it from the database.
      * hewett - Nov. 1, 93
@@ -2893,6 +3543,7 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::pruneInvalidRecords()
     StudyDescRecord *pStudyDesc;
 
     DB_lock(OFTrue);
+    DB_KeyIndexAvailable(OFTrue);
 
     pStudyDesc = (StudyDescRecord *)malloc (SIZEOF_STUDYDESC) ;
     if (pStudyDesc == NULL) {
@@ -2906,7 +3557,8 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::pruneInvalidRecords()
 
     DB_GetStudyDesc(pStudyDesc) ;
 
-    while (DB_IdxRead(idx, &idxRec) == EC_Normal)
+    DB_IdxInitLoop(&idx);
+    while (DB_IdxGetNext(&idx, &idxRec) == EC_Normal)
     {
       if (access(idxRec.filename, R_OK) < 0)
       {
@@ -2934,7 +3586,6 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::pruneInvalidRecords()
         /* remove the idx record  */
         DB_IdxRemove (idx);
       }
-      idx++;
     }
 
     DB_StudyDescChange (pStudyDesc);
@@ -2983,10 +3634,12 @@ void DcmQueryRetrieveIndexDatabaseHandle::printIndexFile (char *storeArea)
         }
     }
 
+    int count = 0 ;
     handle.DB_IdxInitLoop (&j) ;
     while (1) {
         if (handle.DB_IdxGetNext(&j, &idxRec) != EC_Normal)
             break ;
+        count++ ;
 
         COUT << "*******************************************************" << OFendl;
         COUT << "RECORD NUMBER: " << j << OFendl << "  Status: ";
@@ -3007,12 +3660,154 @@ void DcmQueryRetrieveIndexDatabaseHandle::printIndexFile (char *storeArea)
         COUT << "  InstanceDescription: \"" << idxRec.InstanceDescription << "\"" << OFendl;
     }
     COUT << "*******************************************************" << OFendl
-         << "RECORDS IN THIS INDEXFILE: " << j << OFendl;
+         << "RECORDS IN THIS INDEXFILE: " << count << OFendl;
 
     handle.DB_unlock();
 
 }
 
+/************************
+ *      Convert a legacy index file
+ */
+
+OFCondition DcmQueryRetrieveIndexDatabaseHandle::convertLegacyIndexFile(const char *storeArea)
+{
+    char indexFilename[DBC_MAXSTRING+1];
+    char tempFilename[DBC_MAXSTRING+1];
+    char keyIndexFilename[DBC_MAXSTRING+1];
+    sprintf(indexFilename, "%s%c%s", storeArea, PATH_SEPARATOR, DBINDEXFILE);
+    sprintf(tempFilename, "%s%c%s.tmp", storeArea, PATH_SEPARATOR, DBINDEXFILE);
+    sprintf(keyIndexFilename, "%s%c%s", storeArea, PATH_SEPARATOR, DBKEYINDEXFILE);
+
+#ifdef O_BINARY
+    int pidx = open(indexFilename, O_RDWR | O_BINARY);
+#else
+    int pidx = open(indexFilename, O_RDWR);
+#endif
+    if (pidx < 0)
+    {
+        DCMQRDB_ERROR(indexFilename << ": " << OFStandard::getLastSystemErrorCode().message());
+        return QR_EC_IndexDatabaseError;
+    }
+    if (dcmtk_flock(pidx, LOCK_EX) < 0)
+    {
+        dcmtk_plockerr("convertLegacyIndexFile");
+        close(pidx);
+        return QR_EC_IndexDatabaseError;
+    }
+
+    /* check the version of the index file */
+    char header[DBHEADERSIZE+1] = {};
+    unsigned int version = 0;
+    if (read(pidx, header, DBIDENTSIZE) != DBIDENTSIZE ||
+        strncmp(header, DBMAGIC, strlen(DBMAGIC)) != 0 ||
+        sscanf(header + strlen(DBMAGIC), "%x", &version) != 1 ||
+        (version != DBVERSION && version != DBLEGACYVERSION))
+    {
+        DCMQRDB_ERROR(indexFilename << ": cannot convert unknown/unsupported QRDB database file format");
+        dcmtk_flock(pidx, LOCK_UN);
+        close(pidx);
+        return QR_EC_IndexDatabaseError;
+    }
+    if (version == DBVERSION)
+    {
+        DCMQRDB_INFO(indexFilename << ": index file already uses current format, nothing to convert");
+        dcmtk_flock(pidx, LOCK_UN);
+        close(pidx);
+        return EC_Normal;
+    }
+
+    /* write the converted index file to a temporary file */
+#ifdef O_BINARY
+    int pout = open(tempFilename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+#else
+    int pout = open(tempFilename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+    if (pout < 0)
+    {
+        DCMQRDB_ERROR(tempFilename << ": " << OFStandard::getLastSystemErrorCode().message());
+        dcmtk_flock(pidx, LOCK_UN);
+        close(pidx);
+        return QR_EC_IndexDatabaseError;
+    }
+
+    OFCondition result = EC_Normal;
+    IdxRecord *idxRec = new IdxRecord;
+    char *studyDesc = new char[SIZEOF_STUDYDESC];
+    char *buffer = new char[DB_MAXRECORDSIZE];
+    long records = 0;
+
+    /* the generation counter of the converted index file starts at zero */
+    memset(header, 0, sizeof(header));
+    sprintf(header, DBMAGIC "%.2X", DBVERSION);
+    if (write(pout, header, DBHEADERSIZE) != DBHEADERSIZE)
+        result = QR_EC_IndexDatabaseError;
+
+    /* an index file without study descriptors contains only the header */
+    const long bytesRead = OFstatic_cast(long, read(pidx, studyDesc, SIZEOF_STUDYDESC));
+    if (result.good() && (bytesRead > 0))
+    {
+        if (bytesRead != OFstatic_cast(long, SIZEOF_STUDYDESC))
+        {
+            DCMQRDB_ERROR(indexFilename << ": incomplete study descriptors");
+            result = QR_EC_IndexDatabaseError;
+        }
+        else if (write(pout, studyDesc, SIZEOF_STUDYDESC) != SIZEOF_STUDYDESC)
+            result = QR_EC_IndexDatabaseError;
+    }
+
+    /* copy all records in use, an incomplete record at the end is ignored */
+    while (result.good() && (read(pidx, OFreinterpret_cast(char *, idxRec), SIZEOF_IDXRECORD) == SIZEOF_IDXRECORD))
+    {
+        if (idxRec->filename[0] == '\0')
+            continue;
+        idxRec->filename[DBC_MAXSTRING] = '\0';
+        const Uint32 size = DB_IdxEncode(idxRec, DB_RECORD_USED, buffer);
+        if (OFstatic_cast(Uint32, write(pout, buffer, size)) != size)
+            result = QR_EC_IndexDatabaseError;
+        else
+            records++;
+    }
+
+    if (result.bad())
+        DCMQRDB_ERROR(tempFilename << ": cannot write converted index file: " << OFStandard::getLastSystemErrorCode().message());
+    if (close(pout) < 0)
+        result = QR_EC_IndexDatabaseError;
+
+    delete[] buffer;
+    delete[] studyDesc;
+    delete idxRec;
+
+    /* replace the legacy index file. On Windows, a file cannot be replaced
+     * while it is open, so it is closed (and unlocked) first.
+     */
+#ifdef _WIN32
+    dcmtk_flock(pidx, LOCK_UN);
+    close(pidx);
+    if (result.good() && (!OFStandard::deleteFile(indexFilename) || !OFStandard::renameFile(tempFilename, indexFilename)))
+#else
+    if (result.good() && !OFStandard::renameFile(tempFilename, indexFilename))
+#endif
+    {
+        DCMQRDB_ERROR(indexFilename << ": cannot replace index file: " << OFStandard::getLastSystemErrorCode().message());
+        result = QR_EC_IndexDatabaseError;
+    }
+    if (result.bad())
+        OFStandard::deleteFile(tempFilename);
+    else
+    {
+        /* the attribute index refers to the legacy record numbers */
+        if (OFStandard::fileExists(keyIndexFilename))
+            OFStandard::deleteFile(keyIndexFilename);
+        DCMQRDB_INFO(indexFilename << ": converted " << records << " index records to QRDB database version " << DBVERSION);
+    }
+#ifndef _WIN32
+    dcmtk_flock(pidx, LOCK_UN);
+    close(pidx);
+#endif
+    return result;
+}
+
 /************************
  *      Search in index file for SOP Class UID and SOP Instance UID. Used for the storage commitment server
  */
@@ -3032,10 +3827,12 @@ OFBool DcmQueryRetrieveIndexDatabaseHandle::findSOPInstance(const char *storeAre
 
     handle.DB_lock(OFFalse);
 
-    handle.DB_IdxInitLoop (&j) ;
-    while (1) {
-        if (handle.DB_IdxGetNext(&j, &idxRec) != EC_Normal)
-            break ;
+    OFVector<int> records;
+    handle.DB_KeyIndexFind(KEYIDX_SOPInstanceUID, sopInstanceUID.c_str(), OFFalse, records);
+    for (OFVector<int>::const_iterator it = records.begin(); it != records.end(); ++it) {
+        j = *it;
+        if ((handle.DB_IdxRead(j, &idxRec) != EC_Normal) || (idxRec.filename[0] == '\0'))
+            continue ;
         if (sopClassUID.compare(idxRec.SOPClassUID)==0 && sopInstanceUID.compare(idxRec.SOPInstanceUID)==0)
         {
             Found=OFTrue;
@@ -3151,14 +3948,17 @@ DcmQueryRetrieveIndexDatabaseHandle::DcmQueryRetrieveIndexDatabaseHandle(
                 unsigned int version = 0;
                 if
                 (
-                    read( handle_ -> pidx, header, DBHEADERSIZE ) != DBHEADERSIZE ||
+                    read( handle_ -> pidx, header, DBIDENTSIZE ) != DBIDENTSIZE   ||
                     strncmp( header, DBMAGIC, strlen(DBMAGIC) ) != 0              ||
                     sscanf( header + strlen(DBMAGIC), "%x", &version ) != 1       ||
                     version != DBVERSION
                 )
                 {
                     DB_unlock();
-                    if ( version )
+                    if ( version == DBLEGACYVERSION )
+                        DCMQRDB_ERROR(handle_->indexFilename << ": legacy QRDB database version " << version
+                            << ", use dcmqridx --convert-legacy to convert the index file");
+                    else if ( version )
                         DCMQRDB_ERROR(handle_->indexFilename << ": invalid/unsupported QRDB database version " << version);
                     else
                         DCMQRDB_ERROR(handle_->indexFilename << ": unknown/legacy QRDB database file format");
@@ -3169,8 +3969,9 @@ DcmQueryRetrieveIndexDatabaseHandle::DcmQueryRetrieveIndexDatabaseHandle(
             else
             {
                 // write magic word and version number to the buffer
-                // then write it to the file
-                char header[DBHEADERSIZE + 1];
+                // then write it to the file, the generation counter
+                // starts at zero
+                char header[DBHEADERSIZE + 1] = {};
                 sprintf( header, DBMAGIC "%.2X", DBVERSION );
                 if ( write( handle_ -> pidx, header, DBHEADERSIZE ) != DBHEADERSIZE )
                 {
@@ -3181,6 +3982,19 @@ DcmQueryRetrieveIndexDatabaseHandle::DcmQueryRetrieveIndexDatabaseHandle(
                 }
             }
 
+            /* open the attribute index and make sure that it is up to date */
+            char keyIndexFilename[DBC_MAXSTRING+1];
+            sprintf (keyIndexFilename, "%s%c%s", storageArea, PATH_SEPARATOR, DBKEYINDEXFILE);
+            handle_ -> keyIndex = new DcmQueryRetrieveKeyIndex;
+            if ( handle_ -> keyIndex -> open( keyIndexFilename ).bad() )
+            {
+                DCMQRDB_WARN(keyIndexFilename << ": cannot open attribute index, searching index file sequentially");
+                delete handle_ -> keyIndex;
+                handle_ -> keyIndex = NULL;
+            }
+            else
+                DB_KeyIndexAvailable(OFTrue);
+
             DB_unlock();
 
             handle_ -> idxCounter = -1;
@@ -3223,6 +4037,8 @@ DcmQueryRetrieveIndexDatabaseHandle::~DcmQueryRetrieveIndexDatabaseHandle()
       DB_FreeElementList (handle_ -> findResponseList);
       DB_FreeUidList (handle_ -> uidList);
 
+      delete handle_ -> keyIndex;
+      delete[] handle_ -> readBuffer;
       delete handle_;
     }
 }
@@ -3270,11 +4086,11 @@ OFCondition DcmQueryRetrieveIndexDatabaseHandle::instanceReviewed(int idx)
       result = DB_lock(OFTrue);
       if (result.bad()) return result;
 
-      record.hstat = DVIF_objectIsNotNew;
-      DB_lseek(handle_->pidx, OFstatic_cast(long, DBHEADERSIZE + SIZEOF_STUDYDESC + idx * SIZEOF_IDXRECORD), SEEK_SET);
-      if (write(handle_->pidx, OFreinterpret_cast(char *, &record), SIZEOF_IDXRECORD) != SIZEOF_IDXRECORD)
+      // only the status field in the record header is changed
+      const char hstat = DVIF_objectIsNotNew;
+      if ((DB_IdxReadRecord(handle_, idx, OFFalse) == NULL) ||
+          !DB_IdxWriteData(handle_, DB_RecordOffset(idx) + DB_RECORDHSTATOFFSET, &hstat, 1))
           result = QR_EC_IndexDatabaseError;
-      DB_lseek(handle_->pidx, OFstatic_cast(long, DBHEADERSIZE), SEEK_SET);
       DB_unlock();
     }
 
@@ -0,0 +1,678 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: class DcmQueryRetrieveKeyIndex
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+BEGIN_EXTERN_C
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_IO_H
+#define access my_access    // Workaround to make Visual C++ Compiler happy!
+#include <io.h>
+#undef access
+#endif
+END_EXTERN_C
+
+#include "dcmtk/dcmqrdb/dcmqrkey.h"
+#include "dcmtk/dcmqrdb/dcmqridx.h"
+#include "dcmtk/dcmqrdb/dcmqrcnf.h"
+#include "dcmtk/dcmqrdb/dcmqropt.h"
+#include "dcmtk/dcmdata/dcvrda.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofdate.h"
+
+
+/* ========================= file layout ========================= */
+
+/* The key index file consists of pages of KEYIDX_PAGESIZE bytes.
+ * Page 0 contains the file header, all other pages are nodes of the
+ * B+ trees. Each node starts with a small page header (leaf flag,
+ * number of entries, link) followed by the entries. In a leaf node,
+ * the link refers to the next leaf node (0 = none). In an inner node,
+ * the link refers to the child node containing all entries less than
+ * the first entry of the node, and each entry is followed by the number
+ * of the child node containing the entries greater than or equal to it.
+ * Entries are never merged when being removed, which keeps the tree
+ * valid but may leave empty leaf nodes behind until the next rebuild.
+ */
+
+#define KEYIDX_PAGESIZE     4096
+#define KEYIDX_NODEHEADER   16
+#define KEYIDX_ENTRYSIZE    (KEYIDX_MAX_LENGTH + 4)
+#define KEYIDX_LEAFMAX      ((KEYIDX_PAGESIZE - KEYIDX_NODEHEADER) / KEYIDX_ENTRYSIZE)
+#define KEYIDX_INNERMAX     ((KEYIDX_PAGESIZE - KEYIDX_NODEHEADER) / (KEYIDX_ENTRYSIZE + 4))
+#define KEYIDX_MAXDEPTH     32
+
+/* key value under which attribute values are stored that may change
+ * their leading ASCII characters during character set conversion, i.e.
+ * values containing ISO 2022 escape sequences or other control characters.
+ * Lookups on the respective attributes always include these records.
+ */
+#define KEYIDX_UNCERTAIN    "\001"
+
+/* ENSURE THAT DBKEYVERSION IS INCREMENTED WHENEVER THIS STRUCT IS MODIFIED */
+
+struct DcmQueryRetrieveKeyIndex::Header
+{
+    char   magic[8];
+    Uint32 version;
+    Uint32 pageSize;
+    Uint32 pageCount;
+    Uint32 dirty;
+    Uint32 root[NBKEYINDEXES];
+    Uint64 indexGeneration;
+};
+
+struct DcmQueryRetrieveKeyIndex::Entry
+{
+    unsigned char key[KEYIDX_MAX_LENGTH];
+    Uint32 record;
+};
+
+struct DcmQueryRetrieveKeyIndex::Node
+{
+    Node() : leaf(OFTrue), link(0), entries(), children() {}
+
+    OFBool leaf;
+    Uint32 link;
+    OFVector<Entry> entries;
+    OFVector<Uint32> children;
+};
+
+
+/* ========================= static functions ========================= */
+
+static int KEYIDX_compare(const unsigned char *key1, Uint32 record1, const unsigned char *key2, Uint32 record2)
+{
+    int result = memcmp(key1, key2, KEYIDX_MAX_LENGTH);
+    if (result == 0)
+    {
+        if (record1 < record2) result = -1;
+        else if (record1 > record2) result = 1;
+    }
+    return result;
+}
+
+static void KEYIDX_setKey(unsigned char *key, const char *value, size_t length, unsigned char padding)
+{
+    if (length > KEYIDX_MAX_LENGTH) length = KEYIDX_MAX_LENGTH;
+    memcpy(key, value, length);
+    memset(key + length, padding, KEYIDX_MAX_LENGTH - length);
+}
+
+static Uint32 KEYIDX_getUint32(const unsigned char *p)
+{
+    Uint32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void KEYIDX_putUint32(unsigned char *p, Uint32 value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+static void KEYIDX_getValues(const IdxRecord& idxRec, const char *values[NBKEYINDEXES])
+{
+    values[KEYIDX_PatientID] = idxRec.PatientID;
+    values[KEYIDX_StudyInstanceUID] = idxRec.StudyInstanceUID;
+    values[KEYIDX_SeriesInstanceUID] = idxRec.SeriesInstanceUID;
+    values[KEYIDX_SOPInstanceUID] = idxRec.SOPInstanceUID;
+    values[KEYIDX_StudyDate] = idxRec.StudyDate;
+    values[KEYIDX_AccessionNumber] = idxRec.AccessionNumber;
+}
+
+static OFBool KEYIDX_isUncertainKey(int key)
+{
+    /* attributes whose value representation is affected by the character set */
+    return (key == KEYIDX_PatientID) || (key == KEYIDX_AccessionNumber);
+}
+
+
+/* ========================= DcmQueryRetrieveKeyIndex ========================= */
+
+DcmQueryRetrieveKeyIndex::DcmQueryRetrieveKeyIndex()
+: fd_(-1)
+, header_(new Header)
+, updating_(OFFalse)
+, filename_()
+{
+    memset(header_, 0, sizeof(Header));
+}
+
+DcmQueryRetrieveKeyIndex::~DcmQueryRetrieveKeyIndex()
+{
+    close();
+    delete header_;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::open(const char *filename)
+{
+    close();
+    if (filename == NULL) return EC_IllegalParameter;
+#ifdef O_BINARY
+    fd_ = ::open(filename, O_RDWR | O_CREAT | O_BINARY, 0666);
+#else
+    fd_ = ::open(filename, O_RDWR | O_CREAT, 0666);
+#endif
+    if (fd_ < 0)
+    {
+        DCMQRDB_WARN(filename << ": " << OFStandard::getLastSystemErrorCode().message());
+        return QR_EC_IndexDatabaseError;
+    }
+    filename_ = filename;
+    if (readHeader().bad())
+    {
+        /* new or unusable file, start with an empty key index that is
+         * not up to date with any index file
+         */
+        DCMQRDB_DEBUG(filename_ << ": initializing attribute index file");
+        OFCondition cond = clear();
+        updating_ = OFFalse;
+        if (cond.bad())
+        {
+            close();
+            return cond;
+        }
+    }
+    return EC_Normal;
+}
+
+void DcmQueryRetrieveKeyIndex::close()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    updating_ = OFFalse;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::readHeader()
+{
+    if (fd_ < 0) return QR_EC_IndexDatabaseError;
+    if ((lseek(fd_, 0, SEEK_SET) != 0) ||
+        (read(fd_, (char *) header_, sizeof(Header)) != OFstatic_cast(int, sizeof(Header))) ||
+        (strncmp(header_->magic, DBKEYMAGIC, sizeof(header_->magic)) != 0) ||
+        (header_->version != DBKEYVERSION) ||
+        (header_->pageSize != KEYIDX_PAGESIZE) ||
+        (header_->pageCount == 0))
+    {
+        return QR_EC_IndexDatabaseError;
+    }
+    for (int i = 0; i < NBKEYINDEXES; i++)
+    {
+        if (header_->root[i] >= header_->pageCount)
+            return QR_EC_IndexDatabaseError;
+    }
+    return EC_Normal;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::writeHeader()
+{
+    unsigned char page[KEYIDX_PAGESIZE];
+    memset(page, 0, sizeof(page));
+    memcpy(page, header_, sizeof(Header));
+    if ((lseek(fd_, 0, SEEK_SET) != 0) ||
+        (write(fd_, (const char *) page, KEYIDX_PAGESIZE) != KEYIDX_PAGESIZE))
+    {
+        DCMQRDB_WARN(filename_ << ": " << OFStandard::getLastSystemErrorCode().message());
+        return QR_EC_IndexDatabaseError;
+    }
+    return EC_Normal;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::beginUpdate()
+{
+    if (updating_) return EC_Normal;
+    OFCondition cond = readHeader();
+    if (cond.good())
+    {
+        header_->dirty = 1;
+        cond = writeHeader();
+    }
+    if (cond.good()) updating_ = OFTrue;
+    return cond;
+}
+
+OFBool DcmQueryRetrieveKeyIndex::isUpToDate(Uint64 indexGeneration)
+{
+    if (updating_ || readHeader().bad()) return OFFalse;
+    return (header_->dirty == 0) && (header_->indexGeneration == indexGeneration);
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::clear()
+{
+    if (fd_ < 0) return QR_EC_IndexDatabaseError;
+    memset(header_, 0, sizeof(Header));
+    memcpy(header_->magic, DBKEYMAGIC, sizeof(header_->magic));
+    header_->version = DBKEYVERSION;
+    header_->pageSize = KEYIDX_PAGESIZE;
+    header_->pageCount = 1;
+    header_->dirty = 1;
+    OFCondition cond = writeHeader();
+    if (cond.good()) updating_ = OFTrue;
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::commit(Uint64 indexGeneration)
+{
+    if (!updating_)
+    {
+        OFCondition cond = readHeader();
+        if (cond.bad()) return cond;
+    }
+    header_->dirty = 0;
+    header_->indexGeneration = indexGeneration;
+    OFCondition cond = writeHeader();
+    if (cond.good()) updating_ = OFFalse;
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::readNode(Uint32 page, Node& node)
+{
+    unsigned char buf[KEYIDX_PAGESIZE];
+    if ((page == 0) || (page >= header_->pageCount) ||
+        (lseek(fd_, OFstatic_cast(off_t, page) * KEYIDX_PAGESIZE, SEEK_SET) < 0) ||
+        (read(fd_, (char *) buf, KEYIDX_PAGESIZE) != KEYIDX_PAGESIZE))
+    {
+        DCMQRDB_WARN(filename_ << ": cannot read page " << page);
+        return QR_EC_IndexDatabaseError;
+    }
+    node.leaf = (KEYIDX_getUint32(buf) != 0);
+    const Uint32 count = KEYIDX_getUint32(buf + 4);
+    node.link = KEYIDX_getUint32(buf + 8);
+    if (count > OFstatic_cast(Uint32, node.leaf ? KEYIDX_LEAFMAX : KEYIDX_INNERMAX))
+    {
+        DCMQRDB_WARN(filename_ << ": invalid page " << page);
+        return QR_EC_IndexDatabaseError;
+    }
+    node.entries.resize(count);
+    node.children.clear();
+    const unsigned char *p = buf + KEYIDX_NODEHEADER;
+    for (Uint32 i = 0; i < count; i++)
+    {
+        memcpy(node.entries[i].key, p, KEYIDX_MAX_LENGTH);
+        node.entries[i].record = KEYIDX_getUint32(p + KEYIDX_MAX_LENGTH);
+        p += KEYIDX_ENTRYSIZE;
+        if (!node.leaf)
+        {
+            node.children.push_back(KEYIDX_getUint32(p));
+            p += 4;
+        }
+    }
+    return EC_Normal;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::writeNode(Uint32 page, const Node& node)
+{
+    unsigned char buf[KEYIDX_PAGESIZE];
+    memset(buf, 0, sizeof(buf));
+    KEYIDX_putUint32(buf, node.leaf ? 1 : 0);
+    KEYIDX_putUint32(buf + 4, OFstatic_cast(Uint32, node.entries.size()));
+    KEYIDX_putUint32(buf + 8, node.link);
+    unsigned char *p = buf + KEYIDX_NODEHEADER;
+    for (size_t i = 0; i < node.entries.size(); i++)
+    {
+        memcpy(p, node.entries[i].key, KEYIDX_MAX_LENGTH);
+        KEYIDX_putUint32(p + KEYIDX_MAX_LENGTH, node.entries[i].record);
+        p += KEYIDX_ENTRYSIZE;
+        if (!node.leaf)
+        {
+            KEYIDX_putUint32(p, node.children[i]);
+            p += 4;
+        }
+    }
+    if ((lseek(fd_, OFstatic_cast(off_t, page) * KEYIDX_PAGESIZE, SEEK_SET) < 0) ||
+        (write(fd_, (const char *) buf, KEYIDX_PAGESIZE) != KEYIDX_PAGESIZE))
+    {
+        DCMQRDB_WARN(filename_ << ": " << OFStandard::getLastSystemErrorCode().message());
+        return QR_EC_IndexDatabaseError;
+    }
+    return EC_Normal;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::insertEntry(Uint32 page, const Entry& entry, OFBool& split, Entry& separator, Uint32& newPage)
+{
+    split = OFFalse;
+    Node node;
+    OFCondition cond = readNode(page, node);
+    if (cond.bad()) return cond;
+
+    /* number of entries less than or equal to the new entry */
+    size_t pos = 0;
+    int cmp = 1;
+    while (pos < node.entries.size())
+    {
+        cmp = KEYIDX_compare(node.entries[pos].key, node.entries[pos].record, entry.key, entry.record);
+        if (cmp > 0) break;
+        pos++;
+        if (cmp == 0) break;
+    }
+
+    if (node.leaf)
+    {
+        /* entry already present */
+        if (cmp == 0) return EC_Normal;
+        node.entries.insert(node.entries.begin() + pos, entry);
+        if (node.entries.size() <= KEYIDX_LEAFMAX) return writeNode(page, node);
+
+        /* split the leaf, the first entry of the new leaf becomes the separator */
+        Node right;
+        const size_t half = node.entries.size() / 2;
+        right.leaf = OFTrue;
+        right.link = node.link;
+        right.entries.insert(right.entries.end(), node.entries.begin() + half, node.entries.end());
+        node.entries.resize(half);
+        newPage = header_->pageCount++;
+        node.link = newPage;
+        separator = right.entries[0];
+        cond = writeNode(newPage, right);
+    }
+    else
+    {
+        Entry childSeparator;
+        Uint32 childPage = 0;
+        OFBool childSplit = OFFalse;
+        cond = insertEntry((pos == 0) ? node.link : node.children[pos - 1], entry, childSplit, childSeparator, childPage);
+        if (cond.bad() || !childSplit) return cond;
+        node.entries.insert(node.entries.begin() + pos, childSeparator);
+        node.children.insert(node.children.begin() + pos, childPage);
+        if (node.entries.size() <= KEYIDX_INNERMAX) return writeNode(page, node);
+
+        /* split the inner node, the middle entry moves up to the parent */
+        Node right;
+        const size_t half = node.entries.size() / 2;
+        right.leaf = OFFalse;
+        right.link = node.children[half];
+        right.entries.insert(right.entries.end(), node.entries.begin() + half + 1, node.entries.end());
+        right.children.insert(right.children.end(), node.children.begin() + half + 1, node.children.end());
+        separator = node.entries[half];
+        node.entries.resize(half);
+        node.children.resize(half);
+        newPage = header_->pageCount++;
+        cond = writeNode(newPage, right);
+    }
+
+    if (cond.good())
+    {
+        split = OFTrue;
+        cond = writeNode(page, node);
+    }
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::insert(int key, const Entry& entry)
+{
+    OFCondition cond = EC_Normal;
+    if (header_->root[key] == 0)
+    {
+        /* first entry, create a leaf node as the root of the tree */
+        Node root;
+        root.entries.push_back(entry);
+        const Uint32 page = header_->pageCount++;
+        cond = writeNode(page, root);
+        if (cond.good()) header_->root[key] = page;
+        return cond;
+    }
+
+    OFBool split = OFFalse;
+    Entry separator;
+    Uint32 newPage = 0;
+    cond = insertEntry(header_->root[key], entry, split, separator, newPage);
+    if (cond.good() && split)
+    {
+        /* the root has been split, the tree grows by one level */
+        Node root;
+        root.leaf = OFFalse;
+        root.link = header_->root[key];
+        root.entries.push_back(separator);
+        root.children.push_back(newPage);
+        const Uint32 page = header_->pageCount++;
+        cond = writeNode(page, root);
+        if (cond.good()) header_->root[key] = page;
+    }
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::remove(int key, const Entry& entry)
+{
+    Uint32 page = header_->root[key];
+    Node node;
+    for (int depth = 0; page != 0; depth++)
+    {
+        OFCondition cond = readNode(page, node);
+        if (cond.bad()) return cond;
+        if (depth >= KEYIDX_MAXDEPTH) return QR_EC_IndexDatabaseError;
+
+        if (node.leaf)
+        {
+            for (size_t i = 0; i < node.entries.size(); i++)
+            {
+                if (KEYIDX_compare(node.entries[i].key, node.entries[i].record, entry.key, entry.record) == 0)
+                {
+                    node.entries.erase(node.entries.begin() + i);
+                    return writeNode(page, node);
+                }
+            }
+            /* entry not present */
+            return EC_Normal;
+        }
+
+        /* descend into the child node that may contain the entry */
+        size_t pos = 0;
+        while ((pos < node.entries.size()) &&
+               (KEYIDX_compare(node.entries[pos].key, node.entries[pos].record, entry.key, entry.record) <= 0))
+            pos++;
+        page = (pos == 0) ? node.link : node.children[pos - 1];
+    }
+    return EC_Normal;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::scan(int key, const unsigned char *lower, const unsigned char *upper, OFVector<int>& records)
+{
+    Uint32 page = header_->root[key];
+    Node node;
+    OFCondition cond = EC_Normal;
+
+    /* descend to the leaf node that contains the lower bound */
+    for (int depth = 0; page != 0; depth++)
+    {
+        cond = readNode(page, node);
+        if (cond.bad()) return cond;
+        if (node.leaf) break;
+        if (depth >= KEYIDX_MAXDEPTH) return QR_EC_IndexDatabaseError;
+        size_t pos = 0;
+        while ((pos < node.entries.size()) && (KEYIDX_compare(node.entries[pos].key, node.entries[pos].record, lower, 0) <= 0))
+            pos++;
+        page = (pos == 0) ? node.link : node.children[pos - 1];
+    }
+
+    /* follow the chain of leaf nodes until the upper bound is exceeded */
+    for (Uint32 visited = 0; page != 0; visited++)
+    {
+        if (visited >= header_->pageCount) return QR_EC_IndexDatabaseError;
+        for (size_t i = 0; i < node.entries.size(); i++)
+        {
+            if (memcmp(node.entries[i].key, upper, KEYIDX_MAX_LENGTH) > 0) return EC_Normal;
+            if (memcmp(node.entries[i].key, lower, KEYIDX_MAX_LENGTH) >= 0)
+                records.push_back(OFstatic_cast(int, node.entries[i].record));
+        }
+        page = node.link;
+        if (page != 0)
+        {
+            cond = readNode(page, node);
+            if (cond.bad()) return cond;
+            if (!node.leaf) return QR_EC_IndexDatabaseError;
+        }
+    }
+    return EC_Normal;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::addRecord(const IdxRecord& idxRec, int idx)
+{
+    const char *values[NBKEYINDEXES];
+    KEYIDX_getValues(idxRec, values);
+
+    OFCondition cond = beginUpdate();
+    OFString value;
+    Entry entry;
+    entry.record = OFstatic_cast(Uint32, idx);
+    for (int key = 0; (key < NBKEYINDEXES) && cond.good(); key++)
+    {
+        if (makeKey(key, values[key], strlen(values[key]), value))
+        {
+            KEYIDX_setKey(entry.key, value.c_str(), value.length(), 0);
+            cond = insert(key, entry);
+        }
+    }
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::removeRecord(const IdxRecord& idxRec, int idx)
+{
+    const char *values[NBKEYINDEXES];
+    KEYIDX_getValues(idxRec, values);
+
+    OFCondition cond = beginUpdate();
+    OFString value;
+    Entry entry;
+    entry.record = OFstatic_cast(Uint32, idx);
+    for (int key = 0; (key < NBKEYINDEXES) && cond.good(); key++)
+    {
+        if (makeKey(key, values[key], strlen(values[key]), value))
+        {
+            KEYIDX_setKey(entry.key, value.c_str(), value.length(), 0);
+            cond = remove(key, entry);
+        }
+    }
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::findEqual(int key, const char *value, size_t length, OFVector<int>& records)
+{
+    if ((key < 0) || (key >= NBKEYINDEXES) || (value == NULL)) return EC_IllegalParameter;
+    if (!updating_)
+    {
+        OFCondition cond = readHeader();
+        if (cond.bad()) return cond;
+    }
+    OFString keyValue;
+    if (!makeKey(key, value, length, keyValue)) return EC_Normal;
+    unsigned char bound[KEYIDX_MAX_LENGTH];
+    KEYIDX_setKey(bound, keyValue.c_str(), keyValue.length(), 0);
+    OFCondition cond = scan(key, bound, bound, records);
+    if (cond.good() && KEYIDX_isUncertainKey(key) && (keyValue != KEYIDX_UNCERTAIN))
+    {
+        KEYIDX_setKey(bound, KEYIDX_UNCERTAIN, strlen(KEYIDX_UNCERTAIN), 0);
+        cond = scan(key, bound, bound, records);
+    }
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::findPrefix(int key, const char *prefix, size_t length, OFVector<int>& records)
+{
+    if ((key < 0) || (key >= NBKEYINDEXES) || (prefix == NULL)) return EC_IllegalParameter;
+    if (!updating_)
+    {
+        OFCondition cond = readHeader();
+        if (cond.bad()) return cond;
+    }
+    /* remove leading spaces only, trailing spaces are part of the prefix */
+    while ((length > 0) && ((*prefix == ' ') || (*prefix == '\0')))
+    {
+        ++prefix;
+        --length;
+    }
+    if (length == 0) return EC_IllegalParameter;
+    unsigned char lower[KEYIDX_MAX_LENGTH];
+    unsigned char upper[KEYIDX_MAX_LENGTH];
+    KEYIDX_setKey(lower, prefix, length, 0);
+    KEYIDX_setKey(upper, prefix, length, 0xff);
+    OFCondition cond = scan(key, lower, upper, records);
+    if (cond.good() && KEYIDX_isUncertainKey(key))
+    {
+        KEYIDX_setKey(lower, KEYIDX_UNCERTAIN, strlen(KEYIDX_UNCERTAIN), 0);
+        cond = scan(key, lower, lower, records);
+    }
+    return cond;
+}
+
+OFCondition DcmQueryRetrieveKeyIndex::findRange(int key, const char *lower, const char *upper, OFVector<int>& records)
+{
+    if ((key < 0) || (key >= NBKEYINDEXES)) return EC_IllegalParameter;
+    if (!updating_)
+    {
+        OFCondition cond = readHeader();
+        if (cond.bad()) return cond;
+    }
+    unsigned char lowerBound[KEYIDX_MAX_LENGTH];
+    unsigned char upperBound[KEYIDX_MAX_LENGTH];
+    if (lower)
+        KEYIDX_setKey(lowerBound, lower, strlen(lower), 0);
+    else
+        memset(lowerBound, 0, KEYIDX_MAX_LENGTH);
+    if (upper)
+        KEYIDX_setKey(upperBound, upper, strlen(upper), 0);
+    else
+        memset(upperBound, 0xff, KEYIDX_MAX_LENGTH);
+    return scan(key, lowerBound, upperBound, records);
+}
+
+OFBool DcmQueryRetrieveKeyIndex::makeKey(int key, const char *value, size_t length, OFString& result)
+{
+    result.clear();
+    if (value == NULL) return OFFalse;
+    const char *begin = value;
+    const char *end = value + length;
+    OFStandard::trimString(begin, end);
+    if (begin == end) return OFFalse;
+
+    if (key == KEYIDX_StudyDate)
+    {
+        /* dates are compared as OFDate values, store them in a canonical form */
+        OFDate date;
+        if (DcmDate::getOFDateFromString(begin, end - begin, date).bad())
+            return OFFalse;
+        return date.getISOFormattedDate(result, OFFalse /* showDelimiter */);
+    }
+
+    if (KEYIDX_isUncertainKey(key))
+    {
+        for (const char *p = begin; p != end; ++p)
+        {
+            if (OFstatic_cast(unsigned char, *p) < 0x20)
+            {
+                result = KEYIDX_UNCERTAIN;
+                return OFTrue;
+            }
+        }
+    }
+    result.assign(begin, OFstatic_cast(size_t, end - begin) > KEYIDX_MAX_LENGTH ? KEYIDX_MAX_LENGTH : end - begin);
+    return OFTrue;
+}
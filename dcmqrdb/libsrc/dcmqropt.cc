@@ -35,6 +35,7 @@ DcmQueryRetrieveOptions::DcmQueryRetrieveOptions()
 , ignoreStoreData_(OFFalse)
 , itempad_(0)
 , maxAssociations_(20)
+, maxMoveSubAssociations_(1)
 , maxPDU_(ASC_DEFAULTMAXPDU)
 , net_(NULL)
 , networkTransferSyntax_(EXS_Unknown)
@@ -0,0 +1,39 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: main test program
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/ofstd/oftest.h"
+
+OFTEST_REGISTER(dcmqrdb_keyindex_make_key);
+OFTEST_REGISTER(dcmqrdb_keyindex_insert_remove);
+OFTEST_REGISTER(dcmqrdb_keyindex_stale_rebuild);
+OFTEST_REGISTER(dcmqrdb_index_store_during_find);
+OFTEST_REGISTER(dcmqrdb_index_store_during_move);
+OFTEST_REGISTER(dcmqrdb_index_legacy_conversion);
+OFTEST_REGISTER(dcmqrdb_index_record_reuse);
+
+#ifdef WITH_THREADS
+OFTEST_REGISTER(dcmqrdb_index_concurrent_access);
+OFTEST_REGISTER(dcmqrdb_move_failing_destination);
+#endif // WITH_THREADS
+
+OFTEST_MAIN("dcmqrdb")
@@ -0,0 +1,444 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test concurrent access to the index file of a storage area
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/dcmqrdb/dcmqrdbi.h"
+#include "dcmtk/dcmqrdb/dcmqridx.h"
+#include "dcmtk/dcmqrdb/dcmqrdbs.h"
+#include "dcmtk/dcmqrdb/dcmqrcnf.h"
+#include "dcmtk/dcmqrdb/dcmqrkey.h"
+
+BEGIN_EXTERN_C
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#endif
+END_EXTERN_C
+
+
+/// number of storage threads used by the stress test
+#define STRESS_TEST_WRITERS 4
+
+/// number of query threads used by the stress test
+#define STRESS_TEST_READERS 4
+
+/// number of instances stored by each storage thread
+#define STRESS_TEST_INSTANCES 25
+
+
+/// a storage area that is removed again when the test is finished
+class TestStorageArea
+{
+public:
+    TestStorageArea(const char *dirName)
+      : m_dirName(dirName)
+      , m_files()
+      , m_counter(0)
+      , m_finished(OFFalse)
+      , m_mutex()
+    {
+        OFCHECK(OFStandard::createDirectory(m_dirName, "").good());
+    }
+
+    ~TestStorageArea()
+    {
+        OFString filename;
+        for (OFVector<OFString>::const_iterator it = m_files.begin(); it != m_files.end(); ++it)
+            OFStandard::deleteFile(*it);
+        OFStandard::deleteFile(OFStandard::combineDirAndFilename(filename, m_dirName, DBINDEXFILE));
+        OFStandard::deleteFile(OFStandard::combineDirAndFilename(filename, m_dirName, DBKEYINDEXFILE));
+#ifdef _WIN32
+        _rmdir(m_dirName.c_str());
+#else
+        rmdir(m_dirName.c_str());
+#endif
+    }
+
+    const char *dirName() const
+    {
+        return m_dirName.c_str();
+    }
+
+    /// mark the storage of instances as finished
+    void setFinished()
+    {
+        m_mutex.lock();
+        m_finished = OFTrue;
+        m_mutex.unlock();
+    }
+
+    /// check whether the storage of instances has finished
+    OFBool finished()
+    {
+        m_mutex.lock();
+        OFBool result = m_finished;
+        m_mutex.unlock();
+        return result;
+    }
+
+    /// create an instance in the storage area and return its SOP Instance UID
+    OFString createInstance(const char *studyUID, OFString& filename)
+    {
+        char uid[100];
+        DcmFileFormat fileformat;
+        DcmDataset *dset = fileformat.getDataset();
+        OFCHECK(dset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+        OFCHECK(dset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT)).good());
+        OFCHECK(dset->putAndInsertString(DCM_StudyInstanceUID, studyUID).good());
+        OFCHECK(dset->putAndInsertString(DCM_SeriesInstanceUID, studyUID).good());
+        OFCHECK(dset->putAndInsertString(DCM_PatientID, "CONCURRENCY").good());
+        OFCHECK(dset->putAndInsertString(DCM_PatientName, "Concurrent^Access").good());
+        OFCHECK(dset->putAndInsertString(DCM_StudyDate, "20210315").good());
+        OFCHECK(dset->putAndInsertString(DCM_Modality, "OT").good());
+        OFString sopInstanceUID = uid;
+        char name[20];
+        m_mutex.lock();
+        sprintf(name, "SC%06u.dcm", ++m_counter);
+        OFStandard::combineDirAndFilename(filename, m_dirName, name);
+        m_files.push_back(filename);
+        m_mutex.unlock();
+        OFCHECK(fileformat.saveFile(filename, EXS_LittleEndianExplicit).good());
+        return sopInstanceUID;
+    }
+
+    /// create an instance and register it in the index file using the given handle
+    OFString storeInstance(DcmQueryRetrieveIndexDatabaseHandle& handle, const char *studyUID)
+    {
+        OFString filename;
+        OFString sopInstanceUID = createInstance(studyUID, filename);
+        DcmQueryRetrieveDatabaseStatus status;
+        OFCHECK(handle.storeRequest(UID_SecondaryCaptureImageStorage, sopInstanceUID.c_str(), filename.c_str(), &status).good());
+        OFCHECK_EQUAL(status.status(), STATUS_Success);
+        return sopInstanceUID;
+    }
+
+private:
+    OFString m_dirName;
+    OFVector<OFString> m_files;
+    unsigned int m_counter;
+    OFBool m_finished;
+    OFMutex m_mutex;
+};
+
+
+// start a study root C-FIND at the given level with the given return key.
+// Image level queries are restricted to the given study, whose only series
+// has the same UID as the study.
+static OFCondition startFind(DcmQueryRetrieveIndexDatabaseHandle& handle, const char *level, const DcmTagKey& key, const char *studyUID = NULL)
+{
+    DcmDataset query;
+    OFCHECK(query.putAndInsertString(DCM_QueryRetrieveLevel, level).good());
+    if (studyUID != NULL)
+    {
+        OFCHECK(query.putAndInsertString(DCM_StudyInstanceUID, studyUID).good());
+        OFCHECK(query.putAndInsertString(DCM_SeriesInstanceUID, studyUID).good());
+    }
+    OFCHECK(query.insertEmptyElement(key).good());
+    DcmQueryRetrieveDatabaseStatus status;
+    OFCondition result = handle.startFindRequest(UID_FINDStudyRootQueryRetrieveInformationModel, &query, &status);
+    if (result.good() && (status.status() != STATUS_Pending) && (status.status() != STATUS_Success))
+        result = EC_IllegalCall;
+    return result;
+}
+
+// retrieve the next C-FIND response, return OFFalse after the last one
+static OFBool nextFind(DcmQueryRetrieveIndexDatabaseHandle& handle, const DcmTagKey& key, OFString& value)
+{
+    DcmDataset *response = NULL;
+    DcmQueryRetrieveDatabaseStatus status;
+    DcmQueryRetrieveCharacterSetOptions options;
+    OFCHECK(handle.nextFindResponse(&response, &status, options).good());
+    if (response == NULL)
+        return OFFalse;
+    OFCHECK(response->findAndGetOFString(key, value).good());
+    delete response;
+    return status.status() == STATUS_Pending;
+}
+
+// perform a complete C-FIND and return the values of the given key
+static void findAll(DcmQueryRetrieveIndexDatabaseHandle& handle, const char *level, const DcmTagKey& key, OFVector<OFString>& values, const char *studyUID = NULL)
+{
+    OFString value;
+    values.clear();
+    OFCHECK(startFind(handle, level, key, studyUID).good());
+    while (nextFind(handle, key, value))
+        values.push_back(value);
+}
+
+// check that the given list of values does not contain duplicates
+static OFBool isUnique(const OFVector<OFString>& values)
+{
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        for (size_t j = i + 1; j < values.size(); ++j)
+        {
+            if (values[i] == values[j])
+                return OFFalse;
+        }
+    }
+    return OFTrue;
+}
+
+
+OFTEST(dcmqrdb_index_store_during_find)
+{
+    TestStorageArea area("tidxconc_find.out");
+    OFCondition result;
+    DcmQueryRetrieveIndexDatabaseHandle finder(area.dirName(), -1, -1, result);
+    OFCHECK(result.good());
+    DcmQueryRetrieveIndexDatabaseHandle storer(area.dirName(), -1, -1, result);
+    OFCHECK(result.good());
+
+    area.storeInstance(storer, "1.2.276.0.7230010.3.4.1");
+    area.storeInstance(storer, "1.2.276.0.7230010.3.4.2");
+
+    // the pending C-FIND must not block the storage of further instances
+    OFString value;
+    OFVector<OFString> values;
+    OFCHECK(startFind(finder, STUDY_LEVEL_STRING, DCM_StudyInstanceUID).good());
+    OFCHECK(nextFind(finder, DCM_StudyInstanceUID, value));
+    values.push_back(value);
+    area.storeInstance(storer, "1.2.276.0.7230010.3.4.3");
+    area.storeInstance(storer, "1.2.276.0.7230010.3.4.1");
+    while (nextFind(finder, DCM_StudyInstanceUID, value))
+        values.push_back(value);
+
+    // the study stored in the meantime is reported, but no study twice
+    OFCHECK_EQUAL(values.size(), 3);
+    OFCHECK(isUnique(values));
+
+    // a cancelled C-FIND must not block either
+    DcmQueryRetrieveDatabaseStatus status;
+    OFCHECK(startFind(finder, IMAGE_LEVEL_STRING, DCM_SOPInstanceUID, "1.2.276.0.7230010.3.4.1").good());
+    OFCHECK(finder.cancelFindRequest(&status).good());
+    area.storeInstance(storer, "1.2.276.0.7230010.3.4.1");
+    findAll(finder, IMAGE_LEVEL_STRING, DCM_SOPInstanceUID, values, "1.2.276.0.7230010.3.4.1");
+    OFCHECK_EQUAL(values.size(), 3);
+}
+
+
+OFTEST(dcmqrdb_index_store_during_move)
+{
+    TestStorageArea area("tidxconc_move.out");
+    OFCondition result;
+    DcmQueryRetrieveIndexDatabaseHandle mover(area.dirName(), -1, -1, result);
+    OFCHECK(result.good());
+    DcmQueryRetrieveIndexDatabaseHandle storer(area.dirName(), -1, -1, result);
+    OFCHECK(result.good());
+
+    OFVector<OFString> stored;
+    stored.push_back(area.storeInstance(storer, "1.2.276.0.7230010.3.4.1"));
+    stored.push_back(area.storeInstance(storer, "1.2.276.0.7230010.3.4.1"));
+    stored.push_back(area.storeInstance(storer, "1.2.276.0.7230010.3.4.1"));
+
+    DcmDataset query;
+    OFCHECK(query.putAndInsertString(DCM_QueryRetrieveLevel, STUDY_LEVEL_STRING).good());
+    OFCHECK(query.putAndInsertString(DCM_StudyInstanceUID, "1.2.276.0.7230010.3.4.1").good());
+    DcmQueryRetrieveDatabaseStatus status;
+    OFCHECK(mover.startMoveRequest(UID_MOVEStudyRootQueryRetrieveInformationModel, &query, &status).good());
+    OFCHECK_EQUAL(status.status(), STATUS_Pending);
+
+    // storing further instances while the sub-operations are performed must not block
+    char sopClass[UI_MAX_LENGTH + 1];
+    char sopInstance[UI_MAX_LENGTH + 1];
+    char filename[DBC_MAXSTRING + 1];
+    unsigned short remaining = 0;
+    OFVector<OFString> moved;
+    OFCHECK(mover.nextMoveResponse(sopClass, sizeof(sopClass), sopInstance, sizeof(sopInstance), filename, sizeof(filename), &remaining, &status).good());
+    OFCHECK_EQUAL(status.status(), STATUS_Pending);
+    OFCHECK_EQUAL(remaining, 2);
+    moved.push_back(sopInstance);
+    area.storeInstance(storer, "1.2.276.0.7230010.3.4.1");
+    while (mover.nextMoveResponse(sopClass, sizeof(sopClass), sopInstance, sizeof(sopInstance), filename, sizeof(filename), &remaining, &status).good() &&
+           (status.status() == STATUS_Pending))
+    {
+        moved.push_back(sopInstance);
+    }
+    OFCHECK_EQUAL(status.status(), STATUS_Success);
+
+    // the sub-operations are those determined when the request was started
+    OFCHECK_EQUAL(moved.size(), stored.size());
+    for (size_t i = 0; (i < moved.size()) && (i < stored.size()); ++i)
+        OFCHECK_EQUAL(moved[i], stored[i]);
+}
+
+
+#ifdef WITH_THREADS
+
+/// studies stored by the storage threads of the stress test, one per thread
+static const char *stressTestStudies[STRESS_TEST_WRITERS] =
+{
+    "1.2.276.0.7230010.3.4.11",
+    "1.2.276.0.7230010.3.4.12",
+    "1.2.276.0.7230010.3.4.13",
+    "1.2.276.0.7230010.3.4.14"
+};
+
+/// stores instances of its own study while other threads access the storage area
+class StorageThread : public OFThread
+{
+public:
+    StorageThread(TestStorageArea& area, const char *studyUID)
+      : OFThread()
+      , m_area(area)
+      , m_studyUID(studyUID)
+      , m_stored()
+    {
+    }
+
+    virtual void run()
+    {
+        OFCondition result;
+        DcmQueryRetrieveIndexDatabaseHandle handle(m_area.dirName(), -1, -1, result);
+        OFCHECK(result.good());
+        if (result.good())
+        {
+            for (int i = 0; i < STRESS_TEST_INSTANCES; ++i)
+                m_stored.push_back(m_area.storeInstance(handle, m_studyUID.c_str()));
+        }
+    }
+
+    TestStorageArea& m_area;
+    OFString m_studyUID;
+    OFVector<OFString> m_stored;
+};
+
+/// queries the storage area repeatedly until all instances have been stored
+class QueryThread : public OFThread
+{
+public:
+    QueryThread(TestStorageArea& area)
+      : OFThread()
+      , m_area(area)
+      , m_queries(0)
+      , m_consistent(OFTrue)
+    {
+    }
+
+    virtual void run()
+    {
+        OFCondition result;
+        DcmQueryRetrieveIndexDatabaseHandle handle(m_area.dirName(), -1, -1, result);
+        OFCHECK(result.good());
+        if (result.bad())
+            return;
+        OFVector<OFString> values;
+        size_t previous[STRESS_TEST_WRITERS] = { 0 };
+        do
+        {
+            // alternate between study and instance level queries
+            if (m_queries % 2 == 0)
+            {
+                findAll(handle, STUDY_LEVEL_STRING, DCM_StudyInstanceUID, values);
+                if (values.size() > STRESS_TEST_WRITERS || !isUnique(values))
+                    m_consistent = OFFalse;
+            }
+            else
+            {
+                const size_t study = (m_queries / 2) % STRESS_TEST_WRITERS;
+                findAll(handle, IMAGE_LEVEL_STRING, DCM_SOPInstanceUID, values, stressTestStudies[study]);
+                // instances are never removed, so their number must not decrease
+                if (values.size() < previous[study] || !isUnique(values))
+                    m_consistent = OFFalse;
+                previous[study] = values.size();
+            }
+            ++m_queries;
+        } while (!m_area.finished());
+    }
+
+    TestStorageArea& m_area;
+    size_t m_queries;
+    OFBool m_consistent;
+};
+
+
+OFTEST(dcmqrdb_index_concurrent_access)
+{
+    TestStorageArea area("tidxconc_stress.out");
+
+    // create the index file before the threads are started
+    {
+        OFCondition result;
+        DcmQueryRetrieveIndexDatabaseHandle handle(area.dirName(), -1, -1, result);
+        OFCHECK(result.good());
+    }
+
+    StorageThread *writers[STRESS_TEST_WRITERS];
+    QueryThread *readers[STRESS_TEST_READERS];
+    int i;
+    for (i = 0; i < STRESS_TEST_READERS; ++i)
+    {
+        readers[i] = new QueryThread(area);
+        readers[i]->start();
+    }
+    for (i = 0; i < STRESS_TEST_WRITERS; ++i)
+    {
+        writers[i] = new StorageThread(area, stressTestStudies[i]);
+        writers[i]->start();
+    }
+
+    OFVector<OFString> stored;
+    for (i = 0; i < STRESS_TEST_WRITERS; ++i)
+    {
+        writers[i]->join();
+        OFCHECK_EQUAL(writers[i]->m_stored.size(), STRESS_TEST_INSTANCES);
+        stored.insert(stored.end(), writers[i]->m_stored.begin(), writers[i]->m_stored.end());
+        delete writers[i];
+    }
+    area.setFinished();
+    for (i = 0; i < STRESS_TEST_READERS; ++i)
+    {
+        readers[i]->join();
+        OFCHECK(readers[i]->m_consistent);
+        OFCHECK(readers[i]->m_queries > 0);
+        delete readers[i];
+    }
+
+    // all instances are registered exactly once and can be found via the attribute index
+    OFCondition result;
+    DcmQueryRetrieveIndexDatabaseHandle handle(area.dirName(), -1, -1, result);
+    OFCHECK(result.good());
+    OFVector<OFString> values;
+    for (i = 0; i < STRESS_TEST_WRITERS; ++i)
+    {
+        findAll(handle, IMAGE_LEVEL_STRING, DCM_SOPInstanceUID, values, stressTestStudies[i]);
+        OFCHECK_EQUAL(values.size(), STRESS_TEST_INSTANCES);
+        OFCHECK(isUnique(values));
+    }
+    findAll(handle, STUDY_LEVEL_STRING, DCM_StudyInstanceUID, values);
+    OFCHECK_EQUAL(values.size(), STRESS_TEST_WRITERS);
+    for (OFVector<OFString>::const_iterator it = stored.begin(); it != stored.end(); ++it)
+        OFCHECK(handle.findSOPInstance(area.dirName(), UID_SecondaryCaptureImageStorage, *it));
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,225 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test the record format of the index file of a storage area
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/dcmqrdb/dcmqrdbi.h"
+#include "dcmtk/dcmqrdb/dcmqridx.h"
+#include "dcmtk/dcmqrdb/dcmqrdbs.h"
+#include "dcmtk/dcmqrdb/dcmqrcnf.h"
+#include "dcmtk/dcmqrdb/dcmqrkey.h"
+
+BEGIN_EXTERN_C
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#endif
+END_EXTERN_C
+
+
+#define TEST_STUDY_UID "1.2.276.0.7230010.3.4.5"
+
+
+// remove the files of a storage area and the storage area itself
+static void removeStorageArea(const char *dirName, const OFVector<OFString>& files)
+{
+    OFString filename;
+    for (OFVector<OFString>::const_iterator it = files.begin(); it != files.end(); ++it)
+        OFStandard::deleteFile(*it);
+    OFStandard::deleteFile(OFStandard::combineDirAndFilename(filename, dirName, DBINDEXFILE));
+    OFStandard::deleteFile(OFStandard::combineDirAndFilename(filename, dirName, DBKEYINDEXFILE));
+#ifdef _WIN32
+    _rmdir(dirName);
+#else
+    rmdir(dirName);
+#endif
+}
+
+// perform an image level C-FIND for the test study and return the SOP Instance UIDs
+static void findInstances(DcmQueryRetrieveIndexDatabaseHandle& handle, OFVector<OFString>& values)
+{
+    DcmDataset query;
+    OFCHECK(query.putAndInsertString(DCM_QueryRetrieveLevel, IMAGE_LEVEL_STRING).good());
+    OFCHECK(query.putAndInsertString(DCM_StudyInstanceUID, TEST_STUDY_UID).good());
+    OFCHECK(query.putAndInsertString(DCM_SeriesInstanceUID, TEST_STUDY_UID).good());
+    OFCHECK(query.insertEmptyElement(DCM_SOPInstanceUID).good());
+    DcmQueryRetrieveDatabaseStatus status;
+    DcmQueryRetrieveCharacterSetOptions options;
+    values.clear();
+    OFCHECK(handle.startFindRequest(UID_FINDStudyRootQueryRetrieveInformationModel, &query, &status).good());
+    while (status.status() == STATUS_Pending)
+    {
+        DcmDataset *response = NULL;
+        OFCHECK(handle.nextFindResponse(&response, &status, options).good());
+        OFString value;
+        if ((response != NULL) && response->findAndGetOFString(DCM_SOPInstanceUID, value).good())
+            values.push_back(value);
+        delete response;
+    }
+}
+
+// fill a record in the legacy format, i.e. a binary copy of struct IdxRecord
+static void makeLegacyRecord(IdxRecord& rec, const char *filename, const char *sopInstanceUID)
+{
+    memset(OFreinterpret_cast(char *, &rec), 0, SIZEOF_IDXRECORD);
+    OFStandard::strlcpy(rec.filename, filename, sizeof(rec.filename));
+    OFStandard::strlcpy(rec.SOPClassUID, UID_SecondaryCaptureImageStorage, sizeof(rec.SOPClassUID));
+    OFStandard::strlcpy(rec.PatientID, "FORMAT", sizeof(rec.PatientID));
+    OFStandard::strlcpy(rec.StudyInstanceUID, TEST_STUDY_UID, sizeof(rec.StudyInstanceUID));
+    OFStandard::strlcpy(rec.SeriesInstanceUID, TEST_STUDY_UID, sizeof(rec.SeriesInstanceUID));
+    OFStandard::strlcpy(rec.SOPInstanceUID, sopInstanceUID, sizeof(rec.SOPInstanceUID));
+    rec.ImageSize = 1000;
+    rec.hstat = DVIF_objectIsNew;
+}
+
+
+OFTEST(dcmqrdb_index_legacy_conversion)
+{
+    const char *dirName = "tidxfmt_conv.out";
+    OFVector<OFString> files;
+    OFString indexFilename;
+    OFStandard::combineDirAndFilename(indexFilename, dirName, DBINDEXFILE);
+    OFCHECK(OFStandard::createDirectory(dirName, "").good());
+
+    // write a legacy index file with two records in use and a free record
+    StudyDescRecord *studyDesc = new StudyDescRecord[MAX_MAX_STUDIES];
+    memset(OFreinterpret_cast(char *, studyDesc), 0, SIZEOF_STUDYDESC);
+    OFStandard::strlcpy(studyDesc[0].StudyInstanceUID, TEST_STUDY_UID, sizeof(studyDesc[0].StudyInstanceUID));
+    studyDesc[0].StudySize = 2000;
+    studyDesc[0].NumberofRegistratedImages = 2;
+    IdxRecord *records = new IdxRecord[3];
+    makeLegacyRecord(records[0], "SC000001.dcm", "1.2.276.0.7230010.3.4.5.1");
+    makeLegacyRecord(records[1], "", "");
+    makeLegacyRecord(records[2], "SC000003.dcm", "1.2.276.0.7230010.3.4.5.3");
+    FILE *f = fopen(indexFilename.c_str(), "wb");
+    OFCHECK(f != NULL);
+    if (f != NULL)
+    {
+        char header[DBHEADERSIZE + 1];
+        sprintf(header, DBMAGIC "%.2X", DBLEGACYVERSION);
+        OFCHECK(fwrite(header, 1, DBIDENTSIZE, f) == DBIDENTSIZE);
+        OFCHECK(fwrite(studyDesc, 1, SIZEOF_STUDYDESC, f) == SIZEOF_STUDYDESC);
+        OFCHECK(fwrite(records, 1, 3 * SIZEOF_IDXRECORD, f) == 3 * SIZEOF_IDXRECORD);
+        fclose(f);
+    }
+    delete[] records;
+    delete[] studyDesc;
+    const size_t legacySize = OFStandard::getFileSize(indexFilename);
+
+    // the legacy index file is rejected
+    {
+        OFCondition result;
+        DcmQueryRetrieveIndexDatabaseHandle handle(dirName, -1, -1, result);
+        OFCHECK(result.bad());
+    }
+
+    // after the conversion, both records are found and the file is much smaller
+    OFCHECK(DcmQueryRetrieveIndexDatabaseHandle::convertLegacyIndexFile(dirName).good());
+    OFCHECK(OFStandard::getFileSize(indexFilename) < legacySize - 2 * SIZEOF_IDXRECORD);
+    {
+        OFCondition result;
+        DcmQueryRetrieveIndexDatabaseHandle handle(dirName, -1, -1, result);
+        OFCHECK(result.good());
+        OFVector<OFString> values;
+        findInstances(handle, values);
+        OFCHECK_EQUAL(values.size(), 2);
+        if (values.size() == 2)
+        {
+            OFCHECK_EQUAL(values[0], "1.2.276.0.7230010.3.4.5.1");
+            OFCHECK_EQUAL(values[1], "1.2.276.0.7230010.3.4.5.3");
+        }
+    }
+
+    // an index file in the current format is left unchanged
+    const size_t convertedSize = OFStandard::getFileSize(indexFilename);
+    OFCHECK(DcmQueryRetrieveIndexDatabaseHandle::convertLegacyIndexFile(dirName).good());
+    OFCHECK_EQUAL(OFStandard::getFileSize(indexFilename), convertedSize);
+
+    removeStorageArea(dirName, files);
+}
+
+
+OFTEST(dcmqrdb_index_record_reuse)
+{
+    const char *dirName = "tidxfmt_reuse.out";
+    OFVector<OFString> files;
+    OFString indexFilename;
+    OFStandard::combineDirAndFilename(indexFilename, dirName, DBINDEXFILE);
+    OFCHECK(OFStandard::createDirectory(dirName, "").good());
+
+    OFCondition result;
+    DcmQueryRetrieveIndexDatabaseHandle handle(dirName, -1, -1, result);
+    OFCHECK(result.good());
+    handle.enableQuotaSystem(OFFalse);
+
+    // store three instances
+    OFVector<OFString> stored;
+    for (int i = 1; i <= 3; ++i)
+    {
+        char name[20];
+        char uid[100];
+        OFString filename;
+        sprintf(name, "SC%06d.dcm", i);
+        sprintf(uid, "%s.%d", TEST_STUDY_UID, i);
+        OFStandard::combineDirAndFilename(filename, dirName, name);
+        DcmFileFormat fileformat;
+        DcmDataset *dset = fileformat.getDataset();
+        OFCHECK(dset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+        OFCHECK(dset->putAndInsertString(DCM_SOPInstanceUID, uid).good());
+        OFCHECK(dset->putAndInsertString(DCM_StudyInstanceUID, TEST_STUDY_UID).good());
+        OFCHECK(dset->putAndInsertString(DCM_SeriesInstanceUID, TEST_STUDY_UID).good());
+        OFCHECK(dset->putAndInsertString(DCM_PatientID, "FORMAT").good());
+        OFCHECK(fileformat.saveFile(filename, EXS_LittleEndianExplicit).good());
+        files.push_back(filename);
+        stored.push_back(uid);
+        DcmQueryRetrieveDatabaseStatus status;
+        OFCHECK(handle.storeRequest(UID_SecondaryCaptureImageStorage, uid, filename.c_str(), &status).good());
+        OFCHECK_EQUAL(status.status(), STATUS_Success);
+    }
+    const size_t size = OFStandard::getFileSize(indexFilename);
+
+    // storing an instance again replaces its record, which is re-used
+    DcmQueryRetrieveDatabaseStatus status;
+    OFCHECK(handle.storeRequest(UID_SecondaryCaptureImageStorage, stored[1].c_str(), files[1].c_str(), &status).good());
+    OFCHECK_EQUAL(status.status(), STATUS_Success);
+    OFCHECK_EQUAL(OFStandard::getFileSize(indexFilename), size);
+
+    OFVector<OFString> values;
+    findInstances(handle, values);
+    OFCHECK_EQUAL(values.size(), 3);
+    if (values.size() == 3)
+    {
+        for (size_t i = 0; i < 3; ++i)
+            OFCHECK_EQUAL(values[i], stored[i]);
+    }
+
+    removeStorageArea(dirName, files);
+}
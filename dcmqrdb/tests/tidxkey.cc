@@ -0,0 +1,347 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test the attribute index of a storage area
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/ofstd/ofalgo.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmnet/dimse.h"
+#include "dcmtk/dcmqrdb/dcmqrdbi.h"
+#include "dcmtk/dcmqrdb/dcmqridx.h"
+#include "dcmtk/dcmqrdb/dcmqrdbs.h"
+#include "dcmtk/dcmqrdb/dcmqrcnf.h"
+#include "dcmtk/dcmqrdb/dcmqrkey.h"
+
+BEGIN_EXTERN_C
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#endif
+END_EXTERN_C
+
+
+#define TEST_STUDY_UID "1.2.276.0.7230010.3.4.6"
+
+/* number of records, large enough for a tree with more than two levels */
+#define TEST_RECORDS   6000
+
+
+// fill an index record with the given attribute values
+static void makeRecord(IdxRecord& rec, int number)
+{
+    char buf[100];
+    memset(OFreinterpret_cast(char *, &rec), 0, SIZEOF_IDXRECORD);
+    sprintf(buf, "PAT%05d", number);
+    OFStandard::strlcpy(rec.PatientID, buf, sizeof(rec.PatientID));
+    sprintf(buf, "%s.%d", TEST_STUDY_UID, number / 100);
+    OFStandard::strlcpy(rec.StudyInstanceUID, buf, sizeof(rec.StudyInstanceUID));
+    OFStandard::strlcpy(rec.SeriesInstanceUID, buf, sizeof(rec.SeriesInstanceUID));
+    sprintf(buf, "%s.%d.%d", TEST_STUDY_UID, number / 100, number);
+    OFStandard::strlcpy(rec.SOPInstanceUID, buf, sizeof(rec.SOPInstanceUID));
+    sprintf(buf, "2021%02d%02d", (number / 28) % 12 + 1, number % 28 + 1);
+    OFStandard::strlcpy(rec.StudyDate, buf, sizeof(rec.StudyDate));
+}
+
+// return the record numbers found for the SOP Instance UID of the given record
+static OFVector<int> findInstance(DcmQueryRetrieveKeyIndex& keyIndex, int number)
+{
+    IdxRecord rec;
+    makeRecord(rec, number);
+    OFVector<int> records;
+    OFCHECK(keyIndex.findEqual(KEYIDX_SOPInstanceUID, rec.SOPInstanceUID, strlen(rec.SOPInstanceUID), records).good());
+    return records;
+}
+
+// check that exactly the given record has been found
+static void checkFound(const OFVector<int>& records, int number)
+{
+    OFCHECK_EQUAL(records.size(), 1);
+    if (records.size() == 1)
+        OFCHECK_EQUAL(records[0], number);
+}
+
+// perform an image level C-FIND for a list of SOP Instance UIDs and return the UIDs found
+static void findInstances(const char *dirName, OFVector<OFString>& values)
+{
+    OFCondition result;
+    DcmQueryRetrieveIndexDatabaseHandle handle(dirName, -1, -1, result);
+    OFCHECK(result.good());
+    DcmDataset query;
+    OFCHECK(query.putAndInsertString(DCM_QueryRetrieveLevel, IMAGE_LEVEL_STRING).good());
+    OFCHECK(query.putAndInsertString(DCM_StudyInstanceUID, TEST_STUDY_UID).good());
+    OFCHECK(query.putAndInsertString(DCM_SeriesInstanceUID, TEST_STUDY_UID).good());
+    OFCHECK(query.putAndInsertString(DCM_SOPInstanceUID, TEST_STUDY_UID ".1\\" TEST_STUDY_UID ".3").good());
+    DcmQueryRetrieveDatabaseStatus status;
+    DcmQueryRetrieveCharacterSetOptions options;
+    values.clear();
+    OFCHECK(handle.startFindRequest(UID_FINDStudyRootQueryRetrieveInformationModel, &query, &status).good());
+    while (status.status() == STATUS_Pending)
+    {
+        DcmDataset *response = NULL;
+        OFCHECK(handle.nextFindResponse(&response, &status, options).good());
+        OFString value;
+        if ((response != NULL) && response->findAndGetOFString(DCM_SOPInstanceUID, value).good())
+            values.push_back(value);
+        delete response;
+    }
+}
+
+// read the generation counter from the header of the given index file
+static Uint64 readGeneration(const OFString& indexFilename)
+{
+    Uint64 generation = 0;
+    FILE *f = fopen(indexFilename.c_str(), "rb");
+    OFCHECK(f != NULL);
+    if (f != NULL)
+    {
+        OFCHECK(fseek(f, DBGENERATIONOFFSET, SEEK_SET) == 0);
+        OFCHECK(fread(&generation, 1, sizeof(generation), f) == sizeof(generation));
+        fclose(f);
+    }
+    return generation;
+}
+
+// write the generation counter to the header of the given index file
+static void writeGeneration(const OFString& indexFilename, Uint64 generation)
+{
+    FILE *f = fopen(indexFilename.c_str(), "r+b");
+    OFCHECK(f != NULL);
+    if (f != NULL)
+    {
+        OFCHECK(fseek(f, DBGENERATIONOFFSET, SEEK_SET) == 0);
+        OFCHECK(fwrite(&generation, 1, sizeof(generation), f) == sizeof(generation));
+        fclose(f);
+    }
+}
+
+
+OFTEST(dcmqrdb_keyindex_make_key)
+{
+    OFString key;
+    OFCHECK(DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_PatientID, "  PAT 1  ", 9, key));
+    OFCHECK_EQUAL(key, "PAT 1");
+    OFCHECK(!DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_PatientID, "    ", 4, key));
+    OFCHECK(!DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_PatientID, NULL, 0, key));
+
+    // values are truncated to the maximum key length
+    const OFString longValue(KEYIDX_MAX_LENGTH + 10, 'X');
+    OFCHECK(DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_AccessionNumber, longValue.c_str(), longValue.length(), key));
+    OFCHECK_EQUAL(key, longValue.substr(0, KEYIDX_MAX_LENGTH));
+
+    // values with control characters (e.g. escape sequences) are uncertain
+    OFString other;
+    OFCHECK(DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_PatientID, "A\033$BB", 5, key));
+    OFCHECK(DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_PatientID, "C\033$BD", 5, other));
+    OFCHECK_EQUAL(key, other);
+    OFCHECK(DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_SOPInstanceUID, "1.2.3 ", 6, key));
+    OFCHECK_EQUAL(key, "1.2.3");
+
+    // dates are stored in canonical form, invalid dates are not indexed
+    OFCHECK(DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_StudyDate, "20210315 ", 9, key));
+    OFCHECK_EQUAL(key, "20210315");
+    OFCHECK(!DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_StudyDate, "20211315", 8, key));
+    OFCHECK(!DcmQueryRetrieveKeyIndex::makeKey(KEYIDX_StudyDate, "TODAY", 5, key));
+}
+
+
+OFTEST(dcmqrdb_keyindex_insert_remove)
+{
+    const char *filename = "tidxkey_tree.out";
+    OFStandard::deleteFile(filename);
+    DcmQueryRetrieveKeyIndex keyIndex;
+    OFCHECK(keyIndex.open(filename).good());
+    OFCHECK(!keyIndex.isUpToDate(0));
+    OFCHECK(keyIndex.clear().good());
+    OFCHECK(keyIndex.commit(1).good());
+    OFCHECK(keyIndex.isUpToDate(1));
+
+    // add the records in an order that is neither ascending nor descending
+    IdxRecord rec;
+    for (int i = 0; i < TEST_RECORDS; ++i)
+    {
+        const int number = OFstatic_cast(int, (OFstatic_cast(unsigned long, i) * 2311) % TEST_RECORDS);
+        makeRecord(rec, number);
+        OFCHECK(keyIndex.addRecord(rec, number).good());
+    }
+
+    // the key index remains dirty until the change is committed
+    OFCHECK(!keyIndex.isUpToDate(1));
+    OFCHECK(!keyIndex.isUpToDate(2));
+    OFCHECK(keyIndex.commit(2).good());
+    OFCHECK(!keyIndex.isUpToDate(1));
+    OFCHECK(keyIndex.isUpToDate(2));
+
+    // five attributes are indexed, each tree has more leaves than the root
+    // node can refer to, i.e. the leaves and the inner nodes have been split
+    OFCHECK(OFStandard::getFileSize(filename) > 5 * (TEST_RECORDS / 60) * 4096);
+
+    for (int i = 0; i < TEST_RECORDS; i += 7)
+        checkFound(findInstance(keyIndex, i), i);
+
+    // prefix matching
+    OFVector<int> records;
+    OFCHECK(keyIndex.findPrefix(KEYIDX_PatientID, "PAT012", 6, records).good());
+    OFCHECK_EQUAL(records.size(), 100);
+    records.clear();
+    OFCHECK(keyIndex.findPrefix(KEYIDX_PatientID, "XYZ", 3, records).good());
+    OFCHECK(records.empty());
+
+    // date range matching
+    records.clear();
+    OFCHECK(keyIndex.findRange(KEYIDX_StudyDate, "20210101", "20210103", records).good());
+    OFCHECK_EQUAL(records.size(), 3 * (TEST_RECORDS / (28 * 12)) + 3);
+    records.clear();
+    OFCHECK(keyIndex.findRange(KEYIDX_StudyDate, NULL, NULL, records).good());
+    OFCHECK_EQUAL(records.size(), TEST_RECORDS);
+
+    // list of UIDs, i.e. several lookups for the same attribute
+    records.clear();
+    makeRecord(rec, 0);
+    OFCHECK(keyIndex.findEqual(KEYIDX_StudyInstanceUID, rec.StudyInstanceUID, strlen(rec.StudyInstanceUID), records).good());
+    makeRecord(rec, TEST_RECORDS - 1);
+    OFCHECK(keyIndex.findEqual(KEYIDX_StudyInstanceUID, rec.StudyInstanceUID, strlen(rec.StudyInstanceUID), records).good());
+    OFCHECK_EQUAL(records.size(), 200);
+    OFCHECK(OFFind(OFVector<int>::iterator, int, records.begin(), records.end(), 99) != records.end());
+    OFCHECK(OFFind(OFVector<int>::iterator, int, records.begin(), records.end(), TEST_RECORDS - 100) != records.end());
+
+    // remove every other record
+    for (int i = 0; i < TEST_RECORDS; i += 2)
+    {
+        makeRecord(rec, i);
+        OFCHECK(keyIndex.removeRecord(rec, i).good());
+    }
+    OFCHECK(keyIndex.commit(3).good());
+    keyIndex.close();
+
+    // the changes are persistent
+    OFCHECK(keyIndex.open(filename).good());
+    OFCHECK(keyIndex.isUpToDate(3));
+    for (int i = 0; i < TEST_RECORDS; i += 5)
+    {
+        records = findInstance(keyIndex, i);
+        if (i % 2)
+            checkFound(records, i);
+        else
+            OFCHECK(records.empty());
+    }
+    records.clear();
+    OFCHECK(keyIndex.findPrefix(KEYIDX_PatientID, "PAT012", 6, records).good());
+    OFCHECK_EQUAL(records.size(), 50);
+
+    keyIndex.close();
+    OFStandard::deleteFile(filename);
+}
+
+
+OFTEST(dcmqrdb_keyindex_stale_rebuild)
+{
+    const char *dirName = "tidxkey_stale.out";
+    OFVector<OFString> files;
+    OFString filename;
+    OFString indexFilename;
+    OFString keyIndexFilename;
+    OFStandard::combineDirAndFilename(indexFilename, dirName, DBINDEXFILE);
+    OFStandard::combineDirAndFilename(keyIndexFilename, dirName, DBKEYINDEXFILE);
+    OFCHECK(OFStandard::createDirectory(dirName, "").good());
+
+    // store three instances of the same study
+    {
+        OFCondition result;
+        DcmQueryRetrieveIndexDatabaseHandle handle(dirName, -1, -1, result);
+        OFCHECK(result.good());
+        handle.enableQuotaSystem(OFFalse);
+        for (int i = 1; i <= 3; ++i)
+        {
+            char name[20];
+            char uid[100];
+            sprintf(name, "SC%06d.dcm", i);
+            sprintf(uid, "%s.%d", TEST_STUDY_UID, i);
+            OFStandard::combineDirAndFilename(filename, dirName, name);
+            DcmFileFormat fileformat;
+            DcmDataset *dset = fileformat.getDataset();
+            OFCHECK(dset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+            OFCHECK(dset->putAndInsertString(DCM_SOPInstanceUID, uid).good());
+            OFCHECK(dset->putAndInsertString(DCM_StudyInstanceUID, TEST_STUDY_UID).good());
+            OFCHECK(dset->putAndInsertString(DCM_SeriesInstanceUID, TEST_STUDY_UID).good());
+            OFCHECK(dset->putAndInsertString(DCM_PatientID, "STALE").good());
+            OFCHECK(fileformat.saveFile(filename, EXS_LittleEndianExplicit).good());
+            files.push_back(filename);
+            DcmQueryRetrieveDatabaseStatus status;
+            OFCHECK(handle.storeRequest(UID_SecondaryCaptureImageStorage, uid, filename.c_str(), &status).good());
+            OFCHECK_EQUAL(status.status(), STATUS_Success);
+        }
+    }
+
+    // each stored record advanced the generation counter of the index file
+    const Uint64 generation = readGeneration(indexFilename);
+    OFCHECK(generation >= 3);
+    {
+        DcmQueryRetrieveKeyIndex keyIndex;
+        OFCHECK(keyIndex.open(keyIndexFilename.c_str()).good());
+        OFCHECK(keyIndex.isUpToDate(generation));
+        OFVector<int> records;
+        OFCHECK(keyIndex.findEqual(KEYIDX_SOPInstanceUID, TEST_STUDY_UID ".2", strlen(TEST_STUDY_UID ".2"), records).good());
+        OFCHECK_EQUAL(records.size(), 1);
+
+        // empty the key index, but mark it as up to date
+        OFCHECK(keyIndex.clear().good());
+        OFCHECK(keyIndex.commit(generation).good());
+    }
+
+    // an up to date key index is trusted, i.e. no instance is found
+    OFVector<OFString> values;
+    findInstances(dirName, values);
+    OFCHECK(values.empty());
+
+    // a change of the index file that is not reflected in the key index
+    // (e.g. by a crashed process) causes the key index to be rebuilt
+    writeGeneration(indexFilename, generation + 1);
+    findInstances(dirName, values);
+    OFCHECK_EQUAL(values.size(), 2);
+    if (values.size() == 2)
+    {
+        OFCHECK_EQUAL(values[0], TEST_STUDY_UID ".1");
+        OFCHECK_EQUAL(values[1], TEST_STUDY_UID ".3");
+    }
+    {
+        DcmQueryRetrieveKeyIndex keyIndex;
+        OFCHECK(keyIndex.open(keyIndexFilename.c_str()).good());
+        OFCHECK(keyIndex.isUpToDate(generation + 1));
+    }
+
+    for (OFVector<OFString>::const_iterator it = files.begin(); it != files.end(); ++it)
+        OFStandard::deleteFile(*it);
+    OFStandard::deleteFile(indexFilename);
+    OFStandard::deleteFile(keyIndexFilename);
+#ifdef _WIN32
+    _rmdir(dirName);
+#else
+    rmdir(dirName);
+#endif
+}
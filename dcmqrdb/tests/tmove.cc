@@ -0,0 +1,295 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  dcmqrdb
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Test the store sub-operations of the C-MOVE SCP with a move
+ *           destination that fails
+ *
+ */
+
+
+#include "dcmtk/config/osconfig.h"    /* make sure OS specific configuration is included first */
+
+#ifdef WITH_THREADS
+
+#include "dcmtk/ofstd/oftest.h"
+#include "dcmtk/ofstd/ofstd.h"
+#include "dcmtk/ofstd/ofmap.h"
+#include "dcmtk/ofstd/ofvector.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+#include "dcmtk/dcmnet/scppool.h"
+#include "dcmtk/dcmqrdb/dcmqrdbi.h"
+#include "dcmtk/dcmqrdb/dcmqridx.h"
+#include "dcmtk/dcmqrdb/dcmqrkey.h"
+#include "dcmtk/dcmqrdb/dcmqrdbs.h"
+#include "dcmtk/dcmqrdb/dcmqrcnf.h"
+#include "dcmtk/dcmqrdb/dcmqropt.h"
+#include "dcmtk/dcmqrdb/dcmqrcbm.h"
+
+BEGIN_EXTERN_C
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#endif
+END_EXTERN_C
+
+
+/// port of the move destination used by the tests in this file
+#define MOVE_TEST_PORT 11130
+
+/// number of instances to be moved
+#define MOVE_TEST_INSTANCES 6
+
+/// size of the pixel data of the instance whose transmission is interrupted
+#define MOVE_TEST_LARGE_SIZE (32 * 1024 * 1024)
+
+/// study that is moved
+#define MOVE_TEST_STUDY "1.2.276.0.7230010.3.4.21"
+
+
+/// instance that is aborted by the move destination before it has been received
+static OFString abortedInstance;
+
+/// instance that is received by the move destination but never answered
+static OFString unansweredInstance;
+
+/// number of C-STORE requests received by the move destination for each instance
+static OFMap<OFString, int> storeRequests;
+
+/// mutex protecting the variables above
+static OFMutex storeRequestsMutex;
+
+
+static int getStoreRequests(const OFString& instance)
+{
+    storeRequestsMutex.lock();
+    const int result = storeRequests[instance];
+    storeRequestsMutex.unlock();
+    return result;
+}
+
+
+/** move destination that aborts the association on the first request for
+ *  abortedInstance (without receiving its dataset) and after having received
+ *  the dataset of unansweredInstance
+ */
+struct MoveDestinationSCP : DcmThreadSCP
+{
+    virtual OFCondition handleIncomingCommand(T_DIMSE_Message* incomingMsg, const DcmPresentationContextInfo& presInfo)
+    {
+        if (incomingMsg->CommandField != DIMSE_C_STORE_RQ)
+            return DcmThreadSCP::handleIncomingCommand(incomingMsg, presInfo);
+        T_DIMSE_C_StoreRQ& req = incomingMsg->msg.CStoreRQ;
+        const OFString instance = req.AffectedSOPInstanceUID;
+        storeRequestsMutex.lock();
+        const int count = ++storeRequests[instance];
+        const OFBool abort = (instance == abortedInstance) && (count == 1);
+        const OFBool unanswered = (instance == unansweredInstance);
+        storeRequestsMutex.unlock();
+        if (abort)
+            return DIMSE_BADDATA;
+        DcmDataset *dataset = NULL;
+        OFCondition cond = receiveSTORERequest(req, presInfo.presentationContextID, dataset);
+        delete dataset;
+        if (cond.good() && unanswered)
+            cond = DIMSE_BADDATA;
+        if (cond.good())
+            cond = sendSTOREResponse(presInfo.presentationContextID, req, STATUS_Success);
+        return cond;
+    }
+};
+
+
+struct MoveDestinationPool : DcmSCPPool<MoveDestinationSCP>, OFThread
+{
+    OFCondition result;
+protected:
+    void run()
+    {
+        result = listen();
+    }
+};
+
+
+/// create an instance, store it in the given directory and register it in the index file
+static OFString storeInstance(DcmQueryRetrieveIndexDatabaseHandle& handle, const OFString& dirName, OFVector<OFString>& files, const size_t pixelDataSize = 0)
+{
+    char uid[100];
+    DcmFileFormat fileformat;
+    DcmDataset *dset = fileformat.getDataset();
+    OFCHECK(dset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage).good());
+    OFCHECK(dset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT)).good());
+    OFCHECK(dset->putAndInsertString(DCM_StudyInstanceUID, MOVE_TEST_STUDY).good());
+    OFCHECK(dset->putAndInsertString(DCM_SeriesInstanceUID, MOVE_TEST_STUDY).good());
+    OFCHECK(dset->putAndInsertString(DCM_PatientID, "MOVE").good());
+    OFCHECK(dset->putAndInsertString(DCM_PatientName, "Move^Destination").good());
+    OFCHECK(dset->putAndInsertString(DCM_Modality, "OT").good());
+    if (pixelDataSize > 0)
+    {
+        Uint8 *pixelData = new Uint8[pixelDataSize];
+        memset(pixelData, 0x55, pixelDataSize);
+        OFCHECK(dset->putAndInsertUint8Array(DCM_PixelData, pixelData, OFstatic_cast(unsigned long, pixelDataSize)).good());
+        delete[] pixelData;
+    }
+    OFString filename;
+    char name[20];
+    sprintf(name, "MV%06u.dcm", OFstatic_cast(unsigned int, files.size() + 1));
+    OFStandard::combineDirAndFilename(filename, dirName, name);
+    files.push_back(filename);
+    OFCHECK(fileformat.saveFile(filename, EXS_LittleEndianExplicit).good());
+    DcmQueryRetrieveDatabaseStatus status;
+    OFCHECK(handle.storeRequest(UID_SecondaryCaptureImageStorage, uid, filename.c_str(), &status).good());
+    OFCHECK_EQUAL(status.status(), STATUS_Success);
+    return uid;
+}
+
+
+OFTEST_FLAGS(dcmqrdb_move_failing_destination, EF_Slow)
+{
+    // the move destination accepts up to two parallel sub-associations
+    MoveDestinationPool scp;
+    DcmSCPConfig& scpConfig = scp.getConfig();
+    scpConfig.setAETitle("MOVE_DEST");
+    scpConfig.setPort(MOVE_TEST_PORT);
+    scpConfig.setConnectionBlockingMode(DUL_NOBLOCK);
+    scpConfig.setConnectionTimeout(1);
+    scpConfig.setDIMSEBlockingMode(DIMSE_NONBLOCKING);
+    scpConfig.setDIMSETimeout(30);
+    scp.setMaxThreads(4);
+    OFList<OFString> xfers;
+    xfers.push_back(UID_LittleEndianExplicitTransferSyntax);
+    xfers.push_back(UID_LittleEndianImplicitTransferSyntax);
+    OFCHECK(scpConfig.addPresentationContext(UID_SecondaryCaptureImageStorage, xfers).good());
+    scp.start();
+
+    // storage area of the C-MOVE SCP
+    const OFString dirName = "tmove.out";
+    const OFString cfgName = "tmove.cfg";
+    OFCHECK(OFStandard::createDirectory(dirName, "").good());
+    FILE *cfg = fopen(cfgName.c_str(), "w");
+    OFCHECK(cfg != NULL);
+    if (cfg != NULL)
+    {
+        fprintf(cfg, "HostTable BEGIN\nmovedest = (MOVE_DEST, localhost, %d)\nHostTable END\n", MOVE_TEST_PORT);
+        fprintf(cfg, "AETable BEGIN\nMOVE_SCP %s RW (9, 1024mb) ANY\nAETable END\n", dirName.c_str());
+        fclose(cfg);
+    }
+    DcmQueryRetrieveConfig config;
+    OFCHECK(config.init(cfgName.c_str()) == 1);
+
+    OFCondition result;
+    OFVector<OFString> files;
+    OFVector<OFString> instances;
+    {
+        DcmQueryRetrieveIndexDatabaseHandle handle(dirName.c_str(), -1, -1, result);
+        OFCHECK(result.good());
+        for (size_t i = 0; i < MOVE_TEST_INSTANCES; ++i)
+        {
+            // the transmission of a large instance fails before the request has been sent completely
+            instances.push_back(storeInstance(handle, dirName, files, (i == 1) ? MOVE_TEST_LARGE_SIZE : 0));
+        }
+    }
+    storeRequestsMutex.lock();
+    abortedInstance = instances[1];
+    unansweredInstance = instances[4];
+    storeRequestsMutex.unlock();
+
+    // the association on which the C-MOVE request has been received
+    DcmQueryRetrieveOptions options;
+    options.maxMoveSubAssociations_ = 2;
+    options.blockMode_ = DIMSE_NONBLOCKING;
+    options.dimse_timeout_ = 30;
+    OFCHECK(ASC_initializeNetwork(NET_REQUESTOR, 0, 30, &options.net_).good());
+    T_ASC_Association origAssoc;
+    memset(&origAssoc, 0, sizeof(origAssoc));
+    OFCHECK(ASC_createAssociationParameters(&origAssoc.params, ASC_DEFAULTMAXPDU).good());
+    ASC_setAPTitles(origAssoc.params, "MOVE_SCU", "MOVE_SCP", NULL);
+    ASC_setPresentationAddresses(origAssoc.params, "localhost", "localhost:104");
+
+    // perform the C-MOVE and check the counters of each response
+    DcmQueryRetrieveIndexDatabaseHandle handle(dirName.c_str(), -1, -1, result);
+    OFCHECK(result.good());
+    DcmAssociationConfiguration associationConfiguration;
+    DcmQueryRetrieveMoveContext context(handle, options, associationConfiguration, &config, STATUS_Pending, &origAssoc, 1, DIMSE_PRIORITY_MEDIUM);
+    context.setOurAETitle("MOVE_SCP");
+    T_DIMSE_C_MoveRQ request;
+    memset(&request, 0, sizeof(request));
+    request.MessageID = 1;
+    OFStandard::strlcpy(request.AffectedSOPClassUID, UID_MOVEStudyRootQueryRetrieveInformationModel, sizeof(request.AffectedSOPClassUID));
+    OFStandard::strlcpy(request.MoveDestination, "MOVE_DEST", sizeof(request.MoveDestination));
+    DcmDataset identifiers;
+    OFCHECK(identifiers.putAndInsertString(DCM_QueryRetrieveLevel, STUDY_LEVEL_STRING).good());
+    OFCHECK(identifiers.putAndInsertString(DCM_StudyInstanceUID, MOVE_TEST_STUDY).good());
+    T_DIMSE_C_MoveRSP response;
+    DcmDataset *statusDetail = NULL;
+    DcmDataset *responseIdentifiers = NULL;
+    int responseCount = 0;
+    do
+    {
+        memset(&response, 0, sizeof(response));
+        context.callbackHandler(OFFalse, &request, &identifiers, ++responseCount, &response, &statusDetail, &responseIdentifiers);
+        delete statusDetail;
+        statusDetail = NULL;
+        if (response.DimseStatus == STATUS_Pending)
+        {
+            // sub-operations are never counted twice or lost
+            OFCHECK_EQUAL(response.NumberOfRemainingSubOperations + response.NumberOfCompletedSubOperations +
+                response.NumberOfFailedSubOperations + response.NumberOfWarningSubOperations, MOVE_TEST_INSTANCES);
+            delete responseIdentifiers;
+            responseIdentifiers = NULL;
+        }
+    } while ((response.DimseStatus == STATUS_Pending) && (responseCount <= MOVE_TEST_INSTANCES));
+
+    // the interrupted request is repeated, the unanswered one is not (and counted as failed)
+    OFCHECK_EQUAL(response.DimseStatus, STATUS_MOVE_Warning_SubOperationsCompleteOneOrMoreFailures);
+    OFCHECK_EQUAL(response.NumberOfRemainingSubOperations, 0);
+    OFCHECK_EQUAL(response.NumberOfCompletedSubOperations, MOVE_TEST_INSTANCES - 1);
+    OFCHECK_EQUAL(response.NumberOfFailedSubOperations, 1);
+    OFCHECK_EQUAL(response.NumberOfWarningSubOperations, 0);
+    OFString failedInstances;
+    OFCHECK(responseIdentifiers != NULL);
+    if (responseIdentifiers != NULL)
+        OFCHECK(responseIdentifiers->findAndGetOFStringArray(DCM_FailedSOPInstanceUIDList, failedInstances).good());
+    OFCHECK_EQUAL(failedInstances, unansweredInstance);
+    delete responseIdentifiers;
+    for (size_t i = 0; i < MOVE_TEST_INSTANCES; ++i)
+        OFCHECK_EQUAL(getStoreRequests(instances[i]), (i == 1) ? 2 : 1);
+
+    ASC_destroyAssociationParameters(&origAssoc.params);
+    ASC_dropNetwork(&options.net_);
+    scp.stopAfterCurrentAssociations();
+    scp.join();
+    OFCHECK(scp.result.good());
+
+    // remove the storage area
+    OFString filename;
+    for (OFVector<OFString>::const_iterator it = files.begin(); it != files.end(); ++it)
+        OFStandard::deleteFile(*it);
+    OFStandard::deleteFile(OFStandard::combineDirAndFilename(filename, dirName, DBINDEXFILE));
+    OFStandard::deleteFile(OFStandard::combineDirAndFilename(filename, dirName, DBKEYINDEXFILE));
+    OFStandard::deleteFile(cfgName);
+#ifdef _WIN32
+    _rmdir(dirName.c_str());
+#else
+    rmdir(dirName.c_str());
+#endif
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,149 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  ofstd
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Provides a simple pool of threads that processes a number of
+ *           independent work items (e.g. the frames of a multi-frame
+ *           image) in parallel.
+ *
+ */
+
+#ifndef OFTHPOOL_H
+#define OFTHPOOL_H
+
+#include "dcmtk/config/osconfig.h"
+#include "dcmtk/ofstd/oftypes.h"   /* for class OFBool */
+#include "dcmtk/ofstd/ofthread.h"  /* for class OFMutex */
+#include "dcmtk/ofstd/ofvector.h"  /* for class OFVector */
+
+/** a simple pool of threads that processes a number of independent work
+ *  items in parallel. The work items are identified by their index and
+ *  handed out to the threads in ascending order, i.e.\ each thread fetches
+ *  the next unprocessed work item as soon as it has finished the previous
+ *  one. The calling thread takes part in the processing, so a pool with a
+ *  single thread processes all work items sequentially without creating
+ *  any further thread. The additional threads are created by the first
+ *  call of run() that needs them and are kept until the pool is destroyed,
+ *  so a pool that processes several batches of work items one after the
+ *  other only creates its threads once. If DCMTK is compiled without thread support or if a thread
+ *  cannot be created, the remaining work items are processed by the
+ *  calling thread.
+ */
+class DCMTK_OFSTD_EXPORT OFThreadPool
+{
+public:
+
+  /** abstract base class for the work to be performed by a thread pool.
+   *  Derived classes implement the processing of a single work item.
+   */
+  class DCMTK_OFSTD_EXPORT Task
+  {
+  public:
+
+    /// destructor
+    virtual ~Task();
+
+    /** process a single work item. This method is called concurrently
+     *  from different threads (but never twice for the same work item),
+     *  so any data shared between work items must be protected.
+     *  @param index index of the work item to be processed, 0..n-1
+     *  @param thread index of the calling thread within the pool,
+     *    0..getNumberOfThreads()-1. Can be used to access resources that
+     *    are maintained separately for each thread.
+     *  @return OFTrue if successful, OFFalse otherwise. In the latter case,
+     *    no further work items are handed out to any thread.
+     */
+    virtual OFBool execute(const size_t index,
+                           const size_t thread) = 0;
+  };
+
+  /** constructor
+   *  @param numberOfThreads maximum number of threads used for processing
+   *    the work items (including the calling thread). 0 selects the number
+   *    of processors available on this system.
+   */
+  explicit OFThreadPool(const size_t numberOfThreads = 0);
+
+  /// destructor
+  ~OFThreadPool();
+
+  /** get the maximum number of threads used by this pool
+   *  @return number of threads, always greater than 0
+   */
+  size_t getNumberOfThreads() const
+  {
+    return numberOfThreads_;
+  }
+
+  /** process the given number of work items in parallel. This method
+   *  returns after all work items have been processed or after the
+   *  processing of a work item failed. It must not be called by more
+   *  than one thread at the same time.
+   *  @param task task that processes the work items
+   *  @param numberOfItems number of work items to be processed
+   *  @return OFTrue if all work items have been processed successfully,
+   *    OFFalse otherwise
+   */
+  OFBool run(Task &task,
+             const size_t numberOfItems);
+
+  /** determine the number of processors available on this system
+   *  @return number of processors, 1 if unknown
+   */
+  static size_t getNumberOfProcessors();
+
+private:
+
+  class Worker;
+  friend class Worker;
+
+  /// private undefined copy constructor
+  OFThreadPool(const OFThreadPool &);
+
+  /// private undefined assignment operator
+  OFThreadPool &operator=(const OFThreadPool &);
+
+  /** process work items until there are no more or an error occurred
+   *  @param thread index of the calling thread within the pool
+   */
+  void process(const size_t thread);
+
+  /// maximum number of threads used for processing
+  size_t numberOfThreads_;
+
+  /// mutex protecting the following members while run() is executed
+  OFMutex mutex_;
+
+  /// task currently executed, NULL if none
+  Task *task_;
+
+  /// number of work items of the current task
+  size_t numberOfItems_;
+
+  /// index of the next work item to be processed
+  size_t nextItem_;
+
+  /// flag indicating whether the processing of a work item failed
+  OFBool failed_;
+
+  /// flag telling the additional threads to terminate
+  OFBool shutdown_;
+
+  /// additional threads of this pool, created on demand by run()
+  OFVector<Worker *> workers_;
+};
+
+#endif
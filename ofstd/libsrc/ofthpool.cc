@@ -0,0 +1,210 @@
+/*
+ *
+ *  Copyright (C) 2021, OFFIS e.V.
+ *  All rights reserved.  See COPYRIGHT file for details.
+ *
+ *  This software and supporting documentation were developed by
+ *
+ *    OFFIS e.V.
+ *    R&D Division Health
+ *    Escherweg 2
+ *    D-26121 Oldenburg, Germany
+ *
+ *
+ *  Module:  ofstd
+ *
+ *  Author:  DCMTK contributors
+ *
+ *  Purpose: Provides a simple pool of threads that processes a number of
+ *           independent work items (e.g. the frames of a multi-frame
+ *           image) in parallel.
+ *
+ */
+
+#include "dcmtk/config/osconfig.h"
+
+#include "dcmtk/ofstd/ofthpool.h"
+
+#ifdef HAVE_WINDOWS_H
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>     /* for GetSystemInfo() */
+#elif defined(HAVE_UNISTD_H)
+#include <unistd.h>      /* for sysconf() */
+#endif
+
+
+/** helper class for the additional threads of a thread pool. A worker
+ *  waits until it is resumed by OFThreadPool::run(), processes work items
+ *  until there are no more and then signals that it is done, until the
+ *  pool is destroyed.
+ */
+class OFThreadPool::Worker: public OFThread
+{
+public:
+
+  /** constructor
+   *  @param pool thread pool this worker belongs to
+   *  @param thread index of this thread within the pool
+   */
+  Worker(OFThreadPool &pool, const size_t thread)
+  : OFThread()
+  , pool_(pool)
+  , thread_(thread)
+  , start_(1)
+  , done_(1)
+  {
+    // the maximum value of a semaphore is its initial value (at least on
+    // Windows), so create both semaphores with a value of 1 and acquire them
+    start_.wait();
+    done_.wait();
+  }
+
+  /// let the worker process the work items of the current task
+  void resume()
+  {
+    start_.post();
+  }
+
+  /// wait until the worker has finished processing the current task
+  void waitUntilDone()
+  {
+    done_.wait();
+  }
+
+protected:
+
+  /// process the work items of each task until the pool is destroyed
+  virtual void run()
+  {
+    while (OFTrue)
+    {
+      start_.wait();
+      if (pool_.shutdown_)
+        break;
+      pool_.process(thread_);
+      done_.post();
+    }
+  }
+
+private:
+
+  /// thread pool this worker belongs to
+  OFThreadPool &pool_;
+
+  /// index of this thread within the pool
+  size_t thread_;
+
+  /// semaphore that is posted when the worker should start processing
+  OFSemaphore start_;
+
+  /// semaphore that is posted when the worker has finished processing
+  OFSemaphore done_;
+};
+
+
+OFThreadPool::Task::~Task()
+{
+}
+
+
+OFThreadPool::OFThreadPool(const size_t numberOfThreads)
+: numberOfThreads_(numberOfThreads)
+, mutex_()
+, task_(NULL)
+, numberOfItems_(0)
+, nextItem_(0)
+, failed_(OFFalse)
+, shutdown_(OFFalse)
+, workers_()
+{
+  if (numberOfThreads_ == 0)
+    numberOfThreads_ = getNumberOfProcessors();
+}
+
+
+OFThreadPool::~OFThreadPool()
+{
+  // wake up all workers so that they notice the shutdown and terminate
+  shutdown_ = OFTrue;
+  for (OFVector<Worker *>::iterator it = workers_.begin(); it != workers_.end(); ++it)
+  {
+    (*it)->resume();
+    (*it)->join();
+    delete *it;
+  }
+}
+
+
+OFBool OFThreadPool::run(Task &task,
+                         const size_t numberOfItems)
+{
+  task_ = &task;
+  numberOfItems_ = numberOfItems;
+  nextItem_ = 0;
+  failed_ = OFFalse;
+  // there is no need for more threads than work items
+  const size_t numberOfThreads = (numberOfThreads_ < numberOfItems) ? numberOfThreads_ : numberOfItems;
+  // the calling thread is the first thread of the pool, so start the others
+  // (unless they are still available from a previous call)
+  while (workers_.size() + 1 < numberOfThreads)
+  {
+    Worker *worker = new Worker(*this, workers_.size() + 1);
+    if (worker->start() == 0)
+      workers_.push_back(worker);
+    else
+    {
+      // thread support not available or limit of threads reached,
+      // continue with the threads started so far
+      delete worker;
+      break;
+    }
+  }
+  size_t numberOfWorkers = workers_.size();
+  if (numberOfThreads > 0 && numberOfWorkers > numberOfThreads - 1)
+    numberOfWorkers = numberOfThreads - 1;
+  for (size_t i = 0; i < numberOfWorkers; ++i)
+    workers_[i]->resume();
+  process(0);
+  for (size_t i = 0; i < numberOfWorkers; ++i)
+    workers_[i]->waitUntilDone();
+  task_ = NULL;
+  return !failed_;
+}
+
+
+void OFThreadPool::process(const size_t thread)
+{
+  while (OFTrue)
+  {
+    // fetch the next work item (if any)
+    mutex_.lock();
+    const OFBool done = failed_ || (nextItem_ >= numberOfItems_);
+    const size_t item = nextItem_++;
+    mutex_.unlock();
+    if (done)
+      break;
+    if (!task_->execute(item, thread))
+    {
+      mutex_.lock();
+      failed_ = OFTrue;
+      mutex_.unlock();
+    }
+  }
+}
+
+
+size_t OFThreadPool::getNumberOfProcessors()
+{
+  size_t result = 1;
+#ifdef HAVE_WINDOWS_H
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  if (systemInfo.dwNumberOfProcessors > 0)
+    result = OFstatic_cast(size_t, systemInfo.dwNumberOfProcessors);
+#elif defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  const long count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (count > 0)
+    result = OFstatic_cast(size_t, count);
+#endif
+  return result;
+}
@@ -72,6 +72,7 @@ OFTEST_REGISTER(ofstd_testPaths_1);
 OFTEST_REGISTER(ofstd_testPaths_2);
 #ifdef WITH_THREADS
 OFTEST_REGISTER(ofstd_thread);
+OFTEST_REGISTER(ofstd_threadPool);
 #endif // WITH_THREADS
 #ifndef _XMLWIDECHAR
 OFTEST_REGISTER(ofstd_xmlParser);
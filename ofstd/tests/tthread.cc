@@ -26,6 +26,8 @@
 #define OFTEST_OFSTD_ONLY
 #include "dcmtk/ofstd/oftest.h"
 #include "dcmtk/ofstd/ofthread.h"
+#include "dcmtk/ofstd/ofthpool.h"
+#include "dcmtk/ofstd/ofvector.h"
 #include "dcmtk/ofstd/ofstring.h"
 #include "dcmtk/ofstd/ofstd.h"
 #include "dcmtk/ofstd/ofdiag.h"
@@ -661,3 +663,79 @@ OFTEST(ofstd_thread)
   rwlocker_test();  // may assume that mutexes, semaphores and read/write locks work correctly
   tsdata_test();
 }
+
+
+/* ---------------- thread pool test ---------------- */
+
+class PoolTask: public OFThreadPool::Task
+{
+public:
+  PoolTask(const size_t numberOfItems, const size_t failingItem)
+  : results(numberOfItems, 0)
+  , calls(numberOfItems, 0)
+  , threadOk(OFTrue)
+  , threadOkMutex()
+  , failing(failingItem)
+  , numberOfThreads(0)
+  {
+  }
+
+  virtual OFBool execute(const size_t index, const size_t thread)
+  {
+    // each work item is written by exactly one thread, so no lock is needed
+    results[index] = index * index;
+    ++calls[index];
+    if (thread >= numberOfThreads)
+    {
+      // the flag is shared by all threads
+      threadOkMutex.lock();
+      threadOk = OFFalse;
+      threadOkMutex.unlock();
+    }
+    return (index != failing);
+  }
+
+  OFVector<size_t> results;
+  OFVector<int> calls;
+  OFBool threadOk;
+  OFMutex threadOkMutex;
+  size_t failing;
+  size_t numberOfThreads;
+};
+
+OFTEST(ofstd_threadPool)
+{
+  OFThreadPool defaultPool;
+  OFCHECK(defaultPool.getNumberOfThreads() > 0);
+  OFCHECK_EQUAL(defaultPool.getNumberOfThreads(), OFThreadPool::getNumberOfProcessors());
+
+  const size_t numberOfThreads[] = { 1, 4, 16 };
+  for (size_t t = 0; t < sizeof(numberOfThreads) / sizeof(numberOfThreads[0]); ++t)
+  {
+    OFThreadPool pool(numberOfThreads[t]);
+    OFCHECK_EQUAL(pool.getNumberOfThreads(), numberOfThreads[t]);
+    // process all work items
+    PoolTask task(1000, 1000);
+    task.numberOfThreads = pool.getNumberOfThreads();
+    OFCHECK(pool.run(task, 1000));
+    OFCHECK(task.threadOk);
+    for (size_t i = 0; i < 1000; ++i)
+    {
+      OFCHECK_EQUAL(task.results[i], i * i);
+      OFCHECK_EQUAL(task.calls[i], 1);
+    }
+    // the same pool can be used more than once
+    PoolTask task2(3, 3);
+    task2.numberOfThreads = pool.getNumberOfThreads();
+    OFCHECK(pool.run(task2, 3));
+    OFCHECK(task2.results[2] == 4);
+    // a failing work item stops the processing
+    PoolTask task3(1000, 10);
+    task3.numberOfThreads = pool.getNumberOfThreads();
+    OFCHECK(!pool.run(task3, 1000));
+    OFCHECK_EQUAL(task3.calls[10], 1);
+    OFCHECK(task3.calls[999] == 0 || pool.getNumberOfThreads() > 1);
+    // nothing to do
+    OFCHECK(pool.run(task3, 0));
+  }
+}